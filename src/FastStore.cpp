@@ -35,6 +35,7 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <cstring>
 
 #include <Rcpp.h>
 
@@ -43,39 +44,73 @@
 #include <ifsttable.h>
 #include <icolumnfactory.h>
 #include <fststore.h>
+#include <fstwriter.h>
+#include <fsthandle.h>
+#include <fstdataset.h>
+#include <fstcopy.h>
+#include <fstindex.h>
+#include <fstsort.h>
+#include <fstjoin.h>
+#include <fstiterator.h>
+#include <fstfilter.h>
+#include <fstaggregate.h>
+#include <fstkeylookup.h>
+#include <fstio.h>
+#include <fstrangeinput.h>
 
 #include <blockrunner_char.h>
 #include <fsttable.h>
 #include <fstcolumn.h>
 #include <columnfactory.h>
+#include <lazycolumns.h>
 
 #include <FastStore.h>
 #include <FastStore_v1.h>
+#include <openmp.h>
 
 
 using namespace std;
 using namespace Rcpp;
 
 
-inline int FindKey(StringVector colNameList, String item)
+#define ERROR_MESSAGE_SIZE 512  // maximum length of an error message passed to R
+
+
+// Bulk reads and writes of files bypass the page cache, see fstDirectIO
+static bool directIO = false;
+
+
+// Profile of the last read or write with fstStore or fstRetrieve, see fstProfile
+static bool profiling = false;
+static FstProfile* lastProfile = nullptr;
+static vector<string> profileColumns;
+
+
+// New profile for the next read or write, nullptr if operations are not profiled
+inline FstProfile* StartProfile()
+{
+  if (!profiling) return nullptr;
+
+  delete lastProfile;
+  lastProfile = new FstProfile();
+  profileColumns.clear();
+
+  return lastProfile;
+}
+
+
+inline void SetProfileColumns(SEXP colNames)
 {
-  int index = -1;
-  int found = 0;
-  for (Rcpp::StringVector::iterator it = colNameList.begin(); it != colNameList.end(); ++it)
+  profileColumns.clear();
+
+  for (int colNr = 0; colNr < LENGTH(colNames); ++colNr)
   {
-    if (*it == item)
-    {
-      index = found;
-      break;
-    }
-    ++found;
+    profileColumns.push_back(CHAR(STRING_ELT(colNames, colNr)));
   }
-
-  return index;
 }
 
 
-SEXP fstStore(String fileName, SEXP table, SEXP compression)
+inline int CompressionLevel(SEXP compression)
 {
   if (!Rf_isInteger(compression))
   {
@@ -88,24 +123,436 @@ SEXP fstStore(String fileName, SEXP table, SEXP compression)
     ::Rf_error("Parameter compression should be an integer value between 0 and 100");
   }
 
+  return compress;
+}
+
+
+SEXP fstStore(String fileName, SEXP table, SEXP compression, SEXP streamLayout, SEXP chunkSize, SEXP blockSize, SEXP goal,
+  SEXP bloomBits, SEXP mantissaBits, SEXP fastDecode, SEXP compressLevels)
+{
+  int compress = CompressionLevel(compression);
+
+  // Block size in bytes of each column, validated by write.fst
+  vector<unsigned int> blockSizes;
+  if (!Rf_isNull(blockSize))
+  {
+    double* sizes = REAL(blockSize);
+    for (int colNr = 0; colNr < LENGTH(blockSize); ++colNr)
+    {
+      blockSizes.push_back((unsigned int) sizes[colNr]);
+    }
+  }
+
+  // Bloom filter bits per key of each column (0 for no filter), validated by write.fst
+  vector<unsigned int> bloomFilterBits;
+  if (!Rf_isNull(bloomBits))
+  {
+    double* bits = REAL(bloomBits);
+    for (int colNr = 0; colNr < LENGTH(bloomBits); ++colNr)
+    {
+      bloomFilterBits.push_back((unsigned int) bits[colNr]);
+    }
+  }
+
+  // Mantissa bits kept of each double column (0 for full precision), validated by write.fst
+  vector<unsigned int> precisionBits;
+  if (!Rf_isNull(mantissaBits))
+  {
+    double* bits = REAL(mantissaBits);
+    for (int colNr = 0; colNr < LENGTH(mantissaBits); ++colNr)
+    {
+      precisionBits.push_back((unsigned int) bits[colNr]);
+    }
+  }
+
+  // Compression level of each column (overrides compression), validated by write.fst
+  vector<int> columnLevels;
+  if (!Rf_isNull(compressLevels))
+  {
+    int* levels = INTEGER(compressLevels);
+    for (int colNr = 0; colNr < LENGTH(compressLevels); ++colNr)
+    {
+      columnLevels.push_back(levels[colNr]);
+    }
+  }
+
+  // Minimum speed and minimum ratio of the adaptive compression, validated by write.fst
+  CompressionGoal* compressionGoal = nullptr;
+  if (!Rf_isNull(goal))
+  {
+    compressionGoal = new CompressionGoal(REAL(goal)[0], REAL(goal)[1]);
+  }
+
   FstTable fstTable(table);
   FstStore* fstStore = new FstStore(fileName.get_cstring());
 
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    // The append-only layout never seeks in the file
+    FstFileOutput fileOutput(fileName.get_cstring(), *LOGICAL(streamLayout) != 1, directIO);
+
+    FstProfile* profile = StartProfile();
+    FstProfiledOutput profiledOutput(fileOutput, profile);
+    IFstOutput &output = profile == nullptr ? static_cast<IFstOutput&>(fileOutput) : profiledOutput;
+
+    if (profile != nullptr) SetProfileColumns(Rf_getAttrib(table, R_NamesSymbol));
+
+    ProfileScope profileScope(profile);
+
+    fstStore->fstWrite(output, fstTable, compress, getDTthreads(), (unsigned long long) Rf_asReal(chunkSize),
+      blockSizes.empty() ? nullptr : blockSizes.data(), compressionGoal,
+      bloomFilterBits.empty() ? nullptr : bloomFilterBits.data(),
+      precisionBits.empty() ? nullptr : precisionBits.data(), *LOGICAL(fastDecode) == 1,
+      columnLevels.empty() ? nullptr : columnLevels.data());
+
+    if (profile != nullptr) profile->Stop();
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete fstStore;
+  delete compressionGoal;
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  return table;
+}
+
+
+SEXP fstStoreRaw(SEXP table, SEXP compression)
+{
+  int compress = CompressionLevel(compression);
+
+  FstTable fstTable(table);
+  FstMemoryOutput memoryOutput;
+  FstStore fstStore("");
+
   try
   {
-    fstStore->fstWrite(fileName.get_cstring(), fstTable, compress);
+    fstStore.fstWrite(memoryOutput, fstTable, compress, getDTthreads(), 0);
   }
   catch (const std::runtime_error& e)
   {
     ::Rf_error(e.what());
   }
 
+  SEXP rawVec;
+  PROTECT(rawVec = Rf_allocVector(RAWSXP, memoryOutput.Size()));
+  memcpy(RAW(rawVec), memoryOutput.Data(), memoryOutput.Size());
+  UNPROTECT(1);
+
+  return rawVec;
+}
+
+
+SEXP fstAppend(String fileName, SEXP table, SEXP compression)
+{
+  int compress = CompressionLevel(compression);
+
+  FstTable fstTable(table);
+  FstStore* fstStore = new FstStore(fileName.get_cstring());
+  IColumnFactory* columnFactory = new ColumnFactory();
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fstStore->fstAppend(fileName.get_cstring(), fstTable, compress, getDTthreads(), columnFactory);
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete columnFactory;
+  delete fstStore;
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  return table;
+}
+
+
+SEXP fstCbind(String fileName, SEXP table, SEXP compression)
+{
+  int compress = CompressionLevel(compression);
+
+  FstTable fstTable(table);
+  FstStore* fstStore = new FstStore(fileName.get_cstring());
+  IColumnFactory* columnFactory = new ColumnFactory();
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fstStore->fstCbind(fileName.get_cstring(), fstTable, compress, getDTthreads(), columnFactory);
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete columnFactory;
   delete fstStore;
 
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  return table;
+}
+
+
+SEXP fstReplaceColumn(String fileName, String colName, SEXP table, SEXP compression)
+{
+  int compress = CompressionLevel(compression);
+
+  FstTable fstTable(table);
+  FstStore fstStore(fileName.get_cstring());
+  ColumnFactory columnFactory;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fstStore.fstReplaceColumn(fileName.get_cstring(), colName.get_cstring(), fstTable, compress, getDTthreads(),
+      &columnFactory);
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
   return table;
 }
 
 
+SEXP fstDeleteColumn(String fileName, String colName)
+{
+  FstStore fstStore(fileName.get_cstring());
+  ColumnFactory columnFactory;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fstStore.fstDeleteColumn(fileName.get_cstring(), colName.get_cstring(), &columnFactory);
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  return R_NilValue;
+}
+
+
+// Batched writer owned by an R external pointer. Writers with sort columns write the batches through a sorter.
+class FstWriterHandle
+{
+public:
+  ColumnFactory columnFactory;
+  FstWriter fstWriter;
+  FstSorter* fstSorter;
+
+  FstWriterHandle(const char* fileName, int compress) :
+    fstWriter(fileName, compress, getDTthreads(), &columnFactory), fstSorter(nullptr) {}
+
+  ~FstWriterHandle() { delete fstSorter; }
+
+  unsigned long long NrOfRows() { return fstSorter != nullptr ? fstSorter->NrOfRows() : fstWriter.NrOfRows(); }
+};
+
+
+inline FstWriterHandle* GetWriterHandle(SEXP writer)
+{
+  if (TYPEOF(writer) != EXTPTRSXP || R_ExternalPtrAddr(writer) == nullptr)
+  {
+    ::Rf_error("Parameter 'writer' should be an open fst writer.");
+  }
+
+  return (FstWriterHandle*) R_ExternalPtrAddr(writer);
+}
+
+
+SEXP fstWriterOpen(String fileName, SEXP compression, SEXP sortKeys)
+{
+  int compress = CompressionLevel(compression);
+
+  XPtr<FstWriterHandle> writer(new FstWriterHandle(fileName.get_cstring(), compress), true);
+
+  // The sorted runs are stored in a temporary file next to the fst file
+  if (!Rf_isNull(sortKeys))
+  {
+    vector<string> keyNames;
+
+    for (int keyNr = 0; keyNr < LENGTH(sortKeys); ++keyNr)
+    {
+      keyNames.push_back(CHAR(STRING_ELT(sortKeys, keyNr)));
+    }
+
+    string runFileName = string(fileName.get_cstring()) + ".run";
+
+    writer->fstSorter = new FstSorter(fileName.get_cstring(), runFileName.c_str(), keyNames, compress, getDTthreads(),
+      &writer->columnFactory);
+  }
+
+  return writer;
+}
+
+
+SEXP fstWriterAppend(SEXP writer, SEXP table)
+{
+  FstWriterHandle* writerHandle = GetWriterHandle(writer);
+  FstTable fstTable(table);
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    if (writerHandle->fstSorter != nullptr)
+    {
+      writerHandle->fstSorter->WriteBatch(fstTable);
+    }
+    else
+    {
+      writerHandle->fstWriter.WriteBatch(fstTable);
+    }
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  return Rf_ScalarReal((double) writerHandle->NrOfRows());
+}
+
+
+SEXP fstWriterClose(SEXP writer)
+{
+  FstWriterHandle* writerHandle = GetWriterHandle(writer);
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    if (writerHandle->fstSorter != nullptr)
+    {
+      writerHandle->fstSorter->Close();
+    }
+    else
+    {
+      writerHandle->fstWriter.Close();
+    }
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  return Rf_ScalarReal((double) writerHandle->NrOfRows());
+}
+
+
+SEXP fstUpgrade(String fileName, String outputName, SEXP compression, SEXP batchRows)
+{
+  int compress = CompressionLevel(compression);
+  int nrOfBatchRows = Rf_asInteger(batchRows);  // validated by fst.upgrade
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+  int nrOfRows = 0;
+  int nrOfProtected = 0;
+
+  {
+    ifstream myfile;
+    myfile.open(fileName.get_cstring(), ios::binary);
+
+    FstHeader_v1 header;
+    ColumnFactory columnFactory;
+    FstWriter fstWriter(outputName.get_cstring(), compress, getDTthreads(), &columnFactory);
+
+    try
+    {
+      if (myfile.fail())
+      {
+        throw(runtime_error("There was an error opening the fst file. Please check for a correct filename."));
+      }
+
+      fstReadHeader_v1(myfile, header);
+
+      SEXP colNames = PROTECT(fstReadColNames_v1(myfile, header));
+      ++nrOfProtected;
+
+      // The file is converted batch by batch, each batch becomes a data chunk of the new file
+      fstWriter.SetSortedBatches(true);
+
+      int length;
+
+      for (int firstRow = 0; firstRow < header.nrOfRows; firstRow += length)
+      {
+        length = min(nrOfBatchRows, header.nrOfRows - firstRow);
+
+        SEXP batch = PROTECT(fstReadRows_v1(myfile, header, colNames, firstRow, length));
+        ++nrOfProtected;
+
+        FstTable fstTable(batch);
+        fstWriter.WriteBatch(fstTable);
+
+        UNPROTECT(1);
+        --nrOfProtected;
+      }
+
+      fstWriter.Close();
+      nrOfRows = header.nrOfRows;
+    }
+    catch (const std::runtime_error& e)
+    {
+      strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+    }
+  }
+
+  UNPROTECT(nrOfProtected);
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  return Rf_ScalarReal((double) nrOfRows);
+}
+
+
 SEXP fstMeta(String fileName)
 {
   int version;
@@ -139,6 +586,14 @@ SEXP fstMeta(String fileName)
     colTypeVec[col] = fstStore->colTypes[col];
   }
 
+  // Recorded precision of the double columns, NA for full precision
+  IntegerVector mantissaBitsVec(fstStore->nrOfCols, NA_INTEGER);
+  for (int col = 0; col != fstStore->nrOfCols; ++col)
+  {
+    unsigned short int colAttributeType = fstStore->colAttributeTypes[col];
+    if ((colAttributeType & COL_ATTR_PRECISION) != 0) mantissaBitsVec[col] = colAttributeType & COL_ATTR_BITS_MASK;
+  }
+
   List retList;
 
   if (fstStore->keyLength > 0)
@@ -160,23 +615,25 @@ SEXP fstMeta(String fileName)
 
     retList = List::create(
       _["nrOfCols"]        = fstStore->nrOfCols,
-      _["nrOfRows"]        = *fstStore->p_nrOfRows,
+      _["nrOfRows"]        = (double) *fstStore->p_nrOfRows,
       _["fstVersion"]      = fstStore->version,
       _["colTypeVec"]      = colTypeVec,
       _["keyColIndex"]     = keyColIndex,
       _["keyLength"]       = fstStore->keyLength,
       _["keyNames"]        = keyNames,
-      _["colNames"]        = colNames);
+      _["colNames"]        = colNames,
+      _["mantissaBits"]    = mantissaBitsVec);
   }
   else
   {
     retList = List::create(
       _["nrOfCols"]        = fstStore->nrOfCols,
-      _["nrOfRows"]        = *fstStore->p_nrOfRows,
+      _["nrOfRows"]        = (double) *fstStore->p_nrOfRows,
       _["fstVersion"]      = fstStore->version,
       _["keyLength"]       = fstStore->keyLength,
       _["colTypeVec"]      = colTypeVec,
-      _["colNames"]        = colNames);
+      _["colNames"]        = colNames,
+      _["mantissaBits"]    = mantissaBitsVec);
   }
 
   delete columnFactory;
@@ -186,55 +643,151 @@ SEXP fstMeta(String fileName)
 }
 
 
-SEXP fstRetrieve(String fileName, SEXP columnSelection, SEXP startRow, SEXP endRow)
+SEXP fstColumnStatistics(String fileName)
 {
-  FstTableReader tableReader;
-  IColumnFactory* columnFactory = new ColumnFactory();
-  FstStore* fstStore = new FstStore(fileName.get_cstring());
+  FstFileInput fstInput(fileName.get_cstring());
+  ColumnFactory columnFactory;
+  FstHandle fstHandle(fstInput, &columnFactory);
 
-  int sRow = *INTEGER(startRow);
+  vector<ZoneMapEntry> colStats;
+  vector<bool> hasStats;
 
-  // Set to last row
-  int eRow = -1;
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
 
-  if (!Rf_isNull(endRow))
+  try
+  {
+    // Files in the deprecated format have no zone maps
+    if (fstHandle.Open())
+    {
+      int nrOfCols = fstHandle.NrOfColumns();
+      colStats.resize(nrOfCols);
+
+      for (int colNr = 0; colNr < nrOfCols; ++colNr)
+      {
+        hasStats.push_back(fstHandle.ColumnStatistics(colNr, colStats[colNr]));
+      }
+    }
+  }
+  catch (const std::runtime_error& e)
   {
-    eRow = *INTEGER(endRow);
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
   }
 
-  vector<int> keyIndex;
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
 
-  StringArray* colNames = new StringArray();
-  StringArray* colSelection = nullptr;
+  int nrOfCols = (int) colStats.size();
+  NumericVector minValues(nrOfCols, NA_REAL);
+  NumericVector maxValues(nrOfCols, NA_REAL);
+  NumericVector naCounts(nrOfCols, NA_REAL);
 
-  if (!Rf_isNull(columnSelection))
+  for (int colNr = 0; colNr < nrOfCols; ++colNr)
   {
-    colSelection = new StringArray();
-    colSelection->SetArray(columnSelection);
+    if (!hasStats[colNr]) continue;
+
+    ZoneMapEntry &stats = colStats[colNr];
+    naCounts[colNr] = stats.naCount;
+
+    // Ranges are reported for numeric columns with at least one value
+    unsigned short int colType = fstHandle.ColumnType(colNr);
+    if (colType < 8 || stats.naCount == stats.nrOfValues) continue;
+
+    if (colType == 11)  // 64-bit integers are reported as the nearest double
+    {
+      minValues[colNr] = (double) stats.minInt64;
+      maxValues[colNr] = (double) stats.maxInt64;
+      continue;
+    }
+
+    minValues[colNr] = stats.minValue;
+    maxValues[colNr] = stats.maxValue;
   }
 
-  int result;
+  return List::create(
+    _["minValues"] = minValues,
+    _["maxValues"] = maxValues,
+    _["naCounts"]  = naCounts);
+}
+
+
+SEXP fstColumnStorage(String fileName)
+{
+  FstFileInput fstInput(fileName.get_cstring());
+  ColumnFactory columnFactory;
+  FstHandle fstHandle(fstInput, &columnFactory);
+
+  vector<ColumnStorage> colStorage;
+  vector<unsigned short int> colTypes;
+  unsigned long long deadBytes = 0;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
 
   try
   {
-    result = fstStore->fstRead(fileName.get_cstring(), tableReader, colSelection, sRow, eRow, columnFactory, keyIndex, colNames);
+    if (!fstHandle.Open())
+    {
+      throw(runtime_error("The fst file uses a deprecated format, please resave the file to report its storage."));
+    }
+
+    int nrOfCols = fstHandle.NrOfColumns();
+    colStorage.resize(nrOfCols);
+
+    for (int colNr = 0; colNr < nrOfCols; ++colNr)
+    {
+      fstHandle.ReadColumnStorage(colNr, colStorage[colNr]);
+      colTypes.push_back(fstHandle.ColumnType(colNr));
+    }
+
+    deadBytes = fstHandle.DeadBytes();
   }
   catch (const std::runtime_error& e)
   {
-    delete colSelection;
-    delete columnFactory;
-    delete fstStore;
-    delete colNames;
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
 
-    ::Rf_error(e.what());
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
   }
 
-  // Test deprecated version format !!!
-  if (result == -1)
+  int nrOfCols = (int) colStorage.size();
+  double nrOfRows = (double) fstHandle.NrOfRows();
+  NumericVector bytes(nrOfCols);
+  NumericVector dataBytes(nrOfCols, NA_REAL);
+  NumericVector maxBlockSize(nrOfCols);
+  NumericMatrix blocks(nrOfCols, NR_OF_ALGORITHMS);
+
+  for (int colNr = 0; colNr < nrOfCols; ++colNr)
   {
-    return fstRead_v1(fileName.get_sexp(), columnSelection, startRow, endRow);
+    ColumnStorage &storage = colStorage[colNr];
+    bytes[colNr] = (double) storage.bytes;
+    maxBlockSize[colNr] = (double) storage.maxBlockSize;
+
+    // The size of character data is not stored in the block indexes
+    if (colTypes[colNr] == 7 || colTypes[colNr] == 8 || colTypes[colNr] == 10) dataBytes[colNr] = 4 * nrOfRows;
+    else if (colTypes[colNr] != 6) dataBytes[colNr] = 8 * nrOfRows;
+
+    for (int algo = 0; algo < NR_OF_ALGORITHMS; ++algo)
+    {
+      blocks(colNr, algo) = (double) storage.blocks[algo];
+    }
   }
 
+  return List::create(
+    _["bytes"]        = bytes,
+    _["dataBytes"]    = dataBytes,
+    _["maxBlockSize"] = maxBlockSize,
+    _["blocks"]       = blocks,
+    _["deadBytes"]    = (double) deadBytes,
+    _["nrOfChunks"]   = (double) fstHandle.NrOfChunks());
+}
+
+
+// Combine the columns of a read with their names and the key columns in a result list. Releases colNames.
+inline SEXP ResultTable(FstTableReader &tableReader, StringArray* colNames, vector<int> &keyIndex)
+{
   SEXP colNameVec = colNames->StrVector();
 
   // Generalize to full atributes
@@ -252,8 +805,6 @@ SEXP fstRetrieve(String fileName, SEXP columnSelection, SEXP startRow, SEXP endR
     SET_STRING_ELT(keyNames, count++, STRING_ELT(colNameVec, *keyIt));
   }
 
-  delete columnFactory;
-  delete fstStore;
   delete colNames;
 
   UNPROTECT(1);
@@ -264,3 +815,1651 @@ SEXP fstRetrieve(String fileName, SEXP columnSelection, SEXP startRow, SEXP endR
     _["colNameVec"] = colNameVec,
     _["resTable"] = tableReader.resTable);
 }
+
+
+// Read a table from a fst input, returns R_NilValue for the deprecated (pre v0.7.3) format.
+// Errors are reported as a std::runtime_error.
+inline SEXP RetrieveTable(IFstInput &input, SEXP columnSelection, SEXP startRow, SEXP endRow)
+{
+  FstTableReader tableReader;
+  IColumnFactory* columnFactory = new ColumnFactory();
+  FstStore* fstStore = new FstStore("");
+
+  // Row numbers are passed as doubles to address rows beyond 2^31 - 1
+  long long sRow = (long long) Rf_asReal(startRow);
+
+  // Set to last row
+  long long eRow = -1;
+
+  if (!Rf_isNull(endRow))
+  {
+    eRow = (long long) Rf_asReal(endRow);
+  }
+
+  vector<int> keyIndex;
+
+  StringArray* colNames = new StringArray();
+  StringArray* colSelection = nullptr;
+
+  if (!Rf_isNull(columnSelection))
+  {
+    colSelection = new StringArray();
+    colSelection->SetArray(columnSelection);
+  }
+
+  int result;
+
+  try
+  {
+    result = fstStore->fstRead(input, tableReader, colSelection, sRow, eRow, columnFactory, keyIndex, colNames, getDTthreads());
+  }
+  catch (const std::runtime_error& e)
+  {
+    delete colSelection;
+    delete columnFactory;
+    delete fstStore;
+    delete colNames;
+
+    throw;  // input is released by the caller before raising the R error
+  }
+
+  // Test deprecated version format !!!
+  if (result == -1)
+  {
+    delete colSelection;
+    delete columnFactory;
+    delete fstStore;
+    delete colNames;
+
+    return R_NilValue;
+  }
+
+  delete columnFactory;
+  delete fstStore;
+
+  return ResultTable(tableReader, colNames, keyIndex);
+}
+
+
+SEXP fstRetrieve(String fileName, SEXP columnSelection, SEXP startRow, SEXP endRow, SEXP memoryMapped)
+{
+  SEXP result = R_NilValue;
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    FstProfile* profile = StartProfile();
+    ProfileScope profileScope(profile);
+
+    if (*LOGICAL(memoryMapped) == 1)
+    {
+      FstMappedFileInput mappedInput;
+
+      if (!mappedInput.Open(fileName.get_cstring()))
+      {
+        throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+      }
+
+      FstProfiledInput profiledInput(mappedInput, profile);
+      result = RetrieveTable(profile == nullptr ? static_cast<IFstInput&>(mappedInput) : profiledInput,
+        columnSelection, startRow, endRow);
+    }
+    else
+    {
+      FstFileInput fileInput(fileName.get_cstring(), directIO);
+      FstProfiledInput profiledInput(fileInput, profile);
+      result = RetrieveTable(profile == nullptr ? static_cast<IFstInput&>(fileInput) : profiledInput,
+        columnSelection, startRow, endRow);
+    }
+
+    if (profile != nullptr)
+    {
+      profile->Stop();
+      if (!Rf_isNull(result)) SetProfileColumns(List(result)["colNameVec"]);
+    }
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  // Test deprecated version format !!!
+  if (Rf_isNull(result))
+  {
+    // The deprecated format is limited to 32-bit row numbers
+    SEXP intStartRow = PROTECT(Rf_coerceVector(startRow, INTSXP));
+    SEXP intEndRow = PROTECT(Rf_isNull(endRow) ? endRow : Rf_coerceVector(endRow, INTSXP));
+
+    result = fstRead_v1(fileName.get_sexp(), columnSelection, intStartRow, intEndRow);
+
+    UNPROTECT(2);
+  }
+
+  return result;
+}
+
+
+SEXP fstRetrieveRaw(SEXP rawVec, SEXP columnSelection, SEXP startRow, SEXP endRow)
+{
+  if (TYPEOF(rawVec) != RAWSXP)
+  {
+    ::Rf_error("Parameter 'x' should be a raw vector.");
+  }
+
+  FstMemoryInput memoryInput((const char*) RAW(rawVec), XLENGTH(rawVec));
+
+  SEXP result = R_NilValue;
+
+  try
+  {
+    result = RetrieveTable(memoryInput, columnSelection, startRow, endRow);
+  }
+  catch (const std::runtime_error& e)
+  {
+    ::Rf_error(e.what());
+  }
+
+  if (Rf_isNull(result))
+  {
+    ::Rf_error("The raw vector does not contain fst data in a supported format.");
+  }
+
+  return result;
+}
+
+
+// Row iterator owned by an R external pointer
+class FstIteratorHandle
+{
+public:
+  FstFileInput fileInput;
+  ColumnFactory columnFactory;
+  FstIterator fstIterator;
+
+  FstIteratorHandle(const char* fileName) : fileInput(fileName), fstIterator(fileInput, &columnFactory) {}
+};
+
+
+inline FstIteratorHandle* GetIteratorHandle(SEXP iterator)
+{
+  if (TYPEOF(iterator) != EXTPTRSXP || R_ExternalPtrAddr(iterator) == nullptr)
+  {
+    ::Rf_error("Parameter 'iterator' should be an open fst iterator.");
+  }
+
+  return (FstIteratorHandle*) R_ExternalPtrAddr(iterator);
+}
+
+
+SEXP fstIterOpen(String fileName, SEXP columnSelection)
+{
+  FstIteratorHandle* iteratorHandle = new FstIteratorHandle(fileName.get_cstring());
+
+  StringArray* colSelection = nullptr;
+
+  if (!Rf_isNull(columnSelection))
+  {
+    colSelection = new StringArray();
+    colSelection->SetArray(columnSelection);
+  }
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    if (!iteratorHandle->fstIterator.Open(colSelection))
+    {
+      throw(runtime_error("The fst file uses a deprecated format, please resave the file to iterate over its rows."));
+    }
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete colSelection;
+
+  if (errorMessage[0] != 0)
+  {
+    delete iteratorHandle;
+    ::Rf_error(errorMessage);
+  }
+
+  double nrOfRows = (double) iteratorHandle->fstIterator.NrOfRows();
+  XPtr<FstIteratorHandle> iterator(iteratorHandle, true);
+
+  return List::create(
+    _["ptr"] = iterator,
+    _["nrOfRows"] = nrOfRows);
+}
+
+
+SEXP fstIterNext(SEXP iterator, SEXP batchRows)
+{
+  FstIteratorHandle* iteratorHandle = GetIteratorHandle(iterator);
+
+  FstTableReader tableReader;
+  vector<int> keyIndex;
+  unsigned long long nrOfRows = 0;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    nrOfRows = iteratorHandle->fstIterator.NextBatch(tableReader, (unsigned long long) Rf_asReal(batchRows),
+      getDTthreads());
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  // All rows have been read
+  if (nrOfRows == 0)
+  {
+    return R_NilValue;
+  }
+
+  StringArray* colNames = new StringArray();
+  iteratorHandle->fstIterator.SelectedColumns(colNames, keyIndex);
+
+  return ResultTable(tableReader, colNames, keyIndex);
+}
+
+
+SEXP fstIterClose(SEXP iterator)
+{
+  // Closing an iterator twice has no effect
+  if (TYPEOF(iterator) == EXTPTRSXP && R_ExternalPtrAddr(iterator) == nullptr)
+  {
+    return R_NilValue;
+  }
+
+  FstIteratorHandle* iteratorHandle = GetIteratorHandle(iterator);
+
+  // Closes the file, the finalizer ignores the cleared pointer
+  delete iteratorHandle;
+  R_ClearExternalPtr(iterator);
+
+  return R_NilValue;
+}
+
+
+// Open fst file with parsed metadata, owned by an R external pointer
+class FstFileHandle
+{
+public:
+  IFstInput* input;
+  ColumnFactory columnFactory;
+  FstHandle* fstHandle;
+
+  FstFileHandle(IFstInput* input) : input(input) { fstHandle = new FstHandle(*input, &columnFactory); }
+
+  ~FstFileHandle() { delete fstHandle; delete input; }
+};
+
+
+inline FstFileHandle* GetFileHandle(SEXP handle)
+{
+  if (TYPEOF(handle) != EXTPTRSXP || R_ExternalPtrAddr(handle) == nullptr)
+  {
+    ::Rf_error("Parameter 'handle' should be an open fst handle.");
+  }
+
+  return (FstFileHandle*) R_ExternalPtrAddr(handle);
+}
+
+
+// Open a fst file and parse its metadata, throws on failure
+FstFileHandle* OpenFileHandle(const char* fileName, bool memoryMapped)
+{
+  FstFileHandle* fileHandle = nullptr;
+
+  if (memoryMapped)
+  {
+    FstMappedFileInput* mappedInput = new FstMappedFileInput();
+
+    if (!mappedInput->Open(fileName))
+    {
+      delete mappedInput;
+      throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+    }
+
+    fileHandle = new FstFileHandle(mappedInput);
+  }
+  else
+  {
+    fileHandle = new FstFileHandle(new FstFileInput(fileName, directIO));
+  }
+
+  if (!fileHandle->fstHandle->Open())
+  {
+    delete fileHandle;
+    throw(runtime_error("The fst file uses a deprecated format, please resave the file to open a handle."));
+  }
+
+  return fileHandle;
+}
+
+
+// External pointer, number of rows and column names of an opened handle
+inline SEXP HandleResult(FstFileHandle* fileHandle)
+{
+  double nrOfRows = (double) fileHandle->fstHandle->NrOfRows();
+
+  vector<int> colIndex(fileHandle->fstHandle->NrOfColumns());
+  for (int colNr = 0; colNr < (int) colIndex.size(); ++colNr) colIndex[colNr] = colNr;
+
+  vector<int> keyIndex;
+  StringArray colNames;
+  fileHandle->fstHandle->SelectedColumns(colIndex, &colNames, keyIndex);
+
+  XPtr<FstFileHandle> handle(fileHandle, true);
+
+  return List::create(
+    _["ptr"] = handle,
+    _["nrOfRows"] = nrOfRows,
+    _["colNames"] = colNames.StrVector());
+}
+
+
+SEXP fstHandleOpen(String fileName, SEXP memoryMapped, SEXP verify)
+{
+  FstFileHandle* fileHandle = nullptr;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fileHandle = OpenFileHandle(fileName.get_cstring(), *LOGICAL(memoryMapped) == 1);
+    fileHandle->fstHandle->SetVerifyOnRead(*LOGICAL(verify) == 1);
+    fileHandle->fstHandle->SetBlockCache(true);
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  return HandleResult(fileHandle);
+}
+
+
+// Byte ranges of a remote fst file, read with an R function. The function is called with the offsets and sizes of
+// the requested ranges and returns a list with a raw vector for each range. Because R can only be called from the
+// main thread, the source is not thread-safe and all reads of the handle are done from the calling thread.
+class RRangeSource : public IRangeSource
+{
+  Function reader;
+  unsigned long long fileSize;
+
+public:
+  RRangeSource(SEXP reader, unsigned long long fileSize) : reader(reader), fileSize(fileSize) {}
+
+  unsigned long long Size() { return fileSize; }
+
+  bool ReadRanges(unsigned int nrOfRanges, const unsigned long long* offsets, const unsigned long long* sizes,
+    char** buffers)
+  {
+    NumericVector offsetVec(nrOfRanges);
+    NumericVector sizeVec(nrOfRanges);
+
+    for (unsigned int rangeNr = 0; rangeNr < nrOfRanges; ++rangeNr)
+    {
+      offsetVec[rangeNr] = (double) offsets[rangeNr];
+      sizeVec[rangeNr] = (double) sizes[rangeNr];
+    }
+
+    // Errors of the reader are reported as a failed read
+    try
+    {
+      List ranges = reader(offsetVec, sizeVec);
+
+      if (ranges.size() != (R_xlen_t) nrOfRanges) return false;
+
+      for (unsigned int rangeNr = 0; rangeNr < nrOfRanges; ++rangeNr)
+      {
+        SEXP range = ranges[rangeNr];
+
+        if (TYPEOF(range) != RAWSXP || (unsigned long long) XLENGTH(range) != sizes[rangeNr]) return false;
+
+        memcpy(buffers[rangeNr], RAW(range), sizes[rangeNr]);
+      }
+    }
+    catch (...)
+    {
+      return false;
+    }
+
+    return true;
+  }
+};
+
+
+SEXP fstHandleOpenRemote(SEXP reader, SEXP fileSize, SEXP cacheSize, SEXP verify)
+{
+  // Cache size is specified in MB
+  unsigned long long cacheBytes = (unsigned long long) (Rf_asReal(cacheSize) * 1048576);
+  IRangeSource* source = new RRangeSource(reader, (unsigned long long) Rf_asReal(fileSize));
+  FstFileHandle* fileHandle = new FstFileHandle(new FstRangeInput(source, cacheBytes));
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    if (!fileHandle->fstHandle->Open())
+    {
+      throw(runtime_error("The fst file uses a deprecated format, please resave the file to open a handle."));
+    }
+
+    fileHandle->fstHandle->SetVerifyOnRead(*LOGICAL(verify) == 1);
+    fileHandle->fstHandle->SetBlockCache(true);
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  if (errorMessage[0] != 0)
+  {
+    delete fileHandle;
+    ::Rf_error(errorMessage);
+  }
+
+  return HandleResult(fileHandle);
+}
+
+
+SEXP fstDatasetRead(SEXP fileNames, SEXP columnSelection)
+{
+  int nrOfFiles = LENGTH(fileNames);
+
+  StringArray* colSelection = nullptr;
+
+  if (!Rf_isNull(columnSelection))
+  {
+    colSelection = new StringArray();
+    colSelection->SetArray(columnSelection);
+  }
+
+  vector<FstFileHandle*> fileHandles;
+  FstDataset dataset;
+  FstTableReader tableReader;
+  vector<int> colIndex;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    for (int fileNr = 0; fileNr < nrOfFiles; ++fileNr)
+    {
+      fileHandles.push_back(OpenFileHandle(CHAR(STRING_ELT(fileNames, fileNr)), false));
+      dataset.AddTable(*fileHandles.back()->fstHandle);
+    }
+
+    fileHandles[0]->fstHandle->SelectColumns(colSelection, colIndex);
+    dataset.Read(tableReader, colIndex, getDTthreads());
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete colSelection;
+
+  if (errorMessage[0] != 0)
+  {
+    for (FstFileHandle* fileHandle : fileHandles) delete fileHandle;
+    ::Rf_error(errorMessage);
+  }
+
+  // The rows of the files aren't sorted on the key columns of the first file
+  vector<int> keyIndex;
+  StringArray* colNames = new StringArray();
+  fileHandles[0]->fstHandle->SelectedColumns(colIndex, colNames, keyIndex);
+  keyIndex.clear();
+
+  for (FstFileHandle* fileHandle : fileHandles) delete fileHandle;
+
+  return ResultTable(tableReader, colNames, keyIndex);
+}
+
+
+SEXP fstCopy(SEXP fileNames, SEXP outputName, SEXP columnSelection, SEXP recompressColumns, SEXP compression,
+  SEXP chunkRows)
+{
+  int compress = CompressionLevel(compression);
+  int nrOfFiles = LENGTH(fileNames);
+
+  StringArray* colSelection = nullptr;
+  StringArray* recompressSelection = nullptr;
+
+  if (!Rf_isNull(columnSelection))
+  {
+    colSelection = new StringArray();
+    colSelection->SetArray(columnSelection);
+  }
+
+  if (!Rf_isNull(recompressColumns))
+  {
+    recompressSelection = new StringArray();
+    recompressSelection->SetArray(recompressColumns);
+  }
+
+  vector<FstFileHandle*> fileHandles;
+  FstCopier copier;
+  unsigned long long nrOfRows = 0;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    for (int fileNr = 0; fileNr < nrOfFiles; ++fileNr)
+    {
+      fileHandles.push_back(OpenFileHandle(CHAR(STRING_ELT(fileNames, fileNr)), false));
+      copier.AddTable(*fileHandles.back()->fstHandle);
+    }
+
+    FstHandle &first = *fileHandles[0]->fstHandle;
+    vector<int> colIndex;
+
+    if (colSelection != nullptr)
+    {
+      first.SelectColumns(colSelection, colIndex);
+      copier.SelectColumns(colIndex);
+    }
+
+    if (recompressSelection != nullptr)
+    {
+      first.SelectColumns(recompressSelection, colIndex);
+
+      for (int colNr : colIndex) copier.Recompress(colNr, compress);
+    }
+
+    if (*REAL(chunkRows) > 0)
+    {
+      copier.MergeChunks((unsigned long long) *REAL(chunkRows), compress);
+    }
+
+    FstFileOutput fileOutput(CHAR(STRING_ELT(outputName, 0)), true, directIO);
+    nrOfRows = copier.Write(fileOutput, getDTthreads());
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete colSelection;
+  delete recompressSelection;
+
+  for (FstFileHandle* fileHandle : fileHandles) delete fileHandle;
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  return Rf_ScalarReal((double) nrOfRows);
+}
+
+
+SEXP fstIndex(SEXP fileName, SEXP column, SEXP currentIndex, SEXP outputName, SEXP compression, SEXP batchRows)
+{
+  int compress = CompressionLevel(compression);
+
+  StringArray colSelection;
+  colSelection.SetArray(column);
+
+  // The sorted runs are stored next to the new index
+  string runName = string(CHAR(STRING_ELT(outputName, 0))) + ".run";
+
+  FstFileHandle* fileHandle = nullptr;
+  FstFileHandle* indexHandle = nullptr;
+  unsigned long long nrOfRows = 0;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fileHandle = OpenFileHandle(CHAR(STRING_ELT(fileName, 0)), false);
+
+    if (!Rf_isNull(currentIndex))
+    {
+      indexHandle = OpenFileHandle(CHAR(STRING_ELT(currentIndex, 0)), false);
+    }
+
+    vector<int> colIndex;
+    fileHandle->fstHandle->SelectColumns(&colSelection, colIndex);
+
+    FstIndexer indexer(*fileHandle->fstHandle, compress, (unsigned long long) Rf_asReal(batchRows), getDTthreads());
+    nrOfRows = indexer.Build(colIndex[0], indexHandle == nullptr ? nullptr : indexHandle->fstHandle, runName.c_str(),
+      CHAR(STRING_ELT(outputName, 0)));
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete fileHandle;
+  delete indexHandle;
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  return Rf_ScalarReal((double) nrOfRows);
+}
+
+
+SEXP fstJoin(SEXP leftName, SEXP rightName, SEXP nrOfKeys, SEXP leftColumns, SEXP rightColumns, SEXP colNames,
+  SEXP allLeft, SEXP outputName, SEXP compression, SEXP batchRows)
+{
+  int compress = CompressionLevel(compression);
+
+  // Column numbers are 0-based
+  vector<int> leftCols(INTEGER(leftColumns), INTEGER(leftColumns) + LENGTH(leftColumns));
+  vector<int> rightCols(INTEGER(rightColumns), INTEGER(rightColumns) + LENGTH(rightColumns));
+
+  vector<string> names;
+  for (int colNr = 0; colNr < LENGTH(colNames); ++colNr)
+  {
+    names.push_back(CHAR(STRING_ELT(colNames, colNr)));
+  }
+
+  FstFileHandle* leftHandle = nullptr;
+  FstFileHandle* rightHandle = nullptr;
+  unsigned long long nrOfRows = 0;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    leftHandle = OpenFileHandle(CHAR(STRING_ELT(leftName, 0)), false);
+    rightHandle = OpenFileHandle(CHAR(STRING_ELT(rightName, 0)), false);
+
+    FstJoiner joiner(*leftHandle->fstHandle, *rightHandle->fstHandle, compress,
+      (unsigned long long) Rf_asReal(batchRows), getDTthreads());
+    nrOfRows = joiner.Join(Rf_asInteger(nrOfKeys), leftCols, rightCols, names, Rf_asLogical(allLeft) == TRUE,
+      CHAR(STRING_ELT(outputName, 0)));
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete leftHandle;
+  delete rightHandle;
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  return Rf_ScalarReal((double) nrOfRows);
+}
+
+SEXP fstHandleRead(SEXP handle, SEXP columnSelection, SEXP startRow, SEXP endRow)
+{
+  FstFileHandle* fileHandle = GetFileHandle(handle);
+
+  // Row numbers are passed as doubles to address rows beyond 2^31 - 1
+  long long sRow = (long long) Rf_asReal(startRow);
+  long long eRow = Rf_isNull(endRow) ? -1 : (long long) Rf_asReal(endRow);
+
+  StringArray* colSelection = nullptr;
+
+  if (!Rf_isNull(columnSelection))
+  {
+    colSelection = new StringArray();
+    colSelection->SetArray(columnSelection);
+  }
+
+  FstTableReader tableReader;
+  vector<int> colIndex;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fileHandle->fstHandle->SelectColumns(colSelection, colIndex);
+    fileHandle->fstHandle->ReadRange(tableReader, colIndex, sRow, eRow, getDTthreads());
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete colSelection;
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  vector<int> keyIndex;
+  StringArray* colNames = new StringArray();
+  fileHandle->fstHandle->SelectedColumns(colIndex, colNames, keyIndex);
+
+  return ResultTable(tableReader, colNames, keyIndex);
+}
+
+
+SEXP ReadHandleColumn(SEXP handle, int colNr, unsigned long long firstRow, unsigned long long length)
+{
+  FstFileHandle* fileHandle = GetFileHandle(handle);
+
+  FstTableReader tableReader;
+  vector<int> colIndex(1, colNr);
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fileHandle->fstHandle->ReadRows(tableReader, colIndex, firstRow, length, getDTthreads());
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  return VECTOR_ELT(tableReader.resTable, 0);
+}
+
+
+// The first row of the selected columns is read to determine the type and attributes of each lazy column
+SEXP fstHandleReadLazy(SEXP handle, SEXP columnSelection, SEXP startRow, SEXP endRow)
+{
+  FstFileHandle* fileHandle = GetFileHandle(handle);
+
+  // Row numbers are passed as doubles to address rows beyond 2^31 - 1
+  long long sRow = (long long) Rf_asReal(startRow);
+  long long eRow = Rf_isNull(endRow) ? -1 : (long long) Rf_asReal(endRow);
+
+  StringArray* colSelection = nullptr;
+
+  if (!Rf_isNull(columnSelection))
+  {
+    colSelection = new StringArray();
+    colSelection->SetArray(columnSelection);
+  }
+
+  FstTableReader tableReader;
+  FstTableReader factorReader;
+  vector<int> colIndex;
+  vector<int> factorIndex;
+  unsigned long long length = 0;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    FstHandle* fstHandle = fileHandle->fstHandle;
+    fstHandle->SelectColumns(colSelection, colIndex);
+
+    if (eRow != -1 && eRow < sRow)
+    {
+      throw(runtime_error("Incorrect row range specified."));
+    }
+
+    fstHandle->ReadRange(tableReader, colIndex, sRow, sRow, 1);  // validates the first row
+
+    long long nrOfRows = (long long) fstHandle->NrOfRows();
+    length = (unsigned long long) (eRow == -1 ? nrOfRows - sRow + 1 : min(eRow, nrOfRows) - sRow + 1);
+
+    // Each data chunk has its own factor levels and a read of multiple chunks merges them, so the levels of the
+    // sample only hold for rows of its own chunk. Factor columns of rows in multiple chunks are read directly.
+    bool multipleChunks = false;
+
+    for (unsigned int chunkNr = 1; chunkNr < fstHandle->NrOfChunks(); ++chunkNr)
+    {
+      unsigned long long chunkRow = fstHandle->ChunkFirstRow(chunkNr);
+      if (chunkRow > (unsigned long long) sRow - 1 && chunkRow < sRow - 1 + length) multipleChunks = true;
+    }
+
+    if (multipleChunks)
+    {
+      for (int colNr : colIndex)
+      {
+        if (fstHandle->ColumnType(colNr) == 7) factorIndex.push_back(colNr);
+      }
+    }
+
+    if (!factorIndex.empty())
+    {
+      fstHandle->ReadRange(factorReader, factorIndex, sRow, sRow - 1 + length, getDTthreads());
+    }
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete colSelection;
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  unsigned int factorNr = 0;
+
+  for (unsigned int col = 0; col < colIndex.size(); ++col)
+  {
+    if (factorNr < factorIndex.size() && factorIndex[factorNr] == colIndex[col])
+    {
+      SET_VECTOR_ELT(tableReader.resTable, col, VECTOR_ELT(factorReader.resTable, factorNr++));
+      continue;
+    }
+
+    SEXP sample = VECTOR_ELT(tableReader.resTable, col);
+    SET_VECTOR_ELT(tableReader.resTable, col, LazyColumn(handle, colIndex[col], sRow - 1, length, sample));
+  }
+
+  vector<int> keyIndex;
+  StringArray* colNames = new StringArray();
+  fileHandle->fstHandle->SelectedColumns(colIndex, colNames, keyIndex);
+
+  return ResultTable(tableReader, colNames, keyIndex);
+}
+
+
+// The columns of target receive the stored columns with the same names, without allocating new vectors
+SEXP fstHandleReadInto(SEXP handle, SEXP target, SEXP startRow)
+{
+  FstFileHandle* fileHandle = GetFileHandle(handle);
+
+  // Row numbers are passed as doubles to address rows beyond 2^31 - 1
+  long long sRow = (long long) Rf_asReal(startRow);
+  long long nrOfTargetRows = (long long) XLENGTH(VECTOR_ELT(target, 0));
+
+  StringArray* colSelection = new StringArray();
+  colSelection->SetArray(Rf_getAttrib(target, R_NamesSymbol));
+
+  FstTableReader tableReader;
+  TargetColumnFactory targetFactory(target);
+  IColumnFactory* columnFactory = fileHandle->fstHandle->SetColumnFactory(&targetFactory);
+
+  vector<int> colIndex;
+  unsigned long long nrOfRows = 0;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fileHandle->fstHandle->SelectColumns(colSelection, colIndex);
+    nrOfRows = fileHandle->fstHandle->ReadRange(tableReader, colIndex, sRow, sRow + nrOfTargetRows - 1, getDTthreads());
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  fileHandle->fstHandle->SetColumnFactory(columnFactory);
+  delete colSelection;
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  return Rf_ScalarReal((double) nrOfRows);
+}
+
+
+// Convert 1-based row numbers, validated and sorted on the R side, to 0-based row numbers. Doubles are used to
+// address rows beyond 2^31 - 1.
+inline void RowSelection(SEXP rows, vector<unsigned long long> &rowSel)
+{
+  unsigned long long nrOfSel = (unsigned long long) LENGTH(rows);
+  double* rowNumbers = REAL(rows);
+
+  rowSel.resize(nrOfSel);
+  for (unsigned long long sel = 0; sel < nrOfSel; ++sel)
+  {
+    rowSel[sel] = (unsigned long long) rowNumbers[sel] - 1;
+  }
+}
+
+
+SEXP fstRetrieveRows(String fileName, SEXP columnSelection, SEXP rows, SEXP memoryMapped)
+{
+  vector<unsigned long long> rowSel;
+  RowSelection(rows, rowSel);
+
+  StringArray* colSelection = nullptr;
+
+  if (!Rf_isNull(columnSelection))
+  {
+    colSelection = new StringArray();
+    colSelection->SetArray(columnSelection);
+  }
+
+  FstFileHandle* fileHandle = nullptr;
+  FstTableReader tableReader;
+  vector<int> colIndex;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fileHandle = OpenFileHandle(fileName.get_cstring(), *LOGICAL(memoryMapped) == 1);
+    fileHandle->fstHandle->SelectColumns(colSelection, colIndex);
+    fileHandle->fstHandle->ReadRowSet(tableReader, colIndex, rowSel.data(), rowSel.size(), getDTthreads());
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete colSelection;
+
+  if (errorMessage[0] != 0)
+  {
+    delete fileHandle;
+    ::Rf_error(errorMessage);
+  }
+
+  vector<int> keyIndex;
+  StringArray* colNames = new StringArray();
+  fileHandle->fstHandle->SelectedColumns(colIndex, colNames, keyIndex);
+
+  delete fileHandle;
+
+  return ResultTable(tableReader, colNames, keyIndex);
+}
+
+
+SEXP fstHandleReadRows(SEXP handle, SEXP columnSelection, SEXP rows)
+{
+  FstFileHandle* fileHandle = GetFileHandle(handle);
+
+  vector<unsigned long long> rowSel;
+  RowSelection(rows, rowSel);
+
+  StringArray* colSelection = nullptr;
+
+  if (!Rf_isNull(columnSelection))
+  {
+    colSelection = new StringArray();
+    colSelection->SetArray(columnSelection);
+  }
+
+  FstTableReader tableReader;
+  vector<int> colIndex;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fileHandle->fstHandle->SelectColumns(colSelection, colIndex);
+    fileHandle->fstHandle->ReadRowSet(tableReader, colIndex, rowSel.data(), rowSel.size(), getDTthreads());
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete colSelection;
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  vector<int> keyIndex;
+  StringArray* colNames = new StringArray();
+  fileHandle->fstHandle->SelectedColumns(colIndex, colNames, keyIndex);
+
+  return ResultTable(tableReader, colNames, keyIndex);
+}
+
+
+SEXP fstHandleSample(SEXP handle, SEXP columnSelection, SEXP fraction, SEXP blocks, SEXP seed)
+{
+  FstFileHandle* fileHandle = GetFileHandle(handle);
+
+  StringArray* colSelection = nullptr;
+
+  if (!Rf_isNull(columnSelection))
+  {
+    colSelection = new StringArray();
+    colSelection->SetArray(columnSelection);
+  }
+
+  FstTableReader tableReader;
+  vector<int> colIndex;
+  vector<unsigned long long> rowSel;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fileHandle->fstHandle->SelectColumns(colSelection, colIndex);
+    fileHandle->fstHandle->SampleRows(colIndex, *REAL(fraction), *LOGICAL(blocks) == 1,
+      (unsigned long long) *REAL(seed), rowSel);
+
+    if (!rowSel.empty())
+    {
+      fileHandle->fstHandle->ReadRowSet(tableReader, colIndex, rowSel.data(), rowSel.size(), getDTthreads());
+    }
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete colSelection;
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  // An empty sample is read as an empty row selection on the R side
+  if (rowSel.empty()) return R_NilValue;
+
+  vector<int> keyIndex;
+  StringArray* colNames = new StringArray();
+  fileHandle->fstHandle->SelectedColumns(colIndex, colNames, keyIndex);
+
+  return ResultTable(tableReader, colNames, keyIndex);
+}
+
+
+// Convert a row filter, created with row_filter in R, to a predicate. Each node is a list with the operator,
+// column name, operand vector (double or character), NA flag and the list of operands of logical operators.
+FstPredicate* RowFilter(SEXP rowFilter)
+{
+  static const char* opNames[] = { "==", "!=", "<", "<=", ">", ">=", "%in%", "&", "|" };
+
+  const char* opName = CHAR(STRING_ELT(VECTOR_ELT(rowFilter, 0), 0));
+
+  int op = 0;
+  while (op < 8 && strcmp(opName, opNames[op]) != 0) ++op;
+
+  FstPredicate* predicate = new FstPredicate((PredicateOperator) (op + 1));
+  predicate->colName = CHAR(STRING_ELT(VECTOR_ELT(rowFilter, 1), 0));
+  predicate->matchNA = *LOGICAL(VECTOR_ELT(rowFilter, 3)) == 1;
+
+  SEXP operands = VECTOR_ELT(rowFilter, 2);
+  int nrOfOperands = LENGTH(operands);
+
+  if (TYPEOF(operands) == STRSXP)
+  {
+    for (int pos = 0; pos < nrOfOperands; ++pos)
+    {
+      predicate->strings.push_back(CHAR(STRING_ELT(operands, pos)));
+    }
+  }
+  else if (TYPEOF(operands) == REALSXP)
+  {
+    predicate->values.assign(REAL(operands), REAL(operands) + nrOfOperands);
+  }
+
+  SEXP subFilters = VECTOR_ELT(rowFilter, 4);
+
+  for (int pos = 0; pos < LENGTH(subFilters); ++pos)
+  {
+    predicate->operands.push_back(RowFilter(VECTOR_ELT(subFilters, pos)));
+  }
+
+  return predicate;
+}
+
+
+SEXP fstHandleFilter(SEXP handle, SEXP rowFilter)
+{
+  FstFileHandle* fileHandle = GetFileHandle(handle);
+
+  FstPredicate* predicate = RowFilter(rowFilter);
+  vector<unsigned long long> rows;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    FstFilter fstFilter(*fileHandle->fstHandle);
+    fstFilter.SelectRows(*predicate, rows, getDTthreads());
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete predicate;
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  // Row numbers are returned as doubles to address rows beyond 2^31 - 1
+  SEXP rowNumbers = PROTECT(Rf_allocVector(REALSXP, rows.size()));
+  double* rowNumbersP = REAL(rowNumbers);
+
+  for (unsigned long long sel = 0; sel < rows.size(); ++sel)
+  {
+    rowNumbersP[sel] = (double) (rows[sel] + 1);
+  }
+
+  UNPROTECT(1);
+
+  return rowNumbers;
+}
+
+
+SEXP fstHandleKeyLookup(SEXP handle, SEXP keyValues)
+{
+  FstFileHandle* fileHandle = GetFileHandle(handle);
+
+  // Key values are single doubles or strings, as prepared by read_key
+  vector<FstKeyValue> keys(LENGTH(keyValues));
+
+  for (unsigned int keyNr = 0; keyNr < keys.size(); ++keyNr)
+  {
+    SEXP keyValue = VECTOR_ELT(keyValues, keyNr);
+
+    keys[keyNr].isString = TYPEOF(keyValue) == STRSXP;
+    keys[keyNr].value = keys[keyNr].isString ? 0 : *REAL(keyValue);
+
+    if (keys[keyNr].isString) keys[keyNr].str = CHAR(STRING_ELT(keyValue, 0));
+  }
+
+  unsigned long long firstRow = 0;
+  unsigned long long nrOfRows = 0;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    FstKeyLookup keyLookup(*fileHandle->fstHandle);
+    nrOfRows = keyLookup.Lookup(keys, firstRow);
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  // First matching row (1-based) and the number of matching rows
+  SEXP keyRange = PROTECT(Rf_allocVector(REALSXP, 2));
+  REAL(keyRange)[0] = (double) (firstRow + 1);
+  REAL(keyRange)[1] = (double) nrOfRows;
+
+  UNPROTECT(1);
+
+  return keyRange;
+}
+
+
+SEXP fstHandleKeyLookupBatch(SEXP handle, SEXP keyValues)
+{
+  FstFileHandle* fileHandle = GetFileHandle(handle);
+
+  // Key columns are double or character vectors of equal length, as prepared by fst.lookup
+  vector<FstKeyValues> keys(LENGTH(keyValues));
+
+  for (unsigned int keyNr = 0; keyNr < keys.size(); ++keyNr)
+  {
+    SEXP keyVec = VECTOR_ELT(keyValues, keyNr);
+    R_xlen_t nrOfKeys = XLENGTH(keyVec);
+    FstKeyValues &keyCol = keys[keyNr];
+
+    keyCol.isString = TYPEOF(keyVec) == STRSXP;
+
+    if (!keyCol.isString)
+    {
+      keyCol.values.assign(REAL(keyVec), REAL(keyVec) + nrOfKeys);
+      continue;
+    }
+
+    keyCol.strs.resize(nrOfKeys);
+    keyCol.isNA.resize(nrOfKeys);
+
+    for (R_xlen_t key = 0; key < nrOfKeys; ++key)
+    {
+      SEXP str = STRING_ELT(keyVec, key);
+      keyCol.isNA[key] = str == NA_STRING;
+      if (str != NA_STRING) keyCol.strs[key].assign(CHAR(str), LENGTH(str));
+    }
+  }
+
+  vector<unsigned long long> firstRows;
+  vector<unsigned long long> rowCounts;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    FstKeyLookup keyLookup(*fileHandle->fstHandle);
+    keyLookup.LookupBatch(keys, firstRows, rowCounts, getDTthreads());
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  // First matching row (1-based) and the number of matching rows of each key
+  SEXP firstVec = PROTECT(Rf_allocVector(REALSXP, firstRows.size()));
+  SEXP countVec = PROTECT(Rf_allocVector(REALSXP, rowCounts.size()));
+
+  for (size_t key = 0; key < firstRows.size(); ++key)
+  {
+    REAL(firstVec)[key] = (double) (firstRows[key] + 1);
+    REAL(countVec)[key] = (double) rowCounts[key];
+  }
+
+  SEXP keyRanges = PROTECT(Rf_allocVector(VECSXP, 2));
+  SET_VECTOR_ELT(keyRanges, 0, firstVec);
+  SET_VECTOR_ELT(keyRanges, 1, countVec);
+
+  UNPROTECT(3);
+
+  return keyRanges;
+}
+
+
+// Values of the groups of a grouped aggregate as an R vector of the stored type of the group column
+SEXP GroupVector(GroupValues &groups, unsigned short int colType)
+{
+  unsigned int nrOfGroups = (unsigned int) groups.isNA.size();
+  SEXP groupVec;
+
+  switch (colType)
+  {
+    case 6:
+    case 7:
+      groupVec = PROTECT(Rf_allocVector(STRSXP, nrOfGroups));
+
+      for (unsigned int groupNr = 0; groupNr < nrOfGroups; ++groupNr)
+      {
+        const string &value = groups.strings[groupNr];
+        SET_STRING_ELT(groupVec, groupNr,
+          groups.isNA[groupNr] ? NA_STRING : Rf_mkCharLen(value.data(), (int) value.size()));
+      }
+      break;
+
+    case 8:
+    case 10:
+      groupVec = PROTECT(Rf_allocVector(colType == 8 ? INTSXP : LGLSXP, nrOfGroups));
+
+      for (unsigned int groupNr = 0; groupNr < nrOfGroups; ++groupNr)
+      {
+        INTEGER(groupVec)[groupNr] = groups.isNA[groupNr] ? NA_INTEGER : (int) groups.values[groupNr];
+      }
+      break;
+
+    case 11:
+      // Stored as the bits of a bit64::integer64 vector
+      groupVec = PROTECT(Rf_allocVector(REALSXP, nrOfGroups));
+
+      if (nrOfGroups > 0) memcpy(REAL(groupVec), groups.int64Values.data(), 8 * nrOfGroups);
+      break;
+
+    default:
+      groupVec = PROTECT(Rf_allocVector(REALSXP, nrOfGroups));
+
+      for (unsigned int groupNr = 0; groupNr < nrOfGroups; ++groupNr)
+      {
+        REAL(groupVec)[groupNr] = groups.isNA[groupNr] ? NA_REAL : groups.values[groupNr];
+      }
+      break;
+  }
+
+  UNPROTECT(1);
+
+  return groupVec;
+}
+
+
+SEXP fstHandleAggregate(SEXP handle, SEXP columnSelection, SEXP functions, SEXP rowFilter, SEXP groupColumn)
+{
+  FstFileHandle* fileHandle = GetFileHandle(handle);
+
+  StringArray* colSelection = nullptr;
+  StringArray* groupSelection = nullptr;
+
+  if (!Rf_isNull(columnSelection))
+  {
+    colSelection = new StringArray();
+    colSelection->SetArray(columnSelection);
+  }
+
+  if (!Rf_isNull(groupColumn))
+  {
+    groupSelection = new StringArray();
+    groupSelection->SetArray(groupColumn);
+  }
+
+  FstPredicate* predicate = Rf_isNull(rowFilter) ? nullptr : RowFilter(rowFilter);
+
+  vector<int> colIndex;
+  vector<int> groupIndex;
+  vector<ColumnAggregate> results;
+  GroupValues groups;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fileHandle->fstHandle->SelectColumns(colSelection, colIndex);
+
+    FstAggregator aggregator(*fileHandle->fstHandle);
+
+    if (groupSelection == nullptr)
+    {
+      aggregator.Aggregate(colIndex, Rf_asInteger(functions), predicate, results, getDTthreads());
+    }
+    else
+    {
+      fileHandle->fstHandle->SelectColumns(groupSelection, groupIndex);
+      aggregator.AggregateGroups(colIndex, groupIndex[0], predicate, groups, results, getDTthreads());
+    }
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete colSelection;
+  delete groupSelection;
+  delete predicate;
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  // Counts are returned as doubles to count beyond 2^31 - 1 values, NaN aggregates are returned as NA
+  SEXP counts = PROTECT(Rf_allocVector(REALSXP, results.size()));
+  SEXP sums = PROTECT(Rf_allocVector(REALSXP, results.size()));
+  SEXP minValues = PROTECT(Rf_allocVector(REALSXP, results.size()));
+  SEXP maxValues = PROTECT(Rf_allocVector(REALSXP, results.size()));
+
+  for (unsigned int pos = 0; pos < results.size(); ++pos)
+  {
+    ColumnAggregate &result = results[pos];
+
+    REAL(counts)[pos] = (double) result.count;
+    REAL(sums)[pos] = result.sum != result.sum ? NA_REAL : result.sum;
+    REAL(minValues)[pos] = result.minValue != result.minValue ? NA_REAL : result.minValue;
+    REAL(maxValues)[pos] = result.maxValue != result.maxValue ? NA_REAL : result.maxValue;
+  }
+
+  // Grouped aggregates are followed by the values of the groups
+  SEXP aggregates = PROTECT(Rf_allocVector(VECSXP, groupIndex.empty() ? 4 : 5));
+  SET_VECTOR_ELT(aggregates, 0, counts);
+  SET_VECTOR_ELT(aggregates, 1, sums);
+  SET_VECTOR_ELT(aggregates, 2, minValues);
+  SET_VECTOR_ELT(aggregates, 3, maxValues);
+
+  if (!groupIndex.empty())
+  {
+    SET_VECTOR_ELT(aggregates, 4, GroupVector(groups, fileHandle->fstHandle->ColumnType(groupIndex[0])));
+  }
+
+  UNPROTECT(5);
+
+  return aggregates;
+}
+
+
+SEXP fstHandleDistinct(SEXP handle, SEXP column, SEXP maxValues)
+{
+  FstFileHandle* fileHandle = GetFileHandle(handle);
+
+  StringArray colSelection;
+  colSelection.SetArray(column);
+
+  // A cap of zero collects all distinct values
+  unsigned long long maxNrOfValues = Rf_isNull(maxValues) ? 0 : (unsigned long long) Rf_asReal(maxValues);
+
+  vector<int> colIndex;
+  GroupValues values;
+  bool complete = false;
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fileHandle->fstHandle->SelectColumns(&colSelection, colIndex);
+
+    FstAggregator aggregator(*fileHandle->fstHandle);
+    complete = aggregator.Distinct(colIndex[0], maxNrOfValues, values, getDTthreads());
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  // More distinct values than the cap
+  if (!complete) return R_NilValue;
+
+  return GroupVector(values, fileHandle->fstHandle->ColumnType(colIndex[0]));
+}
+
+
+SEXP fstHandleClose(SEXP handle)
+{
+  // Closing a handle twice has no effect
+  if (TYPEOF(handle) == EXTPTRSXP && R_ExternalPtrAddr(handle) == nullptr)
+  {
+    return R_NilValue;
+  }
+
+  FstFileHandle* fileHandle = GetFileHandle(handle);
+
+  // Closes the file, the finalizer ignores the cleared pointer
+  delete fileHandle;
+  R_ClearExternalPtr(handle);
+
+  return R_NilValue;
+}
+
+
+SEXP fstBlockCache(SEXP budget, SEXP reset)
+{
+  BlockCache &blockCache = BlockCache::Global();
+  BlockCacheStats stats = blockCache.Stats();
+
+  if (!Rf_isNull(budget)) blockCache.SetBudget((unsigned long long) *REAL(budget));
+  if (*LOGICAL(reset) == 1) blockCache.ResetStats();
+
+  return List::create(
+    _["budget"] = (double) stats.budget,
+    _["size"] = (double) stats.size,
+    _["blocks"] = (double) stats.blocks,
+    _["hits"] = (double) stats.hits,
+    _["misses"] = (double) stats.misses);
+}
+
+
+SEXP fstSharedBlockCache(SEXP size)
+{
+  SharedBlockCache &sharedCache = SharedBlockCache::Global();
+  SharedBlockCacheStats stats = sharedCache.Stats();
+
+  if (!Rf_isNull(size) && !sharedCache.Create((unsigned long long) *REAL(size)))
+  {
+    ::Rf_error("The shared block cache is not supported on this system.");
+  }
+
+  return List::create(
+    _["size"] = (double) stats.size,
+    _["used"] = (double) stats.used,
+    _["blocks"] = (double) stats.blocks,
+    _["hits"] = (double) stats.hits,
+    _["misses"] = (double) stats.misses);
+}
+
+
+SEXP fstProfile(SEXP enable)
+{
+  if (!Rf_isNull(enable)) profiling = *LOGICAL(enable) == 1;
+
+  if (lastProfile == nullptr) return List::create(_["enabled"] = profiling);
+
+  // The metadata precedes the columns
+  int nrOfCols = lastProfile->NrOfColumns();
+  CharacterVector colNames(nrOfCols + 1);
+  NumericVector bytes(nrOfCols + 1);
+  NumericVector uncompressedBytes(nrOfCols + 1);
+  NumericMatrix phases(nrOfCols + 1, PROFILE_PHASES);
+  NumericMatrix blocks(nrOfCols + 1, PROFILE_ALGORITHMS);
+
+  for (int colNr = PROFILE_METADATA; colNr < nrOfCols; ++colNr)
+  {
+    ColumnProfile* column = lastProfile->Column(colNr);
+    int row = colNr + 1;
+
+    colNames[row] = colNr == PROFILE_METADATA ? "" :
+      (colNr < (int) profileColumns.size() ? profileColumns[colNr] : "");
+    bytes[row] = (double) column->bytes;
+    uncompressedBytes[row] = (double) column->uncompressedBytes;
+
+    for (int phase = 0; phase < PROFILE_PHASES; ++phase) phases(row, phase) = column->nanos[phase] / 1e9;
+    for (int algo = 0; algo < PROFILE_ALGORITHMS; ++algo) blocks(row, algo) = (double) column->blocks[algo];
+  }
+
+  return List::create(
+    _["enabled"] = profiling,
+    _["seconds"] = lastProfile->totalNanos / 1e9,
+    _["bytesRead"] = (double) lastProfile->bytesRead,
+    _["bytesWritten"] = (double) lastProfile->bytesWritten,
+    _["seeks"] = (double) lastProfile->seeks,
+    _["colNames"] = colNames,
+    _["bytes"] = bytes,
+    _["uncompressedBytes"] = uncompressedBytes,
+    _["phases"] = phases,
+    _["blocks"] = blocks);
+}
+
+
+SEXP fstHandleVerify(SEXP handle, SEXP columnSelection)
+{
+  FstFileHandle* fileHandle = GetFileHandle(handle);
+  FstHandle* fstHandle = fileHandle->fstHandle;
+
+  StringArray* colSelection = nullptr;
+
+  if (!Rf_isNull(columnSelection))
+  {
+    colSelection = new StringArray();
+    colSelection->SetArray(columnSelection);
+  }
+
+  vector<int> colIndex;
+  vector<int> verified;  // R logical values
+
+  char errorMessage[ERROR_MESSAGE_SIZE] = "";
+
+  try
+  {
+    fstHandle->SelectColumns(colSelection, colIndex);
+
+    for (int colNr : colIndex)
+    {
+      // Columns without checksums can't be verified
+      int colVerified = fstHandle->HasChecksums(colNr) ? TRUE : NA_LOGICAL;
+
+      for (unsigned int chunkNr = 0; chunkNr < fstHandle->NrOfChunks() && colVerified == TRUE; ++chunkNr)
+      {
+        if (!fstHandle->VerifyColumn(chunkNr, colNr)) colVerified = FALSE;
+      }
+
+      verified.push_back(colVerified);
+    }
+  }
+  catch (const std::runtime_error& e)
+  {
+    strncpy(errorMessage, e.what(), ERROR_MESSAGE_SIZE - 1);
+  }
+
+  delete colSelection;
+
+  if (errorMessage[0] != 0)
+  {
+    ::Rf_error(errorMessage);
+  }
+
+  SEXP result = PROTECT(Rf_allocVector(LGLSXP, verified.size()));
+
+  for (unsigned int colSel = 0; colSel < verified.size(); ++colSel)
+  {
+    LOGICAL(result)[colSel] = verified[colSel];
+  }
+
+  vector<int> keyIndex;
+  StringArray* colNames = new StringArray();
+  fstHandle->SelectedColumns(colIndex, colNames, keyIndex);
+  Rf_setAttrib(result, R_NamesSymbol, colNames->StrVector());
+  delete colNames;
+
+  UNPROTECT(1);
+
+  return result;
+}
+
+
+SEXP fstDirectIO(SEXP enable)
+{
+  bool oldSetting = directIO;
+
+  if (!Rf_isNull(enable)) directIO = *LOGICAL(enable) == 1;
+
+  return Rf_ScalarLogical(oldSetting);
+}
+
+
+SEXP fstHugePages(SEXP enable)
+{
+  bool oldSetting = HugePages();
+
+  if (!Rf_isNull(enable)) SetHugePages(*LOGICAL(enable) == 1);
+
+  return Rf_ScalarLogical(oldSetting);
+}
+
+
+SEXP fstReadPrefix(SEXP size)
+{
+  double oldSize = (double) ReadPrefixSize();
+
+  if (!Rf_isNull(size)) SetReadPrefixSize((unsigned long long) Rf_asReal(size));
+
+  return Rf_ScalarReal(oldSize);
+}
@@ -44,13 +44,139 @@
 
 
 // [[Rcpp::export]]
-SEXP fstStore(Rcpp::String fileName, SEXP table, SEXP compression);
+SEXP fstStore(Rcpp::String fileName, SEXP table, SEXP compression, SEXP streamLayout, SEXP chunkSize, SEXP blockSize, SEXP goal,
+  SEXP bloomBits, SEXP mantissaBits, SEXP fastDecode, SEXP compressLevels);
+
+// [[Rcpp::export]]
+SEXP fstStoreRaw(SEXP table, SEXP compression);
+
+// [[Rcpp::export]]
+SEXP fstAppend(Rcpp::String fileName, SEXP table, SEXP compression);
+
+// [[Rcpp::export]]
+SEXP fstCbind(Rcpp::String fileName, SEXP table, SEXP compression);
+
+// [[Rcpp::export]]
+SEXP fstReplaceColumn(Rcpp::String fileName, Rcpp::String colName, SEXP table, SEXP compression);
+
+// [[Rcpp::export]]
+SEXP fstDeleteColumn(Rcpp::String fileName, Rcpp::String colName);
+
+// [[Rcpp::export]]
+SEXP fstWriterOpen(Rcpp::String fileName, SEXP compression, SEXP sortKeys);
+
+// [[Rcpp::export]]
+SEXP fstWriterAppend(SEXP writer, SEXP table);
+
+// [[Rcpp::export]]
+SEXP fstWriterClose(SEXP writer);
+
+// [[Rcpp::export]]
+SEXP fstUpgrade(Rcpp::String fileName, Rcpp::String outputName, SEXP compression, SEXP batchRows);
 
 // [[Rcpp::export]]
 SEXP fstMeta(Rcpp::String fileName);
 
 // [[Rcpp::export]]
-SEXP fstRetrieve(Rcpp::String fileName, SEXP columnSelection, SEXP startRow, SEXP endRow);
+SEXP fstColumnStatistics(Rcpp::String fileName);
+
+// [[Rcpp::export]]
+SEXP fstColumnStorage(Rcpp::String fileName);
+
+// [[Rcpp::export]]
+SEXP fstRetrieve(Rcpp::String fileName, SEXP columnSelection, SEXP startRow, SEXP endRow, SEXP memoryMapped);
+
+// [[Rcpp::export]]
+SEXP fstRetrieveRaw(SEXP rawVec, SEXP columnSelection, SEXP startRow, SEXP endRow);
+
+// [[Rcpp::export]]
+SEXP fstIterOpen(Rcpp::String fileName, SEXP columnSelection);
+
+// [[Rcpp::export]]
+SEXP fstIterNext(SEXP iterator, SEXP batchRows);
+
+// [[Rcpp::export]]
+SEXP fstIterClose(SEXP iterator);
+
+// [[Rcpp::export]]
+SEXP fstHandleOpen(Rcpp::String fileName, SEXP memoryMapped, SEXP verify);
+
+// [[Rcpp::export]]
+SEXP fstHandleOpenRemote(SEXP reader, SEXP fileSize, SEXP cacheSize, SEXP verify);
+
+// [[Rcpp::export]]
+SEXP fstDatasetRead(SEXP fileNames, SEXP columnSelection);
+
+// [[Rcpp::export]]
+SEXP fstCopy(SEXP fileNames, SEXP outputName, SEXP columnSelection, SEXP recompressColumns, SEXP compression,
+  SEXP chunkRows);
+
+// [[Rcpp::export]]
+SEXP fstIndex(SEXP fileName, SEXP column, SEXP currentIndex, SEXP outputName, SEXP compression, SEXP batchRows);
+
+// [[Rcpp::export]]
+SEXP fstJoin(SEXP leftName, SEXP rightName, SEXP nrOfKeys, SEXP leftColumns, SEXP rightColumns, SEXP colNames,
+  SEXP allLeft, SEXP outputName, SEXP compression, SEXP batchRows);
+
+// [[Rcpp::export]]
+SEXP fstHandleRead(SEXP handle, SEXP columnSelection, SEXP startRow, SEXP endRow);
+
+// [[Rcpp::export]]
+SEXP fstHandleReadInto(SEXP handle, SEXP target, SEXP startRow);
+
+// [[Rcpp::export]]
+SEXP fstHandleReadLazy(SEXP handle, SEXP columnSelection, SEXP startRow, SEXP endRow);
+
+// Read rows firstRow until firstRow + length (0-based) of column colNr of an open handle
+SEXP ReadHandleColumn(SEXP handle, int colNr, unsigned long long firstRow, unsigned long long length);
+
+// [[Rcpp::export]]
+SEXP fstRetrieveRows(Rcpp::String fileName, SEXP columnSelection, SEXP rows, SEXP memoryMapped);
+
+// [[Rcpp::export]]
+SEXP fstHandleReadRows(SEXP handle, SEXP columnSelection, SEXP rows);
+
+// [[Rcpp::export]]
+SEXP fstHandleSample(SEXP handle, SEXP columnSelection, SEXP fraction, SEXP blocks, SEXP seed);
+
+// [[Rcpp::export]]
+SEXP fstHandleFilter(SEXP handle, SEXP rowFilter);
+
+// [[Rcpp::export]]
+SEXP fstHandleKeyLookup(SEXP handle, SEXP keyValues);
+
+// [[Rcpp::export]]
+SEXP fstHandleKeyLookupBatch(SEXP handle, SEXP keyValues);
+
+// [[Rcpp::export]]
+SEXP fstHandleAggregate(SEXP handle, SEXP columnSelection, SEXP functions, SEXP rowFilter, SEXP groupColumn);
+
+// [[Rcpp::export]]
+SEXP fstHandleDistinct(SEXP handle, SEXP column, SEXP maxValues);
+
+// [[Rcpp::export]]
+SEXP fstHandleVerify(SEXP handle, SEXP columnSelection);
+
+// [[Rcpp::export]]
+SEXP fstHandleClose(SEXP handle);
+
+// [[Rcpp::export]]
+SEXP fstBlockCache(SEXP budget, SEXP reset);
+
+// [[Rcpp::export]]
+SEXP fstSharedBlockCache(SEXP size);
+
+// [[Rcpp::export]]
+SEXP fstProfile(SEXP enable);
+
+// [[Rcpp::export]]
+SEXP fstDirectIO(SEXP enable);
+
+// [[Rcpp::export]]
+SEXP fstHugePages(SEXP enable);
+
+// [[Rcpp::export]]
+SEXP fstReadPrefix(SEXP size);
 
 
 #endif  // FASTSTORE_H
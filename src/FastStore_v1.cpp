@@ -36,6 +36,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <stdexcept>
 
 #include <Rcpp.h>
 
@@ -532,7 +533,7 @@ SEXP fstRead_v1(SEXP fileName, SEXP columnSelection, SEXP startRow, SEXP endRow)
     delete[] keyColumns;
     delete[] allBlockPos;
 
-    Rf_warning("This fst file was created with a beta version of the fst package. Please re-write the data as this format will not be supported in future releases.");
+    Rf_warning("This fst file was created with a beta version of the fst package. Please convert the file with fst.upgrade as this format will not be supported in future releases.");
 
     return List::create(
       _["keyNames"] = keyNames,
@@ -548,7 +549,7 @@ SEXP fstRead_v1(SEXP fileName, SEXP columnSelection, SEXP startRow, SEXP endRow)
   delete[] allBlockPos;
 
   // add deprecated warning
-  Rf_warning("This fst file was created with a beta version of the fst package. Please re-write the data as this format will not be supported in future releases.");
+  Rf_warning("This fst file was created with a beta version of the fst package. Please convert the file with fst.upgrade as this format will not be supported in future releases.");
 
   return List::create(
     _["keyNames"] = R_NilValue,
@@ -556,3 +557,160 @@ SEXP fstRead_v1(SEXP fileName, SEXP columnSelection, SEXP startRow, SEXP endRow)
     _["resTable"] = resTable,
     _["colInfo"] = colInfo);
 }
+
+
+void fstReadHeader_v1(ifstream &myfile, FstHeader_v1 &header)
+{
+  // Column count and key length
+  short int colSizes[2];
+  myfile.seekg(0);
+  myfile.read((char*) &colSizes, 2 * sizeof(short int));
+
+  if (!myfile || (colSizes[0] <= 0) | (colSizes[1] < 0))
+  {
+    throw(runtime_error("Unrecognised file type, are you sure this is a fst file?"));
+  }
+
+  int nrOfCols = colSizes[0];
+  int keyLength = colSizes[1] & 32767;
+
+  header.nrOfCols = nrOfCols;
+  header.keyColumns.resize(keyLength);
+  header.colTypes.resize(nrOfCols);
+
+  vector<unsigned long long> allBlockPos(nrOfCols + 1);
+
+  myfile.read((char*) header.keyColumns.data(), keyLength * sizeof(short int));  // may be of length zero
+  myfile.read((char*) header.colTypes.data(), nrOfCols * sizeof(short int));
+  myfile.read((char*) allBlockPos.data(), (nrOfCols + 1) * sizeof(unsigned long long));
+
+  if (!myfile)
+  {
+    throw(runtime_error("Error reading file header, are you sure this is a fst file?"));
+  }
+
+  for (short int keyCol : header.keyColumns)
+  {
+    if ((keyCol < 0) | (keyCol >= nrOfCols))
+    {
+      throw(runtime_error("Error reading file header, are you sure this is a fst file?"));
+    }
+  }
+
+  for (short int colType : header.colTypes)
+  {
+    if ((colType < 1) | (colType > 5))
+    {
+      throw(runtime_error("Error reading file header, are you sure this is a fst file?"));
+    }
+  }
+
+  // Block positions should be monotonically increasing
+  for (int colCount = 2; colCount <= nrOfCols; ++colCount)
+  {
+    if (allBlockPos[colCount] < allBlockPos[colCount - 1])
+    {
+      throw(runtime_error("Error reading file header (blockPos), are you sure this is a fst file?"));
+    }
+  }
+
+  header.nrOfRows = (int) allBlockPos[0];
+
+  if (header.nrOfRows <= 0)
+  {
+    throw(runtime_error("Error reading file header (blockPos), are you sure this is a fst file?"));
+  }
+
+  header.colPos.assign(allBlockPos.begin() + 1, allBlockPos.end());
+}
+
+
+SEXP fstReadColNames_v1(ifstream &myfile, FstHeader_v1 &header)
+{
+  int nrOfCols = header.nrOfCols;
+  int keyLength = (int) header.keyColumns.size();
+
+  SEXP colNames;
+  PROTECT(colNames = Rf_allocVector(STRSXP, nrOfCols));
+
+  unsigned long long offset = (nrOfCols + 1) * sizeof(unsigned long long) + (nrOfCols + keyLength + 2) * sizeof(short int);
+  fdsReadCharVec_v1(myfile, colNames, offset, 0, (unsigned int) nrOfCols, (unsigned int) nrOfCols);
+
+  UNPROTECT(1);
+
+  return colNames;
+}
+
+
+SEXP fstReadRows_v1(ifstream &myfile, FstHeader_v1 &header, SEXP colNames, int firstRow, int length)
+{
+  int nrOfCols = header.nrOfCols;
+  int keyLength = (int) header.keyColumns.size();
+
+  SEXP table;
+  PROTECT(table = Rf_allocVector(VECSXP, nrOfCols));
+
+  for (int colNr = 0; colNr < nrOfCols; ++colNr)
+  {
+    unsigned long long pos = header.colPos[colNr];
+    short int colType = header.colTypes[colNr];
+
+    SEXP colVec;
+    myfile.clear();  // the column readers don't reset the stream state
+
+    // Character vector
+    if (colType == 1)
+    {
+      PROTECT(colVec = Rf_allocVector(STRSXP, length));
+      fdsReadCharVec_v1(myfile, colVec, pos, firstRow, length, header.nrOfRows);
+    }
+    else if (colType == 3)  // real vector
+    {
+      PROTECT(colVec = Rf_allocVector(REALSXP, length));
+      fdsReadRealVec_v3(myfile, colVec, pos, firstRow, length, header.nrOfRows);
+    }
+    else if (colType == 4)  // logical vector
+    {
+      PROTECT(colVec = Rf_allocVector(LGLSXP, length));
+      fdsReadLogicalVec_v4(myfile, colVec, pos, firstRow, length, header.nrOfRows);
+    }
+    else  // integer or factor vector
+    {
+      PROTECT(colVec = Rf_allocVector(INTSXP, length));
+
+      if (colType == 2)
+      {
+        fdsReadIntVec_v2(myfile, colVec, pos, firstRow, length, header.nrOfRows);
+      }
+      else
+      {
+        fdsReadFactorVec_v5(myfile, colVec, pos, firstRow, length, header.nrOfRows);
+        UNPROTECT(1);  // level string was also generated
+      }
+    }
+
+    SET_VECTOR_ELT(table, colNr, colVec);
+    UNPROTECT(1);
+  }
+
+  Rf_setAttrib(table, R_NamesSymbol, colNames);
+
+  // Rows are read in the sort order of the key columns
+  if (keyLength > 0)
+  {
+    SEXP keyNames;
+    PROTECT(keyNames = Rf_allocVector(STRSXP, keyLength));
+
+    for (int keyNr = 0; keyNr < keyLength; ++keyNr)
+    {
+      SET_STRING_ELT(keyNames, keyNr, STRING_ELT(colNames, header.keyColumns[keyNr]));
+    }
+
+    Rf_setAttrib(table, Rf_mkString("sorted"), keyNames);
+    UNPROTECT(1);
+  }
+
+  UNPROTECT(1);
+
+  return table;
+}
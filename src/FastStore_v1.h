@@ -38,13 +38,35 @@
 
 #include <iostream>
 #include <fstream>
+#include <vector>
 
 #include <Rcpp.h>
 
 
+// Table layout of a fst file in the v0.7.2 format
+struct FstHeader_v1
+{
+  int nrOfCols;
+  int nrOfRows;
+  std::vector<short int> keyColumns;
+  std::vector<short int> colTypes;        // 1: character, 2: integer, 3: double, 4: logical, 5: factor
+  std::vector<unsigned long long> colPos;  // file position of each column
+};
+
+
 Rcpp::List fstMeta_v1(Rcpp::String fileName);
 
 SEXP fstRead_v1(SEXP fileName, SEXP columnSelection, SEXP startRow, SEXP endRow);
 
+// Read and validate the table layout of an opened v0.7.2 file, throws a runtime_error for a damaged header
+void fstReadHeader_v1(std::ifstream &myfile, FstHeader_v1 &header);
+
+// Read the column names of an opened v0.7.2 file (unprotected)
+SEXP fstReadColNames_v1(std::ifstream &myfile, FstHeader_v1 &header);
+
+// Read rows firstRow until firstRow + length (0-based) of all columns of an opened v0.7.2 file into a list with
+// the column names and, for a sorted table, the key column names in attribute 'sorted' (unprotected)
+SEXP fstReadRows_v1(std::ifstream &myfile, FstHeader_v1 &header, SEXP colNames, int firstRow, int length);
+
 
 #endif  // FASTSTORE_V1_H
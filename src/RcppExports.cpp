@@ -6,15 +6,137 @@
 using namespace Rcpp;
 
 // fstStore
-SEXP fstStore(Rcpp::String fileName, SEXP table, SEXP compression);
-RcppExport SEXP fst_fstStore(SEXP fileNameSEXP, SEXP tableSEXP, SEXP compressionSEXP) {
+SEXP fstStore(Rcpp::String fileName, SEXP table, SEXP compression, SEXP streamLayout, SEXP chunkSize, SEXP blockSize, SEXP goal, SEXP bloomBits, SEXP mantissaBits, SEXP fastDecode, SEXP compressLevels);
+RcppExport SEXP fst_fstStore(SEXP fileNameSEXP, SEXP tableSEXP, SEXP compressionSEXP, SEXP streamLayoutSEXP, SEXP chunkSizeSEXP, SEXP blockSizeSEXP, SEXP goalSEXP, SEXP bloomBitsSEXP, SEXP mantissaBitsSEXP, SEXP fastDecodeSEXP, SEXP compressLevelsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< Rcpp::String >::type fileName(fileNameSEXP);
     Rcpp::traits::input_parameter< SEXP >::type table(tableSEXP);
     Rcpp::traits::input_parameter< SEXP >::type compression(compressionSEXP);
-    rcpp_result_gen = Rcpp::wrap(fstStore(fileName, table, compression));
+    Rcpp::traits::input_parameter< SEXP >::type streamLayout(streamLayoutSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type chunkSize(chunkSizeSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type blockSize(blockSizeSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type goal(goalSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type bloomBits(bloomBitsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type mantissaBits(mantissaBitsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type fastDecode(fastDecodeSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type compressLevels(compressLevelsSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstStore(fileName, table, compression, streamLayout, chunkSize, blockSize, goal, bloomBits, mantissaBits, fastDecode, compressLevels));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstStoreRaw
+SEXP fstStoreRaw(SEXP table, SEXP compression);
+RcppExport SEXP fst_fstStoreRaw(SEXP tableSEXP, SEXP compressionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type table(tableSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type compression(compressionSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstStoreRaw(table, compression));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstAppend
+SEXP fstAppend(Rcpp::String fileName, SEXP table, SEXP compression);
+RcppExport SEXP fst_fstAppend(SEXP fileNameSEXP, SEXP tableSEXP, SEXP compressionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::String >::type fileName(fileNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type table(tableSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type compression(compressionSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstAppend(fileName, table, compression));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstCbind
+SEXP fstCbind(Rcpp::String fileName, SEXP table, SEXP compression);
+RcppExport SEXP fst_fstCbind(SEXP fileNameSEXP, SEXP tableSEXP, SEXP compressionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::String >::type fileName(fileNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type table(tableSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type compression(compressionSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstCbind(fileName, table, compression));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstReplaceColumn
+SEXP fstReplaceColumn(Rcpp::String fileName, Rcpp::String colName, SEXP table, SEXP compression);
+RcppExport SEXP fst_fstReplaceColumn(SEXP fileNameSEXP, SEXP colNameSEXP, SEXP tableSEXP, SEXP compressionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::String >::type fileName(fileNameSEXP);
+    Rcpp::traits::input_parameter< Rcpp::String >::type colName(colNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type table(tableSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type compression(compressionSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstReplaceColumn(fileName, colName, table, compression));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstDeleteColumn
+SEXP fstDeleteColumn(Rcpp::String fileName, Rcpp::String colName);
+RcppExport SEXP fst_fstDeleteColumn(SEXP fileNameSEXP, SEXP colNameSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::String >::type fileName(fileNameSEXP);
+    Rcpp::traits::input_parameter< Rcpp::String >::type colName(colNameSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstDeleteColumn(fileName, colName));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstWriterOpen
+SEXP fstWriterOpen(Rcpp::String fileName, SEXP compression, SEXP sortKeys);
+RcppExport SEXP fst_fstWriterOpen(SEXP fileNameSEXP, SEXP compressionSEXP, SEXP sortKeysSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::String >::type fileName(fileNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type compression(compressionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type sortKeys(sortKeysSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstWriterOpen(fileName, compression, sortKeys));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstWriterAppend
+SEXP fstWriterAppend(SEXP writer, SEXP table);
+RcppExport SEXP fst_fstWriterAppend(SEXP writerSEXP, SEXP tableSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type writer(writerSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type table(tableSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstWriterAppend(writer, table));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstWriterClose
+SEXP fstWriterClose(SEXP writer);
+RcppExport SEXP fst_fstWriterClose(SEXP writerSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type writer(writerSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstWriterClose(writer));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstUpgrade
+SEXP fstUpgrade(Rcpp::String fileName, Rcpp::String outputName, SEXP compression, SEXP batchRows);
+RcppExport SEXP fst_fstUpgrade(SEXP fileNameSEXP, SEXP outputNameSEXP, SEXP compressionSEXP, SEXP batchRowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::String >::type fileName(fileNameSEXP);
+    Rcpp::traits::input_parameter< Rcpp::String >::type outputName(outputNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type compression(compressionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type batchRows(batchRowsSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstUpgrade(fileName, outputName, compression, batchRows));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -29,9 +151,31 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// fstColumnStatistics
+SEXP fstColumnStatistics(Rcpp::String fileName);
+RcppExport SEXP fst_fstColumnStatistics(SEXP fileNameSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::String >::type fileName(fileNameSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstColumnStatistics(fileName));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstColumnStorage
+SEXP fstColumnStorage(Rcpp::String fileName);
+RcppExport SEXP fst_fstColumnStorage(SEXP fileNameSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::String >::type fileName(fileNameSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstColumnStorage(fileName));
+    return rcpp_result_gen;
+END_RCPP
+}
 // fstRetrieve
-SEXP fstRetrieve(Rcpp::String fileName, SEXP columnSelection, SEXP startRow, SEXP endRow);
-RcppExport SEXP fst_fstRetrieve(SEXP fileNameSEXP, SEXP columnSelectionSEXP, SEXP startRowSEXP, SEXP endRowSEXP) {
+SEXP fstRetrieve(Rcpp::String fileName, SEXP columnSelection, SEXP startRow, SEXP endRow, SEXP memoryMapped);
+RcppExport SEXP fst_fstRetrieve(SEXP fileNameSEXP, SEXP columnSelectionSEXP, SEXP startRowSEXP, SEXP endRowSEXP, SEXP memoryMappedSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -39,7 +183,385 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< SEXP >::type columnSelection(columnSelectionSEXP);
     Rcpp::traits::input_parameter< SEXP >::type startRow(startRowSEXP);
     Rcpp::traits::input_parameter< SEXP >::type endRow(endRowSEXP);
-    rcpp_result_gen = Rcpp::wrap(fstRetrieve(fileName, columnSelection, startRow, endRow));
+    Rcpp::traits::input_parameter< SEXP >::type memoryMapped(memoryMappedSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstRetrieve(fileName, columnSelection, startRow, endRow, memoryMapped));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstRetrieveRaw
+SEXP fstRetrieveRaw(SEXP rawVec, SEXP columnSelection, SEXP startRow, SEXP endRow);
+RcppExport SEXP fst_fstRetrieveRaw(SEXP rawVecSEXP, SEXP columnSelectionSEXP, SEXP startRowSEXP, SEXP endRowSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type rawVec(rawVecSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type columnSelection(columnSelectionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type startRow(startRowSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type endRow(endRowSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstRetrieveRaw(rawVec, columnSelection, startRow, endRow));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstIterOpen
+SEXP fstIterOpen(Rcpp::String fileName, SEXP columnSelection);
+RcppExport SEXP fst_fstIterOpen(SEXP fileNameSEXP, SEXP columnSelectionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::String >::type fileName(fileNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type columnSelection(columnSelectionSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstIterOpen(fileName, columnSelection));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstIterNext
+SEXP fstIterNext(SEXP iterator, SEXP batchRows);
+RcppExport SEXP fst_fstIterNext(SEXP iteratorSEXP, SEXP batchRowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type iterator(iteratorSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type batchRows(batchRowsSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstIterNext(iterator, batchRows));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstIterClose
+SEXP fstIterClose(SEXP iterator);
+RcppExport SEXP fst_fstIterClose(SEXP iteratorSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type iterator(iteratorSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstIterClose(iterator));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleOpen
+SEXP fstHandleOpen(Rcpp::String fileName, SEXP memoryMapped, SEXP verify);
+RcppExport SEXP fst_fstHandleOpen(SEXP fileNameSEXP, SEXP memoryMappedSEXP, SEXP verifySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::String >::type fileName(fileNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type memoryMapped(memoryMappedSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type verify(verifySEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleOpen(fileName, memoryMapped, verify));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleOpenRemote
+SEXP fstHandleOpenRemote(SEXP reader, SEXP fileSize, SEXP cacheSize, SEXP verify);
+RcppExport SEXP fst_fstHandleOpenRemote(SEXP readerSEXP, SEXP fileSizeSEXP, SEXP cacheSizeSEXP, SEXP verifySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type reader(readerSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type fileSize(fileSizeSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type cacheSize(cacheSizeSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type verify(verifySEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleOpenRemote(reader, fileSize, cacheSize, verify));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstDatasetRead
+SEXP fstDatasetRead(SEXP fileNames, SEXP columnSelection);
+RcppExport SEXP fst_fstDatasetRead(SEXP fileNamesSEXP, SEXP columnSelectionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type fileNames(fileNamesSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type columnSelection(columnSelectionSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstDatasetRead(fileNames, columnSelection));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstCopy
+SEXP fstCopy(SEXP fileNames, SEXP outputName, SEXP columnSelection, SEXP recompressColumns, SEXP compression, SEXP chunkRows);
+RcppExport SEXP fst_fstCopy(SEXP fileNamesSEXP, SEXP outputNameSEXP, SEXP columnSelectionSEXP, SEXP recompressColumnsSEXP, SEXP compressionSEXP, SEXP chunkRowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type fileNames(fileNamesSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type outputName(outputNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type columnSelection(columnSelectionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type recompressColumns(recompressColumnsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type compression(compressionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type chunkRows(chunkRowsSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstCopy(fileNames, outputName, columnSelection, recompressColumns, compression, chunkRows));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstIndex
+SEXP fstIndex(SEXP fileName, SEXP column, SEXP currentIndex, SEXP outputName, SEXP compression, SEXP batchRows);
+RcppExport SEXP fst_fstIndex(SEXP fileNameSEXP, SEXP columnSEXP, SEXP currentIndexSEXP, SEXP outputNameSEXP, SEXP compressionSEXP, SEXP batchRowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type fileName(fileNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type column(columnSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type currentIndex(currentIndexSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type outputName(outputNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type compression(compressionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type batchRows(batchRowsSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstIndex(fileName, column, currentIndex, outputName, compression, batchRows));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstJoin
+SEXP fstJoin(SEXP leftName, SEXP rightName, SEXP nrOfKeys, SEXP leftColumns, SEXP rightColumns, SEXP colNames, SEXP allLeft, SEXP outputName, SEXP compression, SEXP batchRows);
+RcppExport SEXP fst_fstJoin(SEXP leftNameSEXP, SEXP rightNameSEXP, SEXP nrOfKeysSEXP, SEXP leftColumnsSEXP, SEXP rightColumnsSEXP, SEXP colNamesSEXP, SEXP allLeftSEXP, SEXP outputNameSEXP, SEXP compressionSEXP, SEXP batchRowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type leftName(leftNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type rightName(rightNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nrOfKeys(nrOfKeysSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type leftColumns(leftColumnsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type rightColumns(rightColumnsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type colNames(colNamesSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type allLeft(allLeftSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type outputName(outputNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type compression(compressionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type batchRows(batchRowsSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstJoin(leftName, rightName, nrOfKeys, leftColumns, rightColumns, colNames, allLeft, outputName, compression, batchRows));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleRead
+SEXP fstHandleRead(SEXP handle, SEXP columnSelection, SEXP startRow, SEXP endRow);
+RcppExport SEXP fst_fstHandleRead(SEXP handleSEXP, SEXP columnSelectionSEXP, SEXP startRowSEXP, SEXP endRowSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type columnSelection(columnSelectionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type startRow(startRowSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type endRow(endRowSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleRead(handle, columnSelection, startRow, endRow));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleReadInto
+SEXP fstHandleReadInto(SEXP handle, SEXP target, SEXP startRow);
+RcppExport SEXP fst_fstHandleReadInto(SEXP handleSEXP, SEXP targetSEXP, SEXP startRowSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type target(targetSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type startRow(startRowSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleReadInto(handle, target, startRow));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleReadLazy
+SEXP fstHandleReadLazy(SEXP handle, SEXP columnSelection, SEXP startRow, SEXP endRow);
+RcppExport SEXP fst_fstHandleReadLazy(SEXP handleSEXP, SEXP columnSelectionSEXP, SEXP startRowSEXP, SEXP endRowSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type columnSelection(columnSelectionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type startRow(startRowSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type endRow(endRowSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleReadLazy(handle, columnSelection, startRow, endRow));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstRetrieveRows
+SEXP fstRetrieveRows(Rcpp::String fileName, SEXP columnSelection, SEXP rows, SEXP memoryMapped);
+RcppExport SEXP fst_fstRetrieveRows(SEXP fileNameSEXP, SEXP columnSelectionSEXP, SEXP rowsSEXP, SEXP memoryMappedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::String >::type fileName(fileNameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type columnSelection(columnSelectionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type rows(rowsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type memoryMapped(memoryMappedSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstRetrieveRows(fileName, columnSelection, rows, memoryMapped));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleReadRows
+SEXP fstHandleReadRows(SEXP handle, SEXP columnSelection, SEXP rows);
+RcppExport SEXP fst_fstHandleReadRows(SEXP handleSEXP, SEXP columnSelectionSEXP, SEXP rowsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type columnSelection(columnSelectionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type rows(rowsSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleReadRows(handle, columnSelection, rows));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleSample
+SEXP fstHandleSample(SEXP handle, SEXP columnSelection, SEXP fraction, SEXP blocks, SEXP seed);
+RcppExport SEXP fst_fstHandleSample(SEXP handleSEXP, SEXP columnSelectionSEXP, SEXP fractionSEXP, SEXP blocksSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type columnSelection(columnSelectionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type fraction(fractionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type blocks(blocksSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleSample(handle, columnSelection, fraction, blocks, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleFilter
+SEXP fstHandleFilter(SEXP handle, SEXP rowFilter);
+RcppExport SEXP fst_fstHandleFilter(SEXP handleSEXP, SEXP rowFilterSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type rowFilter(rowFilterSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleFilter(handle, rowFilter));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleKeyLookup
+SEXP fstHandleKeyLookup(SEXP handle, SEXP keyValues);
+RcppExport SEXP fst_fstHandleKeyLookup(SEXP handleSEXP, SEXP keyValuesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type keyValues(keyValuesSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleKeyLookup(handle, keyValues));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleKeyLookupBatch
+SEXP fstHandleKeyLookupBatch(SEXP handle, SEXP keyValues);
+RcppExport SEXP fst_fstHandleKeyLookupBatch(SEXP handleSEXP, SEXP keyValuesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type keyValues(keyValuesSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleKeyLookupBatch(handle, keyValues));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleAggregate
+SEXP fstHandleAggregate(SEXP handle, SEXP columnSelection, SEXP functions, SEXP rowFilter, SEXP groupColumn);
+RcppExport SEXP fst_fstHandleAggregate(SEXP handleSEXP, SEXP columnSelectionSEXP, SEXP functionsSEXP, SEXP rowFilterSEXP, SEXP groupColumnSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type columnSelection(columnSelectionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type functions(functionsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type rowFilter(rowFilterSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type groupColumn(groupColumnSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleAggregate(handle, columnSelection, functions, rowFilter, groupColumn));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleDistinct
+SEXP fstHandleDistinct(SEXP handle, SEXP column, SEXP maxValues);
+RcppExport SEXP fst_fstHandleDistinct(SEXP handleSEXP, SEXP columnSEXP, SEXP maxValuesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type column(columnSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type maxValues(maxValuesSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleDistinct(handle, column, maxValues));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleVerify
+SEXP fstHandleVerify(SEXP handle, SEXP columnSelection);
+RcppExport SEXP fst_fstHandleVerify(SEXP handleSEXP, SEXP columnSelectionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type columnSelection(columnSelectionSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleVerify(handle, columnSelection));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHandleClose
+SEXP fstHandleClose(SEXP handle);
+RcppExport SEXP fst_fstHandleClose(SEXP handleSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type handle(handleSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHandleClose(handle));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstBlockCache
+SEXP fstBlockCache(SEXP budget, SEXP reset);
+RcppExport SEXP fst_fstBlockCache(SEXP budgetSEXP, SEXP resetSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type budget(budgetSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type reset(resetSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstBlockCache(budget, reset));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstSharedBlockCache
+SEXP fstSharedBlockCache(SEXP size);
+RcppExport SEXP fst_fstSharedBlockCache(SEXP sizeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type size(sizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstSharedBlockCache(size));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstProfile
+SEXP fstProfile(SEXP enable);
+RcppExport SEXP fst_fstProfile(SEXP enableSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type enable(enableSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstProfile(enable));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstDirectIO
+SEXP fstDirectIO(SEXP enable);
+RcppExport SEXP fst_fstDirectIO(SEXP enableSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type enable(enableSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstDirectIO(enable));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstHugePages
+SEXP fstHugePages(SEXP enable);
+RcppExport SEXP fst_fstHugePages(SEXP enableSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type enable(enableSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstHugePages(enable));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fstReadPrefix
+SEXP fstReadPrefix(SEXP size);
+RcppExport SEXP fst_fstReadPrefix(SEXP sizeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type size(sizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(fstReadPrefix(size));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -53,6 +575,17 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// setDTthreads
+SEXP setDTthreads(SEXP threads);
+RcppExport SEXP fst_setDTthreads(SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(setDTthreads(threads));
+    return rcpp_result_gen;
+END_RCPP
+}
 // hasOpenMP
 SEXP hasOpenMP();
 RcppExport SEXP fst_hasOpenMP() {
@@ -63,3 +596,14 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// setLazyStrings
+SEXP setLazyStrings(SEXP enable);
+RcppExport SEXP fst_setLazyStrings(SEXP enableSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type enable(enableSEXP);
+    rcpp_result_gen = Rcpp::wrap(setLazyStrings(enable));
+    return rcpp_result_gen;
+END_RCPP
+}
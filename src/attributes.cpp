@@ -33,72 +33,297 @@
 */
 
 #include "attributes.h"
-#include <fstream>
+
+#include <cstring>
+#include <string>
+#include <stdexcept>
 
 using namespace std;
 using namespace Rcpp;
 
 
-// In general, attributes contain a small amount of data. Therefore, we can use R's internal serialization mechanism
-// to stream the attributes (we can optimize known types in a future release if speed is too low).
-inline unsigned int SerializeObjectAttributes(ofstream &myfile, RObject rObject, Function serializer)
+// Encoded attributes of a single column
+//
+//  NR OF BYTES            | TYPE               | VARIABLE NAME
+//
+//  4                      | unsigned int       | nrOfAttributes
+//
+// Followed by each attribute:
+//
+//  4                      | unsigned int       | nameLength
+//  nameLength             | char               | name
+//  4                      | unsigned int       | attributeType
+//  4                      | unsigned int       | length (elements, or bytes for ATTR_SERIALIZED)
+//  ?                      | ?                  | attribute data
+//
+// Character elements are stored as their size in bytes (-1 for NA) followed by their UTF-8 bytes, integer and
+// logical elements as 4-byte integers and double elements as 8-byte doubles.
+
+#define ATTR_CHARACTER  1
+#define ATTR_INTEGER    2
+#define ATTR_DOUBLE     3
+#define ATTR_LOGICAL    4
+#define ATTR_SERIALIZED 5  // attribute serialized with R's serialize
+
+
+inline void AppendBytes(vector<char> &attributeData, const void* bytes, unsigned int size)
+{
+  const char* p = (const char*) bytes;
+  attributeData.insert(attributeData.end(), p, p + size);
+}
+
+
+inline void AppendInt(vector<char> &attributeData, int value)
 {
-  vector<string> attrNames = rObject.attributeNames();
-  unsigned int nrOfAttributes = attrNames.size();
+  AppendBytes(attributeData, &value, 4);
+}
+
+
+// Attributes that are restored from the column type or depend on the number of rows
+inline bool IsColumnTypeAttribute(SEXP tag, SEXP value, FstColumnType colType)
+{
+  if (tag == R_NamesSymbol || tag == R_DimSymbol || tag == R_DimNamesSymbol) return true;
 
-  if (nrOfAttributes == 0) return 0;
+  if (colType == FstColumnType::FACTOR && tag == R_LevelsSymbol) return true;
 
-  // Create a list with attribute data for serialization
-  List outList(nrOfAttributes + 1);
+  if (tag != R_ClassSymbol || TYPEOF(value) != STRSXP) return false;
 
-  int listIndex = 0;
-  for (std::vector<string>::iterator it = attrNames.begin() ; it != attrNames.end(); ++it)
+  int nrOfClasses = LENGTH(value);
+
+  switch (colType)
   {
-    SEXP attribute = rObject.attr(*it);
-    outList[listIndex++] = attribute;
-  }
+    case FstColumnType::FACTOR:
+      return nrOfClasses == 1 && strcmp(CHAR(STRING_ELT(value, 0)), "factor") == 0;
 
-  outList[nrOfAttributes] = attrNames;
+    case FstColumnType::INT_64:
+      return nrOfClasses == 1 && strcmp(CHAR(STRING_ELT(value, 0)), "integer64") == 0;
 
-  RawVector serializedAttributes = serializer(outList, R_NilValue);
+    case FstColumnType::DATE_DAYS:
+      return nrOfClasses == 1 && strcmp(CHAR(STRING_ELT(value, 0)), "Date") == 0;
 
-  unsigned int dataLength =  LENGTH(serializedAttributes);
-  myfile.write((char*) RAW(serializedAttributes), dataLength);
+    case FstColumnType::TIMESTAMP_SECONDS:
+      return nrOfClasses == 2 && strcmp(CHAR(STRING_ELT(value, 0)), "POSIXct") == 0 &&
+        strcmp(CHAR(STRING_ELT(value, 1)), "POSIXt") == 0;
 
-  return dataLength;
+    default:
+      return false;
+  }
 }
 
 
-inline SEXP UnserializeRaw(unsigned char* rawData, unsigned int rawLength, Function unserializer)
+void EncodeColumnAttributes(SEXP colVec, FstColumnType colType, vector<char> &attributeData)
 {
-  RawVector rawVec(rawLength);
-  memcpy(RAW(rawVec), rawData, rawLength);
-  return unserializer(rawVec);
+  attributeData.clear();
+  AppendInt(attributeData, 0);  // number of attributes, set at the end
+
+  int nrOfAttributes = 0;
+
+  for (SEXP attr = ATTRIB(colVec); attr != R_NilValue; attr = CDR(attr))
+  {
+    SEXP tag = TAG(attr);
+    SEXP value = CAR(attr);
+
+    if (IsColumnTypeAttribute(tag, value, colType)) continue;
+
+    const char* name = CHAR(PRINTNAME(tag));
+    int nameLength = (int) strlen(name);
+    AppendInt(attributeData, nameLength);
+    AppendBytes(attributeData, name, nameLength);
+
+    int length = LENGTH(value);
+    int attrType = ATTR_SERIALIZED;
+
+    // Attribute vectors with attributes of their own are serialized
+    if (ATTRIB(value) == R_NilValue)
+    {
+      switch (TYPEOF(value))
+      {
+        case STRSXP:
+          attrType = ATTR_CHARACTER;
+          break;
+
+        case INTSXP:
+          attrType = ATTR_INTEGER;
+          break;
+
+        case REALSXP:
+          attrType = ATTR_DOUBLE;
+          break;
+
+        case LGLSXP:
+          attrType = ATTR_LOGICAL;
+          break;
+      }
+    }
+
+    AppendInt(attributeData, attrType);
+
+    switch (attrType)
+    {
+      case ATTR_CHARACTER:
+      {
+        AppendInt(attributeData, length);
+
+        for (int elementNr = 0; elementNr < length; ++elementNr)
+        {
+          SEXP strElem = STRING_ELT(value, elementNr);
+
+          if (strElem == NA_STRING)
+          {
+            AppendInt(attributeData, -1);
+            continue;
+          }
+
+          const char* str = Rf_translateCharUTF8(strElem);
+          int strLength = (int) strlen(str);
+          AppendInt(attributeData, strLength);
+          AppendBytes(attributeData, str, strLength);
+        }
+
+        break;
+      }
+
+      case ATTR_INTEGER:
+        AppendInt(attributeData, length);
+        AppendBytes(attributeData, INTEGER(value), 4 * length);
+        break;
+
+      case ATTR_DOUBLE:
+        AppendInt(attributeData, length);
+        AppendBytes(attributeData, REAL(value), 8 * length);
+        break;
+
+      case ATTR_LOGICAL:
+        AppendInt(attributeData, length);
+        AppendBytes(attributeData, LOGICAL(value), 4 * length);
+        break;
+
+      default:
+      {
+        Function serializer = Environment::base_env()["serialize"];
+        RawVector serializedAttribute = serializer(value, R_NilValue);
+
+        int dataLength = LENGTH(serializedAttribute);
+        AppendInt(attributeData, dataLength);
+        AppendBytes(attributeData, RAW(serializedAttribute), dataLength);
+      }
+    }
+
+    ++nrOfAttributes;
+  }
+
+  if (nrOfAttributes == 0)
+  {
+    attributeData.clear();
+    return;
+  }
+
+  memcpy(attributeData.data(), &nrOfAttributes, 4);
 }
 
 
-SEXP UnserializeObjectAttributes(SEXP rObject, RawVector rawVector, Function unserializer)
+// Sequential reader of encoded attributes
+class AttributeReader
 {
-  SEXP attributes = UnserializeRaw(RAW(rawVector), LENGTH(rawVector), unserializer);
+  const char* attributeData;
+  unsigned int size;
+  unsigned int pos;
+
+public:
+  AttributeReader(const char* attributeData, unsigned int size) : attributeData(attributeData), size(size), pos(0) {}
+
+  const char* Read(unsigned long long nrOfBytes)
+  {
+    if (nrOfBytes > size - pos)
+    {
+      throw(runtime_error("Error reading column attributes, your fst file is incomplete or damaged."));
+    }
+
+    const char* bytes = &attributeData[pos];
+    pos += (unsigned int) nrOfBytes;
 
-  int nrOfAttributes = LENGTH(attributes) - 1;
-  SEXP attrNames = VECTOR_ELT(attributes, nrOfAttributes);
+    return bytes;
+  }
 
-  for (int itemNr = 0; itemNr != nrOfAttributes; ++itemNr)
+  int ReadInt()
   {
-    Rf_setAttrib(rObject, Rf_mkString(CHAR(STRING_ELT(attrNames, itemNr))), VECTOR_ELT(attributes, itemNr));
+    int value;
+    memcpy(&value, Read(4), 4);
+    return value;
   }
+};
 
-  SEXP a = STRING_ELT(attrNames, 0);
-  SEXP b = STRING_ELT(attrNames, 1);
 
-  return List::create(
-    _["attributes"] = attributes,
-    _["attrNames"] = attrNames,
-    _["nrOfAttributes"] = nrOfAttributes,
-    _["rObject"] = rObject,
-    _["a"] = a,
-    _["b"] = b);
-}
+void DecodeColumnAttributes(SEXP colVec, const char* attributeData, unsigned int size)
+{
+  AttributeReader reader(attributeData, size);
+  int nrOfAttributes = reader.ReadInt();
+
+  for (int attrNr = 0; attrNr < nrOfAttributes; ++attrNr)
+  {
+    int nameLength = reader.ReadInt();
+    string name(reader.Read((unsigned int) nameLength), nameLength);
+
+    int attrType = reader.ReadInt();
+    int length = reader.ReadInt();
+
+    if (length < 0)
+    {
+      throw(runtime_error("Error reading column attributes, your fst file is incomplete or damaged."));
+    }
+
+    SEXP value;
+
+    switch (attrType)
+    {
+      case ATTR_CHARACTER:
+      {
+        value = PROTECT(Rf_allocVector(STRSXP, length));
+
+        for (int elementNr = 0; elementNr < length; ++elementNr)
+        {
+          int strLength = reader.ReadInt();
 
+          if (strLength < 0)
+          {
+            SET_STRING_ELT(value, elementNr, NA_STRING);
+            continue;
+          }
 
+          SET_STRING_ELT(value, elementNr, Rf_mkCharLenCE(reader.Read(strLength), strLength, CE_UTF8));
+        }
+
+        break;
+      }
+
+      case ATTR_INTEGER:
+      case ATTR_LOGICAL:
+      {
+        const char* values = reader.Read(4ULL * length);
+        value = PROTECT(Rf_allocVector(attrType == ATTR_INTEGER ? INTSXP : LGLSXP, length));
+        memcpy(attrType == ATTR_INTEGER ? INTEGER(value) : LOGICAL(value), values, 4ULL * length);
+        break;
+      }
+
+      case ATTR_DOUBLE:
+      {
+        const char* values = reader.Read(8ULL * length);
+        value = PROTECT(Rf_allocVector(REALSXP, length));
+        memcpy(REAL(value), values, 8ULL * length);
+        break;
+      }
+
+      default:
+      {
+        RawVector rawVec(length);
+        memcpy(RAW(rawVec), reader.Read(length), length);
+
+        Function unserializer = Environment::base_env()["unserialize"];
+        value = PROTECT(unserializer(rawVec));
+      }
+    }
+
+    Rf_setAttrib(colVec, Rf_install(name.c_str()), value);
+    UNPROTECT(1);
+  }
+}
@@ -36,12 +36,24 @@
 #ifndef ATTRIBUTES_H
 #define ATTRIBUTES_H
 
+#include <vector>
+
 #include <Rcpp.h>  // Rcpp header
 
-// Logical vectors are always compressed to fill all available bits (factor 16 compression).
-// On top of that, we can compress the resulting bytes with a custom compressor.
-SEXP SerializeObjectAttributes(Rcpp::RObject rObject, Rcpp::Function serializer);
+#include <ifsttable.h>
+
+
+/**
+ Encode the attributes of a column vector in attributeData. Attributes that are restored from the column type
+ (factor levels and default classes) are skipped, as are attributes with a length that depends on the number of
+ rows. Character, integer, double and logical attribute vectors are encoded natively, other attributes with R's
+ serialize.
+ */
+void EncodeColumnAttributes(SEXP colVec, FstColumnType colType, std::vector<char> &attributeData);
 
-SEXP UnserializeObjectAttributes(Rcpp::RawVector rawVector, Rcpp::Function unserializer);
+/**
+ Set the attributes encoded with EncodeColumnAttributes on a column vector.
+ */
+void DecodeColumnAttributes(SEXP colVec, const char* attributeData, unsigned int size);
 
 #endif // ATTRIBUTES_H
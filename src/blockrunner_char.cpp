@@ -38,6 +38,8 @@
 #include "ifstcolumn.h"
 #include "blockrunner_char.h"
 #include "fstdefines.h"
+#include "bitmapruns.h"
+#include "scratchbuffer.h"
 
 #include <Rcpp.h>
 
@@ -46,7 +48,7 @@ using namespace std;
 using namespace Rcpp;
 
 
-BlockWriterChar::BlockWriterChar(SEXP &strVec, unsigned int vecLength, unsigned int* strSizes, unsigned int* naInts, char* stackBuf, unsigned int stackBufSize)
+BlockWriterChar::BlockWriterChar(SEXP &strVec, unsigned long long vecLength, unsigned int* strSizes, unsigned int* naInts, char* stackBuf, unsigned int stackBufSize)
 {
   this->strVec = &strVec;
   this->naInts = naInts;
@@ -54,23 +56,17 @@ BlockWriterChar::BlockWriterChar(SEXP &strVec, unsigned int vecLength, unsigned
   this->buf = stackBuf;
   this->stackBufSize = stackBufSize;
   this->vecLength = vecLength;
-
-  heapBufSize = BASIC_HEAP_SIZE;
-  heapBuf = new char[BASIC_HEAP_SIZE];
-}
-
-
-BlockWriterChar::~BlockWriterChar()
-{
-  delete[] heapBuf;
 }
 
 
-void BlockWriterChar::SetBuffersFromVec(unsigned int startCount, unsigned int endCount)
+// The strings are copied to the block buffer in the same pass that determines their sizes and NA bits, so the
+// string vector is traversed only once per block. Blocks that don't fit the stack buffer continue in a per-thread
+// scratch buffer that is reused for all blocks and columns
+void BlockWriterChar::SetBuffersFromVec(unsigned long long startCount, unsigned long long endCount)
 {
   // Determine string lengths
   // unsigned int startCount = block * BLOCKSIZE_CHAR;
-  unsigned int nrOfElements = endCount - startCount;  // the string at position endCount is not included
+  unsigned int nrOfElements = static_cast<unsigned int>(endCount - startCount);  // the string at position endCount is not included
   unsigned int nrOfNAInts = 1 + nrOfElements / 32;  // add 1 bit for NA present flag
 
   unsigned int totSize = 0;
@@ -79,7 +75,10 @@ void BlockWriterChar::SetBuffersFromVec(unsigned int startCount, unsigned int en
 
   memset(naInts, 0, nrOfNAInts * 4);  // clear NA bit metadata block (neccessary?)
 
-  for (unsigned int count = startCount; count != endCount; ++count)
+  activeBuf = buf;
+  unsigned int activeBufSize = stackBufSize;
+
+  for (unsigned long long count = startCount; count != endCount; ++count)
   {
     SEXP strElem = STRING_ELT(*strVec, count);
 
@@ -91,7 +90,19 @@ void BlockWriterChar::SetBuffersFromVec(unsigned int startCount, unsigned int en
       naInts[intPos] |= 1 << bitPos;
     }
 
-    totSize += LENGTH(strElem);
+    unsigned int strSize = LENGTH(strElem);
+
+    if (totSize + strSize > activeBufSize)  // continue in (a larger) scratch buffer
+    {
+      activeBufSize = max(2 * (totSize + strSize), (unsigned int) BASIC_HEAP_SIZE);
+      char* heapBuf = ScratchBuffer(ScratchSlot::CHAR_STAGING, activeBufSize);  // keeps its contents when it grows
+
+      if (activeBuf == buf) memcpy(heapBuf, buf, totSize);  // strings so far are in the stack buffer
+      activeBuf = heapBuf;
+    }
+
+    memcpy(activeBuf + totSize, CHAR(strElem), strSize);
+    totSize += strSize;
     strSizes[++sizeCount] = totSize;
   }
 
@@ -102,188 +113,166 @@ void BlockWriterChar::SetBuffersFromVec(unsigned int startCount, unsigned int en
     naInts[nrOfNAInts - 1] |= 1 << bitPos;
   }
 
+  bufSize = totSize;
+}
 
-  // Write string data
-  unsigned int pos = 0;
-  unsigned int lastPos = 0;
-  sizeCount = -1;
 
-  activeBuf = buf;
+// Only the walk over the string vector requires the R thread, the strings are copied from their CHARSXP's by the
+// thread that compresses the block. NA strings are stored as their CHARSXP ("NA"), as in SetBuffersFromVec
+bool BlockWriterChar::GatherStrings(unsigned long long startCount, unsigned long long endCount, const char** strings,
+  unsigned int* sizes, unsigned int* naBits)
+{
+  unsigned int nrOfElements = static_cast<unsigned int>(endCount - startCount);
+  unsigned int nrOfNAInts = 1 + nrOfElements / 32;  // add 1 bit for NA present flag
+  unsigned int hasNA = 0;
+
+  memset(naBits, 0, nrOfNAInts * 4);
 
-  if (totSize > stackBufSize)  // don't use cache memory
+  for (unsigned int elem = 0; elem < nrOfElements; ++elem)
   {
-    if (totSize > heapBufSize)
+    SEXP strElem = STRING_ELT(*strVec, startCount + elem);
+
+    if (strElem == NA_STRING)  // set NA bit
     {
-      delete[] heapBuf;
-      heapBufSize = totSize * 1.1;
-      heapBuf = new char[heapBufSize];
+      ++hasNA;
+      naBits[elem / 32] |= 1 << (elem % 32);
     }
 
-    activeBuf = heapBuf;
+    strings[elem] = CHAR(strElem);
+    sizes[elem] = LENGTH(strElem);
   }
 
-  for (unsigned int count = startCount; count < endCount; ++count)
-  {
-    const char* str = CHAR(STRING_ELT(*strVec, count));
-    pos = strSizes[++sizeCount];
-    strncpy(activeBuf + lastPos, str, pos - lastPos);
-    lastPos = pos;
-  }
+  if (hasNA != 0) naBits[nrOfNAInts - 1] |= 1 << (nrOfElements % 32);  // set last bit
 
-  bufSize = totSize;
+  return true;
 }
 
 
-void BlockReaderChar::AllocateVec(unsigned int vecLength)
-{
-  PROTECT(this->strVec = Rf_allocVector(STRSXP, vecLength));
-  isProtected = true;
-}
-
-void BlockReaderChar::BufferToVec(unsigned int nrOfElements, unsigned int startElem, unsigned int endElem,
-  unsigned int vecOffset, unsigned int* sizeMeta, char* buf)
+void BlockReaderChar::AllocateVec(unsigned long long vecLength)
 {
-  unsigned int nrOfNAInts = 1 + nrOfElements / 32;  // last bit is NA flag
-  unsigned int* bitsNA = &sizeMeta[nrOfElements];
-  unsigned int pos = 0;
-
-  if (startElem != 0)
+  if (target != R_NilValue)
   {
-    pos = sizeMeta[startElem - 1];  // offset previous element
+    PROTECT(this->strVec = target);
+    isProtected = true;
+    return;
   }
 
-  // Test NA flag TODO: set as first flag and remove parameter nrOfNAInts
-  unsigned int flagNA = bitsNA[nrOfNAInts - 1] & (1 << (nrOfElements % 32));
-  if (flagNA == 0)  // no NA's in vector
+  if (lazy)
   {
-    for (unsigned int blockElem = startElem; blockElem <= endElem; ++blockElem)
-    {
-      unsigned int newPos = sizeMeta[blockElem];
-      SEXP curStr = Rf_mkCharLen(buf + pos, newPos - pos);
-      SET_STRING_ELT(strVec, vecOffset + blockElem - startElem, curStr);
-      pos = newPos;  // update to new string offset
-    }
-
+    store = new LazyStringStore(vecLength);
+    PROTECT(this->strVec = LazyStringVector(store));  // the vector owns the store
+    isProtected = true;
     return;
   }
 
-  // We process the datablock in cycles of 32 strings. This minimizes the impact of NA testing for vectors with a small number of NA's
+  PROTECT(this->strVec = Rf_allocVector(STRSXP, (R_xlen_t) vecLength));
+  isProtected = true;
+}
 
-  unsigned int startCycle = startElem / 32;
-  unsigned int endCycle = endElem / 32;
-  unsigned int cycleNAs = bitsNA[startCycle];
 
-  // A single 32 string cycle
+// Copy the strings of a block to the store of a lazy string vector
+inline void BufferToStore(LazyStringStore* store, unsigned int nrOfElements, unsigned int startElem,
+  unsigned int endElem, unsigned long long vecOffset, unsigned int* sizeMeta, char* buf)
+{
+  unsigned int* bitsNA = &sizeMeta[nrOfElements];
+  unsigned int pos = startElem == 0 ? 0 : sizeMeta[startElem - 1];
 
-  if (startCycle == endCycle)
+  BitmapRuns(bitsNA, startElem, endElem + 1, [&](unsigned int runStart, unsigned int runEnd, bool isNA)
   {
-    for (unsigned int blockElem = startElem; blockElem <= endElem; ++blockElem)
+    if (isNA)
     {
-      unsigned int bitMask = 1 << (blockElem % 32);
-
-      if ((cycleNAs & bitMask) != 0)  // set string to NA
+      for (unsigned int blockElem = runStart; blockElem != runEnd; ++blockElem)
       {
-        SET_STRING_ELT(strVec, vecOffset + blockElem - startElem, NA_STRING);
-        pos = sizeMeta[blockElem];  // update to new string offset
-        continue;
+        store->SetNA(vecOffset + blockElem - startElem);
       }
 
-      // Get string from data stream
+      pos = sizeMeta[runEnd - 1];
+      return;
+    }
 
+    for (unsigned int blockElem = runStart; blockElem != runEnd; ++blockElem)
+    {
       unsigned int newPos = sizeMeta[blockElem];
-      SEXP curStr = Rf_mkCharLen(buf + pos, newPos - pos);
-      SET_STRING_ELT(strVec, vecOffset + blockElem - startElem, curStr);
+      store->SetElement(vecOffset + blockElem - startElem, buf + pos, newPos - pos);
       pos = newPos;  // update to new string offset
     }
+  });
+}
+
 
+void BlockReaderChar::BufferToVec(unsigned int nrOfElements, unsigned int startElem, unsigned int endElem,
+  unsigned long long vecOffset, unsigned int* sizeMeta, char* buf)
+{
+  if (lazy)
+  {
+    BufferToStore(store, nrOfElements, startElem, endElem, vecOffset, sizeMeta, buf);
     return;
   }
 
-  // Get possibly partial first cycle
+  unsigned int* bitsNA = &sizeMeta[nrOfElements];
+  unsigned int pos = startElem == 0 ? 0 : sizeMeta[startElem - 1];  // offset previous element
 
-  unsigned int firstCylceEnd = startCycle * 32 + 31;
-  for (unsigned int blockElem = startElem; blockElem <= firstCylceEnd; ++blockElem)
+  // Strings of elements [runStart, runEnd)
+  auto stringRun = [&](unsigned int runStart, unsigned int runEnd)
   {
-    unsigned int bitMask = 1 << (blockElem % 32);
-
-    if ((cycleNAs & bitMask) != 0)  // set string to NA
+    for (unsigned int blockElem = runStart; blockElem != runEnd; ++blockElem)
     {
-      SET_STRING_ELT(strVec, vecOffset + blockElem - startElem, NA_STRING);
-      pos = sizeMeta[blockElem];  // update to new string offset
-      continue;
+      unsigned int newPos = sizeMeta[blockElem];
+      SEXP curStr = Rf_mkCharLen(buf + pos, newPos - pos);
+      SET_STRING_ELT(strVec, vecOffset + blockElem - startElem, curStr);
+      pos = newPos;  // update to new string offset
     }
+  };
 
-    // Get string from data stream
-
-    unsigned int newPos = sizeMeta[blockElem];
-    SEXP curStr = Rf_mkCharLen(buf + pos, newPos - pos);
-    SET_STRING_ELT(strVec, vecOffset + blockElem - startElem, curStr);
-    pos = newPos;  // update to new string offset
+  // The bit following the NA bits flags the presence of NA's in the block
+  if (((bitsNA[nrOfElements / 32] >> (nrOfElements % 32)) & 1) == 0)
+  {
+    stringRun(startElem, endElem + 1);
+    return;
   }
 
-  // Get all but last cycle with fast NA test
-
-  for (unsigned int cycle = startCycle + 1; cycle != endCycle; ++cycle)
+  // The NA bits are processed as runs of strings and runs of NA's, so the cost of NA testing depends on the number
+  // of runs rather than on the number of elements
+  BitmapRuns(bitsNA, startElem, endElem + 1, [&](unsigned int runStart, unsigned int runEnd, bool isNA)
   {
-    unsigned int cycleNAs = bitsNA[cycle];
-    unsigned int middleCycleEnd = cycle * 32 + 32;
-
-    if (cycleNAs == 0)  // no NA's
+    if (!isNA)
     {
-      for (unsigned int blockElem = cycle * 32; blockElem != middleCycleEnd; ++blockElem)
-      {
-        unsigned int newPos = sizeMeta[blockElem];
-        SEXP curStr = Rf_mkCharLen(buf + pos, newPos - pos);
-        SET_STRING_ELT(strVec, vecOffset + blockElem - startElem, curStr);
-        pos = newPos;  // update to new string offset
-      }
-      continue;
+      stringRun(runStart, runEnd);
+      return;
     }
 
-    // Cycle contains one or more NA's
-
-    for (unsigned int blockElem = cycle * 32; blockElem != middleCycleEnd; ++blockElem)
+    for (unsigned int blockElem = runStart; blockElem != runEnd; ++blockElem)
     {
-      unsigned int bitMask = 1 << (blockElem % 32);
-      unsigned int newPos = sizeMeta[blockElem];
-
-      if ((cycleNAs & bitMask) != 0)  // set string to NA
-      {
-        SET_STRING_ELT(strVec, vecOffset + blockElem - startElem, NA_STRING);
-        pos = newPos;  // update to new string offset
-        continue;
-      }
+      SET_STRING_ELT(strVec, vecOffset + blockElem - startElem, NA_STRING);
+    }
 
-      // Get string from data stream
+    pos = sizeMeta[runEnd - 1];  // update to new string offset
+  });
+}
 
-      SEXP curStr = Rf_mkCharLen(buf + pos, newPos - pos);
-      SET_STRING_ELT(strVec, vecOffset + blockElem - startElem, curStr);
-      pos = newPos;  // update to new string offset
-    }
-  }
 
-  // Last cycle
+// The CHARSXP of each level is created once, elements only reference them
+bool BlockReaderChar::LevelsToVec(unsigned long long vecOffset, unsigned long long length, const int* codes,
+  unsigned int nrOfLevels, const unsigned int* levelSizes, const char* levelBuf)
+{
+  if (lazy) return false;  // the strings are expanded into the store with BufferToVec
 
-  cycleNAs = bitsNA[endCycle];
+  SEXP levels = PROTECT(Rf_allocVector(STRSXP, nrOfLevels));
+  unsigned int pos = 0;
 
-  ++endElem;
-  for (unsigned int blockElem = endCycle * 32; blockElem != endElem; ++blockElem)
+  for (unsigned int level = 0; level < nrOfLevels; ++level)
   {
-    unsigned int bitMask = 1 << (blockElem % 32);
-    unsigned int newPos = sizeMeta[blockElem];
+    SET_STRING_ELT(levels, level, Rf_mkCharLen(levelBuf + pos, levelSizes[level] - pos));
+    pos = levelSizes[level];
+  }
 
-    if ((cycleNAs & bitMask) != 0)  // set string to NA
-    {
-      SET_STRING_ELT(strVec, vecOffset + blockElem - startElem, NA_STRING);
-      pos = newPos;  // update to new string offset
-      continue;
-    }
+  for (unsigned long long elem = 0; elem < length; ++elem)
+  {
+    int code = codes[elem];
+    SET_STRING_ELT(strVec, vecOffset + elem, code == NA_INTEGER ? NA_STRING : STRING_ELT(levels, code - 1));
+  }
 
-    // Get string from data stream
+  UNPROTECT(1);
 
-    SEXP curStr = Rf_mkCharLen(buf + pos, newPos - pos);
-    SET_STRING_ELT(strVec, vecOffset + blockElem - startElem, curStr);
-    pos = newPos;  // update to new string offset
-  }
+  return true;
 }
-
@@ -39,39 +39,57 @@
 
 #include <Rcpp.h>
 
+#include "lazystrings.h"
+
 
 class BlockWriterChar : public IBlockWriter
 {
   SEXP* strVec;
   unsigned int stackBufSize;
-  unsigned int heapBufSize;
   char* buf;
-  char *heapBuf;
 
   public:
-    BlockWriterChar(SEXP &strVec, unsigned int vecLength, unsigned int* strSizes, unsigned int* naInts, char* stackBuf, unsigned int stackBufSize);
-    ~BlockWriterChar();
+    BlockWriterChar(SEXP &strVec, unsigned long long vecLength, unsigned int* strSizes, unsigned int* naInts, char* stackBuf, unsigned int stackBufSize);
+
+    void SetBuffersFromVec(unsigned long long startCount, unsigned long long endCount);
 
-    void SetBuffersFromVec(unsigned int startCount, unsigned int endCount);
+    bool GatherStrings(unsigned long long startCount, unsigned long long endCount, const char** strings,
+      unsigned int* sizes, unsigned int* naBits);
 };
 
 
+// With lazy set, the strings are collected in a LazyStringStore and returned as a lazy string vector. With a target
+// vector, the strings are set in that (reused) vector instead of a new one.
 class BlockReaderChar : public IStringColumn
 {
   SEXP strVec;
   bool isProtected;
+  bool lazy;
+  LazyStringStore* store;
+  SEXP target;
 
 public:
-  BlockReaderChar() { isProtected = true; }
+  BlockReaderChar(bool lazy = false, SEXP target = R_NilValue)
+  {
+    isProtected = true;
+    this->lazy = lazy && target == R_NilValue;
+    this->target = target;
+    store = nullptr;
+  }
   ~BlockReaderChar(){ if (isProtected) UNPROTECT(1); }
 
-  void AllocateVec(unsigned int vecLength);
+  void AllocateVec(unsigned long long vecLength);
 
   void BufferToVec(unsigned int nrOfElements, unsigned int startElem, unsigned int endElem,
-    unsigned int vecOffset, unsigned int* sizeMeta, char* buf);
+    unsigned long long vecOffset, unsigned int* sizeMeta, char* buf);
+
+  bool LevelsToVec(unsigned long long vecOffset, unsigned long long length, const int* codes,
+    unsigned int nrOfLevels, const unsigned int* levelSizes, const char* levelBuf);
 
   const char* GetElement(int elementNr)
   {
+    if (lazy) return store->Element(elementNr);
+
     return CHAR(STRING_ELT(strVec, elementNr));
   }
 
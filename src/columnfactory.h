@@ -38,6 +38,7 @@
 
 #include <iostream>
 #include <vector>
+#include <stdexcept>
 
 #include <Rcpp.h>
 
@@ -47,6 +48,7 @@
 
 #include <fstcolumn.h>
 #include <blockrunner_char.h>
+#include <lazystrings.h>
 
 
 class ColumnFactory : public IColumnFactory
@@ -54,34 +56,93 @@ class ColumnFactory : public IColumnFactory
 public:
   ~ColumnFactory() {};
 
-  IFactorColumn* CreateFactorColumn(int nrOfRows)
+  IFactorColumn* CreateFactorColumn(unsigned long long nrOfRows)
   {
     return new FactorColumn(nrOfRows);
   }
 
-  ILogicalColumn* CreateLogicalColumn(int nrOfRows)
+  ILogicalColumn* CreateLogicalColumn(unsigned long long nrOfRows)
   {
     return new LogicalColumn(nrOfRows);
   }
 
-  IDoubleColumn* CreateDoubleColumn(int nrOfRows)
+  IDoubleColumn* CreateDoubleColumn(unsigned long long nrOfRows)
   {
     return new DoubleColumn(nrOfRows);
   }
 
-  IIntegerColumn* CreateIntegerColumn(int nrOfRows)
+  IIntegerColumn* CreateIntegerColumn(unsigned long long nrOfRows)
   {
     return new IntegerColumn(nrOfRows);
   }
 
+  IInt64Column* CreateInt64Column(unsigned long long nrOfRows)
+  {
+    return new Int64Column(nrOfRows);
+  }
+
   IStringArray* CreateStringArray()
   {
     return new StringArray();
   }
 
-  IStringColumn* CreateStringColumn(int nrOfRows)
+  IStringColumn* CreateStringColumn(unsigned long long nrOfRows)
+  {
+    return new BlockReaderChar(LazyStringsEnabled());
+  }
+};
+
+
+// Creates the result columns of a range read from the columns of an existing table (with matching column types and
+// at least the number of rows read), so a window of rows can be read repeatedly without allocating new vectors
+class TargetColumnFactory : public ColumnFactory
+{
+  SEXP targetTable;
+
+  SEXP Target(int colSel, SEXPTYPE type, unsigned long long nrOfRows)
+  {
+    SEXP target = VECTOR_ELT(targetTable, colSel);
+
+    if (TYPEOF(target) != type || (unsigned long long) XLENGTH(target) < nrOfRows)
+    {
+      throw(std::runtime_error("The columns of the target table should match the stored column types and have "
+        "sufficient length."));
+    }
+
+    return target;
+  }
+
+public:
+  TargetColumnFactory(SEXP targetTable) : targetTable(targetTable) {}
+
+  IFactorColumn* CreateFactorColumn(unsigned long long nrOfRows, int colSel)
+  {
+    return new FactorColumn(Target(colSel, INTSXP, nrOfRows));
+  }
+
+  ILogicalColumn* CreateLogicalColumn(unsigned long long nrOfRows, int colSel)
+  {
+    return new LogicalColumn(Target(colSel, LGLSXP, nrOfRows));
+  }
+
+  IDoubleColumn* CreateDoubleColumn(unsigned long long nrOfRows, int colSel)
+  {
+    return new DoubleColumn(Target(colSel, REALSXP, nrOfRows));
+  }
+
+  IIntegerColumn* CreateIntegerColumn(unsigned long long nrOfRows, int colSel)
+  {
+    return new IntegerColumn(Target(colSel, INTSXP, nrOfRows));
+  }
+
+  IInt64Column* CreateInt64Column(unsigned long long nrOfRows, int colSel)
+  {
+    return new Int64Column(Target(colSel, REALSXP, nrOfRows));
+  }
+
+  IStringColumn* CreateStringColumn(unsigned long long nrOfRows, int colSel)
   {
-    return new BlockReaderChar();
+    return new BlockReaderChar(false, Target(colSel, STRSXP, nrOfRows));
   }
 };
 
@@ -91,9 +91,17 @@ public:
   SEXP intVec;
   BlockReaderChar* blockReaderStrVec;
 
-  FactorColumn(int nrOfRows)
+  FactorColumn(unsigned long long nrOfRows)
   {
-    intVec = Rf_allocVector(INTSXP, nrOfRows);
+    intVec = Rf_allocVector(INTSXP, (R_xlen_t) nrOfRows);
+    PROTECT(intVec);
+    blockReaderStrVec = new BlockReaderChar();
+  }
+
+  // Read into an existing (reused) vector
+  FactorColumn(SEXP target)
+  {
+    intVec = target;
     PROTECT(intVec);
     blockReaderStrVec = new BlockReaderChar();
   }
@@ -121,9 +129,15 @@ class LogicalColumn : public ILogicalColumn
 public:
   SEXP boolVec;
 
-  LogicalColumn(int nrOfRows)
+  LogicalColumn(unsigned long long nrOfRows)
   {
-    boolVec = Rf_allocVector(LGLSXP, nrOfRows);
+    boolVec = Rf_allocVector(LGLSXP, (R_xlen_t) nrOfRows);
+    PROTECT(boolVec);
+  }
+
+  LogicalColumn(SEXP target)
+  {
+    boolVec = target;
     PROTECT(boolVec);
   }
 
@@ -144,9 +158,15 @@ class DoubleColumn : public IDoubleColumn
   public:
     SEXP colVec;
 
-    DoubleColumn(int nrOfRows)
+    DoubleColumn(unsigned long long nrOfRows)
     {
-      colVec = Rf_allocVector(REALSXP, nrOfRows);
+      colVec = Rf_allocVector(REALSXP, (R_xlen_t) nrOfRows);
+      PROTECT(colVec);
+    }
+
+    DoubleColumn(SEXP target)
+    {
+      colVec = target;
       PROTECT(colVec);
     }
 
@@ -162,14 +182,50 @@ class DoubleColumn : public IDoubleColumn
 };
 
 
+// Columns of type bit64::integer64 are stored in a double vector
+class Int64Column : public IInt64Column
+{
+  public:
+    SEXP colVec;
+
+    Int64Column(unsigned long long nrOfRows)
+    {
+      colVec = Rf_allocVector(REALSXP, (R_xlen_t) nrOfRows);
+      PROTECT(colVec);
+    }
+
+    Int64Column(SEXP target)
+    {
+      colVec = target;
+      PROTECT(colVec);
+    }
+
+    ~Int64Column()
+    {
+      UNPROTECT(1);
+    }
+
+    long long* Data()
+    {
+      return (long long*) REAL(colVec);
+    }
+};
+
+
 class IntegerColumn : public IIntegerColumn
 {
 public:
   SEXP colVec;
 
-  IntegerColumn(int nrOfRows)
+  IntegerColumn(unsigned long long nrOfRows)
+  {
+    colVec = Rf_allocVector(INTSXP, (R_xlen_t) nrOfRows);
+    PROTECT(colVec);
+  }
+
+  IntegerColumn(SEXP target)
   {
-    colVec = Rf_allocVector(INTSXP, nrOfRows);
+    colVec = target;
     PROTECT(colVec);
   }
 
@@ -0,0 +1,562 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+// Standalone benchmark of the block codecs of fstcore/compression, not part of the R package. Each codec is run on
+// blocks of synthetic column data and the compression ratio and the compression and decompression speeds are
+// written as CSV to stdout, one line per codec, data type, distribution, compression level and block size. The
+// transform kernels ShuffleReal, LogicCompr64 and CompactIntToByte are measured the same way.
+//
+// Build (in directory src): make -f Makevars codecbench
+//
+// Usage: codecbench [--size MB] [--block-sizes 4096,16384] [--levels 10,50,100] [--min-time seconds] [--filter name]
+//
+// Speeds are in GB/s of uncompressed data, the best of the passes over all blocks that are run during the minimum
+// time. Blocks that a codec can't encode (a zero compressed size, e.g. REAL_INT on non-integer values) are counted
+// as stored uncompressed and are not decompressed.
+
+#include "compression.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+
+using namespace std;
+
+
+#define NA_INTEGER_BITS INT_MIN
+#define NA_REAL_BITS 0x7FF00000000007A2ULL  // R's NA_real_
+
+
+enum ElementType
+{
+  INT_32,
+  LOGICAL_32,
+  DOUBLE_64,
+  INT_64
+};
+
+const char* elementTypeNames[] = { "integer", "logical", "double", "integer64" };
+
+
+enum Distribution
+{
+  RANDOM,
+  SORTED,
+  LOW_CARDINALITY,
+  NA_HEAVY,
+  REAL_VALUED,
+  NR_OF_DISTRIBUTIONS
+};
+
+const char* distributionNames[] = { "random", "sorted", "low_cardinality", "na_heavy", "real_valued" };
+
+
+typedef void (*Transform)(char* dst, const char* src, unsigned int nrOfBytes);
+
+
+struct Codec
+{
+  const char* name;
+  ElementType type;
+  CompAlgorithm compress;      // nullptr for a transform kernel
+  DecompAlgorithm decompress;
+  bool usesLevel;              // the compression level is passed to LZ4 or ZSTD
+  bool smallInts;              // only for integers in the range 0 - 127 and NA (factor codes)
+  Transform forward;           // transform kernel
+  Transform inverse;
+  unsigned int (*transformSize)(unsigned int nrOfBytes);
+};
+
+
+// Transform kernels
+
+unsigned int SameSize(unsigned int nrOfBytes)
+{
+  return nrOfBytes;
+}
+
+void CopyKernel(char* dst, const char* src, unsigned int nrOfBytes)
+{
+  memcpy(dst, src, nrOfBytes);  // uncompressed blocks are copied
+}
+
+void ShuffleRealKernel(char* dst, const char* src, unsigned int nrOfBytes)
+{
+  ShuffleReal((double*) src, (double*) dst, nrOfBytes / 8);
+}
+
+void DeshuffleRealKernel(char* dst, const char* src, unsigned int nrOfBytes)
+{
+  DeshuffleReal((double*) src, (double*) dst, nrOfBytes / 8);
+}
+
+void LogicCompr64Kernel(char* dst, const char* src, unsigned int nrOfBytes)
+{
+  LogicCompr64(src, (unsigned long long*) dst, nrOfBytes / 4);
+}
+
+void LogicDecompr64Kernel(char* dst, const char* src, unsigned int nrOfBytes)
+{
+  LogicDecompr64(dst, (const unsigned long long*) src, nrOfBytes / 4, 0);
+}
+
+unsigned int LogicCompr64Size(unsigned int nrOfBytes)
+{
+  return 8 * (1 + (nrOfBytes / 4 - 1) / 32);  // 32 logicals per 64-bit word
+}
+
+void CompactIntToByteKernel(char* dst, const char* src, unsigned int nrOfBytes)
+{
+  CompactIntToByte(dst, src, nrOfBytes / 4);
+}
+
+void DecompactByteToIntKernel(char* dst, const char* src, unsigned int nrOfBytes)
+{
+  DecompactByteToInt(src, dst, nrOfBytes / 4);
+}
+
+unsigned int CompactIntToByteSize(unsigned int nrOfBytes)
+{
+  return 8 * (1 + (nrOfBytes - 1) / 32);  // 8 integers per 64-bit word
+}
+
+
+// The ZSTDMT and ZSTD_DICT algorithms use the ZSTD block functions, their compressors work on complete columns
+const Codec codecs[] =
+{
+  { "UNCOMPRESS",             INT_32,     nullptr, nullptr, false, false, CopyKernel, CopyKernel, SameSize },
+  { "LZ4",                    INT_32,     LZ4_C,                    LZ4_D,                    true,  false },
+  { "LZ4",                    DOUBLE_64,  LZ4_C,                    LZ4_D,                    true,  false },
+  { "LZ4_SHUF4",              INT_32,     LZ4_C_SHUF4,              LZ4_D_SHUF4,              true,  false },
+  { "ZSTD",                   INT_32,     ZSTD_C,                   ZSTD_D,                   true,  false },
+  { "ZSTD",                   DOUBLE_64,  ZSTD_C,                   ZSTD_D,                   true,  false },
+  { "ZSTD_SHUF4",             INT_32,     ZSTD_C_SHUF4,             ZSTD_D_SHUF4,             true,  false },
+  { "LZ4_SHUF8",              DOUBLE_64,  LZ4_C_SHUF8,              LZ4_D_SHUF8,              true,  false },
+  { "LZ4_SHUF8",              INT_64,     LZ4_C_SHUF8,              LZ4_D_SHUF8,              true,  false },
+  { "ZSTD_SHUF8",             DOUBLE_64,  ZSTD_C_SHUF8,             ZSTD_D_SHUF8,             true,  false },
+  { "ZSTD_SHUF8",             INT_64,     ZSTD_C_SHUF8,             ZSTD_D_SHUF8,             true,  false },
+  { "LZ4_LOGIC64",            LOGICAL_32, LZ4_LOGIC64_C,            LZ4_LOGIC64_D,            true,  false },
+  { "LOGIC64",                LOGICAL_32, LOGIC64_C,                LOGIC64_D,                false, false },
+  { "ZSTD_LOGIC64",           LOGICAL_32, ZSTD_LOGIC64_C,           ZSTD_LOGIC64_D,           true,  false },
+  { "LZ4_INT_TO_BYTE",        INT_32,     LZ4_INT_TO_BYTE_C,        LZ4_INT_TO_BYTE_D,        true,  true  },
+  { "LZ4_INT_TO_SHORT_SHUF2", INT_32,     LZ4_INT_TO_SHORT_SHUF2_C, LZ4_INT_TO_SHORT_SHUF2_D, true,  true  },
+  { "INT_TO_BYTE",            INT_32,     INT_TO_BYTE_C,            INT_TO_BYTE_D,            false, true  },
+  { "INT_TO_SHORT",           INT_32,     INT_TO_SHORT_C,           INT_TO_SHORT_D,           false, true  },
+  { "ZSTD_INT_TO_BYTE",       INT_32,     ZSTD_INT_TO_BYTE_C,       ZSTD_INT_TO_BYTE_D,       true,  true  },
+  { "INT_BITPACK",            INT_32,     INT_BITPACK_C,            INT_BITPACK_D,            false, false },
+  { "LZ4_INT_BITPACK",        INT_32,     LZ4_INT_BITPACK_C,        LZ4_INT_BITPACK_D,        true,  false },
+  { "ZSTD_INT_BITPACK",       INT_32,     ZSTD_INT_BITPACK_C,       ZSTD_INT_BITPACK_D,       true,  false },
+  { "INT_DELTA",              INT_32,     INT_DELTA_C,              INT_DELTA_D,              false, false },
+  { "LZ4_INT_DELTA",          INT_32,     LZ4_INT_DELTA_C,          LZ4_INT_DELTA_D,          true,  false },
+  { "REAL_DELTA",             DOUBLE_64,  REAL_DELTA_C,             REAL_DELTA_D,             false, false },
+  { "LZ4_REAL_DELTA",         DOUBLE_64,  LZ4_REAL_DELTA_C,         LZ4_REAL_DELTA_D,         true,  false },
+  { "REAL_XOR",               DOUBLE_64,  REAL_XOR_C,               REAL_XOR_D,               false, false },
+  { "INT_RLE",                INT_32,     INT_RLE_C,                INT_RLE_D,                false, false },
+  { "REAL_INT",               DOUBLE_64,  REAL_INT_C,               REAL_INT_D,               false, false },
+  { "LZ4_REAL_INT",           DOUBLE_64,  LZ4_REAL_INT_C,           LZ4_REAL_INT_D,           true,  false },
+  { "ZSTD_REAL_INT",          DOUBLE_64,  ZSTD_REAL_INT_C,          ZSTD_REAL_INT_D,          true,  false },
+  { "LONG_BITPACK",           INT_64,     LONG_BITPACK_C,           LONG_BITPACK_D,           false, false },
+  { "LZ4_LONG_BITPACK",       INT_64,     LZ4_LONG_BITPACK_C,       LZ4_LONG_BITPACK_D,       true,  false },
+  { "ZSTD_LONG_BITPACK",      INT_64,     ZSTD_LONG_BITPACK_C,      ZSTD_LONG_BITPACK_D,      true,  false },
+  { "LONG_DELTA",             INT_64,     LONG_DELTA_C,             LONG_DELTA_D,             false, false },
+  { "LZ4_LONG_DELTA",         INT_64,     LZ4_LONG_DELTA_C,         LZ4_LONG_DELTA_D,         true,  false },
+  { "INT_SPARSE",             INT_32,     INT_SPARSE_C,             INT_SPARSE_D,             false, false },
+  { "REAL_SPARSE",            DOUBLE_64,  REAL_SPARSE_C,            REAL_SPARSE_D,            false, false },
+  { "LONG_SPARSE",            INT_64,     LONG_SPARSE_C,            LONG_SPARSE_D,            false, false },
+  { "LZ4HC",                  INT_32,     LZ4HC_C,                  LZ4_D,                    true,  false },
+  { "LZ4HC",                  DOUBLE_64,  LZ4HC_C,                  LZ4_D,                    true,  false },
+  { "LZ4HC_SHUF4",            INT_32,     LZ4HC_C_SHUF4,            LZ4_D_SHUF4,              true,  false },
+  { "LZ4HC_SHUF8",            DOUBLE_64,  LZ4HC_C_SHUF8,            LZ4_D_SHUF8,              true,  false },
+  { "LZ4HC_SHUF8",            INT_64,     LZ4HC_C_SHUF8,            LZ4_D_SHUF8,              true,  false },
+  { "ShuffleReal",            DOUBLE_64,  nullptr, nullptr, false, false, ShuffleRealKernel, DeshuffleRealKernel,
+    SameSize },
+  { "LogicCompr64",           LOGICAL_32, nullptr, nullptr, false, false, LogicCompr64Kernel, LogicDecompr64Kernel,
+    LogicCompr64Size },
+  { "CompactIntToByte",       INT_32,     nullptr, nullptr, false, true,  CompactIntToByteKernel,
+    DecompactByteToIntKernel, CompactIntToByteSize }
+};
+
+
+// Fill the data with elements of a distribution, returns false if the distribution doesn't apply to the type
+bool Generate(ElementType type, Distribution distribution, vector<char> &data, mt19937_64 &rng)
+{
+  if (distribution == REAL_VALUED && type != DOUBLE_64) return false;
+
+  unsigned long long nrOfBytes = data.size();
+  uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  if (type == INT_32 || type == LOGICAL_32)
+  {
+    int* values = (int*) data.data();
+    unsigned long long length = nrOfBytes / 4;
+    int sum = 0;
+
+    for (unsigned long long pos = 0; pos < length; ++pos)
+    {
+      unsigned int bits = (unsigned int) rng();
+      bool logical = type == LOGICAL_32;
+
+      switch (distribution)
+      {
+        case RANDOM:
+          values[pos] = logical ? bits % 2 : (int) (bits == (unsigned int) NA_INTEGER_BITS ? 0 : bits);
+          break;
+
+        case SORTED:
+          if (logical) values[pos] = pos >= length / 2;
+          else values[pos] = sum += bits % 16;
+          break;
+
+        case LOW_CARDINALITY:  // factor codes, or mostly FALSE logicals
+          values[pos] = logical ? bits % 100 == 0 : 1 + bits % 16;
+          break;
+
+        default:  // NA_HEAVY
+          values[pos] = bits % 10 < 7 ? NA_INTEGER_BITS : (logical ? bits % 2 : (bits >> 4) % 100);
+          break;
+      }
+    }
+
+    return true;
+  }
+
+  if (type == INT_64)
+  {
+    long long* values = (long long*) data.data();
+    long long sum = 0;
+
+    for (unsigned long long pos = 0; pos < nrOfBytes / 8; ++pos)
+    {
+      unsigned long long bits = rng();
+
+      switch (distribution)
+      {
+        case RANDOM:
+          values[pos] = bits == 0x8000000000000000ULL ? 0 : (long long) bits;
+          break;
+
+        case SORTED:
+          values[pos] = sum += bits % 1000;
+          break;
+
+        case LOW_CARDINALITY:
+          values[pos] = 10000000000LL * (1 + bits % 16);
+          break;
+
+        default:  // NA_HEAVY
+          values[pos] = bits % 10 < 7 ? LLONG_MIN : (long long) (bits >> 40);
+          break;
+      }
+    }
+
+    return true;
+  }
+
+  double* values = (double*) data.data();
+  double sum = 0;
+  double naValue;
+  unsigned long long naBits = NA_REAL_BITS;
+  memcpy(&naValue, &naBits, 8);
+
+  for (unsigned long long pos = 0; pos < nrOfBytes / 8; ++pos)
+  {
+    double value = uniform(rng);
+
+    switch (distribution)
+    {
+      case RANDOM:
+        values[pos] = value;
+        break;
+
+      case SORTED:
+        values[pos] = sum += value;
+        break;
+
+      case LOW_CARDINALITY:
+        values[pos] = 0.25 * (int) (16 * value);
+        break;
+
+      case NA_HEAVY:
+        values[pos] = rng() % 10 < 7 ? naValue : value;
+        break;
+
+      default:  // REAL_VALUED, prices with 2 decimals
+        values[pos] = round(100000 * value) / 100;
+        break;
+    }
+  }
+
+  return true;
+}
+
+
+struct Measurement
+{
+  unsigned long long compressedBytes;
+  unsigned long long declinedBlocks;
+  double compressSeconds;
+  double decompressSeconds;
+  bool roundTrip;
+};
+
+
+double Seconds(chrono::steady_clock::time_point start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+// Run passes over all blocks until minTime has passed, returns the time of the fastest pass
+template<typename Pass>
+double BestPass(Pass pass, double minTime)
+{
+  double best = 1e100;
+  double total = 0;
+
+  do
+  {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    pass();
+    double seconds = Seconds(start);
+
+    best = min(best, seconds);
+    total += seconds;
+  }
+  while (total < minTime);
+
+  return best;
+}
+
+
+Measurement Measure(const Codec &codec, const vector<char> &data, unsigned int blockSize, int level, double minTime)
+{
+  unsigned long long nrOfBlocks = data.size() / blockSize;
+  unsigned int capacity = 2 * blockSize + 1024;  // exceeds the compress bound of all codecs
+
+  vector<char> compressed(nrOfBlocks * capacity);
+  vector<unsigned int> compSizes(nrOfBlocks);
+  vector<char> decompressed(data.size());
+
+  Measurement measurement;
+
+  measurement.compressSeconds = BestPass([&]()
+  {
+    for (unsigned long long block = 0; block < nrOfBlocks; ++block)
+    {
+      char* dst = &compressed[block * capacity];
+      const char* src = &data[block * blockSize];
+
+      if (codec.compress == nullptr)
+      {
+        codec.forward(dst, src, blockSize);
+        compSizes[block] = codec.transformSize(blockSize);
+      }
+      else
+      {
+        compSizes[block] = codec.compress(dst, capacity, src, blockSize, level);
+      }
+    }
+  }, minTime);
+
+  measurement.compressedBytes = 0;
+  measurement.declinedBlocks = 0;
+
+  for (unsigned long long block = 0; block < nrOfBlocks; ++block)
+  {
+    if (compSizes[block] == 0) ++measurement.declinedBlocks;
+    measurement.compressedBytes += compSizes[block] == 0 ? blockSize : compSizes[block];
+  }
+
+  measurement.decompressSeconds = BestPass([&]()
+  {
+    for (unsigned long long block = 0; block < nrOfBlocks; ++block)
+    {
+      if (compSizes[block] == 0) continue;
+
+      char* dst = &decompressed[block * blockSize];
+      const char* src = &compressed[block * capacity];
+
+      if (codec.compress == nullptr)
+      {
+        codec.inverse(dst, src, blockSize);
+      }
+      else
+      {
+        codec.decompress(dst, blockSize, src, compSizes[block]);
+      }
+    }
+  }, minTime);
+
+  measurement.roundTrip = true;
+
+  for (unsigned long long block = 0; block < nrOfBlocks; ++block)
+  {
+    if (compSizes[block] == 0) continue;
+
+    if (memcmp(&decompressed[block * blockSize], &data[block * blockSize], blockSize) != 0)
+    {
+      measurement.roundTrip = false;
+    }
+  }
+
+  return measurement;
+}
+
+
+vector<int> ParseList(const char* arg)
+{
+  vector<int> values;
+  string list(arg);
+  size_t start = 0;
+
+  while (start <= list.size())
+  {
+    size_t end = list.find(',', start);
+    if (end == string::npos) end = list.size();
+
+    values.push_back(atoi(list.substr(start, end - start).c_str()));
+    start = end + 1;
+  }
+
+  return values;
+}
+
+
+int Usage()
+{
+  fprintf(stderr, "Usage: codecbench [--size MB] [--block-sizes 4096,16384] [--levels 10,50,100] "
+    "[--min-time seconds] [--filter name]\n");
+
+  return 1;
+}
+
+
+int main(int argc, char* argv[])
+{
+  double sizeMB = 4;
+  vector<int> blockSizes = { 1024, 4096, MAX_SIZE_COMPRESS_BLOCK };
+  vector<int> levels = { 10, 50, 100 };
+  double minTime = 0.05;
+  string filter;
+
+  for (int argNr = 1; argNr < argc; argNr += 2)
+  {
+    if (argNr + 1 == argc) return Usage();
+
+    string option(argv[argNr]);
+    const char* value = argv[argNr + 1];
+
+    if (option == "--size") sizeMB = atof(value);
+    else if (option == "--block-sizes") blockSizes = ParseList(value);
+    else if (option == "--levels") levels = ParseList(value);
+    else if (option == "--min-time") minTime = atof(value);
+    else if (option == "--filter") filter = value;
+    else return Usage();
+  }
+
+  // Blocks hold a multiple of 256 bytes (the 64 logicals of two LogicCompr64 words and the 8 doubles of a shuffle)
+  for (vector<int>::iterator blockSize = blockSizes.begin(); blockSize != blockSizes.end(); ++blockSize)
+  {
+    if (*blockSize < 256 || *blockSize > MAX_SIZE_COMPRESS_BLOCK || *blockSize % 256 != 0)
+    {
+      fprintf(stderr, "Block sizes should be multiples of 256 bytes of at most %d bytes.\n", MAX_SIZE_COMPRESS_BLOCK);
+      return 1;
+    }
+  }
+
+  for (vector<int>::iterator level = levels.begin(); level != levels.end(); ++level)
+  {
+    if (*level < 0 || *level > 100)
+    {
+      fprintf(stderr, "Compression levels should be in the range 0 to 100.\n");
+      return 1;
+    }
+  }
+
+  unsigned long long dataSize = (unsigned long long) (sizeMB * 1048576);
+  dataSize -= dataSize % MAX_SIZE_COMPRESS_BLOCK;
+
+  if (dataSize == 0 || minTime < 0) return Usage();
+
+  printf("codec,type,distribution,level,block_size,raw_bytes,compressed_bytes,ratio,declined_blocks,"
+    "compress_gbps,decompress_gbps,roundtrip\n");
+
+  vector<char> data(dataSize);
+
+  for (int type = INT_32; type <= INT_64; ++type)
+  {
+    for (int distribution = RANDOM; distribution < NR_OF_DISTRIBUTIONS; ++distribution)
+    {
+      mt19937_64 rng(2017);  // identical data for each run
+      if (!Generate((ElementType) type, (Distribution) distribution, data, rng)) continue;
+
+      for (const Codec &codec : codecs)
+      {
+        if (codec.type != type) continue;
+        if (!filter.empty() && string(codec.name).find(filter) == string::npos) continue;
+        if (codec.smallInts && distribution != LOW_CARDINALITY && distribution != NA_HEAVY) continue;
+
+        vector<int> codecLevels = codec.usesLevel ? levels : vector<int>(1, 0);
+
+        for (vector<int>::iterator level = codecLevels.begin(); level != codecLevels.end(); ++level)
+        {
+          for (vector<int>::iterator blockSize = blockSizes.begin(); blockSize != blockSizes.end(); ++blockSize)
+          {
+            unsigned long long rawBytes = dataSize - dataSize % *blockSize;
+            Measurement measurement = Measure(codec, data, *blockSize, *level, minTime);
+
+            printf("%s,%s,%s,%d,%d,%llu,%llu,%.4f,%llu,%.4f,%.4f,%d\n", codec.name, elementTypeNames[type],
+              distributionNames[distribution], *level, *blockSize, rawBytes, measurement.compressedBytes,
+              (double) rawBytes / measurement.compressedBytes, measurement.declinedBlocks,
+              rawBytes / measurement.compressSeconds / 1e9,
+              (rawBytes - measurement.declinedBlocks * *blockSize) / measurement.decompressSeconds / 1e9,
+              measurement.roundTrip ? 1 : 0);
+
+            fflush(stdout);
+          }
+        }
+      }
+    }
+  }
+
+  return 0;
+}
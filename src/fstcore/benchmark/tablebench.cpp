@@ -0,0 +1,684 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+// Standalone end-to-end benchmark of writing and reading fst files with FstStore, not part of the R package.
+// Synthetic tables of several shapes are generated with a fixed seed, written with FstStore::fstWrite and read back
+// with FstStore::fstRead. Each combination of table, size, compression level and thread count is measured for a
+// write, a full read, a read of a range of rows and a read of a subset of the columns, with a hot and a cold page
+// cache. Results are written as CSV to stdout with the wall time, throughput (MB/s of in-memory data), CPU time and
+// peak resident memory of each measurement.
+//
+// Build (in directory src): make -f Makevars tablebench
+//
+// Usage: tablebench [--rows 1000000,10000000] [--tables narrow,wide,text,factor,timeseries] [--levels 0,50,100]
+//   [--threads 1,8] [--repeats 3] [--dir path] [--drop-caches]
+//
+// Hot reads are the best of the repeats after a first read. For cold reads the pages of the file are evicted with
+// posix_fadvise before each repeat; with --drop-caches (requires root) the complete page cache is dropped as well.
+// Peak memory is the high-water mark of the resident set size during a measurement, which is reset before each
+// measurement where the kernel supports it (Linux).
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <omp.h>
+
+#include <ifstcolumn.h>
+#include <fstdefines.h>
+#include <fststore.h>
+#include <rowbatch.h>
+
+
+using namespace std;
+
+
+// Column names and selections
+class StringArray : public IStringArray
+{
+public:
+  vector<string> strings;
+
+  void AllocateArray(int vecLength) { strings.resize(vecLength); }
+  void SetElement(int elementNr, const char* str) { strings[elementNr] = str; }
+  void SetElement(int elementNr, const char* str, int strLen) { strings[elementNr].assign(str, strLen); }
+  const char* GetElement(int elementNr) { return strings[elementNr].c_str(); }
+  int Length() { return (int) strings.size(); }
+};
+
+
+// Column factory of the reads, the result columns are moved to the RowBatch that is read
+class ReadBatch : public RowBatch
+{
+public:
+  ReadBatch(const vector<FstColumnType> &colTypes) : RowBatch(colTypes) {}
+
+  IStringArray* CreateStringArray() { return new StringArray(); }
+};
+
+
+// Synthetic tables
+
+struct TableSpec
+{
+  const char* name;
+  const char* description;
+};
+
+const TableSpec tableSpecs[] =
+{
+  { "narrow",     "integer, double and logical columns" },
+  { "wide",       "100 integer and double columns, 1/20 of the rows" },
+  { "text",       "short codes, words and long free text columns" },
+  { "factor",     "factors with 10, 1000 and 100000 levels" },
+  { "timeseries", "keyed on a timestamp, with a sensor id and measurements" }
+};
+
+
+// Random word of lowercase characters
+string Word(mt19937_64 &rng, int minLength, int maxLength)
+{
+  int length = minLength + (int) (rng() % (maxLength - minLength + 1));
+  string word(length, 'a');
+
+  for (int pos = 0; pos < length; ++pos) word[pos] = 'a' + rng() % 26;
+
+  return word;
+}
+
+
+void SetLayout(RowBatch &table, const vector<FstColumnType> &colTypes, const vector<string> &colNames,
+  unsigned long long nrOfRows)
+{
+  table.SetColumnTypes(colTypes);
+  table.nrOfRows = nrOfRows;
+  table.colNames.AllocateVec(colNames.size());
+  table.colNames.strings = colNames;
+
+  for (unsigned int colNr = 0; colNr < colTypes.size(); ++colNr)
+  {
+    switch (colTypes[colNr])
+    {
+      case FstColumnType::CHARACTER:
+        table.strings[colNr].AllocateVec(nrOfRows);
+        break;
+
+      case FstColumnType::FACTOR:
+      case FstColumnType::INT_32:
+      case FstColumnType::BOOL_32:
+        table.ints[colNr].resize(nrOfRows);
+        break;
+
+      case FstColumnType::INT_64:
+        table.longs[colNr].resize(nrOfRows);
+        break;
+
+      default:
+        table.doubles[colNr].resize(nrOfRows);
+        break;
+    }
+  }
+}
+
+
+// Generate a synthetic table, returns false for an unknown table name
+bool Generate(const string &name, unsigned long long nrOfRows, RowBatch &table)
+{
+  mt19937_64 rng(2017);  // identical tables in each run
+  uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  vector<FstColumnType> colTypes;
+  vector<string> colNames;
+
+  if (name == "narrow")
+  {
+    colTypes = { FstColumnType::INT_32, FstColumnType::INT_32, FstColumnType::DOUBLE_64, FstColumnType::DOUBLE_64,
+      FstColumnType::BOOL_32 };
+    colNames = { "Id", "Count", "Price", "Value", "Flag" };
+    SetLayout(table, colTypes, colNames, nrOfRows);
+
+    for (unsigned long long row = 0; row < nrOfRows; ++row)
+    {
+      table.ints[0][row] = (int) row;
+      table.ints[1][row] = rng() % 10 == 0 ? INT_MIN : (int) (rng() % 1000);
+      table.doubles[2][row] = round(100000 * uniform(rng)) / 100;
+      table.doubles[3][row] = uniform(rng);
+      table.ints[4][row] = rng() % 2;
+    }
+
+    return true;
+  }
+
+  if (name == "wide")
+  {
+    nrOfRows = max(nrOfRows / 20, 1ULL);
+
+    for (int colNr = 0; colNr < 100; ++colNr)
+    {
+      colTypes.push_back(colNr % 2 == 0 ? FstColumnType::INT_32 : FstColumnType::DOUBLE_64);
+      colNames.push_back("X" + to_string(colNr + 1));
+    }
+
+    SetLayout(table, colTypes, colNames, nrOfRows);
+
+    for (int colNr = 0; colNr < 100; ++colNr)
+    {
+      int range = 10 << (colNr % 20);  // from low to high cardinality
+
+      for (unsigned long long row = 0; row < nrOfRows; ++row)
+      {
+        if (colNr % 2 == 0) table.ints[colNr][row] = (int) (rng() % range);
+        else table.doubles[colNr][row] = range * uniform(rng);
+      }
+    }
+
+    return true;
+  }
+
+  if (name == "text")
+  {
+    colTypes = { FstColumnType::CHARACTER, FstColumnType::CHARACTER, FstColumnType::CHARACTER,
+      FstColumnType::INT_32 };
+    colNames = { "Code", "Word", "Text", "Nr" };
+    SetLayout(table, colTypes, colNames, nrOfRows);
+
+    vector<string> words(10000);
+    for (vector<string>::iterator word = words.begin(); word != words.end(); ++word) *word = Word(rng, 3, 12);
+
+    for (unsigned long long row = 0; row < nrOfRows; ++row)
+    {
+      table.strings[0].strings[row] = "C" + to_string(rng() % 100000);
+
+      if (rng() % 20 == 0) table.strings[1].isNA[row] = 1;
+      else table.strings[1].strings[row] = words[rng() % words.size()];
+
+      string &text = table.strings[2].strings[row];
+      int nrOfWords = 5 + (int) (rng() % 20);
+      for (int wordNr = 0; wordNr < nrOfWords; ++wordNr)
+      {
+        if (wordNr > 0) text += ' ';
+        text += words[rng() % words.size()];
+      }
+
+      table.ints[3][row] = (int) row;
+    }
+
+    return true;
+  }
+
+  if (name == "factor")
+  {
+    int nrOfLevels[] = { 10, 1000, 100000 };
+
+    for (int colNr = 0; colNr < 3; ++colNr)
+    {
+      colTypes.push_back(FstColumnType::FACTOR);
+      colNames.push_back("Factor" + to_string(nrOfLevels[colNr]));
+    }
+
+    SetLayout(table, colTypes, colNames, nrOfRows);
+
+    for (int colNr = 0; colNr < 3; ++colNr)
+    {
+      StringVectorColumn &levels = table.strings[colNr];
+      levels.AllocateVec(nrOfLevels[colNr]);
+      for (int level = 0; level < nrOfLevels[colNr]; ++level) levels.strings[level] = "L" + to_string(level + 1);
+
+      for (unsigned long long row = 0; row < nrOfRows; ++row)
+      {
+        table.ints[colNr][row] = rng() % 50 == 0 ? INT_MIN : 1 + (int) (rng() % nrOfLevels[colNr]);
+      }
+    }
+
+    return true;
+  }
+
+  if (name == "timeseries")
+  {
+    colTypes = { FstColumnType::TIMESTAMP_SECONDS, FstColumnType::INT_64, FstColumnType::DOUBLE_64,
+      FstColumnType::DOUBLE_64, FstColumnType::INT_32 };
+    colNames = { "Time", "Sensor", "Temperature", "Pressure", "Status" };
+    SetLayout(table, colTypes, colNames, nrOfRows);
+    table.keyColPos = { 0 };
+
+    double time = 1500000000;
+    double temperature = 20;
+
+    for (unsigned long long row = 0; row < nrOfRows; ++row)
+    {
+      time += (double) (rng() % 1000) / 100;  // sorted, centiseconds
+      temperature += uniform(rng) - 0.5;
+
+      table.doubles[0][row] = time;
+      table.longs[1][row] = 1000000000000LL + (long long) (rng() % 500);
+      table.doubles[2][row] = round(10 * temperature) / 10;
+      table.doubles[3][row] = 1000 + round(100 * uniform(rng)) / 100;
+      table.ints[4][row] = rng() % 100 == 0 ? 1 : 0;
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+
+// Size in bytes of the in-memory column data of rows [firstRow, endRow) of a column
+unsigned long long ColumnBytes(RowBatch &table, int colNr, unsigned long long firstRow, unsigned long long endRow)
+{
+  switch (table.colTypes[colNr])
+  {
+    case FstColumnType::CHARACTER:
+    {
+      unsigned long long nrOfBytes = 0;
+      StringVectorColumn &column = table.strings[colNr];
+
+      for (unsigned long long row = firstRow; row < endRow; ++row) nrOfBytes += 8 + column.strings[row].size();
+
+      return nrOfBytes;  // an 8-byte pointer and the characters of each string
+    }
+
+    case FstColumnType::FACTOR:
+    case FstColumnType::INT_32:
+    case FstColumnType::BOOL_32:
+      return 4 * (endRow - firstRow);
+
+    default:
+      return 8 * (endRow - firstRow);
+  }
+}
+
+
+// Measurements
+
+double CpuSeconds()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+
+// Reset the peak resident set size of the process (Linux 4.0 and later)
+void ResetPeakMemory()
+{
+  FILE* clearRefs = fopen("/proc/self/clear_refs", "w");
+  if (clearRefs == nullptr) return;
+
+  fputs("5", clearRefs);
+  fclose(clearRefs);
+}
+
+
+// Peak resident set size in MB since the last reset
+double PeakMemoryMB()
+{
+  FILE* status = fopen("/proc/self/status", "r");
+
+  if (status != nullptr)
+  {
+    char line[256];
+
+    while (fgets(line, sizeof(line), status) != nullptr)
+    {
+      if (strncmp(line, "VmHWM:", 6) == 0)
+      {
+        fclose(status);
+        return atof(&line[6]) / 1024;  // kB
+      }
+    }
+
+    fclose(status);
+  }
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  return usage.ru_maxrss / 1024.0;  // kB on Linux, no reset
+}
+
+
+// Evict the pages of a file from the page cache, and the complete page cache if requested and permitted
+void EvictFile(const string &fileName, bool dropCaches)
+{
+  int fd = open(fileName.c_str(), O_RDONLY);
+
+  if (fd >= 0)
+  {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+
+  if (!dropCaches) return;
+
+  sync();
+  FILE* dropFile = fopen("/proc/sys/vm/drop_caches", "w");
+
+  if (dropFile == nullptr)
+  {
+    static bool warned = false;
+    if (!warned) fprintf(stderr, "The page cache can't be dropped (requires root), only the file is evicted.\n");
+    warned = true;
+    return;
+  }
+
+  fputs("3", dropFile);
+  fclose(dropFile);
+}
+
+
+struct Result
+{
+  double seconds;
+  double cpuSeconds;
+  double peakMemoryMB;
+};
+
+
+// Run an operation repeats times, returns the fastest run. A cold run evicts the file before each repeat.
+template<typename Operation>
+Result Measure(Operation operation, int repeats, bool cold, const string &fileName, bool dropCaches)
+{
+  Result best = { 1e100, 0, 0 };
+
+  for (int repeat = 0; repeat < repeats; ++repeat)
+  {
+    if (cold) EvictFile(fileName, dropCaches);
+
+    ResetPeakMemory();
+    double cpuStart = CpuSeconds();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    operation();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (seconds < best.seconds)
+    {
+      best.seconds = seconds;
+      best.cpuSeconds = CpuSeconds() - cpuStart;
+      best.peakMemoryMB = PeakMemoryMB();
+    }
+  }
+
+  return best;
+}
+
+
+void Report(const string &table, RowBatch &data, double fileMB, int compress, int nrOfThreads, const char* operation,
+  const char* cache, double rawMB, const Result &result)
+{
+  printf("%s,%llu,%u,%.2f,%.2f,%d,%d,%s,%s,%.4f,%.1f,%.4f,%.1f\n", table.c_str(), data.nrOfRows, data.NrOfColumns(),
+    rawMB, fileMB, compress, nrOfThreads, operation, cache, result.seconds, rawMB / result.seconds, result.cpuSeconds,
+    result.peakMemoryMB);
+
+  fflush(stdout);
+}
+
+
+// Read rows [firstRow, endRow) of the selected columns (all columns if empty)
+void Read(const string &fileName, RowBatch &data, const vector<int> &columns, unsigned long long firstRow,
+  unsigned long long endRow, int nrOfThreads)
+{
+  vector<FstColumnType> colTypes;
+  StringArray selection;
+
+  for (vector<int>::const_iterator colNr = columns.begin(); colNr != columns.end(); ++colNr)
+  {
+    colTypes.push_back(data.colTypes[*colNr]);
+    selection.strings.push_back(data.colNames.strings[*colNr]);
+  }
+
+  ReadBatch result(columns.empty() ? data.colTypes : colTypes);
+  StringArray selectedCols;
+  vector<int> keyIndex;
+
+  FstStore fstStore(fileName);
+  fstStore.fstRead(fileName.c_str(), result, columns.empty() ? nullptr : &selection, (long long) firstRow + 1,
+    (long long) endRow, &result, keyIndex, &selectedCols, nrOfThreads, false);
+
+  if (result.nrOfRows != endRow - firstRow) throw(runtime_error("Incorrect number of rows read."));
+}
+
+
+vector<string> ParseList(const char* arg)
+{
+  vector<string> values;
+  string list(arg);
+  size_t start = 0;
+
+  while (start <= list.size())
+  {
+    size_t end = list.find(',', start);
+    if (end == string::npos) end = list.size();
+
+    values.push_back(list.substr(start, end - start));
+    start = end + 1;
+  }
+
+  return values;
+}
+
+
+vector<int> ParseNumbers(const char* arg)
+{
+  vector<int> numbers;
+  vector<string> values = ParseList(arg);
+
+  for (vector<string>::iterator value = values.begin(); value != values.end(); ++value)
+  {
+    numbers.push_back(atoi(value->c_str()));
+  }
+
+  return numbers;
+}
+
+
+int Usage()
+{
+  fprintf(stderr, "Usage: tablebench [--rows 1000000,10000000] [--tables narrow,wide,text,factor,timeseries] "
+    "[--levels 0,50,100] [--threads 1,8] [--repeats 3] [--dir path] [--drop-caches]\n");
+
+  return 1;
+}
+
+
+int main(int argc, char* argv[])
+{
+  vector<unsigned long long> rowCounts = { 1000000 };
+  vector<string> tables;
+  vector<int> levels = { 0, 50, 100 };
+  vector<int> threads = { 1, omp_get_num_procs() };
+  int repeats = 3;
+  string dir = ".";
+  bool dropCaches = false;
+
+  for (const TableSpec &spec : tableSpecs) tables.push_back(spec.name);
+
+  for (int argNr = 1; argNr < argc; ++argNr)
+  {
+    string option(argv[argNr]);
+
+    if (option == "--drop-caches")
+    {
+      dropCaches = true;
+      continue;
+    }
+
+    if (argNr + 1 == argc) return Usage();
+    const char* value = argv[++argNr];
+
+    if (option == "--rows")
+    {
+      rowCounts.clear();
+      vector<string> values = ParseList(value);
+      for (vector<string>::iterator count = values.begin(); count != values.end(); ++count)
+      {
+        rowCounts.push_back(strtoull(count->c_str(), nullptr, 10));
+      }
+    }
+    else if (option == "--tables") tables = ParseList(value);
+    else if (option == "--levels") levels = ParseNumbers(value);
+    else if (option == "--threads") threads = ParseNumbers(value);
+    else if (option == "--repeats") repeats = atoi(value);
+    else if (option == "--dir") dir = value;
+    else return Usage();
+  }
+
+  if (repeats < 1) return Usage();
+
+  for (vector<int>::iterator level = levels.begin(); level != levels.end(); ++level)
+  {
+    if (*level < 0 || *level > 100) return Usage();
+  }
+
+  for (vector<int>::iterator nrOfThreads = threads.begin(); nrOfThreads != threads.end(); ++nrOfThreads)
+  {
+    if (*nrOfThreads < 1) return Usage();
+  }
+
+  for (vector<string>::iterator table = tables.begin(); table != tables.end(); ++table)
+  {
+    bool known = false;
+    for (const TableSpec &spec : tableSpecs) known = known || *table == spec.name;
+
+    if (!known)
+    {
+      fprintf(stderr, "Unknown table '%s'.\n", table->c_str());
+      return Usage();
+    }
+  }
+
+  string fileName = dir + "/tablebench.fst";
+
+  printf("table,rows,columns,raw_mb,file_mb,compress,threads,operation,cache,seconds,mb_per_s,cpu_seconds,"
+    "peak_rss_mb\n");
+
+  try
+  {
+    for (vector<string>::iterator table = tables.begin(); table != tables.end(); ++table)
+    {
+      for (vector<unsigned long long>::iterator nrOfRows = rowCounts.begin(); nrOfRows != rowCounts.end(); ++nrOfRows)
+      {
+        RowBatch data(vector<FstColumnType>{});
+
+        Generate(*table, *nrOfRows, data);
+
+        unsigned long long rows = data.nrOfRows;
+        int nrOfCols = (int) data.NrOfColumns();
+
+        // Middle tenth of the rows and the first half of the columns
+        unsigned long long rangeStart = rows / 2 - rows / 20;
+        unsigned long long rangeEnd = rangeStart + max(rows / 10, 1ULL);
+        vector<int> subset;
+        for (int colNr = 0; colNr < max(nrOfCols / 2, 1); ++colNr) subset.push_back(colNr);
+
+        double fullMB = 0, rangeMB = 0, subsetMB = 0;
+
+        for (int colNr = 0; colNr < nrOfCols; ++colNr)
+        {
+          fullMB += ColumnBytes(data, colNr, 0, rows) / 1e6;
+          rangeMB += ColumnBytes(data, colNr, rangeStart, rangeEnd) / 1e6;
+          if (colNr < (int) subset.size()) subsetMB += ColumnBytes(data, colNr, 0, rows) / 1e6;
+        }
+
+        for (vector<int>::iterator level = levels.begin(); level != levels.end(); ++level)
+        {
+          for (vector<int>::iterator nrOfThreads = threads.begin(); nrOfThreads != threads.end(); ++nrOfThreads)
+          {
+            int compress = *level;
+            int threadCount = *nrOfThreads;
+
+            Result write = Measure([&]()
+            {
+              FstStore fstStore(fileName);
+              fstStore.fstWrite(fileName.c_str(), data, compress, threadCount, 0);
+            }, repeats, false, fileName, false);
+
+            FILE* file = fopen(fileName.c_str(), "rb");
+            fseek(file, 0, SEEK_END);
+            double fileMB = ftell(file) / 1e6;
+            fclose(file);
+
+            Report(*table, data, fileMB, compress, threadCount, "write", "hot", fullMB, write);
+
+            vector<int> allColumns;
+
+            for (int cold = 1; cold >= 0; --cold)
+            {
+              const char* cache = cold ? "cold" : "hot";
+
+              if (!cold) Read(fileName, data, allColumns, 0, rows, threadCount);  // warm the page cache
+
+              Result read = Measure([&]() { Read(fileName, data, allColumns, 0, rows, threadCount); }, repeats,
+                cold != 0, fileName, dropCaches);
+              Report(*table, data, fileMB, compress, threadCount, "read_full", cache, fullMB, read);
+
+              read = Measure([&]() { Read(fileName, data, allColumns, rangeStart, rangeEnd, threadCount); },
+                repeats, cold != 0, fileName, dropCaches);
+              Report(*table, data, fileMB, compress, threadCount, "read_range", cache, rangeMB, read);
+
+              read = Measure([&]() { Read(fileName, data, subset, 0, rows, threadCount); }, repeats, cold != 0,
+                fileName, dropCaches);
+              Report(*table, data, fileMB, compress, threadCount, "read_columns", cache, subsetMB, read);
+            }
+          }
+        }
+      }
+    }
+  }
+  catch (const std::runtime_error &e)
+  {
+    fprintf(stderr, "%s\n", e.what());
+    remove(fileName.c_str());
+    return 1;
+  }
+
+  remove(fileName.c_str());
+
+  return 0;
+}
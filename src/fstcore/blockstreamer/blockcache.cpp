@@ -0,0 +1,435 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#include <fstdefines.h>
+#include "blockcache.h"
+
+
+using namespace std;
+
+
+// File selected for caching on the current thread
+static thread_local unsigned long long activeFileId = 0;
+
+
+BlockCache::BlockCache()
+{
+  stats.budget = 0;
+  stats.size = 0;
+  stats.blocks = 0;
+  stats.hits = 0;
+  stats.misses = 0;
+  lastFileId = 0;
+}
+
+
+BlockCache &BlockCache::Global()
+{
+  static BlockCache blockCache;
+
+  return blockCache;
+}
+
+
+// Release the least recently used blocks until the cached data fits the budget
+void BlockCache::Evict()
+{
+  while (stats.size > stats.budget)
+  {
+    Entry &entry = entries.back();
+    stats.size -= entry.second->size();
+    --stats.blocks;
+
+    index.erase(entry.first);
+    entries.pop_back();
+  }
+}
+
+
+void BlockCache::SetBudget(unsigned long long budget)
+{
+#pragma omp critical (block_cache)
+  {
+    stats.budget = budget;
+    Evict();
+  }
+}
+
+
+bool BlockCache::Enabled()
+{
+  bool enabled;
+
+#pragma omp critical (block_cache)
+  enabled = stats.budget > 0;
+
+  return enabled;
+}
+
+
+BlockCacheStats BlockCache::Stats()
+{
+  BlockCacheStats curStats;
+
+#pragma omp critical (block_cache)
+  curStats = stats;
+
+  return curStats;
+}
+
+
+void BlockCache::ResetStats()
+{
+#pragma omp critical (block_cache)
+  {
+    stats.hits = 0;
+    stats.misses = 0;
+  }
+}
+
+
+unsigned long long BlockCache::NewFile()
+{
+  unsigned long long fileId;
+
+#pragma omp critical (block_cache)
+  fileId = ++lastFileId;
+
+  return fileId;
+}
+
+
+void BlockCache::ReleaseFile(unsigned long long fileId)
+{
+#pragma omp critical (block_cache)
+  {
+    for (list<Entry>::iterator entry = entries.begin(); entry != entries.end();)
+    {
+      if (entry->first.fileId != fileId)
+      {
+        ++entry;
+        continue;
+      }
+
+      stats.size -= entry->second->size();
+      --stats.blocks;
+
+      index.erase(entry->first);
+      entry = entries.erase(entry);
+    }
+  }
+}
+
+
+BlockCache::Block BlockCache::Find(const BlockCacheKey &key)
+{
+  Block block;
+
+#pragma omp critical (block_cache)
+  {
+    unordered_map<BlockCacheKey, list<Entry>::iterator, BlockCacheKeyHash>::iterator pos = index.find(key);
+
+    if (pos == index.end())
+    {
+      ++stats.misses;
+    }
+    else
+    {
+      ++stats.hits;
+      entries.splice(entries.begin(), entries, pos->second);  // most recently used
+      block = pos->second->second;
+    }
+  }
+
+  return block;
+}
+
+
+void BlockCache::Insert(const BlockCacheKey &key, const Block &block)
+{
+#pragma omp critical (block_cache)
+  {
+    // Large blocks would release a large part of the cache
+    if (block->size() <= stats.budget / 4 && index.find(key) == index.end())
+    {
+      entries.push_front(Entry(key, block));
+      index[key] = entries.begin();
+
+      stats.size += block->size();
+      ++stats.blocks;
+
+      Evict();
+    }
+  }
+}
+
+
+// States of the slots of the shared block cache
+#define SLOT_EMPTY   0
+#define SLOT_CLAIMED 1  // being filled by a process
+#define SLOT_READY   2
+
+
+struct SharedCacheHeader
+{
+  unsigned long long dataSize;   // bytes of shared memory for block data
+  unsigned long long nrOfSlots;  // number of slots of the block index, a power of two
+  atomic<unsigned long long> dataUsed;
+  atomic<unsigned long long> blocks;
+  atomic<unsigned long long> hits;
+  atomic<unsigned long long> misses;
+};
+
+
+struct SharedFileSlot
+{
+  atomic<unsigned int> state;
+  FstFileIdentity identity;
+};
+
+
+struct SharedBlockSlot
+{
+  atomic<unsigned int> state;
+  BlockCacheKey key;
+  unsigned long long dataPos;  // position of the block data in the data section
+  unsigned long long size;
+};
+
+
+inline unsigned long long MixHash(unsigned long long hash, unsigned long long value)
+{
+  hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+
+  return hash * 0xff51afd7ed558ccdULL;
+}
+
+
+SharedBlockCache &SharedBlockCache::Global()
+{
+  static SharedBlockCache sharedCache;
+
+  return sharedCache;
+}
+
+
+bool SharedBlockCache::Create(unsigned long long size)
+{
+#ifdef _WIN32
+  return size == 0;
+#else
+  // Forked processes keep their mapping of the previous cache
+  if (region != nullptr) munmap(region, regionSize);
+
+  region = nullptr;
+  regionSize = 0;
+
+  if (size == 0) return true;
+
+  // The atomic slot states are shared between processes
+  atomic<unsigned long long> test(0);
+  if (!test.is_lock_free()) return false;
+
+  unsigned long long nrOfSlots = 1024;
+  while (nrOfSlots < size / SHARED_CACHE_SLOT) nrOfSlots *= 2;
+
+  unsigned long long filesPos = (sizeof(SharedCacheHeader) + 63) & ~63ULL;
+  unsigned long long slotsPos = filesPos + SHARED_CACHE_FILES * sizeof(SharedFileSlot);
+  unsigned long long dataPos = (slotsPos + nrOfSlots * sizeof(SharedBlockSlot) + 63) & ~63ULL;
+
+  // An anonymous shared mapping is zero filled and shared with the processes that are forked later
+  void* memory = mmap(nullptr, dataPos + size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) return false;
+
+  region = static_cast<char*>(memory);
+  regionSize = dataPos + size;
+  header = reinterpret_cast<SharedCacheHeader*>(region);
+  files = reinterpret_cast<SharedFileSlot*>(region + filesPos);
+  slots = reinterpret_cast<SharedBlockSlot*>(region + slotsPos);
+  data = region + dataPos;
+
+  header->dataSize = size;
+  header->nrOfSlots = nrOfSlots;
+
+  return true;
+#endif
+}
+
+
+SharedBlockCacheStats SharedBlockCache::Stats()
+{
+  SharedBlockCacheStats stats = { 0, 0, 0, 0, 0 };
+
+  if (region == nullptr) return stats;
+
+  stats.size = header->dataSize;
+  stats.used = min(header->dataUsed.load(memory_order_relaxed), header->dataSize);
+  stats.blocks = header->blocks.load(memory_order_relaxed);
+  stats.hits = header->hits.load(memory_order_relaxed);
+  stats.misses = header->misses.load(memory_order_relaxed);
+
+  return stats;
+}
+
+
+unsigned long long SharedBlockCache::FileNr(const FstFileIdentity &identity)
+{
+  if (region == nullptr) return 0;
+
+  unsigned long long hash = MixHash(MixHash(MixHash(identity.device, identity.inode), identity.size),
+    identity.modified);
+
+  for (unsigned long long probe = 0; probe < SHARED_CACHE_PROBES; ++probe)
+  {
+    unsigned long long slotNr = (hash + probe) % SHARED_CACHE_FILES;
+    SharedFileSlot &slot = files[slotNr];
+    unsigned int state = slot.state.load(memory_order_acquire);
+
+    if (state == SLOT_EMPTY)
+    {
+      if (!slot.state.compare_exchange_strong(state, SLOT_CLAIMED, memory_order_acq_rel))
+      {
+        // Claimed by another process, which may add the same file
+        if (state != SLOT_READY) continue;
+      }
+      else
+      {
+        slot.identity = identity;
+        slot.state.store(SLOT_READY, memory_order_release);
+
+        return slotNr + 1;
+      }
+    }
+
+    if (state == SLOT_READY && slot.identity == identity) return slotNr + 1;
+  }
+
+  return 0;
+}
+
+
+const char* SharedBlockCache::Find(const BlockCacheKey &key, unsigned long long size)
+{
+  unsigned long long hash = BlockCacheKeyHash()(key);
+
+  for (unsigned long long probe = 0; probe < SHARED_CACHE_PROBES; ++probe)
+  {
+    SharedBlockSlot &slot = slots[(hash + probe) & (header->nrOfSlots - 1)];
+    unsigned int state = slot.state.load(memory_order_acquire);
+
+    if (state == SLOT_EMPTY) break;
+
+    if (state == SLOT_READY && slot.key == key && slot.size == size)
+    {
+      header->hits.fetch_add(1, memory_order_relaxed);
+      return data + slot.dataPos;
+    }
+  }
+
+  header->misses.fetch_add(1, memory_order_relaxed);
+
+  return nullptr;
+}
+
+
+void SharedBlockCache::Insert(const BlockCacheKey &key, const char* block, unsigned long long size)
+{
+  // Large blocks would fill a large part of the cache
+  if (size > header->dataSize / 4) return;
+
+  unsigned long long hash = BlockCacheKeyHash()(key);
+
+  for (unsigned long long probe = 0; probe < SHARED_CACHE_PROBES; ++probe)
+  {
+    SharedBlockSlot &slot = slots[(hash + probe) & (header->nrOfSlots - 1)];
+    unsigned int state = slot.state.load(memory_order_acquire);
+
+    if (state == SLOT_READY && slot.key == key) return;  // added by another process
+
+    if (state != SLOT_EMPTY || !slot.state.compare_exchange_strong(state, SLOT_CLAIMED, memory_order_acq_rel))
+    {
+      if (state == SLOT_READY && slot.key == key) return;
+      continue;
+    }
+
+    // The claimed slot stays claimed (and is skipped) when the shared memory is full
+    unsigned long long dataPos = header->dataUsed.fetch_add((size + 7) & ~7ULL, memory_order_relaxed);
+    if (dataPos + size > header->dataSize) return;
+
+    slot.key = key;
+    slot.dataPos = dataPos;
+    slot.size = size;
+    memcpy(data + dataPos, block, size);
+
+    slot.state.store(SLOT_READY, memory_order_release);
+    header->blocks.fetch_add(1, memory_order_relaxed);
+
+    return;
+  }
+}
+
+
+BlockCacheScope::BlockCacheScope(unsigned long long fileId)
+{
+  previous = activeFileId;
+  activeFileId = fileId;
+}
+
+
+BlockCacheScope::~BlockCacheScope()
+{
+  activeFileId = previous;
+}
+
+
+unsigned long long BlockCacheScope::ActiveFile()
+{
+  if (activeFileId == 0) return 0;
+
+  if ((activeFileId & SHARED_CACHE_FILE) != 0) return SharedBlockCache::Global().Enabled() ? activeFileId : 0;
+
+  if (!BlockCache::Global().Enabled()) return 0;
+
+  return activeFileId;
+}
@@ -0,0 +1,280 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <ifstio.h>
+
+
+#define SHARED_CACHE_FILE 0x8000000000000000ULL  // flag of a file identity of the shared block cache (see BlockCacheScope)
+
+
+/**
+ Statistics of the block cache.
+ */
+struct BlockCacheStats
+{
+  unsigned long long budget;  // maximum number of bytes of cached block data
+  unsigned long long size;    // bytes of cached block data
+  unsigned long long blocks;  // number of cached blocks
+  unsigned long long hits;    // number of blocks served from the cache
+  unsigned long long misses;  // number of blocks read and decompressed
+};
+
+
+/**
+ Identifies a decompressed block: the data block blockNr of the column data stored at file position colPos of
+ the file with identity fileId (see BlockCache::NewFile).
+ */
+struct BlockCacheKey
+{
+  unsigned long long fileId;
+  unsigned long long colPos;
+  unsigned long long blockNr;
+
+  bool operator==(const BlockCacheKey &other) const
+  {
+    return fileId == other.fileId && colPos == other.colPos && blockNr == other.blockNr;
+  }
+};
+
+
+struct BlockCacheKeyHash
+{
+  size_t operator()(const BlockCacheKey &key) const
+  {
+    unsigned long long hash = key.fileId * 0x9e3779b97f4a7c15ULL;
+    hash ^= key.colPos + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    hash ^= key.blockNr + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+
+    return (size_t) hash;
+  }
+};
+
+
+/**
+ Process-wide cache of decompressed data blocks, used by the reads through an open handle (FstHandle). Repeated
+ reads of overlapping row ranges then decompress each block (including the partially read first and last blocks)
+ only once. The least recently used blocks are released when the cached data exceeds the memory budget. The cache
+ is disabled with a budget of zero bytes (the default).
+
+ Each opened file receives a unique identity, so blocks are never shared between different files or between
+ different versions of a file. The blocks of a file are released when the file is closed (see ReleaseFile).
+
+ All methods can be used concurrently from multiple threads. Cached blocks are shared and should not be modified.
+ */
+class BlockCache
+{
+  typedef std::shared_ptr<std::vector<char>> Block;
+  typedef std::pair<BlockCacheKey, Block> Entry;
+
+  std::list<Entry> entries;  // most recently used first
+  std::unordered_map<BlockCacheKey, std::list<Entry>::iterator, BlockCacheKeyHash> index;
+  BlockCacheStats stats;
+  unsigned long long lastFileId;
+
+  BlockCache();
+
+  void Evict();
+
+public:
+  /**
+   The process-wide block cache.
+   */
+  static BlockCache &Global();
+
+  /**
+   Set the maximum number of bytes of cached block data, cached blocks are released if required. A budget of zero
+   disables the cache.
+   */
+  void SetBudget(unsigned long long budget);
+
+  /**
+   Whether blocks are cached (the budget is larger than zero).
+   */
+  bool Enabled();
+
+  /**
+   Current statistics of the cache.
+   */
+  BlockCacheStats Stats();
+
+  /**
+   Reset the hit and miss counts of the cache statistics.
+   */
+  void ResetStats();
+
+  /**
+   A unique identity for a newly opened file.
+   */
+  unsigned long long NewFile();
+
+  /**
+   Release the cached blocks of a file.
+   */
+  void ReleaseFile(unsigned long long fileId);
+
+  /**
+   Find a decompressed block, which is then marked as the most recently used block. The hit and miss counts are
+   updated.
+
+   @return The block data or an empty pointer if the block isn't cached.
+   */
+  Block Find(const BlockCacheKey &key);
+
+  /**
+   Add a decompressed block. Blocks larger than a quarter of the budget are not cached.
+   */
+  void Insert(const BlockCacheKey &key, const Block &block);
+};
+
+
+/**
+ Statistics of the shared block cache, counted over all processes that use the cache.
+ */
+struct SharedBlockCacheStats
+{
+  unsigned long long size;    // size of the shared memory for block data in bytes
+  unsigned long long used;    // bytes of cached block data
+  unsigned long long blocks;  // number of cached blocks
+  unsigned long long hits;    // number of blocks served from the cache
+  unsigned long long misses;  // number of blocks read and decompressed
+};
+
+
+struct SharedCacheHeader;
+struct SharedFileSlot;
+struct SharedBlockSlot;
+
+
+/**
+ Cache of decompressed data blocks in shared memory, for the processes that are forked from the process that
+ created the cache (such as the workers of parallel::mclapply). The first process that decompresses a block
+ publishes it in the cache, the other processes copy the decompressed data from the shared memory. Files are
+ identified by their device, inode, size and modification time (see FstFileIdentity), so all processes share the
+ blocks of a file. Blocks are never released: when the shared memory is full, new blocks are not cached. The cache
+ is only available on systems that fork processes and is disabled by default.
+
+ The index of the cache is an open addressing hash table. A process adds a block by claiming an empty slot with a
+ compare-and-swap, filling it and then publishing it. Slots that are being filled are skipped, so processes never
+ wait for each other. All methods can be used concurrently from multiple threads and processes. Cached blocks
+ should not be modified.
+ */
+class SharedBlockCache
+{
+  char* region;  // shared memory, nullptr if the cache is disabled
+  unsigned long long regionSize;
+  SharedCacheHeader* header;
+  SharedFileSlot* files;
+  SharedBlockSlot* slots;
+  char* data;
+
+  SharedBlockCache() : region(nullptr), regionSize(0), header(nullptr), files(nullptr), slots(nullptr),
+    data(nullptr) {}
+
+public:
+  /**
+   The shared block cache of the process, inherited by forked processes.
+   */
+  static SharedBlockCache &Global();
+
+  /**
+   Replace the cache of this process by a new cache with size bytes of shared memory for block data. Processes that
+   were forked earlier keep using the previous cache. A size of zero disables the cache.
+
+   @return false if shared memory is not available on this system.
+   */
+  bool Create(unsigned long long size);
+
+  /**
+   Whether blocks are cached.
+   */
+  bool Enabled() const { return region != nullptr; }
+
+  /**
+   Current statistics of the cache.
+   */
+  SharedBlockCacheStats Stats();
+
+  /**
+   The number of a file in the cache, used in the keys of its blocks. The file is added if required.
+
+   @return The file number (larger than zero) or zero if the cache is disabled or has no free file slot.
+   */
+  unsigned long long FileNr(const FstFileIdentity &identity);
+
+  /**
+   Find a decompressed block of size bytes. The hit and miss counts are updated.
+
+   @return The block data or nullptr if the block isn't cached.
+   */
+  const char* Find(const BlockCacheKey &key, unsigned long long size);
+
+  /**
+   Add a decompressed block. Blocks larger than a quarter of the shared memory are not cached.
+   */
+  void Insert(const BlockCacheKey &key, const char* block, unsigned long long size);
+};
+
+
+/**
+ Selects the file of which the blocks are cached in the reads on the current thread, during the lifetime of the
+ scope. Reads outside a scope (or with a fileId of zero) don't use the cache. Identities with the SHARED_CACHE_FILE
+ flag select the file with that number in the shared block cache.
+ */
+class BlockCacheScope
+{
+  unsigned long long previous;
+
+public:
+  BlockCacheScope(unsigned long long fileId);
+
+  ~BlockCacheScope();
+
+  /**
+   The file selected on the current thread, zero if blocks aren't cached.
+   */
+  static unsigned long long ActiveFile();
+};
+
+
+#endif  // BLOCK_CACHE_H
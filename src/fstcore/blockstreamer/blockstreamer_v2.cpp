@@ -37,10 +37,16 @@ You can contact the author at :
 // System libraries
 #include <fstream>
 #include <cstring>
+#include <algorithm>
+#include <vector>
 
 // External libraries
 #include <compression.h>
 #include <compressor.h>
+#include <zonemap.h>
+#include "scratchbuffer.h"
+#include "blockcache.h"
+#include "profile.h"
 
 
 #define COL_META_SIZE 8
@@ -49,16 +55,17 @@ You can contact the author at :
 #define MAX_COMPRESSBOUND_PLUS_META_SIZE 17044
 #define BLOCK_ALGO_MASK 0xffff000000000000
 #define BLOCK_POS_MASK 0x0000ffffffffffff
+#define BLOCK_BATCH_SIZE 16  // number of blocks per thread compressed in a single parallel batch
 
 
 using namespace std;
 
 
-inline unsigned long long CompressBlock_v2(StreamCompressor* streamCompressor, ofstream &myfile, char* vecP, char* compBuf, char* blockIndex,
+inline unsigned long long CompressBlock_v2(StreamCompressor* streamCompressor, ostream &myfile, char* vecP, char* compBuf, char* blockIndex,
   int block, unsigned long long blockIndexPos, unsigned int *maxCompSize, int sourceBlockSize)
 {
   // 1 long file pointer and 1 short algorithmID per block
-  unsigned long long* blockPosition = reinterpret_cast<unsigned long long*>(&blockIndex[COL_META_SIZE + block * 8]);
+  unsigned long long* blockPosition = reinterpret_cast<unsigned long long*>(&blockIndex[COL_META_SIZE + (uint64_t) block * 8]);
 
   // unsigned short blockAlgorithm = (unsigned short*) &blockIndex[COL_META_SIZE + 8 + block * 8];
 
@@ -69,19 +76,22 @@ inline unsigned long long CompressBlock_v2(StreamCompressor* streamCompressor, o
   unsigned int blockAlgorithm = static_cast<unsigned int>(compAlgo);
 
   *blockPosition = blockIndexPos | (static_cast<unsigned long long>(blockAlgorithm) << 48); // starting position and algorithm in 2 high bytes
+  ProfileBlocks(blockAlgorithm);
 
   return compSize;  // compressed block length
 }
 
 
-// Method for writing column data of any type to a ofstream.
-void fdsStreamUncompressed_v2(ofstream &myfile, char* vec, unsigned int vecLength, int elementSize, int blockSizeElems,
-  FixedRatioCompressor* fixedRatioCompressor)
+// Method for writing column data of any type to a stream.
+void fdsStreamUncompressed_v2(ostream &myfile, char* vec, unsigned long long vecLength, int elementSize, int blockSizeElems,
+  FixedRatioCompressor* fixedRatioCompressor, ZoneMap* zoneMap)
 {
-  int nrOfBlocks = 1 + (vecLength - 1) / blockSizeElems;  // number of compressed / uncompressed blocks
-  int remain = 1 + (vecLength + blockSizeElems - 1) % blockSizeElems;  // number of elements in last incomplete block
+  int nrOfBlocks = static_cast<int>(1 + (vecLength - 1) / blockSizeElems);  // number of compressed / uncompressed blocks
+  int remain = static_cast<int>(1 + (vecLength + blockSizeElems - 1) % blockSizeElems);  // number of elements in last incomplete block
   int blockSize = blockSizeElems * elementSize;
 
+  ProfileData(vecLength * elementSize);
+
   // Write uncompressed vector to disk in blocks
   --nrOfBlocks;  // Do last block later
 
@@ -95,11 +105,14 @@ void fdsStreamUncompressed_v2(ofstream &myfile, char* vec, unsigned int vecLengt
 
     for (int block = 0; block != nrOfBlocks; ++block)
     {
+      if (zoneMap != nullptr) zoneMap->AddBlock(block, &vec[blockPos], blockSizeElems);
       myfile.write(&vec[blockPos], blockSize);
       blockPos += blockSize;
     }
 
+    if (zoneMap != nullptr) zoneMap->AddBlock(nrOfBlocks, &vec[blockPos], remain);
     myfile.write(&vec[blockPos], remain * elementSize);
+    ProfileBlocks(0, nrOfBlocks + 1);
 
     return;
   }
@@ -110,7 +123,15 @@ void fdsStreamUncompressed_v2(ofstream &myfile, char* vec, unsigned int vecLengt
   int remainBlock = remain * elementSize;
   int compressBufSizeRemain = fixedRatioCompressor->CompressBufferSize(remainBlock);  // size of block
 
-  char compBuf[MAX_COMPRESSBOUND_PLUS_META_SIZE];  // meta data and compression buffer
+  char compBufStack[MAX_COMPRESSBOUND_PLUS_META_SIZE];  // meta data and compression buffer
+  char* compBuf = compBufStack;
+  vector<char> largeBlockBuf;  // buffer for blocks larger than MAX_SIZE_COMPRESS_BLOCK
+
+  if (blockSize > MAX_SIZE_COMPRESS_BLOCK)
+  {
+    largeBlockBuf.resize(fixedRatioCompressor->CompressBufferSize(blockSize) + COL_META_SIZE);
+    compBuf = largeBlockBuf.data();
+  }
 
   if (nrOfBlocks == 0)  // single block
   {
@@ -119,10 +140,13 @@ void fdsStreamUncompressed_v2(ofstream &myfile, char* vec, unsigned int vecLengt
     unsigned int *compress = reinterpret_cast<unsigned int*>(compBuf);
     compress[0] = 0;
 
+    if (zoneMap != nullptr) zoneMap->AddBlock(0, vec, remain);
+
     CompAlgo compAlgo;
     fixedRatioCompressor->Compress(&compBuf[COL_META_SIZE], compressBufSizeRemain, vec, remainBlock, compAlgo);
     compress[1] = static_cast<unsigned int>(compAlgo);  // set fixed-ratio compression algorithm
     myfile.write(compBuf, compressBufSizeRemain + COL_META_SIZE);
+    ProfileBlocks(compAlgo);
 
     return;
   }
@@ -137,6 +161,8 @@ void fdsStreamUncompressed_v2(ofstream &myfile, char* vec, unsigned int vecLengt
   unsigned int *compress = reinterpret_cast<unsigned int*>(compBuf);
   compress[0] = 0;
 
+  if (zoneMap != nullptr) zoneMap->AddBlock(0, vec, blockSizeElems);
+
   CompAlgo compAlgo;
   fixedRatioCompressor->Compress(&compBuf[COL_META_SIZE], compressBufSize, vec, blockSize, compAlgo);
   compress[1] = static_cast<unsigned int>(compAlgo);  // set fixed-ratio compression algorithm
@@ -148,6 +174,7 @@ void fdsStreamUncompressed_v2(ofstream &myfile, char* vec, unsigned int vecLengt
 
   for (int block = 1; block != nrOfBlocks; ++block)
   {
+    if (zoneMap != nullptr) zoneMap->AddBlock(block, &vec[blockPos], blockSizeElems);
     fixedRatioCompressor->Compress(compBuf, compressBufSize, &vec[blockPos], blockSize, compAlgo);
     blockPos += blockSize;
     myfile.write(compBuf, compressBufSize);
@@ -155,25 +182,122 @@ void fdsStreamUncompressed_v2(ofstream &myfile, char* vec, unsigned int vecLengt
 
   // Last block
 
+  if (zoneMap != nullptr) zoneMap->AddBlock(nrOfBlocks, &vec[blockPos], remain);
   fixedRatioCompressor->Compress(compBuf, compressBufSizeRemain, &vec[blockPos], remainBlock, compAlgo);
   myfile.write(compBuf, compressBufSizeRemain);
+  ProfileBlocks(compAlgo, nrOfBlocks + 1);
+}
+
+
+// Compress blocks in batches of BLOCK_BATCH_SIZE blocks per thread. Each block is assigned a compressor by
+// the (deterministic) selection sequence of the stream compressor before the batch is compressed. Stateful
+// compressors are run serially in block order, so the result is identical to a serial compression.
+inline unsigned long long CompressBlocksParallel_v2(StreamCompressor* streamCompressor, ostream &myfile, char* colVec,
+  char* blockIndex, int nrOfBlocks, int blockSize, int lastBlockSize, unsigned long long blockIndexPos,
+  unsigned int *maxCompSize, int nrOfThreads, int elementSize, ZoneMap* zoneMap)
+{
+  int compBufSize = streamCompressor->CompressBufferSize();  // maximum compressed block size
+  uint64_t slotSize = max(compBufSize, MAX_COMPRESSBOUND);  // compression buffer of a single block
+
+  // Large blocks use fewer blocks per batch, keeping the batch buffer at the size used for default blocks
+  int blocksPerThread = max(1, BLOCK_BATCH_SIZE * MAX_SIZE_COMPRESS_BLOCK / max(blockSize, 1));
+  int batchSize = min(BLOCK_BATCH_SIZE, blocksPerThread) * nrOfThreads;  // number of blocks per batch
+
+  char* batchBuf = ScratchBuffer(ScratchSlot::BLOCK_BATCH, batchSize * slotSize);  // compression buffers for a single batch
+  Compressor** blockCompressors = new Compressor*[batchSize];
+  int* compSizes = new int[batchSize];
+  CompAlgo* compAlgos = new CompAlgo[batchSize];
+
+  for (int batchStart = 0; batchStart < nrOfBlocks; batchStart += batchSize)
+  {
+    int nrOfBatchBlocks = min(batchSize, nrOfBlocks - batchStart);
+
+    for (int block = 0; block < nrOfBatchBlocks; ++block)
+    {
+      blockCompressors[block] = streamCompressor->NextBlockCompressor();
+    }
+
+#pragma omp parallel for schedule(dynamic) num_threads(nrOfThreads)
+    for (int block = 0; block < nrOfBatchBlocks; ++block)
+    {
+      int curBlock = batchStart + block;
+      int sourceBlockSize = curBlock == nrOfBlocks - 1 ? lastBlockSize : blockSize;
+
+      // Statistics are collected while the block is in cache for compression
+      if (zoneMap != nullptr)
+      {
+        zoneMap->AddBlock(curBlock, &colVec[(uint64_t) curBlock * blockSize], sourceBlockSize / elementSize);
+      }
+
+      Compressor* compressor = blockCompressors[block];
+      if (compressor == nullptr || !compressor->IsStateless()) continue;
+
+      compSizes[block] = compressor->Compress(&batchBuf[block * slotSize], compBufSize,
+        &colVec[(uint64_t) curBlock * blockSize], sourceBlockSize, compAlgos[block]);
+    }
+
+    // Stateful compressors and writing the compressed data
+    for (int block = 0; block < nrOfBatchBlocks; ++block)
+    {
+      Compressor* compressor = blockCompressors[block];
+      int curBlock = batchStart + block;
+      int sourceBlockSize = curBlock == nrOfBlocks - 1 ? lastBlockSize : blockSize;
+      char* blockData = &colVec[(uint64_t) curBlock * blockSize];
+
+      if (compressor == nullptr)  // uncompressed block
+      {
+        compSizes[block] = sourceBlockSize;
+        compAlgos[block] = CompAlgo::UNCOMPRESS;
+      }
+      else
+      {
+        if (!compressor->IsStateless())
+        {
+          compSizes[block] = compressor->Compress(&batchBuf[block * slotSize], compBufSize,
+            blockData, sourceBlockSize, compAlgos[block]);
+        }
+
+        blockData = &batchBuf[block * slotSize];
+      }
+
+      myfile.write(blockData, compSizes[block]);
+
+      unsigned int compSize = static_cast<unsigned int>(compSizes[block]);
+      if (compSize > *maxCompSize) *maxCompSize = compSize;
+
+      // starting position and algorithm in 2 high bytes
+      unsigned long long* blockPosition = reinterpret_cast<unsigned long long*>(&blockIndex[COL_META_SIZE + (uint64_t) curBlock * 8]);
+      *blockPosition = blockIndexPos | (static_cast<unsigned long long>(compAlgos[block]) << 48);
+      ProfileBlocks(static_cast<unsigned int>(compAlgos[block]));
+
+      blockIndexPos += compSize;
+    }
+  }
+
+  delete[] blockCompressors;
+  delete[] compSizes;
+  delete[] compAlgos;
+
+  return blockIndexPos;
 }
 
 
 // Method for writing column data of any type to a stream.
-void fdsStreamcompressed_v2(ofstream &myfile, char* colVec, unsigned int nrOfRows, int elementSize,
-  StreamCompressor* streamCompressor, int blockSizeElems)
+void fdsStreamcompressed_v2(ostream &myfile, char* colVec, unsigned long long nrOfRows, int elementSize,
+  StreamCompressor* streamCompressor, int blockSizeElems, int nrOfThreads, ZoneMap* zoneMap)
 {
-  int nrOfBlocks = 1 + (nrOfRows - 1) / blockSizeElems;  // number of compressed / uncompressed blocks
-  int remain = 1 + (nrOfRows + blockSizeElems - 1) % blockSizeElems;  // number of elements in last incomplete block
+  int nrOfBlocks = static_cast<int>(1 + (nrOfRows - 1) / blockSizeElems);  // number of compressed / uncompressed blocks
+  int remain = static_cast<int>(1 + (nrOfRows + blockSizeElems - 1) % blockSizeElems);  // number of elements in last incomplete block
   int blockSize = blockSizeElems * elementSize;
 
+  ProfileData(nrOfRows * elementSize);
+
   unsigned long long curPos = myfile.tellp();
 
   // Blocks meta information
   // Allocate a 8 bytes alligned buffer
 
-  char* blockIndex = new char[(2 + nrOfBlocks) * 8];  // 1 long file pointer with 2 highest bytes indicating algorithmID
+  char* blockIndex = ScratchBuffer(ScratchSlot::BLOCK_INDEX, (2 + (uint64_t) nrOfBlocks) * 8);  // 1 long file pointer with 2 highest bytes indicating algorithmID
 
   unsigned int* maxCompSize = reinterpret_cast<unsigned int*>(&blockIndex[0]);  // maximum uncompressed block length
   unsigned int* blockSizeElements = reinterpret_cast<unsigned int*>(&blockIndex[4]);  // number of elements per block
@@ -182,44 +306,64 @@ void fdsStreamcompressed_v2(ofstream &myfile, char* colVec, unsigned int nrOfRow
   *maxCompSize = blockSize;  // can be used later for optimization
 
   // Write block index
-  myfile.write(static_cast<char*>(blockIndex), 8 + COL_META_SIZE + nrOfBlocks * 8);
-  unsigned long long blockIndexPos = 8 + COL_META_SIZE + nrOfBlocks * 8;  // relative to the column data starting position
+  myfile.write(static_cast<char*>(blockIndex), 8 + COL_META_SIZE + (uint64_t) nrOfBlocks * 8);
+  unsigned long long blockIndexPos = 8 + COL_META_SIZE + (uint64_t) nrOfBlocks * 8;  // relative to the column data starting position
 
 
   // Compress in blocks
 
-  // int compBufSize =  streamCompressor->CompressBufferSize();  // maximum compressed block size
+  if (nrOfThreads > 1 && nrOfBlocks > 1)
+  {
+    blockIndexPos = CompressBlocksParallel_v2(streamCompressor, myfile, colVec, blockIndex, nrOfBlocks, blockSize,
+      remain * elementSize, blockIndexPos, maxCompSize, nrOfThreads, elementSize, zoneMap);
 
-  char compBuf[MAX_COMPRESSBOUND];
-  // char compBuf[compBufSize];  // buffer used during compression
+    --nrOfBlocks;  // index of last block
+  }
+  else
+  {
+    // int compBufSize =  streamCompressor->CompressBufferSize();  // maximum compressed block size
 
-  --nrOfBlocks;  // Do last block later
-  uint64_t blockPos = 0;  // position of active block
+    char compBufStack[MAX_COMPRESSBOUND];
+    // char compBuf[compBufSize];  // buffer used during compression
 
-  for (int block = 0; block < nrOfBlocks; ++block)
-  {
-    blockIndexPos += CompressBlock_v2(streamCompressor, myfile, &colVec[blockPos], compBuf, blockIndex, block, blockIndexPos, maxCompSize, blockSize);
-    blockPos += blockSize;
+    vector<char> largeBlockBuf;  // compression buffer for blocks larger than MAX_SIZE_COMPRESS_BLOCK
+    char* compBuf = compBufStack;
+
+    if (blockSize > MAX_SIZE_COMPRESS_BLOCK)
+    {
+      largeBlockBuf.resize(streamCompressor->CompressBufferSize());
+      compBuf = largeBlockBuf.data();
+    }
+
+    --nrOfBlocks;  // Do last block later
+    uint64_t blockPos = 0;  // position of active block
+
+    for (int block = 0; block < nrOfBlocks; ++block)
+    {
+      if (zoneMap != nullptr) zoneMap->AddBlock(block, &colVec[blockPos], blockSizeElems);
+      blockIndexPos += CompressBlock_v2(streamCompressor, myfile, &colVec[blockPos], compBuf, blockIndex, block, blockIndexPos, maxCompSize, blockSize);
+      blockPos += blockSize;
+    }
+
+    if (zoneMap != nullptr) zoneMap->AddBlock(nrOfBlocks, &colVec[blockPos], remain);
+    blockIndexPos += CompressBlock_v2(streamCompressor, myfile, &colVec[blockPos], compBuf, blockIndex, nrOfBlocks, blockIndexPos, maxCompSize, remain * elementSize);
   }
-  blockIndexPos += CompressBlock_v2(streamCompressor, myfile, &colVec[blockPos], compBuf, blockIndex, nrOfBlocks, blockIndexPos, maxCompSize, remain * elementSize);
 
   // Write last block position
-  unsigned long long* blockPosition = reinterpret_cast<unsigned long long*>(&blockIndex[COL_META_SIZE + 8 + nrOfBlocks * 8]);
+  unsigned long long* blockPosition = reinterpret_cast<unsigned long long*>(&blockIndex[COL_META_SIZE + 8 + (uint64_t) nrOfBlocks * 8]);
   *blockPosition = blockIndexPos;
 
   // Rewrite blockIndex
   myfile.seekp(curPos);
-  myfile.write(static_cast<char*>(blockIndex), COL_META_SIZE + 16 + nrOfBlocks * 8);
+  myfile.write(static_cast<char*>(blockIndex), COL_META_SIZE + 16 + (uint64_t) nrOfBlocks * 8);
   myfile.seekp(0, ios_base::end);
-
-  delete[] blockIndex;
 }
 
 
 // Read data compressed with a fixed ratio compressor from a stream
 // Note that repSize is assumed to be a multiple of elementSize
 inline void fdsReadFixedCompStream_v2(istream &myfile, char* outVec, unsigned long long blockPos,
-  unsigned int* meta, unsigned int startRow, int elementSize, unsigned int vecLength)
+  unsigned int* meta, unsigned long long startRow, int elementSize, unsigned long long vecLength)
 {
   unsigned int compAlgo = meta[1];  // identifier of the fixed ratio compressor
   unsigned int repSize = fixedRatioSourceRepSize[static_cast<int>(compAlgo)];  // in bytes
@@ -233,8 +377,8 @@ inline void fdsReadFixedCompStream_v2(istream &myfile, char* outVec, unsigned lo
 
   // Determine random-access starting point
   unsigned int repSizeElement = repSize / elementSize;
-  unsigned int startRep = startRow / repSizeElement;
-  unsigned int endRep = (startRow + vecLength - 1) / repSizeElement;
+  unsigned long long startRep = startRow / repSizeElement;
+  unsigned long long endRep = (startRow + vecLength - 1) / repSizeElement;
 
   Decompressor decompressor;  // decompressor
 
@@ -243,8 +387,8 @@ inline void fdsReadFixedCompStream_v2(istream &myfile, char* outVec, unsigned lo
     myfile.seekg(blockPos + COL_META_SIZE + startRep * targetRepSize);  // move to startRep
   }
 
-  unsigned int startRowRep = startRep * repSizeElement;
-  unsigned int startOffset = startRow - startRowRep;  // rep-block offset in number of elements
+  unsigned long long startRowRep = startRep * repSizeElement;
+  unsigned int startOffset = static_cast<unsigned int>(startRow - startRowRep);  // rep-block offset in number of elements
 
   char* outP = outVec;  // allow shifting of vector pointer
 
@@ -275,8 +419,8 @@ inline void fdsReadFixedCompStream_v2(istream &myfile, char* outVec, unsigned lo
 
   // Define prefered block sizes
   unsigned int nrOfRepsPerBlock = (PREF_BLOCK_SIZE / repSize);
-  unsigned int nrOfReps = 1 + endRep - startRep;  // remaining reps to read
-  unsigned int nrOfFullBlocks = (nrOfReps - 1) / nrOfRepsPerBlock;  // excluding last (partial) block
+  unsigned long long nrOfReps = 1 + endRep - startRep;  // remaining reps to read
+  unsigned long long nrOfFullBlocks = (nrOfReps - 1) / nrOfRepsPerBlock;  // excluding last (partial) block
 
   unsigned int blockSize = nrOfRepsPerBlock * repSize;  // block size in bytes
   unsigned int targetBlockSize = nrOfRepsPerBlock * targetRepSize;  // block size in bytes
@@ -287,7 +431,7 @@ inline void fdsReadFixedCompStream_v2(istream &myfile, char* outVec, unsigned lo
   if (((uintptr_t) outP % 8) == 0)  // aligned pointer
   {
     // Decompress full blocks
-    for (unsigned int block = 0; block < nrOfFullBlocks; ++block)
+    for (unsigned long long block = 0; block < nrOfFullBlocks; ++block)
     {
       myfile.read(repBuf, targetBlockSize);
       decompressor.Decompress(compAlgo, &outP[activeBlockPos], blockSize, repBuf, targetBlockSize);
@@ -299,7 +443,7 @@ inline void fdsReadFixedCompStream_v2(istream &myfile, char* outVec, unsigned lo
     char alignBuf[PREF_BLOCK_SIZE];  // alignment buffer
 
     // Decompress full blocks
-    for (unsigned int block = 0; block < nrOfFullBlocks; ++block)
+    for (unsigned long long block = 0; block < nrOfFullBlocks; ++block)
     {
       myfile.read(repBuf, targetBlockSize);
       decompressor.Decompress(compAlgo, alignBuf, blockSize, repBuf, targetBlockSize);
@@ -308,7 +452,7 @@ inline void fdsReadFixedCompStream_v2(istream &myfile, char* outVec, unsigned lo
     }
   }
 
-  unsigned int remainReps = nrOfReps - nrOfRepsPerBlock * nrOfFullBlocks;  // always > 0 including last rep unit
+  unsigned int remainReps = static_cast<unsigned int>(nrOfReps - nrOfRepsPerBlock * nrOfFullBlocks);  // always > 0 including last rep unit
 
   // Read last block
   unsigned int lastBlockSize = remainReps * repSize;  // block size in bytes
@@ -332,7 +476,7 @@ inline void fdsReadFixedCompStream_v2(istream &myfile, char* outVec, unsigned lo
 
   // Last rep unit may be partial
   char buf[MAX_SOURCE_REP_SIZE];  // single rep unit buffer
-  unsigned int nrOfElemsLastRep = startRow + vecLength - endRep * repSizeElement;
+  unsigned int nrOfElemsLastRep = static_cast<unsigned int>(startRow + vecLength - endRep * repSizeElement);
 
   decompressor.Decompress(compAlgo, buf, repSize, &repBuf[lastTargetBlockSize - targetRepSize], targetRepSize);  // decompress repetition block
   memcpy(&outP[activeBlockPos + lastBlockSize - repSize], buf, elementSize * nrOfElemsLastRep);  // skip last elements if required
@@ -340,8 +484,197 @@ inline void fdsReadFixedCompStream_v2(istream &myfile, char* outVec, unsigned lo
 
 #define UNCOMPRESSED_BLOCKSIZE 1073741824  // 1 GB default block
 
-void fdsReadColumn_v2(istream &myfile, char* outVec, unsigned long long blockPos, unsigned startRow, unsigned length, unsigned size, int elementSize)
+
+// Decompress a complete block to out. Blocks are decompressed in place when out has the alignment required by the
+// decompression routine of the algorithm (see decompAlignment), so routines that write bytes or integers fill the
+// unaligned positions that follow a partial first block of a 4-byte column directly. Otherwise the block is
+// decompressed in tmpBuf and copied.
+inline void DecompressBlock_v2(Decompressor &decompressor, unsigned int algo, char* out, unsigned int blockSize,
+  const char* compBuf, unsigned int compSize, char* tmpBuf)
 {
+  if (((uintptr_t) out % decompAlignment[algo]) == 0)
+  {
+    decompressor.Decompress(algo, out, blockSize, compBuf, compSize);
+    return;
+  }
+
+  decompressor.Decompress(algo, tmpBuf, blockSize, compBuf, compSize);
+  memcpy(out, tmpBuf, blockSize);
+}
+
+// Decompress blocks in batches of BLOCK_BATCH_SIZE blocks per thread. The compressed data of a batch is read
+// from the stream with a single read, after which each thread decompresses its blocks straight into the
+// corresponding slice of the output vector.
+inline void DecompressBlocksParallel_v2(istream &myfile, char* outVec, unsigned long long blockPos, char* blockIndex,
+  int startBlock, int endBlock, unsigned long long startRow, unsigned long long length, unsigned long long size, int elementSize,
+  unsigned int blockSizeElements, unsigned int maxCompSize, int nrOfThreads)
+{
+  uint64_t blockSize = (uint64_t) blockSizeElements * elementSize;
+  bool isLargeBlock = blockSize > MAX_SIZE_COMPRESS_BLOCK;
+  uint64_t blockBufSize = max(maxCompSize, (unsigned int) MAX_COMPRESSBOUND);  // compressed data buffer per block
+
+  // Large blocks use fewer blocks per batch, keeping the batch buffer at the size used for default blocks
+  int blocksPerThread = static_cast<int>(max((uint64_t) 1, BLOCK_BATCH_SIZE * MAX_SIZE_COMPRESS_BLOCK / blockSize));
+  int batchSize = min(BLOCK_BATCH_SIZE, blocksPerThread) * nrOfThreads;  // number of blocks in a single batch
+  int nrOfBlocks = static_cast<int>(1 + (size - 1) / blockSizeElements);
+  unsigned int lastBlockSize = static_cast<unsigned int>(1 + (size + blockSizeElements - 1) % blockSizeElements);  // smaller last block size
+  uint64_t endRow = startRow + length;  // exclusive
+
+  unsigned long long* blockP = reinterpret_cast<unsigned long long*>(blockIndex);  // index relative to startBlock
+  char* batchBuf = ScratchBuffer(ScratchSlot::BLOCK_BATCH, batchSize * blockBufSize);  // compressed data for a single batch
+
+  for (int batchStart = startBlock; batchStart <= endBlock; batchStart += batchSize)
+  {
+    int batchEnd = min(batchStart + batchSize - 1, endBlock);
+
+    // Compressed blocks of a batch are stored contiguously
+    unsigned long long batchPos = blockP[batchStart - startBlock] & BLOCK_POS_MASK;
+    unsigned long long batchBytes = (blockP[batchEnd - startBlock + 1] & BLOCK_POS_MASK) - batchPos;
+
+    myfile.seekg(blockPos + batchPos);
+    myfile.read(batchBuf, batchBytes);
+
+#pragma omp parallel num_threads(nrOfThreads)
+    {
+      char tmpBufStack[MAX_SIZE_COMPRESS_BLOCK];  // temporary buffer
+      vector<char> largeBlockBuf;  // temporary buffer for blocks larger than MAX_SIZE_COMPRESS_BLOCK
+      char* tmpBuf = tmpBufStack;
+
+      if (isLargeBlock)
+      {
+        largeBlockBuf.resize(blockSize);
+        tmpBuf = largeBlockBuf.data();
+      }
+
+      Decompressor decompressor;
+
+#pragma omp for schedule(dynamic)
+      for (int block = batchStart; block <= batchEnd; ++block)
+      {
+        unsigned long long blockStart = blockP[block - startBlock];
+        unsigned short algo = (unsigned short) ((blockStart >> 48) & 0xffff);
+        unsigned long long blockPosStart = blockStart & BLOCK_POS_MASK;
+        unsigned long long compSize = (blockP[block - startBlock + 1] & BLOCK_POS_MASK) - blockPosStart;
+        char* compData = &batchBuf[blockPosStart - batchPos];
+
+        // Range of requested elements in this block
+        unsigned int curSize = block == (nrOfBlocks - 1) ? lastBlockSize : blockSizeElements;
+        uint64_t blockFirstRow = (uint64_t) block * blockSizeElements;
+        uint64_t firstRow = max(blockFirstRow, (uint64_t) startRow);
+        uint64_t lastRow = min(blockFirstRow + curSize, endRow);
+
+        uint64_t outOffset = (firstRow - startRow) * elementSize;  // position in output vector
+        uint64_t nrOfBytes = (lastRow - firstRow) * elementSize;
+
+        if (algo == 0)  // no compression
+        {
+          memcpy(&outVec[outOffset], &compData[(firstRow - blockFirstRow) * elementSize], nrOfBytes);
+        }
+        else if (nrOfBytes == (uint64_t) curSize * elementSize)  // full block
+        {
+          DecompressBlock_v2(decompressor, algo, &outVec[outOffset], curSize * elementSize, compData, compSize, tmpBuf);
+        }
+        else
+        {
+          decompressor.Decompress(algo, tmpBuf, curSize * elementSize, compData, compSize);
+          memcpy(&outVec[outOffset], &tmpBuf[(firstRow - blockFirstRow) * elementSize], nrOfBytes);
+        }
+      }
+    }
+  }
+}
+
+
+// Read the blocks of a range through the block cache, or the shared block cache for a file identity with the
+// SHARED_CACHE_FILE flag. Missing blocks are decompressed completely and added to the cache. The block index is
+// only read when a block is missing.
+inline void ReadBlocksCached_v2(istream &myfile, char* outVec, unsigned long long blockPos, unsigned long long fileId,
+  int startBlock, int endBlock, unsigned long long startRow, unsigned long long length, unsigned long long size,
+  int elementSize, unsigned int blockSizeElements, unsigned int maxCompSize)
+{
+  BlockCache &blockCache = BlockCache::Global();
+  SharedBlockCache &sharedCache = SharedBlockCache::Global();
+  bool shared = (fileId & SHARED_CACHE_FILE) != 0;
+  int nrOfBlocks = static_cast<int>(1 + (size - 1) / blockSizeElements);
+  unsigned int lastBlockSize = static_cast<unsigned int>(1 + (size + blockSizeElements - 1) % blockSizeElements);  // smaller last block size
+  uint64_t endRow = startRow + length;  // exclusive
+
+  unsigned long long* blockP = nullptr;  // index relative to startBlock
+  char* compBuf = nullptr;
+  Decompressor decompressor;
+
+  for (int block = startBlock; block <= endBlock; ++block)
+  {
+    BlockCacheKey key = { fileId & ~SHARED_CACHE_FILE, blockPos, (unsigned long long) block };
+    unsigned int curSize = block == (nrOfBlocks - 1) ? lastBlockSize : blockSizeElements;
+    shared_ptr<vector<char>> blockData;
+    const char* cachedData;
+
+    if (shared)
+    {
+      cachedData = sharedCache.Find(key, (uint64_t) curSize * elementSize);
+    }
+    else
+    {
+      blockData = blockCache.Find(key);
+      cachedData = blockData ? blockData->data() : nullptr;
+    }
+
+    if (cachedData == nullptr)
+    {
+      if (blockP == nullptr)  // read block index and allocate the read buffer
+      {
+        uint64_t indexSize = (2 + (uint64_t) (endBlock - startBlock)) * 8;
+        blockP = reinterpret_cast<unsigned long long*>(ScratchBuffer(ScratchSlot::BLOCK_INDEX, indexSize));
+        compBuf = ScratchBuffer(ScratchSlot::BLOCK_BATCH, max(maxCompSize, (unsigned int) MAX_COMPRESSBOUND));
+
+        myfile.seekg(blockPos + COL_META_SIZE + 8 * (uint64_t) startBlock);
+        myfile.read(reinterpret_cast<char*>(blockP), indexSize);
+      }
+
+      unsigned long long blockStart = blockP[block - startBlock];
+      unsigned short algo = (unsigned short) ((blockStart >> 48) & 0xffff);
+      unsigned long long blockPosStart = blockStart & BLOCK_POS_MASK;
+      unsigned long long compSize = (blockP[block - startBlock + 1] & BLOCK_POS_MASK) - blockPosStart;
+
+      blockData = make_shared<vector<char>>((uint64_t) curSize * elementSize);
+      myfile.seekg(blockPos + blockPosStart);
+      ProfileBlocks(algo);
+
+      if (algo == 0)  // no compression
+      {
+        myfile.read(blockData->data(), blockData->size());
+      }
+      else
+      {
+        myfile.read(compBuf, compSize);
+        decompressor.Decompress(algo, blockData->data(), curSize * elementSize, compBuf, compSize);
+      }
+
+      if (shared) sharedCache.Insert(key, blockData->data(), blockData->size());
+      else blockCache.Insert(key, blockData);
+
+      cachedData = blockData->data();
+    }
+
+    // Range of requested elements in this block
+    uint64_t blockFirstRow = (uint64_t) block * blockSizeElements;
+    uint64_t firstRow = max(blockFirstRow, (uint64_t) startRow);
+    uint64_t lastRow = min(blockFirstRow + curSize, endRow);
+
+    memcpy(&outVec[(firstRow - startRow) * elementSize], &cachedData[(firstRow - blockFirstRow) * elementSize],
+      (lastRow - firstRow) * elementSize);
+  }
+}
+
+
+void fdsReadColumn_v2(istream &myfile, char* outVec, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, unsigned long long size, int elementSize,
+  int nrOfThreads)
+{
+  ProfileTimer profileTimer(ProfilePhase::CODEC);
+  ProfileData(length * elementSize);
+
   // Read header
   unsigned int compress[2];
   myfile.seekg(blockPos);
@@ -355,7 +688,7 @@ void fdsReadColumn_v2(istream &myfile, char* outVec, unsigned long long blockPos
       // Jump to startRow position
       if (startRow > 0) myfile.seekg(blockPos + elementSize * startRow + COL_META_SIZE);
 
-      uint64_t totBytes = (uint64_t) (length) * elementSize;
+      uint64_t totBytes = length * elementSize;
       uint64_t nrOfBlocks = (totBytes - 1) / UNCOMPRESSED_BLOCKSIZE;  // all but last block
       uint64_t remainingBytes = totBytes - nrOfBlocks * UNCOMPRESSED_BLOCKSIZE;  // last block
       uint64_t curBlockPos = 0;
@@ -380,32 +713,66 @@ void fdsReadColumn_v2(istream &myfile, char* outVec, unsigned long long blockPos
 
   // Data is compressed
 
-  // unsigned int* maxCompSize = (unsigned int*) &compress[0];  // 4 algorithms in index
   unsigned int blockSizeElements = compress[1];  // number of elements per block
 
   // Number of compressed data blocks, the last block can be smaller than blockSizeElements
-  int nrOfBlocks = 1 + (size - 1) / blockSizeElements;
+  int nrOfBlocks = static_cast<int>(1 + (size - 1) / blockSizeElements);
 
   // Calculate startRow data block position
-  int startBlock = startRow / blockSizeElements;
-  int endBlock = (startRow + length - 1) / blockSizeElements;
-  int startOffset = startRow % blockSizeElements;
+  int startBlock = static_cast<int>(startRow / blockSizeElements);
+  int endBlock = static_cast<int>((startRow + length - 1) / blockSizeElements);
+  int startOffset = static_cast<int>(startRow % blockSizeElements);
+
+  // Reads through an open handle use the block cache, unless the range would release a large part of the cache
+  unsigned long long fileId = BlockCacheScope::ActiveFile();
+
+  unsigned long long cacheSize = (fileId & SHARED_CACHE_FILE) != 0 ? SharedBlockCache::Global().Stats().size :
+    BlockCache::Global().Stats().budget;
+
+  if (fileId != 0 && (uint64_t) (1 + endBlock - startBlock) * blockSizeElements * elementSize <= cacheSize / 4)
+  {
+    ReadBlocksCached_v2(myfile, outVec, blockPos, fileId, startBlock, endBlock, startRow, length, size, elementSize,
+      blockSizeElements, compress[0]);
+
+    return;
+  }
 
   if (startBlock > 0)
   {
-    myfile.seekg(blockPos + COL_META_SIZE + 8 * startBlock);  // move to startBlock meta info
+    myfile.seekg(blockPos + COL_META_SIZE + 8 * (uint64_t) startBlock);  // move to startBlock meta info
   }
 
   // Read block index (position pointer and algorithm for each block)
-  char* blockIndex = new char[(2 + endBlock - startBlock) * 8];  // 1 long file pointer using 2 highest bytes for algorithm
-  myfile.read(blockIndex, (2 + endBlock - startBlock) * 8);
+  char* blockIndex = ScratchBuffer(ScratchSlot::BLOCK_INDEX, (2 + (uint64_t) (endBlock - startBlock)) * 8);  // 1 long file pointer using 2 highest bytes for algorithm
+  myfile.read(blockIndex, (2 + (uint64_t) (endBlock - startBlock)) * 8);
+
+  if (ProfileScope::Active() != nullptr)
+  {
+    for (int block = 0; block <= endBlock - startBlock; ++block)
+    {
+      ProfileBlocks((reinterpret_cast<unsigned long long*>(blockIndex)[block] >> 48) & 0xffff);
+    }
+  }
 
   int blockSize = elementSize * blockSizeElements;
 
   // char compBuf[*maxCompSize];  // read buffer
   // char tmpBuf[blockSize];  // temporary buffer
-  char compBuf[MAX_COMPRESSBOUND];  // maximum size needed in worst case scenario compression
-  char tmpBuf[MAX_SIZE_COMPRESS_BLOCK];  // temporary buffer
+  char compBufStack[MAX_COMPRESSBOUND];  // maximum size needed in worst case scenario compression
+  char tmpBufStack[MAX_SIZE_COMPRESS_BLOCK];  // temporary buffer
+  char* compBuf = compBufStack;
+  char* tmpBuf = tmpBufStack;
+
+  // Blocks larger than MAX_SIZE_COMPRESS_BLOCK need buffers that are too large for the stack
+  unsigned int maxCompSize = compress[0];  // maximum compressed block size
+  vector<char> largeBlockBuf;
+
+  if (blockSize > MAX_SIZE_COMPRESS_BLOCK)
+  {
+    largeBlockBuf.resize((uint64_t) maxCompSize + blockSize);
+    compBuf = largeBlockBuf.data();
+    tmpBuf = &largeBlockBuf[maxCompSize];
+  }
 
   Decompressor decompressor;
 
@@ -425,9 +792,7 @@ void fdsReadColumn_v2(istream &myfile, char* outVec, unsigned long long blockPos
     if (algo == 0)  // no compression on this block
     {
       myfile.seekg(blockPos + blockPosStart + elementSize * startOffset);  // move to block data position
-      myfile.read((char*) outVec, (uint64_t) (length) * elementSize);
-
-      delete[] blockIndex;
+      myfile.read((char*) outVec, length * elementSize);
 
       return;
     }
@@ -436,7 +801,7 @@ void fdsReadColumn_v2(istream &myfile, char* outVec, unsigned long long blockPos
     unsigned int curSize = blockSizeElements;
     if (startBlock == (nrOfBlocks - 1))  // test for last block
     {
-      curSize = 1 + (size + blockSizeElements - 1) % blockSizeElements;  // smaller last block size
+      curSize = static_cast<unsigned int>(1 + (size + blockSizeElements - 1) % blockSizeElements);  // smaller last block size
     }
 
     myfile.seekg(blockPos + blockPosStart);  // move to block data position, not always necessary!
@@ -444,7 +809,7 @@ void fdsReadColumn_v2(istream &myfile, char* outVec, unsigned long long blockPos
 
     if (length == curSize)
     {
-      decompressor.Decompress(algo, outVec, elementSize * length, compBuf, compSize);  // direct decompress
+      DecompressBlock_v2(decompressor, algo, outVec, elementSize * curSize, compBuf, compSize, tmpBuf);
     }
     else
     {
@@ -452,13 +817,20 @@ void fdsReadColumn_v2(istream &myfile, char* outVec, unsigned long long blockPos
       memcpy(outVec, &tmpBuf[elementSize * startOffset], elementSize * length);  // data range
     }
 
-    delete[] blockIndex;
-
     return;
   }
 
   // Calculations span at least two block
 
+  // Decompress blocks in parallel
+  if (nrOfThreads > 1 && (endBlock - startBlock) >= nrOfThreads)
+  {
+    DecompressBlocksParallel_v2(myfile, outVec, blockPos, blockIndex, startBlock, endBlock, startRow, length, size,
+      elementSize, blockSizeElements, maxCompSize, nrOfThreads);
+
+    return;
+  }
+
   // First block
   int subBlockSize = blockSizeElements - startOffset;
 
@@ -473,7 +845,7 @@ void fdsReadColumn_v2(istream &myfile, char* outVec, unsigned long long blockPos
 
     if (startOffset == 0)  // full block
     {
-      decompressor.Decompress(algo, outVec, blockSize, compBuf, compSize);
+      DecompressBlock_v2(decompressor, algo, outVec, blockSize, compBuf, compSize, tmpBuf);
     }
     else
     {
@@ -482,72 +854,40 @@ void fdsReadColumn_v2(istream &myfile, char* outVec, unsigned long long blockPos
     }
   }
 
-  int remain = (startRow + length) % blockSizeElements;  // remaining required items in last block
+  int remain = static_cast<int>((startRow + length) % blockSizeElements);  // remaining required items in last block
   if (remain == 0) ++endBlock;
 
   int maxBlock = endBlock - startBlock;
-  uint64_t outOffset = subBlockSize * elementSize;  // position in output vector
+  uint64_t outOffset = (uint64_t) subBlockSize * elementSize;  // position in output vector
 
-  if ((outOffset % 8) == 0)  // outVec pointer is 8-byte aligned
+  // Process middle blocks (if any)
+  for (int blockCount = 1; blockCount < maxBlock; ++blockCount)
   {
-    // Process middle blocks (if any)
-    for (int blockCount = 1; blockCount < maxBlock; ++blockCount)
-    {
-      // Update meta pointers
-      blockPStart = blockPEnd;
-      blockPEnd = (unsigned long long*) &blockIndex[8 + 8 * blockCount];
-
-      algo = (unsigned short) (((*blockPStart) >> 48) & 0xffff);
-      blockPosStart = (*blockPStart) & BLOCK_POS_MASK;
-      blockPosEnd = (*blockPEnd) & BLOCK_POS_MASK;
-      compSize = blockPosEnd - blockPosStart;
+    // Update meta pointers
+    blockPStart = blockPEnd;
+    blockPEnd = (unsigned long long*) &blockIndex[8 + 8 * (uint64_t) blockCount];
 
-      if (algo == 0)  // no compression
-      {
-        myfile.read(&outVec[outOffset], blockSize);  // read first block data
-      } else
-      {
-        myfile.read(compBuf, compSize);
-        decompressor.Decompress(algo, &outVec[outOffset], blockSize, compBuf, compSize);
-      }
+    algo = (unsigned short) (((*blockPStart) >> 48) & 0xffff);
+    blockPosStart = (*blockPStart) & BLOCK_POS_MASK;
+    blockPosEnd = (*blockPEnd) & BLOCK_POS_MASK;
+    compSize = blockPosEnd - blockPosStart;
 
-      outOffset += blockSize;  // update position in output vector
-    }
-  }
-  else  // outVec pointer is nog 8-byte aligned
-  {
-    // Process middle blocks (if any)
-    for (int blockCount = 1; blockCount < maxBlock; ++blockCount)
+    if (algo == 0)  // no compression
     {
-      // Update meta pointers
-      blockPStart = blockPEnd;
-      blockPEnd = (unsigned long long*) &blockIndex[8 + 8 * blockCount];
-
-      algo = (unsigned short) (((*blockPStart) >> 48) & 0xffff);
-      blockPosStart = (*blockPStart) & BLOCK_POS_MASK;
-      blockPosEnd = (*blockPEnd) & BLOCK_POS_MASK;
-      compSize = blockPosEnd - blockPosStart;
-
-      if (algo == 0)  // no compression
-      {
-        myfile.read(&outVec[outOffset], blockSize);  // read first block data
-      } else
-      {
-        myfile.read(compBuf, compSize);
-        decompressor.Decompress(algo, tmpBuf, blockSize, compBuf, compSize);
-        memcpy(&outVec[outOffset], tmpBuf, blockSize);  // copy to misaligned pointer
-      }
-
-      outOffset += blockSize;  // update position in output vector
+      myfile.read(&outVec[outOffset], blockSize);  // read first block data
+    } else
+    {
+      myfile.read(compBuf, compSize);
+      DecompressBlock_v2(decompressor, algo, &outVec[outOffset], blockSize, compBuf, compSize, tmpBuf);
     }
+
+    outOffset += blockSize;  // update position in output vector
   }
 
 
   // No last block
   if (remain == 0)  // no additional elements required
   {
-    delete[] blockIndex;
-
     return;
   }
 
@@ -555,7 +895,7 @@ void fdsReadColumn_v2(istream &myfile, char* outVec, unsigned long long blockPos
 
   // Update meta pointers
   blockPStart = blockPEnd;
-  blockPEnd = reinterpret_cast<unsigned long long*>(&blockIndex[8 + 8 * maxBlock]);
+  blockPEnd = reinterpret_cast<unsigned long long*>(&blockIndex[8 + 8 * (uint64_t) maxBlock]);
 
   algo = (unsigned short) (((*blockPStart) >> 48) & 0xffff);
   blockPosStart = (*blockPStart) & BLOCK_POS_MASK;
@@ -573,20 +913,12 @@ void fdsReadColumn_v2(istream &myfile, char* outVec, unsigned long long blockPos
 
     if (endBlock == (nrOfBlocks - 1))  // test for last block
     {
-      curSize = 1 + (size + blockSizeElements - 1) % blockSizeElements;  // smaller last block size
+      curSize = static_cast<int>(1 + (size + blockSizeElements - 1) % blockSizeElements);  // smaller last block size
     }
 
     if (remain == curSize)  // full last block
     {
-      if ((outOffset % 8) == 0)  // outVec pointer is 8-byte aligned
-      {
-        decompressor.Decompress(algo, &outVec[outOffset], curSize * elementSize, compBuf, compSize);
-      }
-      else
-      {
-        decompressor.Decompress(algo, tmpBuf, curSize * elementSize, compBuf, compSize);
-        memcpy(&outVec[outOffset], tmpBuf, curSize * elementSize);
-      }
+      DecompressBlock_v2(decompressor, algo, &outVec[outOffset], curSize * elementSize, compBuf, compSize, tmpBuf);
     }
     else
     {
@@ -594,7 +926,172 @@ void fdsReadColumn_v2(istream &myfile, char* outVec, unsigned long long blockPos
       memcpy((char*) &outVec[outOffset], tmpBuf, elementSize * remain);
     }
   }
+}
+
+
+
+bool fdsReadColumnRuns_v2(istream &myfile, vector<int> &runValues, vector<unsigned long long> &runEnds,
+  unsigned long long blockPos, unsigned long long startRow, unsigned long long length)
+{
+  runValues.clear();
+  runEnds.clear();
+
+  // Read header
+  unsigned int compress[2];
+  myfile.seekg(blockPos);
+  myfile.read((char*) compress, COL_META_SIZE);
+
+  if (compress[0] == 0) return false;  // uncompressed data or a fixed-ratio compressor
+
+  unsigned int blockSizeElements = compress[1];  // number of elements per block
+  int startBlock = static_cast<int>(startRow / blockSizeElements);
+  int endBlock = static_cast<int>((startRow + length - 1) / blockSizeElements);
+
+  // Read block index (position pointer and algorithm for each block)
+  vector<unsigned long long> blockIndex(2 + endBlock - startBlock);
+  myfile.seekg(blockPos + COL_META_SIZE + 8 * (uint64_t) startBlock);
+  myfile.read((char*) blockIndex.data(), 8 * blockIndex.size());
+
+  for (int block = startBlock; block <= endBlock; ++block)
+  {
+    unsigned short algo = (unsigned short) ((blockIndex[block - startBlock] >> 48) & 0xffff);
+    if (algo != CompAlgo::INT_RLE) return false;
+  }
+
+  // Run-length encoded blocks are small, the compressed data of the range is read at once
+  unsigned long long rangePos = blockIndex[0] & BLOCK_POS_MASK;
+  unsigned long long rangeBytes = (blockIndex[endBlock - startBlock + 1] & BLOCK_POS_MASK) - rangePos;
+
+  vector<char> rangeData(rangeBytes);
+  myfile.seekg(blockPos + rangePos);
+  myfile.read(rangeData.data(), rangeBytes);
+
+  unsigned long long endRow = startRow + length;
+
+  for (int block = startBlock; block <= endBlock; ++block)
+  {
+    const int* blockValues;
+    const unsigned int* blockLengths;
+    unsigned long long dataPos = (blockIndex[block - startBlock] & BLOCK_POS_MASK) - rangePos;
+    unsigned int nrOfRuns = IntRleRuns(&rangeData[dataPos], blockValues, blockLengths);
 
-  delete[] blockIndex;
+    unsigned long long runStart = (unsigned long long) block * blockSizeElements;
+
+    for (unsigned int run = 0; run < nrOfRuns; ++run)
+    {
+      unsigned long long firstRow = max(runStart, startRow);
+      runStart += blockLengths[run];
+      unsigned long long lastRow = min(runStart, endRow);
+
+      if (firstRow >= lastRow) continue;  // run outside the requested range
+
+      // Runs that continue in the next block are joined
+      if (!runEnds.empty() && runValues.back() == blockValues[run] && runEnds.back() == firstRow - startRow)
+      {
+        runEnds.back() = lastRow - startRow;
+        continue;
+      }
+
+      runValues.push_back(blockValues[run]);
+      runEnds.push_back(lastRow - startRow);
+    }
+  }
+
+  return true;
 }
 
+
+void fdsColumnStorage_v2(istream &myfile, unsigned long long blockPos, unsigned long long size, int elementSize,
+  ColumnStorage &storage)
+{
+  // Read header
+  unsigned int compress[2];
+  myfile.seekg(blockPos);
+  myfile.read((char*) compress, COL_META_SIZE);
+
+  if (compress[0] == 0)
+  {
+    unsigned long long streamSize = size * elementSize;
+
+    if (compress[1] != 0)  // fixed-ratio compressor
+    {
+      unsigned int repSize = fixedRatioSourceRepSize[compress[1]];
+      streamSize = ((streamSize + repSize - 1) / repSize) * fixedRatioTargetRepSize[compress[1]];
+    }
+
+    storage.AddBlock(compress[1], streamSize);
+    storage.bytes += COL_META_SIZE + streamSize;
+
+    return;
+  }
+
+  // Block positions (relative to blockPos) with the algorithm in the 2 high bytes, followed by the end position
+  unsigned long long nrOfBlocks = 1 + (size - 1) / compress[1];
+  vector<unsigned long long> blockIndex(nrOfBlocks + 1);
+  myfile.read((char*) blockIndex.data(), (nrOfBlocks + 1) * 8);
+
+  if (myfile.fail())
+  {
+    throw(runtime_error("Error reading the block index of a column."));
+  }
+
+  for (unsigned long long block = 0; block < nrOfBlocks; ++block)
+  {
+    unsigned long long blockStart = blockIndex[block] & BLOCK_POS_MASK;
+    unsigned int algo = (unsigned int) ((blockIndex[block] >> 48) & 0xffff);
+
+    storage.AddBlock(algo, (blockIndex[block + 1] & BLOCK_POS_MASK) - blockStart);
+  }
+
+  storage.bytes += blockIndex[nrOfBlocks] & BLOCK_POS_MASK;
+}
+
+
+unsigned int fdsColumnBlockRows_v2(istream &myfile, unsigned long long blockPos)
+{
+  unsigned int compress[2];
+  myfile.seekg(blockPos);
+  myfile.read((char*) compress, COL_META_SIZE);
+
+  if (myfile.fail() || compress[0] == 0 || compress[1] == 0) return 1;
+
+  return compress[1];
+}
+
+
+bool fdsColumnRange_v2(istream &myfile, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, int elementSize, unsigned long long &rangeStart, unsigned long long &rangeEnd)
+{
+  // Read header
+  unsigned int compress[2];
+  myfile.seekg(blockPos);
+  myfile.read((char*) compress, COL_META_SIZE);
+
+  if (compress[0] == 0)
+  {
+    if (compress[1] != 0) return false;  // fixed-ratio compressor
+
+    rangeStart = blockPos + COL_META_SIZE + elementSize * startRow;
+    rangeEnd = rangeStart + elementSize * length;
+
+    return true;
+  }
+
+  unsigned int blockSizeElements = compress[1];  // number of elements per block
+  unsigned long long startBlock = startRow / blockSizeElements;
+  unsigned long long endBlock = (startRow + length - 1) / blockSizeElements;
+
+  // Start of the first block and end of the last block
+  unsigned long long blockStart, blockEnd;
+  myfile.seekg(blockPos + COL_META_SIZE + 8 * startBlock);
+  myfile.read((char*) &blockStart, 8);
+  myfile.seekg(blockPos + COL_META_SIZE + 8 * (endBlock + 1));
+  myfile.read((char*) &blockEnd, 8);
+
+  if (myfile.fail()) return false;
+
+  rangeStart = blockPos + (blockStart & BLOCK_POS_MASK);
+  rangeEnd = blockPos + (blockEnd & BLOCK_POS_MASK);
+
+  return true;
+}
@@ -36,22 +36,77 @@
 #ifndef BLOCKSTORE_H
 #define BLOCKSTORE_H
 
-#include <fstream>
+#include <ostream>
+#include <istream>
+#include <vector>
 
 // Framework headers
 #include "compressor.h"
+#include "zonemap.h"
 
-// Method for writing column data of any type to a ofstream.
-void fdsStreamUncompressed_v2(std::ofstream &myfile, char* vec, unsigned int vecLength, int elementSize, int blockSizeElems,
-  FixedRatioCompressor* fixedRatioCompressor);
+// Method for writing column data of any type to a stream. If zoneMap is specified, it receives the statistics
+// of each block. The block size of a fixed ratio compressor should be a multiple of its source repetition size.
+void fdsStreamUncompressed_v2(std::ostream &myfile, char* vec, unsigned long long vecLength, int elementSize, int blockSizeElems,
+  FixedRatioCompressor* fixedRatioCompressor, ZoneMap* zoneMap = nullptr);
 
 
-// Method for writing column data of any type to a stream.
-void fdsStreamcompressed_v2(std::ofstream &myfile, char* colVec, unsigned int nrOfRows, int elementSize,
-  StreamCompressor* streamCompressor, int blockSizeElems);
+// Method for writing column data of any type to a stream. With more than one thread, blocks are compressed
+// in parallel batches. The resulting stream is identical to the single threaded result. Any block size can be
+// used, blocks larger than MAX_SIZE_COMPRESS_BLOCK use heap allocated buffers. If zoneMap is specified, it
+// receives the statistics of each block.
+void fdsStreamcompressed_v2(std::ostream &myfile, char* colVec, unsigned long long nrOfRows, int elementSize,
+  StreamCompressor* streamCompressor, int blockSizeElems, int nrOfThreads, ZoneMap* zoneMap = nullptr);
 
 
-void fdsReadColumn_v2(std::istream &myfile, char* outVec, unsigned long long blockPos, unsigned startRow, unsigned length, unsigned size, int elementSize);
+// Method for reading column data of any type from a stream. With more than one thread, compressed blocks are
+// decompressed in parallel batches.
+void fdsReadColumn_v2(std::istream &myfile, char* outVec, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, unsigned long long size, int elementSize,
+  int nrOfThreads);
+
+
+// Method for reading a range of an integer column as runs of equal values, without expanding the runs. Run r
+// holds runValues[r] for the rows up to runEnds[r] (relative to startRow). Returns false (and no runs) if not
+// all blocks of the range are run-length encoded (INT_RLE).
+bool fdsReadColumnRuns_v2(std::istream &myfile, std::vector<int> &runValues, std::vector<unsigned long long> &runEnds,
+  unsigned long long blockPos, unsigned long long startRow, unsigned long long length);
+
+
+// Determine the file positions [rangeStart, rangeEnd) of the stored data of rows startRow until startRow + length of
+// the column data at blockPos, using its block index. Returns false if the range can't be determined (data stored
+// with a fixed-ratio compressor).
+bool fdsColumnRange_v2(std::istream &myfile, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, int elementSize, unsigned long long &rangeStart, unsigned long long &rangeEnd);
+
+
+// Number of rows in a compressed block of the column data at blockPos. Data without blocks (uncompressed or using a
+// fixed-ratio compressor) can be read from any row and has 1 row per block.
+unsigned int fdsColumnBlockRows_v2(std::istream &myfile, unsigned long long blockPos);
+
+
+// Storage of the data of a column: its size in the file and the number and maximum size of the stored blocks of
+// each compression algorithm
+struct ColumnStorage
+{
+  unsigned long long bytes;                     // size of the column data in the file
+  unsigned long long blocks[NR_OF_ALGORITHMS];  // number of stored blocks per compression algorithm
+  unsigned long long maxBlockSize;              // size of the largest stored block
+
+  ColumnStorage() : bytes(0), blocks(), maxBlockSize(0) {}
+
+  void AddBlock(unsigned int algo, unsigned long long blockSize)
+  {
+    if (algo < NR_OF_ALGORITHMS) ++blocks[algo];
+    if (blockSize > maxBlockSize) maxBlockSize = blockSize;
+  }
+};
+
+
+// Add the storage of the column data at blockPos, with size elements, to storage. Only the header and block index
+// of the column are read. Data without a block index (uncompressed or using a fixed-ratio compressor) is a single
+// stored block.
+void fdsColumnStorage_v2(std::istream &myfile, unsigned long long blockPos, unsigned long long size, int elementSize,
+  ColumnStorage &storage);
 
 
 #endif // BLOCKSTORE_H
@@ -0,0 +1,223 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+
+#include "bloomfilter.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include <xxhash.h>
+
+
+using namespace std;
+
+
+BloomFilter::BloomFilter(FstColumnType colType, unsigned long long nrOfRows, unsigned int blockSizeElems,
+  unsigned int bitsPerKey)
+{
+  this->colType    = colType;
+  this->bitsPerKey = min(bitsPerKey, (unsigned int) BLOOM_MAX_BITS_PER_KEY);
+
+  nrOfHashes  = min(max((unsigned int) lround(0.69 * this->bitsPerKey), 1U), (unsigned int) BLOOM_MAX_HASHES);
+  filterWords = (unsigned int) (((unsigned long long) blockSizeElems * this->bitsPerKey + 63) / 64);
+  nrOfBlocks  = this->bitsPerKey == 0 ? 0 : (nrOfRows + blockSizeElems - 1) / blockSizeElems;
+
+  words.assign(filterWords * nrOfBlocks, 0);
+}
+
+
+// Finalizer of the SplitMix64 generator, which spreads consecutive values over all bits
+unsigned long long BloomFilter::IntHash(long long value)
+{
+  unsigned long long hash = (unsigned long long) value + 0x9e3779b97f4a7c15ULL;
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+
+  return hash ^ (hash >> 31);
+}
+
+
+unsigned long long BloomFilter::StringHash(const char* str, unsigned int length)
+{
+  return XXH64(str, length, 0);
+}
+
+
+// The bit positions of the hash functions are h + i * delta (modulo the filter size), with the step derived from
+// the high bits of the hash (double hashing)
+void BloomFilter::Add(unsigned long long blockNr, unsigned long long hash)
+{
+  unsigned long long* filter = &words[blockNr * filterWords];
+  unsigned long long nrOfBits = 64 * (unsigned long long) filterWords;
+  unsigned long long delta = (hash >> 33) | 1;
+
+  for (unsigned int hashNr = 0; hashNr < nrOfHashes; ++hashNr)
+  {
+    unsigned long long bit = hash % nrOfBits;
+    filter[bit / 64] |= 1ULL << (bit % 64);
+    hash += delta;
+  }
+}
+
+
+bool BloomFilter::MayContain(unsigned long long blockNr, unsigned long long hash) const
+{
+  const unsigned long long* filter = &words[blockNr * filterWords];
+  unsigned long long nrOfBits = 64 * (unsigned long long) filterWords;
+  unsigned long long delta = (hash >> 33) | 1;
+
+  for (unsigned int hashNr = 0; hashNr < nrOfHashes; ++hashNr)
+  {
+    unsigned long long bit = hash % nrOfBits;
+    if ((filter[bit / 64] & (1ULL << (bit % 64))) == 0) return false;
+    hash += delta;
+  }
+
+  return true;
+}
+
+
+void BloomFilter::AddBlock(unsigned long long blockNr, const char* blockData, unsigned int nrOfElements)
+{
+  if (colType == FstColumnType::INT_64)
+  {
+    const long long* values = (const long long*) blockData;
+
+    for (unsigned int pos = 0; pos < nrOfElements; ++pos)
+    {
+      if (values[pos] != LLONG_MIN) Add(blockNr, IntHash(values[pos]));
+    }
+
+    return;
+  }
+
+  const int* values = (const int*) blockData;
+
+  for (unsigned int pos = 0; pos < nrOfElements; ++pos)
+  {
+    if (values[pos] != INT_MIN) Add(blockNr, IntHash(values[pos]));
+  }
+}
+
+
+void BloomFilter::AddCharBlock(unsigned long long blockNr, IBlockWriter* blockWriter, unsigned int nrOfElements)
+{
+  const unsigned int* strSizes = blockWriter->strSizes;  // cumulative string sizes
+  const unsigned int* naInts   = blockWriter->naInts;
+  const char* buf              = blockWriter->activeBuf;
+
+  unsigned int strStart = 0;
+
+  for (unsigned int pos = 0; pos < nrOfElements; ++pos)
+  {
+    unsigned int strEnd = strSizes[pos];
+
+    if (((naInts[pos / 32] >> (pos % 32)) & 1) == 0)
+    {
+      Add(blockNr, StringHash(&buf[strStart], strEnd - strStart));
+    }
+
+    strStart = strEnd;
+  }
+}
+
+
+void BloomFilter::Write(ostream &myfile) const
+{
+  if (!Enabled()) return;
+
+  unsigned int meta[6];
+  unsigned long long* p_id = (unsigned long long*) meta;
+
+  *p_id   = BLOOM_FILTER_ID;
+  meta[2] = bitsPerKey;
+  meta[3] = nrOfHashes;
+  meta[4] = filterWords;
+  meta[5] = (unsigned int) nrOfBlocks;
+
+  myfile.write((const char*) words.data(), 8 * words.size());
+  myfile.write((const char*) meta, BLOOM_FILTER_META_SIZE);
+}
+
+
+bool BloomFilter::Read(istream &myfile, unsigned long long endPos, FstColumnType colType,
+  unsigned long long nrOfBlocks)
+{
+  bitsPerKey = 0;
+  words.clear();
+
+  if (endPos < BLOOM_FILTER_META_SIZE)
+  {
+    return false;
+  }
+
+  unsigned int meta[6];
+  unsigned long long* p_id = (unsigned long long*) meta;
+
+  myfile.seekg(endPos - BLOOM_FILTER_META_SIZE);
+  myfile.read((char*) meta, BLOOM_FILTER_META_SIZE);
+
+  // The filters should match the column data
+  if (!myfile || *p_id != BLOOM_FILTER_ID || meta[2] == 0 || meta[2] > BLOOM_MAX_BITS_PER_KEY || meta[3] == 0 ||
+    meta[3] > BLOOM_MAX_HASHES || meta[4] == 0 || meta[5] != nrOfBlocks ||
+    endPos < BLOOM_FILTER_META_SIZE + 8 * (unsigned long long) meta[4] * nrOfBlocks)
+  {
+    myfile.clear();
+    return false;
+  }
+
+  this->colType    = colType;
+  this->nrOfBlocks = nrOfBlocks;
+  filterWords      = meta[4];
+  nrOfHashes       = meta[3];
+
+  words.resize(filterWords * nrOfBlocks);
+  myfile.seekg(endPos - BLOOM_FILTER_META_SIZE - 8 * words.size());
+  myfile.read((char*) words.data(), 8 * words.size());
+
+  if (!myfile)
+  {
+    myfile.clear();
+    words.clear();
+    return false;
+  }
+
+  bitsPerKey = meta[2];
+
+  return true;
+}
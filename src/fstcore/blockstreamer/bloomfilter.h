@@ -0,0 +1,151 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+
+#include <ostream>
+#include <istream>
+#include <vector>
+
+#include "ifsttable.h"
+#include "iblockrunner.h"
+
+
+#define BLOOM_FILTER_ID        0x4c464d4f4f4c4201  // Bloom filter identifier (version 1)
+#define BLOOM_FILTER_META_SIZE 24                  // identifier, bits per key, hashes, filter size and number of blocks
+#define BLOOM_MAX_BITS_PER_KEY 64                  // maximum number of filter bits per value
+#define BLOOM_MAX_HASHES       16                  // maximum number of hash functions
+
+
+/**
+ Bloom filters of the blocks of a single column in a single data chunk, used to skip blocks that can't contain a
+ value compared for equality. Unlike the zone map, a Bloom filter also excludes blocks of unsorted columns with a
+ high cardinality, where the range of almost every block covers the compared values. Filters are stored for
+ integer, 64-bit integer and character columns only. NA values are not added to the filters.
+
+ Each block has a filter of a fixed size, with bitsPerKey bits for each row of a (full) block. Values are set
+ in the filter with round(0.69 * bitsPerKey) hash functions, derived from a single 64-bit hash of the value, which
+ gives a false positive rate of about 1% for 10 bits per key. The filters are collected through the zone map of
+ the column (see ZoneMap::SetBloomFilter) and stored directly in front of the checksum metadata, ending with their
+ metadata, so readers that are unaware of Bloom filters never see them.
+ */
+class BloomFilter
+{
+  FstColumnType colType;
+  unsigned int bitsPerKey;
+  unsigned int nrOfHashes;
+  unsigned int filterWords;          // number of 64-bit words in the filter of a single block
+  unsigned long long nrOfBlocks;
+  std::vector<unsigned long long> words;
+
+  void Add(unsigned long long blockNr, unsigned long long hash);
+
+public:
+  BloomFilter() : colType(FstColumnType::UNKNOWN), bitsPerKey(0), nrOfHashes(0), filterWords(0), nrOfBlocks(0) {}
+
+  /**
+   Prepare empty filters for nrOfRows rows of a column, in blocks of blockSizeElems elements, with bitsPerKey
+   bits per value (at most BLOOM_MAX_BITS_PER_KEY). A filter without bits (bitsPerKey 0) is disabled.
+   */
+  BloomFilter(FstColumnType colType, unsigned long long nrOfRows, unsigned int blockSizeElems, unsigned int bitsPerKey);
+
+  /**
+   Whether Bloom filters can be stored for columns of type colType.
+   */
+  static bool SupportsType(FstColumnType colType)
+  {
+    return colType == FstColumnType::INT_32 || colType == FstColumnType::INT_64 ||
+      colType == FstColumnType::CHARACTER;
+  }
+
+  /**
+   Hash of an integer or 64-bit integer value.
+   */
+  static unsigned long long IntHash(long long value);
+
+  /**
+   Hash of a string of length bytes.
+   */
+  static unsigned long long StringHash(const char* str, unsigned int length);
+
+  bool Enabled() const { return bitsPerKey != 0; }
+
+  unsigned int BitsPerKey() const { return bitsPerKey; }
+
+  unsigned long long NrOfBlocks() const { return nrOfBlocks; }
+
+  /**
+   Bytes used by the filters in the file.
+   */
+  unsigned long long StoredSize() const
+  {
+    return Enabled() ? BLOOM_FILTER_META_SIZE + 8 * (unsigned long long) filterWords * nrOfBlocks : 0;
+  }
+
+  /**
+   Add the values of a block of integers or 64-bit integers (depending on the column type). Blocks can be added
+   from multiple threads, as long as each block is added only once.
+   */
+  void AddBlock(unsigned long long blockNr, const char* blockData, unsigned int nrOfElements);
+
+  /**
+   Add the values of a block of strings, with the buffers of blockWriter set to the block.
+   */
+  void AddCharBlock(unsigned long long blockNr, IBlockWriter* blockWriter, unsigned int nrOfElements);
+
+  /**
+   Test if a block can contain a value with the given hash. False positives occur, false negatives don't.
+   */
+  bool MayContain(unsigned long long blockNr, unsigned long long hash) const;
+
+  /**
+   Write the filters at the current stream position. The checksum metadata should follow directly after.
+   */
+  void Write(std::ostream &myfile) const;
+
+  /**
+   Read the filters that end at stream position endPos.
+
+   @param nrOfBlocks Number of blocks of the column data, as recorded in its zone map.
+   @return false if no (valid) Bloom filters are stored.
+   */
+  bool Read(std::istream &myfile, unsigned long long endPos, FstColumnType colType, unsigned long long nrOfBlocks);
+};
+
+
+#endif  // BLOOM_FILTER_H
@@ -0,0 +1,242 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include "checksum.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <xxhash.h>
+
+
+using namespace std;
+
+
+void ColumnChecksum::WriteMeta(ostream &myfile) const
+{
+  unsigned long long meta[3];
+  meta[0] = CHECKSUM_ID;
+  meta[1] = dataSize;
+  meta[2] = entries.size();
+
+  myfile.write((const char*) meta, CHECKSUM_META_SIZE);
+}
+
+
+void ColumnChecksum::WriteEntries(ostream &myfile) const
+{
+  myfile.write((const char*) entries.data(), CHECKSUM_ENTRY_SIZE * entries.size());
+}
+
+
+bool ColumnChecksum::Read(istream &myfile, unsigned long long metaPos, unsigned long long colPos)
+{
+  entries.clear();
+  dataSize = 0;
+
+  if (metaPos < CHECKSUM_META_SIZE)
+  {
+    return false;
+  }
+
+  unsigned long long meta[3];
+  myfile.seekg(metaPos - CHECKSUM_META_SIZE);
+  myfile.read((char*) meta, CHECKSUM_META_SIZE);
+
+  if (!myfile || meta[0] != CHECKSUM_ID || meta[2] > meta[1])  // blocks are never empty
+  {
+    myfile.clear();
+    return false;
+  }
+
+  entries.resize(meta[2]);
+
+  myfile.seekg(colPos + meta[1]);
+  myfile.read((char*) entries.data(), CHECKSUM_ENTRY_SIZE * meta[2]);
+
+  // The blocks should exactly cover the column data
+  unsigned long long totalSize = 0;
+  for (ChecksumEntry &entry : entries) totalSize += entry.size;
+
+  if (!myfile || totalSize != meta[1])
+  {
+    myfile.clear();
+    entries.clear();
+    return false;
+  }
+
+  dataSize = meta[1];
+
+  return true;
+}
+
+
+unsigned long long ColumnChecksum::Verify(istream &myfile, unsigned long long colPos) const
+{
+  vector<char> buffer;
+  unsigned long long nrOfMismatches = 0;
+
+  myfile.seekg(colPos);
+
+  // Consecutive blocks are read in batches of about CHECKSUM_READ_SIZE bytes
+  unsigned long long nrOfBlocks = entries.size();
+  unsigned long long firstBlock = 0;
+
+  while (firstBlock < nrOfBlocks)
+  {
+    unsigned long long lastBlock = firstBlock;
+    unsigned long long readSize = 0;
+
+    while (lastBlock < nrOfBlocks && (readSize == 0 || readSize + entries[lastBlock].size <= CHECKSUM_READ_SIZE))
+    {
+      readSize += entries[lastBlock++].size;
+    }
+
+    if (buffer.size() < readSize) buffer.resize(readSize);
+
+    myfile.read(buffer.data(), readSize);
+
+    if (!myfile)  // truncated data
+    {
+      myfile.clear();
+      return nrOfMismatches + nrOfBlocks - firstBlock;
+    }
+
+    const char* blockData = buffer.data();
+
+    for (unsigned long long block = firstBlock; block < lastBlock; ++block)
+    {
+      if (XXH64(blockData, entries[block].size, 0) != entries[block].hash)
+      {
+        ++nrOfMismatches;
+      }
+
+      blockData += entries[block].size;
+    }
+
+    firstBlock = lastBlock;
+  }
+
+  return nrOfMismatches;
+}
+
+
+ChecksumStreamBuf::ChecksumStreamBuf(streambuf* target, ColumnChecksum &checksum) : checksum(checksum)
+{
+  this->target = target;
+  startPos = target->pubseekoff(0, ios_base::cur, ios_base::out);
+  pos = startPos;
+
+  checksum.entries.clear();
+  checksum.dataSize = 0;
+}
+
+
+streambuf::pos_type ChecksumStreamBuf::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+  if (dir == ios_base::cur && off == 0)
+  {
+    return pos_type(pos);  // tellp
+  }
+
+  pos_type newPos = target->pubseekoff(off, dir, which);
+
+  if (newPos != pos_type(off_type(-1)))
+  {
+    pos = newPos;
+  }
+
+  return newPos;
+}
+
+
+streambuf::pos_type ChecksumStreamBuf::seekpos(pos_type newPos, ios_base::openmode which)
+{
+  return seekoff(off_type(newPos), ios_base::beg, which);
+}
+
+
+streamsize ChecksumStreamBuf::xsputn(const char* s, streamsize n)
+{
+  if (n <= 0) return 0;
+
+  if (pos < startPos)
+  {
+    throw(runtime_error("Column data was written outside of the column."));
+  }
+
+  ChecksumEntry entry;
+  entry.size = n;
+  entry.hash = XXH64(s, n, 0);
+
+  unsigned long long offset = pos - startPos;
+
+  if (offset == checksum.dataSize)  // new data
+  {
+    checksum.entries.push_back(entry);
+    offsets.push_back(offset);
+    checksum.dataSize += n;
+  }
+  else
+  {
+    // A rewrite should replace a complete earlier write
+    vector<unsigned long long>::iterator it = lower_bound(offsets.begin(), offsets.end(), offset);
+
+    if (it == offsets.end() || *it != offset || checksum.entries[it - offsets.begin()].size != entry.size)
+    {
+      throw(runtime_error("Column data was rewritten at an unexpected position."));
+    }
+
+    checksum.entries[it - offsets.begin()].hash = entry.hash;
+  }
+
+  streamsize written = target->sputn(s, n);
+  pos += written;
+
+  return written;
+}
+
+
+streambuf::int_type ChecksumStreamBuf::overflow(int_type c)
+{
+  if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+
+  char ch = traits_type::to_char_type(c);
+
+  if (xsputn(&ch, 1) != 1) return traits_type::eof();
+
+  return c;
+}
@@ -0,0 +1,146 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+
+#include <ostream>
+#include <istream>
+#include <streambuf>
+#include <vector>
+
+
+#define CHECKSUM_ID         0x4d555348434b4301  // checksum identifier (version 1)
+#define CHECKSUM_META_SIZE  24                  // identifier, data size and number of blocks
+#define CHECKSUM_ENTRY_SIZE 16                  // size and hash of a single block
+#define CHECKSUM_READ_SIZE  1048576             // number of bytes read at once during verification
+
+
+/**
+ Size and 64-bit xxhash of a single block of stored column data.
+ */
+struct ChecksumEntry
+{
+  unsigned long long size;
+  unsigned long long hash;
+};
+
+
+/**
+ Checksums of the stored (compressed) data of a single column in a single data chunk. Every block of data that is
+ written by the column writers (compressed blocks and the headers that index them) is hashed separately. The
+ metadata of the checksums is stored in front of the zone map of the column, the checksums of the blocks directly
+ after the column data, so they can be located from the column position and the zone map size alone.
+
+ Verification hashes the stored bytes only, so damaged data can be detected without decompressing it.
+ */
+class ColumnChecksum
+{
+  unsigned long long dataSize;          // bytes of column data
+  std::vector<ChecksumEntry> entries;   // in order of their position in the column data
+
+  friend class ChecksumStreamBuf;
+
+public:
+  ColumnChecksum() : dataSize(0) {}
+
+  /**
+   Number of bytes of column data covered by the checksums.
+   */
+  unsigned long long DataSize() const { return dataSize; }
+
+  /**
+   Number of hashed blocks of the column data.
+   */
+  unsigned long long NrOfBlocks() const { return entries.size(); }
+
+  /**
+   Write the checksum metadata at the current stream position. The zone map and column data should follow.
+   */
+  void WriteMeta(std::ostream &myfile) const;
+
+  /**
+   Write the checksums of the blocks at the current stream position, directly after the column data.
+   */
+  void WriteEntries(std::ostream &myfile) const;
+
+  /**
+   Read the checksums of the column data at colPos, with the checksum metadata ending at stream position metaPos.
+
+   @return false if no (valid) checksums are stored for the column data.
+   */
+  bool Read(std::istream &myfile, unsigned long long metaPos, unsigned long long colPos);
+
+  /**
+   Hash the stored column data at position colPos and compare with the checksums that were read.
+
+   @return Number of blocks with a checksum mismatch (or that could not be read), 0 for intact data.
+   */
+  unsigned long long Verify(std::istream &myfile, unsigned long long colPos) const;
+};
+
+
+/**
+ Output stream buffer that passes all data to a target stream buffer, hashing the data of each write on the way.
+ The column writers complete their headers after the column data is written. Such a rewrite should cover the
+ exact range of an earlier write, the checksum of which is then replaced.
+ */
+class ChecksumStreamBuf : public std::streambuf
+{
+  std::streambuf* target;
+  ColumnChecksum &checksum;
+  unsigned long long startPos;                // target position of the first byte of column data
+  unsigned long long pos;                     // current target position
+  std::vector<unsigned long long> offsets;    // offset of each hashed block relative to startPos
+
+public:
+  /**
+   Pass data to target, starting at its current position.
+   */
+  ChecksumStreamBuf(std::streambuf* target, ColumnChecksum &checksum);
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::out);
+
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::out);
+
+  std::streamsize xsputn(const char* s, std::streamsize n);
+
+  int_type overflow(int_type c);
+};
+
+
+#endif  // CHECKSUM_H
@@ -0,0 +1,128 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include "profile.h"
+
+
+using namespace std;
+
+
+thread_local ProfileState profileState = { nullptr, nullptr, 0, 0 };
+
+
+inline long long ProfileNow()
+{
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+ColumnProfile::ColumnProfile()
+{
+  bytes = 0;
+  uncompressedBytes = 0;
+
+  for (int phase = 0; phase < PROFILE_PHASES; ++phase) nanos[phase] = 0;
+  for (int algo = 0; algo < PROFILE_ALGORITHMS; ++algo) blocks[algo] = 0;
+}
+
+
+FstProfile::FstProfile() : startTime(chrono::steady_clock::now())
+{
+  bytesRead = 0;
+  bytesWritten = 0;
+  seeks = 0;
+  totalNanos = 0;
+}
+
+
+void FstProfile::SetColumns(unsigned int nrOfCols)
+{
+  columns.clear();
+
+  for (unsigned int colNr = 0; colNr < nrOfCols; ++colNr)
+  {
+    columns.push_back(unique_ptr<ColumnProfile>(new ColumnProfile()));
+  }
+}
+
+
+ColumnProfile* FstProfile::Column(int colNr)
+{
+  if (colNr == PROFILE_METADATA) return &metadata;
+
+  if (colNr < 0 || colNr >= (int) columns.size()) return nullptr;
+
+  return columns[colNr].get();
+}
+
+
+void FstProfile::Stop()
+{
+  totalNanos = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - startTime).count();
+}
+
+
+void ProfileSwitch(ColumnProfile* column, int phase)
+{
+  long long now = ProfileNow();
+
+  if (profileState.column != nullptr)
+  {
+    profileState.column->nanos[profileState.phase].fetch_add(now - profileState.since, memory_order_relaxed);
+  }
+
+  profileState.column = column;
+  profileState.phase = phase;
+  profileState.since = now;
+}
+
+
+ProfileScope::ProfileScope(FstProfile* profile)
+{
+  previous = profileState;
+  if (previous.column != nullptr) ProfileSwitch(nullptr, 0);
+
+  profileState.profile = profile;
+}
+
+
+ProfileScope::~ProfileScope()
+{
+  if (profileState.column != nullptr) ProfileSwitch(nullptr, 0);
+
+  profileState = previous;
+  if (previous.column != nullptr) profileState.since = ProfileNow();
+}
@@ -0,0 +1,244 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_PROFILE_H
+#define FST_PROFILE_H
+
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+
+#define PROFILE_ALGORITHMS 40  // number of compression algorithms (CompAlgo)
+
+
+/**
+ Phases of the time spent on a column: compressing or decompressing the data (including block indexes, zone maps
+ and checksums), reading or writing the file and converting between the stored data and the table (creating the
+ result columns, converting strings).
+ */
+enum class ProfilePhase
+{
+  CODEC = 0,
+  IO,
+  TABLE
+};
+
+#define PROFILE_PHASES 3
+
+
+/**
+ Counters of a single column of a profiled read or write. Counters are updated from multiple threads.
+ */
+struct ColumnProfile
+{
+  std::atomic<unsigned long long> bytes;                       // bytes read from or written to the file
+  std::atomic<unsigned long long> uncompressedBytes;           // bytes of the column data in memory
+  std::atomic<unsigned long long> nanos[PROFILE_PHASES];       // time spent in each phase
+  std::atomic<unsigned long long> blocks[PROFILE_ALGORITHMS];  // compressed blocks per algorithm
+
+  ColumnProfile();
+};
+
+
+/**
+ Low overhead counters of a single read or write, collected while the profile is selected with a ProfileScope. The
+ time of the operation is divided between the columns and the metadata (the header, column names, chunk indexes
+ and other data outside the columns) and, within those, between the phases of ProfilePhase. The number of bytes
+ and seeks of the file are counted by the profiled inputs and outputs (see FstProfiledInput and FstProfiledOutput).
+
+ Operations without a selected profile only test a thread-local pointer, profiling is disabled by default.
+ */
+class FstProfile
+{
+  std::vector<std::unique_ptr<ColumnProfile>> columns;
+  std::chrono::steady_clock::time_point startTime;
+
+public:
+  ColumnProfile metadata;  // time and I/O outside the columns
+
+  std::atomic<unsigned long long> bytesRead;
+  std::atomic<unsigned long long> bytesWritten;
+  std::atomic<unsigned long long> seeks;
+  unsigned long long totalNanos;  // duration of the operation, see Stop
+
+  FstProfile();
+
+  /**
+   Create the counters of nrOfCols columns (read: the selected columns, write: the table columns). Called from the
+   calling thread before any column is processed.
+   */
+  void SetColumns(unsigned int nrOfCols);
+
+  unsigned int NrOfColumns() { return (unsigned int) columns.size(); }
+
+  /**
+   Counters of column colNr, of the metadata for PROFILE_METADATA or nullptr if the column has no counters.
+   */
+  ColumnProfile* Column(int colNr);
+
+  /**
+   Set the duration of the operation, the time since the profile was created.
+   */
+  void Stop();
+};
+
+#define PROFILE_METADATA -1
+
+
+// Profile, column and phase selected on a thread and the time (in nanoseconds) they were selected
+struct ProfileState
+{
+  FstProfile* profile;
+  ColumnProfile* column;
+  int phase;
+  long long since;
+};
+
+extern thread_local ProfileState profileState;
+
+
+// Add the time since the last switch to the selected column and phase and select column and phase
+void ProfileSwitch(ColumnProfile* column, int phase);
+
+
+/**
+ Selects the profile of the operations on the current thread, during the lifetime of the scope. A nullptr profile
+ disables profiling. Worker threads select the profile of the calling thread.
+ */
+class ProfileScope
+{
+  ProfileState previous;
+
+public:
+  ProfileScope(FstProfile* profile);
+
+  ~ProfileScope();
+
+  /**
+   The profile selected on the current thread, nullptr if operations are not profiled.
+   */
+  static FstProfile* Active() { return profileState.profile; }
+};
+
+
+/**
+ Selects a column (or PROFILE_METADATA) of the active profile on the current thread during the lifetime of the
+ object, with the time spent attributed to phase. Nothing is measured if no profile is active or the column has no
+ counters.
+ */
+class ProfileColumn
+{
+  ColumnProfile* column;  // selected column of the enclosing scope
+  int phase;
+  bool active;
+
+public:
+  ProfileColumn(int colNr, ProfilePhase newPhase) : column(nullptr), phase(0), active(false)
+  {
+    if (profileState.profile == nullptr) return;
+
+    ColumnProfile* newColumn = profileState.profile->Column(colNr);
+    if (newColumn == nullptr) return;
+
+    column = profileState.column;
+    phase = profileState.phase;
+    active = true;
+    ProfileSwitch(newColumn, (int) newPhase);
+  }
+
+  ~ProfileColumn()
+  {
+    if (active) ProfileSwitch(column, phase);
+  }
+};
+
+
+/**
+ Attributes the time spent during the lifetime of the object to phase, for the column selected on the current
+ thread. Nested timers are exclusive, the time of the inner timer is not counted in the outer phase.
+ */
+class ProfileTimer
+{
+  ColumnProfile* column;
+  int phase;
+
+public:
+  ProfileTimer(ProfilePhase newPhase) : column(profileState.column), phase(0)
+  {
+    if (column == nullptr) return;
+
+    phase = profileState.phase;
+    ProfileSwitch(column, (int) newPhase);
+  }
+
+  ~ProfileTimer()
+  {
+    if (column != nullptr) ProfileSwitch(column, phase);
+  }
+};
+
+
+// Count bytes read or written for the column selected on the current thread
+inline void ProfileBytes(unsigned long long nrOfBytes)
+{
+  if (profileState.column != nullptr) profileState.column->bytes.fetch_add(nrOfBytes, std::memory_order_relaxed);
+}
+
+
+// Count bytes of column data in memory for the column selected on the current thread
+inline void ProfileData(unsigned long long nrOfBytes)
+{
+  if (profileState.column != nullptr)
+  {
+    profileState.column->uncompressedBytes.fetch_add(nrOfBytes, std::memory_order_relaxed);
+  }
+}
+
+
+// Count compressed blocks of algorithm algo for the column selected on the current thread
+inline void ProfileBlocks(unsigned int algo, unsigned long long nrOfBlocks = 1)
+{
+  if (profileState.column != nullptr && algo < PROFILE_ALGORITHMS)
+  {
+    profileState.column->blocks[algo].fetch_add(nrOfBlocks, std::memory_order_relaxed);
+  }
+}
+
+
+#endif  // FST_PROFILE_H
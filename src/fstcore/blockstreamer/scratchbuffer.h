@@ -0,0 +1,75 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#ifndef SCRATCH_BUFFER_H
+#define SCRATCH_BUFFER_H
+
+
+#include <vector>
+#include <cstdint>
+
+
+// Scratch buffers for the temporary data of reading and writing blocks
+enum class ScratchSlot
+{
+  BLOCK_INDEX = 0,  // block index of a column
+  BLOCK_BATCH,      // (de)compression buffers of a batch of blocks
+  CHAR_SIZES,       // string sizes and NA bits of a character block
+  CHAR_COMPRESSED,  // compressed data of a character block
+  CHAR_DATA,        // (decompressed) string data of a character block
+  CHAR_STRINGS,     // decoded strings of a front coded character block
+  CHAR_STAGING,     // strings of a character block that don't fit the stack buffer
+  COUNT
+};
+
+
+/**
+ Per-thread scratch buffer of at least size bytes (8 byte aligned). Each thread keeps a single buffer per slot that
+ grows to the largest size requested and is reused for all following blocks and columns, so the read and write
+ paths don't allocate memory per block. The buffer is valid until the next request for the same slot on the same
+ thread and keeps its contents when it grows.
+ */
+inline char* ScratchBuffer(ScratchSlot slot, uint64_t size)
+{
+  static thread_local std::vector<unsigned long long> buffers[static_cast<int>(ScratchSlot::COUNT)];
+
+  std::vector<unsigned long long> &buffer = buffers[static_cast<int>(slot)];
+  if (buffer.size() * 8 < size) buffer.resize((size + 7) / 8);
+
+  return reinterpret_cast<char*>(buffer.data());
+}
+
+
+#endif  // SCRATCH_BUFFER_H
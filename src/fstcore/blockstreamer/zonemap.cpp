@@ -0,0 +1,350 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include "zonemap.h"
+
+#include <cmath>
+#include <climits>
+#include <cstring>
+
+
+using namespace std;
+
+
+ZoneMap::ZoneMap(FstColumnType colType, unsigned long long nrOfRows, unsigned int blockSizeElems)
+{
+  this->colType        = colType;
+  this->blockSizeElems = blockSizeElems;
+  bloomFilter          = nullptr;
+
+  ZoneMapEntry emptyEntry;
+  memset(&emptyEntry, 0, ZONE_MAP_ENTRY_SIZE);
+
+  nrOfBlocks = (nrOfRows + blockSizeElems - 1) / blockSizeElems;
+  entries.assign(nrOfBlocks, emptyEntry);
+}
+
+
+// Statistics of a block of int values (integers, logicals and factor level codes) with NA's stored as INT_MIN
+inline void IntBlockStatistics(ZoneMapEntry &entry, const int* values, unsigned int nrOfElements)
+{
+  int minValue = INT_MAX;
+  int maxValue = INT_MIN;
+  unsigned int naCount = 0;
+
+  for (unsigned int pos = 0; pos < nrOfElements; ++pos)
+  {
+    int value = values[pos];
+
+    if (value == INT_MIN)
+    {
+      ++naCount;
+      continue;
+    }
+
+    if (value < minValue) minValue = value;
+    if (value > maxValue) maxValue = value;
+  }
+
+  entry.naCount = naCount;
+
+  if (naCount != nrOfElements)
+  {
+    entry.minValue = minValue;
+    entry.maxValue = maxValue;
+  }
+}
+
+
+// Statistics of a block of doubles, NA and NaN values are both counted as NA
+inline void DoubleBlockStatistics(ZoneMapEntry &entry, const double* values, unsigned int nrOfElements)
+{
+  double minValue = INFINITY;
+  double maxValue = -INFINITY;
+  unsigned int naCount = 0;
+
+  for (unsigned int pos = 0; pos < nrOfElements; ++pos)
+  {
+    double value = values[pos];
+
+    if (std::isnan(value))
+    {
+      ++naCount;
+      continue;
+    }
+
+    if (value < minValue) minValue = value;
+    if (value > maxValue) maxValue = value;
+  }
+
+  entry.naCount = naCount;
+
+  if (naCount != nrOfElements)
+  {
+    entry.minValue = minValue;
+    entry.maxValue = maxValue;
+  }
+}
+
+
+// Statistics of a block of 64-bit integers with NA's stored as LLONG_MIN (bit64::integer64)
+inline void Int64BlockStatistics(ZoneMapEntry &entry, const long long* values, unsigned int nrOfElements)
+{
+  long long minValue = LLONG_MAX;
+  long long maxValue = LLONG_MIN;
+  unsigned int naCount = 0;
+
+  for (unsigned int pos = 0; pos < nrOfElements; ++pos)
+  {
+    long long value = values[pos];
+
+    if (value == LLONG_MIN)
+    {
+      ++naCount;
+      continue;
+    }
+
+    if (value < minValue) minValue = value;
+    if (value > maxValue) maxValue = value;
+  }
+
+  entry.naCount = naCount;
+
+  if (naCount != nrOfElements)
+  {
+    entry.minInt64 = minValue;
+    entry.maxInt64 = maxValue;
+  }
+}
+
+
+void ZoneMap::AddBlock(unsigned long long blockNr, const char* blockData, unsigned int nrOfElements)
+{
+  ZoneMapEntry &entry = entries[blockNr];
+  entry.nrOfValues = nrOfElements;
+
+  if (bloomFilter != nullptr) bloomFilter->AddBlock(blockNr, blockData, nrOfElements);
+
+  if (ValueType(colType) == FstColumnType::DOUBLE_64)
+  {
+    DoubleBlockStatistics(entry, (const double*) blockData, nrOfElements);
+    return;
+  }
+
+  if (colType == FstColumnType::INT_64)
+  {
+    Int64BlockStatistics(entry, (const long long*) blockData, nrOfElements);
+    return;
+  }
+
+  IntBlockStatistics(entry, (const int*) blockData, nrOfElements);
+}
+
+
+void ZoneMap::AddCharBlock(unsigned long long blockNr, IBlockWriter* blockWriter, unsigned int nrOfElements)
+{
+  ZoneMapEntry &entry = entries[blockNr];
+  entry.nrOfValues = nrOfElements;
+
+  if (bloomFilter != nullptr) bloomFilter->AddCharBlock(blockNr, blockWriter, nrOfElements);
+
+  const unsigned int* strSizes = blockWriter->strSizes;  // cumulative string sizes
+  const unsigned int* naInts   = blockWriter->naInts;
+  const char* buf              = blockWriter->activeBuf;
+
+  char prefix[ZONE_MAP_PREFIX_SIZE];
+  unsigned int naCount = 0;
+  unsigned int strStart = 0;
+
+  for (unsigned int pos = 0; pos < nrOfElements; ++pos)
+  {
+    unsigned int strEnd = strSizes[pos];
+
+    if ((naInts[pos / 32] >> (pos % 32)) & 1)
+    {
+      ++naCount;
+      strStart = strEnd;
+      continue;
+    }
+
+    // Strings are compared on their leading bytes only, padded with zeros
+    unsigned int prefixLength = min(strEnd - strStart, (unsigned int) ZONE_MAP_PREFIX_SIZE);
+    memset(prefix, 0, ZONE_MAP_PREFIX_SIZE);
+    memcpy(prefix, &buf[strStart], prefixLength);
+    strStart = strEnd;
+
+    if (naCount == pos)  // first non-NA value
+    {
+      memcpy(entry.minPrefix, prefix, ZONE_MAP_PREFIX_SIZE);
+      memcpy(entry.maxPrefix, prefix, ZONE_MAP_PREFIX_SIZE);
+      continue;
+    }
+
+    if (memcmp(prefix, entry.minPrefix, ZONE_MAP_PREFIX_SIZE) < 0) memcpy(entry.minPrefix, prefix, ZONE_MAP_PREFIX_SIZE);
+    if (memcmp(prefix, entry.maxPrefix, ZONE_MAP_PREFIX_SIZE) > 0) memcpy(entry.maxPrefix, prefix, ZONE_MAP_PREFIX_SIZE);
+  }
+
+  entry.naCount = naCount;
+}
+
+
+void ZoneMap::Merge(ZoneMapEntry &total) const
+{
+  for (const ZoneMapEntry &entry : entries)
+  {
+    bool totalHasValues = total.naCount != total.nrOfValues;
+    bool entryHasValues = entry.naCount != entry.nrOfValues;
+
+    total.naCount    += entry.naCount;
+    total.nrOfValues += entry.nrOfValues;
+
+    if (!entryHasValues) continue;
+
+    if (colType == FstColumnType::CHARACTER)
+    {
+      if (!totalHasValues || memcmp(entry.minPrefix, total.minPrefix, ZONE_MAP_PREFIX_SIZE) < 0)
+      {
+        memcpy(total.minPrefix, entry.minPrefix, ZONE_MAP_PREFIX_SIZE);
+      }
+
+      if (!totalHasValues || memcmp(entry.maxPrefix, total.maxPrefix, ZONE_MAP_PREFIX_SIZE) > 0)
+      {
+        memcpy(total.maxPrefix, entry.maxPrefix, ZONE_MAP_PREFIX_SIZE);
+      }
+
+      continue;
+    }
+
+    if (colType == FstColumnType::INT_64)
+    {
+      if (!totalHasValues || entry.minInt64 < total.minInt64) total.minInt64 = entry.minInt64;
+      if (!totalHasValues || entry.maxInt64 > total.maxInt64) total.maxInt64 = entry.maxInt64;
+      continue;
+    }
+
+    if (!totalHasValues || entry.minValue < total.minValue) total.minValue = entry.minValue;
+    if (!totalHasValues || entry.maxValue > total.maxValue) total.maxValue = entry.maxValue;
+  }
+}
+
+
+void ZoneMap::Write(ostream &myfile) const
+{
+  unsigned long long meta[2];
+  meta[0] = ZONE_MAP_ID;
+  unsigned int* p_blockSizeElems = (unsigned int*) &meta[1];
+  unsigned int* p_nrOfBlocks     = (unsigned int*) &meta[1] + 1;
+
+  *p_blockSizeElems = blockSizeElems;
+  *p_nrOfBlocks     = (unsigned int) entries.size();
+
+  myfile.write((const char*) entries.data(), ZONE_MAP_ENTRY_SIZE * entries.size());
+  myfile.write((const char*) meta, ZONE_MAP_META_SIZE);
+}
+
+
+bool ZoneMap::ReadMeta(istream &myfile, unsigned long long colPos, FstColumnType colType, unsigned long long nrOfRows)
+{
+  entries.clear();
+  nrOfBlocks = 0;
+
+  if (colPos < ZONE_MAP_META_SIZE)
+  {
+    return false;
+  }
+
+  unsigned long long meta[2];
+  myfile.seekg(colPos - ZONE_MAP_META_SIZE);
+  myfile.read((char*) meta, ZONE_MAP_META_SIZE);
+
+  unsigned int* p_blockSizeElems = (unsigned int*) &meta[1];
+  unsigned int* p_nrOfBlocks     = (unsigned int*) &meta[1] + 1;
+
+  // The zone map should match the column data
+  if (!myfile || meta[0] != ZONE_MAP_ID || *p_blockSizeElems == 0 ||
+    *p_nrOfBlocks != (nrOfRows + *p_blockSizeElems - 1) / *p_blockSizeElems ||
+    colPos < ZONE_MAP_META_SIZE + (unsigned long long) ZONE_MAP_ENTRY_SIZE * *p_nrOfBlocks)
+  {
+    myfile.clear();
+    return false;
+  }
+
+  this->colType  = colType;
+  blockSizeElems = *p_blockSizeElems;
+  nrOfBlocks     = *p_nrOfBlocks;
+
+  return true;
+}
+
+
+bool ZoneMap::Read(istream &myfile, unsigned long long colPos, FstColumnType colType, unsigned long long nrOfRows)
+{
+  if (!ReadMeta(myfile, colPos, colType, nrOfRows))
+  {
+    return false;
+  }
+
+  entries.resize(nrOfBlocks);
+
+  myfile.seekg(colPos - StoredSize());
+  myfile.read((char*) entries.data(), ZONE_MAP_ENTRY_SIZE * nrOfBlocks);
+
+  if (!myfile)
+  {
+    myfile.clear();
+    entries.clear();
+    nrOfBlocks = 0;
+    return false;
+  }
+
+  return true;
+}
+
+
+bool ZoneMap::ReadBlock(istream &myfile, unsigned long long colPos, unsigned long long blockNr,
+  ZoneMapEntry &entry) const
+{
+  myfile.seekg(colPos - StoredSize() + ZONE_MAP_ENTRY_SIZE * blockNr);
+  myfile.read((char*) &entry, ZONE_MAP_ENTRY_SIZE);
+
+  if (!myfile)
+  {
+    myfile.clear();
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,180 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#ifndef ZONE_MAP_H
+#define ZONE_MAP_H
+
+
+#include <ostream>
+#include <istream>
+#include <vector>
+
+#include "ifsttable.h"
+#include "iblockrunner.h"
+#include "bloomfilter.h"
+
+
+#define ZONE_MAP_ID          0x50414d454e4f5a01  // zone map identifier (version 1)
+#define ZONE_MAP_META_SIZE   16                  // identifier, block size and number of blocks
+#define ZONE_MAP_ENTRY_SIZE  24                  // statistics of a single block
+#define ZONE_MAP_PREFIX_SIZE 8                   // number of leading bytes stored for character values
+
+
+/**
+ Statistics of a single block of column data. Numeric values (integer, logical, factor level codes,
+ doubles, dates and timestamps) are stored as doubles. 64-bit integer columns store their statistics as 64-bit
+ integers, which can't be represented exactly by a double. Character columns store the leading
+ ZONE_MAP_PREFIX_SIZE bytes of the smallest and largest string, padded with zeros (bytewise comparison) instead. The minimum and maximum are
+ only defined when the block has at least one non-NA value.
+ */
+struct ZoneMapEntry
+{
+  union
+  {
+    double minValue;
+    long long minInt64;
+    char minPrefix[ZONE_MAP_PREFIX_SIZE];
+  };
+
+  union
+  {
+    double maxValue;
+    long long maxInt64;
+    char maxPrefix[ZONE_MAP_PREFIX_SIZE];
+  };
+
+  unsigned int naCount;     // number of NA values in the block
+  unsigned int nrOfValues;  // number of values in the block
+};
+
+
+/**
+ Per-block statistics (zone map) of the data of a single column in a single data chunk. The zone map is stored
+ directly in front of the column data, ending with its metadata, so it can be located from the column
+ position alone. Readers that are unaware of zone maps never see it.
+
+ The statistics are collected by the column writers while each block is compressed. Blocks can be added from
+ multiple threads, as long as each block is added only once.
+ */
+class ZoneMap
+{
+  FstColumnType colType;
+  unsigned int blockSizeElems;
+  unsigned long long nrOfBlocks;
+  std::vector<ZoneMapEntry> entries;  // empty if only the metadata was read
+  BloomFilter* bloomFilter;           // filters that receive the values of the added blocks, if any
+
+public:
+  ZoneMap() : colType(FstColumnType::UNKNOWN), blockSizeElems(0), nrOfBlocks(0), bloomFilter(nullptr) {}
+
+  /**
+   Prepare a zone map for nrOfRows rows of a column, in blocks of blockSizeElems elements.
+   */
+  ZoneMap(FstColumnType colType, unsigned long long nrOfRows, unsigned int blockSizeElems);
+
+  /**
+   Number of elements in each block (except the last block).
+   */
+  unsigned int BlockSize() const { return blockSizeElems; }
+
+  /**
+   Number of blocks in the zone map.
+   */
+  unsigned long long NrOfBlocks() const { return nrOfBlocks; }
+
+  /**
+   Statistics of a single block.
+   */
+  const ZoneMapEntry &Block(unsigned long long blockNr) const { return entries[blockNr]; }
+
+  /**
+   Bytes used by the zone map in the file.
+   */
+  unsigned long long StoredSize() const { return ZONE_MAP_META_SIZE + ZONE_MAP_ENTRY_SIZE * nrOfBlocks; }
+
+  /**
+   Also add the values of each block added to the zone map to bloomFilter, which should have the same blocks.
+   */
+  void SetBloomFilter(BloomFilter* bloomFilter) { this->bloomFilter = bloomFilter; }
+
+  /**
+   Collect the statistics of a block of fixed width values (int, 64-bit int or double, depending on the column type).
+   */
+  void AddBlock(unsigned long long blockNr, const char* blockData, unsigned int nrOfElements);
+
+  /**
+   Collect the statistics of a block of strings, with the buffers of blockWriter set to the block.
+   */
+  void AddCharBlock(unsigned long long blockNr, IBlockWriter* blockWriter, unsigned int nrOfElements);
+
+  /**
+   Combine the statistics of all blocks with the statistics in total. An entry with zero values can be used
+   to start combining. Level codes of factor columns are combined as integers.
+   */
+  void Merge(ZoneMapEntry &total) const;
+
+  /**
+   Write the zone map at the current stream position. The column data should follow directly after.
+   */
+  void Write(std::ostream &myfile) const;
+
+  /**
+   Read the zone map stored in front of the column data at position colPos.
+
+   @param nrOfRows Number of rows of the column in the data chunk.
+   @return false if no (valid) zone map is stored for the column.
+   */
+  bool Read(std::istream &myfile, unsigned long long colPos, FstColumnType colType, unsigned long long nrOfRows);
+
+  /**
+   Read only the metadata (block size and number of blocks) of the zone map stored in front of the column data.
+   Statistics of single blocks can then be read with ReadBlock, which avoids reading the complete zone map for a
+   few lookups. Block() can't be used on such a zone map.
+
+   @return false if no (valid) zone map is stored for the column.
+   */
+  bool ReadMeta(std::istream &myfile, unsigned long long colPos, FstColumnType colType, unsigned long long nrOfRows);
+
+  /**
+   Read the statistics of a single block of a zone map of which the metadata was read.
+
+   @param colPos Position of the column data, as used to read the metadata.
+   */
+  bool ReadBlock(std::istream &myfile, unsigned long long colPos, unsigned long long blockNr,
+    ZoneMapEntry &entry) const;
+};
+
+
+#endif  // ZONE_MAP_H
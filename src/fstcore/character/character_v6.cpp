@@ -36,8 +36,23 @@ You can contact the author at :
 #include "iblockrunner.h"
 #include "fstdefines.h"
 #include <compressor.h>
+#include <factor_v7.h>
+#include <integer_v8.h>
+#include <stringvectorcolumn.h>
+#include <scratchbuffer.h>
+#include <blockcache.h>
+#include <profile.h>
 
 #include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+#include <climits>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <omp.h>
 
 
 // #include <boost/unordered_map.hpp>
@@ -45,11 +60,14 @@ You can contact the author at :
 using namespace std;
 
 
-inline unsigned int StoreCharBlock_v6(ofstream &myfile, IBlockWriter* blockRunner, unsigned int startCount, unsigned int endCount)
+inline unsigned int StoreCharBlock_v6(ostream &myfile, IBlockWriter* blockRunner, unsigned long long startCount,
+  unsigned long long endCount, unsigned int blockSizeChar, ZoneMap* zoneMap)
 {
   blockRunner->SetBuffersFromVec(startCount, endCount);
 
-  unsigned int nrOfElements = endCount - startCount;  // the string at position endCount is not included
+  unsigned int nrOfElements = static_cast<unsigned int>(endCount - startCount);  // the string at position endCount is not included
+
+  if (zoneMap != nullptr) zoneMap->AddCharBlock(startCount / blockSizeChar, blockRunner, nrOfElements);
   unsigned int nrOfNAInts = 1 + nrOfElements / 32;  // add 1 bit for NA present flag
 
   myfile.write((char*)(blockRunner->strSizes), nrOfElements * 4);  // write string lengths
@@ -58,73 +76,507 @@ inline unsigned int StoreCharBlock_v6(ofstream &myfile, IBlockWriter* blockRunne
   unsigned int totSize = blockRunner->bufSize;
 
   myfile.write(blockRunner->activeBuf, totSize);
+  ProfileBlocks(0);
 
   return totSize + (nrOfElements + nrOfNAInts) * 4;
 
 }
 
 
-inline unsigned int storeCharBlockCompressed_v6(ofstream &myfile, IBlockWriter* blockRunner, unsigned int startCount,
-  unsigned int endCount, StreamCompressor* intCompressor, StreamCompressor* charCompressor, unsigned short int &algoInt,
-  unsigned short int &algoChar, int &intBufSize)
+// Buffers of the compressed blocks of a character column, reused for all blocks and columns
+struct CharBlockBuffers
 {
-  // Determine string lengths
-  unsigned int nrOfElements = endCount - startCount;  // the string at position endCount is not included
-  unsigned int nrOfNAInts = 1 + nrOfElements / 32;  // add 1 bit for NA present flag
+  vector<char> intBuf;
+  vector<char> compBuf;
+  vector<unsigned int> frontSizes;  // cumulative suffix sizes of a front coded block
+  vector<char> frontBuf;            // prefix lengths and suffixes of a front coded block
+  unsigned int frontSize;
+
+  // Compressed block (see CompressCharBlock_v6)
+  int intSize;
+  const char* charData;  // compressed character data or the stored data itself
+  int charSize;
+  CompAlgo algoInt;
+  CompAlgo algoChar;
+  bool frontCoded;
+};
+
+
+// Front code the strings of a block (as in sorted key columns): each string is stored as the length of the prefix it
+// shares with the previous string (2 bytes) and the remaining suffix. The prefix lengths precede the suffixes. Every
+// CHAR_FRONT_RESTART strings a complete string is stored (a restart point), so strings can be decoded starting from
+// the nearest restart point. Returns false if front coding reduces the character data by less than a quarter.
+inline bool FrontEncode_v6(IBlockWriter* blockRunner, unsigned int nrOfElements, CharBlockBuffers &buffers)
+{
+  const unsigned int* strSizes = blockRunner->strSizes;
+  const char* buf = blockRunner->activeBuf;
+  unsigned int totSize = blockRunner->bufSize;
+
+  buffers.frontSizes.resize(nrOfElements);
+  buffers.frontBuf.resize(2 * nrOfElements + totSize);
+
+  unsigned short int* prefixLengths = (unsigned short int*) buffers.frontBuf.data();
+  char* suffixes = &buffers.frontBuf[2 * nrOfElements];
+
+  unsigned int prevStart = 0;
+  unsigned int prevEnd = 0;
+  unsigned int strStart = 0;
+  unsigned int suffixSize = 0;
+
+  for (unsigned int pos = 0; pos < nrOfElements; ++pos)
+  {
+    unsigned int strEnd = strSizes[pos];
+    unsigned int prefix = 0;
+
+    if (pos % CHAR_FRONT_RESTART != 0)
+    {
+      unsigned int maxPrefix = min(min(strEnd - strStart, prevEnd - prevStart), 65535u);
+      while (prefix < maxPrefix && buf[strStart + prefix] == buf[prevStart + prefix]) ++prefix;
+    }
+
+    prefixLengths[pos] = (unsigned short int) prefix;
+    memcpy(&suffixes[suffixSize], &buf[strStart + prefix], strEnd - strStart - prefix);
+    suffixSize += strEnd - strStart - prefix;
+    buffers.frontSizes[pos] = suffixSize;
+
+    prevStart = strStart;
+    prevEnd = strEnd;
+    strStart = strEnd;
+  }
+
+  buffers.frontSize = 2 * nrOfElements + suffixSize;
+
+  return buffers.frontSize <= totSize - totSize / 4;
+}
 
 
+// Compress the string sizes and character data of a block with the compressors selected for the block. Without a
+// character data compressor, the data is stored uncompressed. Uses only the buffers of the block, so different
+// blocks can be compressed concurrently.
+inline void CompressCharBlock_v6(IBlockWriter* blockRunner, unsigned int nrOfElements, Compressor* intCompressor,
+  Compressor* charCompressor, CharBlockBuffers &buffers)
+{
+  // Blocks with long shared prefixes store the sizes of the suffixes
+  buffers.frontCoded = FrontEncode_v6(blockRunner, nrOfElements, buffers);
+  unsigned int* strSizes = buffers.frontCoded ? buffers.frontSizes.data() : blockRunner->strSizes;
+
   // Compress string size vector
   unsigned int strSizesBufLength = nrOfElements * 4;
 
-  // 1) Use stack buffer here !!!!!!
-  // 2) compress to 1 or 2 bytes if possible with strSizesBufLength
-  int bufSize = intCompressor->CompressBufferSize(strSizesBufLength);  // 1 integer per string
-  char *intBuf = new char[bufSize];
+  buffers.intBuf.resize(intCompressor->CompressBufferSize(strSizesBufLength));  // 1 integer per string
+  buffers.intSize = intCompressor->Compress(buffers.intBuf.data(), static_cast<unsigned int>(buffers.intBuf.size()),
+    (char*) strSizes, strSizesBufLength, buffers.algoInt);
+
+  const char* charData = buffers.frontCoded ? buffers.frontBuf.data() : blockRunner->activeBuf;
+  unsigned int totSize = buffers.frontCoded ? buffers.frontSize : blockRunner->bufSize;
+
+  if (charCompressor == nullptr)  // uncompressed
+  {
+    buffers.charData = charData;
+    buffers.charSize = totSize;
+    buffers.algoChar = CompAlgo::UNCOMPRESS;
+    return;
+  }
+
+  // Compress buffer
+  buffers.compBuf.resize(charCompressor->CompressBufferSize(totSize));
+  buffers.charSize = charCompressor->Compress(buffers.compBuf.data(), static_cast<unsigned int>(buffers.compBuf.size()),
+    charData, totSize, buffers.algoChar);
+  buffers.charData = buffers.compBuf.data();
+}
+
+
+// Write a block compressed with CompressCharBlock_v6: the compressed string sizes, the NA bits (only for blocks that
+// contain NA's) and the character data. Sets the algorithms and size of the block index entry.
+inline unsigned int WriteCharBlock_v6(ostream &myfile, IBlockWriter* blockRunner, unsigned int nrOfElements,
+  const CharBlockBuffers &buffers, unsigned short int &algoInt, unsigned short int &algoChar, int &intBufSize)
+{
+  unsigned int nrOfNAInts = 1 + nrOfElements / 32;  // add 1 bit for NA present flag
+
+  myfile.write(buffers.intBuf.data(), buffers.intSize);
+  intBufSize = buffers.intSize;
+  algoInt = (unsigned short int) (buffers.algoInt);  // store selected algorithm
+
+  unsigned int naSize = 0;
+  if ((blockRunner->naInts[nrOfNAInts - 1] >> (nrOfElements % 32)) & 1)
+  {
+    naSize = nrOfNAInts * 4;
+    myfile.write((char*)(blockRunner->naInts), naSize);  // write NA bits
+  }
+  else
+  {
+    algoInt |= CHAR_NO_NA_BITS;
+  }
+
+  myfile.write(buffers.charData, buffers.charSize);
+
+  algoChar = (unsigned short int) (buffers.algoChar);  // store selected algorithm
+  ProfileBlocks(algoChar);
+  if (buffers.frontCoded) algoChar |= CHAR_FRONT_CODED;
+
+  return naSize + buffers.charSize + buffers.intSize;
+}
+
+
+inline unsigned int storeCharBlockCompressed_v6(ostream &myfile, IBlockWriter* blockRunner, unsigned long long startCount,
+  unsigned long long endCount, StreamCompressor* intCompressor, StreamCompressor* charCompressor, unsigned short int &algoInt,
+  unsigned short int &algoChar, int &intBufSize, CharBlockBuffers &buffers)
+{
+  unsigned int nrOfElements = static_cast<unsigned int>(endCount - startCount);  // the string at position endCount is not included
+
+  CompressCharBlock_v6(blockRunner, nrOfElements, intCompressor->NextBlockCompressor(),
+    charCompressor->NextBlockCompressor(), buffers);
+
+  return WriteCharBlock_v6(myfile, blockRunner, nrOfElements, buffers, algoInt, algoChar, intBufSize);
+}
+
+
+// The strings of a block assembled from the string pointers gathered by the column writer (see
+// IBlockWriter::GatherStrings), so the strings can be copied on a worker thread
+class CharBlockPayload : public IBlockWriter
+{
+  vector<const char*> strings;
+  vector<unsigned int> sizeBuf;
+  vector<unsigned int> naBuf;
+  vector<char> charBuf;
+
+public:
+  unsigned int nrOfElements;
+
+  CharBlockPayload(unsigned int blockSize) : strings(blockSize), sizeBuf(blockSize), naBuf(1 + blockSize / 32)
+  {
+    strSizes = nullptr;
+    naInts = nullptr;
+    bufSize = 0;
+    activeBuf = nullptr;
+    vecLength = 0;
+    nrOfElements = 0;
+  }
+
+  bool Gather(IBlockWriter* blockRunner, unsigned long long startCount, unsigned long long endCount)
+  {
+    strSizes = sizeBuf.data();  // (copied) payloads use their own buffers
+    naInts = naBuf.data();
+    nrOfElements = static_cast<unsigned int>(endCount - startCount);
+    return blockRunner->GatherStrings(startCount, endCount, strings.data(), strSizes, naInts);
+  }
+
+  // Copy the strings to the block buffer, replacing the gathered sizes by the cumulative sizes
+  void Assemble()
+  {
+    unsigned long long totSize = 0;
+    for (unsigned int pos = 0; pos < nrOfElements; ++pos) totSize += strSizes[pos];
+
+    charBuf.resize(totSize + 1);  // non-empty buffer
+
+    unsigned int strEnd = 0;
+    for (unsigned int pos = 0; pos < nrOfElements; ++pos)
+    {
+      unsigned int strSize = strSizes[pos];
+      if (strSize != 0) memcpy(&charBuf[strEnd], strings[pos], strSize);
+      strEnd += strSize;
+      strSizes[pos] = strEnd;
+    }
+
+    activeBuf = charBuf.data();
+    bufSize = strEnd;
+  }
+
+  void SetBuffersFromVec(unsigned long long, unsigned long long) {}  // see Gather and Assemble
+};
+
+
+// Write the compressed blocks of a character column in batches. The calling thread gathers the string pointers of
+// the blocks of a batch (the column writer might only be accessible from that thread) and selects their compressors
+// in block order. Worker threads copy the strings to the block buffers, add the blocks to the zone map and compress
+// them, after which the calling thread writes the blocks in order. The result is identical to a serial write.
+// Returns false without writing if the column writer doesn't provide string pointers.
+inline bool WriteCharBlocksParallel_v6(ostream &myfile, IBlockWriter* blockRunner, unsigned int blockSizeChar,
+  unsigned long long nrOfBlocks, StreamCompressor* intCompressor, StreamCompressor* charCompressor, ZoneMap* zoneMap,
+  char* blockP, unsigned long long &fullSize, int nrOfThreads)
+{
+  unsigned long long vecLength = blockRunner->vecLength;
+  int batchSize = CHAR_WRITE_BATCH * nrOfThreads;  // number of blocks per batch
+
+  vector<CharBlockPayload> payloads(batchSize, CharBlockPayload(blockSizeChar));
+  vector<CharBlockBuffers> buffers(batchSize);
+  vector<Compressor*> intCompressors(batchSize);
+  vector<Compressor*> charCompressors(batchSize);
+
+  for (unsigned long long batchStart = 0; batchStart <= nrOfBlocks; batchStart += batchSize)
+  {
+    int nrOfBatchBlocks = static_cast<int>(min((unsigned long long) batchSize, nrOfBlocks + 1 - batchStart));
+
+    for (int block = 0; block < nrOfBatchBlocks; ++block)
+    {
+      unsigned long long startCount = (batchStart + block) * blockSizeChar;
+      unsigned long long endCount = min(startCount + blockSizeChar, vecLength);
+
+      if (!payloads[block].Gather(blockRunner, startCount, endCount)) return false;  // fails on the first block
+    }
+
+    for (int block = 0; block < nrOfBatchBlocks; ++block)
+    {
+      intCompressors[block] = intCompressor->NextBlockCompressor();
+      charCompressors[block] = charCompressor->NextBlockCompressor();
+    }
+
+    // The compressors of character columns are stateless
+#pragma omp parallel for schedule(dynamic) num_threads(nrOfThreads)
+    for (int block = 0; block < nrOfBatchBlocks; ++block)
+    {
+      CharBlockPayload &payload = payloads[block];
+      payload.Assemble();
+
+      if (zoneMap != nullptr) zoneMap->AddCharBlock(batchStart + block, &payload, payload.nrOfElements);
+
+      CompressCharBlock_v6(&payload, payload.nrOfElements, intCompressors[block], charCompressors[block],
+        buffers[block]);
+    }
+
+    for (int block = 0; block < nrOfBatchBlocks; ++block)
+    {
+      unsigned long long* blockPos = (unsigned long long*) blockP;
+      unsigned short int* algoInt  = (unsigned short int*) (blockP + 8);
+      unsigned short int* algoChar = (unsigned short int*) (blockP + 10);
+      int* intBufSize = (int*) (blockP + 12);
+
+      fullSize += WriteCharBlock_v6(myfile, &payloads[block], payloads[block].nrOfElements, buffers[block], *algoInt,
+        *algoChar, *intBufSize);
+
+      *blockPos = fullSize;
+      blockP += CHAR_INDEX_SIZE;  // advance one block index entry
+    }
+  }
+
+  return true;
+}
+
+
+unsigned int fdsCharBlockSize_v6(IBlockWriter* blockRunner)
+{
+  unsigned long long vecLength = blockRunner->vecLength;
+
+  if (vecLength == 0) return BLOCKSIZE_CHAR;
+
+  // Average string size from a few small samples spread over the vector, so long strings are never buffered in bulk
+  unsigned long long nrOfSamples = min((unsigned long long) CHAR_SIZE_SAMPLES, 1 + (vecLength - 1) / CHAR_SAMPLE_ROWS);
+  unsigned long long nrOfBytes = 0;
+  unsigned long long nrOfElements = 0;
+
+  for (unsigned long long sample = 0; sample < nrOfSamples; ++sample)
+  {
+    unsigned long long startCount = (sample * vecLength) / nrOfSamples;
+    unsigned long long endCount = min(startCount + CHAR_SAMPLE_ROWS, vecLength);
+
+    blockRunner->SetBuffersFromVec(startCount, endCount);
+
+    nrOfBytes += blockRunner->bufSize;
+    nrOfElements += endCount - startCount;
+  }
+
+  unsigned long long blockSize = (CHAR_BLOCK_BYTES * nrOfElements) / max(nrOfBytes, 1ULL);
+
+  return static_cast<unsigned int>(max((unsigned long long) CHAR_MIN_BLOCK_SIZE,
+    min(blockSize, (unsigned long long) CHAR_MAX_BLOCK_SIZE)));
+}
+
+
+// Build a raw content dictionary from the character data of blocks spread evenly over the vector. Strings of a column
+// tend to share a vocabulary, so the blocks can reference the dictionary content where ZSTD would otherwise need to
+// store literals. Later samples are closest to the end of the dictionary and are referenced most efficiently.
+inline void BuildCharDictionary_v6(IBlockWriter* blockRunner, unsigned long long nrOfBlocks, unsigned int blockSizeChar,
+  vector<char> &dictionary)
+{
+  unsigned long long vecLength = blockRunner->vecLength;
+  unsigned long long nrOfSamples = min(nrOfBlocks + 1, (unsigned long long) CHAR_DICT_SAMPLES);
+  unsigned int sampleSize = static_cast<unsigned int>(CHAR_DICT_SIZE / nrOfSamples);
+
+  dictionary.clear();
 
+  for (unsigned long long sample = 0; sample < nrOfSamples; ++sample)
+  {
+    unsigned long long block = (sample * (nrOfBlocks + 1)) / nrOfSamples;
+    unsigned long long startCount = block * blockSizeChar;
+    unsigned long long endCount = min(startCount + blockSizeChar, vecLength);
+
+    blockRunner->SetBuffersFromVec(startCount, endCount);
+
+    unsigned int size = min(sampleSize, blockRunner->bufSize);
+    dictionary.insert(dictionary.end(), blockRunner->activeBuf, blockRunner->activeBuf + size);
+  }
+}
+
+
+// The dictionary is stored with the column, so it's only used when the projected reduction of the compressed size of all
+// blocks exceeds the dictionary size. The reduction is measured on probe blocks located in between the sampled blocks.
+inline bool CharDictionaryGain_v6(IBlockWriter* blockRunner, unsigned long long nrOfBlocks, unsigned int blockSizeChar,
+  const vector<char> &dictionary, int compression)
+{
+  unsigned long long vecLength = blockRunner->vecLength;
+  ZstdDictCompressor dictCompressor(dictionary.data(), static_cast<unsigned int>(dictionary.size()), compression);
+  SingleCompressor compressor(CompAlgo::ZSTD, compression);
+
+  long long gain = 0;
+  vector<char> compBuf;
   CompAlgo compAlgorithm;
-  intBufSize = intCompressor->Compress(myfile, (char*)(blockRunner->strSizes), strSizesBufLength, intBuf, compAlgorithm);
-  algoInt = (unsigned short int) (compAlgorithm);  // store selected algorithm
 
-  // Write NA bits uncompressed (add compression later ?)
-  myfile.write((char*)(blockRunner->naInts), nrOfNAInts * 4);  // write string lengths
+  for (unsigned long long probe = 0; probe < CHAR_DICT_PROBES; ++probe)
+  {
+    unsigned long long block = ((2 * probe + 1) * (nrOfBlocks + 1)) / (2 * CHAR_DICT_PROBES);
+    unsigned long long startCount = block * blockSizeChar;
+    unsigned long long endCount = min(startCount + blockSizeChar, vecLength);
 
-  unsigned int totSize = blockRunner->bufSize;
+    blockRunner->SetBuffersFromVec(startCount, endCount);
 
-  int compBufSize = charCompressor->CompressBufferSize(totSize);
-  // unsigned int pos = 0;
-  // unsigned int lastPos = 0;
-  // int sizeCount = -1;
-  char* compBuf = new char[compBufSize];  // character buffer   check if reuse possible?
+    unsigned int bufSize = blockRunner->bufSize;
+    compBuf.resize(compressor.CompressBufferSize(bufSize));
 
+    gain += compressor.Compress(compBuf.data(), static_cast<unsigned int>(compBuf.size()), blockRunner->activeBuf, bufSize,
+      compAlgorithm);
+    gain -= dictCompressor.Compress(compBuf.data(), static_cast<unsigned int>(compBuf.size()), blockRunner->activeBuf,
+      bufSize, compAlgorithm);
+  }
 
-  // Compress buffer
-  int resSize = charCompressor->Compress(myfile, blockRunner->activeBuf, totSize, compBuf, compAlgorithm);
+  return gain * static_cast<long long>(nrOfBlocks + 1) > static_cast<long long>(dictionary.size()) * CHAR_DICT_PROBES;
+}
+
+
+// Block writer for the levels of a character column stored as level codes
+class LevelBlockWriter : public IBlockWriter
+{
+  std::vector<unsigned int> sizeBuf;
+  std::vector<unsigned int> naBuf;
+  std::vector<char> charBuf;
+
+public:
+  std::vector<std::string> levels;
+
+  LevelBlockWriter() : sizeBuf(CHAR_MAX_BLOCK_SIZE), naBuf(1 + CHAR_MAX_BLOCK_SIZE / 32, 0)
+  {
+    strSizes = sizeBuf.data();
+    naInts = naBuf.data();
+    vecLength = 0;
+  }
+
+  void SetBuffersFromVec(unsigned long long startCount, unsigned long long endCount)
+  {
+    charBuf.clear();
+
+    for (unsigned long long count = startCount; count < endCount; ++count)
+    {
+      charBuf.insert(charBuf.end(), levels[count].begin(), levels[count].end());
+      strSizes[count - startCount] = static_cast<unsigned int>(charBuf.size());
+    }
+
+    charBuf.push_back(0);  // non-empty buffer
+    activeBuf = charBuf.data();
+    bufSize = static_cast<unsigned int>(charBuf.size() - 1);
+  }
+};
+
+
+// Store a column with few distinct strings as its levels (in order of appearance) and level codes, using the layout of a
+// factor column. Returns false without writing if the column has more distinct strings than can be stored efficiently.
+inline bool StoreCharLevels_v6(ostream &myfile, IBlockWriter* blockRunner, int compression, unsigned int blockSizeChar,
+  ZoneMap* zoneMap)
+{
+  unsigned long long vecLength = blockRunner->vecLength;
+  unsigned long long nrOfBlocks = (vecLength - 1) / blockSizeChar;  // number of blocks minus 1
+  size_t maxLevels = static_cast<size_t>(min((unsigned long long) CHAR_LEVEL_MAX, vecLength / CHAR_LEVEL_REPEATS));
+
+  LevelBlockWriter levelWriter;
+  unordered_map<string, int> levelCodes;
+  vector<int> codes(vecLength);
+  string str;
+
+  for (unsigned long long block = 0; block <= nrOfBlocks; ++block)
+  {
+    unsigned long long startCount = block * blockSizeChar;
+    unsigned long long endCount = min(startCount + blockSizeChar, vecLength);
+    unsigned int nrOfElements = static_cast<unsigned int>(endCount - startCount);
+
+    blockRunner->SetBuffersFromVec(startCount, endCount);
+
+    const unsigned int* strSizes = blockRunner->strSizes;
+    const unsigned int* naInts = blockRunner->naInts;
+    int* blockCodes = &codes[startCount];
+    unsigned int strStart = 0;
+
+    for (unsigned int pos = 0; pos < nrOfElements; ++pos)
+    {
+      unsigned int strEnd = strSizes[pos];
+
+      if ((naInts[pos / 32] >> (pos % 32)) & 1)
+      {
+        blockCodes[pos] = INT_MIN;
+        strStart = strEnd;
+        continue;
+      }
 
-  algoChar = (unsigned short int) (compAlgorithm);  // store selected algorithm
+      str.assign(&blockRunner->activeBuf[strStart], strEnd - strStart);
+      strStart = strEnd;
 
-  delete[] compBuf;
-  delete[] intBuf;
+      unordered_map<string, int>::const_iterator level = levelCodes.find(str);
 
-  return nrOfNAInts * 4 + resSize + intBufSize;
+      if (level != levelCodes.end())
+      {
+        blockCodes[pos] = level->second;
+        continue;
+      }
+
+      if (levelCodes.size() == maxLevels) return false;  // too many distinct strings
+
+      int code = static_cast<int>(levelCodes.size()) + 1;
+      levelCodes[str] = code;
+      levelWriter.levels.push_back(str);
+      blockCodes[pos] = code;
+    }
+
+    if (zoneMap != nullptr) zoneMap->AddCharBlock(block, blockRunner, nrOfElements);
+  }
+
+  if (levelCodes.empty()) return false;  // only NA's
+
+  // Set column header
+  unsigned int meta[2];
+  meta[0] = 3;  // level codes flag
+  meta[1] = blockSizeChar;
+  myfile.write((char*) meta, CHAR_HEADER_SIZE);
+
+  levelWriter.vecLength = levelWriter.levels.size();
+  fdsWriteFactorVec_v7(myfile, codes.data(), &levelWriter, vecLength, compression, 1, BLOCKSIZE_INT);
+
+  return true;
 }
 
 
-void fdsWriteCharVec_v6(ofstream &myfile, IBlockWriter* blockRunner, int compression)
+void fdsWriteCharVec_v6(ostream &myfile, IBlockWriter* blockRunner, int compression, ZoneMap* zoneMap,
+  int nrOfThreads)
 {
-  unsigned int vecLength = blockRunner->vecLength;
+  unsigned long long vecLength = blockRunner->vecLength;
+
+  // The block size of the zone map is the block size of the column
+  unsigned int blockSizeChar = zoneMap != nullptr ? zoneMap->BlockSize() : fdsCharBlockSize_v6(blockRunner);
+
+  // Columns with a small number of distinct strings are stored as level codes, which are much faster to read
+  if (vecLength >= CHAR_LEVEL_MIN_ROWS && StoreCharLevels_v6(myfile, blockRunner, compression, blockSizeChar, zoneMap))
+  {
+    return;
+  }
 
   unsigned long long curPos = myfile.tellp();
-  unsigned int nrOfBlocks = (vecLength - 1) / BLOCKSIZE_CHAR;  // number of blocks minus 1
+  unsigned long long nrOfBlocks = (vecLength - 1) / blockSizeChar;  // number of blocks minus 1
 
   if (compression == 0)
   {
-    unsigned int metaSize = CHAR_HEADER_SIZE + (nrOfBlocks + 1) * 8;
+    unsigned long long metaSize = CHAR_HEADER_SIZE + (nrOfBlocks + 1) * 8;
     char *meta = new char[metaSize];  // first CHAR_HEADER_SIZE bytes store compression setting and block size
 
     // Set column header
     unsigned int* isCompressed  = (unsigned int*) meta;
-    unsigned int* blockSizeChar = (unsigned int*) &meta[4];
-    *blockSizeChar = BLOCKSIZE_CHAR;
+    unsigned int* blockSizeMeta = (unsigned int*) &meta[4];
+    *blockSizeMeta = blockSizeChar;
     *isCompressed = 0;
 
     myfile.write(meta, metaSize);  // write block offset index
@@ -132,19 +584,22 @@ void fdsWriteCharVec_v6(ofstream &myfile, IBlockWriter* blockRunner, int compres
     unsigned long long* blockPos = (unsigned long long*) &meta[CHAR_HEADER_SIZE];
     unsigned long long fullSize = metaSize;
 
-    for (unsigned int block = 0; block < nrOfBlocks; ++block)
+    for (unsigned long long block = 0; block < nrOfBlocks; ++block)
     {
-      unsigned int totSize = StoreCharBlock_v6(myfile, blockRunner, block * BLOCKSIZE_CHAR, (block + 1) * BLOCKSIZE_CHAR);
+      unsigned int totSize = StoreCharBlock_v6(myfile, blockRunner, block * blockSizeChar, (block + 1) * blockSizeChar,
+        blockSizeChar, zoneMap);
       fullSize += totSize;
       blockPos[block] = fullSize;
     }
 
-    unsigned int totSize = StoreCharBlock_v6(myfile, blockRunner, nrOfBlocks * BLOCKSIZE_CHAR, vecLength);
+    unsigned int totSize = StoreCharBlock_v6(myfile, blockRunner, nrOfBlocks * blockSizeChar, vecLength, blockSizeChar,
+      zoneMap);
     fullSize += totSize;
     blockPos[nrOfBlocks] = fullSize;
 
-    myfile.seekp(curPos + CHAR_HEADER_SIZE);
-    myfile.write((char*)(blockPos), (nrOfBlocks + 1) * 8);  // additional zero for index convenience
+    // The complete header is rewritten, so the rewrite covers the range of the first write (see ChecksumStreamBuf)
+    myfile.seekp(curPos);
+    myfile.write(meta, metaSize);  // block offset index
     myfile.seekp(curPos + fullSize);  // back to end of file
 
     delete[] meta;
@@ -155,14 +610,22 @@ void fdsWriteCharVec_v6(ofstream &myfile, IBlockWriter* blockRunner, int compres
 
   // Use compression
 
-  unsigned int metaSize = CHAR_HEADER_SIZE + (nrOfBlocks + 1) * CHAR_INDEX_SIZE;  // 1 long and 2 unsigned int per block
+  // At high compression settings, columns with many blocks are compressed with a dictionary shared by all blocks
+  vector<char> dictionary;
+  if (compression > 50 && nrOfBlocks + 1 >= CHAR_DICT_MIN_BLOCKS)
+  {
+    BuildCharDictionary_v6(blockRunner, nrOfBlocks, blockSizeChar, dictionary);
+    if (!CharDictionaryGain_v6(blockRunner, nrOfBlocks, blockSizeChar, dictionary, 20)) dictionary.clear();
+  }
+
+  unsigned long long metaSize = CHAR_HEADER_SIZE + (nrOfBlocks + 1) * CHAR_INDEX_SIZE;  // 1 long and 2 unsigned int per block
   char *meta = new char[metaSize];
 
   // Set column header
   unsigned int* isCompressed  = (unsigned int*) meta;
-  unsigned int* blockSizeChar = (unsigned int*) &meta[4];
-  *blockSizeChar = BLOCKSIZE_CHAR;
-  *isCompressed = 1;  // set compression flag
+  unsigned int* blockSizeMeta = (unsigned int*) &meta[4];
+  *blockSizeMeta = blockSizeChar;
+  *isCompressed = dictionary.empty() ? 1 : 2;  // set compression flag, 2 for a dictionary following the index
 
   myfile.write(meta, metaSize);  // write block offset and algorithm index
 
@@ -170,65 +633,100 @@ void fdsWriteCharVec_v6(ofstream &myfile, IBlockWriter* blockRunner, int compres
 
   unsigned long long fullSize = metaSize;
 
+  if (!dictionary.empty())
+  {
+    unsigned int dictSize = static_cast<unsigned int>(dictionary.size());
+    myfile.write((char*) &dictSize, 4);  // dictionary size
+    myfile.write(dictionary.data(), dictSize);
+    fullSize += 4 + dictSize;
+  }
+
   // Compressors
   Compressor* compressInt;
-  Compressor* compressInt2 = nullptr;
+  Compressor* compressInt2;
   StreamCompressor* streamCompressInt = nullptr;
   Compressor* compressChar = nullptr;
   Compressor* compressChar2 = nullptr;
   StreamCompressor* streamCompressChar;
 
-  // Compression settings
+  // The cumulative string sizes are delta encoded to bit-packed string lengths, the fallback compressor is only used
+  // for blocks with strings too long for the delta codes
   if (compression <= 50)
   {
-    // Integer vector compressor
     compressInt = new SingleCompressor(CompAlgo::LZ4_SHUF4, 0);
-    streamCompressInt = new StreamLinearCompressor(compressInt, 2 * compression);
+    compressInt2 = new DeltaCompressor(CompAlgo::INT_DELTA, compressInt, 0);
+  }
+  else
+  {
+    compressInt = new SingleCompressor(CompAlgo::ZSTD_SHUF4, 0);
+    compressInt2 = new DeltaCompressor(CompAlgo::LZ4_INT_DELTA, compressInt, 0);
+  }
+
+  streamCompressInt = new StreamSingleCompressor(compressInt2);
 
+  // Compression settings
+  if (compression <= 50)
+  {
     // Character vector compressor
     compressChar = new SingleCompressor(CompAlgo::LZ4, 20);
     streamCompressChar = new StreamLinearCompressor(compressChar, 2 * compression);  // unknown blockSize
   } else  // 51 - 100
   {
-    // Integer vector compressor
-    compressInt = new SingleCompressor(CompAlgo::LZ4_SHUF4, 0);
-    compressInt2 = new SingleCompressor(CompAlgo::ZSTD_SHUF4, 0);
-    streamCompressInt = new StreamCompositeCompressor(compressInt, compressInt2, 2 * (compression - 50));
 
     // Character vector compressor
     compressChar = new SingleCompressor(CompAlgo::LZ4, 20);
-    compressChar2 = new SingleCompressor(CompAlgo::ZSTD, 20);
+
+    if (dictionary.empty())
+    {
+      compressChar2 = new SingleCompressor(CompAlgo::ZSTD, 20);
+    }
+    else
+    {
+      compressChar2 = new ZstdDictCompressor(dictionary.data(), static_cast<unsigned int>(dictionary.size()), 20);
+    }
+
     streamCompressChar = new StreamCompositeCompressor(compressChar, compressChar2, 2 * (compression - 50));
   }
 
-  for (unsigned int block = 0; block < nrOfBlocks; ++block)
+  // Blocks are compressed on worker threads if the column writer provides string pointers
+  if (nrOfThreads < 2 || nrOfBlocks + 1 < CHAR_PIPELINE_MIN_BLOCKS || !WriteCharBlocksParallel_v6(myfile, blockRunner,
+    blockSizeChar, nrOfBlocks, streamCompressInt, streamCompressChar, zoneMap, blockP, fullSize, nrOfThreads))
   {
+    static thread_local CharBlockBuffers buffers;
+
+    for (unsigned long long block = 0; block < nrOfBlocks; ++block)
+    {
+      unsigned long long* blockPos = (unsigned long long*) blockP;
+      unsigned short int* algoInt  = (unsigned short int*) (blockP + 8);
+      unsigned short int* algoChar = (unsigned short int*) (blockP + 10);
+      int* intBufSize = (int*) (blockP + 12);
+
+      blockRunner->SetBuffersFromVec(block * blockSizeChar, (block + 1) * blockSizeChar);
+      if (zoneMap != nullptr) zoneMap->AddCharBlock(block, blockRunner, blockSizeChar);
+
+      unsigned int totSize = storeCharBlockCompressed_v6(myfile, blockRunner, block * blockSizeChar,
+        (block + 1) * blockSizeChar, streamCompressInt, streamCompressChar, *algoInt, *algoChar, *intBufSize, buffers);
+
+      fullSize += totSize;
+      *blockPos = fullSize;
+      blockP += CHAR_INDEX_SIZE;  // advance one block index entry
+    }
+
     unsigned long long* blockPos = (unsigned long long*) blockP;
     unsigned short int* algoInt  = (unsigned short int*) (blockP + 8);
     unsigned short int* algoChar = (unsigned short int*) (blockP + 10);
     int* intBufSize = (int*) (blockP + 12);
 
-    blockRunner->SetBuffersFromVec(block * BLOCKSIZE_CHAR, (block + 1) * BLOCKSIZE_CHAR);
-    unsigned int totSize = storeCharBlockCompressed_v6(myfile, blockRunner, block * BLOCKSIZE_CHAR,
-      (block + 1) * BLOCKSIZE_CHAR, streamCompressInt, streamCompressChar, *algoInt, *algoChar, *intBufSize);
+    blockRunner->SetBuffersFromVec(nrOfBlocks * blockSizeChar, vecLength);
+    if (zoneMap != nullptr) zoneMap->AddCharBlock(nrOfBlocks, blockRunner, (unsigned int) (vecLength - nrOfBlocks * blockSizeChar));
+
+    unsigned int totSize = storeCharBlockCompressed_v6(myfile, blockRunner, nrOfBlocks * blockSizeChar,
+      vecLength, streamCompressInt, streamCompressChar, *algoInt, *algoChar, *intBufSize, buffers);
 
     fullSize += totSize;
     *blockPos = fullSize;
-    blockP += CHAR_INDEX_SIZE;  // advance one block index entry
   }
 
-  unsigned long long* blockPos = (unsigned long long*) blockP;
-  unsigned short int* algoInt  = (unsigned short int*) (blockP + 8);
-  unsigned short int* algoChar = (unsigned short int*) (blockP + 10);
-  int* intBufSize = (int*) (blockP + 12);
-
-  blockRunner->SetBuffersFromVec(nrOfBlocks * BLOCKSIZE_CHAR, vecLength);
-  unsigned int totSize = storeCharBlockCompressed_v6(myfile, blockRunner, nrOfBlocks * BLOCKSIZE_CHAR,
-    vecLength, streamCompressInt, streamCompressChar, *algoInt, *algoChar, *intBufSize);
-
-  fullSize += totSize;
-  *blockPos = fullSize;
-
   delete streamCompressInt;
   delete streamCompressChar;
   delete compressInt;
@@ -236,8 +734,9 @@ void fdsWriteCharVec_v6(ofstream &myfile, IBlockWriter* blockRunner, int compres
   delete compressChar;
   delete compressChar2;
 
-  myfile.seekp(curPos + CHAR_HEADER_SIZE);
-  myfile.write((char*)(&meta[CHAR_HEADER_SIZE]), (nrOfBlocks + 1) * CHAR_INDEX_SIZE);  // additional zero for index convenience
+  // The complete header is rewritten, so the rewrite covers the range of the first write (see ChecksumStreamBuf)
+  myfile.seekp(curPos);
+  myfile.write(meta, metaSize);  // block offset and algorithm index
   myfile.seekp(0, ios_base::end);
 
   delete[] meta;
@@ -247,17 +746,18 @@ void fdsWriteCharVec_v6(ofstream &myfile, IBlockWriter* blockRunner, int compres
 
 
 inline void ReadDataBlock_v6(istream &myfile, IStringColumn* blockReader, unsigned long long blockSize, unsigned int nrOfElements,
-  unsigned int startElem, unsigned int endElem, unsigned int vecOffset)
+  unsigned int startElem, unsigned int endElem, unsigned long long vecOffset)
 {
   unsigned int nrOfNAInts = 1 + nrOfElements / 32;  // last bit is NA flag
   unsigned int totElements = nrOfElements + nrOfNAInts;
-  unsigned int *sizeMeta = new unsigned int[totElements];
+  unsigned int *sizeMeta = (unsigned int*) ScratchBuffer(ScratchSlot::CHAR_SIZES, totElements * 4);
   myfile.read((char*) sizeMeta, totElements * 4);  // read cumulative string lengths and NA bits
 
   unsigned int charDataSize = blockSize - totElements * 4;
 
-  char* buf = new char[charDataSize];
+  char* buf = ScratchBuffer(ScratchSlot::CHAR_DATA, charDataSize);
   myfile.read(buf, charDataSize);  // read string lengths
+  ProfileBlocks(0);
 
   // Create IBlockReader
   // IBlockReader* blockReader = new BlockReaderChar(strVec);
@@ -265,65 +765,427 @@ inline void ReadDataBlock_v6(istream &myfile, IStringColumn* blockReader, unsign
   // delete blockReader;
 
   // ReadDataBlockInfo_v6(strVec, nrOfElements, startElem, endElem, vecOffset, sizeMeta, buf);
+}
+
+
+// Buffers of a decoded character block. Blocks decoded on the calling thread use the scratch buffers of the
+// thread, blocks decoded by the workers of a read pipeline use the buffers of their pipeline slot.
+struct CharDecodeBuffers
+{
+  vector<char> sizeMeta;
+  vector<char> data;
+  vector<char> strings;
+};
+
+
+// Buffer of at least size bytes, taken from buf if specified and from the scratch buffer slot otherwise
+inline char* DecodeBuffer(vector<char>* buf, ScratchSlot slot, unsigned long long size)
+{
+  if (buf == nullptr) return ScratchBuffer(slot, size);
 
-  delete[] sizeMeta;
-  delete[] buf;
+  if (buf->size() < size) buf->resize(size);
+  return buf->data();
 }
 
 
-inline void ReadDataBlockCompressed_v6(istream &myfile, IStringColumn* blockReader, unsigned long long blockSize, unsigned int nrOfElements,
-  unsigned int startElem, unsigned int endElem, unsigned int vecOffset,
-  unsigned int intBlockSize, Decompressor &decompressor, unsigned short int &algoInt, unsigned short int &algoChar)
+// Decode the strings startElem until endElem of a front coded block (see FrontEncode_v6), starting at the nearest
+// restart point. The cumulative suffix sizes in sizeMeta are replaced by the cumulative sizes of the decoded strings,
+// starting from the restart point (the size preceding the restart point is set to zero).
+inline char* FrontDecode_v6(const char* buf, unsigned int nrOfElements, unsigned int startElem, unsigned int endElem,
+  unsigned int* sizeMeta, CharDecodeBuffers* buffers)
+{
+  const unsigned short int* prefixLengths = (const unsigned short int*) buf;
+  const char* suffixes = &buf[2 * nrOfElements];
+
+  unsigned int firstElem = startElem - startElem % CHAR_FRONT_RESTART;  // restart point
+  unsigned int suffixStart = firstElem == 0 ? 0 : sizeMeta[firstElem - 1];
+
+  // Size of the decoded strings
+  unsigned int totSize = sizeMeta[endElem] - suffixStart;
+  for (unsigned int pos = firstElem; pos <= endElem; ++pos) totSize += prefixLengths[pos];
+
+  char* strings = DecodeBuffer(buffers == nullptr ? nullptr : &buffers->strings, ScratchSlot::CHAR_STRINGS,
+    max(totSize, 1u));
+  unsigned int prevStart = 0;
+  unsigned int strStart = 0;
+
+  for (unsigned int pos = firstElem; pos <= endElem; ++pos)
+  {
+    unsigned int prefix = prefixLengths[pos];
+    unsigned int suffixEnd = sizeMeta[pos];
+    unsigned int suffixSize = suffixEnd - suffixStart;
+
+    memcpy(&strings[strStart], &strings[prevStart], prefix);
+    memcpy(&strings[strStart + prefix], &suffixes[suffixStart], suffixSize);
+
+    prevStart = strStart;
+    strStart += prefix + suffixSize;
+    suffixStart = suffixEnd;
+    sizeMeta[pos] = strStart;
+  }
+
+  if (firstElem != 0) sizeMeta[firstElem - 1] = 0;
+
+  return strings;
+}
+
+
+// Decode the stored data of a compressed block (blockSize bytes): the (compressed) cumulative string sizes
+// (intBlockSize bytes), the NA bits and the (compressed) string data. The string sizes and NA bits are decoded into
+// sizeMeta, the string data of elements startElem until endElem is returned. The buffers are taken from buffers, or
+// from the scratch buffers of the calling thread if nullptr.
+inline char* DecodeCharBlock_v6(const char* blockData, unsigned long long blockSize, unsigned int nrOfElements,
+  unsigned int startElem, unsigned int endElem, unsigned int intBlockSize, Decompressor &decompressor,
+  unsigned short int algoInt, unsigned short int algoChar, unsigned int* &sizeMeta, CharDecodeBuffers* buffers)
 {
   unsigned int nrOfNAInts = 1 + nrOfElements / 32;  // NA metadata including overall NA bit
   unsigned int totElements = nrOfElements + nrOfNAInts;
-  unsigned int *sizeMeta = new unsigned int[totElements];
+  sizeMeta = (unsigned int*) DecodeBuffer(buffers == nullptr ? nullptr : &buffers->sizeMeta, ScratchSlot::CHAR_SIZES,
+    totElements * 4);
+
+  unsigned int algoSizes = algoInt & ~CHAR_NO_NA_BITS;
+  unsigned int naSize = (algoInt & CHAR_NO_NA_BITS) == 0 ? nrOfNAInts * 4 : 0;
 
-  // Read and uncompress str sizes data
-  if (algoInt == 0)  // uncompressed
+  // Uncompress str sizes data
+  if (algoSizes == 0)  // uncompressed
   {
-    myfile.read((char*) sizeMeta, totElements * 4);  // read cumulative string lengths
+    memcpy(sizeMeta, blockData, nrOfElements * 4);  // cumulative string lengths
+    blockData += nrOfElements * 4;
   }
   else
   {
-    unsigned int intBufSize = intBlockSize;
-    char *strSizeBuf = new char[intBufSize];
-    myfile.read(strSizeBuf, intBufSize);
-    myfile.read((char*) &sizeMeta[nrOfElements], nrOfNAInts * 4);  // read cumulative string lengths
-
     // Decompress size but not NA metadata (which is currently uncompressed)
+    decompressor.Decompress(algoSizes, (char*) sizeMeta, nrOfElements * 4, blockData, intBlockSize);
+    blockData += intBlockSize;
+  }
+
+  if (naSize != 0)
+  {
+    memcpy(&sizeMeta[nrOfElements], blockData, naSize);  // NA bits
+    blockData += naSize;
+  }
+  else
+  {
+    memset(&sizeMeta[nrOfElements], 0, nrOfNAInts * 4);  // block without NA's
+  }
+
+  bool frontCoded = (algoChar & CHAR_FRONT_CODED) != 0;
+  unsigned int algoData = algoChar & ~CHAR_FRONT_CODED;
+  unsigned int charDataSizeUncompressed = sizeMeta[nrOfElements - 1] + (frontCoded ? 2 * nrOfElements : 0);
+
+  // Uncompress string vector data, uncompressed data is used in place
+  unsigned int charDataSize = static_cast<unsigned int>(blockSize - intBlockSize - naSize);
+  char* buf = const_cast<char*>(blockData);
+
+  if (algoData != 0)
+  {
+    buf = DecodeBuffer(buffers == nullptr ? nullptr : &buffers->data, ScratchSlot::CHAR_DATA, charDataSizeUncompressed);
+    decompressor.Decompress(algoData, buf, charDataSizeUncompressed, blockData, charDataSize);
+  }
+
+  if (frontCoded)
+  {
+    return FrontDecode_v6(buf, nrOfElements, startElem, endElem, sizeMeta, buffers);
+  }
+
+  return buf;
+}
+
+
+inline void ReadDataBlockCompressed_v6(istream &myfile, IStringColumn* blockReader, unsigned long long blockSize, unsigned int nrOfElements,
+  unsigned int startElem, unsigned int endElem, unsigned long long vecOffset,
+  unsigned int intBlockSize, Decompressor &decompressor, unsigned short int &algoInt, unsigned short int &algoChar)
+{
+  char* blockData = ScratchBuffer(ScratchSlot::CHAR_COMPRESSED, blockSize);
+  myfile.read(blockData, blockSize);
+  ProfileBlocks(algoChar & ~CHAR_FRONT_CODED);
+
+  unsigned int* sizeMeta;
+  char* strings = DecodeCharBlock_v6(blockData, blockSize, nrOfElements, startElem, endElem, intBlockSize,
+    decompressor, algoInt, algoChar, sizeMeta, nullptr);
 
-    decompressor.Decompress(algoInt, (char*) sizeMeta, nrOfElements * 4, strSizeBuf, intBlockSize);
+  blockReader->BufferToVec(nrOfElements, startElem, endElem, vecOffset, sizeMeta, strings);
+}
+
+
+// Receives the complete decoded strings of a block: the string sizes and NA bits followed by the string data
+class CharBlockCapture : public IStringColumn
+{
+public:
+  shared_ptr<vector<char>> block;
+
+  void AllocateVec(unsigned long long vecLength) {}
+
+  void BufferToVec(unsigned int nrOfElements, unsigned int startElem, unsigned int endElem,
+    unsigned long long vecOffset, unsigned int* sizeMeta, char* buf)
+  {
+    unsigned int metaSize = 4 * (nrOfElements + 1 + nrOfElements / 32);
+    block = make_shared<vector<char>>(metaSize + sizeMeta[nrOfElements - 1]);
 
-    delete[] strSizeBuf;
+    memcpy(block->data(), sizeMeta, metaSize);
+    memcpy(&(*block)[metaSize], buf, sizeMeta[nrOfElements - 1]);
   }
 
-  unsigned int charDataSizeUncompressed = sizeMeta[nrOfElements - 1];
+  const char* GetElement(int elementNr) { return nullptr; }
+};
 
-  // Read and uncompress string vector data, use stack if possible here !!!!!
-  unsigned int charDataSize = blockSize - intBlockSize - nrOfNAInts * 4;
-  char* buf = new char[charDataSizeUncompressed];
 
-  if (algoChar == 0)
+// Read a compressed block through the block cache if a file is selected for caching (fileId != 0), the decoded
+// strings of the complete block are cached. The stream is positioned at blockEnd afterwards.
+inline void ReadDataBlockCached_v6(istream &myfile, IStringColumn* blockReader, unsigned long long blockSize,
+  unsigned int nrOfElements, unsigned int startElem, unsigned int endElem, unsigned long long vecOffset,
+  unsigned int intBlockSize, Decompressor &decompressor, unsigned short int &algoInt, unsigned short int &algoChar,
+  unsigned long long fileId, unsigned long long colPos, unsigned long long blockNr, unsigned long long blockEnd)
+{
+  if (fileId == 0)
+  {
+    ReadDataBlockCompressed_v6(myfile, blockReader, blockSize, nrOfElements, startElem, endElem, vecOffset,
+      intBlockSize, decompressor, algoInt, algoChar);
+
+    return;
+  }
+
+  BlockCacheKey key = { fileId, colPos, blockNr };
+  shared_ptr<vector<char>> block = BlockCache::Global().Find(key);
+
+  if (!block)
   {
-    myfile.read(buf, charDataSize);  // read string lengths
+    CharBlockCapture capture;
+    ReadDataBlockCompressed_v6(myfile, &capture, blockSize, nrOfElements, 0, nrOfElements - 1, 0, intBlockSize,
+      decompressor, algoInt, algoChar);
+
+    block = capture.block;
+    BlockCache::Global().Insert(key, block);
   }
   else
   {
-    char* bufCompressed = new char[charDataSize];
-    myfile.read(bufCompressed, charDataSize);  // read string lengths
-    decompressor.Decompress(algoChar, buf, charDataSizeUncompressed, bufCompressed, charDataSize);
-    delete[] bufCompressed;
+    myfile.seekg(blockEnd);
   }
 
-  blockReader->BufferToVec(nrOfElements, startElem, endElem, vecOffset, sizeMeta, buf);
+  // The cached block is shared, BufferToVec only reads the buffers
+  unsigned int metaSize = 4 * (nrOfElements + 1 + nrOfElements / 32);
+  blockReader->BufferToVec(nrOfElements, startElem, endElem, vecOffset, reinterpret_cast<unsigned int*>(block->data()),
+    &(*block)[metaSize]);
+}
+
 
-  delete[] buf;  // character vector buffer
-  delete[] sizeMeta;
+// A slot in the ring of decoded blocks of a read pipeline
+struct CharPipelineSlot
+{
+  CharDecodeBuffers buffers;
+  vector<char> blockData;  // stored data of the block
+  unsigned int* sizeMeta;
+  char* strings;
+  atomic<long long> ready;  // block decoded in the slot (-1 for none)
+  atomic<long long> free;   // next block that can be decoded in the slot
+};
+
+
+// Read the compressed blocks of a range with a two stage pipeline. Worker threads read (one at a time) and decode
+// the upcoming blocks into a ring of reusable slots, while the calling thread converts the decoded blocks to the
+// result column in block order. The string conversion (R's CHARSXP creation) has to stay on the calling thread, so
+// the decompression is done in parallel with it. The blockInfo index holds the end of the preceding block, followed
+// by the index elements of the nrOfBlocks blocks of the range. The stream is positioned after the last block
+// afterwards.
+inline void ReadBlocksPipelined_v6(istream &myfile, IStringColumn* blockReader, unsigned long long blockPos,
+  const char* blockInfo, unsigned long long nrOfBlocks, unsigned int blockSizeChar, unsigned int startOffset,
+  unsigned int endOffset, unsigned int lastNrOfElements, unsigned long long vecOffset, Decompressor &decompressor,
+  int nrOfThreads)
+{
+  // Algorithms are counted up front, the workers have no profile column
+  for (unsigned long long block = 0; block < nrOfBlocks; ++block)
+  {
+    ProfileBlocks(*(const unsigned short int*) &blockInfo[(block + 1) * CHAR_INDEX_SIZE + 10] & ~CHAR_FRONT_CODED);
+  }
+
+  long long ringSize = CHAR_PIPELINE_SLOTS * (nrOfThreads - 1);
+  vector<CharPipelineSlot> slots(ringSize);
+
+  for (long long slotNr = 0; slotNr < ringSize; ++slotNr)
+  {
+    slots[slotNr].ready = -1;
+    slots[slotNr].free = slotNr;
+  }
+
+  atomic<long long> nextBlock(0);
+  atomic<bool> failed(false);
+  string errorMessage;
+
+  // Read and decode a block into its slot, the Decompressor only reads its dictionary and is shared by the threads
+  auto decodeBlock = [&](long long block, CharPipelineSlot &slot)
+  {
+    const char* indexElement = &blockInfo[(block + 1) * CHAR_INDEX_SIZE];
+    unsigned long long blockStart = *(const unsigned long long*) &blockInfo[block * CHAR_INDEX_SIZE];
+    unsigned long long blockSize = *(const unsigned long long*) indexElement - blockStart;
+    unsigned int nrOfElements = block == (long long) nrOfBlocks - 1 ? lastNrOfElements : blockSizeChar;
+    unsigned int startElem = block == 0 ? startOffset : 0;
+    unsigned int endElem = block == (long long) nrOfBlocks - 1 ? endOffset : nrOfElements - 1;
+
+    if (slot.blockData.size() < blockSize) slot.blockData.resize(blockSize);
+    bool readFailed;
+
+#pragma omp critical (char_pipeline_read)
+    {
+      myfile.seekg(blockPos + blockStart);
+      myfile.read(slot.blockData.data(), blockSize);
+      readFailed = myfile.fail();
+    }
+
+    if (readFailed)
+    {
+      throw(runtime_error("Error reading the data of a character column."));
+    }
+
+    slot.strings = DecodeCharBlock_v6(slot.blockData.data(), blockSize, nrOfElements, startElem, endElem,
+      *(const unsigned int*) &indexElement[12], decompressor, *(const unsigned short int*) &indexElement[8],
+      *(const unsigned short int*) &indexElement[10], slot.sizeMeta, &slot.buffers);
+  };
+
+#pragma omp parallel num_threads(nrOfThreads)
+  {
+    // Without worker threads (a smaller team than requested), the calling thread decodes the blocks itself
+    bool hasWorkers = omp_get_num_threads() > 1;
+
+    try
+    {
+      if (omp_get_thread_num() == 0)  // calling thread
+      {
+        unsigned long long vecPos = vecOffset;
+
+        for (long long block = 0; block < (long long) nrOfBlocks && !failed; ++block)
+        {
+          CharPipelineSlot &slot = slots[block % ringSize];
+
+          if (hasWorkers)
+          {
+            while (slot.ready.load(memory_order_acquire) != block && !failed) this_thread::yield();
+            if (failed) break;
+          }
+          else
+          {
+            decodeBlock(block, slot);
+          }
+
+          unsigned int nrOfElements = block == (long long) nrOfBlocks - 1 ? lastNrOfElements : blockSizeChar;
+          unsigned int startElem = block == 0 ? startOffset : 0;
+          unsigned int endElem = block == (long long) nrOfBlocks - 1 ? endOffset : nrOfElements - 1;
+
+          blockReader->BufferToVec(nrOfElements, startElem, endElem, vecPos, slot.sizeMeta, slot.strings);
+          vecPos += 1 + endElem - startElem;
+
+          slot.free.store(block + ringSize, memory_order_release);
+        }
+      }
+      else  // worker threads take the blocks in order
+      {
+        while (!failed)
+        {
+          long long block = nextBlock.fetch_add(1);
+          if (block >= (long long) nrOfBlocks) break;
+
+          CharPipelineSlot &slot = slots[block % ringSize];
+          while (slot.free.load(memory_order_acquire) != block && !failed) this_thread::yield();
+          if (failed) break;
+
+          decodeBlock(block, slot);
+          slot.ready.store(block, memory_order_release);
+        }
+      }
+    }
+    catch (const std::exception &e)
+    {
+#pragma omp critical (char_pipeline_error)
+      {
+        if (!failed) errorMessage = e.what();
+        failed = true;
+      }
+    }
+  }
+
+  if (failed)
+  {
+    throw(runtime_error(errorMessage));
+  }
+
+  myfile.seekg(blockPos + *(const unsigned long long*) &blockInfo[nrOfBlocks * CHAR_INDEX_SIZE]);
 }
 
 
-void fdsReadCharVec_v6(istream &myfile, IStringColumn* blockReader, unsigned long long blockPos, unsigned int startRow, unsigned int vecLength, unsigned int size)
+// Read a column stored as level codes. Each level is converted once if the column supports level codes, otherwise
+// the levels are expanded to blocks of strings.
+inline void ReadCharLevels_v6(istream &myfile, IStringColumn* blockReader, unsigned long long levelPos,
+  unsigned long long startRow, unsigned long long vecLength, unsigned long long size, unsigned long long vecOffset)
+{
+  StringVectorColumn levels;
+  unsigned int nrOfLevels = fdsReadFactorLevels_v7(myfile, &levels, levelPos);
+
+  vector<int> codes(vecLength);
+  fdsReadFactorCodes_v7(myfile, codes.data(), levelPos, startRow, vecLength, size, 1);
+
+  vector<unsigned int> levelSizes(nrOfLevels);
+  string levelBuf;
+
+  for (unsigned int level = 0; level < nrOfLevels; ++level)
+  {
+    levelBuf += levels.strings[level];
+    levelSizes[level] = static_cast<unsigned int>(levelBuf.size());
+  }
+
+  if (blockReader->LevelsToVec(vecOffset, vecLength, codes.data(), nrOfLevels, levelSizes.data(), levelBuf.data()))
+  {
+    return;
+  }
+
+  vector<unsigned int> sizeMeta(BLOCKSIZE_CHAR + 1 + BLOCKSIZE_CHAR / 32);  // string sizes and NA bits
+  vector<char> buf;
+  buf.reserve(1);  // non-empty buffer
+
+  for (unsigned long long blockStart = 0; blockStart < vecLength; blockStart += BLOCKSIZE_CHAR)
+  {
+    unsigned int nrOfElements = static_cast<unsigned int>(min((unsigned long long) BLOCKSIZE_CHAR, vecLength - blockStart));
+    unsigned int nrOfNAInts = 1 + nrOfElements / 32;  // add 1 bit for NA present flag
+    unsigned int* bitsNA = &sizeMeta[nrOfElements];
+    const int* blockCodes = &codes[blockStart];
+
+    memset(bitsNA, 0, nrOfNAInts * 4);
+    buf.clear();
+
+    for (unsigned int pos = 0; pos < nrOfElements; ++pos)
+    {
+      int code = blockCodes[pos];
+
+      if (code == INT_MIN)
+      {
+        bitsNA[pos / 32] |= 1u << (pos % 32);
+        bitsNA[nrOfNAInts - 1] |= 1u << (nrOfElements % 32);  // NA present flag
+      }
+      else
+      {
+        unsigned int levelStart = code == 1 ? 0 : levelSizes[code - 2];
+        buf.insert(buf.end(), &levelBuf[levelStart], &levelBuf[levelStart] + (levelSizes[code - 1] - levelStart));
+      }
+
+      sizeMeta[pos] = static_cast<unsigned int>(buf.size());
+    }
+
+    blockReader->BufferToVec(nrOfElements, 0, nrOfElements - 1, vecOffset + blockStart, sizeMeta.data(), buf.data());
+  }
+}
+
+
+void fdsReadCharVec_v6(istream &myfile, IStringColumn* blockReader, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long vecLength, unsigned long long size)
+{
+  // Create result vector
+  blockReader->AllocateVec(vecLength);
+
+  fdsReadCharVecAt_v6(myfile, blockReader, blockPos, startRow, vecLength, size, 0);
+}
+
+
+inline void ReadCharVecAt_v6(istream &myfile, IStringColumn* blockReader, unsigned long long blockPos,
+  unsigned long long startRow, unsigned long long vecLength, unsigned long long size, unsigned long long vecOffset,
+  int nrOfThreads)
 {
   // Jump to startRow size
   myfile.seekg(blockPos);
@@ -333,15 +1195,20 @@ void fdsReadCharVec_v6(istream &myfile, IStringColumn* blockReader, unsigned lon
   myfile.read((char*) meta, CHAR_HEADER_SIZE);
 
   unsigned int blockSizeChar = meta[1];
-  unsigned int totNrOfBlocks = (size - 1) / blockSizeChar;  // total number of blocks minus 1
-  unsigned int startBlock = startRow / blockSizeChar;
-  unsigned int startOffset = startRow - (startBlock * blockSizeChar);
-  unsigned int endBlock = (startRow + vecLength - 1)  / blockSizeChar;
-  unsigned int endOffset = (startRow + vecLength - 1)  -  endBlock *blockSizeChar;
-  unsigned int nrOfBlocks = 1 + endBlock - startBlock;  // total number of blocks to read
+  unsigned long long totNrOfBlocks = (size - 1) / blockSizeChar;  // total number of blocks minus 1
+  unsigned long long startBlock = startRow / blockSizeChar;
+  unsigned int startOffset = static_cast<unsigned int>(startRow - (startBlock * blockSizeChar));
+  unsigned long long endBlock = (startRow + vecLength - 1)  / blockSizeChar;
+  unsigned int endOffset = static_cast<unsigned int>((startRow + vecLength - 1)  -  endBlock *blockSizeChar);
+  unsigned long long nrOfBlocks = 1 + endBlock - startBlock;  // total number of blocks to read
 
-  // Create result vector
-  blockReader->AllocateVec(vecLength);
+  // Vector data is stored as level codes
+
+  if (meta[0] == 3)
+  {
+    ReadCharLevels_v6(myfile, blockReader, blockPos + CHAR_HEADER_SIZE, startRow, vecLength, size, vecOffset);
+    return;
+  }
 
   // Vector data is uncompressed
 
@@ -373,14 +1240,14 @@ void fdsReadCharVec_v6(istream &myfile, IStringColumn* blockReader, unsigned lon
       endElem = endOffset;
       if (endBlock == totNrOfBlocks)
       {
-        nrOfElements = size - totNrOfBlocks * blockSizeChar;  // last block can have less elements
+        nrOfElements = static_cast<unsigned int>(size - totNrOfBlocks * blockSizeChar);  // last block can have less elements
       }
     }
 
     // Read first block with offset
     unsigned long long blockSize = blockOffset[1] - offset;  // size of data block
 
-    ReadDataBlock_v6(myfile, blockReader, blockSize, nrOfElements, startOffset, endElem, 0);
+    ReadDataBlock_v6(myfile, blockReader, blockSize, nrOfElements, startOffset, endElem, vecOffset);
 
     if (startBlock == endBlock)  // subset start and end of block
     {
@@ -390,15 +1257,15 @@ void fdsReadCharVec_v6(istream &myfile, IStringColumn* blockReader, unsigned lon
     }
 
     offset = blockOffset[1];
-    unsigned int vecPos = blockSizeChar - startOffset;
+    unsigned long long vecPos = vecOffset + blockSizeChar - startOffset;
 
     if (endBlock == totNrOfBlocks)
     {
-      nrOfElements = size - totNrOfBlocks * blockSizeChar;  // last block can have less elements
+      nrOfElements = static_cast<unsigned int>(size - totNrOfBlocks * blockSizeChar);  // last block can have less elements
     }
 
     --nrOfBlocks;  // iterate full blocks
-    for (unsigned int block = 1; block < nrOfBlocks; ++block)
+    for (unsigned long long block = 1; block < nrOfBlocks; ++block)
     {
       unsigned long long newPos = blockOffset[block + 1];
 
@@ -419,7 +1286,25 @@ void fdsReadCharVec_v6(istream &myfile, IStringColumn* blockReader, unsigned lon
 
   // Vector data is compressed
 
-  unsigned int bufLength = (nrOfBlocks + 1) * CHAR_INDEX_SIZE;  // 1 long and 2 unsigned int per block
+  unsigned long long firstBlockOffset = CHAR_HEADER_SIZE + (totNrOfBlocks + 1) * CHAR_INDEX_SIZE;  // offset of first data block
+  Decompressor decompressor;  // uncompress all availble algorithms
+
+  if (meta[0] == 2)  // dictionary is stored after the block index
+  {
+    myfile.seekg(blockPos + firstBlockOffset);
+
+    unsigned int dictSize;
+    myfile.read((char*) &dictSize, 4);
+
+    vector<char> dictionary(dictSize);
+    myfile.read(dictionary.data(), dictSize);
+    decompressor.SetDictionary(dictionary.data(), dictSize);
+
+    firstBlockOffset += 4 + dictSize;
+    myfile.seekg(blockPos + CHAR_HEADER_SIZE);  // back to block index
+  }
+
+  unsigned long long bufLength = (nrOfBlocks + 1) * CHAR_INDEX_SIZE;  // 1 long and 2 unsigned int per block
   char *blockInfo = new char[bufLength + CHAR_INDEX_SIZE];  // add extra first element for convenience
 
 
@@ -431,7 +1316,7 @@ void fdsReadCharVec_v6(istream &myfile, IStringColumn* blockReader, unsigned lon
   else
   {
     unsigned long long* firstBlock = (unsigned long long*) blockInfo;
-    *firstBlock = CHAR_HEADER_SIZE + (totNrOfBlocks + 1) * CHAR_INDEX_SIZE;  // offset of first data block
+    *firstBlock = firstBlockOffset;
     myfile.read(&blockInfo[CHAR_INDEX_SIZE], nrOfBlocks * CHAR_INDEX_SIZE);
   }
 
@@ -455,17 +1340,36 @@ void fdsReadCharVec_v6(istream &myfile, IStringColumn* blockReader, unsigned lon
     endElem = endOffset;
     if (endBlock == totNrOfBlocks)
     {
-      nrOfElements = size - totNrOfBlocks * blockSizeChar;  // last block can have less elements
+      nrOfElements = static_cast<unsigned int>(size - totNrOfBlocks * blockSizeChar);  // last block can have less elements
     }
   }
 
+  // Reads through an open handle use the block cache, unless the (compressed) range would release a large part of
+  // the cache
+  unsigned long long fileId = BlockCacheScope::ActiveFile();
+  unsigned long long rangeEnd = *(unsigned long long*) &blockInfo[nrOfBlocks * CHAR_INDEX_SIZE];
+
+  if (fileId != 0 && rangeEnd - *offset > BlockCache::Global().Stats().budget / 8) fileId = 0;
+
+  // Longer ranges outside the block cache are decompressed by worker threads
+  if (fileId == 0 && nrOfThreads > 1 && nrOfBlocks >= CHAR_PIPELINE_MIN_BLOCKS)
+  {
+    unsigned int lastNrOfElements = endBlock == totNrOfBlocks ?
+      static_cast<unsigned int>(size - totNrOfBlocks * blockSizeChar) : blockSizeChar;
+
+    ReadBlocksPipelined_v6(myfile, blockReader, blockPos, blockInfo, nrOfBlocks, blockSizeChar, startOffset, endOffset,
+      lastNrOfElements, vecOffset, decompressor, nrOfThreads);
+
+    delete[] blockInfo;
+
+    return;
+  }
+
   // Read first block with offset
   unsigned long long blockSize = *curBlockPos - *offset;  // size of data block
 
-  Decompressor decompressor;  // uncompress all availble algorithms
-
-  ReadDataBlockCompressed_v6(myfile, blockReader, blockSize, nrOfElements, startOffset, endElem, 0, *intBufSize,
-                             decompressor, *algoInt, *algoChar);
+  ReadDataBlockCached_v6(myfile, blockReader, blockSize, nrOfElements, startOffset, endElem, vecOffset, *intBufSize,
+    decompressor, *algoInt, *algoChar, fileId, blockPos, startBlock, blockPos + *curBlockPos);
 
 
   if (startBlock == endBlock)  // subset start and end of block
@@ -477,24 +1381,24 @@ void fdsReadCharVec_v6(istream &myfile, IStringColumn* blockReader, unsigned lon
 
   offset = curBlockPos;
 
-  unsigned int vecPos = blockSizeChar - startOffset;
+  unsigned long long vecPos = vecOffset + blockSizeChar - startOffset;
 
   if (endBlock == totNrOfBlocks)
   {
-    nrOfElements = size - totNrOfBlocks * blockSizeChar;  // last block can have less elements
+    nrOfElements = static_cast<unsigned int>(size - totNrOfBlocks * blockSizeChar);  // last block can have less elements
   }
 
   --nrOfBlocks;  // iterate all but last block
   blockP += CHAR_INDEX_SIZE;  // move to next index element
-  for (unsigned int block = 1; block < nrOfBlocks; ++block)
+  for (unsigned long long block = 1; block < nrOfBlocks; ++block)
   {
     unsigned long long* curBlockPos = (unsigned long long*) blockP;
     unsigned short int* algoInt  = (unsigned short int*) (blockP + 8);
     unsigned short int* algoChar = (unsigned short int*) (blockP + 10);
     int* intBufSize = (int*) (blockP + 12);
 
-    ReadDataBlockCompressed_v6(myfile, blockReader, *curBlockPos - *offset, blockSizeChar, 0, blockSizeChar - 1, vecPos, *intBufSize,
-      decompressor, *algoInt, *algoChar);
+    ReadDataBlockCached_v6(myfile, blockReader, *curBlockPos - *offset, blockSizeChar, 0, blockSizeChar - 1, vecPos,
+      *intBufSize, decompressor, *algoInt, *algoChar, fileId, blockPos, startBlock + block, blockPos + *curBlockPos);
 
     vecPos += blockSizeChar;
     offset = curBlockPos;
@@ -506,10 +1410,154 @@ void fdsReadCharVec_v6(istream &myfile, IStringColumn* blockReader, unsigned lon
   algoChar = (unsigned short int*) (blockP + 10);
   intBufSize = (int*) (blockP + 12);
 
-  ReadDataBlockCompressed_v6(myfile, blockReader, *curBlockPos - *offset, nrOfElements, 0, endOffset, vecPos, *intBufSize,
-    decompressor, *algoInt, *algoChar);
+  ReadDataBlockCached_v6(myfile, blockReader, *curBlockPos - *offset, nrOfElements, 0, endOffset, vecPos, *intBufSize,
+    decompressor, *algoInt, *algoChar, fileId, blockPos, endBlock, blockPos + *curBlockPos);
 
   delete[] blockInfo;
 
   return;
 }
+
+
+// Attributes the conversion of the decoded strings to the result column to the table phase of a profiled read
+class ProfiledStringColumn : public IStringColumn
+{
+  IStringColumn* column;
+
+public:
+  ProfiledStringColumn(IStringColumn* column) : column(column) {}
+
+  void AllocateVec(unsigned long long vecLength)
+  {
+    ProfileTimer profileTimer(ProfilePhase::TABLE);
+    column->AllocateVec(vecLength);
+  }
+
+  void BufferToVec(unsigned int nrOfElements, unsigned int startElem, unsigned int endElem,
+    unsigned long long vecOffset, unsigned int* sizeMeta, char* buf)
+  {
+    unsigned int firstSize = startElem == 0 ? 0 : sizeMeta[startElem - 1];
+    ProfileData(4 * (unsigned long long) (1 + endElem - startElem) + sizeMeta[endElem] - firstSize);
+
+    ProfileTimer profileTimer(ProfilePhase::TABLE);
+    column->BufferToVec(nrOfElements, startElem, endElem, vecOffset, sizeMeta, buf);
+  }
+
+  const char* GetElement(int elementNr) { return column->GetElement(elementNr); }
+
+  bool LevelsToVec(unsigned long long vecOffset, unsigned long long length, const int* codes,
+    unsigned int nrOfLevels, const unsigned int* levelSizes, const char* levelBuf)
+  {
+    ProfileTimer profileTimer(ProfilePhase::TABLE);
+    if (!column->LevelsToVec(vecOffset, length, codes, nrOfLevels, levelSizes, levelBuf)) return false;
+
+    ProfileData(4 * length);
+    return true;
+  }
+};
+
+
+void fdsReadCharVecAt_v6(istream &myfile, IStringColumn* blockReader, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long vecLength, unsigned long long size, unsigned long long vecOffset, int nrOfThreads)
+{
+  if (profileState.column == nullptr)
+  {
+    ReadCharVecAt_v6(myfile, blockReader, blockPos, startRow, vecLength, size, vecOffset, nrOfThreads);
+    return;
+  }
+
+  ProfileTimer profileTimer(ProfilePhase::CODEC);
+  ProfiledStringColumn profiledColumn(blockReader);
+  ReadCharVecAt_v6(myfile, &profiledColumn, blockPos, startRow, vecLength, size, vecOffset, nrOfThreads);
+}
+
+
+void fdsCharColumnStorage_v6(istream &myfile, unsigned long long blockPos, unsigned long long size,
+  ColumnStorage &storage)
+{
+  // Read algorithm type and block size
+  unsigned int meta[2];
+  myfile.seekg(blockPos);
+  myfile.read((char*) meta, CHAR_HEADER_SIZE);
+
+  if (meta[0] == 3)  // level codes
+  {
+    storage.bytes += CHAR_HEADER_SIZE;
+    fdsFactorColumnStorage_v7(myfile, blockPos + CHAR_HEADER_SIZE, size, storage);
+    return;
+  }
+
+  unsigned long long nrOfBlocks = 1 + (size - 1) / meta[1];
+  unsigned int indexSize = meta[0] == 0 ? 8 : CHAR_INDEX_SIZE;  // size of a block index element
+
+  vector<char> blockIndex(nrOfBlocks * indexSize);
+  myfile.read(blockIndex.data(), nrOfBlocks * indexSize);
+
+  // The first block follows the block index and dictionary
+  unsigned long long blockStart = CHAR_HEADER_SIZE + nrOfBlocks * indexSize;
+
+  if (meta[0] == 2)
+  {
+    unsigned int dictSize;
+    myfile.read((char*) &dictSize, 4);
+    blockStart += 4 + dictSize;
+  }
+
+  if (myfile.fail())
+  {
+    throw(runtime_error("Error reading the block index of a column."));
+  }
+
+  // Each index element starts with the end position of its block
+  for (unsigned long long block = 0; block < nrOfBlocks; ++block)
+  {
+    char* indexElement = &blockIndex[block * indexSize];
+    unsigned long long blockEnd = *((unsigned long long*) indexElement);
+    unsigned int algo = 0;
+
+    if (meta[0] != 0)
+    {
+      algo = *((unsigned short int*) &indexElement[10]) & ~CHAR_FRONT_CODED;
+    }
+
+    storage.AddBlock(algo, blockEnd - blockStart);
+    blockStart = blockEnd;
+  }
+
+  storage.bytes += blockStart;
+}
+
+
+bool fdsCharColumnRange_v6(istream &myfile, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long vecLength, unsigned long long &rangeStart, unsigned long long &rangeEnd)
+{
+  // Read algorithm type and block size
+  unsigned int meta[2];
+  myfile.seekg(blockPos);
+  myfile.read((char*) meta, CHAR_HEADER_SIZE);
+
+  if (!myfile || meta[0] == 3) return false;  // level codes
+
+  unsigned int blockSizeChar = meta[1];
+  unsigned long long startBlock = startRow / blockSizeChar;
+  unsigned long long endBlock = (startRow + vecLength - 1) / blockSizeChar;
+  unsigned int indexSize = meta[0] == 0 ? 8 : CHAR_INDEX_SIZE;  // size of a block index element
+
+  // Each index element starts with the end position of its block
+  rangeStart = blockPos;
+
+  if (startBlock > 0)
+  {
+    unsigned long long blockStart;
+    myfile.seekg(blockPos + CHAR_HEADER_SIZE + (startBlock - 1) * indexSize);
+    myfile.read((char*) &blockStart, 8);
+    rangeStart += blockStart;
+  }
+
+  unsigned long long blockEnd;
+  myfile.seekg(blockPos + CHAR_HEADER_SIZE + endBlock * indexSize);
+  myfile.read((char*) &blockEnd, 8);
+  rangeEnd = blockPos + blockEnd;
+
+  return !myfile.fail();
+}
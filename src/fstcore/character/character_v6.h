@@ -42,12 +42,51 @@
 
 #include "iblockrunner.h"
 #include "ifstcolumn.h"
+#include "zonemap.h"
+#include "blockstreamer_v2.h"
 
 
-void fdsWriteCharVec_v6(std::ofstream &myfile, IBlockWriter* blockRunner, int compression);
+/**
+ Number of strings in a block of a character column, such that a block holds about CHAR_BLOCK_BYTES bytes of
+ character data. The size is estimated from samples of the vector.
+*/
+unsigned int fdsCharBlockSize_v6(IBlockWriter* blockRunner);
+
+
+// If zoneMap is specified, it receives the statistics of each block and its block size (which should be
+// determined with fdsCharBlockSize_v6) is used for the column. Otherwise the block size is determined here. With more
+// than one thread, the compressed blocks are copied and compressed by worker threads (for writers that provide
+// string pointers, see IBlockWriter::GatherStrings).
+void fdsWriteCharVec_v6(std::ostream &myfile, IBlockWriter* blockRunner, int compression, ZoneMap* zoneMap = nullptr,
+  int nrOfThreads = 1);
+
+
+void fdsReadCharVec_v6(std::istream &myfile, IStringColumn* blockReader, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long vecLength, unsigned long long size);
+
+
+/**
+ Read elements startRow until startRow + vecLength of a character column into an already allocated vector,
+ starting at element vecOffset of that vector. With more than one thread, the compressed blocks of longer ranges
+ are read and decompressed by worker threads while the calling thread converts the decoded blocks to the vector.
+*/
+void fdsReadCharVecAt_v6(std::istream &myfile, IStringColumn* blockReader, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long vecLength, unsigned long long size, unsigned long long vecOffset, int nrOfThreads = 1);
+
+
+/**
+ Determine the file positions [rangeStart, rangeEnd) of the stored data of elements startRow until
+ startRow + vecLength, using the block index of the column. The range of a selection that starts in the first block
+ includes the block index (and dictionary). Returns false for columns stored as level codes.
+*/
+bool fdsCharColumnRange_v6(std::istream &myfile, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long vecLength, unsigned long long &rangeStart, unsigned long long &rangeEnd);
 
 
-void fdsReadCharVec_v6(std::istream &myfile, IStringColumn* blockReader, unsigned long long blockPos, unsigned int startRow, unsigned int vecLength, unsigned int size);
+// Add the storage of the character column at blockPos, with size elements, to storage (see fdsColumnStorage_v2).
+// The block algorithm is the algorithm of the character data of the block.
+void fdsCharColumnStorage_v6(std::istream &myfile, unsigned long long blockPos, unsigned long long size,
+  ColumnStorage &storage);
 
 
 #endif  // CHARACTER_V6_H
@@ -0,0 +1,87 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef BITMAP_RUNS_H
+#define BITMAP_RUNS_H
+
+
+// Iteration over the runs of equal bits in a bitmap of 32 or 64 bit words (bit i is bit i % W of word i / W). The
+// boundaries of the runs are found a word at a time with a count of trailing zeros, so the cost depends on the
+// number of runs rather than on the number of bits. Used for the NA bits of character blocks and the value bits of
+// sparse blocks.
+
+
+// Position of the first bit at or after pos that equals value, or endBit if there is none before endBit
+template<typename W>
+inline unsigned int NextBitOf(const W* bitmap, unsigned int pos, unsigned int endBit, bool value)
+{
+  const unsigned int wordBits = 8 * sizeof(W);
+  const W flip = value ? (W) 0 : (W) ~(W) 0;  // search for set bits
+
+  if (pos >= endBit) return endBit;
+
+  unsigned int word = pos / wordBits;
+  W bits = (bitmap[word] ^ flip) & (W) ((W) ~(W) 0 << (pos % wordBits));
+
+  while (bits == 0)
+  {
+    if (++word * wordBits >= endBit) return endBit;
+    bits = bitmap[word] ^ flip;
+  }
+
+  unsigned int next = word * wordBits + __builtin_ctzll((unsigned long long) bits);
+  return next < endBit ? next : endBit;
+}
+
+
+// Call runFunc(runStart, runEnd, isSet) for each run of equal bits in [startBit, endBit), in order
+template<typename W, typename RunFunc>
+inline void BitmapRuns(const W* bitmap, unsigned int startBit, unsigned int endBit, RunFunc runFunc)
+{
+  const unsigned int wordBits = 8 * sizeof(W);
+  unsigned int pos = startBit;
+
+  while (pos < endBit)
+  {
+    bool isSet = (bitmap[pos / wordBits] >> (pos % wordBits)) & 1;
+    unsigned int runEnd = NextBitOf(bitmap, pos + 1, endBit, !isSet);
+
+    runFunc(pos, runEnd, isSet);
+    pos = runEnd;
+  }
+}
+
+
+#endif  // BITMAP_RUNS_H
@@ -0,0 +1,743 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#include "compact.h"
+
+#include <limits.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define COMPACT_AVX2
+  #include <immintrin.h>
+#endif
+
+
+typedef int (*PackKernel)(const char* src, char* dst, int nrOfLongs);
+typedef int (*RangeKernel)(const int* intVec, int nrOfInts, int &rawMin, int &minVal, int &maxVal);
+typedef int (*BitPackKernel)(const int* intVec, char* packed, int nrOfGroups, int base, int bitWidth, bool hasNA);
+typedef int (*BitUnpackKernel)(const char* packed, int* intVec, int nrOfGroups, int base, int bitWidth, bool hasNA);
+typedef int (*DeltaWidthKernel)(const int* intVec, int nrOfInts, unsigned int &codes1, unsigned int &codes2,
+  bool &isSorted);
+typedef int (*DeltaDecodeKernel)(int* intVec, int nrOfInts, int base, int order);
+typedef int (*RunCountKernel)(const int* intVec, int nrOfInts, unsigned int &nrOfBounds);
+typedef int (*FillKernel)(int* intVec, int nrOfInts, int value);
+typedef int (*RealToIntKernel)(const double* realVec, int* intVec, int nrOfDoubles, double factor, double naValue);
+typedef int (*IntToRealKernel)(const int* intVec, double* realVec, int nrOfInts, double factor, double naValue);
+
+
+#ifdef COMPACT_AVX2
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+
+// Long r of a cycle of 16 longs (32 logicals) is shifted both left and right by r and masked, as in the scalar
+// code. Each 256-bit register holds 4 longs, shifted by a variable shift, and the registers are OR-ed together.
+AVX2_TARGET static int Avx2LogicCompr64(const char* src, char* dst, int nrOfLongs)
+{
+  unsigned long long* compress = (unsigned long long*) dst;
+  __m256i bits = _mm256_set1_epi64x((1LL << 32) | 1LL);
+  __m256i shifts[4], masks[4];
+
+  for (int quarter = 0; quarter < 4; ++quarter)
+  {
+    int r = 4 * quarter;
+    shifts[quarter] = _mm256_setr_epi64x(r, r + 1, r + 2, r + 3);
+    masks[quarter] = _mm256_or_si256(_mm256_sllv_epi64(bits, shifts[quarter]),
+      _mm256_sllv_epi64(bits, _mm256_sub_epi64(_mm256_set1_epi64x(31), shifts[quarter])));
+  }
+
+  for (int longNr = 0; longNr < nrOfLongs; ++longNr)
+  {
+    const char* logicals = src + 128 * longNr;
+    __m256i compVal = _mm256_setzero_si256();
+
+    for (int quarter = 0; quarter < 4; ++quarter)
+    {
+      __m256i vec = _mm256_loadu_si256((const __m256i*) (logicals + 32 * quarter));
+      __m256i shifted = _mm256_or_si256(_mm256_srlv_epi64(vec, shifts[quarter]), _mm256_sllv_epi64(vec, shifts[quarter]));
+
+      compVal = _mm256_or_si256(compVal, _mm256_and_si256(shifted, masks[quarter]));
+    }
+
+    __m128i half = _mm_or_si128(_mm256_castsi256_si128(compVal), _mm256_extracti128_si256(compVal, 1));
+    half = _mm_or_si128(half, _mm_unpackhi_epi64(half, half));
+
+    compress[longNr] = (unsigned long long) _mm_cvtsi128_si64(half);
+  }
+
+  return nrOfLongs;
+}
+
+
+// The compressed word is broadcast to 4 longs and shifted back by r for long r
+AVX2_TARGET static int Avx2LogicDecompr64(const char* src, char* dst, int nrOfLongs)
+{
+  const unsigned long long* compress = (const unsigned long long*) src;
+  __m256i bit0 = _mm256_set1_epi64x((1LL << 32) | 1LL);
+  __m256i bit31 = _mm256_slli_epi64(bit0, 31);
+  __m256i shifts[4];
+
+  for (int quarter = 0; quarter < 4; ++quarter)
+  {
+    int r = 4 * quarter;
+    shifts[quarter] = _mm256_setr_epi64x(r, r + 1, r + 2, r + 3);
+  }
+
+  for (int longNr = 0; longNr < nrOfLongs; ++longNr)
+  {
+    __m256i compVal = _mm256_set1_epi64x((long long) compress[longNr]);
+    char* logicals = dst + 128 * longNr;
+
+    for (int quarter = 0; quarter < 4; ++quarter)
+    {
+      __m256i values = _mm256_and_si256(_mm256_srlv_epi64(compVal, shifts[quarter]), bit0);
+      __m256i nas = _mm256_and_si256(_mm256_sllv_epi64(compVal, shifts[quarter]), bit31);
+
+      _mm256_storeu_si256((__m256i*) (logicals + 32 * quarter), _mm256_or_si256(values, nas));
+    }
+  }
+
+  return nrOfLongs;
+}
+
+
+// A word holds the bytes (bit 0-7 combined with bits 24-31) of integers 6, 4, 2, 0, 7, 5, 3, 1. Per iteration,
+// 32 integers are narrowed with saturating packs, which interleave the 128-bit lanes. A permute restores the
+// order of the integers and a byte shuffle sets the order within each word.
+AVX2_TARGET static int Avx2CompactIntToByte(const char* src, char* dst, int nrOfLongs)
+{
+  __m256i byteMask = _mm256_set1_epi32(255);
+  __m256i laneOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  __m256i wordOrder = _mm256_setr_epi8(6, 4, 2, 0, 7, 5, 3, 1, 14, 12, 10, 8, 15, 13, 11, 9,
+    6, 4, 2, 0, 7, 5, 3, 1, 14, 12, 10, 8, 15, 13, 11, 9);
+
+  int longNr = 0;
+  for (; longNr + 4 <= nrOfLongs; longNr += 4)
+  {
+    const char* ints = src + 32 * longNr;
+    __m256i bytes[4];
+
+    for (int quarter = 0; quarter < 4; ++quarter)
+    {
+      __m256i vec = _mm256_loadu_si256((const __m256i*) (ints + 32 * quarter));
+      bytes[quarter] = _mm256_and_si256(_mm256_or_si256(vec, _mm256_srli_epi32(vec, 24)), byteMask);
+    }
+
+    __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(bytes[0], bytes[1]),
+      _mm256_packus_epi32(bytes[2], bytes[3]));
+    packed = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(packed, laneOrder), wordOrder);
+
+    _mm256_storeu_si256((__m256i*) (dst + 8 * longNr), packed);
+  }
+
+  return longNr;
+}
+
+
+AVX2_TARGET static int Avx2DecompactByteToInt(const char* src, char* dst, int nrOfLongs)
+{
+  __m256i intOrder = _mm256_setr_epi8(3, 7, 2, 6, 1, 5, 0, 4, 11, 15, 10, 14, 9, 13, 8, 12,
+    3, 7, 2, 6, 1, 5, 0, 4, 11, 15, 10, 14, 9, 13, 8, 12);
+  __m256i valueMask = _mm256_set1_epi32(127);
+  __m256i naMask = _mm256_set1_epi32(128);
+
+  int longNr = 0;
+  for (; longNr + 4 <= nrOfLongs; longNr += 4)
+  {
+    __m256i bytes = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*) (src + 8 * longNr)), intOrder);
+    __m128i parts[4];
+
+    parts[0] = _mm256_castsi256_si128(bytes);
+    parts[1] = _mm_srli_si128(parts[0], 8);
+    parts[2] = _mm256_extracti128_si256(bytes, 1);
+    parts[3] = _mm_srli_si128(parts[2], 8);
+
+    char* ints = dst + 32 * longNr;
+    for (int quarter = 0; quarter < 4; ++quarter)
+    {
+      __m256i vec = _mm256_cvtepu8_epi32(parts[quarter]);
+      vec = _mm256_or_si256(_mm256_and_si256(vec, valueMask), _mm256_slli_epi32(_mm256_and_si256(vec, naMask), 24));
+
+      _mm256_storeu_si256((__m256i*) (ints + 32 * quarter), vec);
+    }
+  }
+
+  return longNr;
+}
+
+
+// A word holds the shorts (bits 0-15 combined with bits 16-31) of integers 2, 0, 3, 1
+AVX2_TARGET static int Avx2CompactIntToShort(const char* src, char* dst, int nrOfLongs)
+{
+  __m256i shortMask = _mm256_set1_epi32(65535);
+  __m256i wordOrder = _mm256_setr_epi8(4, 5, 0, 1, 6, 7, 2, 3, 12, 13, 8, 9, 14, 15, 10, 11,
+    4, 5, 0, 1, 6, 7, 2, 3, 12, 13, 8, 9, 14, 15, 10, 11);
+
+  int longNr = 0;
+  for (; longNr + 4 <= nrOfLongs; longNr += 4)
+  {
+    const char* ints = src + 16 * longNr;
+    __m256i low = _mm256_loadu_si256((const __m256i*) ints);
+    __m256i high = _mm256_loadu_si256((const __m256i*) (ints + 32));
+
+    low = _mm256_and_si256(_mm256_or_si256(low, _mm256_srli_epi32(low, 16)), shortMask);
+    high = _mm256_and_si256(_mm256_or_si256(high, _mm256_srli_epi32(high, 16)), shortMask);
+
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), 0xd8);  // lane order 0, 2, 1, 3
+
+    _mm256_storeu_si256((__m256i*) (dst + 8 * longNr), _mm256_shuffle_epi8(packed, wordOrder));
+  }
+
+  return longNr;
+}
+
+
+AVX2_TARGET static int Avx2DecompactShortToInt(const char* src, char* dst, int nrOfLongs)
+{
+  __m256i intOrder = _mm256_setr_epi8(2, 3, 6, 7, 0, 1, 4, 5, 10, 11, 14, 15, 8, 9, 12, 13,
+    2, 3, 6, 7, 0, 1, 4, 5, 10, 11, 14, 15, 8, 9, 12, 13);
+  __m256i valueMask = _mm256_set1_epi32(32767);
+  __m256i naMask = _mm256_set1_epi32(32768);
+
+  int longNr = 0;
+  for (; longNr + 4 <= nrOfLongs; longNr += 4)
+  {
+    __m256i shorts = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*) (src + 8 * longNr)), intOrder);
+    char* ints = dst + 16 * longNr;
+
+    __m256i low = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(shorts));
+    __m256i high = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(shorts, 1));
+
+    low = _mm256_or_si256(_mm256_and_si256(low, valueMask), _mm256_slli_epi32(_mm256_and_si256(low, naMask), 16));
+    high = _mm256_or_si256(_mm256_and_si256(high, valueMask), _mm256_slli_epi32(_mm256_and_si256(high, naMask), 16));
+
+    _mm256_storeu_si256((__m256i*) ints, low);
+    _mm256_storeu_si256((__m256i*) (ints + 32), high);
+  }
+
+  return longNr;
+}
+
+
+// Minimum (also over NA), minimum over non-NA values and maximum of 8 integers at a time
+AVX2_TARGET static int Avx2IntRange(const int* intVec, int nrOfInts, int &rawMin, int &minVal, int &maxVal)
+{
+  __m256i na = _mm256_set1_epi32(INT_MIN);
+  __m256i large = _mm256_set1_epi32(INT_MAX);
+  __m256i rawMins = _mm256_set1_epi32(rawMin);
+  __m256i mins = _mm256_set1_epi32(minVal);
+  __m256i maxs = _mm256_set1_epi32(maxVal);
+
+  int pos = 0;
+  for (; pos + 8 <= nrOfInts; pos += 8)
+  {
+    __m256i vec = _mm256_loadu_si256((const __m256i*) &intVec[pos]);
+
+    rawMins = _mm256_min_epi32(rawMins, vec);
+    maxs = _mm256_max_epi32(maxs, vec);
+    mins = _mm256_min_epi32(mins, _mm256_blendv_epi8(vec, large, _mm256_cmpeq_epi32(vec, na)));
+  }
+
+  int lanes[24];
+  _mm256_storeu_si256((__m256i*) lanes, rawMins);
+  _mm256_storeu_si256((__m256i*) &lanes[8], mins);
+  _mm256_storeu_si256((__m256i*) &lanes[16], maxs);
+
+  for (int lane = 0; lane < 8; ++lane)
+  {
+    rawMin = lanes[lane] < rawMin ? lanes[lane] : rawMin;
+    minVal = lanes[8 + lane] < minVal ? lanes[8 + lane] : minVal;
+    maxVal = lanes[16 + lane] > maxVal ? lanes[16 + lane] : maxVal;
+  }
+
+  return pos;
+}
+
+
+// A group of 256 integers is packed as 32 rows of 8 integers, each lane of the register packs a column
+AVX2_TARGET static int Avx2IntBitPack(const int* intVec, char* packed, int nrOfGroups, int base, int bitWidth,
+  bool hasNA)
+{
+  __m256i na = _mm256_set1_epi32(INT_MIN);
+  __m256i naFlag = _mm256_set1_epi32(hasNA ? -1 : 0);
+  __m256i bases = _mm256_set1_epi32(base);
+  __m256i* words = (__m256i*) packed;
+
+  for (int group = 0; group < nrOfGroups; ++group)
+  {
+    const int* groupInts = &intVec[256 * group];
+    __m256i acc = _mm256_setzero_si256();
+    int bits = 0;
+
+    for (int row = 0; row < 32; ++row)
+    {
+      __m256i vec = _mm256_loadu_si256((const __m256i*) &groupInts[8 * row]);
+      __m256i isNA = _mm256_and_si256(_mm256_cmpeq_epi32(vec, na), naFlag);
+      __m256i code = _mm256_andnot_si256(isNA, _mm256_sub_epi32(vec, bases));
+
+      acc = _mm256_or_si256(acc, _mm256_sll_epi32(code, _mm_cvtsi32_si128(bits)));
+      bits += bitWidth;
+
+      if (bits >= 32)
+      {
+        _mm256_storeu_si256(words++, acc);
+        bits -= 32;
+        acc = _mm256_srl_epi32(code, _mm_cvtsi32_si128(bitWidth - bits));  // shifts of 32 give zero
+      }
+    }
+  }
+
+  return nrOfGroups;
+}
+
+
+AVX2_TARGET static int Avx2IntBitUnpack(const char* packed, int* intVec, int nrOfGroups, int base, int bitWidth,
+  bool hasNA)
+{
+  __m256i na = _mm256_set1_epi32(INT_MIN);
+  __m256i bases = _mm256_set1_epi32(base);
+  __m256i mask = _mm256_set1_epi32(bitWidth == 32 ? -1 : (1 << bitWidth) - 1);
+  __m256i naFlag = _mm256_set1_epi32(hasNA ? -1 : 0);
+  const __m256i* words = (const __m256i*) packed;
+
+  for (int group = 0; group < nrOfGroups; ++group)
+  {
+    int* groupInts = &intVec[256 * group];
+    const __m256i* groupWords = &words[bitWidth * group];
+    __m256i cur = bitWidth == 0 ? _mm256_setzero_si256() : _mm256_loadu_si256(groupWords);
+    int shift = 0;
+    int word = 0;
+
+    for (int row = 0; row < 32; ++row)
+    {
+      __m256i code = _mm256_srl_epi32(cur, _mm_cvtsi32_si128(shift));
+      shift += bitWidth;
+
+      if (shift >= 32)
+      {
+        shift -= 32;
+
+        if (++word < bitWidth)
+        {
+          cur = _mm256_loadu_si256(&groupWords[word]);
+          code = _mm256_or_si256(code, _mm256_sll_epi32(cur, _mm_cvtsi32_si128(bitWidth - shift)));
+        }
+      }
+
+      code = _mm256_and_si256(code, mask);
+      __m256i isNA = _mm256_and_si256(_mm256_cmpeq_epi32(code, _mm256_setzero_si256()), naFlag);
+      __m256i vec = _mm256_blendv_epi8(_mm256_add_epi32(code, bases), na, isNA);
+
+      _mm256_storeu_si256((__m256i*) &groupInts[8 * row], vec);
+    }
+  }
+
+  return nrOfGroups;
+}
+
+
+AVX2_TARGET inline __m256i ZigZag(__m256i delta)
+{
+  return _mm256_xor_si256(_mm256_slli_epi32(delta, 1), _mm256_srai_epi32(delta, 31));
+}
+
+
+// Codes of integers 2 and up (integer 1 is left to the caller), returns the index of the first integer not processed
+AVX2_TARGET static int Avx2IntDeltaWidth(const int* intVec, int nrOfInts, unsigned int &codes1, unsigned int &codes2,
+  bool &isSorted)
+{
+  __m256i bits1 = _mm256_setzero_si256();
+  __m256i bits2 = _mm256_setzero_si256();
+  __m256i unsorted = _mm256_setzero_si256();
+
+  int pos = 2;
+  for (; pos + 8 <= nrOfInts; pos += 8)
+  {
+    __m256i cur = _mm256_loadu_si256((const __m256i*) &intVec[pos]);
+    __m256i prev = _mm256_loadu_si256((const __m256i*) &intVec[pos - 1]);
+    __m256i prev2 = _mm256_loadu_si256((const __m256i*) &intVec[pos - 2]);
+
+    __m256i delta = _mm256_sub_epi32(cur, prev);
+    __m256i prevDelta = _mm256_sub_epi32(prev, prev2);
+
+    bits1 = _mm256_or_si256(bits1, ZigZag(delta));
+    bits2 = _mm256_or_si256(bits2, ZigZag(_mm256_sub_epi32(delta, prevDelta)));
+    unsorted = _mm256_or_si256(unsorted, _mm256_cmpgt_epi32(prev, cur));
+  }
+
+  unsigned int lanes[16];
+  _mm256_storeu_si256((__m256i*) lanes, bits1);
+  _mm256_storeu_si256((__m256i*) &lanes[8], bits2);
+
+  for (int lane = 0; lane < 8; ++lane)
+  {
+    codes1 |= lanes[lane];
+    codes2 |= lanes[8 + lane];
+  }
+
+  isSorted = isSorted && _mm256_testz_si256(unsorted, unsorted);
+
+  return pos;
+}
+
+
+// Inclusive prefix sum of 8 integers
+AVX2_TARGET inline __m256i PrefixSum(__m256i vec)
+{
+  vec = _mm256_add_epi32(vec, _mm256_slli_si256(vec, 4));
+  vec = _mm256_add_epi32(vec, _mm256_slli_si256(vec, 8));  // prefix sums within each 128-bit lane
+
+  __m256i lowTotal = _mm256_permutevar8x32_epi32(vec, _mm256_set1_epi32(3));
+  return _mm256_add_epi32(vec, _mm256_and_si256(lowTotal, _mm256_setr_epi32(0, 0, 0, 0, -1, -1, -1, -1)));
+}
+
+
+AVX2_TARGET static int Avx2IntDeltaDecode(int* intVec, int nrOfInts, int base, int order)
+{
+  __m256i last = _mm256_set1_epi32(7);
+  __m256i values = _mm256_set1_epi32(base);  // last value of the previous iteration
+  __m256i deltas = _mm256_setzero_si256();  // last delta of the previous iteration
+
+  int pos = 0;
+  for (; pos + 8 <= nrOfInts; pos += 8)
+  {
+    __m256i codes = _mm256_loadu_si256((const __m256i*) &intVec[pos]);
+    __m256i diffs = _mm256_xor_si256(_mm256_srli_epi32(codes, 1),
+      _mm256_sub_epi32(_mm256_setzero_si256(), _mm256_and_si256(codes, _mm256_set1_epi32(1))));
+
+    if (order == 2)
+    {
+      diffs = _mm256_add_epi32(PrefixSum(diffs), deltas);
+      deltas = _mm256_permutevar8x32_epi32(diffs, last);
+    }
+
+    values = _mm256_add_epi32(PrefixSum(diffs), values);
+    _mm256_storeu_si256((__m256i*) &intVec[pos], values);
+    values = _mm256_permutevar8x32_epi32(values, last);
+  }
+
+  return pos;
+}
+
+
+// Count the integers that differ from their predecessor, starting at integer 1
+AVX2_TARGET static int Avx2IntRunBounds(const int* intVec, int nrOfInts, unsigned int &nrOfBounds)
+{
+  unsigned int bounds = 0;
+
+  int pos = 1;
+  for (; pos + 8 <= nrOfInts; pos += 8)
+  {
+    __m256i values = _mm256_loadu_si256((const __m256i*) &intVec[pos]);
+    __m256i prevValues = _mm256_loadu_si256((const __m256i*) &intVec[pos - 1]);
+    int equalMask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(values, prevValues)));
+    bounds += 8 - __builtin_popcount(equalMask);
+  }
+
+  nrOfBounds += bounds;
+  return pos;
+}
+
+
+AVX2_TARGET static int Avx2IntFill(int* intVec, int nrOfInts, int value)
+{
+  __m256i values = _mm256_set1_epi32(value);
+
+  int pos = 0;
+  for (; pos + 32 <= nrOfInts; pos += 32)
+  {
+    _mm256_storeu_si256((__m256i*) &intVec[pos], values);
+    _mm256_storeu_si256((__m256i*) &intVec[pos + 8], values);
+    _mm256_storeu_si256((__m256i*) &intVec[pos + 16], values);
+    _mm256_storeu_si256((__m256i*) &intVec[pos + 24], values);
+  }
+
+  for (; pos + 8 <= nrOfInts; pos += 8)
+  {
+    _mm256_storeu_si256((__m256i*) &intVec[pos], values);
+  }
+
+  return pos;
+}
+
+
+// Stops at the first set of 4 doubles with a value that can't be converted, the scalar code rejects the vector
+AVX2_TARGET static int Avx2RealToInt(const double* realVec, int* intVec, int nrOfDoubles, double factor,
+  double naValue)
+{
+  __m256d factors = _mm256_set1_pd(factor);
+  __m256i naBits = _mm256_castpd_si256(_mm256_set1_pd(naValue));
+  __m128i naCode = _mm_set1_epi32(INT_MIN);
+
+  int pos = 0;
+  for (; pos + 4 <= nrOfDoubles; pos += 4)
+  {
+    __m256d values = _mm256_loadu_pd(&realVec[pos]);
+    __m256i isNA = _mm256_cmpeq_epi64(_mm256_castpd_si256(values), naBits);
+
+    __m128i codes = _mm256_cvtpd_epi32(_mm256_mul_pd(values, factors));  // INT_MIN if out of range
+    __m256d converted = _mm256_div_pd(_mm256_cvtepi32_pd(codes), factors);
+
+    // Bitwise identical (which excludes -0.0) or NA, and NA_INTEGER isn't used as a code
+    __m256i isExact = _mm256_cmpeq_epi64(_mm256_castpd_si256(converted), _mm256_castpd_si256(values));
+    __m256i isNACode = _mm256_cvtepi32_epi64(_mm_cmpeq_epi32(codes, naCode));
+    __m256i isValid = _mm256_or_si256(isNA, _mm256_andnot_si256(isNACode, isExact));
+
+    if (_mm256_movemask_pd(_mm256_castsi256_pd(isValid)) != 15) break;
+
+    _mm_storeu_si128((__m128i*) &intVec[pos], codes);  // NaN is converted to INT_MIN, which is NA_INTEGER
+  }
+
+  return pos;
+}
+
+
+AVX2_TARGET static int Avx2IntToReal(const int* intVec, double* realVec, int nrOfInts, double factor, double naValue)
+{
+  __m256d factors = _mm256_set1_pd(factor);
+  __m256d naValues = _mm256_set1_pd(naValue);
+  __m128i naCode = _mm_set1_epi32(INT_MIN);
+
+  // Codes are loaded before the results are stored, so realVec can overlap the upper half of the codes
+  int pos = 0;
+  for (; pos + 4 <= nrOfInts; pos += 4)
+  {
+    __m128i codes = _mm_loadu_si128((const __m128i*) &intVec[pos]);
+    __m256d values = _mm256_div_pd(_mm256_cvtepi32_pd(codes), factors);
+    __m256d isNA = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmpeq_epi32(codes, naCode)));
+
+    _mm256_storeu_pd(&realVec[pos], _mm256_blendv_pd(values, naValues, isNA));
+  }
+
+  return pos;
+}
+
+#endif  // COMPACT_AVX2
+
+
+// Used when the CPU has no supported instruction set, all words are left to the scalar code
+static int NoKernel(const char*, char*, int)
+{
+  return 0;
+}
+
+static int NoRangeKernel(const int*, int, int&, int&, int&)
+{
+  return 0;
+}
+
+static int NoBitPackKernel(const int*, char*, int, int, int, bool)
+{
+  return 0;
+}
+
+static int NoBitUnpackKernel(const char*, int*, int, int, int, bool)
+{
+  return 0;
+}
+
+static int NoDeltaWidthKernel(const int*, int, unsigned int&, unsigned int&, bool&)
+{
+  return 2;
+}
+
+static int NoDeltaDecodeKernel(int*, int, int, int)
+{
+  return 0;
+}
+
+static int NoRunCountKernel(const int*, int, unsigned int&)
+{
+  return 1;
+}
+
+static int NoFillKernel(int*, int, int)
+{
+  return 0;
+}
+
+static int NoRealToIntKernel(const double*, int*, int, double, double)
+{
+  return 0;
+}
+
+static int NoIntToRealKernel(const int*, double*, int, double, double)
+{
+  return 0;
+}
+
+
+class PackKernels
+{
+public:
+  PackKernel logicCompr64 = NoKernel;
+  PackKernel logicDecompr64 = NoKernel;
+  PackKernel compactIntToByte = NoKernel;
+  PackKernel decompactByteToInt = NoKernel;
+  PackKernel compactIntToShort = NoKernel;
+  PackKernel decompactShortToInt = NoKernel;
+  RangeKernel intRange = NoRangeKernel;
+  BitPackKernel intBitPack = NoBitPackKernel;
+  BitUnpackKernel intBitUnpack = NoBitUnpackKernel;
+  DeltaWidthKernel intDeltaWidth = NoDeltaWidthKernel;
+  DeltaDecodeKernel intDeltaDecode = NoDeltaDecodeKernel;
+  RunCountKernel intRunBounds = NoRunCountKernel;
+  FillKernel intFill = NoFillKernel;
+  RealToIntKernel realToInt = NoRealToIntKernel;
+  IntToRealKernel intToReal = NoIntToRealKernel;
+
+  PackKernels()
+  {
+#ifdef COMPACT_AVX2
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+      logicCompr64 = Avx2LogicCompr64;
+      logicDecompr64 = Avx2LogicDecompr64;
+      compactIntToByte = Avx2CompactIntToByte;
+      decompactByteToInt = Avx2DecompactByteToInt;
+      compactIntToShort = Avx2CompactIntToShort;
+      decompactShortToInt = Avx2DecompactShortToInt;
+      intRange = Avx2IntRange;
+      intBitPack = Avx2IntBitPack;
+      intBitUnpack = Avx2IntBitUnpack;
+      intDeltaWidth = Avx2IntDeltaWidth;
+      intDeltaDecode = Avx2IntDeltaDecode;
+      intRunBounds = Avx2IntRunBounds;
+      intFill = Avx2IntFill;
+      realToInt = Avx2RealToInt;
+      intToReal = Avx2IntToReal;
+    }
+#endif
+  }
+};
+
+
+// Kernels are selected on first use
+static inline const PackKernels &SelectedKernels()
+{
+  static const PackKernels packKernels;
+
+  return packKernels;
+}
+
+
+int SimdLogicCompr64(const char* logicalVec, unsigned long long* compress, int nrOfLongs)
+{
+  return SelectedKernels().logicCompr64(logicalVec, (char*) compress, nrOfLongs);
+}
+
+
+int SimdLogicDecompr64(char* logicalVec, const unsigned long long* compress, int nrOfLongs)
+{
+  return SelectedKernels().logicDecompr64((const char*) compress, logicalVec, nrOfLongs);
+}
+
+
+int SimdCompactIntToByte(char* outVec, const char* intVec, int nrOfLongs)
+{
+  return SelectedKernels().compactIntToByte(intVec, outVec, nrOfLongs);
+}
+
+
+int SimdDecompactByteToInt(const char* compressedVec, char* intVec, int nrOfLongs)
+{
+  return SelectedKernels().decompactByteToInt(compressedVec, intVec, nrOfLongs);
+}
+
+
+int SimdCompactIntToShort(char* outVec, const char* intVec, int nrOfLongs)
+{
+  return SelectedKernels().compactIntToShort(intVec, outVec, nrOfLongs);
+}
+
+
+int SimdDecompactShortToInt(const char* compressedVec, char* intVec, int nrOfLongs)
+{
+  return SelectedKernels().decompactShortToInt(compressedVec, intVec, nrOfLongs);
+}
+
+
+int SimdIntRange(const int* intVec, int nrOfInts, int &rawMin, int &minVal, int &maxVal)
+{
+  return SelectedKernels().intRange(intVec, nrOfInts, rawMin, minVal, maxVal);
+}
+
+
+int SimdIntBitPack(const int* intVec, char* packed, int nrOfGroups, int base, int bitWidth, bool hasNA)
+{
+  return SelectedKernels().intBitPack(intVec, packed, nrOfGroups, base, bitWidth, hasNA);
+}
+
+
+int SimdIntBitUnpack(const char* packed, int* intVec, int nrOfGroups, int base, int bitWidth, bool hasNA)
+{
+  return SelectedKernels().intBitUnpack(packed, intVec, nrOfGroups, base, bitWidth, hasNA);
+}
+
+
+int SimdIntDeltaWidth(const int* intVec, int nrOfInts, unsigned int &codes1, unsigned int &codes2, bool &isSorted)
+{
+  return SelectedKernels().intDeltaWidth(intVec, nrOfInts, codes1, codes2, isSorted);
+}
+
+
+int SimdIntDeltaDecode(int* intVec, int nrOfInts, int base, int order)
+{
+  return SelectedKernels().intDeltaDecode(intVec, nrOfInts, base, order);
+}
+
+
+int SimdIntRunBounds(const int* intVec, int nrOfInts, unsigned int &nrOfBounds)
+{
+  return SelectedKernels().intRunBounds(intVec, nrOfInts, nrOfBounds);
+}
+
+
+int SimdIntFill(int* intVec, int nrOfInts, int value)
+{
+  return SelectedKernels().intFill(intVec, nrOfInts, value);
+}
+
+
+int SimdRealToInt(const double* realVec, int* intVec, int nrOfDoubles, double factor, double naValue)
+{
+  return SelectedKernels().realToInt(realVec, intVec, nrOfDoubles, factor, naValue);
+}
+
+
+int SimdIntToReal(const int* intVec, double* realVec, int nrOfInts, double factor, double naValue)
+{
+  return SelectedKernels().intToReal(intVec, realVec, nrOfInts, factor, naValue);
+}
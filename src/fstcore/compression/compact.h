@@ -0,0 +1,97 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+
+#ifndef COMPACT_H
+#define COMPACT_H
+
+
+// Vectorized versions of the logical packing (LOGIC64), the integer compaction (INT_TO_BYTE, INT_TO_SHORT), the
+// frame of reference bit packing, the delta encoding and the run-length encoding of compression.cpp. A kernel is
+// used if the CPU supports AVX2. Each method processes the leading 64-bit words of the packed vector (of the
+// nrOfLongs words given) and returns the number of words processed, which is zero if no kernel is available. The
+// remaining words are left to the scalar code, so the packed layout is identical for all kernels.
+
+// Pack 32 logicals into each word
+int SimdLogicCompr64(const char* logicalVec, unsigned long long* compress, int nrOfLongs);
+
+int SimdLogicDecompr64(char* logicalVec, const unsigned long long* compress, int nrOfLongs);
+
+// Compact 8 integers into each word
+int SimdCompactIntToByte(char* outVec, const char* intVec, int nrOfLongs);
+
+int SimdDecompactByteToInt(const char* compressedVec, char* intVec, int nrOfLongs);
+
+// Compact 4 integers into each word
+int SimdCompactIntToShort(char* outVec, const char* intVec, int nrOfLongs);
+
+int SimdDecompactShortToInt(const char* compressedVec, char* intVec, int nrOfLongs);
+
+
+// Update the minimum, the minimum of the non-NA values and the maximum with the leading integers of the vector,
+// returns the number of integers processed
+int SimdIntRange(const int* intVec, int nrOfInts, int &rawMin, int &minVal, int &maxVal);
+
+// Bit pack groups of 256 integers, returns the number of groups processed
+int SimdIntBitPack(const int* intVec, char* packed, int nrOfGroups, int base, int bitWidth, bool hasNA);
+
+int SimdIntBitUnpack(const char* packed, int* intVec, int nrOfGroups, int base, int bitWidth, bool hasNA);
+
+
+// Update the bits used by the first and second order delta codes of integers 2 and up, returns the index of the
+// first integer not processed
+int SimdIntDeltaWidth(const int* intVec, int nrOfInts, unsigned int &codes1, unsigned int &codes2, bool &isSorted);
+
+// Decode the delta codes of the leading integers in place, returns the number of integers decoded
+int SimdIntDeltaDecode(int* intVec, int nrOfInts, int base, int order);
+
+
+// Update the number of integers 1 and up that differ from their predecessor (run boundaries), returns the index of
+// the first integer not processed
+int SimdIntRunBounds(const int* intVec, int nrOfInts, unsigned int &nrOfBounds);
+
+// Set the leading integers to value, returns the number of integers set
+int SimdIntFill(int* intVec, int nrOfInts, int value);
+
+
+// Convert the leading doubles to integer codes (value * factor), with NA_INTEGER for naValue. Returns the number of
+// doubles converted, the kernel stops at the first doubles that can't be converted exactly.
+int SimdRealToInt(const double* realVec, int* intVec, int nrOfDoubles, double factor, double naValue);
+
+// Convert the leading integer codes to doubles (code / factor), returns the number of codes converted
+int SimdIntToReal(const int* intVec, double* realVec, int nrOfInts, double factor, double naValue);
+
+
+#endif  // COMPACT_H
@@ -33,12 +33,19 @@
 */
 
 #include "compression.h"
+#include "shuffle.h"
+#include "compact.h"
+#include "lz4chain.h"
+#include "bitmapruns.h"
 
 #include <stdio.h>
 #include <stdint.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <math.h>
 #include <string.h>
 #include <algorithm>
+#include <vector>
 
 #include <iostream>
 #include <fstream>
@@ -53,11 +60,48 @@
 using namespace std;
 
 
+// Compress and decompress contexts are allocated once per thread and reused for all blocks that the thread
+// processes. A one-shot ZSTD_compress call allocates and initializes a new context for every block.
+class ZstdContexts
+{
+public:
+  ZSTD_CCtx* cctx = nullptr;
+  ZSTD_DCtx* dctx = nullptr;
+
+  ~ZstdContexts()
+  {
+    if (cctx != nullptr) ZSTD_freeCCtx(cctx);
+    if (dctx != nullptr) ZSTD_freeDCtx(dctx);
+  }
+};
+
+static thread_local ZstdContexts zstdContexts;
+
+
+inline size_t ZstdCompress(void* dst, size_t dstCapacity, const void* src, size_t srcSize, int compressionLevel)
+{
+  if (zstdContexts.cctx == nullptr) zstdContexts.cctx = ZSTD_createCCtx();
+
+  return ZSTD_compressCCtx(zstdContexts.cctx, dst, dstCapacity, src, srcSize, compressionLevel);
+}
+
+
+inline size_t ZstdDecompress(void* dst, size_t dstCapacity, const void* src, size_t compressedSize)
+{
+  if (zstdContexts.dctx == nullptr) zstdContexts.dctx = ZSTD_createDCtx();
+
+  return ZSTD_decompressDCtx(zstdContexts.dctx, dst, dstCapacity, src, compressedSize);
+}
+
+
 // The size of outVec is expected to be 2 times nrOfDoubles
 void ShuffleReal(double* inVec, double* outVec, int nrOfDoubles)
 {
   int blockLength = nrOfDoubles / 8;
 
+  // The leading blocks of 8 doubles are shuffled by a vectorized kernel (if available)
+  int firstBlock = SimdShuffleReal((const char*) inVec, (char*) outVec, blockLength);
+
   unsigned long long* vecIn  = (unsigned long long*) inVec;
   unsigned long long* vecOut = (unsigned long long*) outVec;
 
@@ -71,9 +115,9 @@ void ShuffleReal(double* inVec, double* outVec, int nrOfDoubles)
   unsigned long long byte6 = byte5 << 8;
   unsigned long long byte7 = byte6 << 8;
 
-  int offset = -1;
-  int blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  int offset = firstBlock - 1;
+  int blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine most significant byte
     vecOut[++offset] =
@@ -89,8 +133,9 @@ void ShuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 7th byte
     vecOut[++offset] =
@@ -105,8 +150,9 @@ void ShuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 6th byte
     vecOut[++offset] =
@@ -122,8 +168,9 @@ void ShuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 5th byte
     vecOut[++offset] =
@@ -139,8 +186,9 @@ void ShuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 4th byte
     vecOut[++offset] =
@@ -156,8 +204,9 @@ void ShuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 3th byte
     vecOut[++offset] =
@@ -173,8 +222,9 @@ void ShuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 2nd byte
     vecOut[++offset] =
@@ -190,8 +240,9 @@ void ShuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 1st byte
     vecOut[++offset] =
@@ -220,6 +271,7 @@ void ShuffleReal(double* inVec, double* outVec, int nrOfDoubles)
 void DeshuffleReal(double* inVec, double* outVec, int nrOfDoubles)
 {
   int blockLength = nrOfDoubles / 8;
+  int firstBlock = SimdDeshuffleReal((const char*) inVec, (char*) outVec, blockLength);
 
   unsigned long long* vecInReal  = (unsigned long long*) inVec;
   unsigned long long* vecOutReal = (unsigned long long*) outVec;
@@ -234,9 +286,9 @@ void DeshuffleReal(double* inVec, double* outVec, int nrOfDoubles)
   unsigned long long byte6 = byte5 << 8;
   unsigned long long byte7 = byte6 << 8;
 
-  int offset = -1;
-  int blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  int offset = firstBlock - 1;
+  int blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine most significant byte
     unsigned long long compVal = vecInReal[++offset];
@@ -253,8 +305,9 @@ void DeshuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 7th byte
     unsigned long long compVal = vecInReal[++offset];
@@ -271,8 +324,9 @@ void DeshuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 6th byte
     unsigned long long compVal = vecInReal[++offset];
@@ -289,8 +343,9 @@ void DeshuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 5th byte
     unsigned long long compVal = vecInReal[++offset];
@@ -307,8 +362,9 @@ void DeshuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 4th byte
     unsigned long long compVal = vecInReal[++offset];
@@ -325,8 +381,9 @@ void DeshuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 4th byte
     unsigned long long compVal = vecInReal[++offset];
@@ -343,8 +400,9 @@ void DeshuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 2nd byte
     unsigned long long compVal = vecInReal[++offset];
@@ -361,8 +419,9 @@ void DeshuffleReal(double* inVec, double* outVec, int nrOfDoubles)
     blockIndex += 8;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 8 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine least significant byte
     unsigned long long compVal = vecInReal[++offset];
@@ -392,6 +451,7 @@ void ShuffleInt2(int* inVec, int* outVec, int nrOfInts)
 {
   // Determine block length in number of longs
   int blockLength = nrOfInts / 8;
+  int firstBlock = SimdShuffleInt2((const char*) inVec, (char*) outVec, blockLength);
 
   unsigned long long* vecIn  = (unsigned long long*) inVec;
   unsigned long long* vecOut = (unsigned long long*) outVec;
@@ -402,9 +462,9 @@ void ShuffleInt2(int* inVec, int* outVec, int nrOfInts)
   unsigned long long byte2 = byte0 << 16;
   unsigned long long byte3 = byte0 << 24;
 
-  int offset = -1;
-  int blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  int offset = firstBlock - 1;
+  int blockIndex = 4 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine most significant byte
     vecOut[++offset] =
@@ -416,8 +476,9 @@ void ShuffleInt2(int* inVec, int* outVec, int nrOfInts)
     blockIndex += 4;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 4 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 3th byte
     vecOut[++offset] =
@@ -429,8 +490,9 @@ void ShuffleInt2(int* inVec, int* outVec, int nrOfInts)
     blockIndex += 4;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 4 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 2nd byte
     vecOut[++offset] =
@@ -442,8 +504,9 @@ void ShuffleInt2(int* inVec, int* outVec, int nrOfInts)
     blockIndex += 4;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 4 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 5th byte
     vecOut[++offset] =
@@ -466,6 +529,7 @@ void ShuffleInt2(int* inVec, int* outVec, int nrOfInts)
 void DeshuffleInt2(int* inVec, int* outVec, int nrOfInts)
 {
   int blockLength = nrOfInts / 8;
+  int firstBlock = SimdDeshuffleInt2((const char*) inVec, (char*) outVec, blockLength);
 
   unsigned long long* vecInLong  = (unsigned long long*) inVec;
   unsigned long long* vecOutLong = (unsigned long long*) outVec;
@@ -476,9 +540,9 @@ void DeshuffleInt2(int* inVec, int* outVec, int nrOfInts)
   unsigned long long byte2 = byte0 << 16;
   unsigned long long byte3 = byte0 << 24;
 
-  int offset = -1;
-  int blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  int offset = firstBlock - 1;
+  int blockIndex = 4 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine most significant byte
     unsigned long long compVal = vecInLong[++offset];
@@ -491,8 +555,9 @@ void DeshuffleInt2(int* inVec, int* outVec, int nrOfInts)
     blockIndex += 4;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 4 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 3th byte
     unsigned long long compVal = vecInLong[++offset];
@@ -505,8 +570,9 @@ void DeshuffleInt2(int* inVec, int* outVec, int nrOfInts)
     blockIndex += 4;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 4 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine 2nd byte
     unsigned long long compVal = vecInLong[++offset];
@@ -519,8 +585,9 @@ void DeshuffleInt2(int* inVec, int* outVec, int nrOfInts)
     blockIndex += 4;
   }
 
-  blockIndex = 0;
-  for (int i = 0; i < blockLength; ++i)
+  offset += firstBlock;
+  blockIndex = 4 * firstBlock;
+  for (int i = firstBlock; i < blockLength; ++i)
   {
     // Combine least significant byte
     unsigned long long compVal = vecInLong[++offset];
@@ -612,8 +679,11 @@ void LogicDecompr64(char* logicalVec, const unsigned long long* compBuf, int nrO
   unsigned long long* compress = (unsigned long long*) compBuf;
   int nrOfLongs = nrOfLogicals / 32;
 
+  // Leading words are unpacked by a vectorized kernel (if available)
+  int firstLong = SimdLogicDecompr64(logicalVec, compress, nrOfLongs);
+
   // Compress in cycles of 32 logicals
-  for (int i = 0; i < nrOfLongs; ++i)
+  for (int i = firstLong; i < nrOfLongs; ++i)
   {
     unsigned long long* logics = &logicals[16 * i];
     unsigned long long compVal = compress[i];
@@ -688,8 +758,11 @@ void LogicCompr64(const char* logicalVec, unsigned long long* compress, int nrOf
 
   const unsigned long long* logics;
 
+  // Leading words are packed by a vectorized kernel (if available)
+  int firstLong = SimdLogicCompr64(logicalVec, compress, nrOfLongs);
+
   // Compress in cycles of 32 logicals
-  for (int i = 0; i < nrOfLongs; ++i)
+  for (int i = firstLong; i < nrOfLongs; ++i)
   {
     logics = &logicals[16 * i];
 
@@ -721,7 +794,7 @@ void LogicCompr64(const char* logicalVec, unsigned long long* compress, int nrOf
   logics = &logicals[16 * nrOfLongs];
 
   int nrOfRemainLongs = 1 + (remain - 1) / 2;  // per 2 logicals
-  unsigned long long remainLongs[16];  // at maximum nrOfRemainLongs equals 16
+  unsigned long long remainLongs[16] = { 0 };  // at maximum nrOfRemainLongs equals 16, zero padding
   memcpy(remainLongs, logics, remain * sizeof(int));
 
   unsigned long long compRes = 0;
@@ -751,12 +824,13 @@ void CompactIntToByte(char* outVec, const char* intVec, unsigned int nrOfInts)
   unsigned long long byte2 = byte0 << 16;
   unsigned long long byte3 = byte0 << 24;
 
-  // Compact least significant byte
+  // Compact least significant byte, leading words with a vectorized kernel (if available)
 
-  int offset = -1;
-  int blockIndex = 0;
+  int firstLong = SimdCompactIntToByte(outVec, intVec, nrOfLongs);
+  int offset = firstLong - 1;
+  int blockIndex = 4 * firstLong;
 
-  for (int i = 0; i != nrOfLongs; ++i)
+  for (int i = firstLong; i != nrOfLongs; ++i)
   {
     vecOut[++offset] =
       (((vecIn[blockIndex + 3] >> 24) |  vecIn[blockIndex + 3]       ) & byte0) |
@@ -771,7 +845,7 @@ void CompactIntToByte(char* outVec, const char* intVec, unsigned int nrOfInts)
 
   int remain = nrOfInts - nrOfLongs * 8;
 
-  unsigned long long intBuf[4];
+  unsigned long long intBuf[4] = { 0, 0, 0, 0 };  // zero padding for a deterministic result
   memcpy(intBuf, &vecIn[blockIndex], remain * 4);
 
   vecOut[++offset] =
@@ -798,10 +872,11 @@ void DecompactShortToInt(const char* compressedVec, char* intVec, unsigned int n
 
   // unsigned long long byte0 = (65535LL << 32) | 65535LL;
 
-  // Compact least significant byte
+  // Compact least significant byte, leading words with a vectorized kernel (if available)
 
-  int blockIndex = -1;
-  for (int i = 0; i != nrOfLongs; ++i)
+  int firstLong = SimdDecompactShortToInt(compressedVec, intVec, nrOfLongs);
+  int blockIndex = 2 * firstLong - 1;
+  for (int i = firstLong; i != nrOfLongs; ++i)
   {
     unsigned long long val = vecCompress[i];
     vecOut[++blockIndex] = ((val >> 16) & byte0) | ( val        & byteNA);
@@ -838,11 +913,12 @@ void CompactIntToShort(char* outVec, const char* intVec, unsigned int nrOfInts)
   unsigned long long byte0 = (65535LL << 32) | 65535LL;
   unsigned long long byte1 = byte0 << 16;
 
-  // Compact 4 integers per cycle
+  // Compact 4 integers per cycle, leading words with a vectorized kernel (if available)
 
-  int offset = -1;
-  int blockIndex = 0;
-  for (int i = 0; i != nrOfLongs; ++i)
+  int firstLong = SimdCompactIntToShort(outVec, intVec, nrOfLongs);
+  int offset = firstLong - 1;
+  int blockIndex = 2 * firstLong;
+  for (int i = firstLong; i != nrOfLongs; ++i)
   {
     // vecOut[++offset] =
     // (((vecIn[blockIndex + 3] >> 24) |  vecIn[blockIndex + 3]       ) & byte0) |
@@ -862,7 +938,7 @@ void CompactIntToShort(char* outVec, const char* intVec, unsigned int nrOfInts)
 
   int remain = nrOfInts - nrOfLongs * 4;
 
-  unsigned long long intBuf[2];
+  unsigned long long intBuf[2] = { 0, 0 };  // zero padding for a deterministic result
   memcpy(intBuf, &vecIn[blockIndex], remain * 4);
 
   vecOut[++offset] =
@@ -885,10 +961,11 @@ void DecompactByteToInt(const char* compressedVec, char* intVec, unsigned int nr
   unsigned long long byteNA = (1LL << 31);
   byteNA = byteNA | (byteNA << 32);
 
-  // Compact least significant byte
+  // Compact least significant byte, leading words with a vectorized kernel (if available)
 
-  int blockIndex = -1;
-  for (int i = 0; i != nrOfLongs; ++i)
+  int firstLong = SimdDecompactByteToInt(compressedVec, intVec, nrOfLongs);
+  int blockIndex = 4 * firstLong - 1;
+  for (int i = firstLong; i != nrOfLongs; ++i)
   {
     unsigned long long val = vecCompress[i];
     vecOut[++blockIndex] = ((val >> 24) & byte0) | ( val       & byteNA);
@@ -912,376 +989,2059 @@ void DecompactByteToInt(const char* compressedVec, char* intVec, unsigned int nr
 }
 
 
-// Function pointer to compression algorithm
-typedef unsigned int (*CompAlgorithm)(char* dst, unsigned int dstCapacity, const char* src, unsigned int srcSize, int compressionLevel);
 
+// Frame of reference bit packing
 
-// Function pointer to decompression algorithm
-typedef unsigned int (*DecompAlgorithm)(char* dst, unsigned int dstCapacity, const char* src, unsigned int  compressedSize);
+unsigned int IntBitPackWidth(const int* intVec, unsigned int nrOfInts, int &base, bool &hasNA)
+{
+  int rawMin = INT_MAX;  // NA is the smallest integer
+  int minVal = INT_MAX;  // smallest value that is not NA
+  int maxVal = INT_MIN;
 
+  // Leading integers are scanned by a vectorized kernel (if available)
+  unsigned int firstInt = SimdIntRange(intVec, nrOfInts, rawMin, minVal, maxVal);
 
-// UNCOMPRESS,
+  for (unsigned int i = firstInt; i < nrOfInts; ++i)
+  {
+    int val = intVec[i];
+    rawMin = std::min(rawMin, val);
+    maxVal = std::max(maxVal, val);
+    minVal = std::min(minVal, val == INT_MIN ? INT_MAX : val);
+  }
 
-unsigned int NoCompression(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
-{
-  return 0;
-}
+  hasNA = rawMin == INT_MIN;
 
-unsigned int NoDecompression(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
-{
-  return 0;
-}
+  if (minVal > maxVal)  // only NA's
+  {
+    base = 0;
+    return 0;
+  }
 
+  // Code zero is reserved for NA if the block has NA's
+  long long frameBase = (long long) minVal - (hasNA ? 1 : 0);
+  unsigned long long maxCode = (unsigned long long) ((long long) maxVal - frameBase);
 
-// LZ4,
+  unsigned int bitWidth = 0;
+  while (bitWidth < 32 && (maxCode >> bitWidth) != 0) ++bitWidth;
 
-unsigned int LZ4_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
-{
-  return LZ4_compress_fast(src, dst, srcSize, dstCapacity, 101 - compressionLevel);  // no acceleration
+  base = (int) frameBase;  // NA's imply minVal > INT_MIN, so frameBase fits an integer
+  return bitWidth;
 }
 
-unsigned int LZ4_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+
+unsigned int IntBitPackSize(unsigned int nrOfInts, unsigned int bitWidth)
 {
-  return LZ4_decompress_fast(src, dst, dstCapacity);
+  unsigned int nrOfGroups = nrOfInts / BITPACK_GROUP_SIZE;
+  unsigned int remain = nrOfInts - nrOfGroups * BITPACK_GROUP_SIZE;
+
+  return nrOfGroups * 32 * bitWidth + 4 * ((remain * bitWidth + 31) / 32);
 }
 
-unsigned int LZ4_INT_TO_BYTE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+
+void IntBitPack(char* packed, const int* intVec, unsigned int nrOfInts, int base, unsigned int bitWidth, bool hasNA)
 {
-  int nrOfLongs = 1 + (srcSize - 1) / 32;  // srcSize is processed in blocks of 32 bytes
+  unsigned int nrOfGroups = nrOfInts / BITPACK_GROUP_SIZE;
+  unsigned int* words = (unsigned int*) packed;
 
-  // Compress buffer
-  char buf[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
-  // char buf[nrOfLongs * 8];
+  // Leading groups are packed by a vectorized kernel (if available)
+  unsigned int firstGroup = SimdIntBitPack(intVec, packed, nrOfGroups, base, bitWidth, hasNA);
 
-  CompactIntToByte(buf, src, srcSize / 4);
-  return LZ4_compress_fast(buf, dst, nrOfLongs * 8, dstCapacity, 101 - compressionLevel);  // no acceleration at compress == 100
-}
+  // Each of the 8 lanes of a group packs every 8th integer into every 8th word
+  for (unsigned int group = firstGroup; group < nrOfGroups; ++group)
+  {
+    const int* groupInts = &intVec[group * BITPACK_GROUP_SIZE];
+    unsigned int* groupWords = &words[group * 8 * bitWidth];
 
-unsigned int LZ4_INT_TO_BYTE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
-{
-  int nrOfLongs = 1 + (dstCapacity - 1) / 32;  // srcSize is processed in blocks of 32 bytes
-  int nrOfDstInts = dstCapacity / 4;
+    for (int lane = 0; lane < 8; ++lane)
+    {
+      unsigned long long acc = 0;
+      unsigned int bits = 0;
+      unsigned int word = 0;
+
+      for (int row = 0; row < 32; ++row)
+      {
+        int val = groupInts[8 * row + lane];
+        unsigned int code = (hasNA && val == INT_MIN) ? 0 : (unsigned int) val - (unsigned int) base;
+
+        acc |= (unsigned long long) code << bits;
+        bits += bitWidth;
+
+        if (bits >= 32)
+        {
+          groupWords[8 * word++ + lane] = (unsigned int) acc;
+          acc >>= 32;
+          bits -= 32;
+        }
+      }
+    }
+  }
 
-  // Compress buffer
-  char buf[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
-  // char buf[nrOfLongs * 8];
+  // Remaining integers are packed sequentially
+  unsigned int* tailWords = &words[nrOfGroups * 8 * bitWidth];
+  unsigned long long acc = 0;
+  unsigned int bits = 0;
+  unsigned int word = 0;
 
-  // Decompress
-  LZ4_decompress_fast(src, (char*) buf, nrOfLongs * 8);
-  DecompactByteToInt(buf, dst, nrOfDstInts);  // one integer per byte
+  for (unsigned int i = nrOfGroups * BITPACK_GROUP_SIZE; i < nrOfInts; ++i)
+  {
+    int val = intVec[i];
+    unsigned int code = (hasNA && val == INT_MIN) ? 0 : (unsigned int) val - (unsigned int) base;
 
-  return nrOfDstInts * 4;
+    acc |= (unsigned long long) code << bits;
+    bits += bitWidth;
+
+    if (bits >= 32)
+    {
+      tailWords[word++] = (unsigned int) acc;
+      acc >>= 32;
+      bits -= 32;
+    }
+  }
+
+  if (bits > 0) tailWords[word] = (unsigned int) acc;
 }
 
 
-unsigned int ZSTD_INT_TO_BYTE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+void IntBitUnpack(int* intVec, const char* packed, unsigned int nrOfInts, int base, unsigned int bitWidth, bool hasNA)
 {
-  int nrOfLongs = 1 + (srcSize - 1) / 32;  // srcSize is processed in blocks of 32 bytes
+  unsigned int nrOfGroups = nrOfInts / BITPACK_GROUP_SIZE;
+  const unsigned int* words = (const unsigned int*) packed;
+  unsigned long long mask = (1ULL << bitWidth) - 1;
 
-  // Compress buffer
-  char buf[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
-  // char buf[nrOfLongs * 8];
+  // Leading groups are unpacked by a vectorized kernel (if available)
+  unsigned int firstGroup = SimdIntBitUnpack(packed, intVec, nrOfGroups, base, bitWidth, hasNA);
 
-  CompactIntToByte(buf, src, srcSize / 4);
+  for (unsigned int group = firstGroup; group < nrOfGroups; ++group)
+  {
+    int* groupInts = &intVec[group * BITPACK_GROUP_SIZE];
+    const unsigned int* groupWords = &words[group * 8 * bitWidth];
 
-  return ZSTD_compress(dst, dstCapacity, (char*) buf,  nrOfLongs * 8,  compressionLevel / 4.5);
-}
+    for (int lane = 0; lane < 8; ++lane)
+    {
+      unsigned long long acc = 0;
+      unsigned int bits = 0;
+      unsigned int word = 0;
+
+      for (int row = 0; row < 32; ++row)
+      {
+        if (bits < bitWidth)
+        {
+          acc |= (unsigned long long) groupWords[8 * word++ + lane] << bits;
+          bits += 32;
+        }
+
+        unsigned int code = (unsigned int) (acc & mask);
+        acc >>= bitWidth;
+        bits -= bitWidth;
+
+        groupInts[8 * row + lane] = (hasNA && code == 0) ? INT_MIN : (int) (code + (unsigned int) base);
+      }
+    }
+  }
 
-unsigned int ZSTD_INT_TO_BYTE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
-{
-  int nrOfLongs = 1 + (dstCapacity - 1) / 32;  // srcSize is processed in blocks of 32 bytes
-  int nrOfDstInts = dstCapacity / 4;
+  const unsigned int* tailWords = &words[nrOfGroups * 8 * bitWidth];
+  unsigned long long acc = 0;
+  unsigned int bits = 0;
+  unsigned int word = 0;
 
-  // Compress buffer
-  // char buf[nrOfLongs * 8];
-  char buf[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  for (unsigned int i = nrOfGroups * BITPACK_GROUP_SIZE; i < nrOfInts; ++i)
+  {
+    if (bits < bitWidth)
+    {
+      acc |= (unsigned long long) tailWords[word++] << bits;
+      bits += 32;
+    }
 
-  // Decompress
-  ZSTD_decompress((char*) buf, 8 * nrOfLongs, src, compressedSize);
-  DecompactByteToInt(buf, dst, nrOfDstInts);  // one integer per byte
+    unsigned int code = (unsigned int) (acc & mask);
+    acc >>= bitWidth;
+    bits -= bitWidth;
 
-  return nrOfDstInts * 4;
+    intVec[i] = (hasNA && code == 0) ? INT_MIN : (int) (code + (unsigned int) base);
+  }
 }
 
-unsigned int LZ4_INT_TO_SHORT_SHUF2_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
-{
-  int nrOfLongs = 1 + (srcSize - 1) / 16;  // srcSize is processed in blocks of 16 bytes
 
-  // Compress buffer
-  // char buf[nrOfLongs * 8];
-  char buf[MAX_SIZE_COMPRESS_BLOCK_HALF];
+// Delta encoding
 
-  CompactIntToShort(buf, src, srcSize / 4);  // expecting a integer vector here
-  return LZ4_compress_fast(buf, dst, nrOfLongs * 8, dstCapacity, 100 - compressionLevel);  // no acceleration at compress == 100
+inline unsigned int BitWidth(unsigned long long maxCode)
+{
+  unsigned int bitWidth = 0;
+  while (bitWidth < 64 && (maxCode >> bitWidth) != 0) ++bitWidth;
+
+  return bitWidth;
 }
 
-unsigned int LZ4_INT_TO_SHORT_SHUF2_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+// Map signed differences to unsigned codes: 0, -1, 1, -2, 2, ... become 0, 1, 2, 3, 4, ...
+inline unsigned int ZigZag(unsigned int delta)
 {
-  int nrOfLongs = 1 + (dstCapacity - 1) / 16;  // srcSize is processed in blocks of 32 bytes
-  int nrOfDstInts = dstCapacity / 4;
-
-  // Compress buffer
-  // char buf[nrOfLongs * 8];
-  char buf[MAX_SIZE_COMPRESS_BLOCK_HALF];
+  return (delta << 1) ^ (unsigned int) ((int) delta >> 31);
+}
 
-  // Decompress
-  LZ4_decompress_fast(src, (char*) buf, nrOfLongs * 8);
-  DecompactShortToInt(buf, dst, nrOfDstInts);  // one integer per byte
+inline unsigned long long ZigZag(long long delta)
+{
+  return ((unsigned long long) delta << 1) ^ (unsigned long long) (delta >> 63);
+}
 
-  return nrOfDstInts * 4;
+inline unsigned int UnZigZag(unsigned int code)
+{
+  return (code >> 1) ^ (0U - (code & 1));
 }
 
-// Factor algorithms
 
-unsigned int INT_TO_BYTE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+unsigned int IntDeltaWidth(const int* intVec, unsigned int nrOfInts, int &order, bool &isSorted)
 {
-  unsigned int nrOfLongs = 1 + (srcSize - 1) / 32;  // srcSize is processed in blocks of 32 bytes
+  const unsigned int* values = (const unsigned int*) intVec;
+  unsigned int codes1 = 0;  // bits used by the first order codes
+  unsigned int codes2 = 0;  // bits used by the second order codes
 
-  CompactIntToByte(dst, src, srcSize / 4);
+  isSorted = true;
 
-  return 8 * nrOfLongs;
-}
+  if (nrOfInts > 1)  // the first delta has a second order code of zero
+  {
+    codes1 = ZigZag(values[1] - values[0]);
+    isSorted = intVec[1] >= intVec[0];
+  }
 
-unsigned int INT_TO_BYTE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
-{
-  DecompactByteToInt(src, dst, dstCapacity / 4);  // one integer per byte
+  // Integers from index 2 are scanned by a vectorized kernel (if available)
+  unsigned int firstInt = SimdIntDeltaWidth(intVec, nrOfInts, codes1, codes2, isSorted);
 
-  return dstCapacity / 4;
-}
+  for (unsigned int i = firstInt; i < nrOfInts; ++i)
+  {
+    unsigned int delta = values[i] - values[i - 1];  // wraps around, but decodes correctly
 
-unsigned int INT_TO_SHORT_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
-{
-  int nrOfLongs = 1 + (srcSize - 1) / 16;  // srcSize is processed in blocks of 32 bytes
+    isSorted = isSorted && intVec[i] >= intVec[i - 1];
+    codes1 |= ZigZag(delta);
+    codes2 |= ZigZag(delta - (values[i - 1] - values[i - 2]));
+  }
 
-  CompactIntToShort(dst, src, srcSize / 4);
+  unsigned int width1 = BitWidth(codes1);
+  unsigned int width2 = BitWidth(codes2);
 
-  return 8 * nrOfLongs;
+  order = width2 < width1 ? 2 : 1;
+  return std::min(width1, width2);
 }
 
-unsigned int INT_TO_SHORT_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+
+void IntDeltaEncode(unsigned int* codes, const int* intVec, unsigned int nrOfInts, int order)
 {
-  DecompactShortToInt(src, dst, dstCapacity / 4);  // one integer per short
+  const unsigned int* values = (const unsigned int*) intVec;
 
-  return dstCapacity / 4;
-}
+  codes[0] = 0;
 
-// LOGIC64
+  if (order == 1)
+  {
+    for (unsigned int i = 1; i < nrOfInts; ++i)
+    {
+      codes[i] = ZigZag(values[i] - values[i - 1]);
+    }
 
-unsigned int LOGIC64_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
-{
-  int nrOfLogicals = srcSize / 4;  // srcSize must be a multiple of 4
-  int nrOfLongs = 1 + (nrOfLogicals - 1) / 32;
+    return;
+  }
 
-  LogicCompr64(src, (unsigned long long*) dst, nrOfLogicals);
-  return 8 * nrOfLongs;
+  if (nrOfInts > 1) codes[1] = 0;  // first delta is stored in the block header
+
+  for (unsigned int i = 2; i < nrOfInts; ++i)
+  {
+    codes[i] = ZigZag((values[i] - values[i - 1]) - (values[i - 1] - values[i - 2]));
+  }
 }
 
-unsigned int LOGIC64_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+
+void IntDeltaDecode(int* intVec, unsigned int nrOfInts, int base, int firstDelta, int order)
 {
-  int nrOfLogicals = dstCapacity / 4;  // dstCapacity must be a multiple of 4
+  unsigned int* values = (unsigned int*) intVec;  // holds the codes on entry
 
-  LogicDecompr64(dst, (unsigned long long*) src, nrOfLogicals, 0);
+  // With a difference of zero for the first value, and the first delta as the difference of the first two deltas,
+  // the values are the (double) prefix sums of the differences
+  values[0] = 0;
+  if (order == 2 && nrOfInts > 1) values[1] = ZigZag((unsigned int) firstDelta);
 
-  return (unsigned int) nrOfLogicals * 4;
+  // Leading integers are decoded by a vectorized kernel (if available)
+  unsigned int firstInt = SimdIntDeltaDecode(intVec, nrOfInts, base, order);
+
+  unsigned int value = firstInt == 0 ? (unsigned int) base : values[firstInt - 1];
+  unsigned int delta = firstInt < 2 ? 0 : values[firstInt - 1] - values[firstInt - 2];
+
+  for (unsigned int i = firstInt; i < nrOfInts; ++i)
+  {
+    if (order == 1)
+    {
+      value += UnZigZag(values[i]);
+    }
+    else
+    {
+      delta += UnZigZag(values[i]);
+      value += delta;
+    }
+
+    values[i] = value;
+  }
 }
 
 
-// LZ4_LOGIC64
+#define MAX_EXACT_INTEGER 9007199254740992.0  // 2^53, larger doubles are not all integers
 
-// Buffer src should contain an integer vector (with logicals)
-// srcSize must be a multiple of 4
-unsigned int LZ4_LOGIC64_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+// Check if a double holds an integer value (-0.0 excluded), and convert it
+inline bool IntegerValued(double value, long long &intValue)
 {
-  // Create compression buffer
-  int nrOfLogicals = srcSize / 4;
-  int nrOfLongs = 1 + (nrOfLogicals - 1) / 32;
+  if (!(value >= -MAX_EXACT_INTEGER && value <= MAX_EXACT_INTEGER)) return false;  // also excludes NaN
 
-  // Compress buffer
-  // unsigned long long buf[nrOfLongs];
-  unsigned long long buf[MAX_SIZE_COMPRESS_BLOCK_128];
+  intValue = (long long) value;
+  double converted = (double) intValue;
 
-  LogicCompr64(src, buf, nrOfLogicals);
-  return LZ4_compress_fast((char*) buf, dst, nrOfLongs * 8, dstCapacity, 100 - compressionLevel);  // no acceleration at compress == 100
+  return memcmp(&converted, &value, 8) == 0;
 }
 
-unsigned int LZ4_LOGIC64_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
-{
-  int nrOfLogicals = dstCapacity / 4;
-  int nrOfLongs = 1 + (nrOfLogicals - 1) / 32;
 
-  // Compress buffer
-  // unsigned long long buf[nrOfLongs];
-  unsigned long long buf[MAX_SIZE_COMPRESS_BLOCK_128];
+unsigned int RealDeltaWidth(const double* realVec, unsigned int nrOfDoubles, int &order, bool &isSorted)
+{
+  unsigned long long codes1 = 0;
+  unsigned long long codes2 = 0;
+  long long prevValue, value;
+  long long prevDelta = 0;
 
-  // Decompress
-  int size = LZ4_decompress_fast(src, (char*) buf, 8 * nrOfLongs);
-  LogicDecompr64(dst, (unsigned long long*) buf, nrOfLogicals, 0);
+  isSorted = true;
+  if (!IntegerValued(realVec[0], prevValue)) return 64;
 
-  return size;
-}
+  for (unsigned int i = 1; i < nrOfDoubles; ++i)
+  {
+    if (!IntegerValued(realVec[i], value)) return 64;
 
+    long long delta = value - prevValue;
 
-// ZSTD_LOGIC64
+    if (i == 1) prevDelta = delta;
 
-// Buffer src should contain an integer vector (with logicals)
-// srcSize must be a multiple of 4
-unsigned int ZSTD_LOGIC64_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
-{
-  // Create compression buffer
-  int nrOfLogicals = srcSize / 4;
-  int nrOfLongs = 1 + (nrOfLogicals - 1) / 32;
+    isSorted = isSorted && delta >= 0;
+    codes1 |= ZigZag(delta);
+    codes2 |= ZigZag(delta - prevDelta);
+    prevDelta = delta;
+    prevValue = value;
+  }
 
-  // Compress buffer
-  // unsigned long long buf[nrOfLongs];
-  unsigned long long buf[MAX_SIZE_COMPRESS_BLOCK_128];
+  unsigned int width1 = BitWidth(codes1);
+  unsigned int width2 = BitWidth(codes2);
 
-  LogicCompr64(src, buf, nrOfLogicals);
+  // The first delta is stored in the block header as a 32-bit integer
+  if (nrOfDoubles > 1)
+  {
+    long long firstDelta = (long long) realVec[1] - (long long) realVec[0];
+    if (firstDelta < INT_MIN || firstDelta > INT_MAX) width2 = 64;
+  }
 
-  return ZSTD_compress(dst, dstCapacity, (char*) buf,  nrOfLongs * 8,  compressionLevel / 4.5);
+  order = width2 < width1 ? 2 : 1;
+  return std::min(width1, width2);
 }
 
-unsigned int ZSTD_LOGIC64_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+
+void RealDeltaEncode(unsigned int* codes, const double* realVec, unsigned int nrOfDoubles, int order)
 {
-  int nrOfLogicals = dstCapacity / 4;
-  int nrOfLongs = 1 + (nrOfLogicals - 1) / 32;
+  codes[0] = 0;
 
-    // Compress buffer
-  // unsigned long long buf[nrOfLongs];
-  unsigned long long buf[MAX_SIZE_COMPRESS_BLOCK_128];
+  if (order == 1)
+  {
+    for (unsigned int i = 1; i < nrOfDoubles; ++i)
+    {
+      codes[i] = (unsigned int) ZigZag((long long) realVec[i] - (long long) realVec[i - 1]);
+    }
 
-  // Decompress
-  int size = ZSTD_decompress((char*) buf, 8 * nrOfLongs, src, compressedSize);
-  LogicDecompr64(dst, (unsigned long long*) buf, nrOfLogicals, 0);
+    return;
+  }
 
-  return size;
-}
+  if (nrOfDoubles > 1) codes[1] = 0;
 
+  for (unsigned int i = 2; i < nrOfDoubles; ++i)
+  {
+    long long delta = (long long) realVec[i] - (long long) realVec[i - 1];
+    long long prevDelta = (long long) realVec[i - 1] - (long long) realVec[i - 2];
+    codes[i] = (unsigned int) ZigZag(delta - prevDelta);
+  }
+}
 
-// LZ4_SHUF4,
 
-// Buffer src should contain an integer vector
-// srcSize must be a multiple of 4
-unsigned int LZ4_C_SHUF4(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+void RealDeltaDecode(double* realVec, const unsigned int* codes, unsigned int nrOfDoubles, long long base,
+  int firstDelta, int order)
 {
-  int intSize = srcSize / 4;
+  long long value = base;
+  long long delta = firstDelta;
 
-  unsigned long long shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_8];
-  // int shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  realVec[0] = (double) value;
 
-  ShuffleInt2((int*) src, (int*) shuffleBuf, intSize);
-  return LZ4_compress_fast((char*) shuffleBuf, dst, srcSize, dstCapacity, 100 - compressionLevel);  // large acceleration
+  for (unsigned int i = 1; i < nrOfDoubles; ++i)
+  {
+    long long code = (long long) (codes[i] >> 1) ^ -(long long) (codes[i] & 1);
+
+    if (order == 1) delta = code;
+    else if (i > 1) delta += code;
+
+    value += delta;
+    realVec[i] = (double) value;
+  }
 }
 
-unsigned int LZ4_D_SHUF4(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
-{
-  int intSize = dstCapacity / 4;
 
-  unsigned long long shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_8];
-  // int shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+// Differences of 64-bit integers wrap around (as unsigned values), but decode correctly
 
-  int size = LZ4_decompress_fast(src, (char*) shuffleBuf, dstCapacity);
-  DeshuffleInt2((int*) shuffleBuf, (int*) dst, intSize);
+unsigned int LongDeltaWidth(const long long* longVec, unsigned int nrOfLongs, int &order, bool &isSorted)
+{
+  const unsigned long long* values = (const unsigned long long*) longVec;
+  unsigned long long codes1 = 0;
+  unsigned long long codes2 = 0;
+  unsigned long long prevDelta = nrOfLongs > 1 ? values[1] - values[0] : 0;
 
-  return size;
-}
+  isSorted = true;
 
+  for (unsigned int i = 1; i < nrOfLongs; ++i)
+  {
+    unsigned long long delta = values[i] - values[i - 1];
 
-// LZ4_SHUF8,
+    isSorted = isSorted && longVec[i] >= longVec[i - 1];
+    codes1 |= ZigZag((long long) delta);
+    codes2 |= ZigZag((long long) (delta - prevDelta));
+    prevDelta = delta;
+  }
+
+  unsigned int width1 = BitWidth(codes1);
+  unsigned int width2 = BitWidth(codes2);
+
+  // The first delta is stored in the block header as a 32-bit integer
+  if (nrOfLongs > 1)
+  {
+    long long firstDelta = (long long) (values[1] - values[0]);
+    if (firstDelta < INT_MIN || firstDelta > INT_MAX) width2 = 64;
+  }
+
+  order = width2 < width1 ? 2 : 1;
+  return std::min(width1, width2);
+}
+
+
+void LongDeltaEncode(unsigned int* codes, const long long* longVec, unsigned int nrOfLongs, int order)
+{
+  const unsigned long long* values = (const unsigned long long*) longVec;
+
+  codes[0] = 0;
+
+  if (order == 1)
+  {
+    for (unsigned int i = 1; i < nrOfLongs; ++i)
+    {
+      codes[i] = (unsigned int) ZigZag((long long) (values[i] - values[i - 1]));
+    }
+
+    return;
+  }
+
+  if (nrOfLongs > 1) codes[1] = 0;
+
+  for (unsigned int i = 2; i < nrOfLongs; ++i)
+  {
+    unsigned long long delta = values[i] - values[i - 1];
+    unsigned long long prevDelta = values[i - 1] - values[i - 2];
+    codes[i] = (unsigned int) ZigZag((long long) (delta - prevDelta));
+  }
+}
+
+
+void LongDeltaDecode(long long* longVec, const unsigned int* codes, unsigned int nrOfLongs, long long base,
+  int firstDelta, int order)
+{
+  unsigned long long* values = (unsigned long long*) longVec;
+  unsigned long long value = (unsigned long long) base;
+  unsigned long long delta = (unsigned long long) (long long) firstDelta;
+
+  values[0] = value;
+
+  for (unsigned int i = 1; i < nrOfLongs; ++i)
+  {
+    unsigned long long code = (unsigned long long) (codes[i] >> 1) ^ (0ULL - (codes[i] & 1));
+
+    if (order == 1) delta = code;
+    else if (i > 1) delta += code;
+
+    value += delta;
+    values[i] = value;
+  }
+}
+
+
+// Sparse blocks are processed as unsigned integers of the element size, so NA's are compared by bit pattern
+
+template<typename T>
+inline unsigned int SparseCount(const T* vec, unsigned int nrOfElements, T naBits)
+{
+  unsigned int nrOfValues = 0;
+
+  for (unsigned int pos = 0; pos < nrOfElements; ++pos)
+  {
+    nrOfValues += vec[pos] != naBits;
+  }
+
+  return nrOfValues;
+}
+
+
+template<typename T>
+inline unsigned int SparseEncodeBlock(char* dst, const T* vec, unsigned int nrOfElements, T naBits)
+{
+  unsigned int nrOfWords = (nrOfElements + 63) / 64;
+  unsigned int* header = (unsigned int*) dst;
+  unsigned long long* bitmap = (unsigned long long*) &dst[SPARSE_HEADER_SIZE];
+  T* values = (T*) &bitmap[nrOfWords];
+  unsigned int nrOfValues = 0;
+
+  for (unsigned int word = 0; word < nrOfWords; ++word)
+  {
+    const T* wordVec = &vec[64 * word];
+    unsigned int wordLength = min(64U, nrOfElements - 64 * word);
+    unsigned long long bits = 0;
+
+    for (unsigned int pos = 0; pos < wordLength; ++pos)
+    {
+      if (wordVec[pos] == naBits) continue;
+
+      bits |= 1ULL << pos;
+      values[nrOfValues++] = wordVec[pos];
+    }
+
+    bitmap[word] = bits;
+  }
+
+  header[0] = nrOfValues;
+  header[1] = 0;
+
+  return SPARSE_HEADER_SIZE + 8 * nrOfWords + sizeof(T) * nrOfValues;
+}
+
+
+template<typename T>
+inline void SparseDecodeBlock(T* vec, const char* src, unsigned int nrOfElements, T naBits)
+{
+  unsigned int nrOfWords = (nrOfElements + 63) / 64;
+  const unsigned long long* bitmap = (const unsigned long long*) &src[SPARSE_HEADER_SIZE];
+  const T* values = (const T*) &bitmap[nrOfWords];
+
+  // runs of NA's are filled and runs of values are copied, each element is written once
+  BitmapRuns(bitmap, 0, nrOfElements, [&](unsigned int runStart, unsigned int runEnd, bool isValue)
+  {
+    if (!isValue)
+    {
+      std::fill(vec + runStart, vec + runEnd, naBits);
+      return;
+    }
+
+    memcpy(vec + runStart, values, sizeof(T) * (runEnd - runStart));
+    values += runEnd - runStart;
+  });
+}
+
+
+unsigned int SparseValueCount(const char* src, unsigned int nrOfElements, unsigned int elementSize,
+  unsigned long long naBits)
+{
+  if (elementSize == 4)
+  {
+    return SparseCount((const unsigned int*) src, nrOfElements, (unsigned int) naBits);
+  }
+
+  return SparseCount((const unsigned long long*) src, nrOfElements, naBits);
+}
+
+
+unsigned int SparseEncode(char* dst, const char* src, unsigned int nrOfElements, unsigned int elementSize,
+  unsigned long long naBits)
+{
+  if (elementSize == 4)
+  {
+    return SparseEncodeBlock(dst, (const unsigned int*) src, nrOfElements, (unsigned int) naBits);
+  }
+
+  return SparseEncodeBlock(dst, (const unsigned long long*) src, nrOfElements, naBits);
+}
+
+
+void SparseDecode(char* dst, const char* src, unsigned int nrOfElements, unsigned int elementSize,
+  unsigned long long naBits)
+{
+  if (elementSize == 4)
+  {
+    SparseDecodeBlock((unsigned int*) dst, src, nrOfElements, (unsigned int) naBits);
+    return;
+  }
+
+  SparseDecodeBlock((unsigned long long*) dst, src, nrOfElements, naBits);
+}
+
+
+// XOR compression of doubles
+
+// Writes bit fields to a vector of 64-bit words, starting at the least significant bit
+class BitWriter
+{
+  unsigned long long* words;
+  unsigned long long acc = 0;  // bits not yet written
+  unsigned int fill = 0;  // number of bits in acc
+  unsigned int pos = 0;  // next word
+
+public:
+  BitWriter(char* dst) : words((unsigned long long*) dst) {}
+
+  // Write the count (1 - 64) lowest bits of bits, higher bits must be zero
+  inline void Write(unsigned long long bits, unsigned int count)
+  {
+    acc |= bits << fill;
+    fill += count;
+
+    if (fill >= 64)
+    {
+      words[pos++] = acc;
+      fill -= 64;
+      acc = fill == 0 ? 0 : bits >> (count - fill);
+    }
+  }
+
+  // Returns the number of bytes written
+  unsigned int Flush()
+  {
+    if (fill > 0) words[pos++] = acc;
+    return 8 * pos;
+  }
+};
+
+
+class BitReader
+{
+  const unsigned long long* words;
+  unsigned long long acc = 0;  // bits not yet read
+  unsigned int avail = 0;  // number of bits in acc
+
+public:
+  BitReader(const char* src) : words((const unsigned long long*) src) {}
+
+  // Read count (1 - 64) bits
+  inline unsigned long long Read(unsigned int count)
+  {
+    unsigned long long mask = count == 64 ? ~0ULL : (1ULL << count) - 1;
+    unsigned long long bits;
+
+    if (avail >= count)
+    {
+      bits = acc & mask;
+      acc = count == 64 ? 0 : acc >> count;
+      avail -= count;
+      return bits;
+    }
+
+    unsigned long long next = *words++;
+    bits = (acc | (next << avail)) & mask;
+
+    unsigned int used = count - avail;  // bits used from next
+    acc = used == 64 ? 0 : next >> used;
+    avail = 64 - used;
+
+    return bits;
+  }
+};
+
+
+unsigned int RealXorCompress(char* dst, const double* realVec, unsigned int nrOfDoubles)
+{
+  const unsigned long long* values = (const unsigned long long*) realVec;
+  BitWriter writer(dst);
+
+  unsigned long long prev = values[0];
+  unsigned int prevLead = 65;  // no window yet
+  unsigned int prevTrail = 0;
+
+  writer.Write(prev, 64);
+
+  for (unsigned int i = 1; i < nrOfDoubles; ++i)
+  {
+    unsigned long long x = values[i] ^ prev;
+    prev = values[i];
+
+    if (x == 0)  // identical value
+    {
+      writer.Write(0, 1);
+      continue;
+    }
+
+    unsigned int lead = std::min(__builtin_clzll(x), 31);
+    unsigned int trail = __builtin_ctzll(x);
+
+    if (lead >= prevLead && trail >= prevTrail)  // meaningful bits fit the previous window
+    {
+      writer.Write(1, 2);
+      writer.Write(x >> prevTrail, 64 - prevLead - prevTrail);
+      continue;
+    }
+
+    unsigned int length = 64 - lead - trail;
+
+    writer.Write(3, 2);
+    writer.Write(lead, 5);
+    writer.Write(length - 1, 6);
+    writer.Write(x >> trail, length);
+
+    prevLead = lead;
+    prevTrail = trail;
+  }
+
+  return writer.Flush();
+}
+
+
+void RealXorDecompress(double* realVec, const char* src, unsigned int nrOfDoubles)
+{
+  unsigned long long* values = (unsigned long long*) realVec;
+  BitReader reader(src);
+
+  unsigned long long prev = reader.Read(64);
+  unsigned int lead = 0;
+  unsigned int length = 64;
+
+  values[0] = prev;
+
+  for (unsigned int i = 1; i < nrOfDoubles; ++i)
+  {
+    if (reader.Read(1) != 0)
+    {
+      if (reader.Read(1) != 0)  // new window
+      {
+        lead = (unsigned int) reader.Read(5);
+        length = (unsigned int) reader.Read(6) + 1;
+      }
+
+      prev ^= reader.Read(length) << (64 - lead - length);
+    }
+
+    values[i] = prev;
+  }
+}
+
+
+unsigned int IntRunCount(const int* intVec, unsigned int nrOfInts)
+{
+  if (nrOfInts == 0) return 0;
+
+  unsigned int nrOfBounds = 0;
+
+  for (unsigned int pos = SimdIntRunBounds(intVec, nrOfInts, nrOfBounds); pos < nrOfInts; ++pos)
+  {
+    if (intVec[pos] != intVec[pos - 1]) ++nrOfBounds;
+  }
+
+  return nrOfBounds + 1;
+}
+
+
+unsigned int IntRleEncode(char* dst, const int* intVec, unsigned int nrOfInts)
+{
+  unsigned int nrOfRuns = IntRunCount(intVec, nrOfInts);
+  unsigned int* header = (unsigned int*) dst;
+  int* runValues = (int*) &dst[RLE_HEADER_SIZE];
+  unsigned int* runLengths = (unsigned int*) &runValues[nrOfRuns];
+
+  header[0] = nrOfRuns;
+  header[1] = 0;
+
+  unsigned int run = 0;
+  unsigned int runStart = 0;
+
+  for (unsigned int pos = 1; pos <= nrOfInts; ++pos)
+  {
+    if (pos == nrOfInts || intVec[pos] != intVec[runStart])
+    {
+      runValues[run] = intVec[runStart];
+      runLengths[run++] = pos - runStart;
+      runStart = pos;
+    }
+  }
+
+  return RLE_HEADER_SIZE + 8 * nrOfRuns;
+}
+
+
+unsigned int IntRleRuns(const char* src, const int* &runValues, const unsigned int* &runLengths)
+{
+  unsigned int nrOfRuns = *((const unsigned int*) src);
+
+  runValues = (const int*) &src[RLE_HEADER_SIZE];
+  runLengths = (const unsigned int*) &runValues[nrOfRuns];
+
+  return nrOfRuns;
+}
+
+
+void IntRleDecode(int* intVec, const char* src, unsigned int nrOfInts)
+{
+  const int* runValues;
+  const unsigned int* runLengths;
+  unsigned int nrOfRuns = IntRleRuns(src, runValues, runLengths);
+
+  unsigned int runStart = 0;
+
+  for (unsigned int run = 0; run < nrOfRuns; ++run)
+  {
+    int* runVec = &intVec[runStart];
+    int value = runValues[run];
+    unsigned int length = runLengths[run];
+
+    for (unsigned int pos = SimdIntFill(runVec, length, value); pos < length; ++pos)
+    {
+      runVec[pos] = value;
+    }
+
+    runStart += length;
+  }
+}
+
+
+static const double DECIMAL_FACTORS[REAL_INT_MAX_SCALE + 1] = { 1.0, 10.0, 100.0, 1000.0, 10000.0 };
+
+// Convert doubles at a single scale, the codes are checked by converting them back
+inline bool RealToIntScale(int* intVec, const double* realVec, unsigned int nrOfDoubles, int scale)
+{
+  double factor = DECIMAL_FACTORS[scale];
+  double naValue;
+  unsigned long long naBits = REAL_NA_BITS;
+  memcpy(&naValue, &naBits, 8);
+
+  for (unsigned int pos = SimdRealToInt(realVec, intVec, nrOfDoubles, factor, naValue); pos < nrOfDoubles; ++pos)
+  {
+    double value = realVec[pos];
+
+    if (memcmp(&value, &naValue, 8) == 0)
+    {
+      intVec[pos] = INT_MIN;
+      continue;
+    }
+
+    double scaled = value * factor;
+    if (!(scaled > -2147483647.5 && scaled < 2147483647.5)) return false;  // also excludes NaN and NA_INTEGER
+
+    int code = (int) nearbyint(scaled);
+    double converted = code / factor;
+
+    if (memcmp(&converted, &value, 8) != 0) return false;  // also excludes -0.0
+
+    intVec[pos] = code;
+  }
+
+  return true;
+}
+
+
+int RealToInt(int* intVec, const double* realVec, unsigned int nrOfDoubles)
+{
+  for (int scale = 0; scale <= REAL_INT_MAX_SCALE; ++scale)
+  {
+    if (RealToIntScale(intVec, realVec, nrOfDoubles, scale)) return scale;
+  }
+
+  return -1;
+}
+
+
+void IntToReal(double* realVec, const int* intVec, unsigned int nrOfDoubles, int scale)
+{
+  double factor = DECIMAL_FACTORS[scale];
+  double naValue;
+  unsigned long long naBits = REAL_NA_BITS;
+  memcpy(&naValue, &naBits, 8);
+
+  for (unsigned int pos = SimdIntToReal(intVec, realVec, nrOfDoubles, factor, naValue); pos < nrOfDoubles; ++pos)
+  {
+    int code = intVec[pos];
+    realVec[pos] = code == INT_MIN ? naValue : code / factor;
+  }
+}
+
+
+bool LongToInt(int* intVec, const long long* longVec, unsigned int nrOfLongs, long long &offset)
+{
+  unsigned long long minValue = ULLONG_MAX;
+  unsigned long long maxValue = 0;
+
+  // Values are compared after flipping the sign bit, which maps NA to zero
+  for (unsigned int pos = 0; pos < nrOfLongs; ++pos)
+  {
+    unsigned long long value = (unsigned long long) longVec[pos] ^ 0x8000000000000000ULL;
+    if (value == 0) continue;
+
+    if (value < minValue) minValue = value;
+    if (value > maxValue) maxValue = value;
+  }
+
+  offset = 0;
+
+  // Codes range from -INT_MAX to INT_MAX, INT_MIN is reserved for NA
+  if (minValue <= maxValue)
+  {
+    if (maxValue - minValue > 0xFFFFFFFEULL) return false;
+
+    offset = (long long) ((minValue ^ 0x8000000000000000ULL) + INT_MAX);
+  }
+
+  for (unsigned int pos = 0; pos < nrOfLongs; ++pos)
+  {
+    long long value = longVec[pos];
+    intVec[pos] = value == LONG_NA_VALUE ? INT_MIN : (int) ((unsigned long long) value - (unsigned long long) offset);
+  }
+
+  return true;
+}
+
+
+void IntToLong(long long* longVec, const int* intVec, unsigned int nrOfLongs, long long offset)
+{
+  for (unsigned int pos = 0; pos < nrOfLongs; ++pos)
+  {
+    int code = intVec[pos];
+    longVec[pos] = code == INT_MIN ? LONG_NA_VALUE : (long long) ((unsigned long long) offset + code);
+  }
+}
+
+// Function pointer to compression algorithm
+typedef unsigned int (*CompAlgorithm)(char* dst, unsigned int dstCapacity, const char* src, unsigned int srcSize, int compressionLevel);
+
+
+// Function pointer to decompression algorithm
+typedef unsigned int (*DecompAlgorithm)(char* dst, unsigned int dstCapacity, const char* src, unsigned int  compressedSize);
+
+
+// Buffer for blocks larger than MAX_SIZE_COMPRESS_BLOCK, allocated once per thread
+static thread_local vector<unsigned long long> largeBlockBuffer;
+
+// Second buffer for algorithms with two compression stages
+static thread_local vector<unsigned long long> largeStageBuffer;
+
+
+// Use the stack buffer of stackSize bytes if size bytes fit in it, and the large block buffer otherwise
+inline char* BlockBuffer(void* stackBuf, unsigned int stackSize, unsigned int size,
+  vector<unsigned long long> &largeBuffer = largeBlockBuffer)
+{
+  if (size <= stackSize) return static_cast<char*>(stackBuf);
+
+  if (largeBuffer.size() * 8 < size) largeBuffer.resize((size + 7) / 8);
+
+  return reinterpret_cast<char*>(largeBuffer.data());
+}
+
+
+// UNCOMPRESS,
+
+unsigned int NoCompression(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  return 0;
+}
+
+unsigned int NoDecompression(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  return 0;
+}
+
+
+// LZ4,
+
+unsigned int LZ4_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  return LZ4_compress_fast(src, dst, srcSize, dstCapacity, 101 - compressionLevel);  // no acceleration
+}
+
+unsigned int LZ4_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  return LZ4_decompress_fast(src, dst, dstCapacity);
+}
+
+unsigned int LZ4_INT_TO_BYTE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  int nrOfLongs = 1 + (srcSize - 1) / 32;  // srcSize is processed in blocks of 32 bytes
+
+  // Compress buffer
+  char bufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* buf = BlockBuffer(bufStack, MAX_SIZE_COMPRESS_BLOCK_QUARTER, nrOfLongs * 8);
+  // char buf[nrOfLongs * 8];
+
+  CompactIntToByte(buf, src, srcSize / 4);
+  return LZ4_compress_fast(buf, dst, nrOfLongs * 8, dstCapacity, 101 - compressionLevel);  // no acceleration at compress == 100
+}
+
+unsigned int LZ4_INT_TO_BYTE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  int nrOfLongs = 1 + (dstCapacity - 1) / 32;  // srcSize is processed in blocks of 32 bytes
+  int nrOfDstInts = dstCapacity / 4;
+
+  // Compress buffer
+  char bufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* buf = BlockBuffer(bufStack, MAX_SIZE_COMPRESS_BLOCK_QUARTER, nrOfLongs * 8);
+  // char buf[nrOfLongs * 8];
+
+  // Decompress
+  LZ4_decompress_fast(src, (char*) buf, nrOfLongs * 8);
+  DecompactByteToInt(buf, dst, nrOfDstInts);  // one integer per byte
+
+  return nrOfDstInts * 4;
+}
+
+
+unsigned int ZSTD_INT_TO_BYTE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  int nrOfLongs = 1 + (srcSize - 1) / 32;  // srcSize is processed in blocks of 32 bytes
+
+  // Compress buffer
+  char bufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* buf = BlockBuffer(bufStack, MAX_SIZE_COMPRESS_BLOCK_QUARTER, nrOfLongs * 8);
+  // char buf[nrOfLongs * 8];
+
+  CompactIntToByte(buf, src, srcSize / 4);
+
+  return ZstdCompress(dst, dstCapacity, (char*) buf,  nrOfLongs * 8,  compressionLevel / 4.5);
+}
+
+unsigned int ZSTD_INT_TO_BYTE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  int nrOfLongs = 1 + (dstCapacity - 1) / 32;  // srcSize is processed in blocks of 32 bytes
+  int nrOfDstInts = dstCapacity / 4;
+
+  // Compress buffer
+  // char buf[nrOfLongs * 8];
+  char bufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* buf = BlockBuffer(bufStack, MAX_SIZE_COMPRESS_BLOCK_QUARTER, nrOfLongs * 8);
+
+  // Decompress
+  ZstdDecompress((char*) buf, 8 * nrOfLongs, src, compressedSize);
+  DecompactByteToInt(buf, dst, nrOfDstInts);  // one integer per byte
+
+  return nrOfDstInts * 4;
+}
+
+unsigned int LZ4_INT_TO_SHORT_SHUF2_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  int nrOfLongs = 1 + (srcSize - 1) / 16;  // srcSize is processed in blocks of 16 bytes
+
+  // Compress buffer
+  // char buf[nrOfLongs * 8];
+  char bufStack[MAX_SIZE_COMPRESS_BLOCK_HALF];
+  char* buf = BlockBuffer(bufStack, MAX_SIZE_COMPRESS_BLOCK_HALF, nrOfLongs * 8);
+
+  CompactIntToShort(buf, src, srcSize / 4);  // expecting a integer vector here
+  return LZ4_compress_fast(buf, dst, nrOfLongs * 8, dstCapacity, 100 - compressionLevel);  // no acceleration at compress == 100
+}
+
+unsigned int LZ4_INT_TO_SHORT_SHUF2_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  int nrOfLongs = 1 + (dstCapacity - 1) / 16;  // srcSize is processed in blocks of 32 bytes
+  int nrOfDstInts = dstCapacity / 4;
+
+  // Compress buffer
+  // char buf[nrOfLongs * 8];
+  char bufStack[MAX_SIZE_COMPRESS_BLOCK_HALF];
+  char* buf = BlockBuffer(bufStack, MAX_SIZE_COMPRESS_BLOCK_HALF, nrOfLongs * 8);
+
+  // Decompress
+  LZ4_decompress_fast(src, (char*) buf, nrOfLongs * 8);
+  DecompactShortToInt(buf, dst, nrOfDstInts);  // one integer per byte
+
+  return nrOfDstInts * 4;
+}
+
+// Factor algorithms
+
+unsigned int INT_TO_BYTE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  unsigned int nrOfLongs = 1 + (srcSize - 1) / 32;  // srcSize is processed in blocks of 32 bytes
+
+  CompactIntToByte(dst, src, srcSize / 4);
+
+  return 8 * nrOfLongs;
+}
+
+unsigned int INT_TO_BYTE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  DecompactByteToInt(src, dst, dstCapacity / 4);  // one integer per byte
+
+  return dstCapacity / 4;
+}
+
+unsigned int INT_TO_SHORT_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  int nrOfLongs = 1 + (srcSize - 1) / 16;  // srcSize is processed in blocks of 32 bytes
+
+  CompactIntToShort(dst, src, srcSize / 4);
+
+  return 8 * nrOfLongs;
+}
+
+unsigned int INT_TO_SHORT_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  DecompactShortToInt(src, dst, dstCapacity / 4);  // one integer per short
+
+  return dstCapacity / 4;
+}
+
+// LOGIC64
+
+unsigned int LOGIC64_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  int nrOfLogicals = srcSize / 4;  // srcSize must be a multiple of 4
+  int nrOfLongs = 1 + (nrOfLogicals - 1) / 32;
+
+  LogicCompr64(src, (unsigned long long*) dst, nrOfLogicals);
+  return 8 * nrOfLongs;
+}
+
+unsigned int LOGIC64_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  int nrOfLogicals = dstCapacity / 4;  // dstCapacity must be a multiple of 4
+
+  LogicDecompr64(dst, (unsigned long long*) src, nrOfLogicals, 0);
+
+  return (unsigned int) nrOfLogicals * 4;
+}
+
+
+// LZ4_LOGIC64
+
+// Buffer src should contain an integer vector (with logicals)
+// srcSize must be a multiple of 4
+unsigned int LZ4_LOGIC64_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  // Create compression buffer
+  int nrOfLogicals = srcSize / 4;
+  int nrOfLongs = 1 + (nrOfLogicals - 1) / 32;
+
+  // Compress buffer
+  // unsigned long long buf[nrOfLongs];
+  unsigned long long bufStack[MAX_SIZE_COMPRESS_BLOCK_128];
+  unsigned long long* buf = (unsigned long long*) BlockBuffer(bufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_128, nrOfLongs * 8);
+
+  LogicCompr64(src, buf, nrOfLogicals);
+  return LZ4_compress_fast((char*) buf, dst, nrOfLongs * 8, dstCapacity, 100 - compressionLevel);  // no acceleration at compress == 100
+}
+
+unsigned int LZ4_LOGIC64_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  int nrOfLogicals = dstCapacity / 4;
+  int nrOfLongs = 1 + (nrOfLogicals - 1) / 32;
+
+  // Compress buffer
+  // unsigned long long buf[nrOfLongs];
+  unsigned long long bufStack[MAX_SIZE_COMPRESS_BLOCK_128];
+  unsigned long long* buf = (unsigned long long*) BlockBuffer(bufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_128, nrOfLongs * 8);
+
+  // Decompress
+  int size = LZ4_decompress_fast(src, (char*) buf, 8 * nrOfLongs);
+  LogicDecompr64(dst, (unsigned long long*) buf, nrOfLogicals, 0);
+
+  return size;
+}
+
+
+// ZSTD_LOGIC64
+
+// Buffer src should contain an integer vector (with logicals)
+// srcSize must be a multiple of 4
+unsigned int ZSTD_LOGIC64_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  // Create compression buffer
+  int nrOfLogicals = srcSize / 4;
+  int nrOfLongs = 1 + (nrOfLogicals - 1) / 32;
+
+  // Compress buffer
+  // unsigned long long buf[nrOfLongs];
+  unsigned long long bufStack[MAX_SIZE_COMPRESS_BLOCK_128];
+  unsigned long long* buf = (unsigned long long*) BlockBuffer(bufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_128, nrOfLongs * 8);
+
+  LogicCompr64(src, buf, nrOfLogicals);
+
+  return ZstdCompress(dst, dstCapacity, (char*) buf,  nrOfLongs * 8,  compressionLevel / 4.5);
+}
+
+unsigned int ZSTD_LOGIC64_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  int nrOfLogicals = dstCapacity / 4;
+  int nrOfLongs = 1 + (nrOfLogicals - 1) / 32;
+
+    // Compress buffer
+  // unsigned long long buf[nrOfLongs];
+  unsigned long long bufStack[MAX_SIZE_COMPRESS_BLOCK_128];
+  unsigned long long* buf = (unsigned long long*) BlockBuffer(bufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_128, nrOfLongs * 8);
+
+  // Decompress
+  int size = ZstdDecompress((char*) buf, 8 * nrOfLongs, src, compressedSize);
+  LogicDecompr64(dst, (unsigned long long*) buf, nrOfLogicals, 0);
+
+  return size;
+}
+
+
+// LZ4_SHUF4,
+
+// Buffer src should contain an integer vector
+// srcSize must be a multiple of 4
+unsigned int LZ4_C_SHUF4(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  int intSize = srcSize / 4;
+
+  unsigned long long shuffleBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  unsigned long long* shuffleBuf = (unsigned long long*) BlockBuffer(shuffleBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, srcSize);
+  // int shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+
+  ShuffleInt2((int*) src, (int*) shuffleBuf, intSize);
+  return LZ4_compress_fast((char*) shuffleBuf, dst, srcSize, dstCapacity, 100 - compressionLevel);  // large acceleration
+}
+
+unsigned int LZ4_D_SHUF4(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  int intSize = dstCapacity / 4;
+
+  unsigned long long shuffleBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  unsigned long long* shuffleBuf = (unsigned long long*) BlockBuffer(shuffleBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, dstCapacity);
+  // int shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+
+  int size = LZ4_decompress_fast(src, (char*) shuffleBuf, dstCapacity);
+  DeshuffleInt2((int*) shuffleBuf, (int*) dst, intSize);
+
+  return size;
+}
+
+
+// LZ4_SHUF8,
 
 // Buffer src should contain an integer vector
 // srcSize must be a multiple of 8
 unsigned int LZ4_C_SHUF8(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
 {
-  int doubleSize = srcSize / 8;
+  int doubleSize = srcSize / 8;
+
+  // double shuffleBuf[doubleSize];
+  double shuffleBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  double* shuffleBuf = (double*) BlockBuffer(shuffleBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, srcSize);
+
+  ShuffleReal((double*) src, shuffleBuf, doubleSize);
+  return LZ4_compress_fast((char*) shuffleBuf, dst, srcSize, dstCapacity, 100 - compressionLevel);  // large acceleration
+}
+
+unsigned int LZ4_D_SHUF8(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  int doubleSize = dstCapacity / 8;
+
+  // double shuffleBuf[doubleSize];
+  double shuffleBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  double* shuffleBuf = (double*) BlockBuffer(shuffleBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, dstCapacity);
+
+  int size = LZ4_decompress_fast(src, (char*) shuffleBuf, dstCapacity);
+  DeshuffleReal(shuffleBuf, (double*) dst, doubleSize);
+
+  return size;
+}
+
+
+// LZ4HC, LZ4HC_SHUF4 and LZ4HC_SHUF8
+
+unsigned int LZ4HC_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  return LZ4ChainCompress(src, dst, srcSize, dstCapacity, compressionLevel);
+}
+
+unsigned int LZ4HC_C_SHUF4(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  int intSize = srcSize / 4;
+
+  unsigned long long shuffleBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  unsigned long long* shuffleBuf = (unsigned long long*) BlockBuffer(shuffleBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, srcSize);
+
+  ShuffleInt2((int*) src, (int*) shuffleBuf, intSize);
+  return LZ4ChainCompress((char*) shuffleBuf, dst, srcSize, dstCapacity, compressionLevel);
+}
+
+unsigned int LZ4HC_C_SHUF8(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  int doubleSize = srcSize / 8;
+
+  double shuffleBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  double* shuffleBuf = (double*) BlockBuffer(shuffleBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, srcSize);
+
+  ShuffleReal((double*) src, shuffleBuf, doubleSize);
+  return LZ4ChainCompress((char*) shuffleBuf, dst, srcSize, dstCapacity, compressionLevel);
+}
+
+
+// ZSTD_SHUF8
+
+unsigned int ZSTD_C_SHUF8(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  int doubleSize = srcSize / 8;
+
+  // double shuffleBuf[doubleSize];
+  double shuffleBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  double* shuffleBuf = (double*) BlockBuffer(shuffleBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, srcSize);
+
+  ShuffleReal((double*) src, shuffleBuf, doubleSize);
+  return ZstdCompress(dst, dstCapacity, (char*) shuffleBuf, srcSize, compressionLevel / 4.5);
+}
+
+unsigned int ZSTD_D_SHUF8(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  int doubleSize = dstCapacity / 8;
+
+  // double shuffleBuf[doubleSize];
+  double shuffleBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  double* shuffleBuf = (double*) BlockBuffer(shuffleBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, dstCapacity);
+
+  int size = ZstdDecompress((char*) shuffleBuf, dstCapacity, src, compressedSize);
+  DeshuffleReal(shuffleBuf, (double*) dst, doubleSize);
+
+  return size;
+}
+
+
+// ZSTD,
+
+unsigned int ZSTD_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  return ZstdCompress(dst, dstCapacity, src,  srcSize,  compressionLevel / 4.5);
+}
+
+unsigned int ZSTD_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  return ZstdDecompress(dst, dstCapacity, src, compressedSize);
+}
+
+
+// ZSTD_SHUF4,
+
+unsigned int ZSTD_C_SHUF4(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  int intSize = srcSize / 4;
+
+  unsigned long long shuffleBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  unsigned long long* shuffleBuf = (unsigned long long*) BlockBuffer(shuffleBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, srcSize);
+  // int shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+
+  ShuffleInt2((int*) src, (int*) shuffleBuf, intSize);
+  return ZstdCompress(dst, dstCapacity, (char*) shuffleBuf, srcSize, compressionLevel / 4.5);
+}
+
+unsigned int ZSTD_D_SHUF4(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  int intSize = dstCapacity / 4;
+
+  unsigned long long shuffleBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  unsigned long long* shuffleBuf = (unsigned long long*) BlockBuffer(shuffleBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, dstCapacity);
+  // int shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+
+  int size = ZstdDecompress((char*) shuffleBuf, dstCapacity, src, compressedSize);
+  DeshuffleInt2((int*) shuffleBuf, (int*) dst, intSize);
+
+  return size;
+}
+
+
+// INT_BITPACK, LZ4_INT_BITPACK and ZSTD_INT_BITPACK
+
+// A block starts with a header of BITPACK_HEADER_SIZE bytes: the frame of reference base (4 bytes), the bit width of
+// the codes (1 byte), the NA flag (1 byte) and 2 unused bytes. The header is followed by the packed codes, which are
+// optionally compressed by LZ4 or ZSTD.
+
+inline unsigned int IntBitPackBlock(char* header, char* packed, const char* src, unsigned int srcSize)
+{
+  unsigned int nrOfInts = srcSize / 4;
+  int base;
+  bool hasNA;
+
+  unsigned int bitWidth = IntBitPackWidth((const int*) src, nrOfInts, base, hasNA);
+
+  memcpy(header, &base, 4);
+  header[4] = (char) bitWidth;
+  header[5] = hasNA ? 1 : 0;
+  header[6] = 0;
+  header[7] = 0;
+
+  IntBitPack(packed, (const int*) src, nrOfInts, base, bitWidth, hasNA);
+
+  return IntBitPackSize(nrOfInts, bitWidth);
+}
+
+inline unsigned int IntBitPackedSize(const char* header, unsigned int dstCapacity)
+{
+  return IntBitPackSize(dstCapacity / 4, (unsigned char) header[4]);
+}
+
+inline void IntBitUnpackBlock(char* dst, unsigned int dstCapacity, const char* header, const char* packed)
+{
+  int base;
+  memcpy(&base, header, 4);
+
+  IntBitUnpack((int*) dst, packed, dstCapacity / 4, base, (unsigned char) header[4], header[5] != 0);
+}
+
+
+unsigned int INT_BITPACK_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  return BITPACK_HEADER_SIZE + IntBitPackBlock(dst, &dst[BITPACK_HEADER_SIZE], src, srcSize);
+}
+
+unsigned int INT_BITPACK_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  IntBitUnpackBlock(dst, dstCapacity, src, &src[BITPACK_HEADER_SIZE]);
+
+  return dstCapacity;
+}
+
+
+unsigned int LZ4_INT_BITPACK_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, srcSize);  // packed size <= srcSize
+
+  unsigned int packedSize = IntBitPackBlock(dst, packBuf, src, srcSize);
+  if (packedSize == 0) return BITPACK_HEADER_SIZE;  // constant block
+
+  return BITPACK_HEADER_SIZE + LZ4_compress_fast(packBuf, &dst[BITPACK_HEADER_SIZE], packedSize,
+    dstCapacity - BITPACK_HEADER_SIZE, 100 - compressionLevel);
+}
+
+unsigned int LZ4_INT_BITPACK_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, dstCapacity);
+
+  unsigned int packedSize = IntBitPackedSize(src, dstCapacity);
+  if (packedSize > 0) LZ4_decompress_fast(&src[BITPACK_HEADER_SIZE], packBuf, packedSize);
+
+  IntBitUnpackBlock(dst, dstCapacity, src, packBuf);
+
+  return dstCapacity;
+}
+
+
+unsigned int ZSTD_INT_BITPACK_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, srcSize);
+
+  unsigned int packedSize = IntBitPackBlock(dst, packBuf, src, srcSize);
+  if (packedSize == 0) return BITPACK_HEADER_SIZE;
+
+  return BITPACK_HEADER_SIZE + ZstdCompress(&dst[BITPACK_HEADER_SIZE], dstCapacity - BITPACK_HEADER_SIZE, packBuf,
+    packedSize, compressionLevel / 4.5);
+}
+
+unsigned int ZSTD_INT_BITPACK_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, dstCapacity);
+
+  unsigned int packedSize = IntBitPackedSize(src, dstCapacity);
+  if (packedSize > 0)
+  {
+    ZstdDecompress(packBuf, packedSize, &src[BITPACK_HEADER_SIZE], compressedSize - BITPACK_HEADER_SIZE);
+  }
+
+  IntBitUnpackBlock(dst, dstCapacity, src, packBuf);
+
+  return dstCapacity;
+}
+
+
+// INT_DELTA, LZ4_INT_DELTA, REAL_DELTA and LZ4_REAL_DELTA
+
+// A block starts with a header of DELTA_HEADER_SIZE bytes: the first value (8 bytes), the first delta (4 bytes), the
+// bit width of the codes (1 byte), the order of the differences (1 byte) and 2 unused bytes. The header is followed
+// by the bit-packed codes, which are optionally compressed by LZ4.
+
+inline void WriteDeltaHeader(char* header, long long base, int firstDelta, unsigned int bitWidth, int order)
+{
+  memcpy(header, &base, 8);
+  memcpy(&header[8], &firstDelta, 4);
+  header[12] = (char) bitWidth;
+  header[13] = (char) order;
+  header[14] = 0;
+  header[15] = 0;
+}
 
-  // double shuffleBuf[doubleSize];
-  double shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_8];
+inline void ReadDeltaHeader(const char* header, long long &base, int &firstDelta, unsigned int &bitWidth, int &order)
+{
+  memcpy(&base, header, 8);
+  memcpy(&firstDelta, &header[8], 4);
+  bitWidth = (unsigned char) header[12];
+  order = header[13];
+}
 
-  ShuffleReal((double*) src, shuffleBuf, doubleSize);
-  return LZ4_compress_fast((char*) shuffleBuf, dst, srcSize, dstCapacity, 100 - compressionLevel);  // large acceleration
+// Delta encode and bit pack an integer block, returns the packed size
+inline unsigned int IntDeltaBlock(char* header, char* packed, const char* src, unsigned int srcSize)
+{
+  const int* intVec = (const int*) src;
+  unsigned int nrOfInts = srcSize / 4;
+  int order;
+  bool isSorted;
+
+  unsigned int bitWidth = IntDeltaWidth(intVec, nrOfInts, order, isSorted);
+  int firstDelta = nrOfInts > 1 ? (int) ((unsigned int) intVec[1] - (unsigned int) intVec[0]) : 0;
+  WriteDeltaHeader(header, intVec[0], firstDelta, bitWidth, order);
+
+  unsigned long long codeBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  unsigned int* codes = (unsigned int*) BlockBuffer(codeBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, srcSize,
+    largeStageBuffer);
+
+  IntDeltaEncode(codes, intVec, nrOfInts, order);
+  IntBitPack(packed, (const int*) codes, nrOfInts, 0, bitWidth, false);
+
+  return IntBitPackSize(nrOfInts, bitWidth);
 }
 
-unsigned int LZ4_D_SHUF8(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+// Delta encode and bit pack a block of integer valued doubles, returns false if the block can't be delta encoded
+inline bool RealDeltaBlock(char* header, char* packed, const char* src, unsigned int srcSize, unsigned int &packedSize)
 {
-  int doubleSize = dstCapacity / 8;
+  const double* realVec = (const double*) src;
+  unsigned int nrOfDoubles = srcSize / 8;
+  int order;
+  bool isSorted;
 
-  // double shuffleBuf[doubleSize];
-  double shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_8];
+  unsigned int bitWidth = RealDeltaWidth(realVec, nrOfDoubles, order, isSorted);
+  if (bitWidth > 32) return false;
 
-  int size = LZ4_decompress_fast(src, (char*) shuffleBuf, dstCapacity);
-  DeshuffleReal(shuffleBuf, (double*) dst, doubleSize);
+  int firstDelta = order == 2 ? (int) ((long long) realVec[1] - (long long) realVec[0]) : 0;
+  WriteDeltaHeader(header, (long long) realVec[0], firstDelta, bitWidth, order);
 
-  return size;
+  unsigned long long codeBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  unsigned int* codes = (unsigned int*) BlockBuffer(codeBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, srcSize / 2,
+    largeStageBuffer);
+
+  RealDeltaEncode(codes, realVec, nrOfDoubles, order);
+  IntBitPack(packed, (const int*) codes, nrOfDoubles, 0, bitWidth, false);
+  packedSize = IntBitPackSize(nrOfDoubles, bitWidth);
+
+  return true;
 }
 
 
-// ZSTD_SHUF8
+unsigned int INT_DELTA_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  return DELTA_HEADER_SIZE + IntDeltaBlock(dst, &dst[DELTA_HEADER_SIZE], src, srcSize);
+}
 
-unsigned int ZSTD_C_SHUF8(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+unsigned int INT_DELTA_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
 {
-  int doubleSize = srcSize / 8;
+  unsigned int nrOfInts = dstCapacity / 4;
+  long long base;
+  int firstDelta, order;
+  unsigned int bitWidth;
 
-  // double shuffleBuf[doubleSize];
-  double shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_8];
+  ReadDeltaHeader(src, base, firstDelta, bitWidth, order);
 
-  ShuffleReal((double*) src, shuffleBuf, doubleSize);
-  return ZSTD_compress(dst, dstCapacity, (char*) shuffleBuf, srcSize, compressionLevel / 4.5);
+  // codes are unpacked in the destination and decoded in place
+  IntBitUnpack((int*) dst, &src[DELTA_HEADER_SIZE], nrOfInts, 0, bitWidth, false);
+  IntDeltaDecode((int*) dst, nrOfInts, (int) base, firstDelta, order);
+
+  return dstCapacity;
 }
 
-unsigned int ZSTD_D_SHUF8(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+
+unsigned int LZ4_INT_DELTA_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
 {
-  int doubleSize = dstCapacity / 8;
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, srcSize);
 
-  // double shuffleBuf[doubleSize];
-  double shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_8];
+  unsigned int packedSize = IntDeltaBlock(dst, packBuf, src, srcSize);
+  if (packedSize == 0) return DELTA_HEADER_SIZE;  // constant differences
 
-  int size = ZSTD_decompress((char*) shuffleBuf, dstCapacity, src, compressedSize);
-  DeshuffleReal(shuffleBuf, (double*) dst, doubleSize);
+  return DELTA_HEADER_SIZE + LZ4_compress_fast(packBuf, &dst[DELTA_HEADER_SIZE], packedSize,
+    dstCapacity - DELTA_HEADER_SIZE, 100 - compressionLevel);
+}
 
-  return size;
+unsigned int LZ4_INT_DELTA_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  unsigned int nrOfInts = dstCapacity / 4;
+  long long base;
+  int firstDelta, order;
+  unsigned int bitWidth;
+
+  ReadDeltaHeader(src, base, firstDelta, bitWidth, order);
+
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_8];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_8, dstCapacity);
+
+  unsigned int packedSize = IntBitPackSize(nrOfInts, bitWidth);
+  if (packedSize > 0) LZ4_decompress_fast(&src[DELTA_HEADER_SIZE], packBuf, packedSize);
+
+  IntBitUnpack((int*) dst, packBuf, nrOfInts, 0, bitWidth, false);
+  IntDeltaDecode((int*) dst, nrOfInts, (int) base, firstDelta, order);
+
+  return dstCapacity;
 }
 
 
-// ZSTD,
+unsigned int REAL_DELTA_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  unsigned int packedSize;
+  if (!RealDeltaBlock(dst, &dst[DELTA_HEADER_SIZE], src, srcSize, packedSize)) return 0;  // not delta encoded
 
-unsigned int ZSTD_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+  return DELTA_HEADER_SIZE + packedSize;
+}
+
+unsigned int REAL_DELTA_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
 {
-  return ZSTD_compress(dst, dstCapacity, src,  srcSize,  compressionLevel / 4.5);
+  unsigned int nrOfDoubles = dstCapacity / 8;
+  long long base;
+  int firstDelta, order;
+  unsigned int bitWidth;
+
+  ReadDeltaHeader(src, base, firstDelta, bitWidth, order);
+
+  unsigned long long codeBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  unsigned int* codes = (unsigned int*) BlockBuffer(codeBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER,
+    dstCapacity / 2);
+
+  IntBitUnpack((int*) codes, &src[DELTA_HEADER_SIZE], nrOfDoubles, 0, bitWidth, false);
+  RealDeltaDecode((double*) dst, codes, nrOfDoubles, base, firstDelta, order);
+
+  return dstCapacity;
 }
 
-unsigned int ZSTD_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+
+unsigned int LZ4_REAL_DELTA_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
 {
-  return ZSTD_decompress(dst, dstCapacity, src, compressedSize);
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, srcSize / 2);
+
+  unsigned int packedSize;
+  if (!RealDeltaBlock(dst, packBuf, src, srcSize, packedSize)) return 0;  // not delta encoded
+  if (packedSize == 0) return DELTA_HEADER_SIZE;  // constant differences
+
+  return DELTA_HEADER_SIZE + LZ4_compress_fast(packBuf, &dst[DELTA_HEADER_SIZE], packedSize,
+    dstCapacity - DELTA_HEADER_SIZE, 100 - compressionLevel);
 }
 
+unsigned int LZ4_REAL_DELTA_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  unsigned int nrOfDoubles = dstCapacity / 8;
+  long long base;
+  int firstDelta, order;
+  unsigned int bitWidth;
 
-// ZSTD_SHUF4,
+  ReadDeltaHeader(src, base, firstDelta, bitWidth, order);
 
-unsigned int ZSTD_C_SHUF4(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+  // The packed codes and the unpacked codes use separate buffers
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, dstCapacity / 2, largeStageBuffer);
+
+  unsigned long long codeBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  unsigned int* codes = (unsigned int*) BlockBuffer(codeBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER,
+    dstCapacity / 2);
+
+  unsigned int packedSize = IntBitPackSize(nrOfDoubles, bitWidth);
+  if (packedSize > 0) LZ4_decompress_fast(&src[DELTA_HEADER_SIZE], packBuf, packedSize);
+
+  IntBitUnpack((int*) codes, packBuf, nrOfDoubles, 0, bitWidth, false);
+  RealDeltaDecode((double*) dst, codes, nrOfDoubles, base, firstDelta, order);
+
+  return dstCapacity;
+}
+
+
+// REAL_XOR
+
+unsigned int REAL_XOR_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
 {
-  int intSize = srcSize / 4;
+  return RealXorCompress(dst, (const double*) src, srcSize / 8);
+}
 
-  unsigned long long shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_8];
-  // int shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+unsigned int REAL_XOR_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  RealXorDecompress((double*) dst, src, dstCapacity / 8);
 
-  ShuffleInt2((int*) src, (int*) shuffleBuf, intSize);
-  return ZSTD_compress(dst, dstCapacity, (char*) shuffleBuf, srcSize, compressionLevel / 4.5);
+  return dstCapacity;
 }
 
-unsigned int ZSTD_D_SHUF4(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+
+// INT_RLE
+
+unsigned int INT_RLE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
 {
-  int intSize = dstCapacity / 4;
+  return IntRleEncode(dst, (const int*) src, srcSize / 4);
+}
 
-  unsigned long long shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_8];
-  // int shuffleBuf[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+unsigned int INT_RLE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  IntRleDecode((int*) dst, src, dstCapacity / 4);
 
-  int size = ZSTD_decompress((char*) shuffleBuf, dstCapacity, src, compressedSize);
-  DeshuffleInt2((int*) shuffleBuf, (int*) dst, intSize);
+  return dstCapacity;
+}
 
-  return size;
+
+// REAL_INT, LZ4_REAL_INT and ZSTD_REAL_INT
+
+// The integer codes of the doubles are stored as an INT_BITPACK block, byte 6 of the header holds the decimal
+// scale. The bit-packed codes are optionally compressed by LZ4 or ZSTD.
+
+// Convert and bit pack a block of doubles, returns false if the doubles can't be converted
+inline bool RealIntBlock(char* header, char* packed, const char* src, unsigned int srcSize, unsigned int &packedSize)
+{
+  unsigned long long codeBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* codes = BlockBuffer(codeBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, srcSize / 2, largeStageBuffer);
+
+  int scale = RealToInt((int*) codes, (const double*) src, srcSize / 8);
+  if (scale < 0) return false;
+
+  packedSize = IntBitPackBlock(header, packed, codes, srcSize / 2);
+  header[6] = (char) scale;
+
+  return true;
+}
+
+inline void RealIntUnpackBlock(char* dst, unsigned int dstCapacity, const char* header, const char* packed)
+{
+  // codes are unpacked in the upper half of the destination and converted in place
+  char* codes = &dst[dstCapacity / 2];
+
+  IntBitUnpackBlock(codes, dstCapacity / 2, header, packed);
+  IntToReal((double*) dst, (const int*) codes, dstCapacity / 8, header[6]);
+}
+
+
+unsigned int REAL_INT_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  unsigned int packedSize;
+  if (!RealIntBlock(dst, &dst[BITPACK_HEADER_SIZE], src, srcSize, packedSize)) return 0;  // not converted
+
+  return BITPACK_HEADER_SIZE + packedSize;
+}
+
+unsigned int REAL_INT_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  RealIntUnpackBlock(dst, dstCapacity, src, &src[BITPACK_HEADER_SIZE]);
+
+  return dstCapacity;
+}
+
+
+unsigned int LZ4_REAL_INT_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, srcSize / 2);
+
+  unsigned int packedSize;
+  if (!RealIntBlock(dst, packBuf, src, srcSize, packedSize)) return 0;  // not converted
+  if (packedSize == 0) return BITPACK_HEADER_SIZE;  // constant block
+
+  return BITPACK_HEADER_SIZE + LZ4_compress_fast(packBuf, &dst[BITPACK_HEADER_SIZE], packedSize,
+    dstCapacity - BITPACK_HEADER_SIZE, 100 - compressionLevel);
+}
+
+unsigned int LZ4_REAL_INT_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, dstCapacity / 2);
+
+  unsigned int packedSize = IntBitPackedSize(src, dstCapacity / 2);
+  if (packedSize > 0) LZ4_decompress_fast(&src[BITPACK_HEADER_SIZE], packBuf, packedSize);
+
+  RealIntUnpackBlock(dst, dstCapacity, src, packBuf);
+
+  return dstCapacity;
+}
+
+
+unsigned int ZSTD_REAL_INT_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, srcSize / 2);
+
+  unsigned int packedSize;
+  if (!RealIntBlock(dst, packBuf, src, srcSize, packedSize)) return 0;  // not converted
+  if (packedSize == 0) return BITPACK_HEADER_SIZE;
+
+  return BITPACK_HEADER_SIZE + ZstdCompress(&dst[BITPACK_HEADER_SIZE], dstCapacity - BITPACK_HEADER_SIZE, packBuf,
+    packedSize, compressionLevel / 4.5);
+}
+
+unsigned int ZSTD_REAL_INT_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, dstCapacity / 2);
+
+  unsigned int packedSize = IntBitPackedSize(src, dstCapacity / 2);
+  if (packedSize > 0)
+  {
+    ZstdDecompress(packBuf, packedSize, &src[BITPACK_HEADER_SIZE], compressedSize - BITPACK_HEADER_SIZE);
+  }
+
+  RealIntUnpackBlock(dst, dstCapacity, src, packBuf);
+
+  return dstCapacity;
+}
+
+
+// LONG_BITPACK, LZ4_LONG_BITPACK and ZSTD_LONG_BITPACK
+
+// A block starts with the offset of the integer codes (LONG_HEADER_SIZE bytes), followed by the codes as an
+// INT_BITPACK block. The bit-packed codes are optionally compressed by LZ4 or ZSTD.
+
+#define LONG_BITPACK_HEADER_SIZE (LONG_HEADER_SIZE + BITPACK_HEADER_SIZE)
+
+// Convert and bit pack a block of 64-bit integers, returns false if the range of the values is too wide
+inline bool LongBitPackBlock(char* header, char* packed, const char* src, unsigned int srcSize,
+  unsigned int &packedSize)
+{
+  unsigned long long codeBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* codes = BlockBuffer(codeBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, srcSize / 2, largeStageBuffer);
+
+  long long offset;
+  if (!LongToInt((int*) codes, (const long long*) src, srcSize / 8, offset)) return false;
+
+  memcpy(header, &offset, LONG_HEADER_SIZE);
+  packedSize = IntBitPackBlock(&header[LONG_HEADER_SIZE], packed, codes, srcSize / 2);
+
+  return true;
+}
+
+inline void LongBitUnpackBlock(char* dst, unsigned int dstCapacity, const char* header, const char* packed)
+{
+  long long offset;
+  memcpy(&offset, header, LONG_HEADER_SIZE);
+
+  // codes are unpacked in the upper half of the destination and converted in place
+  char* codes = &dst[dstCapacity / 2];
+
+  IntBitUnpackBlock(codes, dstCapacity / 2, &header[LONG_HEADER_SIZE], packed);
+  IntToLong((long long*) dst, (const int*) codes, dstCapacity / 8, offset);
+}
+
+
+unsigned int LONG_BITPACK_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  unsigned int packedSize;
+  if (!LongBitPackBlock(dst, &dst[LONG_BITPACK_HEADER_SIZE], src, srcSize, packedSize)) return 0;  // wide range
+
+  return LONG_BITPACK_HEADER_SIZE + packedSize;
+}
+
+unsigned int LONG_BITPACK_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  LongBitUnpackBlock(dst, dstCapacity, src, &src[LONG_BITPACK_HEADER_SIZE]);
+
+  return dstCapacity;
+}
+
+
+unsigned int LZ4_LONG_BITPACK_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, srcSize / 2);
+
+  unsigned int packedSize;
+  if (!LongBitPackBlock(dst, packBuf, src, srcSize, packedSize)) return 0;  // wide range
+  if (packedSize == 0) return LONG_BITPACK_HEADER_SIZE;  // constant block
+
+  return LONG_BITPACK_HEADER_SIZE + LZ4_compress_fast(packBuf, &dst[LONG_BITPACK_HEADER_SIZE], packedSize,
+    dstCapacity - LONG_BITPACK_HEADER_SIZE, 100 - compressionLevel);
+}
+
+unsigned int LZ4_LONG_BITPACK_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, dstCapacity / 2);
+
+  unsigned int packedSize = IntBitPackedSize(&src[LONG_HEADER_SIZE], dstCapacity / 2);
+  if (packedSize > 0) LZ4_decompress_fast(&src[LONG_BITPACK_HEADER_SIZE], packBuf, packedSize);
+
+  LongBitUnpackBlock(dst, dstCapacity, src, packBuf);
+
+  return dstCapacity;
+}
+
+
+unsigned int ZSTD_LONG_BITPACK_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, srcSize / 2);
+
+  unsigned int packedSize;
+  if (!LongBitPackBlock(dst, packBuf, src, srcSize, packedSize)) return 0;  // wide range
+  if (packedSize == 0) return LONG_BITPACK_HEADER_SIZE;
+
+  return LONG_BITPACK_HEADER_SIZE + ZstdCompress(&dst[LONG_BITPACK_HEADER_SIZE],
+    dstCapacity - LONG_BITPACK_HEADER_SIZE, packBuf, packedSize, compressionLevel / 4.5);
+}
+
+unsigned int ZSTD_LONG_BITPACK_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, dstCapacity / 2);
+
+  unsigned int packedSize = IntBitPackedSize(&src[LONG_HEADER_SIZE], dstCapacity / 2);
+  if (packedSize > 0)
+  {
+    ZstdDecompress(packBuf, packedSize, &src[LONG_BITPACK_HEADER_SIZE], compressedSize - LONG_BITPACK_HEADER_SIZE);
+  }
+
+  LongBitUnpackBlock(dst, dstCapacity, src, packBuf);
+
+  return dstCapacity;
+}
+
+
+// LONG_DELTA and LZ4_LONG_DELTA, blocks have the same layout as INT_DELTA and LZ4_INT_DELTA blocks
+
+// Delta encode and bit pack a block of 64-bit integers, returns false if the block can't be delta encoded
+inline bool LongDeltaBlock(char* header, char* packed, const char* src, unsigned int srcSize, unsigned int &packedSize)
+{
+  const long long* longVec = (const long long*) src;
+  unsigned int nrOfLongs = srcSize / 8;
+  int order;
+  bool isSorted;
+
+  unsigned int bitWidth = LongDeltaWidth(longVec, nrOfLongs, order, isSorted);
+  if (bitWidth > 32) return false;
+
+  int firstDelta = order == 2 ? (int) ((unsigned long long) longVec[1] - (unsigned long long) longVec[0]) : 0;
+  WriteDeltaHeader(header, longVec[0], firstDelta, bitWidth, order);
+
+  unsigned long long codeBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  unsigned int* codes = (unsigned int*) BlockBuffer(codeBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, srcSize / 2,
+    largeStageBuffer);
+
+  LongDeltaEncode(codes, longVec, nrOfLongs, order);
+  IntBitPack(packed, (const int*) codes, nrOfLongs, 0, bitWidth, false);
+  packedSize = IntBitPackSize(nrOfLongs, bitWidth);
+
+  return true;
 }
 
 
+unsigned int LONG_DELTA_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  unsigned int packedSize;
+  if (!LongDeltaBlock(dst, &dst[DELTA_HEADER_SIZE], src, srcSize, packedSize)) return 0;  // not delta encoded
+
+  return DELTA_HEADER_SIZE + packedSize;
+}
+
+unsigned int LONG_DELTA_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  unsigned int nrOfLongs = dstCapacity / 8;
+  long long base;
+  int firstDelta, order;
+  unsigned int bitWidth;
+
+  ReadDeltaHeader(src, base, firstDelta, bitWidth, order);
+
+  unsigned long long codeBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  unsigned int* codes = (unsigned int*) BlockBuffer(codeBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER,
+    dstCapacity / 2);
+
+  IntBitUnpack((int*) codes, &src[DELTA_HEADER_SIZE], nrOfLongs, 0, bitWidth, false);
+  LongDeltaDecode((long long*) dst, codes, nrOfLongs, base, firstDelta, order);
+
+  return dstCapacity;
+}
+
+
+unsigned int LZ4_LONG_DELTA_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, srcSize / 2);
+
+  unsigned int packedSize;
+  if (!LongDeltaBlock(dst, packBuf, src, srcSize, packedSize)) return 0;  // not delta encoded
+  if (packedSize == 0) return DELTA_HEADER_SIZE;  // constant differences
+
+  return DELTA_HEADER_SIZE + LZ4_compress_fast(packBuf, &dst[DELTA_HEADER_SIZE], packedSize,
+    dstCapacity - DELTA_HEADER_SIZE, 100 - compressionLevel);
+}
+
+unsigned int LZ4_LONG_DELTA_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  unsigned int nrOfLongs = dstCapacity / 8;
+  long long base;
+  int firstDelta, order;
+  unsigned int bitWidth;
+
+  ReadDeltaHeader(src, base, firstDelta, bitWidth, order);
+
+  // The packed codes and the unpacked codes use separate buffers
+  unsigned long long packBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  char* packBuf = BlockBuffer(packBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER, dstCapacity / 2, largeStageBuffer);
+
+  unsigned long long codeBufStack[MAX_SIZE_COMPRESS_BLOCK_QUARTER];
+  unsigned int* codes = (unsigned int*) BlockBuffer(codeBufStack, 8 * MAX_SIZE_COMPRESS_BLOCK_QUARTER,
+    dstCapacity / 2);
+
+  unsigned int packedSize = IntBitPackSize(nrOfLongs, bitWidth);
+  if (packedSize > 0) LZ4_decompress_fast(&src[DELTA_HEADER_SIZE], packBuf, packedSize);
+
+  IntBitUnpack((int*) codes, packBuf, nrOfLongs, 0, bitWidth, false);
+  LongDeltaDecode((long long*) dst, codes, nrOfLongs, base, firstDelta, order);
+
+  return dstCapacity;
+}
+
+
+// INT_SPARSE, REAL_SPARSE and LONG_SPARSE
+
+unsigned int INT_SPARSE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  return SparseEncode(dst, src, srcSize / 4, 4, (unsigned int) INT_MIN);
+}
+
+unsigned int INT_SPARSE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  SparseDecode(dst, src, dstCapacity / 4, 4, (unsigned int) INT_MIN);
+
+  return dstCapacity;
+}
+
+
+unsigned int REAL_SPARSE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  return SparseEncode(dst, src, srcSize / 8, 8, REAL_NA_BITS);
+}
+
+unsigned int REAL_SPARSE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  SparseDecode(dst, src, dstCapacity / 8, 8, REAL_NA_BITS);
+
+  return dstCapacity;
+}
+
+
+unsigned int LONG_SPARSE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel)
+{
+  return SparseEncode(dst, src, srcSize / 8, 8, (unsigned long long) LONG_NA_VALUE);
+}
+
+unsigned int LONG_SPARSE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
+{
+  SparseDecode(dst, src, dstCapacity / 8, 8, (unsigned long long) LONG_NA_VALUE);
+
+  return dstCapacity;
+}
+
+
+// ZSTD_DICT
+
+unsigned int ZSTD_C_DICT(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize,
+  const ZSTD_CDict* dictionary)
+{
+  if (zstdContexts.cctx == nullptr) zstdContexts.cctx = ZSTD_createCCtx();
+
+  // the compression level is set when the dictionary is digested
+  return ZSTD_compress_usingCDict(zstdContexts.cctx, dst, dstCapacity, src, srcSize, dictionary);
+}
+
+
+unsigned int ZSTD_D_DICT(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize,
+  const ZSTD_DDict* dictionary)
+{
+  if (zstdContexts.dctx == nullptr) zstdContexts.dctx = ZSTD_createDCtx();
+
+  return ZSTD_decompress_usingDDict(zstdContexts.dctx, dst, dstCapacity, src, compressedSize, dictionary);
+}
+
+
+
 inline void smallmemcpy(char* dst, const char* src, int size)
 {
   unsigned short longs = size / 2;
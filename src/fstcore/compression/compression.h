@@ -37,6 +37,10 @@
 #define COMPRESSION_H
 
 
+typedef struct ZSTD_CDict_s ZSTD_CDict;
+typedef struct ZSTD_DDict_s ZSTD_DDict;
+
+
 #define MAX_SIZE_COMPRESS_BLOCK 16384
 #define MAX_SIZE_COMPRESS_BLOCK_HALF 8192
 #define MAX_SIZE_COMPRESS_BLOCK_QUARTER 4096
@@ -86,6 +90,161 @@ void CompactIntToShort(char* outVec, const char* intVec, unsigned int nrOfInts);
 void DecompactByteToInt(const char* compressedVec, char* intVec, unsigned int nrOfInts);
 
 
+// Frame of reference bit packing of integers. Each integer is stored as a code of bitWidth bits, equal to the
+// difference with a base value. If the vector contains NA's, code zero is reserved for NA. Groups of
+// BITPACK_GROUP_SIZE integers are packed in 8 interleaved lanes of 32-bit words (lane l holds every 8th integer,
+// starting at l), the remaining integers are packed sequentially.
+
+#define BITPACK_GROUP_SIZE 256
+#define BITPACK_HEADER_SIZE 8
+
+
+// Determine the base and bit width (0 - 32) of the codes of a vector of integers
+unsigned int IntBitPackWidth(const int* intVec, unsigned int nrOfInts, int &base, bool &hasNA);
+
+
+// Size in bytes of nrOfInts packed codes, at most 4 * nrOfInts
+unsigned int IntBitPackSize(unsigned int nrOfInts, unsigned int bitWidth);
+
+
+// Without NA's (hasNA is false), each integer is packed as the difference with the base
+void IntBitPack(char* packed, const int* intVec, unsigned int nrOfInts, int base, unsigned int bitWidth, bool hasNA);
+
+
+void IntBitUnpack(int* intVec, const char* packed, unsigned int nrOfInts, int base, unsigned int bitWidth, bool hasNA);
+
+// Delta encoding of sorted keys and timestamps. Each value is stored as the difference with the previous value
+// (order 1), or as the difference between consecutive differences (order 2). The differences are mapped to unsigned
+// codes (0, -1, 1, -2, ... to 0, 1, 2, 3, ...), which are bit-packed. The first value and the first difference are
+// stored separately, their codes are zero.
+
+#define DELTA_HEADER_SIZE 16
+
+
+// Determine the order with the smallest codes and their bit width, isSorted is set if the values are non-decreasing
+unsigned int IntDeltaWidth(const int* intVec, unsigned int nrOfInts, int &order, bool &isSorted);
+
+
+void IntDeltaEncode(unsigned int* codes, const int* intVec, unsigned int nrOfInts, int order);
+
+
+// The codes are decoded in place
+void IntDeltaDecode(int* intVec, unsigned int nrOfInts, int base, int firstDelta, int order);
+
+
+// Doubles can be delta encoded if all values are integers and the codes fit 32 bits, otherwise 64 is returned
+unsigned int RealDeltaWidth(const double* realVec, unsigned int nrOfDoubles, int &order, bool &isSorted);
+
+
+void RealDeltaEncode(unsigned int* codes, const double* realVec, unsigned int nrOfDoubles, int order);
+
+
+void RealDeltaDecode(double* realVec, const unsigned int* codes, unsigned int nrOfDoubles, long long base,
+  int firstDelta, int order);
+
+// XOR compression of doubles (as in Facebook's Gorilla time series database). Each value is XOR-ed with the previous
+// value, the result is stored as a single bit if zero and otherwise as its meaningful bits (between the leading and
+// trailing zero bits). If these fit the window of the previous value, only the meaningful bits of that window are
+// stored. Otherwise the number of leading zeros (5 bits) and the number of meaningful bits (6 bits) are stored first.
+
+// Compress nrOfDoubles doubles into a bit stream of 64-bit words, returns the size in bytes. The size is at most
+// REAL_XOR_MAX_BITS bits per double (rounded upwards to whole words).
+unsigned int RealXorCompress(char* dst, const double* realVec, unsigned int nrOfDoubles);
+
+#define REAL_XOR_MAX_BITS 77
+
+
+void RealXorDecompress(double* realVec, const char* src, unsigned int nrOfDoubles);
+
+
+// Run-length encoding of integers, for columns with long runs of equal values (such as the level codes of a sorted
+// factor or a mostly constant logical). A block is stored as the number of runs, followed by the value of each run
+// and the length of each run.
+
+#define RLE_HEADER_SIZE 8
+
+
+// Number of runs of equal values (zero for an empty vector)
+unsigned int IntRunCount(const int* intVec, unsigned int nrOfInts);
+
+
+// Returns the size in bytes of the encoded vector, RLE_HEADER_SIZE + 8 * IntRunCount(intVec, nrOfInts)
+unsigned int IntRleEncode(char* dst, const int* intVec, unsigned int nrOfInts);
+
+
+// Locate the run values and run lengths in an encoded vector, returns the number of runs
+unsigned int IntRleRuns(const char* src, const int* &runValues, const unsigned int* &runLengths);
+
+
+void IntRleDecode(int* intVec, const char* src, unsigned int nrOfInts);
+
+
+// Doubles that are really integers (counts, identifiers) or decimals with a fixed number of digits (prices in cents).
+// A vector of such doubles is stored as 32-bit integer codes, equal to value * 10^scale for a decimal scale of
+// 0 to REAL_INT_MAX_SCALE. R's NA (exact bit pattern REAL_NA_BITS) is converted to NA_INTEGER, vectors with other
+// NaN values or -0.0 can't be converted.
+
+#define REAL_INT_MAX_SCALE 4
+#define REAL_NA_BITS 0x7FF00000000007A2ULL
+
+
+// Convert to integer codes with the smallest possible scale, returns the scale or -1 if the doubles can't be
+// converted exactly
+int RealToInt(int* intVec, const double* realVec, unsigned int nrOfDoubles);
+
+
+// Codes are read before the doubles are written, so intVec may point to the upper half of realVec
+void IntToReal(double* realVec, const int* intVec, unsigned int nrOfDoubles, int scale);
+
+
+// 64-bit integers (bit64::integer64 vectors), with NA stored as LONG_NA_VALUE. A vector with a range of less than
+// 2^32 values is stored as 32-bit integer codes relative to an offset, with NA converted to NA_INTEGER.
+
+#define LONG_NA_VALUE (-9223372036854775807LL - 1)  // NA_integer64_ of package bit64
+#define LONG_HEADER_SIZE 8                          // offset of the integer codes
+
+
+// Convert to integer codes, returns false if the range of the values is too wide
+bool LongToInt(int* intVec, const long long* longVec, unsigned int nrOfLongs, long long &offset);
+
+
+// Codes are read before the values are written, so intVec may point to the upper half of longVec
+void IntToLong(long long* longVec, const int* intVec, unsigned int nrOfLongs, long long offset);
+
+
+// 64-bit integers are delta encoded like integer valued doubles (see RealDeltaWidth), 64 is returned if the codes
+// don't fit 32 bits
+unsigned int LongDeltaWidth(const long long* longVec, unsigned int nrOfLongs, int &order, bool &isSorted);
+
+
+void LongDeltaEncode(unsigned int* codes, const long long* longVec, unsigned int nrOfLongs, int order);
+
+
+void LongDeltaDecode(long long* longVec, const unsigned int* codes, unsigned int nrOfLongs, long long base,
+  int firstDelta, int order);
+
+
+// Sparse encoding of blocks that consist mostly of NA values. A block is stored as the number of non-NA values, a
+// presence bitmap of 64-bit words with a bit set for each non-NA element and the non-NA values in their original
+// order. NA values are identified by their bit pattern (INT_MIN, REAL_NA_BITS or LONG_NA_VALUE), so NaN doubles
+// other than R's NA are stored as values. Decoding fills the block with NA and scatters the values to the set bits.
+
+#define SPARSE_HEADER_SIZE 8
+
+
+// Number of elements (of 4 or 8 bytes) that don't have bit pattern naBits
+unsigned int SparseValueCount(const char* src, unsigned int nrOfElements, unsigned int elementSize,
+  unsigned long long naBits);
+
+
+// Returns the size in bytes of the encoded vector
+unsigned int SparseEncode(char* dst, const char* src, unsigned int nrOfElements, unsigned int elementSize,
+  unsigned long long naBits);
+
+
+void SparseDecode(char* dst, const char* src, unsigned int nrOfElements, unsigned int elementSize,
+  unsigned long long naBits);
+
 // Function pointer to compression algorithm
 typedef unsigned int (*CompAlgorithm)(char* dst, unsigned int dstCapacity, const char* src, unsigned int srcSize, int compressionLevel);
 
@@ -142,6 +301,157 @@ unsigned int INT_TO_SHORT_C(char* dst, unsigned int dstCapacity, const char* src
 unsigned int INT_TO_SHORT_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
 
 
+// Integer algorithms
+
+// Buffer src should contain an integer vector, srcSize must be a multiple of 4
+unsigned int INT_BITPACK_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int INT_BITPACK_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+unsigned int LZ4_INT_BITPACK_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int LZ4_INT_BITPACK_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+unsigned int ZSTD_INT_BITPACK_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int ZSTD_INT_BITPACK_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+// Delta algorithms
+
+// Buffer src should contain an integer vector, srcSize must be a multiple of 4
+unsigned int INT_DELTA_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int INT_DELTA_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+unsigned int LZ4_INT_DELTA_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int LZ4_INT_DELTA_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+// Buffer src should contain a double vector, srcSize must be a multiple of 8. Returns zero if the block can't be
+// delta encoded (see RealDeltaWidth).
+unsigned int REAL_DELTA_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int REAL_DELTA_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+unsigned int LZ4_REAL_DELTA_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int LZ4_REAL_DELTA_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+// REAL_XOR
+
+// Buffer src should contain a double vector, srcSize must be a multiple of 8
+unsigned int REAL_XOR_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int REAL_XOR_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+// INT_RLE
+
+// Buffer src should contain an integer vector, srcSize must be a multiple of 4
+unsigned int INT_RLE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int INT_RLE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+// REAL_INT, LZ4_REAL_INT and ZSTD_REAL_INT
+
+// Buffer src should contain a double vector, srcSize must be a multiple of 8. Returns zero if the doubles can't be
+// converted to integers (see RealToInt).
+unsigned int REAL_INT_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int REAL_INT_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+unsigned int LZ4_REAL_INT_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int LZ4_REAL_INT_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+unsigned int ZSTD_REAL_INT_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int ZSTD_REAL_INT_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+// LONG_BITPACK, LZ4_LONG_BITPACK and ZSTD_LONG_BITPACK
+
+// Buffer src should contain a vector of 64-bit integers, srcSize must be a multiple of 8. Returns zero if the range
+// of the values is too wide (see LongToInt).
+unsigned int LONG_BITPACK_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int LONG_BITPACK_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+unsigned int LZ4_LONG_BITPACK_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int LZ4_LONG_BITPACK_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+unsigned int ZSTD_LONG_BITPACK_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int ZSTD_LONG_BITPACK_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+// LONG_DELTA and LZ4_LONG_DELTA
+
+// Buffer src should contain a vector of 64-bit integers, srcSize must be a multiple of 8. Returns zero if the block
+// can't be delta encoded (see LongDeltaWidth).
+unsigned int LONG_DELTA_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int LONG_DELTA_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+unsigned int LZ4_LONG_DELTA_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int LZ4_LONG_DELTA_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+// INT_SPARSE, REAL_SPARSE and LONG_SPARSE
+
+// Buffer src should contain an integer vector, srcSize must be a multiple of 4
+unsigned int INT_SPARSE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int INT_SPARSE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+// Buffer src should contain a double vector, srcSize must be a multiple of 8
+unsigned int REAL_SPARSE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int REAL_SPARSE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
+// Buffer src should contain a vector of 64-bit integers, srcSize must be a multiple of 8
+unsigned int LONG_SPARSE_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+unsigned int LONG_SPARSE_D(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
+
+
 // LOGIC64
 
 unsigned int LOGIC64_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
@@ -190,6 +500,21 @@ unsigned int LZ4_C_SHUF8(char* dst, unsigned int dstCapacity, const char* src,
 unsigned int LZ4_D_SHUF8(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
 
 
+// LZ4HC, LZ4HC_SHUF4 and LZ4HC_SHUF8
+
+// High compression variants of LZ4, LZ4_SHUF4 and LZ4_SHUF8 (see LZ4ChainCompress). The blocks are regular LZ4
+// blocks, so they are decompressed with LZ4_D, LZ4_D_SHUF4 and LZ4_D_SHUF8.
+unsigned int LZ4HC_C(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+// srcSize must be a multiple of 4
+unsigned int LZ4HC_C_SHUF4(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
+// srcSize must be a multiple of 8
+unsigned int LZ4HC_C_SHUF8(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
+
+
 // ZSTD_SHUF8
 
 unsigned int ZSTD_C_SHUF8(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, int compressionLevel);
@@ -214,4 +539,14 @@ unsigned int ZSTD_C_SHUF4(char* dst, unsigned int dstCapacity, const char* src,
 unsigned int ZSTD_D_SHUF4(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
 
 
+// ZSTD_DICT, blocks compressed with a dictionary that is shared by all blocks of a column
+
+unsigned int ZSTD_C_DICT(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize,
+  const ZSTD_CDict* dictionary);
+
+
+unsigned int ZSTD_D_DICT(char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize,
+  const ZSTD_DDict* dictionary);
+
+
 #endif  // COMPRESSION_H
@@ -33,13 +33,18 @@
 */
 
 #include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
 #include <fstream>
+#include <stdexcept>
 
 #include "compressor.h"
 #include "compression.h"
 
 #include "lz4.h"
 #include "zstd.h"
+#include "zstdmt_compress.h"
 
 
 using namespace std;
@@ -60,7 +65,32 @@ CompAlgorithm compAlgorithms[NR_OF_ALGORITHMS] = {  // all current and historic
   LZ4_INT_TO_SHORT_SHUF2_C,
   INT_TO_BYTE_C,
   INT_TO_SHORT_C,
-  ZSTD_INT_TO_BYTE_C
+  ZSTD_INT_TO_BYTE_C,
+  ZSTD_C,  // ZSTDMT, single threaded equivalent
+  INT_BITPACK_C,
+  LZ4_INT_BITPACK_C,
+  ZSTD_INT_BITPACK_C,
+  INT_DELTA_C,
+  LZ4_INT_DELTA_C,
+  REAL_DELTA_C,
+  LZ4_REAL_DELTA_C,
+  REAL_XOR_C,
+  INT_RLE_C,
+  REAL_INT_C,
+  LZ4_REAL_INT_C,
+  ZSTD_REAL_INT_C,
+  LONG_BITPACK_C,
+  LZ4_LONG_BITPACK_C,
+  ZSTD_LONG_BITPACK_C,
+  LONG_DELTA_C,
+  LZ4_LONG_DELTA_C,
+  ZSTD_C,  // ZSTD_DICT, equivalent without a dictionary
+  INT_SPARSE_C,
+  REAL_SPARSE_C,
+  LONG_SPARSE_C,
+  LZ4HC_C,
+  LZ4HC_C_SHUF4,
+  LZ4HC_C_SHUF8
 };
 
 
@@ -79,7 +109,32 @@ DecompAlgorithm decompAlgorithms[NR_OF_ALGORITHMS] = {  // all current and histo
   LZ4_INT_TO_SHORT_SHUF2_D,
   INT_TO_BYTE_D,
   INT_TO_SHORT_D,
-  ZSTD_INT_TO_BYTE_D
+  ZSTD_INT_TO_BYTE_D,
+  ZSTD_D,  // ZSTDMT blocks are regular ZSTD frames
+  INT_BITPACK_D,
+  LZ4_INT_BITPACK_D,
+  ZSTD_INT_BITPACK_D,
+  INT_DELTA_D,
+  LZ4_INT_DELTA_D,
+  REAL_DELTA_D,
+  LZ4_REAL_DELTA_D,
+  REAL_XOR_D,
+  INT_RLE_D,
+  REAL_INT_D,
+  LZ4_REAL_INT_D,
+  ZSTD_REAL_INT_D,
+  LONG_BITPACK_D,
+  LZ4_LONG_BITPACK_D,
+  ZSTD_LONG_BITPACK_D,
+  LONG_DELTA_D,
+  LZ4_LONG_DELTA_D,
+  ZSTD_D,  // ZSTD_DICT blocks require a dictionary (see Decompressor::SetDictionary)
+  INT_SPARSE_D,
+  REAL_SPARSE_D,
+  LONG_SPARSE_D,
+  LZ4_D,  // LZ4HC blocks are regular LZ4 blocks
+  LZ4_D_SHUF4,
+  LZ4_D_SHUF8
 };
 
 
@@ -98,7 +153,32 @@ CompAlgoType algorithmType[NR_OF_ALGORITHMS] = {  // type of algorithm
   CompAlgoType::LZ4_INT_TO_SHORT_TYPE,
   CompAlgoType::INT_TO_BYTE_TYPE,
   CompAlgoType::INT_TO_SHORT_TYPE,
-  CompAlgoType::ZSTD_INT_TO_BYTE_TYPE
+  CompAlgoType::ZSTD_INT_TO_BYTE_TYPE,
+  CompAlgoType::ZSTD_TYPE,
+  CompAlgoType::INT_BITPACK_TYPE,
+  CompAlgoType::LZ4_INT_BITPACK_TYPE,
+  CompAlgoType::ZSTD_INT_BITPACK_TYPE,
+  CompAlgoType::INT_DELTA_TYPE,
+  CompAlgoType::LZ4_INT_DELTA_TYPE,
+  CompAlgoType::REAL_DELTA_TYPE,
+  CompAlgoType::LZ4_REAL_DELTA_TYPE,
+  CompAlgoType::REAL_XOR_TYPE,
+  CompAlgoType::INT_RLE_TYPE,
+  CompAlgoType::REAL_INT_TYPE,
+  CompAlgoType::LZ4_REAL_INT_TYPE,
+  CompAlgoType::ZSTD_REAL_INT_TYPE,
+  CompAlgoType::LONG_BITPACK_TYPE,
+  CompAlgoType::LZ4_LONG_BITPACK_TYPE,
+  CompAlgoType::ZSTD_LONG_BITPACK_TYPE,
+  CompAlgoType::LONG_DELTA_TYPE,
+  CompAlgoType::LZ4_LONG_DELTA_TYPE,
+  CompAlgoType::ZSTD_TYPE,
+  CompAlgoType::INT_SPARSE_TYPE,
+  CompAlgoType::LONG_SPARSE_TYPE,
+  CompAlgoType::LONG_SPARSE_TYPE,
+  CompAlgoType::LZ4_TYPE,
+  CompAlgoType::LZ4_TYPE,
+  CompAlgoType::LZ4_TYPE
 };
 
 
@@ -118,6 +198,31 @@ unsigned int fixedRatioSourceRepSize[NR_OF_ALGORITHMS] = {  // all current and h
   0,
   32,
   16,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
   0
 };
 
@@ -138,9 +243,80 @@ unsigned int fixedRatioTargetRepSize[NR_OF_ALGORITHMS] = {  // all current and h
   0,
   8,
   8,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
+  0,
   0
 };
 
+
+// Output alignment of the decompression routines
+unsigned int decompAlignment[NR_OF_ALGORITHMS] = {  // all current and historic compression algorithms
+  1,  // UNCOMPRESS
+  1,  // LZ4
+  8,  // LZ4_SHUF4
+  1,  // ZSTD
+  8,  // ZSTD_SHUF4
+  8,  // LZ4_SHUF8
+  8,  // ZSTD_SHUF8
+  8,  // LZ4_LOGIC64
+  8,  // LOGIC64
+  8,  // ZSTD_LOGIC64
+  8,  // LZ4_INT_TO_BYTE
+  8,  // LZ4_INT_TO_SHORT_SHUF2
+  8,  // INT_TO_BYTE
+  8,  // INT_TO_SHORT
+  8,  // ZSTD_INT_TO_BYTE
+  1,  // ZSTDMT
+  4,  // INT_BITPACK
+  4,  // LZ4_INT_BITPACK
+  4,  // ZSTD_INT_BITPACK
+  4,  // INT_DELTA
+  4,  // LZ4_INT_DELTA
+  8,  // REAL_DELTA
+  8,  // LZ4_REAL_DELTA
+  8,  // REAL_XOR
+  4,  // INT_RLE
+  8,  // REAL_INT
+  8,  // LZ4_REAL_INT
+  8,  // ZSTD_REAL_INT
+  8,  // LONG_BITPACK
+  8,  // LZ4_LONG_BITPACK
+  8,  // ZSTD_LONG_BITPACK
+  8,  // LONG_DELTA
+  8,  // LZ4_LONG_DELTA
+  1,  // ZSTD_DICT
+  4,  // INT_SPARSE
+  8,  // REAL_SPARSE
+  8,  // LONG_SPARSE
+  1,  // LZ4HC
+  8,  // LZ4HC_SHUF4
+  8   // LZ4HC_SHUF8
+};
+
+
 inline int MaxCompressSize(int blockSize, CompAlgoType algoType)
 {
   int compBufSize = blockSize;
@@ -222,14 +398,168 @@ inline int MaxCompressSize(int blockSize, CompAlgoType algoType)
       compBufSize = 8 * nrOfLongs;
       break;
     }
+
+    case CompAlgoType::INT_BITPACK_TYPE:
+    {
+      int nrOfInts = (blockSize + 3) / 4;  // safely round upwards
+      compBufSize = BITPACK_HEADER_SIZE + 4 * nrOfInts;  // codes are at most 32 bits wide
+      break;
+    }
+
+    case CompAlgoType::LZ4_INT_BITPACK_TYPE:
+    {
+      int nrOfInts = (blockSize + 3) / 4;  // safely round upwards
+      compBufSize = BITPACK_HEADER_SIZE + LZ4_COMPRESSBOUND(4 * nrOfInts);
+      break;
+    }
+
+    case CompAlgoType::ZSTD_INT_BITPACK_TYPE:
+    {
+      int nrOfInts = (blockSize + 3) / 4;  // safely round upwards
+      compBufSize = BITPACK_HEADER_SIZE + ZSTD_compressBound(4 * nrOfInts);
+      break;
+    }
+
+    case CompAlgoType::INT_DELTA_TYPE:
+    {
+      int nrOfInts = (blockSize + 3) / 4;  // safely round upwards
+      compBufSize = DELTA_HEADER_SIZE + 4 * nrOfInts;  // codes are at most 32 bits wide
+      break;
+    }
+
+    case CompAlgoType::LZ4_INT_DELTA_TYPE:
+    {
+      int nrOfInts = (blockSize + 3) / 4;  // safely round upwards
+      compBufSize = DELTA_HEADER_SIZE + LZ4_COMPRESSBOUND(4 * nrOfInts);
+      break;
+    }
+
+    case CompAlgoType::REAL_DELTA_TYPE:
+    {
+      int nrOfDoubles = (blockSize + 7) / 8;  // safely round upwards
+      compBufSize = DELTA_HEADER_SIZE + 4 * nrOfDoubles;  // codes are at most 32 bits wide
+      break;
+    }
+
+    case CompAlgoType::LZ4_REAL_DELTA_TYPE:
+    {
+      int nrOfDoubles = (blockSize + 7) / 8;  // safely round upwards
+      compBufSize = DELTA_HEADER_SIZE + LZ4_COMPRESSBOUND(4 * nrOfDoubles);
+      break;
+    }
+
+    case CompAlgoType::REAL_XOR_TYPE:
+    {
+      int nrOfDoubles = (blockSize + 7) / 8;  // safely round upwards
+      compBufSize = 8 * ((REAL_XOR_MAX_BITS * nrOfDoubles + 63) / 64) + 8;  // whole words, plus a word of slack
+      break;
+    }
+
+    case CompAlgoType::INT_RLE_TYPE:
+    {
+      int nrOfInts = (blockSize + 3) / 4;  // safely round upwards
+      compBufSize = RLE_HEADER_SIZE + 8 * nrOfInts;  // a run for each integer
+      break;
+    }
+
+    case CompAlgoType::REAL_INT_TYPE:
+    {
+      int nrOfDoubles = (blockSize + 7) / 8;  // safely round upwards
+      compBufSize = BITPACK_HEADER_SIZE + 4 * nrOfDoubles;  // codes are at most 32 bits wide
+      break;
+    }
+
+    case CompAlgoType::LZ4_REAL_INT_TYPE:
+    {
+      int nrOfDoubles = (blockSize + 7) / 8;  // safely round upwards
+      compBufSize = BITPACK_HEADER_SIZE + LZ4_COMPRESSBOUND(4 * nrOfDoubles);
+      break;
+    }
+
+    case CompAlgoType::ZSTD_REAL_INT_TYPE:
+    {
+      int nrOfDoubles = (blockSize + 7) / 8;  // safely round upwards
+      compBufSize = BITPACK_HEADER_SIZE + ZSTD_compressBound(4 * nrOfDoubles);
+      break;
+    }
+
+    case CompAlgoType::LONG_BITPACK_TYPE:
+    {
+      int nrOfLongs = (blockSize + 7) / 8;  // safely round upwards
+      compBufSize = LONG_HEADER_SIZE + BITPACK_HEADER_SIZE + 4 * nrOfLongs;  // codes are at most 32 bits wide
+      break;
+    }
+
+    case CompAlgoType::LZ4_LONG_BITPACK_TYPE:
+    {
+      int nrOfLongs = (blockSize + 7) / 8;  // safely round upwards
+      compBufSize = LONG_HEADER_SIZE + BITPACK_HEADER_SIZE + LZ4_COMPRESSBOUND(4 * nrOfLongs);
+      break;
+    }
+
+    case CompAlgoType::ZSTD_LONG_BITPACK_TYPE:
+    {
+      int nrOfLongs = (blockSize + 7) / 8;  // safely round upwards
+      compBufSize = LONG_HEADER_SIZE + BITPACK_HEADER_SIZE + ZSTD_compressBound(4 * nrOfLongs);
+      break;
+    }
+
+    case CompAlgoType::LONG_DELTA_TYPE:
+    {
+      int nrOfLongs = (blockSize + 7) / 8;  // safely round upwards
+      compBufSize = DELTA_HEADER_SIZE + 4 * nrOfLongs;  // codes are at most 32 bits wide
+      break;
+    }
+
+    case CompAlgoType::LZ4_LONG_DELTA_TYPE:
+    {
+      int nrOfLongs = (blockSize + 7) / 8;  // safely round upwards
+      compBufSize = DELTA_HEADER_SIZE + LZ4_COMPRESSBOUND(4 * nrOfLongs);
+      break;
+    }
+
+    case CompAlgoType::INT_SPARSE_TYPE:
+    {
+      int nrOfInts = (blockSize + 3) / 4;  // safely round upwards
+      compBufSize = SPARSE_HEADER_SIZE + 8 * ((nrOfInts + 63) / 64) + 4 * nrOfInts;  // bitmap and all values
+      break;
+    }
+
+    case CompAlgoType::LONG_SPARSE_TYPE:
+    {
+      int nrOfLongs = (blockSize + 7) / 8;  // safely round upwards
+      compBufSize = SPARSE_HEADER_SIZE + 8 * ((nrOfLongs + 63) / 64) + 8 * nrOfLongs;  // bitmap and all values
+      break;
+    }
   }
 
   return compBufSize;
 }
 
 
+Decompressor::~Decompressor()
+{
+  if (dictionary != nullptr) ZSTD_freeDDict(dictionary);
+}
+
+void Decompressor::SetDictionary(const char* dictBuffer, unsigned int dictSize)
+{
+  if (dictionary != nullptr) ZSTD_freeDDict(dictionary);
+  dictionary = ZSTD_createDDict(dictBuffer, dictSize);
+
+  if (dictionary == nullptr)
+  {
+    throw(runtime_error("Error reading the compression dictionary of the column data."));
+  }
+}
+
 int Decompressor::Decompress(unsigned int algo, char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize)
 {
+  if (algo == CompAlgo::ZSTD_DICT && dictionary != nullptr)
+  {
+    return ZSTD_D_DICT(dst, dstCapacity, src, compressedSize, dictionary);
+  }
+
   DecompAlgorithm decompAlgorithm = decompAlgorithms[algo];
   return decompAlgorithm(dst, dstCapacity, src, compressedSize);
 }
@@ -339,7 +669,440 @@ int DualCompressor::Compress(char* dst, unsigned int dstCapacity, const char* sr
 }
 
 
-int StreamFixedCompressor::Compress(ofstream &myfile, const char* src,  unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm)
+BitPackCompressor::BitPackCompressor(CompAlgo packAlgo, CompAlgo fallbackAlgo, int compressionLevel)
+{
+  this->algo1 = packAlgo;
+  this->algo2 = fallbackAlgo;
+  this->compLevel = compressionLevel;
+
+  a1 = compAlgorithms[(int) packAlgo];
+  a2 = compAlgorithms[(int) fallbackAlgo];
+  isLong = packAlgo == CompAlgo::LONG_BITPACK || packAlgo == CompAlgo::LZ4_LONG_BITPACK ||
+    packAlgo == CompAlgo::ZSTD_LONG_BITPACK;
+}
+
+int BitPackCompressor::CompressBufferSize(int maxBlockSize)
+{
+  int size1 = MaxCompressSize(maxBlockSize, algorithmType[(int) algo1]);
+  int size2 = MaxCompressSize(maxBlockSize, algorithmType[(int) algo2]);
+  return max(size1, size2);
+}
+
+int BitPackCompressor::Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm)
+{
+  // 64-bit integers are packed if the codes fit 32 bits, the packing algorithm returns zero otherwise
+  if (isLong)
+  {
+    int compSize = a1(dst, dstCapacity, src, srcSize, compLevel);
+
+    if (compSize > 0)
+    {
+      compAlgorithm = algo1;
+      return compSize;
+    }
+
+    compAlgorithm = algo2;
+    return a2(dst, dstCapacity, src, srcSize, compLevel);
+  }
+
+  unsigned int nrOfInts = srcSize / 4;
+  int base;
+  bool hasNA;
+
+  // The range of the block is determined again by the bit packing algorithm, but a range scan is cheap
+  unsigned int bitWidth = IntBitPackWidth((const int*) src, nrOfInts, base, hasNA);
+
+  if (bitWidth <= BITPACK_MAX_WIDTH && BITPACK_HEADER_SIZE + IntBitPackSize(nrOfInts, bitWidth) < srcSize)
+  {
+    compAlgorithm = algo1;
+    return a1(dst, dstCapacity, src, srcSize, compLevel);
+  }
+
+  compAlgorithm = algo2;
+  return a2(dst, dstCapacity, src, srcSize, compLevel);
+}
+
+
+
+DeltaCompressor::DeltaCompressor(CompAlgo deltaAlgo, Compressor* fallbackCompressor, int compressionLevel)
+{
+  this->algo1 = deltaAlgo;
+  this->fallback = fallbackCompressor;
+  this->compLevel = compressionLevel;
+
+  a1 = compAlgorithms[(int) deltaAlgo];
+  isReal = deltaAlgo == CompAlgo::REAL_DELTA || deltaAlgo == CompAlgo::LZ4_REAL_DELTA;
+  isLong = deltaAlgo == CompAlgo::LONG_DELTA || deltaAlgo == CompAlgo::LZ4_LONG_DELTA;
+}
+
+int DeltaCompressor::CompressBufferSize(int maxBlockSize)
+{
+  int size1 = MaxCompressSize(maxBlockSize, algorithmType[(int) algo1]);
+  return max(size1, fallback->CompressBufferSize(maxBlockSize));
+}
+
+int DeltaCompressor::Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm)
+{
+  int order;
+  bool isSorted;
+  unsigned int bitWidth;
+
+  if (isReal)
+  {
+    bitWidth = RealDeltaWidth((const double*) src, srcSize / 8, order, isSorted);
+  }
+  else if (isLong)
+  {
+    bitWidth = LongDeltaWidth((const long long*) src, srcSize / 8, order, isSorted);
+  }
+  else
+  {
+    bitWidth = IntDeltaWidth((const int*) src, srcSize / 4, order, isSorted);
+  }
+
+  if (isSorted && bitWidth <= DELTA_MAX_WIDTH)
+  {
+    compAlgorithm = algo1;
+    return a1(dst, dstCapacity, src, srcSize, compLevel);
+  }
+
+  return fallback->Compress(dst, dstCapacity, src, srcSize, compAlgorithm);
+}
+
+
+
+RleCompressor::RleCompressor(Compressor* fallbackCompressor)
+{
+  this->fallback = fallbackCompressor;
+}
+
+int RleCompressor::CompressBufferSize(int maxBlockSize)
+{
+  int size1 = MaxCompressSize(maxBlockSize, CompAlgoType::INT_RLE_TYPE);
+  return max(size1, fallback->CompressBufferSize(maxBlockSize));
+}
+
+int RleCompressor::Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm)
+{
+  unsigned int nrOfInts = srcSize / 4;
+
+  if (IntRunCount((const int*) src, nrOfInts) * RLE_MIN_RUN_LENGTH <= nrOfInts)
+  {
+    compAlgorithm = CompAlgo::INT_RLE;
+    return INT_RLE_C(dst, dstCapacity, src, srcSize, 0);
+  }
+
+  return fallback->Compress(dst, dstCapacity, src, srcSize, compAlgorithm);
+}
+
+
+SparseCompressor::SparseCompressor(CompAlgo sparseAlgo, Compressor* fallbackCompressor)
+{
+  this->algo = sparseAlgo;
+  this->fallback = fallbackCompressor;
+
+  elementSize = sparseAlgo == CompAlgo::INT_SPARSE ? 4 : 8;
+  naBits = sparseAlgo == CompAlgo::INT_SPARSE ? (unsigned int) INT_MIN :
+    (sparseAlgo == CompAlgo::REAL_SPARSE ? REAL_NA_BITS : (unsigned long long) LONG_NA_VALUE);
+}
+
+int SparseCompressor::CompressBufferSize(int maxBlockSize)
+{
+  int size1 = MaxCompressSize(maxBlockSize, algorithmType[(int) algo]);
+  return max(size1, fallback->CompressBufferSize(maxBlockSize));
+}
+
+int SparseCompressor::Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm)
+{
+  unsigned int nrOfElements = srcSize / elementSize;
+
+  if (SparseValueCount(src, nrOfElements, elementSize, naBits) * SPARSE_MAX_DENSITY <= nrOfElements)
+  {
+    compAlgorithm = algo;
+    return SparseEncode(dst, src, nrOfElements, elementSize, naBits);
+  }
+
+  return fallback->Compress(dst, dstCapacity, src, srcSize, compAlgorithm);
+}
+
+
+RealIntCompressor::RealIntCompressor(CompAlgo intAlgo, Compressor* fallbackCompressor, int compressionLevel)
+{
+  this->algo1 = intAlgo;
+  this->fallback = fallbackCompressor;
+  this->compLevel = compressionLevel;
+
+  a1 = compAlgorithms[(int) intAlgo];
+}
+
+int RealIntCompressor::CompressBufferSize(int maxBlockSize)
+{
+  int size1 = MaxCompressSize(maxBlockSize, algorithmType[(int) algo1]);
+  return max(size1, fallback->CompressBufferSize(maxBlockSize));
+}
+
+int RealIntCompressor::Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm)
+{
+  // the integer algorithms return zero for blocks that can't be converted
+  int compSize = a1(dst, dstCapacity, src, srcSize, compLevel);
+
+  if (compSize > 0)
+  {
+    compAlgorithm = algo1;
+    return compSize;
+  }
+
+  return fallback->Compress(dst, dstCapacity, src, srcSize, compAlgorithm);
+}
+
+
+
+ZstdMtCompressor::ZstdMtCompressor(int compressionLevel, int nrOfThreads)
+{
+  this->compLevel = compressionLevel;
+  mtContext = ZSTDMT_createCCtx(max(1, min(nrOfThreads, 128)));  // ZSTDMT supports up to 128 worker threads
+
+  if (mtContext == nullptr)
+  {
+    throw(runtime_error("Error creating the ZSTD worker pool."));
+  }
+}
+
+ZstdMtCompressor::~ZstdMtCompressor()
+{
+  ZSTDMT_freeCCtx(mtContext);
+}
+
+int ZstdMtCompressor::CompressBufferSize(int maxBlockSize)
+{
+  return MaxCompressSize(maxBlockSize, CompAlgoType::ZSTD_TYPE);
+}
+
+int ZstdMtCompressor::Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm)
+{
+  compAlgorithm = CompAlgo::ZSTDMT;
+
+  // level scaling identical to ZSTD_C
+  size_t compSize = ZSTDMT_compressCCtx(mtContext, dst, dstCapacity, src, srcSize, compLevel / 4.5);
+
+  if (ZSTD_isError(compSize))
+  {
+    throw(runtime_error("Error compressing a block of the column data."));
+  }
+
+  return static_cast<int>(compSize);
+}
+
+
+ZstdDictCompressor::ZstdDictCompressor(const char* dictBuffer, unsigned int dictSize, int compressionLevel)
+{
+  // level scaling identical to ZSTD_C
+  dictionary = ZSTD_createCDict(dictBuffer, dictSize, compressionLevel / 4.5);
+
+  if (dictionary == nullptr)
+  {
+    throw(runtime_error("Error creating the compression dictionary of the column data."));
+  }
+}
+
+ZstdDictCompressor::~ZstdDictCompressor()
+{
+  ZSTD_freeCDict(dictionary);
+}
+
+int ZstdDictCompressor::CompressBufferSize(int maxBlockSize)
+{
+  return MaxCompressSize(maxBlockSize, CompAlgoType::ZSTD_TYPE);
+}
+
+int ZstdDictCompressor::Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm)
+{
+  compAlgorithm = CompAlgo::ZSTD_DICT;
+  return ZSTD_C_DICT(dst, dstCapacity, src, srcSize, dictionary);
+}
+
+
+
+#define ADAPTIVE_PROBE_INTERVAL 32  // number of blocks between two probe blocks of an adaptive compressor
+#define ADAPTIVE_AVERAGE_WEIGHT 0.25  // weight of the last measurement in the running averages
+#define UNCOMPRESSED_SPEED 1e9  // nominal speed of storing a block uncompressed (MB/s)
+
+// Compression buffers of the candidates of a probe block
+static thread_local vector<vector<char>> probeBuffers;
+
+
+AdaptiveCompressor::AdaptiveCompressor(const CompressionGoal &goal)
+{
+  minSpeed = goal.minSpeed;
+  minRatio = goal.minRatio;
+  blockCount = 0;
+  selected = 0;
+
+  AddCandidate(CompAlgo::UNCOMPRESS, 0);
+}
+
+void AdaptiveCompressor::AddCandidate(CompAlgo algo, int compressionLevel)
+{
+  algos.push_back(algo);
+  compLevels.push_back(compressionLevel);
+  ratios.push_back(1.0);
+  speeds.push_back(UNCOMPRESSED_SPEED);
+}
+
+int AdaptiveCompressor::CompressBufferSize(int maxBlockSize)
+{
+  int bufSize = maxBlockSize;  // uncompressed blocks
+
+  for (size_t candidate = 1; candidate < algos.size(); ++candidate)
+  {
+    bufSize = max(bufSize, MaxCompressSize(maxBlockSize, algorithmType[(int) algos[candidate]]));
+  }
+
+  return bufSize;
+}
+
+int AdaptiveCompressor::SelectCandidate(const double* candidateRatios, const double* candidateSpeeds) const
+{
+  int best = -1;
+  int highestRatio = 0;
+
+  for (int candidate = 0; candidate < (int) algos.size(); ++candidate)
+  {
+    if (candidateRatios[candidate] > candidateRatios[highestRatio]) highestRatio = candidate;
+
+    if (minSpeed > 0)
+    {
+      // highest ratio within the speed budget
+      if (candidateSpeeds[candidate] < minSpeed) continue;
+      if (best == -1 || candidateRatios[candidate] > candidateRatios[best]) best = candidate;
+    }
+    else
+    {
+      // fastest candidate with a sufficient ratio
+      if (candidateRatios[candidate] < minRatio) continue;
+      if (best == -1 || candidateSpeeds[candidate] > candidateSpeeds[best]) best = candidate;
+    }
+  }
+
+  return best == -1 ? highestRatio : best;
+}
+
+inline int CompressCandidate(CompAlgo algo, int compLevel, char* dst, unsigned int dstCapacity, const char* src,
+  unsigned int srcSize)
+{
+  if (algo == CompAlgo::UNCOMPRESS)
+  {
+    memcpy(dst, src, srcSize);
+    return srcSize;
+  }
+
+  return compAlgorithms[(int) algo](dst, dstCapacity, src, srcSize, compLevel);
+}
+
+int AdaptiveCompressor::Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm)
+{
+  int nrOfCandidates = static_cast<int>(algos.size());
+  int candidate;
+  unsigned int blockNr;
+
+#pragma omp critical(adaptive_compressor)
+  {
+    blockNr = blockCount++;
+    candidate = selected;
+  }
+
+  bool isProbe = blockNr % ADAPTIVE_PROBE_INTERVAL == 0;
+
+  if (!isProbe)
+  {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int compSize = CompressCandidate(algos[candidate], compLevels[candidate], dst, dstCapacity, src, srcSize);
+    double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+    // Blocks that don't compress are stored as is
+    if (compSize == 0 || compSize >= (int) srcSize)
+    {
+      memcpy(dst, src, srcSize);
+      compSize = srcSize;
+      compAlgorithm = CompAlgo::UNCOMPRESS;
+    }
+    else
+    {
+      compAlgorithm = algos[candidate];
+    }
+
+    if (candidate != 0)
+    {
+#pragma omp critical(adaptive_compressor)
+      {
+        ratios[candidate] += ADAPTIVE_AVERAGE_WEIGHT * ((double) srcSize / compSize - ratios[candidate]);
+        speeds[candidate] += ADAPTIVE_AVERAGE_WEIGHT * (srcSize / max(micros, 0.001) - speeds[candidate]);
+        selected = SelectCandidate(ratios.data(), speeds.data());
+      }
+    }
+
+    return compSize;
+  }
+
+  // Probe block: measure all candidates
+  if ((int) probeBuffers.size() < nrOfCandidates) probeBuffers.resize(nrOfCandidates);
+
+  vector<double> blockRatios(nrOfCandidates, 1.0);
+  vector<double> blockSpeeds(nrOfCandidates, UNCOMPRESSED_SPEED);
+  vector<int> compSizes(nrOfCandidates, srcSize);
+
+  for (int probe = 1; probe < nrOfCandidates; ++probe)
+  {
+    if (probeBuffers[probe].size() < dstCapacity) probeBuffers[probe].resize(dstCapacity);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int compSize = CompressCandidate(algos[probe], compLevels[probe], probeBuffers[probe].data(), dstCapacity,
+      src, srcSize);
+    double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+    if (compSize == 0 || compSize >= (int) srcSize) compSize = srcSize;  // no gain over storing uncompressed
+
+    compSizes[probe] = compSize;
+    blockRatios[probe] = (double) srcSize / compSize;
+    blockSpeeds[probe] = srcSize / max(micros, 0.001);
+  }
+
+  // The probe block itself uses the best candidate for its own measurements
+  int best = SelectCandidate(blockRatios.data(), blockSpeeds.data());
+
+#pragma omp critical(adaptive_compressor)
+  {
+    if (blockNr == 0)  // the first probe defines the averages
+    {
+      ratios = blockRatios;
+      speeds = blockSpeeds;
+    }
+    else
+    {
+      for (int probe = 1; probe < nrOfCandidates; ++probe)
+      {
+        ratios[probe] += ADAPTIVE_AVERAGE_WEIGHT * (blockRatios[probe] - ratios[probe]);
+        speeds[probe] += ADAPTIVE_AVERAGE_WEIGHT * (blockSpeeds[probe] - speeds[probe]);
+      }
+    }
+
+    selected = SelectCandidate(ratios.data(), speeds.data());
+  }
+
+  if (best == 0 || compSizes[best] == (int) srcSize)
+  {
+    memcpy(dst, src, srcSize);
+    compAlgorithm = CompAlgo::UNCOMPRESS;
+    return srcSize;
+  }
+
+  memcpy(dst, probeBuffers[best].data(), compSizes[best]);
+  compAlgorithm = algos[best];
+  return compSizes[best];
+}
+
+
+int StreamFixedCompressor::Compress(ostream &myfile, const char* src,  unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm)
 {
   compAlgorithm = CompAlgo::UNCOMPRESS;
   myfile.write(src, srcSize);
@@ -372,21 +1135,33 @@ int StreamLinearCompressor::CompressBufferSize(unsigned int srcSize)
   return compBufSize;  // return buffer size for the compression algorithm
 }
 
-int StreamLinearCompressor::Compress(ofstream &myfile, const char* src,  unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm)
+Compressor* StreamLinearCompressor::NextBlockCompressor()
 {
   // Compressed
   if (curBlock >= nextCompBlock)
   {
-    int compSize = compress->Compress(compBuf, compBufSize, src, srcSize, compAlgorithm);
-    myfile.write(compBuf, compSize);
     nextCompBlock = (int) (++compBlockCount * compFactor) - 1;
     ++curBlock;
-    return compSize;
+    return compress;
   }
 
-
   ++curBlock;
 
+  return nullptr;  // uncompressed
+}
+
+int StreamLinearCompressor::Compress(ostream &myfile, const char* src,  unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm)
+{
+  Compressor* blockCompressor = NextBlockCompressor();
+
+  // Compressed
+  if (blockCompressor != nullptr)
+  {
+    int compSize = blockCompressor->Compress(compBuf, compBufSize, src, srcSize, compAlgorithm);
+    myfile.write(compBuf, compSize);
+    return compSize;
+  }
+
   // Uncompressed
   compAlgorithm = CompAlgo::UNCOMPRESS;
   myfile.write(src, srcSize);
@@ -410,7 +1185,12 @@ int StreamSingleCompressor::CompressBufferSize(unsigned int srcSize)
   return compBufSize;  // return buffer size for the compression algorithm
 }
 
-int StreamSingleCompressor::Compress(ofstream &myfile, const char* src, unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm)
+Compressor* StreamSingleCompressor::NextBlockCompressor()
+{
+  return compress;
+}
+
+int StreamSingleCompressor::Compress(ostream &myfile, const char* src, unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm)
 {
   int compSize = compress->Compress(compBuf, compBufSize, src, srcSize, compAlgorithm);
   myfile.write(compBuf, compSize);
@@ -442,22 +1222,24 @@ int StreamCompositeCompressor::CompressBufferSize(unsigned int srcSize)
   return compBufSize;  // return buffer size for the compression algorithm
 }
 
-int StreamCompositeCompressor::Compress(ofstream &myfile, const char* src,  unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm)
+Compressor* StreamCompositeCompressor::NextBlockCompressor()
 {
-  int compSize;
+  Compressor* blockCompressor = compress2;
 
   // Algortihm 1
   if (curBlock >= nextCompBlock)
   {
-    compSize = compress1->Compress(compBuf, compBufSize, src, srcSize, compAlgorithm);
+    blockCompressor = compress1;
     nextCompBlock = (int) (++compBlockCount * compFactor) - 1;
   }
-  else
-  {
-   compSize = compress2->Compress(compBuf, compBufSize, src, srcSize, compAlgorithm);
-  }
 
-  myfile.write(compBuf, compSize);
   ++curBlock;
+  return blockCompressor;
+}
+
+int StreamCompositeCompressor::Compress(ostream &myfile, const char* src,  unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm)
+{
+  int compSize = NextBlockCompressor()->Compress(compBuf, compBufSize, src, srcSize, compAlgorithm);
+  myfile.write(compBuf, compSize);
   return compSize;
 }
@@ -36,10 +36,16 @@
 #ifndef COMPRESSOR_H
 #define COMPRESSOR_H
 
+#include <ostream>
+#include <vector>
+
 #include "compression.h"
 
 
-#define NR_OF_ALGORITHMS 15
+typedef struct ZSTDMT_CCtx_s ZSTDMT_CCtx;
+
+
+#define NR_OF_ALGORITHMS 40
 #define MAX_TARGET_REP_SIZE 8
 #define MAX_SOURCE_REP_SIZE 128
 #define MAX_TARGET_BUFFER 8192  // 16384  / 2
@@ -57,7 +63,26 @@ enum CompAlgoType
   LZ4_INT_TO_SHORT_TYPE,
   INT_TO_BYTE_TYPE,
   INT_TO_SHORT_TYPE,
-  ZSTD_INT_TO_BYTE_TYPE
+  ZSTD_INT_TO_BYTE_TYPE,
+  INT_BITPACK_TYPE,
+  LZ4_INT_BITPACK_TYPE,
+  ZSTD_INT_BITPACK_TYPE,
+  INT_DELTA_TYPE,
+  LZ4_INT_DELTA_TYPE,
+  REAL_DELTA_TYPE,
+  LZ4_REAL_DELTA_TYPE,
+  REAL_XOR_TYPE,
+  INT_RLE_TYPE,
+  REAL_INT_TYPE,
+  LZ4_REAL_INT_TYPE,
+  ZSTD_REAL_INT_TYPE,
+  LONG_BITPACK_TYPE,
+  LZ4_LONG_BITPACK_TYPE,
+  ZSTD_LONG_BITPACK_TYPE,
+  LONG_DELTA_TYPE,
+  LZ4_LONG_DELTA_TYPE,
+  INT_SPARSE_TYPE,
+  LONG_SPARSE_TYPE
 };
 
 
@@ -77,7 +102,32 @@ enum CompAlgo
   LZ4_INT_TO_SHORT_SHUF2,
   INT_TO_BYTE,
   INT_TO_SHORT,
-  ZSTD_INT_TO_BYTE
+  ZSTD_INT_TO_BYTE,
+  ZSTDMT,
+  INT_BITPACK,
+  LZ4_INT_BITPACK,
+  ZSTD_INT_BITPACK,
+  INT_DELTA,
+  LZ4_INT_DELTA,
+  REAL_DELTA,
+  LZ4_REAL_DELTA,
+  REAL_XOR,
+  INT_RLE,
+  REAL_INT,
+  LZ4_REAL_INT,
+  ZSTD_REAL_INT,
+  LONG_BITPACK,
+  LZ4_LONG_BITPACK,
+  ZSTD_LONG_BITPACK,
+  LONG_DELTA,
+  LZ4_LONG_DELTA,
+  ZSTD_DICT,
+  INT_SPARSE,
+  REAL_SPARSE,
+  LONG_SPARSE,
+  LZ4HC,
+  LZ4HC_SHUF4,
+  LZ4HC_SHUF8
 };
 
 
@@ -87,13 +137,32 @@ extern unsigned int fixedRatioSourceRepSize[NR_OF_ALGORITHMS];
 // Target data minimum repeat length
 extern unsigned int fixedRatioTargetRepSize[NR_OF_ALGORITHMS];
 
+// Alignment in bytes of the output of the decompression routine of each algorithm: 1 for routines that write bytes,
+// 4 for routines that write 4-byte integers and 8 for routines that write 8-byte words
+extern unsigned int decompAlignment[NR_OF_ALGORITHMS];
+
 
 class Decompressor
 {
+private:
+  ZSTD_DDict* dictionary = nullptr;
+
 public:
   Decompressor() {};
 
-  ~Decompressor() { };
+  ~Decompressor();
+
+  Decompressor(const Decompressor&) = delete;
+  Decompressor& operator=(const Decompressor&) = delete;
+
+  /**
+   Set the dictionary used for decompressing ZSTD_DICT blocks. The dictionary is digested once, so it can be used for
+   all blocks of a column.
+
+   @param dictBuffer Dictionary content.
+   @param dictSize Size of the dictionary in bytes.
+   */
+  void SetDictionary(const char* dictBuffer, unsigned int dictSize);
 
   int Decompress(unsigned int algo, char* dst, unsigned int dstCapacity, const char* src, unsigned int compressedSize);
 };
@@ -108,6 +177,12 @@ public:
   virtual int Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm) = 0;
   virtual int CompressBufferSize(int maxBlockSize) = 0;
 
+  /**
+   A stateless compressor gives a result that only depends on the block being compressed, so different
+   blocks can be compressed concurrently (and in any order).
+  */
+  virtual bool IsStateless() { return true; }
+
   virtual ~Compressor() {}
 };
 
@@ -215,6 +290,265 @@ public:
 
   int CompressBufferSize(int maxBlockSize);
 
+  // The selected algorithm depends on the results of previous blocks
+  bool IsStateless() { return false; }
+
+  /**
+  Compress src into dst using compressionLevel (0 - 100)
+
+  @param dst Destination buffer
+  @param dstCapacity Size of destination buffer
+  @param src Source buffer
+  @param srcSize Size of source buffer
+  @return Resulting number of bytes in the compressed data
+  */
+  int Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm);
+};
+
+
+
+#define BITPACK_MAX_WIDTH 24  // maximum bit width of the codes of a bit-packed block
+
+/**
+ A compressor for integer vectors that stores a block as frame of reference codes (algorithm INT_BITPACK,
+ LZ4_INT_BITPACK or ZSTD_INT_BITPACK) if the codes are at most BITPACK_MAX_WIDTH bits wide. Blocks with a wider
+ range of values are compressed with a fallback algorithm. Vectors of 64-bit integers (algorithm LONG_BITPACK,
+ LZ4_LONG_BITPACK or ZSTD_LONG_BITPACK) are packed if the codes fit 32 bits.
+*/
+class BitPackCompressor : public Compressor
+{
+private:
+  CompAlgorithm a1, a2;
+  CompAlgo algo1, algo2;
+  int compLevel;
+  bool isLong;
+
+public:
+
+  /**
+   Constructor for a bit packing compressor.
+
+   @param packAlgo Bit packing compression algorithm.
+   @param fallbackAlgo Compression algorithm for blocks with a wide range of values.
+   @param compressionLevel Level of compression of both algorithms.
+   */
+  BitPackCompressor(CompAlgo packAlgo, CompAlgo fallbackAlgo, int compressionLevel);
+
+  int CompressBufferSize(int maxBlockSize);
+
+  /**
+  Compress src into dst using compressionLevel (0 - 100)
+
+  @param dst Destination buffer
+  @param dstCapacity Size of destination buffer
+  @param src Source buffer
+  @param srcSize Size of source buffer
+  @return Resulting number of bytes in the compressed data
+  */
+  int Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm);
+};
+
+
+
+#define DELTA_MAX_WIDTH 24  // maximum bit width of the codes of a delta encoded block
+
+/**
+ A compressor that delta encodes blocks of sorted keys or timestamps (algorithm INT_DELTA, LZ4_INT_DELTA,
+ REAL_DELTA, LZ4_REAL_DELTA, LONG_DELTA or LZ4_LONG_DELTA). A block is delta encoded if its values are
+ non-decreasing and the codes are at most DELTA_MAX_WIDTH bits wide, other blocks are compressed by a fallback
+ compressor.
+*/
+class DeltaCompressor : public Compressor
+{
+private:
+  CompAlgorithm a1;
+  CompAlgo algo1;
+  Compressor* fallback;
+  int compLevel;
+  bool isReal;
+  bool isLong;
+
+public:
+
+  /**
+   Constructor for a delta compressor.
+
+   @param deltaAlgo Delta compression algorithm.
+   @param fallbackCompressor Compressor for blocks that are not delta encoded (not owned by the delta compressor).
+   @param compressionLevel Level of compression of the delta algorithm.
+   */
+  DeltaCompressor(CompAlgo deltaAlgo, Compressor* fallbackCompressor, int compressionLevel);
+
+  int CompressBufferSize(int maxBlockSize);
+
+  bool IsStateless() { return fallback->IsStateless(); }
+
+  /**
+  Compress src into dst using compressionLevel (0 - 100)
+
+  @param dst Destination buffer
+  @param dstCapacity Size of destination buffer
+  @param src Source buffer
+  @param srcSize Size of source buffer
+  @return Resulting number of bytes in the compressed data
+  */
+  int Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm);
+};
+
+
+
+#define RLE_MIN_RUN_LENGTH 32  // minimum average run length of a run-length encoded block
+
+/**
+ A compressor that run-length encodes blocks of integers with long runs of equal values (algorithm INT_RLE). A block
+ is run-length encoded if its average run length is at least RLE_MIN_RUN_LENGTH, other blocks are compressed by a
+ fallback compressor.
+*/
+class RleCompressor : public Compressor
+{
+private:
+  Compressor* fallback;
+
+public:
+
+  /**
+   Constructor for a run-length compressor.
+
+   @param fallbackCompressor Compressor for blocks with short runs (not owned by the run-length compressor).
+   */
+  RleCompressor(Compressor* fallbackCompressor);
+
+  int CompressBufferSize(int maxBlockSize);
+
+  bool IsStateless() { return fallback->IsStateless(); }
+
+  /**
+  Compress src into dst using compressionLevel (0 - 100)
+
+  @param dst Destination buffer
+  @param dstCapacity Size of destination buffer
+  @param src Source buffer
+  @param srcSize Size of source buffer
+  @return Resulting number of bytes in the compressed data
+  */
+  int Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm);
+};
+
+
+
+#define SPARSE_MAX_DENSITY 16  // a block is sparse encoded if at most one in SPARSE_MAX_DENSITY values is not NA
+
+/**
+ A compressor for blocks that consist mostly of NA values, such as wide feature columns (algorithm INT_SPARSE,
+ REAL_SPARSE or LONG_SPARSE). Blocks with at most one non-NA value in every SPARSE_MAX_DENSITY elements are stored
+ as a presence bitmap and the non-NA values, other blocks are compressed by a fallback compressor.
+*/
+class SparseCompressor : public Compressor
+{
+private:
+  CompAlgo algo;
+  Compressor* fallback;
+  unsigned int elementSize;
+  unsigned long long naBits;
+
+public:
+
+  /**
+   Constructor for a sparse compressor.
+
+   @param sparseAlgo INT_SPARSE for integer, REAL_SPARSE for double and LONG_SPARSE for 64-bit integer columns.
+   @param fallbackCompressor Compressor for blocks with more values (not owned by the sparse compressor).
+   */
+  SparseCompressor(CompAlgo sparseAlgo, Compressor* fallbackCompressor);
+
+  int CompressBufferSize(int maxBlockSize);
+
+  bool IsStateless() { return fallback->IsStateless(); }
+
+  /**
+  Compress src into dst using compressionLevel (0 - 100)
+
+  @param dst Destination buffer
+  @param dstCapacity Size of destination buffer
+  @param src Source buffer
+  @param srcSize Size of source buffer
+  @return Resulting number of bytes in the compressed data
+  */
+  int Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm);
+};
+
+
+
+/**
+ A compressor for double vectors that stores a block of integer valued doubles (or decimals with a fixed number of
+ digits) as integer codes (algorithm REAL_INT, LZ4_REAL_INT or ZSTD_REAL_INT). Other blocks are compressed by a
+ fallback compressor.
+*/
+class RealIntCompressor : public Compressor
+{
+private:
+  CompAlgorithm a1;
+  CompAlgo algo1;
+  Compressor* fallback;
+  int compLevel;
+
+public:
+
+  /**
+   Constructor for an integer valued doubles compressor.
+
+   @param intAlgo Compression algorithm for blocks that can be converted to integers.
+   @param fallbackCompressor Compressor for other blocks (not owned by the compressor).
+   @param compressionLevel Level of compression of the integer algorithm.
+   */
+  RealIntCompressor(CompAlgo intAlgo, Compressor* fallbackCompressor, int compressionLevel);
+
+  int CompressBufferSize(int maxBlockSize);
+
+  bool IsStateless() { return fallback->IsStateless(); }
+
+  /**
+  Compress src into dst using compressionLevel (0 - 100)
+
+  @param dst Destination buffer
+  @param dstCapacity Size of destination buffer
+  @param src Source buffer
+  @param srcSize Size of source buffer
+  @return Resulting number of bytes in the compressed data
+  */
+  int Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm);
+};
+
+
+
+/**
+ A ZSTD compressor that splits large blocks into sections that are compressed concurrently by a pool of worker
+ threads. The result is a regular ZSTD frame, so ZSTDMT blocks are decompressed with the single threaded ZSTD
+ decompressor. The worker pool is owned by the compressor, so it should only be used by a single thread.
+*/
+class ZstdMtCompressor : public Compressor
+{
+private:
+  ZSTDMT_CCtx* mtContext;
+  int compLevel;
+
+public:
+
+  /**
+   Constructor for a multithreaded ZSTD compressor.
+
+   @param compressionLevel Level of compression (0 - 100).
+   @param nrOfThreads Number of worker threads.
+   */
+  ZstdMtCompressor(int compressionLevel, int nrOfThreads);
+
+  ~ZstdMtCompressor();
+
+  int CompressBufferSize(int maxBlockSize);
+
+  // The worker pool can compress a single block at a time
+  bool IsStateless() { return false; }
+
   /**
   Compress src into dst using compressionLevel (0 - 100)
 
@@ -229,10 +563,121 @@ public:
 
 
 
+/**
+ ZSTD compressor that uses a dictionary shared by all blocks of a column. Small blocks with a common vocabulary (such
+ as the strings of a character column) compress much better when earlier content can be referenced. The dictionary
+ is digested once and only read during compression, so blocks can be compressed concurrently.
+*/
+class ZstdDictCompressor : public Compressor
+{
+private:
+  ZSTD_CDict* dictionary;
+
+public:
+
+  /**
+   Constructor for a dictionary based ZSTD compressor.
+
+   @param dictBuffer Dictionary content, stored with the column data for decompression.
+   @param dictSize Size of the dictionary in bytes.
+   @param compressionLevel Level of compression (0 - 100).
+   */
+  ZstdDictCompressor(const char* dictBuffer, unsigned int dictSize, int compressionLevel);
+
+  ~ZstdDictCompressor();
+
+  int CompressBufferSize(int maxBlockSize);
+
+  int Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm);
+};
+
+
+/**
+ Goal of an adaptive compressor. If minSpeed is larger than zero, each block is compressed with the candidate
+ that has the highest compression ratio at a speed of at least minSpeed MB/s. Otherwise the fastest candidate with
+ a compression ratio of at least minRatio is used (or the candidate with the highest ratio if none qualifies).
+*/
+class CompressionGoal
+{
+public:
+  double minSpeed;  // minimum compression speed in MB/s
+  double minRatio;  // minimum compression ratio (uncompressed size / compressed size)
+
+  CompressionGoal(double minSpeed, double minRatio) : minSpeed(minSpeed), minRatio(minRatio) {}
+};
+
+
+/**
+ A compressor that selects an algorithm per block from a set of candidates to meet a CompressionGoal. Every
+ ADAPTIVE_PROBE_INTERVAL blocks, a probe block is compressed with all candidates, measuring the compression ratio and
+ speed of each. Blocks in between use the best candidate according to the running averages of these measurements,
+ which are updated with the results of every block. Storing a block uncompressed is always a candidate, so
+ incompressible data costs (almost) no compression time.
+
+ The measurements are shared by all threads, so blocks can be compressed concurrently. As the selection depends on
+ the measured speed, the file contents can differ between runs.
+*/
+class AdaptiveCompressor : public Compressor
+{
+private:
+  std::vector<CompAlgo> algos;
+  std::vector<int> compLevels;
+  std::vector<double> ratios;  // running average of the compression ratio of each candidate
+  std::vector<double> speeds;  // running average of the compression speed of each candidate (MB/s)
+  double minSpeed, minRatio;
+  unsigned int blockCount;
+  int selected;  // candidate used for blocks that are not probed
+
+  int SelectCandidate(const double* candidateRatios, const double* candidateSpeeds) const;
+
+public:
+
+  /**
+   Constructor for an adaptive compressor, the only initial candidate is storing blocks uncompressed.
+
+   @param goal Target of the algorithm selection.
+   */
+  AdaptiveCompressor(const CompressionGoal &goal);
+
+  /**
+   Add a candidate algorithm.
+
+   @param algo Compression algorithm, fixed ratio algorithms are not supported.
+   @param compressionLevel Level of compression (0 - 100).
+   */
+  void AddCandidate(CompAlgo algo, int compressionLevel);
+
+  int CompressBufferSize(int maxBlockSize);
+
+  // Blocks can be compressed concurrently, the measurements are shared under a lock
+  bool IsStateless() { return true; }
+
+  /**
+  Compress src into dst with the selected candidate, or with all candidates if the block is a probe block
+
+  @param dst Destination buffer
+  @param dstCapacity Size of destination buffer
+  @param src Source buffer
+  @param srcSize Size of source buffer
+  @return Resulting number of bytes in the compressed data
+  */
+  int Compress(char* dst, unsigned int dstCapacity, const char* src,  unsigned int srcSize, CompAlgo &compAlgorithm);
+};
+
+
+
 class StreamCompressor
 {
 public:
-  virtual int Compress(std::ofstream &myfile, const char* src, unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm) = 0;
+  virtual int Compress(std::ostream &myfile, const char* src, unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm) = 0;
+
+  /**
+   Select the compressor for the next block in the stream. The selection sequence only depends on the number of
+   blocks processed, so blocks can be assigned to compressors first and compressed concurrently afterwards.
+
+   @return Compressor to use for the next block or nullptr if the block should be stored uncompressed.
+  */
+  virtual Compressor* NextBlockCompressor() = 0;
 
   virtual int CompressBufferSize(unsigned int srcSize) = 0;
   virtual int CompressBufferSize() = 0;
@@ -249,7 +694,9 @@ class StreamFixedCompressor : StreamCompressor
 {
 public:
 
-  int Compress(std::ofstream &myfile, const char* src,  unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm);
+  int Compress(std::ostream &myfile, const char* src,  unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm);
+
+  Compressor* NextBlockCompressor() { return nullptr; }
 };
 
 
@@ -288,14 +735,16 @@ public:
     Compress src to myfile. Buffer compBuf can be used as a buffer if required.
     Make sure it is at least CompressBufferSize() long.
 
-    @param myfile ofstream to which you want to write the compressed data.
+    @param myfile stream to which you want to write the compressed data.
     @param src Source data.
     @param srcSize Size of the source data (in bytes).
     @param compBuf Buffer to store temporary data.
     @param compAlgorithm Algorithm that was used for compressing the data.
   */
 
-  int Compress(std::ofstream &myfile, const char* src,  unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm);
+  int Compress(std::ostream &myfile, const char* src,  unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm);
+
+  Compressor* NextBlockCompressor();
 };
 
 
@@ -328,13 +777,15 @@ public:
     Compress src to myfile. Buffer compBuf can be used as a buffer if required.
     Make sure it is at least CompressBufferSize() long.
 
-    @param myfile ofstream to which you want to write the compressed data.
+    @param myfile stream to which you want to write the compressed data.
     @param src Source data.
     @param srcSize Size of the source data (in bytes).
     @param compBuf Buffer to store temporary data.
     @param compAlgorithm Algorithm that was used for compression.
   */
-  int Compress(std::ofstream &myfile, const char* src, unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm);
+  int Compress(std::ostream &myfile, const char* src, unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm);
+
+  Compressor* NextBlockCompressor();
 };
 
 
@@ -377,13 +828,15 @@ public:
     Compress src to myfile. Buffer compBuf can be used as a buffer if required.
     Make sure it is at least CompressBufferSize() long.
 
-    @param myfile ofstream to which you want to write the compressed data.
+    @param myfile stream to which you want to write the compressed data.
     @param src Source data.
     @param srcSize Size of the source data (in bytes).
     @param compBuf Buffer to store temporary data.
     @param compAlgorithm Algorithm that was used for compression.
   */
-  int Compress(std::ofstream &myfile, const char* src,  unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm);
+  int Compress(std::ostream &myfile, const char* src,  unsigned int srcSize, char* compBuf, CompAlgo &compAlgorithm);
+
+  Compressor* NextBlockCompressor();
 };
 
 
@@ -0,0 +1,261 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#include "lz4chain.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+
+// Parameters of the LZ4 block format
+#define LZ4_MIN_MATCH      4
+#define LZ4_LAST_LITERALS  5      // the last bytes of a block are always literals
+#define LZ4_MATCH_MARGIN   12     // the last match starts at least this number of bytes before the end of a block
+#define LZ4_MAX_DISTANCE   65535  // largest offset of a match
+#define LZ4_RUN_MASK       15     // largest length stored in the token
+
+#define LZ4_CHAIN_HASH_LOG 16     // maximum number of bits of the hash table index
+
+
+inline unsigned int Read32(const unsigned char* p)
+{
+  unsigned int value;
+  memcpy(&value, p, 4);
+  return value;
+}
+
+
+// Number of equal bytes at pos and match, ending before limit
+inline unsigned int MatchLength(const unsigned char* pos, const unsigned char* match, const unsigned char* limit)
+{
+  const unsigned char* start = pos;
+
+  while (pos + 8 <= limit)
+  {
+    unsigned long long value1, value2;
+    memcpy(&value1, pos, 8);
+    memcpy(&value2, match, 8);
+
+    unsigned long long diff = value1 ^ value2;
+    if (diff != 0) return (unsigned int) (pos - start) + (__builtin_ctzll(diff) >> 3);  // little endian
+
+    pos += 8;
+    match += 8;
+  }
+
+  while (pos < limit && *pos == *match)
+  {
+    ++pos;
+    ++match;
+  }
+
+  return (unsigned int) (pos - start);
+}
+
+
+// Hash chains of all positions of a block: head holds the last position with a given hash of its first 4 bytes,
+// chain the previous position with the same hash. Positions are inserted up to the position searched.
+class ChainMatcher
+{
+  const unsigned char* src;
+  vector<int> head;
+  vector<int> chain;
+  unsigned int hashShift;
+  unsigned int maxAttempts;
+  int nextPos;  // next position to insert
+
+  unsigned int Hash(int pos) const { return (Read32(&src[pos]) * 2654435761U) >> hashShift; }
+
+public:
+  ChainMatcher(const unsigned char* src, unsigned int srcSize, unsigned int maxAttempts) :
+    src(src), chain(srcSize), maxAttempts(maxAttempts), nextPos(0)
+  {
+    // The hash table grows with the block size, so small blocks are cheap to initialize
+    unsigned int hashLog = 10;
+    while (hashLog < LZ4_CHAIN_HASH_LOG && (1U << hashLog) < srcSize) ++hashLog;
+
+    head.assign(1U << hashLog, -1);
+    hashShift = 32 - hashLog;
+  }
+
+  // Longest match of the bytes at pos ending before limit, returns the match length (0 if there is no match of
+  // at least LZ4_MIN_MATCH bytes) and its position in matchPos
+  unsigned int Find(int pos, const unsigned char* limit, int &matchPos)
+  {
+    for (; nextPos < pos; ++nextPos)
+    {
+      unsigned int hash = Hash(nextPos);
+      chain[nextPos] = head[hash];
+      head[hash] = nextPos;
+    }
+
+    const unsigned char* current = &src[pos];
+    unsigned int maxLength = (unsigned int) (limit - current);
+    unsigned int bestLength = LZ4_MIN_MATCH - 1;
+    unsigned int sequence = Read32(current);
+
+    int candidate = head[Hash(pos)];
+
+    for (unsigned int attempt = 0; attempt < maxAttempts && candidate >= 0; ++attempt)
+    {
+      if (pos - candidate > LZ4_MAX_DISTANCE) break;
+
+      const unsigned char* match = &src[candidate];
+
+      // Only candidates that can improve on the best match are compared in full
+      if (match[bestLength] == current[bestLength] && Read32(match) == sequence)
+      {
+        unsigned int length = MatchLength(current, match, limit);
+
+        if (length > bestLength)
+        {
+          bestLength = length;
+          matchPos = candidate;
+
+          if (length == maxLength) break;
+        }
+      }
+
+      candidate = chain[candidate];
+    }
+
+    return bestLength >= LZ4_MIN_MATCH ? bestLength : 0;
+  }
+};
+
+
+inline unsigned char* WriteLength(unsigned char* op, unsigned int length)
+{
+  for (length -= LZ4_RUN_MASK; length >= 255; length -= 255)
+  {
+    *op++ = 255;
+  }
+
+  *op++ = (unsigned char) length;
+
+  return op;
+}
+
+
+// Append a sequence of literals, optionally followed by a match. Returns nullptr if the sequence doesn't fit.
+static unsigned char* WriteSequence(unsigned char* op, const unsigned char* opEnd, const unsigned char* literals,
+  unsigned int nrOfLiterals, unsigned int offset, unsigned int matchLength)
+{
+  unsigned int matchCode = matchLength == 0 ? 0 : matchLength - LZ4_MIN_MATCH;
+
+  // token, literal length, literals, offset and match length
+  unsigned long long maxSize = 1 + nrOfLiterals / 255 + 1 + nrOfLiterals + 2 + matchCode / 255 + 1;
+  if (maxSize > (unsigned long long) (opEnd - op)) return nullptr;
+
+  unsigned char* token = op++;
+  *token = (unsigned char) ((nrOfLiterals < LZ4_RUN_MASK ? nrOfLiterals : LZ4_RUN_MASK) << 4);
+
+  if (nrOfLiterals >= LZ4_RUN_MASK) op = WriteLength(op, nrOfLiterals);
+
+  memcpy(op, literals, nrOfLiterals);
+  op += nrOfLiterals;
+
+  if (matchLength == 0) return op;  // last literals
+
+  *op++ = (unsigned char) offset;
+  *op++ = (unsigned char) (offset >> 8);
+
+  *token |= (unsigned char) (matchCode < LZ4_RUN_MASK ? matchCode : LZ4_RUN_MASK);
+
+  if (matchCode >= LZ4_RUN_MASK) op = WriteLength(op, matchCode);
+
+  return op;
+}
+
+
+unsigned int LZ4ChainCompress(const char* source, char* dest, unsigned int srcSize, unsigned int dstCapacity,
+  int compressionLevel)
+{
+  const unsigned char* src = (const unsigned char*) source;
+  unsigned char* op = (unsigned char*) dest;
+  const unsigned char* opEnd = op + dstCapacity;
+
+  int anchor = 0;  // first literal of the current sequence
+
+  if (srcSize > LZ4_MATCH_MARGIN)
+  {
+    // Search depth doubles every 20 levels
+    unsigned int maxAttempts = LZ4_CHAIN_MIN_ATTEMPTS << (compressionLevel < 0 ? 0 : compressionLevel / 20);
+    if (maxAttempts > LZ4_CHAIN_MAX_ATTEMPTS) maxAttempts = LZ4_CHAIN_MAX_ATTEMPTS;
+
+    ChainMatcher matcher(src, srcSize, maxAttempts);
+
+    int lastMatchPos = (int) (srcSize - LZ4_MATCH_MARGIN);
+    const unsigned char* limit = &src[srcSize - LZ4_LAST_LITERALS];
+    int pos = 0;
+
+    while (pos <= lastMatchPos)
+    {
+      int matchPos;
+      unsigned int matchLength = matcher.Find(pos, limit, matchPos);
+
+      if (matchLength == 0)
+      {
+        ++pos;
+        continue;
+      }
+
+      // Lazy evaluation: a longer match at the next position is preferred over the current match
+      while (pos < lastMatchPos)
+      {
+        int nextMatchPos;
+        unsigned int nextLength = matcher.Find(pos + 1, limit, nextMatchPos);
+
+        if (nextLength <= matchLength) break;
+
+        ++pos;
+        matchLength = nextLength;
+        matchPos = nextMatchPos;
+      }
+
+      op = WriteSequence(op, opEnd, &src[anchor], pos - anchor, pos - matchPos, matchLength);
+      if (op == nullptr) return 0;
+
+      pos += matchLength;
+      anchor = pos;
+    }
+  }
+
+  op = WriteSequence(op, opEnd, &src[anchor], srcSize - anchor, 0, 0);
+  if (op == nullptr) return 0;
+
+  return (unsigned int) (op - (unsigned char*) dest);
+}
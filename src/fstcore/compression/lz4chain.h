@@ -0,0 +1,56 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef LZ4_CHAIN_H
+#define LZ4_CHAIN_H
+
+
+// A high compression encoder of the LZ4 block format. Matches are searched in hash chains over the full 64 kB
+// window with lazy evaluation of the next position, which gives a better ratio than LZ4_compress_fast at a much
+// lower compression speed. The result is a regular LZ4 block that is decoded with LZ4_decompress_fast at the usual
+// LZ4 speed. The search depth increases with compressionLevel (0 - 100) from LZ4_CHAIN_MIN_ATTEMPTS to
+// LZ4_CHAIN_MAX_ATTEMPTS candidates per position.
+
+#define LZ4_CHAIN_MIN_ATTEMPTS 16
+#define LZ4_CHAIN_MAX_ATTEMPTS 512
+
+
+// Compress srcSize bytes of src into dst. Returns the size of the compressed block, or zero if it doesn't fit in
+// dstCapacity bytes (LZ4_COMPRESSBOUND(srcSize) bytes always suffice).
+unsigned int LZ4ChainCompress(const char* src, char* dst, unsigned int srcSize, unsigned int dstCapacity,
+  int compressionLevel);
+
+
+#endif  // LZ4_CHAIN_H
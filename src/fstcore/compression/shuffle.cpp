@@ -0,0 +1,239 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#include "shuffle.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define SHUFFLE_X86
+  #include <immintrin.h>
+#elif defined(__aarch64__)
+  #define SHUFFLE_NEON
+  #include <arm_neon.h>
+#endif
+
+
+// Byte shuffle masks of the kernels in shufflekernels.h
+
+static const unsigned char SHUFFLE_REAL_MASK[16] = { 15, 7, 14, 6, 13, 5, 12, 4, 11, 3, 10, 2, 9, 1, 8, 0 };
+static const unsigned char DESHUFFLE_REAL_MASK[16] = { 15, 13, 11, 9, 7, 5, 3, 1, 14, 12, 10, 8, 6, 4, 2, 0 };
+static const int SHUFFLE_REAL_PAIRS[8] = { 3, 2, 1, 0, 7, 6, 5, 4 };  // order in which the pairs of doubles are loaded
+
+static const unsigned char SHUFFLE_INT2_MASK[16] = { 11, 3, 15, 7, 10, 2, 14, 6, 9, 1, 13, 5, 8, 0, 12, 4 };
+static const unsigned char DESHUFFLE_INT2_MASK[16] = { 13, 9, 5, 1, 15, 11, 7, 3, 12, 8, 4, 0, 14, 10, 6, 2 };
+static const unsigned char SPLIT_WORDS_MASK[16] = { 0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15 };
+
+
+typedef int (*ShuffleKernel)(const char* inVec, char* outVec, int nrOfBlocks);
+
+
+#ifdef SHUFFLE_X86
+
+namespace Ssse3
+{
+  #define SIMD_TARGET __attribute__((target("ssse3")))
+  #define LANES 1
+
+  typedef __m128i Vec;
+
+  SIMD_TARGET inline Vec LoadVec(const char* src) { return _mm_loadu_si128((const __m128i*) src); }
+  SIMD_TARGET inline void StoreVec(char* dst, Vec vec) { _mm_storeu_si128((__m128i*) dst, vec); }
+  SIMD_TARGET inline Vec LoadLanes(const char* src, int) { return LoadVec(src); }
+  SIMD_TARGET inline void StoreLanes(char* dst, Vec vec, int) { StoreVec(dst, vec); }
+  SIMD_TARGET inline Vec LoadMask(const unsigned char* mask) { return LoadVec((const char*) mask); }
+  SIMD_TARGET inline Vec ByteShuffle(Vec vec, Vec mask) { return _mm_shuffle_epi8(vec, mask); }
+  SIMD_TARGET inline Vec ZipLo16(Vec a, Vec b) { return _mm_unpacklo_epi16(a, b); }
+  SIMD_TARGET inline Vec ZipHi16(Vec a, Vec b) { return _mm_unpackhi_epi16(a, b); }
+  SIMD_TARGET inline Vec ZipLo32(Vec a, Vec b) { return _mm_unpacklo_epi32(a, b); }
+  SIMD_TARGET inline Vec ZipHi32(Vec a, Vec b) { return _mm_unpackhi_epi32(a, b); }
+  SIMD_TARGET inline Vec ZipLo64(Vec a, Vec b) { return _mm_unpacklo_epi64(a, b); }
+  SIMD_TARGET inline Vec ZipHi64(Vec a, Vec b) { return _mm_unpackhi_epi64(a, b); }
+
+  #include "shufflekernels.h"
+
+  #undef SIMD_TARGET
+  #undef LANES
+}
+
+
+namespace Avx2
+{
+  #define SIMD_TARGET __attribute__((target("avx2")))
+  #define LANES 2
+
+  typedef __m256i Vec;
+
+  SIMD_TARGET inline Vec LoadVec(const char* src) { return _mm256_loadu_si256((const __m256i*) src); }
+  SIMD_TARGET inline void StoreVec(char* dst, Vec vec) { _mm256_storeu_si256((__m256i*) dst, vec); }
+
+  SIMD_TARGET inline Vec LoadLanes(const char* src, int laneStride)
+  {
+    __m256i vec = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*) src));
+    return _mm256_inserti128_si256(vec, _mm_loadu_si128((const __m128i*) (src + laneStride)), 1);
+  }
+
+  SIMD_TARGET inline void StoreLanes(char* dst, Vec vec, int laneStride)
+  {
+    _mm_storeu_si128((__m128i*) dst, _mm256_castsi256_si128(vec));
+    _mm_storeu_si128((__m128i*) (dst + laneStride), _mm256_extracti128_si256(vec, 1));
+  }
+
+  SIMD_TARGET inline Vec LoadMask(const unsigned char* mask)
+  {
+    return _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) mask));
+  }
+
+  SIMD_TARGET inline Vec ByteShuffle(Vec vec, Vec mask) { return _mm256_shuffle_epi8(vec, mask); }
+  SIMD_TARGET inline Vec ZipLo16(Vec a, Vec b) { return _mm256_unpacklo_epi16(a, b); }
+  SIMD_TARGET inline Vec ZipHi16(Vec a, Vec b) { return _mm256_unpackhi_epi16(a, b); }
+  SIMD_TARGET inline Vec ZipLo32(Vec a, Vec b) { return _mm256_unpacklo_epi32(a, b); }
+  SIMD_TARGET inline Vec ZipHi32(Vec a, Vec b) { return _mm256_unpackhi_epi32(a, b); }
+  SIMD_TARGET inline Vec ZipLo64(Vec a, Vec b) { return _mm256_unpacklo_epi64(a, b); }
+  SIMD_TARGET inline Vec ZipHi64(Vec a, Vec b) { return _mm256_unpackhi_epi64(a, b); }
+
+  #include "shufflekernels.h"
+
+  #undef SIMD_TARGET
+  #undef LANES
+}
+
+#endif  // SHUFFLE_X86
+
+
+#ifdef SHUFFLE_NEON
+
+namespace Neon
+{
+  #define SIMD_TARGET
+  #define LANES 1
+
+  typedef uint8x16_t Vec;
+
+  inline Vec LoadVec(const char* src) { return vld1q_u8((const uint8_t*) src); }
+  inline void StoreVec(char* dst, Vec vec) { vst1q_u8((uint8_t*) dst, vec); }
+  inline Vec LoadLanes(const char* src, int) { return LoadVec(src); }
+  inline void StoreLanes(char* dst, Vec vec, int) { StoreVec(dst, vec); }
+  inline Vec LoadMask(const unsigned char* mask) { return vld1q_u8(mask); }
+  inline Vec ByteShuffle(Vec vec, Vec mask) { return vqtbl1q_u8(vec, mask); }
+  inline Vec ZipLo16(Vec a, Vec b) { return vreinterpretq_u8_u16(vzip1q_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b))); }
+  inline Vec ZipHi16(Vec a, Vec b) { return vreinterpretq_u8_u16(vzip2q_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b))); }
+  inline Vec ZipLo32(Vec a, Vec b) { return vreinterpretq_u8_u32(vzip1q_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b))); }
+  inline Vec ZipHi32(Vec a, Vec b) { return vreinterpretq_u8_u32(vzip2q_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b))); }
+  inline Vec ZipLo64(Vec a, Vec b) { return vreinterpretq_u8_u64(vzip1q_u64(vreinterpretq_u64_u8(a), vreinterpretq_u64_u8(b))); }
+  inline Vec ZipHi64(Vec a, Vec b) { return vreinterpretq_u8_u64(vzip2q_u64(vreinterpretq_u64_u8(a), vreinterpretq_u64_u8(b))); }
+
+  #include "shufflekernels.h"
+
+  #undef SIMD_TARGET
+  #undef LANES
+}
+
+#endif  // SHUFFLE_NEON
+
+
+// Used when the CPU has no supported instruction set, all blocks are left to the scalar code
+static int NoKernel(const char*, char*, int)
+{
+  return 0;
+}
+
+
+class ShuffleKernels
+{
+public:
+  ShuffleKernel shuffleReal = NoKernel;
+  ShuffleKernel deshuffleReal = NoKernel;
+  ShuffleKernel shuffleInt2 = NoKernel;
+  ShuffleKernel deshuffleInt2 = NoKernel;
+
+  ShuffleKernels()
+  {
+#ifdef SHUFFLE_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+      shuffleReal = Avx2::ShuffleReal;
+      deshuffleReal = Avx2::DeshuffleReal;
+      shuffleInt2 = Avx2::ShuffleInt2;
+      deshuffleInt2 = Avx2::DeshuffleInt2;
+    }
+    else if (__builtin_cpu_supports("ssse3"))
+    {
+      shuffleReal = Ssse3::ShuffleReal;
+      deshuffleReal = Ssse3::DeshuffleReal;
+      shuffleInt2 = Ssse3::ShuffleInt2;
+      deshuffleInt2 = Ssse3::DeshuffleInt2;
+    }
+#endif
+
+#ifdef SHUFFLE_NEON
+    shuffleReal = Neon::ShuffleReal;
+    deshuffleReal = Neon::DeshuffleReal;
+    shuffleInt2 = Neon::ShuffleInt2;
+    deshuffleInt2 = Neon::DeshuffleInt2;
+#endif
+  }
+};
+
+// Kernels are selected on first use
+static inline const ShuffleKernels &SelectedKernels()
+{
+  static const ShuffleKernels shuffleKernels;
+
+  return shuffleKernels;
+}
+
+
+int SimdShuffleReal(const char* inVec, char* outVec, int nrOfBlocks)
+{
+  return SelectedKernels().shuffleReal(inVec, outVec, nrOfBlocks);
+}
+
+
+int SimdDeshuffleReal(const char* inVec, char* outVec, int nrOfBlocks)
+{
+  return SelectedKernels().deshuffleReal(inVec, outVec, nrOfBlocks);
+}
+
+
+int SimdShuffleInt2(const char* inVec, char* outVec, int nrOfBlocks)
+{
+  return SelectedKernels().shuffleInt2(inVec, outVec, nrOfBlocks);
+}
+
+
+int SimdDeshuffleInt2(const char* inVec, char* outVec, int nrOfBlocks)
+{
+  return SelectedKernels().deshuffleInt2(inVec, outVec, nrOfBlocks);
+}
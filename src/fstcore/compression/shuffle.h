@@ -0,0 +1,55 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef SHUFFLE_H
+#define SHUFFLE_H
+
+
+// Vectorized versions of the byte shuffles of compression.cpp. The kernel is selected at runtime from the
+// instruction sets supported by the CPU (AVX2, SSSE3 or NEON). Each method processes the leading blocks of 8
+// elements (of the nrOfBlocks blocks in the vector) and returns the number of blocks processed, which is zero
+// if no kernel is available. The remaining blocks are left to the scalar code, at the same positions in the
+// byte planes, so the shuffled layout is identical for all kernels.
+
+int SimdShuffleReal(const char* inVec, char* outVec, int nrOfBlocks);
+
+int SimdDeshuffleReal(const char* inVec, char* outVec, int nrOfBlocks);
+
+int SimdShuffleInt2(const char* inVec, char* outVec, int nrOfBlocks);
+
+int SimdDeshuffleInt2(const char* inVec, char* outVec, int nrOfBlocks);
+
+
+#endif  // SHUFFLE_H
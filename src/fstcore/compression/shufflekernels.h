@@ -0,0 +1,209 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+// Shuffle kernels, written once for all instruction sets. This file has no include guard: shuffle.cpp includes
+// it once for each instruction set, in a separate namespace that defines:
+//
+// SIMD_TARGET: function attribute that enables the instruction set
+// LANES: number of 128-bit lanes in a Vec
+// Vec: vector type of LANES lanes
+// LoadVec / StoreVec: unaligned load and store of a Vec
+// LoadLanes / StoreLanes: load or store lane l at position l * laneStride
+// LoadMask: a 16 byte mask repeated in each lane
+// ByteShuffle: shuffle the bytes of each lane with a mask (pshufb)
+// ZipLo16 ... ZipHi64: interleave the low or high halves of each lane (punpckl / punpckh)
+//
+// A lane holds two blocks (of 8 doubles or 8 integers) of the scalar shuffle, so a single iteration processes
+// 2 * LANES blocks.
+
+
+// Transpose an 8 x 8 matrix of 16-bit words in each lane
+SIMD_TARGET inline void Transpose16(Vec* a)
+{
+  Vec b0 = ZipLo16(a[0], a[1]);
+  Vec b1 = ZipHi16(a[0], a[1]);
+  Vec b2 = ZipLo16(a[2], a[3]);
+  Vec b3 = ZipHi16(a[2], a[3]);
+  Vec b4 = ZipLo16(a[4], a[5]);
+  Vec b5 = ZipHi16(a[4], a[5]);
+  Vec b6 = ZipLo16(a[6], a[7]);
+  Vec b7 = ZipHi16(a[6], a[7]);
+
+  Vec c0 = ZipLo32(b0, b2);
+  Vec c1 = ZipHi32(b0, b2);
+  Vec c2 = ZipLo32(b1, b3);
+  Vec c3 = ZipHi32(b1, b3);
+  Vec c4 = ZipLo32(b4, b6);
+  Vec c5 = ZipHi32(b4, b6);
+  Vec c6 = ZipLo32(b5, b7);
+  Vec c7 = ZipHi32(b5, b7);
+
+  a[0] = ZipLo64(c0, c4);
+  a[1] = ZipHi64(c0, c4);
+  a[2] = ZipLo64(c1, c5);
+  a[3] = ZipHi64(c1, c5);
+  a[4] = ZipLo64(c2, c6);
+  a[5] = ZipHi64(c2, c6);
+  a[6] = ZipLo64(c3, c7);
+  a[7] = ZipHi64(c3, c7);
+}
+
+
+// A lane of 16 doubles is loaded as 8 pairs of doubles. Each pair is shuffled into 8 words (one per byte plane)
+// of two bytes, taken from the second and the first double. The pairs are ordered such that the transposed words
+// of a byte plane hold doubles 7, 6, ..., 0, 15, 14, ..., 8, which is the order of the scalar shuffle.
+SIMD_TARGET int ShuffleReal(const char* inVec, char* outVec, int nrOfBlocks)
+{
+  unsigned long long planeSize = 8ULL * nrOfBlocks;  // size of a byte plane in bytes
+  Vec mask = LoadMask(SHUFFLE_REAL_MASK);
+  Vec a[8];
+
+  int block = 0;
+  for (; block + 2 * LANES <= nrOfBlocks; block += 2 * LANES)
+  {
+    const char* src = inVec + 64 * block;
+    char* dst = outVec + 8 * block;
+
+    for (int pair = 0; pair < 8; ++pair)
+    {
+      a[pair] = ByteShuffle(LoadLanes(src + 16 * SHUFFLE_REAL_PAIRS[pair], 128), mask);
+    }
+
+    Transpose16(a);
+
+    for (int plane = 0; plane < 8; ++plane)
+    {
+      StoreVec(dst + plane * planeSize, a[plane]);
+    }
+  }
+
+  return block;
+}
+
+
+SIMD_TARGET int DeshuffleReal(const char* inVec, char* outVec, int nrOfBlocks)
+{
+  unsigned long long planeSize = 8ULL * nrOfBlocks;
+  Vec mask = LoadMask(DESHUFFLE_REAL_MASK);
+  Vec a[8];
+
+  int block = 0;
+  for (; block + 2 * LANES <= nrOfBlocks; block += 2 * LANES)
+  {
+    const char* src = inVec + 8 * block;
+    char* dst = outVec + 64 * block;
+
+    for (int plane = 0; plane < 8; ++plane)
+    {
+      a[plane] = LoadVec(src + plane * planeSize);
+    }
+
+    Transpose16(a);  // the transpose is its own inverse
+
+    for (int pair = 0; pair < 8; ++pair)
+    {
+      StoreLanes(dst + 16 * SHUFFLE_REAL_PAIRS[pair], ByteShuffle(a[pair], mask), 128);
+    }
+  }
+
+  return block;
+}
+
+
+// A lane of 16 integers is loaded as 4 quads of integers. Each quad (i0, i1, i2, i3) is shuffled into 8 words of
+// two bytes, (i2, i0) and (i3, i1) for each byte plane. Interleaving the words of quads 1 and 0 then gives the
+// scalar order 6, 4, 2, 0, 7, 5, 3, 1 within a byte plane (and 14, 12, ... for quads 3 and 2).
+SIMD_TARGET int ShuffleInt2(const char* inVec, char* outVec, int nrOfBlocks)
+{
+  unsigned long long planeSize = 8ULL * nrOfBlocks;
+  Vec mask = LoadMask(SHUFFLE_INT2_MASK);
+
+  int block = 0;
+  for (; block + 2 * LANES <= nrOfBlocks; block += 2 * LANES)
+  {
+    const char* src = inVec + 32 * block;
+    char* dst = outVec + 8 * block;
+
+    Vec quad0 = ByteShuffle(LoadLanes(src     , 64), mask);
+    Vec quad1 = ByteShuffle(LoadLanes(src + 16, 64), mask);
+    Vec quad2 = ByteShuffle(LoadLanes(src + 32, 64), mask);
+    Vec quad3 = ByteShuffle(LoadLanes(src + 48, 64), mask);
+
+    Vec planes01Low  = ZipLo16(quad1, quad0);  // byte planes 0 and 1 of the first block
+    Vec planes23Low  = ZipHi16(quad1, quad0);
+    Vec planes01High = ZipLo16(quad3, quad2);  // byte planes 0 and 1 of the second block
+    Vec planes23High = ZipHi16(quad3, quad2);
+
+    StoreVec(dst                , ZipLo64(planes01Low, planes01High));
+    StoreVec(dst + planeSize    , ZipHi64(planes01Low, planes01High));
+    StoreVec(dst + 2 * planeSize, ZipLo64(planes23Low, planes23High));
+    StoreVec(dst + 3 * planeSize, ZipHi64(planes23Low, planes23High));
+  }
+
+  return block;
+}
+
+
+SIMD_TARGET int DeshuffleInt2(const char* inVec, char* outVec, int nrOfBlocks)
+{
+  unsigned long long planeSize = 8ULL * nrOfBlocks;
+  Vec mask = LoadMask(DESHUFFLE_INT2_MASK);
+  Vec split = LoadMask(SPLIT_WORDS_MASK);
+
+  int block = 0;
+  for (; block + 2 * LANES <= nrOfBlocks; block += 2 * LANES)
+  {
+    const char* src = inVec + 8 * block;
+    char* dst = outVec + 32 * block;
+
+    Vec plane0 = LoadVec(src);
+    Vec plane1 = LoadVec(src + planeSize);
+    Vec plane2 = LoadVec(src + 2 * planeSize);
+    Vec plane3 = LoadVec(src + 3 * planeSize);
+
+    // Interleaved words of quads 1 and 0 (or 3 and 2), split into the words of each quad
+    Vec planes01Low  = ByteShuffle(ZipLo64(plane0, plane1), split);
+    Vec planes23Low  = ByteShuffle(ZipLo64(plane2, plane3), split);
+    Vec planes01High = ByteShuffle(ZipHi64(plane0, plane1), split);
+    Vec planes23High = ByteShuffle(ZipHi64(plane2, plane3), split);
+
+    StoreLanes(dst     , ByteShuffle(ZipHi64(planes01Low, planes23Low), mask), 64);
+    StoreLanes(dst + 16, ByteShuffle(ZipLo64(planes01Low, planes23Low), mask), 64);
+    StoreLanes(dst + 32, ByteShuffle(ZipHi64(planes01High, planes23High), mask), 64);
+    StoreLanes(dst + 48, ByteShuffle(ZipLo64(planes01High, planes23High), mask), 64);
+  }
+
+  return block;
+}
@@ -32,6 +32,10 @@
   - fst source repository : https://github.com/fstPackage/fst
 */
 
+#include "double_v9.h"
+
+#include <cstring>
+
 // Framework libraries
 #include "blockstreamer_v2.h"
 #include "compressor.h"
@@ -39,39 +43,125 @@
 using namespace std;
 
 
-#define BLOCKSIZE_REAL 2048  // number of doubles in default compression block
+void ReduceRealPrecision(const double* doubleVector, double* reducedVector, unsigned long long nrOfRows,
+  unsigned int mantissaBits)
+{
+  const unsigned long long EXPONENT_MASK = 0x7FF0000000000000ULL;
+  unsigned long long dropMask = (1ULL << (52 - mantissaBits)) - 1;
+  unsigned long long half = (dropMask + 1) >> 1;
+
+  for (unsigned long long row = 0; row < nrOfRows; ++row)
+  {
+    unsigned long long bits;
+    memcpy(&bits, &doubleVector[row], 8);
+
+    if ((bits & EXPONENT_MASK) != EXPONENT_MASK)  // finite value
+    {
+      unsigned long long rounded = (bits + half) & ~dropMask;
+
+      // Rounding up the largest values would overflow to infinity
+      bits = (rounded & EXPONENT_MASK) == EXPONENT_MASK ? bits & ~dropMask : rounded;
+    }
 
+    memcpy(&reducedVector[row], &bits, 8);
+  }
+}
 
-void fdsWriteRealVec_v9(ofstream &myfile, double* doubleVector, unsigned int nrOfRows, unsigned int compression)
+
+void fdsWriteRealVec_v9(ostream &myfile, double* doubleVector, unsigned long long nrOfRows, unsigned int compression,
+  int nrOfThreads, unsigned int blockSizeElems, ZoneMap* zoneMap, const CompressionGoal* goal, bool fastDecode)
 {
   // double* realP = REAL(realVec);
   // unsigned int nrOfRows = LENGTH(realVec);  // vector length
 
-  int blockSize = 8 * BLOCKSIZE_REAL;  // block size in bytes
+  int blockSize = 8 * blockSizeElems;  // block size in bytes
+
+  if (goal != nullptr)  // algorithm selected per block
+  {
+    AdaptiveCompressor* compress1 = new AdaptiveCompressor(*goal);
+    compress1->AddCandidate(CompAlgo::LZ4, 0);
+    compress1->AddCandidate(CompAlgo::LZ4_SHUF8, 0);
+    compress1->AddCandidate(CompAlgo::LZ4_REAL_DELTA, 0);
+    compress1->AddCandidate(CompAlgo::LZ4_REAL_INT, 0);
+    compress1->AddCandidate(CompAlgo::REAL_XOR, 0);
+    compress1->AddCandidate(CompAlgo::REAL_SPARSE, 0);
+    compress1->AddCandidate(CompAlgo::ZSTD, 20);
+    compress1->AddCandidate(CompAlgo::ZSTD_SHUF8, 20);
+    compress1->AddCandidate(CompAlgo::ZSTD_SHUF8, 60);
+    StreamCompressor* streamCompressor = new StreamSingleCompressor(compress1);
+    streamCompressor->CompressBufferSize(blockSize);
+    fdsStreamcompressed_v2(myfile, reinterpret_cast<char*>(doubleVector), nrOfRows, 8, streamCompressor, blockSizeElems, nrOfThreads, zoneMap);
+
+    delete compress1;
+    delete streamCompressor;
+    return;
+  }
 
   if (compression == 0)
   {
-    return fdsStreamUncompressed_v2(myfile, reinterpret_cast<char*>(doubleVector), nrOfRows, 8, BLOCKSIZE_REAL, nullptr);
+    return fdsStreamUncompressed_v2(myfile, reinterpret_cast<char*>(doubleVector), nrOfRows, 8, blockSizeElems, nullptr, zoneMap);
   }
 
+  // Blocks of sorted integer valued doubles (such as timestamps and dates) are delta encoded, other blocks of
+  // integer valued doubles (or decimals with a fixed number of digits) are stored as bit-packed integers. Blocks of
+  // mostly NA's are sparse encoded.
   if (compression <= 50)  // low compression: linear mix of uncompressed and LZ4_SHUF
   {
-    Compressor* compress1 = new DualCompressor(CompAlgo::LZ4_SHUF8, CompAlgo::LZ4, 0, 2 * compression);
+    Compressor* dualCompressor = new DualCompressor(CompAlgo::LZ4_SHUF8, CompAlgo::LZ4, 0, 2 * compression);
+    Compressor* intCompressor = new RealIntCompressor(CompAlgo::LZ4_REAL_INT, dualCompressor, 0);
+    Compressor* deltaCompressor = new DeltaCompressor(CompAlgo::LZ4_REAL_DELTA, intCompressor, 0);
+    Compressor* compress1 = new SparseCompressor(CompAlgo::REAL_SPARSE, deltaCompressor);
     StreamCompressor* streamCompressor = new StreamLinearCompressor(compress1, 2 * compression);
     streamCompressor->CompressBufferSize(blockSize);
-    fdsStreamcompressed_v2(myfile, reinterpret_cast<char*>(doubleVector), nrOfRows, 8, streamCompressor, BLOCKSIZE_REAL);
+    fdsStreamcompressed_v2(myfile, reinterpret_cast<char*>(doubleVector), nrOfRows, 8, streamCompressor, blockSizeElems, nrOfThreads, zoneMap);
+
+    delete dualCompressor;
+    delete intCompressor;
+    delete deltaCompressor;
+    delete compress1;
+    delete streamCompressor;
+    return;
+  }
+
+  // Archival storage: worker threads compress each segment, random access is at segment granularity
+  if (compression == 100 && nrOfThreads > 1 && blockSizeElems >= SEGMENTSIZE_REAL && !fastDecode)
+  {
+    Compressor* compress1 = new ZstdMtCompressor(20, nrOfThreads);  // same ZSTD level as the blocks
+    StreamCompressor* streamCompressor = new StreamSingleCompressor(compress1);
+    streamCompressor->CompressBufferSize(blockSize);
+
+    // the compressor owns the worker threads, segments are processed one at a time
+    fdsStreamcompressed_v2(myfile, (char*) doubleVector, nrOfRows, 8, streamCompressor, blockSizeElems, 1, zoneMap);
 
     delete compress1;
     delete streamCompressor;
     return;
   }
 
-  Compressor* compress1 = new DualCompressor(CompAlgo::LZ4_SHUF8, CompAlgo::LZ4, 0, 100);
-  Compressor* compress2 = new SingleCompressor(CompAlgo::ZSTD, 20);
+  // Slowly varying series (such as prices and measurements) compress better with XOR coding than with LZ4_SHUF8
+  Compressor* dualCompressor = new DualCompressor(CompAlgo::LZ4_SHUF8, CompAlgo::REAL_XOR, 0, 0);
+  Compressor* intCompressor1 = new RealIntCompressor(CompAlgo::LZ4_REAL_INT, dualCompressor, 0);
+
+  // For fast decoding, the high compression blocks use LZ4HC instead of ZSTD
+  Compressor* zstdCompressor = fastDecode ? new SingleCompressor(CompAlgo::LZ4HC, compression) :
+    new SingleCompressor(CompAlgo::ZSTD, 20);
+  Compressor* intCompressor2 = fastDecode ?
+    new RealIntCompressor(CompAlgo::LZ4_REAL_INT, zstdCompressor, compression) :
+    new RealIntCompressor(CompAlgo::ZSTD_REAL_INT, zstdCompressor, 20);
+  Compressor* deltaCompressor1 = new DeltaCompressor(CompAlgo::LZ4_REAL_DELTA, intCompressor1, 0);
+  Compressor* deltaCompressor2 = new DeltaCompressor(CompAlgo::LZ4_REAL_DELTA, intCompressor2, 0);
+  Compressor* compress1 = new SparseCompressor(CompAlgo::REAL_SPARSE, deltaCompressor1);
+  Compressor* compress2 = new SparseCompressor(CompAlgo::REAL_SPARSE, deltaCompressor2);
   StreamCompressor* streamCompressor = new StreamCompositeCompressor(compress1, compress2, 2 * (compression - 50));
   streamCompressor->CompressBufferSize(blockSize);
-  fdsStreamcompressed_v2(myfile, (char*) doubleVector, nrOfRows, 8, streamCompressor, BLOCKSIZE_REAL);
-
+  fdsStreamcompressed_v2(myfile, (char*) doubleVector, nrOfRows, 8, streamCompressor, blockSizeElems, nrOfThreads, zoneMap);
+
+  delete dualCompressor;
+  delete zstdCompressor;
+  delete intCompressor1;
+  delete intCompressor2;
+  delete deltaCompressor1;
+  delete deltaCompressor2;
   delete compress1;
   delete compress2;
   delete streamCompressor;
@@ -80,7 +170,9 @@ void fdsWriteRealVec_v9(ofstream &myfile, double* doubleVector, unsigned int nrO
 }
 
 
-void fdsReadRealVec_v9(istream &myfile, double* doubleVector, unsigned long long blockPos, unsigned int startRow, unsigned int length, unsigned int size)
+void fdsReadRealVec_v9(istream &myfile, double* doubleVector, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, unsigned long long size,
+  int nrOfThreads)
 {
-  return fdsReadColumn_v2(myfile, (char*) doubleVector, blockPos, startRow, length, size, 8);
+  return fdsReadColumn_v2(myfile, (char*) doubleVector, blockPos, startRow, length, size, 8, nrOfThreads);
 }
@@ -40,9 +40,31 @@
 #include <ostream>
 #include <istream>
 
+#include <zonemap.h>
+#include <compressor.h>
 
-void fdsWriteRealVec_v9(std::ofstream &myfile, double* doubleVector, unsigned int nrOfRows, unsigned int compression);
 
-void fdsReadRealVec_v9(std::istream &myfile, double* doubleVector, unsigned long long blockPos, unsigned int startRow, unsigned int length, unsigned int size);
+#define BLOCKSIZE_REAL 2048  // number of doubles in default compression block
+#define SEGMENTSIZE_REAL 2097152  // number of doubles in a 16 MB segment (multithreaded compression)
+
+
+// Blocks of blockSizeElems doubles are compressed. If zoneMap is specified, it receives the statistics of each
+// block. At maximum compression with more than one thread, blocks of at least SEGMENTSIZE_REAL doubles are
+// compressed as segments by a multithreaded ZSTD compressor.
+// If goal is specified, the compression level is ignored and each block is compressed with the algorithm that
+// best meets the goal. With fastDecode, compression levels above 50 use LZ4HC instead of ZSTD (and no segments).
+void fdsWriteRealVec_v9(std::ostream &myfile, double* doubleVector, unsigned long long nrOfRows, unsigned int compression,
+  int nrOfThreads, unsigned int blockSizeElems, ZoneMap* zoneMap = nullptr, const CompressionGoal* goal = nullptr,
+  bool fastDecode = false);
+
+// Copy nrOfRows doubles to reducedVector with their mantissa rounded to the nearest value with mantissaBits
+// significant bits (1 - 52). The zeroed low order bytes of the mantissas compress to almost nothing after
+// shuffling. NA, NaN and infinite values are copied as is.
+void ReduceRealPrecision(const double* doubleVector, double* reducedVector, unsigned long long nrOfRows,
+  unsigned int mantissaBits);
+
+void fdsReadRealVec_v9(std::istream &myfile, double* doubleVector, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, unsigned long long size,
+  int nrOfThreads);
 
 #endif // DOUBLE_v9_H
@@ -54,10 +54,11 @@ using namespace std;
 #define HEADER_SIZE_FACTOR 16
 #define VERSION_NUMBER_FACTOR 1
 
-void fdsWriteFactorVec_v7(ofstream &myfile, int* intP, IBlockWriter* blockRunner, unsigned int size, unsigned int compression)
+void fdsWriteFactorVec_v7(ostream &myfile, int* intP, IBlockWriter* blockRunner, unsigned long long size, unsigned int compression,
+  int nrOfThreads, unsigned int blockSizeElems, ZoneMap* zoneMap)
 {
   unsigned long long blockPos = myfile.tellp();  // offset for factor
-  unsigned int nrOfFactorLevels = blockRunner->vecLength;
+  unsigned int nrOfFactorLevels = static_cast<unsigned int>(blockRunner->vecLength);
 
   // Vector meta data
   char meta[HEADER_SIZE_FACTOR];
@@ -82,7 +83,7 @@ void fdsWriteFactorVec_v7(ofstream &myfile, int* intP, IBlockWriter* blockRunner
 
   // Store factor vector here
 
-  unsigned int nrOfRows = size;  // vector length
+  unsigned long long nrOfRows = size;  // vector length
 
   // With zero compression only a fixed width compactor is used (int to byte or int to short)
 
@@ -91,7 +92,7 @@ void fdsWriteFactorVec_v7(ofstream &myfile, int* intP, IBlockWriter* blockRunner
     if (*nrOfLevels < 128)
     {
       FixedRatioCompressor* compressor = new FixedRatioCompressor(CompAlgo::INT_TO_BYTE);  // compression level not relevant here
-      fdsStreamUncompressed_v2(myfile, (char*) intP, nrOfRows, 4, BLOCKSIZE_INT, compressor);
+      fdsStreamUncompressed_v2(myfile, (char*) intP, nrOfRows, 4, blockSizeElems, compressor, zoneMap);
 
       delete compressor;
 
@@ -101,43 +102,48 @@ void fdsWriteFactorVec_v7(ofstream &myfile, int* intP, IBlockWriter* blockRunner
     if (*nrOfLevels < 32768)
     {
       FixedRatioCompressor* compressor = new FixedRatioCompressor(CompAlgo::INT_TO_SHORT);  // compression level not relevant here
-      fdsStreamUncompressed_v2(myfile, (char*) intP, nrOfRows, 4, BLOCKSIZE_INT, compressor);
+      fdsStreamUncompressed_v2(myfile, (char*) intP, nrOfRows, 4, blockSizeElems, compressor, zoneMap);
       delete compressor;
 
       return;
     }
 
-    fdsStreamUncompressed_v2(myfile, (char*) intP, nrOfRows, 4, BLOCKSIZE_INT, nullptr);
+    fdsStreamUncompressed_v2(myfile, (char*) intP, nrOfRows, 4, blockSizeElems, nullptr, zoneMap);
 
     return;
   }
 
-  int blockSize = 4 * BLOCKSIZE_INT;  // block size in bytes
+  int blockSize = 4 * blockSizeElems;  // block size in bytes
 
   if (*nrOfLevels < 128)  // use 1 byte per int
   {
     Compressor* defaultCompress;
     Compressor* compress2;
-    StreamCompressor* streamCompressor = nullptr;
 
     if (compression <= 50)
     {
       defaultCompress = new SingleCompressor(CompAlgo::INT_TO_BYTE, 0);  // compression not relevant here
       compress2 = new SingleCompressor(CompAlgo::LZ4_INT_TO_BYTE, 100);  // use maximum compression for LZ4 algorithm
-      streamCompressor = new StreamCompositeCompressor(defaultCompress, compress2, 2 * compression);
     }
     else
     {
       defaultCompress = new SingleCompressor(CompAlgo::LZ4_INT_TO_BYTE, 100);  // compression not relevant here
       compress2 = new SingleCompressor(CompAlgo::ZSTD_INT_TO_BYTE, compression - 70);  // use maximum compression for LZ4 algorithm
-      streamCompressor = new StreamCompositeCompressor(defaultCompress, compress2, 2 * (compression - 50));
     }
 
+    // Blocks with long runs of equal level codes are run-length encoded
+    Compressor* rleCompress1 = new RleCompressor(defaultCompress);
+    Compressor* rleCompress2 = new RleCompressor(compress2);
+    int compress2Ratio = compression <= 50 ? 2 * compression : 2 * (compression - 50);
+    StreamCompressor* streamCompressor = new StreamCompositeCompressor(rleCompress1, rleCompress2, compress2Ratio);
+
     streamCompressor->CompressBufferSize(blockSize);
 
-    fdsStreamcompressed_v2(myfile, (char*) intP, nrOfRows, 4, streamCompressor, BLOCKSIZE_INT);
+    fdsStreamcompressed_v2(myfile, (char*) intP, nrOfRows, 4, streamCompressor, blockSizeElems, nrOfThreads, zoneMap);
     delete defaultCompress;
     delete compress2;
+    delete rleCompress1;
+    delete rleCompress2;
     delete streamCompressor;
 
     return;
@@ -147,12 +153,16 @@ void fdsWriteFactorVec_v7(ofstream &myfile, int* intP, IBlockWriter* blockRunner
   {
     Compressor* defaultCompress = new SingleCompressor(CompAlgo::INT_TO_SHORT, 0);  // compression not relevant here
     Compressor* compress2 = new SingleCompressor(CompAlgo::LZ4_INT_TO_SHORT_SHUF2, 100);  // use maximum compression for LZ4 algorithm
-    StreamCompressor* streamCompressor = new StreamCompositeCompressor(defaultCompress, compress2, compression);
+    Compressor* rleCompress1 = new RleCompressor(defaultCompress);
+    Compressor* rleCompress2 = new RleCompressor(compress2);
+    StreamCompressor* streamCompressor = new StreamCompositeCompressor(rleCompress1, rleCompress2, compression);
     streamCompressor->CompressBufferSize(blockSize);
 
-    fdsStreamcompressed_v2(myfile, (char*) intP, nrOfRows, 4, streamCompressor, BLOCKSIZE_INT);
+    fdsStreamcompressed_v2(myfile, (char*) intP, nrOfRows, 4, streamCompressor, blockSizeElems, nrOfThreads, zoneMap);
     delete defaultCompress;
     delete compress2;
+    delete rleCompress1;
+    delete rleCompress2;
     delete streamCompressor;
 
     return;
@@ -160,10 +170,12 @@ void fdsWriteFactorVec_v7(ofstream &myfile, int* intP, IBlockWriter* blockRunner
 
   // use default integer compression with shuffle
 
-  Compressor* compress1 = new SingleCompressor(CompAlgo::LZ4_SHUF4, 0);
+  Compressor* shufCompress = new SingleCompressor(CompAlgo::LZ4_SHUF4, 0);
+  Compressor* compress1 = new RleCompressor(shufCompress);
   StreamCompressor* streamCompressor = new StreamLinearCompressor(compress1, compression);
   streamCompressor->CompressBufferSize(blockSize);
-  fdsStreamcompressed_v2(myfile, (char*) intP, nrOfRows, 4, streamCompressor, BLOCKSIZE_INT);
+  fdsStreamcompressed_v2(myfile, (char*) intP, nrOfRows, 4, streamCompressor, blockSizeElems, nrOfThreads, zoneMap);
+  delete shufCompress;
   delete compress1;
   delete streamCompressor;
 
@@ -172,8 +184,8 @@ void fdsWriteFactorVec_v7(ofstream &myfile, int* intP, IBlockWriter* blockRunner
 
 
 // Parameter 'startRow' is zero based.
-void fdsReadFactorVec_v7(istream &myfile, IStringColumn* blockReader, int* intP, unsigned long long blockPos, unsigned int startRow,
-  unsigned int length, unsigned int size)
+void fdsReadFactorVec_v7(istream &myfile, IStringColumn* blockReader, int* intP, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, unsigned long long size, int nrOfThreads)
 {
   // Jump to factor level
   myfile.seekg(blockPos);
@@ -196,7 +208,96 @@ void fdsReadFactorVec_v7(istream &myfile, IStringColumn* blockReader, int* intP,
   fdsReadCharVec_v6(myfile, blockReader, blockPos + HEADER_SIZE_FACTOR, 0, *nrOfLevels, *nrOfLevels);  // get level strings
 
   // Read level values
-  fdsReadColumn_v2(myfile, (char*) intP, *levelVecPos, startRow, length, size, 4);
+  fdsReadColumn_v2(myfile, (char*) intP, *levelVecPos, startRow, length, size, 4, nrOfThreads);
 
   return;
 }
+
+
+// Read the vector meta data of a factor column, returns the number of levels
+inline unsigned int ReadFactorMeta_v7(istream &myfile, unsigned long long blockPos, unsigned long long &levelVecPos)
+{
+  myfile.seekg(blockPos);
+
+  char meta[HEADER_SIZE_FACTOR];
+  myfile.read(meta, HEADER_SIZE_FACTOR);
+  unsigned int* versionNr = (unsigned int*) &meta;
+
+  if (*versionNr > VERSION_NUMBER_FACTOR)
+  {
+    throw runtime_error("Incompatible fst file.");
+  }
+
+  levelVecPos = *((unsigned long long*) &meta[8]);
+
+  return *((unsigned int*) &meta[4]);
+}
+
+
+unsigned int fdsReadFactorLevels_v7(istream &myfile, IStringColumn* blockReader, unsigned long long blockPos)
+{
+  unsigned long long levelVecPos;
+  unsigned int nrOfLevels = ReadFactorMeta_v7(myfile, blockPos, levelVecPos);
+
+  fdsReadCharVec_v6(myfile, blockReader, blockPos + HEADER_SIZE_FACTOR, 0, nrOfLevels, nrOfLevels);  // get level strings
+
+  return nrOfLevels;
+}
+
+
+void fdsReadFactorCodes_v7(istream &myfile, int* intP, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, unsigned long long size, int nrOfThreads)
+{
+  unsigned long long levelVecPos;
+  ReadFactorMeta_v7(myfile, blockPos, levelVecPos);
+
+  fdsReadColumn_v2(myfile, (char*) intP, levelVecPos, startRow, length, size, 4, nrOfThreads);
+}
+
+
+void fdsFactorColumnStorage_v7(istream &myfile, unsigned long long blockPos, unsigned long long size,
+  ColumnStorage &storage)
+{
+  unsigned long long levelVecPos;
+  unsigned int nrOfLevels = ReadFactorMeta_v7(myfile, blockPos, levelVecPos);
+
+  // The levels are stored between the header and the level codes
+  storage.bytes += levelVecPos - blockPos;
+
+  if (nrOfLevels > 0)
+  {
+    ColumnStorage levelStorage;
+    fdsCharColumnStorage_v6(myfile, blockPos + HEADER_SIZE_FACTOR, nrOfLevels, levelStorage);
+
+    for (unsigned int algo = 0; algo < NR_OF_ALGORITHMS; ++algo) storage.blocks[algo] += levelStorage.blocks[algo];
+    if (levelStorage.maxBlockSize > storage.maxBlockSize) storage.maxBlockSize = levelStorage.maxBlockSize;
+  }
+
+  if (size > 0) fdsColumnStorage_v2(myfile, levelVecPos, size, 4, storage);
+}
+
+
+bool fdsReadFactorCodeRuns_v7(istream &myfile, vector<int> &runValues, vector<unsigned long long> &runEnds,
+  unsigned long long blockPos, unsigned long long startRow, unsigned long long length)
+{
+  unsigned long long levelVecPos;
+  ReadFactorMeta_v7(myfile, blockPos, levelVecPos);
+
+  return fdsReadColumnRuns_v2(myfile, runValues, runEnds, levelVecPos, startRow, length);
+}
+
+
+unsigned int fdsMoveFactorVec_v7(char* factorData, long long offset)
+{
+  unsigned int* versionNr = (unsigned int*) factorData;
+
+  if (*versionNr > VERSION_NUMBER_FACTOR)
+  {
+    throw runtime_error("Incompatible fst file.");
+  }
+
+  unsigned long long* levelVecPos = (unsigned long long*) &factorData[8];
+  *levelVecPos += offset;
+
+  return HEADER_SIZE_FACTOR;
+}
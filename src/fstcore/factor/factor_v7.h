@@ -39,17 +39,51 @@
 
 #include <iostream>
 #include <fstream>
+#include <vector>
 
 #include <iblockrunner.h>
 #include <ifstcolumn.h>
+#include <zonemap.h>
+#include <blockstreamer_v2.h>
 
 
-void fdsWriteFactorVec_v7(std::ofstream &myfile, int* intP, IBlockWriter* blockRunner, unsigned int size, unsigned int compression);
+// Level codes are compressed in blocks of blockSizeElems. If zoneMap is specified, it receives the statistics of
+// the level codes.
+void fdsWriteFactorVec_v7(std::ostream &myfile, int* intP, IBlockWriter* blockRunner, unsigned long long size, unsigned int compression,
+  int nrOfThreads, unsigned int blockSizeElems, ZoneMap* zoneMap = nullptr);
 
 
 // Parameter 'startRow' is zero based.
-void fdsReadFactorVec_v7(std::istream &myfile, IStringColumn* blockReader, int* intP, unsigned long long blockPos, unsigned int startRow,
-  unsigned int length, unsigned int size);
+void fdsReadFactorVec_v7(std::istream &myfile, IStringColumn* blockReader, int* intP, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, unsigned long long size, int nrOfThreads);
+
+
+// Read only the levels of a factor column, returns the number of levels.
+unsigned int fdsReadFactorLevels_v7(std::istream &myfile, IStringColumn* blockReader, unsigned long long blockPos);
+
+
+// Read only the level codes of rows startRow until startRow + length of a factor column. Parameter 'startRow' is
+// zero based.
+void fdsReadFactorCodes_v7(std::istream &myfile, int* intP, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, unsigned long long size, int nrOfThreads);
+
+
+// Read the level codes of rows startRow until startRow + length as runs of equal codes (see fdsReadColumnRuns_v2).
+// Returns false if the range is not run-length encoded.
+bool fdsReadFactorCodeRuns_v7(std::istream &myfile, std::vector<int> &runValues, std::vector<unsigned long long> &runEnds,
+  unsigned long long blockPos, unsigned long long startRow, unsigned long long length);
+
+
+// Add the storage of the factor column at blockPos, with size elements, to storage (see fdsColumnStorage_v2). The
+// blocks of the levels and the level codes are both counted.
+void fdsFactorColumnStorage_v7(std::istream &myfile, unsigned long long blockPos, unsigned long long size,
+  ColumnStorage &storage);
+
+
+// The header of a factor column stores the file position of its level codes. Update that position for factor
+// column data that is copied to a position offset bytes from its original position. Parameter 'factorData'
+// points to the (in memory) header. Returns the size of the header.
+unsigned int fdsMoveFactorVec_v7(char* factorData, long long offset);
 
 
 #endif  // FACTOR_v7_H
@@ -0,0 +1,123 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#include "integer64_v11.h"
+
+// Framework libraries
+#include "blockstreamer_v2.h"
+#include "compressor.h"
+
+using namespace std;
+
+
+void fdsWriteInt64Vec_v11(ostream &myfile, long long* int64Vector, unsigned long long nrOfRows,
+  unsigned int compression, int nrOfThreads, unsigned int blockSizeElems, ZoneMap* zoneMap,
+  const CompressionGoal* goal, bool fastDecode)
+{
+  int blockSize = 8 * blockSizeElems;  // block size in bytes
+
+  if (goal != nullptr)  // algorithm selected per block
+  {
+    AdaptiveCompressor* compress1 = new AdaptiveCompressor(*goal);
+    compress1->AddCandidate(CompAlgo::LONG_BITPACK, 0);
+    compress1->AddCandidate(CompAlgo::LZ4_LONG_DELTA, 0);
+    compress1->AddCandidate(CompAlgo::LZ4_SHUF8, 0);
+    compress1->AddCandidate(CompAlgo::LONG_SPARSE, 0);
+    compress1->AddCandidate(CompAlgo::ZSTD_LONG_BITPACK, 20);
+    compress1->AddCandidate(CompAlgo::ZSTD_SHUF8, 20);
+    compress1->AddCandidate(CompAlgo::ZSTD_SHUF8, 60);
+    StreamCompressor* streamCompressor = new StreamSingleCompressor(compress1);
+    streamCompressor->CompressBufferSize(blockSize);
+    fdsStreamcompressed_v2(myfile, (char*) int64Vector, nrOfRows, 8, streamCompressor, blockSizeElems, nrOfThreads,
+      zoneMap);
+
+    delete compress1;
+    delete streamCompressor;
+    return;
+  }
+
+  if (compression == 0)
+  {
+    return fdsStreamUncompressed_v2(myfile, (char*) int64Vector, nrOfRows, 8, blockSizeElems, nullptr, zoneMap);
+  }
+
+  // Identifiers and nanosecond timestamps rarely use more than a few of their 64 bits: blocks of sorted values are
+  // delta encoded and blocks with a range of less than 2^32 values are bit-packed as 32-bit codes. Blocks of mostly
+  // NA's are sparse encoded.
+  if (compression <= 50)  // low compression: linear mix of uncompressed and LZ4_SHUF8
+  {
+    Compressor* packCompressor = new BitPackCompressor(CompAlgo::LZ4_LONG_BITPACK, CompAlgo::LZ4_SHUF8, 0);
+    Compressor* deltaCompressor = new DeltaCompressor(CompAlgo::LZ4_LONG_DELTA, packCompressor, 0);
+    Compressor* compress1 = new SparseCompressor(CompAlgo::LONG_SPARSE, deltaCompressor);
+    StreamCompressor* streamCompressor = new StreamLinearCompressor(compress1, 2 * compression);
+    streamCompressor->CompressBufferSize(blockSize);
+    fdsStreamcompressed_v2(myfile, (char*) int64Vector, nrOfRows, 8, streamCompressor, blockSizeElems, nrOfThreads,
+      zoneMap);
+
+    delete packCompressor;
+    delete deltaCompressor;
+    delete compress1;
+    delete streamCompressor;
+    return;
+  }
+
+  Compressor* packCompressor1 = new BitPackCompressor(CompAlgo::LZ4_LONG_BITPACK, CompAlgo::LZ4_SHUF8, 0);
+  // For fast decoding, the high compression blocks use LZ4HC instead of ZSTD
+  Compressor* packCompressor2 = fastDecode ?
+    new BitPackCompressor(CompAlgo::LZ4_LONG_BITPACK, CompAlgo::LZ4HC_SHUF8, compression) :
+    new BitPackCompressor(CompAlgo::ZSTD_LONG_BITPACK, CompAlgo::ZSTD_SHUF8, 20);
+  Compressor* deltaCompressor1 = new DeltaCompressor(CompAlgo::LZ4_LONG_DELTA, packCompressor1, 0);
+  Compressor* deltaCompressor2 = new DeltaCompressor(CompAlgo::LZ4_LONG_DELTA, packCompressor2, 0);
+  Compressor* compress1 = new SparseCompressor(CompAlgo::LONG_SPARSE, deltaCompressor1);
+  Compressor* compress2 = new SparseCompressor(CompAlgo::LONG_SPARSE, deltaCompressor2);
+  StreamCompressor* streamCompressor = new StreamCompositeCompressor(compress1, compress2, 2 * (compression - 50));
+  streamCompressor->CompressBufferSize(blockSize);
+  fdsStreamcompressed_v2(myfile, (char*) int64Vector, nrOfRows, 8, streamCompressor, blockSizeElems, nrOfThreads,
+    zoneMap);
+
+  delete packCompressor1;
+  delete packCompressor2;
+  delete deltaCompressor1;
+  delete deltaCompressor2;
+  delete compress1;
+  delete compress2;
+  delete streamCompressor;
+}
+
+
+void fdsReadInt64Vec_v11(istream &myfile, long long* int64Vector, unsigned long long blockPos,
+  unsigned long long startRow, unsigned long long length, unsigned long long size, int nrOfThreads)
+{
+  return fdsReadColumn_v2(myfile, (char*) int64Vector, blockPos, startRow, length, size, 8, nrOfThreads);
+}
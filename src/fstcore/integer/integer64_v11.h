@@ -0,0 +1,61 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#ifndef INTEGER64_V11_H
+#define INTEGER64_V11_H
+
+
+// System libraries
+#include <ostream>
+#include <istream>
+
+#include <zonemap.h>
+#include <compressor.h>
+
+
+#define BLOCKSIZE_INT64 2048  // number of 64-bit integers in default compression block
+
+
+// Blocks of blockSizeElems 64-bit integers are compressed. If zoneMap is specified, it receives the statistics of
+// each block. If goal is specified, the compression level is ignored and each block is compressed with the
+// algorithm that best meets the goal. With fastDecode, compression levels above 50 use LZ4HC instead of ZSTD.
+void fdsWriteInt64Vec_v11(std::ostream &myfile, long long* int64Vector, unsigned long long nrOfRows,
+  unsigned int compression, int nrOfThreads, unsigned int blockSizeElems, ZoneMap* zoneMap = nullptr,
+  const CompressionGoal* goal = nullptr, bool fastDecode = false);
+
+void fdsReadInt64Vec_v11(std::istream &myfile, long long* int64Vector, unsigned long long blockPos,
+  unsigned long long startRow, unsigned long long length, unsigned long long size, int nrOfThreads);
+
+#endif // INTEGER64_V11_H
@@ -43,35 +43,80 @@
 using namespace std;
 
 
-void fdsWriteIntVec_v8(ofstream &myfile, int* integerVector, unsigned int nrOfRows, unsigned int compression)
+void fdsWriteIntVec_v8(ostream &myfile, int* integerVector, unsigned long long nrOfRows, unsigned int compression,
+  int nrOfThreads, unsigned int blockSizeElems, ZoneMap* zoneMap, const CompressionGoal* goal, bool fastDecode)
 {
-  int blockSize = 4 * BLOCKSIZE_INT;  // block size in bytes
+  int blockSize = 4 * blockSizeElems;  // block size in bytes
+
+  if (goal != nullptr)  // algorithm selected per block
+  {
+    AdaptiveCompressor* compress1 = new AdaptiveCompressor(*goal);
+    compress1->AddCandidate(CompAlgo::INT_BITPACK, 0);
+    compress1->AddCandidate(CompAlgo::LZ4_INT_DELTA, 0);
+    compress1->AddCandidate(CompAlgo::INT_RLE, 0);
+    compress1->AddCandidate(CompAlgo::INT_SPARSE, 0);
+    compress1->AddCandidate(CompAlgo::LZ4_SHUF4, 0);
+    compress1->AddCandidate(CompAlgo::ZSTD_INT_BITPACK, 20);
+    compress1->AddCandidate(CompAlgo::ZSTD_SHUF4, 0);
+    compress1->AddCandidate(CompAlgo::ZSTD_SHUF4, 40);
+    compress1->AddCandidate(CompAlgo::ZSTD, 20);
+    StreamCompressor* streamCompressor = new StreamSingleCompressor(compress1);
+    streamCompressor->CompressBufferSize(blockSize);
+    fdsStreamcompressed_v2(myfile, (char*) integerVector, nrOfRows, 4, streamCompressor, blockSizeElems, nrOfThreads, zoneMap);
+
+    delete compress1;
+    delete streamCompressor;
+    return;
+  }
 
   if (compression == 0)
   {
-    return fdsStreamUncompressed_v2(myfile, (char*) integerVector, nrOfRows, 4, BLOCKSIZE_INT, nullptr);
+    return fdsStreamUncompressed_v2(myfile, (char*) integerVector, nrOfRows, 4, blockSizeElems, nullptr, zoneMap);
   }
 
+  // Blocks with a small range of values are bit-packed before LZ4 compression, blocks of sorted keys are
+  // delta encoded, blocks with long runs of equal values are run-length encoded and blocks of mostly NA's are
+  // sparse encoded
   if (compression <= 50)  // low compression: linear mix of uncompressed and LZ4_SHUF
   {
-    Compressor* compress1 = new SingleCompressor(CompAlgo::LZ4_SHUF4, 0);
+    Compressor* packCompressor = new BitPackCompressor(CompAlgo::LZ4_INT_BITPACK, CompAlgo::LZ4_SHUF4, 0);
+    Compressor* deltaCompressor = new DeltaCompressor(CompAlgo::LZ4_INT_DELTA, packCompressor, 0);
+    Compressor* rleCompressor = new RleCompressor(deltaCompressor);
+    Compressor* compress1 = new SparseCompressor(CompAlgo::INT_SPARSE, rleCompressor);
 
     StreamCompressor* streamCompressor = new StreamLinearCompressor(compress1, 2 * compression);
 
     streamCompressor->CompressBufferSize(blockSize);
-    fdsStreamcompressed_v2(myfile, (char*) integerVector, nrOfRows, 4, streamCompressor, BLOCKSIZE_INT);
+    fdsStreamcompressed_v2(myfile, (char*) integerVector, nrOfRows, 4, streamCompressor, blockSizeElems, nrOfThreads, zoneMap);
 
+    delete packCompressor;
+    delete deltaCompressor;
+    delete rleCompressor;
     delete compress1;
     delete streamCompressor;
     return;
   }
 
-  Compressor* compress1 = new SingleCompressor(CompAlgo::LZ4_SHUF4, 0);
-  Compressor* compress2 = new SingleCompressor(CompAlgo::ZSTD_SHUF4, 0);
+  Compressor* packCompressor = new BitPackCompressor(CompAlgo::LZ4_INT_BITPACK, CompAlgo::LZ4_SHUF4, 0);
+  // For fast decoding, the high compression blocks use LZ4HC instead of ZSTD
+  Compressor* zstdCompressor = fastDecode ? new SingleCompressor(CompAlgo::LZ4HC_SHUF4, compression) :
+    new SingleCompressor(CompAlgo::ZSTD_SHUF4, 0);
+  Compressor* deltaCompressor1 = new DeltaCompressor(CompAlgo::LZ4_INT_DELTA, packCompressor, 0);
+  Compressor* deltaCompressor2 = new DeltaCompressor(CompAlgo::LZ4_INT_DELTA, zstdCompressor, 0);
+  Compressor* rleCompressor1 = new RleCompressor(deltaCompressor1);
+  Compressor* rleCompressor2 = new RleCompressor(deltaCompressor2);
+  Compressor* compress1 = new SparseCompressor(CompAlgo::INT_SPARSE, rleCompressor1);
+  Compressor* compress2 = new SparseCompressor(CompAlgo::INT_SPARSE, rleCompressor2);
   StreamCompressor* streamCompressor = new StreamCompositeCompressor(compress1, compress2, 2 * (compression - 50));
   streamCompressor->CompressBufferSize(blockSize);
-  fdsStreamcompressed_v2(myfile, (char*) integerVector, nrOfRows, 4, streamCompressor, BLOCKSIZE_INT);
-
+  fdsStreamcompressed_v2(myfile, (char*) integerVector, nrOfRows, 4, streamCompressor, blockSizeElems, nrOfThreads, zoneMap);
+
+  delete packCompressor;
+  delete zstdCompressor;
+  delete deltaCompressor1;
+  delete deltaCompressor2;
+  delete rleCompressor1;
+  delete rleCompressor2;
   delete compress1;
   delete compress2;
   delete streamCompressor;
@@ -80,7 +125,16 @@ void fdsWriteIntVec_v8(ofstream &myfile, int* integerVector, unsigned int nrOfRo
 }
 
 
-void fdsReadIntVec_v8(istream &myfile, int* integerVec, unsigned long long blockPos, unsigned int startRow, unsigned int length, unsigned int size)
+void fdsReadIntVec_v8(istream &myfile, int* integerVec, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, unsigned long long size,
+  int nrOfThreads)
+{
+  return fdsReadColumn_v2(myfile, (char*) integerVec, blockPos, startRow, length, size, 4, nrOfThreads);
+}
+
+
+bool fdsReadIntRuns_v8(istream &myfile, vector<int> &runValues, vector<unsigned long long> &runEnds,
+  unsigned long long blockPos, unsigned long long startRow, unsigned long long length)
 {
-  return fdsReadColumn_v2(myfile, (char*) integerVec, blockPos, startRow, length, size, 4);
+  return fdsReadColumnRuns_v2(myfile, runValues, runEnds, blockPos, startRow, length);
 }
@@ -39,13 +39,29 @@
 
 #include <ostream>
 #include <istream>
+#include <vector>
+
+#include <zonemap.h>
+#include <compressor.h>
 
 
 #define BLOCKSIZE_INT 4096  // number of integers in default compression block
 
 
-void fdsWriteIntVec_v8(std::ofstream &myfile, int* integerVector, unsigned int nrOfRows, unsigned int compression);
+// Blocks of blockSizeElems integers are compressed. If zoneMap is specified, it receives the statistics of each block.
+// If goal is specified, the compression level is ignored and each block is compressed with the algorithm that
+// best meets the goal. With fastDecode, compression levels above 50 use LZ4HC instead of ZSTD.
+void fdsWriteIntVec_v8(std::ostream &myfile, int* integerVector, unsigned long long nrOfRows, unsigned int compression,
+  int nrOfThreads, unsigned int blockSizeElems, ZoneMap* zoneMap = nullptr, const CompressionGoal* goal = nullptr,
+  bool fastDecode = false);
+
+void fdsReadIntVec_v8(std::istream &myfile, int* integerVector, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, unsigned long long size,
+  int nrOfThreads);
 
-void fdsReadIntVec_v8(std::istream &myfile, int* integerVector, unsigned long long blockPos, unsigned startRow, unsigned length, unsigned size);
+// Read rows startRow until startRow + length as runs of equal values (see fdsReadColumnRuns_v2). Returns false if
+// the range is not run-length encoded.
+bool fdsReadIntRuns_v8(std::istream &myfile, std::vector<int> &runValues, std::vector<unsigned long long> &runEnds,
+  unsigned long long blockPos, unsigned long long startRow, unsigned long long length);
 
 #endif // INTEGER_V8_H
@@ -0,0 +1,67 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef COLUMN_NAME_INDEX_H
+#define COLUMN_NAME_INDEX_H
+
+
+#include <string>
+#include <unordered_map>
+
+
+/**
+ Hash index of the column names of a table, replacing a linear scan over all names for each lookup. Duplicate
+ names resolve to the first column with that name, identical to a linear scan.
+ */
+class ColumnNameIndex
+{
+  std::unordered_map<std::string, int> nameIndex;
+
+public:
+  void Reserve(int nrOfCols) { nameIndex.reserve(nrOfCols); }
+
+  void Add(const char* colName, int colNr) { nameIndex.insert(std::make_pair(std::string(colName), colNr)); }
+
+  // Column number of colName or -1 if the name is not present
+  int Find(const char* colName) const
+  {
+    std::unordered_map<std::string, int>::const_iterator it = nameIndex.find(colName);
+
+    return it == nameIndex.end() ? -1 : it->second;
+  }
+};
+
+
+#endif  // COLUMN_NAME_INDEX_H
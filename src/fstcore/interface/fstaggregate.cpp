@@ -0,0 +1,1300 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#include <stdexcept>
+#include <cmath>
+#include <climits>
+#include <limits>
+#include <algorithm>
+#include <map>
+#include <unordered_set>
+
+#include <fstdefines.h>
+#include <fstaggregate.h>
+#include <stringvectorcolumn.h>
+
+#include <character_v6.h>
+#include <factor_v7.h>
+#include <integer_v8.h>
+#include <integer64_v11.h>
+#include <double_v9.h>
+#include <logical_v10.h>
+
+
+using namespace std;
+
+
+// Running aggregates of the non-NA values of a column
+struct Accumulator
+{
+  unsigned long long count;
+  long double sum;
+  double minValue;
+  double maxValue;
+
+  Accumulator() : count(0), sum(0), minValue(INFINITY), maxValue(-INFINITY) {}
+
+  void Merge(const Accumulator &other)
+  {
+    count += other.count;
+    sum   += other.sum;
+
+    if (other.minValue < minValue) minValue = other.minValue;
+    if (other.maxValue > maxValue) maxValue = other.maxValue;
+  }
+};
+
+
+// Aggregated column with the buffers that are reused for each batch of rows
+class AggregateColumn
+{
+public:
+  int colNr;
+  unsigned short int colType;  // stored column type
+  bool decompress;             // the current data chunk is reduced from the column data
+  Accumulator total;
+  vector<Accumulator> groups;  // grouped aggregates only
+
+  vector<int> ints;  // integer, logical and factor columns
+  vector<double> doubles;
+  vector<long long> longs;  // 64-bit integer columns
+  vector<int> runValues;
+  vector<unsigned long long> runEnds;
+
+  AggregateColumn(int colNr, unsigned short int colType) : colNr(colNr), colType(colType), decompress(true)
+  {
+    if (this->colType == 12 || this->colType == 13) this->colType = 9;  // dates and timestamps are stored as doubles
+  }
+};
+
+
+// Counts the non-NA elements of a character column without copying the strings
+class CharCounter : public IStringColumn
+{
+  const char* mask;
+
+public:
+  unsigned long long count;
+
+  CharCounter(const char* mask) : mask(mask), count(0) {}
+
+  void AllocateVec(unsigned long long vecLength) {}
+
+  void BufferToVec(unsigned int nrOfElements, unsigned int startElem, unsigned int endElem,
+    unsigned long long vecOffset, unsigned int* sizeMeta, char* buf)
+  {
+    unsigned int* bitsNA = &sizeMeta[nrOfElements];
+
+    for (unsigned int elem = startElem; elem <= endElem; ++elem)
+    {
+      if (mask != nullptr && !mask[vecOffset + elem - startElem]) continue;
+      if ((bitsNA[elem / 32] >> (elem % 32)) & 1) continue;
+
+      ++count;
+    }
+  }
+
+  bool LevelsToVec(unsigned long long vecOffset, unsigned long long length, const int* codes,
+    unsigned int nrOfLevels, const unsigned int* levelSizes, const char* levelBuf)
+  {
+    for (unsigned long long pos = 0; pos < length; ++pos)
+    {
+      if (mask != nullptr && !mask[vecOffset + pos]) continue;
+      if (codes[pos] != INT_MIN) ++count;
+    }
+
+    return true;
+  }
+
+  const char* GetElement(int elementNr) { return ""; }
+};
+
+
+// Stores INT_MIN for the NA elements of a character column and 0 for the other elements, so the values can be
+// counted per group as integers
+class CharNAFlags : public IStringColumn
+{
+  int* flags;
+
+public:
+  CharNAFlags(int* flags) : flags(flags) {}
+
+  void AllocateVec(unsigned long long vecLength) {}
+
+  void BufferToVec(unsigned int nrOfElements, unsigned int startElem, unsigned int endElem,
+    unsigned long long vecOffset, unsigned int* sizeMeta, char* buf)
+  {
+    unsigned int* bitsNA = &sizeMeta[nrOfElements];
+
+    for (unsigned int elem = startElem; elem <= endElem; ++elem)
+    {
+      flags[vecOffset + elem - startElem] = ((bitsNA[elem / 32] >> (elem % 32)) & 1) ? INT_MIN : 0;
+    }
+  }
+
+  bool LevelsToVec(unsigned long long vecOffset, unsigned long long length, const int* codes,
+    unsigned int nrOfLevels, const unsigned int* levelSizes, const char* levelBuf)
+  {
+    for (unsigned long long pos = 0; pos < length; ++pos)
+    {
+      flags[vecOffset + pos] = codes[pos] == INT_MIN ? INT_MIN : 0;
+    }
+
+    return true;
+  }
+
+  const char* GetElement(int elementNr) { return ""; }
+};
+
+
+inline bool IsNA(int value) { return value == INT_MIN; }
+
+inline bool IsNA(long long value) { return value == LLONG_MIN; }
+
+inline bool IsNA(double value) { return value != value; }
+
+
+// Add values start until end of a buffer of values (of type T, summed as type S). NA values and the rows for which
+// the mask is 0 are skipped.
+template<typename T, typename S>
+void ReduceSerial(const T* values, const char* mask, unsigned long long start, unsigned long long end,
+  Accumulator &total)
+{
+  unsigned long long count = 0;
+  S sum = 0;
+  T minValue = numeric_limits<T>::has_infinity ? numeric_limits<T>::infinity() : numeric_limits<T>::max();
+  T maxValue = numeric_limits<T>::has_infinity ? -numeric_limits<T>::infinity() : numeric_limits<T>::min();
+
+  for (unsigned long long row = start; row < end; ++row)
+  {
+    T value = values[row];
+
+    if (IsNA(value) || (mask != nullptr && !mask[row])) continue;
+
+    ++count;
+    sum += value;
+    if (value < minValue) minValue = value;
+    if (value > maxValue) maxValue = value;
+  }
+
+  if (count == 0) return;
+
+  total.count += count;
+  total.sum   += sum;
+
+  if (minValue < total.minValue) total.minValue = (double) minValue;
+  if (maxValue > total.maxValue) total.maxValue = (double) maxValue;
+}
+
+
+// Reduce a buffer of values in parallel segments
+template<typename T, typename S>
+void ReduceValues(const T* values, const char* mask, unsigned long long length, Accumulator &total, int nrOfThreads)
+{
+  int nrOfSegments = (int) min((unsigned long long) max(nrOfThreads, 1), 1 + length / 65536);
+  unsigned long long segmentSize = (length + nrOfSegments - 1) / nrOfSegments;
+  vector<Accumulator> partial(nrOfSegments);
+
+#pragma omp parallel for schedule(static) num_threads(nrOfSegments)
+  for (int segment = 0; segment < nrOfSegments; ++segment)
+  {
+    unsigned long long start = segment * segmentSize;
+    ReduceSerial<T, S>(values, mask, start, min(start + segmentSize, length), partial[segment]);
+  }
+
+  for (int segment = 0; segment < nrOfSegments; ++segment)
+  {
+    total.Merge(partial[segment]);
+  }
+}
+
+
+// Reduce a buffer of values per level code in parallel segments, into slot 0 for NA codes and slot code otherwise.
+// Each segment has its own slots, which are merged afterwards.
+template<typename T, typename S>
+void ReduceByCode(const T* values, const int* codes, const char* mask, unsigned long long length,
+  vector<Accumulator> &slots, int nrOfThreads)
+{
+  int nrOfSlots = (int) slots.size();
+  int nrOfSegments = (int) min((unsigned long long) max(nrOfThreads, 1), 1 + length / 65536);
+  unsigned long long segmentSize = (length + nrOfSegments - 1) / nrOfSegments;
+  vector< vector<Accumulator> > partial(nrOfSegments, vector<Accumulator>(nrOfSlots));
+
+#pragma omp parallel for schedule(static) num_threads(nrOfSegments)
+  for (int segment = 0; segment < nrOfSegments; ++segment)
+  {
+    unsigned long long start = segment * segmentSize;
+    unsigned long long end = min(start + segmentSize, length);
+    Accumulator* segmentSlots = partial[segment].data();
+
+    for (unsigned long long row = start; row < end; ++row)
+    {
+      T value = values[row];
+
+      if (IsNA(value) || (mask != nullptr && !mask[row])) continue;
+
+      int code = codes[row];
+      Accumulator &slot = segmentSlots[code >= 1 && code < nrOfSlots ? code : 0];
+
+      ++slot.count;
+      slot.sum += (S) value;
+      if (value < slot.minValue) slot.minValue = (double) value;
+      if (value > slot.maxValue) slot.maxValue = (double) value;
+    }
+  }
+
+  for (int segment = 0; segment < nrOfSegments; ++segment)
+  {
+    for (int slotNr = 0; slotNr < nrOfSlots; ++slotNr)
+    {
+      slots[slotNr].Merge(partial[segment][slotNr]);
+    }
+  }
+}
+
+
+// Reduce the runs of a run-length encoded range of an integer, logical or factor column
+void ReduceRuns(const vector<int> &runValues, const vector<unsigned long long> &runEnds, const char* mask,
+  Accumulator &total)
+{
+  unsigned long long runStart = 0;
+
+  for (size_t run = 0; run < runValues.size(); ++run)
+  {
+    int value = runValues[run];
+    unsigned long long runEnd = runEnds[run];
+    unsigned long long count = runEnd - runStart;
+
+    if (mask != nullptr)
+    {
+      count = 0;
+
+      for (unsigned long long row = runStart; row < runEnd; ++row)
+      {
+        count += mask[row];
+      }
+    }
+
+    runStart = runEnd;
+
+    if (IsNA(value) || count == 0) continue;
+
+    total.count += count;
+    total.sum   += (long double) value * count;
+
+    if (value < total.minValue) total.minValue = value;
+    if (value > total.maxValue) total.maxValue = value;
+  }
+}
+
+
+// Add the statistics of the zone map of a column in a data chunk
+void ReduceZoneMap(const ZoneMap &zoneMap, unsigned short int colType, Accumulator &total)
+{
+  for (unsigned long long blockNr = 0; blockNr < zoneMap.NrOfBlocks(); ++blockNr)
+  {
+    const ZoneMapEntry &entry = zoneMap.Block(blockNr);
+
+    if (entry.naCount == entry.nrOfValues) continue;  // minimum and maximum are undefined
+
+    total.count += entry.nrOfValues - entry.naCount;
+
+    if (colType == 6) continue;  // string prefixes
+
+    double minValue = colType == 11 ? (double) entry.minInt64 : entry.minValue;
+    double maxValue = colType == 11 ? (double) entry.maxInt64 : entry.maxValue;
+
+    if (minValue < total.minValue) total.minValue = minValue;
+    if (maxValue > total.maxValue) total.maxValue = maxValue;
+  }
+}
+
+
+// Row ranges (first and end row) of the blocks of a column in a data chunk that have at least one non-NA value
+void ValueRanges(const ZoneMap &zoneMap, unsigned long long chunkRows,
+  vector<pair<unsigned long long, unsigned long long>> &ranges)
+{
+  unsigned long long blockSize = zoneMap.BlockSize();
+
+  for (unsigned long long blockNr = 0; blockNr < zoneMap.NrOfBlocks(); ++blockNr)
+  {
+    const ZoneMapEntry &entry = zoneMap.Block(blockNr);
+
+    if (entry.naCount == entry.nrOfValues) continue;
+
+    unsigned long long firstRow = blockNr * blockSize;
+    unsigned long long endRow = min(firstRow + blockSize, chunkRows);
+
+    if (!ranges.empty() && ranges.back().second == firstRow)
+    {
+      ranges.back().second = endRow;
+      continue;
+    }
+
+    ranges.push_back(make_pair(firstRow, endRow));
+  }
+}
+
+
+// Aggregates of a column from its accumulated values
+void SetResult(const AggregateColumn &column, const Accumulator &total, ColumnAggregate &result)
+{
+  bool isText = column.colType == 6 || column.colType == 7;
+
+  result.count    = total.count;
+  result.sum      = isText ? NAN : (double) total.sum;
+  result.minValue = isText || total.count == 0 ? NAN : total.minValue;
+  result.maxValue = isText || total.count == 0 ? NAN : total.maxValue;
+}
+
+
+// Decompress rows firstRow until firstRow + length of an aggregated column of a data chunk into the buffers of the
+// column. Character columns are decompressed as NA flags (see CharNAFlags).
+void DecompressColumn(istream &myfile, AggregateColumn &column, unsigned long long pos, unsigned long long firstRow,
+  unsigned long long length, unsigned long long chunkRows, int nrOfThreads)
+{
+  myfile.clear();  // reset state from a previous read at the end of the file
+
+  switch (column.colType)
+  {
+    case 6:
+    {
+      column.ints.resize(length);
+      CharNAFlags naFlags(column.ints.data());
+      fdsReadCharVecAt_v6(myfile, &naFlags, pos, firstRow, length, chunkRows, 0);
+      break;
+    }
+
+    case 7:
+      column.ints.resize(length);
+      fdsReadFactorCodes_v7(myfile, column.ints.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+      break;
+
+    case 8:
+      column.ints.resize(length);
+      fdsReadIntVec_v8(myfile, column.ints.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+      break;
+
+    case 9:
+      column.doubles.resize(length);
+      fdsReadRealVec_v9(myfile, column.doubles.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+      break;
+
+    case 10:
+      column.ints.resize(length);
+      fdsReadLogicalVec_v10(myfile, column.ints.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+      break;
+
+    case 11:
+      column.longs.resize(length);
+      fdsReadInt64Vec_v11(myfile, column.longs.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+      break;
+
+    default:
+      throw(runtime_error("Unknown type found in column."));
+  }
+}
+
+
+// Group column of a grouped aggregate with the groups found so far
+class GroupState
+{
+public:
+  int colNr;
+  unsigned short int colType;  // stored column type
+  bool byLevel;                // factor column, grouped by level code instead of by runs of equal values
+
+  GroupValues keys;                          // value of each group
+  vector<unsigned long long> groupRows;      // number of selected rows of each group
+
+  // Factor columns: group of each level code of the prepared data chunk, element 0 is the NA group
+  int preparedChunk;
+  int naGroup;
+  map<string, unsigned int> levelGroups;
+  vector<unsigned int> codeGroups;
+  vector<Accumulator> slots;
+
+  // Decompressed values of the group column in the current batch
+  vector<int> ints;
+  vector<double> doubles;
+  vector<long long> longs;
+  StringVectorColumn strings;
+
+  // Runs of equal values in the current batch (key columns)
+  vector<unsigned long long> runEnds;
+  vector<unsigned int> runGroups;
+
+  GroupState(int colNr, unsigned short int colType) : colNr(colNr), colType(colType), preparedChunk(-1),
+    naGroup(-1)
+  {
+    if (this->colType == 12 || this->colType == 13) this->colType = 9;  // dates and timestamps are stored as doubles
+    byLevel = this->colType == 7;
+  }
+
+  unsigned int NrOfGroups() const { return (unsigned int) groupRows.size(); }
+
+  // Test if row of the current batch has the value of the last group
+  bool IsLastGroup(unsigned long long row) const
+  {
+    if (groupRows.empty()) return false;
+
+    bool rowNA = IsValueNA(row);
+
+    if (rowNA || keys.isNA.back()) return rowNA && keys.isNA.back();
+
+    switch (colType)
+    {
+      case 6:
+        return strings.strings[row] == keys.strings.back();
+
+      case 9:
+        return doubles[row] == keys.values.back();
+
+      case 11:
+        return longs[row] == keys.int64Values.back();
+
+      default:
+        return (double) ints[row] == keys.values.back();
+    }
+  }
+
+  // Test if two rows of the current batch have the same value
+  bool SameValue(unsigned long long row1, unsigned long long row2) const
+  {
+    bool na1 = IsValueNA(row1);
+    bool na2 = IsValueNA(row2);
+
+    if (na1 || na2) return na1 && na2;
+
+    switch (colType)
+    {
+      case 6:
+        return strings.strings[row1] == strings.strings[row2];
+
+      case 9:
+        return doubles[row1] == doubles[row2];
+
+      case 11:
+        return longs[row1] == longs[row2];
+
+      default:
+        return ints[row1] == ints[row2];
+    }
+  }
+
+  bool IsValueNA(unsigned long long row) const
+  {
+    switch (colType)
+    {
+      case 6:
+        return strings.isNA[row] != 0;
+
+      case 9:
+        return IsNA(doubles[row]);
+
+      case 11:
+        return IsNA(longs[row]);
+
+      default:
+        return IsNA(ints[row]);
+    }
+  }
+
+  // Add a group with the value of a row of the current batch (or NA)
+  unsigned int AddGroup(unsigned long long row, bool isNA)
+  {
+    keys.isNA.push_back(isNA ? 1 : 0);
+    groupRows.push_back(0);
+
+    switch (colType)
+    {
+      case 6:
+      case 7:
+        keys.strings.push_back(isNA || colType == 7 ? string() : strings.strings[row]);
+        break;
+
+      case 9:
+        keys.values.push_back(isNA ? NAN : doubles[row]);
+        break;
+
+      case 11:
+        keys.int64Values.push_back(isNA ? LLONG_MIN : longs[row]);
+        break;
+
+      default:
+        keys.values.push_back(isNA ? NAN : (double) ints[row]);
+        break;
+    }
+
+    return NrOfGroups() - 1;
+  }
+};
+
+
+// Reduce a buffer of values of an aggregated column per group of the current batch
+template<typename T, typename S>
+void ReduceGroupValues(const T* values, const char* mask, unsigned long long length, GroupState &state,
+  vector<Accumulator> &groups, int nrOfThreads)
+{
+  // Direct-indexed slots for the level codes of factor columns
+  if (state.byLevel)
+  {
+    state.slots.assign(state.codeGroups.size(), Accumulator());
+    ReduceByCode<T, S>(values, state.ints.data(), mask, length, state.slots, nrOfThreads);
+
+    for (unsigned int slotNr = 0; slotNr < state.slots.size(); ++slotNr)
+    {
+      groups[state.codeGroups[slotNr]].Merge(state.slots[slotNr]);
+    }
+
+    return;
+  }
+
+  // Each run of equal key values belongs to a different group. A few large runs are each reduced in parallel,
+  // many small runs are divided over the threads.
+  int nrOfRuns = (int) state.runEnds.size();
+
+  if (nrOfRuns < nrOfThreads)
+  {
+    unsigned long long runStart = 0;
+
+    for (int run = 0; run < nrOfRuns; ++run)
+    {
+      unsigned long long runEnd = state.runEnds[run];
+      ReduceValues<T, S>(values + runStart, mask == nullptr ? nullptr : mask + runStart, runEnd - runStart,
+        groups[state.runGroups[run]], nrOfThreads);
+      runStart = runEnd;
+    }
+
+    return;
+  }
+
+#pragma omp parallel for schedule(static) num_threads(nrOfThreads)
+  for (int run = 0; run < nrOfRuns; ++run)
+  {
+    unsigned long long runStart = run == 0 ? 0 : state.runEnds[run - 1];
+    ReduceSerial<T, S>(values, mask, runStart, state.runEnds[run], groups[state.runGroups[run]]);
+  }
+}
+
+
+// Add the distinct values of a buffer of values to a set, in parallel segments with a set for each segment
+template<typename T>
+void InsertDistinct(const T* values, unsigned long long length, unordered_set<T> &distinct, bool &hasNA,
+  int nrOfThreads)
+{
+  int nrOfSegments = (int) min((unsigned long long) max(nrOfThreads, 1), 1 + length / 65536);
+  unsigned long long segmentSize = (length + nrOfSegments - 1) / nrOfSegments;
+  vector< unordered_set<T> > partial(nrOfSegments);
+  vector<char> partialNA(nrOfSegments, 0);
+
+#pragma omp parallel for schedule(static) num_threads(nrOfSegments)
+  for (int segment = 0; segment < nrOfSegments; ++segment)
+  {
+    unsigned long long start = segment * segmentSize;
+    unsigned long long end = min(start + segmentSize, length);
+    unordered_set<T> &segmentSet = partial[segment];
+
+    for (unsigned long long row = start; row < end; ++row)
+    {
+      T value = values[row];
+
+      if (IsNA(value))
+      {
+        partialNA[segment] = 1;
+        continue;
+      }
+
+      segmentSet.insert(value == 0 ? 0 : value);  // -0.0 and 0.0 are the same value
+    }
+  }
+
+  for (int segment = 0; segment < nrOfSegments; ++segment)
+  {
+    distinct.insert(partial[segment].begin(), partial[segment].end());
+    if (partialNA[segment]) hasNA = true;
+  }
+}
+
+
+// Reduces the batches of rows that were evaluated by a row filter
+class AggregateRowMask : public IRowMask
+{
+  FstAggregator &aggregator;
+  vector<AggregateColumn> &columns;
+  GroupState* groupState;  // nullptr for aggregates without groups
+  int nrOfThreads;
+
+public:
+  AggregateRowMask(FstAggregator &aggregator, vector<AggregateColumn> &columns, GroupState* groupState,
+    int nrOfThreads) : aggregator(aggregator), columns(columns), groupState(groupState), nrOfThreads(nrOfThreads) {}
+
+  void AddBatch(unsigned int chunkNr, unsigned long long firstRow, unsigned long long length, const vector<char> &mask)
+  {
+    // Batches without matching rows are not decompressed
+    if (find(mask.begin(), mask.begin() + length, 1) == mask.begin() + length) return;
+
+    if (groupState != nullptr)
+    {
+      aggregator.ReduceGroups(*groupState, columns, chunkNr, firstRow, length, mask.data(), nrOfThreads);
+      return;
+    }
+
+    aggregator.ReduceRange(columns, chunkNr, firstRow, length, mask.data(), nrOfThreads);
+  }
+};
+
+
+void FstAggregator::Aggregate(const vector<int> &colIndex, int functions, const FstPredicate* predicate,
+  vector<ColumnAggregate> &results, int nrOfThreads)
+{
+  if (fstHandle.inputStream == nullptr)
+  {
+    throw(runtime_error("The fst file is not opened."));
+  }
+
+  rowsScanned = 0;
+
+  vector<AggregateColumn> columns;
+
+  for (vector<int>::const_iterator it = colIndex.begin(); it != colIndex.end(); ++it)
+  {
+    columns.push_back(AggregateColumn(*it, fstHandle.colTypes[*it]));
+  }
+
+  if (predicate != nullptr)
+  {
+    FstFilter fstFilter(fstHandle);
+    AggregateRowMask rowMask(*this, columns, nullptr, nrOfThreads);
+
+    fstFilter.ScanRows(*predicate, rowMask, nrOfThreads);
+  }
+  else
+  {
+    ZoneMap zoneMap;
+    vector<vector<pair<unsigned long long, unsigned long long>>> valueRanges(columns.size());
+
+    for (unsigned int chunkNr = 0; chunkNr < fstHandle.NrOfChunks(); ++chunkNr)
+    {
+      unsigned long long chunkRows = fstHandle.ChunkNrOfRows(chunkNr);
+      bool decompressChunk = false;
+
+      // The count, minimum and maximum are available from the zone maps. Character and factor columns have a count
+      // only, which never requires the column data. Sums require the column data, but only of the blocks that have
+      // a value: blocks of NA's are skipped on their NA count.
+      for (unsigned int pos = 0; pos < columns.size(); ++pos)
+      {
+        AggregateColumn &column = columns[pos];
+        bool needsSum = (functions & AGGREGATE_SUM) != 0 && column.colType != 6 && column.colType != 7;
+
+        valueRanges[pos].clear();
+        column.decompress = !fstHandle.ReadZoneMap(chunkNr, column.colNr, zoneMap);
+
+        if (column.decompress)
+        {
+          decompressChunk = true;
+          continue;
+        }
+
+        if (needsSum)
+        {
+          ValueRanges(zoneMap, chunkRows, valueRanges[pos]);
+          continue;
+        }
+
+        ReduceZoneMap(zoneMap, column.colType, column.total);
+      }
+
+      for (unsigned long long firstRow = 0; decompressChunk && firstRow < chunkRows; firstRow += AGGR_BATCH_ROWS)
+      {
+        unsigned long long length = min((unsigned long long) AGGR_BATCH_ROWS, chunkRows - firstRow);
+        ReduceRange(columns, chunkNr, firstRow, length, nullptr, nrOfThreads);
+      }
+
+      // Columns with a zone map are summed one at a time over their ranges of blocks with values
+      for (unsigned int pos = 0; pos < columns.size(); ++pos)
+      {
+        if (valueRanges[pos].empty()) continue;
+
+        for (vector<AggregateColumn>::iterator it = columns.begin(); it != columns.end(); ++it)
+        {
+          it->decompress = false;
+        }
+
+        columns[pos].decompress = true;
+
+        for (auto range = valueRanges[pos].begin(); range != valueRanges[pos].end(); ++range)
+        {
+          for (unsigned long long firstRow = range->first; firstRow < range->second; firstRow += AGGR_BATCH_ROWS)
+          {
+            unsigned long long length = min((unsigned long long) AGGR_BATCH_ROWS, range->second - firstRow);
+            ReduceRange(columns, chunkNr, firstRow, length, nullptr, nrOfThreads);
+          }
+        }
+      }
+
+      for (vector<AggregateColumn>::iterator it = columns.begin(); it != columns.end(); ++it)
+      {
+        it->decompress = true;
+      }
+    }
+  }
+
+  results.resize(columns.size());
+
+  for (unsigned int pos = 0; pos < columns.size(); ++pos)
+  {
+    SetResult(columns[pos], columns[pos].total, results[pos]);
+  }
+}
+
+
+void FstAggregator::ReduceRange(vector<AggregateColumn> &columns, unsigned int chunkNr, unsigned long long firstRow,
+  unsigned long long length, const char* mask, int nrOfThreads)
+{
+  istream &myfile = *fstHandle.inputStream;
+  unsigned long long* blockPos = fstHandle.ChunkPositionData(chunkNr);
+  unsigned long long chunkRows = fstHandle.ChunkNrOfRows(chunkNr);
+
+  for (vector<AggregateColumn>::iterator it = columns.begin(); it != columns.end(); ++it)
+  {
+    AggregateColumn &column = *it;
+
+    if (!column.decompress) continue;
+
+    unsigned long long pos = blockPos[column.colNr];
+    myfile.clear();  // reset state from a previous read at the end of the file
+
+    switch (column.colType)
+    {
+      case 6:
+      {
+        CharCounter charCounter(mask);
+        fdsReadCharVecAt_v6(myfile, &charCounter, pos, firstRow, length, chunkRows, 0);
+        column.total.count += charCounter.count;
+        break;
+      }
+
+      case 7:
+        if (fdsReadFactorCodeRuns_v7(myfile, column.runValues, column.runEnds, pos, firstRow, length))
+        {
+          ReduceRuns(column.runValues, column.runEnds, mask, column.total);
+          break;
+        }
+
+        column.ints.resize(length);
+        fdsReadFactorCodes_v7(myfile, column.ints.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+        ReduceValues<int, long long>(column.ints.data(), mask, length, column.total, nrOfThreads);
+        break;
+
+      case 8:
+        if (fdsReadIntRuns_v8(myfile, column.runValues, column.runEnds, pos, firstRow, length))
+        {
+          ReduceRuns(column.runValues, column.runEnds, mask, column.total);
+          break;
+        }
+
+        column.ints.resize(length);
+        fdsReadIntVec_v8(myfile, column.ints.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+        ReduceValues<int, long long>(column.ints.data(), mask, length, column.total, nrOfThreads);
+        break;
+
+      case 9:
+        column.doubles.resize(length);
+        fdsReadRealVec_v9(myfile, column.doubles.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+        ReduceValues<double, long double>(column.doubles.data(), mask, length, column.total, nrOfThreads);
+        break;
+
+      case 10:
+        if (fdsReadLogicalRuns_v10(myfile, column.runValues, column.runEnds, pos, firstRow, length))
+        {
+          ReduceRuns(column.runValues, column.runEnds, mask, column.total);
+          break;
+        }
+
+        column.ints.resize(length);
+        fdsReadLogicalVec_v10(myfile, column.ints.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+        ReduceValues<int, long long>(column.ints.data(), mask, length, column.total, nrOfThreads);
+        break;
+
+      case 11:
+        column.longs.resize(length);
+        fdsReadInt64Vec_v11(myfile, column.longs.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+        ReduceValues<long long, long double>(column.longs.data(), mask, length, column.total, nrOfThreads);
+        break;
+
+      default:
+        throw(runtime_error("Unknown type found in column."));
+    }
+  }
+
+  rowsScanned += length;
+}
+
+
+void FstAggregator::AggregateGroups(const vector<int> &colIndex, int groupColNr, const FstPredicate* predicate,
+  GroupValues &groups, vector<ColumnAggregate> &results, int nrOfThreads)
+{
+  if (fstHandle.inputStream == nullptr)
+  {
+    throw(runtime_error("The fst file is not opened."));
+  }
+
+  unsigned short int groupType = fstHandle.colTypes[groupColNr];
+
+  if (groupType != 7 && (fstHandle.keyColPos.empty() || fstHandle.keyColPos[0] != groupColNr))
+  {
+    throw(runtime_error("The group column should be a factor column or the first key column of the table."));
+  }
+
+  rowsScanned = 0;
+
+  vector<AggregateColumn> columns;
+
+  for (vector<int>::const_iterator it = colIndex.begin(); it != colIndex.end(); ++it)
+  {
+    columns.push_back(AggregateColumn(*it, fstHandle.colTypes[*it]));
+  }
+
+  GroupState state(groupColNr, groupType);
+
+  if (predicate != nullptr)
+  {
+    FstFilter fstFilter(fstHandle);
+    AggregateRowMask rowMask(*this, columns, &state, nrOfThreads);
+
+    fstFilter.ScanRows(*predicate, rowMask, nrOfThreads);
+  }
+  else
+  {
+    for (unsigned int chunkNr = 0; chunkNr < fstHandle.NrOfChunks(); ++chunkNr)
+    {
+      unsigned long long chunkRows = fstHandle.ChunkNrOfRows(chunkNr);
+
+      for (unsigned long long firstRow = 0; firstRow < chunkRows; firstRow += AGGR_BATCH_ROWS)
+      {
+        unsigned long long length = min((unsigned long long) AGGR_BATCH_ROWS, chunkRows - firstRow);
+        ReduceGroups(state, columns, chunkNr, firstRow, length, nullptr, nrOfThreads);
+      }
+    }
+  }
+
+  // Groups with selected rows, the NA group of a factor column is placed last
+  vector<unsigned int> order;
+
+  for (unsigned int groupNr = 0; groupNr < state.NrOfGroups(); ++groupNr)
+  {
+    if (state.groupRows[groupNr] > 0 && (!state.byLevel || !state.keys.isNA[groupNr])) order.push_back(groupNr);
+  }
+
+  if (state.naGroup >= 0 && state.groupRows[state.naGroup] > 0) order.push_back(state.naGroup);
+
+  groups = GroupValues();
+
+  for (vector<unsigned int>::iterator it = order.begin(); it != order.end(); ++it)
+  {
+    groups.isNA.push_back(state.keys.isNA[*it]);
+
+    if (!state.keys.values.empty()) groups.values.push_back(state.keys.values[*it]);
+    if (!state.keys.int64Values.empty()) groups.int64Values.push_back(state.keys.int64Values[*it]);
+    if (!state.keys.strings.empty()) groups.strings.push_back(state.keys.strings[*it]);
+  }
+
+  results.resize(columns.size() * order.size());
+
+  for (unsigned int pos = 0; pos < columns.size(); ++pos)
+  {
+    AggregateColumn &column = columns[pos];
+    column.groups.resize(state.NrOfGroups());
+
+    for (unsigned int groupNr = 0; groupNr < order.size(); ++groupNr)
+    {
+      SetResult(column, column.groups[order[groupNr]], results[pos * order.size() + groupNr]);
+    }
+  }
+}
+
+
+void FstAggregator::ReduceGroups(GroupState &state, vector<AggregateColumn> &columns, unsigned int chunkNr,
+  unsigned long long firstRow, unsigned long long length, const char* mask, int nrOfThreads)
+{
+  istream &myfile = *fstHandle.inputStream;
+  unsigned long long* blockPos = fstHandle.ChunkPositionData(chunkNr);
+  unsigned long long chunkRows = fstHandle.ChunkNrOfRows(chunkNr);
+  unsigned long long groupPos = blockPos[state.colNr];
+
+  myfile.clear();  // reset state from a previous read at the end of the file
+
+  if (state.byLevel)
+  {
+    // Each data chunk stores its own levels, which are mapped to the groups of the levels of earlier chunks
+    if (state.preparedChunk != (int) chunkNr)
+    {
+      StringVectorColumn levels;
+      unsigned int nrOfLevels = fdsReadFactorLevels_v7(myfile, &levels, groupPos);
+
+      if (state.naGroup < 0) state.naGroup = (int) state.AddGroup(0, true);
+
+      state.codeGroups.assign(nrOfLevels + 1, (unsigned int) state.naGroup);
+
+      for (unsigned int level = 0; level < nrOfLevels; ++level)
+      {
+        map<string, unsigned int>::iterator it = state.levelGroups.find(levels.strings[level]);
+
+        if (it == state.levelGroups.end())
+        {
+          unsigned int groupNr = state.AddGroup(0, false);
+          state.keys.strings[groupNr] = levels.strings[level];
+          it = state.levelGroups.insert(make_pair(levels.strings[level], groupNr)).first;
+        }
+
+        state.codeGroups[level + 1] = it->second;
+      }
+
+      state.preparedChunk = (int) chunkNr;
+    }
+
+    state.ints.resize(length);
+    myfile.clear();
+    fdsReadFactorCodes_v7(myfile, state.ints.data(), groupPos, firstRow, length, chunkRows, nrOfThreads);
+
+    // Selected rows of each level code
+    unsigned int nrOfSlots = (unsigned int) state.codeGroups.size();
+    vector<unsigned long long> slotRows(nrOfSlots, 0);
+
+    for (unsigned long long row = 0; row < length; ++row)
+    {
+      if (mask != nullptr && !mask[row]) continue;
+
+      int code = state.ints[row];
+      ++slotRows[code >= 1 && code < (int) nrOfSlots ? code : 0];
+    }
+
+    for (unsigned int slotNr = 0; slotNr < nrOfSlots; ++slotNr)
+    {
+      state.groupRows[state.codeGroups[slotNr]] += slotRows[slotNr];
+    }
+  }
+  else
+  {
+    switch (state.colType)
+    {
+      case 6:
+        state.strings.AllocateVec(length);
+        fdsReadCharVecAt_v6(myfile, &state.strings, groupPos, firstRow, length, chunkRows, 0);
+        break;
+
+      case 8:
+        state.ints.resize(length);
+        fdsReadIntVec_v8(myfile, state.ints.data(), groupPos, firstRow, length, chunkRows, nrOfThreads);
+        break;
+
+      case 9:
+        state.doubles.resize(length);
+        fdsReadRealVec_v9(myfile, state.doubles.data(), groupPos, firstRow, length, chunkRows, nrOfThreads);
+        break;
+
+      case 10:
+        state.ints.resize(length);
+        fdsReadLogicalVec_v10(myfile, state.ints.data(), groupPos, firstRow, length, chunkRows, nrOfThreads);
+        break;
+
+      case 11:
+        state.longs.resize(length);
+        fdsReadInt64Vec_v11(myfile, state.longs.data(), groupPos, firstRow, length, chunkRows, nrOfThreads);
+        break;
+
+      default:
+        throw(runtime_error("Unknown type found in column."));
+    }
+
+    // Boundaries of the runs of equal values, the first run can continue the last group of the previous batch
+    state.runEnds.clear();
+    state.runGroups.clear();
+
+    for (unsigned long long row = 1; row < length; ++row)
+    {
+      if (!state.SameValue(row - 1, row)) state.runEnds.push_back(row);
+    }
+
+    state.runEnds.push_back(length);
+
+    unsigned long long runStart = 0;
+
+    for (vector<unsigned long long>::iterator it = state.runEnds.begin(); it != state.runEnds.end(); ++it)
+    {
+      unsigned int groupNr = runStart == 0 && state.IsLastGroup(0) ? state.NrOfGroups() - 1 :
+        state.AddGroup(runStart, state.IsValueNA(runStart));
+
+      unsigned long long runRows = *it - runStart;
+
+      if (mask != nullptr)
+      {
+        runRows = 0;
+
+        for (unsigned long long row = runStart; row < *it; ++row)
+        {
+          runRows += mask[row];
+        }
+      }
+
+      state.runGroups.push_back(groupNr);
+      state.groupRows[groupNr] += runRows;
+      runStart = *it;
+    }
+  }
+
+  // Reduce the aggregated columns per group
+  for (vector<AggregateColumn>::iterator it = columns.begin(); it != columns.end(); ++it)
+  {
+    AggregateColumn &column = *it;
+
+    column.groups.resize(state.NrOfGroups());
+    DecompressColumn(myfile, column, blockPos[column.colNr], firstRow, length, chunkRows, nrOfThreads);
+
+    switch (column.colType)
+    {
+      case 9:
+        ReduceGroupValues<double, long double>(column.doubles.data(), mask, length, state, column.groups,
+          nrOfThreads);
+        break;
+
+      case 11:
+        ReduceGroupValues<long long, long double>(column.longs.data(), mask, length, state, column.groups,
+          nrOfThreads);
+        break;
+
+      default:  // character (NA flags), factor, integer and logical
+        ReduceGroupValues<int, long long>(column.ints.data(), mask, length, state, column.groups, nrOfThreads);
+        break;
+    }
+  }
+
+  rowsScanned += length;
+}
+
+
+bool FstAggregator::Distinct(int colNr, unsigned long long maxValues, GroupValues &values, int nrOfThreads)
+{
+  if (fstHandle.inputStream == nullptr)
+  {
+    throw(runtime_error("The fst file is not opened."));
+  }
+
+  rowsScanned = 0;
+  values = GroupValues();
+
+  istream &myfile = *fstHandle.inputStream;
+  AggregateColumn column(colNr, fstHandle.colTypes[colNr]);
+  bool hasNA = false;
+
+  // Levels of a factor column, in the order of the levels of the data chunks. Only the level codes of chunks
+  // without a zone map are decompressed, to determine if the column has NA values.
+  if (column.colType == 7)
+  {
+    map<string, unsigned int> levelIndex;
+    ZoneMap zoneMap;
+
+    for (unsigned int chunkNr = 0; chunkNr < fstHandle.NrOfChunks(); ++chunkNr)
+    {
+      unsigned long long* blockPos = fstHandle.ChunkPositionData(chunkNr);
+      unsigned long long chunkRows = fstHandle.ChunkNrOfRows(chunkNr);
+      StringVectorColumn levels;
+
+      myfile.clear();  // reset state from a previous read at the end of the file
+      unsigned int nrOfLevels = fdsReadFactorLevels_v7(myfile, &levels, blockPos[colNr]);
+
+      for (unsigned int level = 0; level < nrOfLevels; ++level)
+      {
+        if (levelIndex.insert(make_pair(levels.strings[level], 0)).second)
+        {
+          values.strings.push_back(levels.strings[level]);
+        }
+      }
+
+      if (maxValues > 0 && values.strings.size() > maxValues)
+      {
+        values = GroupValues();
+        return false;
+      }
+
+      if (hasNA) continue;
+
+      if (fstHandle.ReadZoneMap(chunkNr, colNr, zoneMap))
+      {
+        for (unsigned long long blockNr = 0; blockNr < zoneMap.NrOfBlocks(); ++blockNr)
+        {
+          if (zoneMap.Block(blockNr).naCount > 0) hasNA = true;
+        }
+
+        continue;
+      }
+
+      for (unsigned long long firstRow = 0; firstRow < chunkRows && !hasNA; firstRow += AGGR_BATCH_ROWS)
+      {
+        unsigned long long length = min((unsigned long long) AGGR_BATCH_ROWS, chunkRows - firstRow);
+
+        DecompressColumn(myfile, column, blockPos[colNr], firstRow, length, chunkRows, nrOfThreads);
+        hasNA = find(column.ints.begin(), column.ints.end(), INT_MIN) != column.ints.end();
+        rowsScanned += length;
+      }
+    }
+
+    values.isNA.assign(values.strings.size(), 0);
+
+    if (hasNA)
+    {
+      values.strings.push_back(string());
+      values.isNA.push_back(1);
+    }
+
+    return true;
+  }
+
+  unordered_set<int> intSet;
+  unordered_set<double> doubleSet;
+  unordered_set<long long> int64Set;
+  unordered_set<string> stringSet;
+
+  for (unsigned int chunkNr = 0; chunkNr < fstHandle.NrOfChunks(); ++chunkNr)
+  {
+    unsigned long long* blockPos = fstHandle.ChunkPositionData(chunkNr);
+    unsigned long long chunkRows = fstHandle.ChunkNrOfRows(chunkNr);
+    unsigned long long pos = blockPos[colNr];
+
+    for (unsigned long long firstRow = 0; firstRow < chunkRows; firstRow += AGGR_BATCH_ROWS)
+    {
+      unsigned long long length = min((unsigned long long) AGGR_BATCH_ROWS, chunkRows - firstRow);
+      unsigned long long nrOfValues;
+
+      myfile.clear();  // reset state from a previous read at the end of the file
+      rowsScanned += length;
+
+      switch (column.colType)
+      {
+        case 6:
+        {
+          StringVectorColumn strings;
+          strings.AllocateVec(length);
+          fdsReadCharVecAt_v6(myfile, &strings, pos, firstRow, length, chunkRows, 0);
+
+          for (unsigned long long row = 0; row < length; ++row)
+          {
+            if (strings.isNA[row])
+            {
+              hasNA = true;
+              continue;
+            }
+
+            stringSet.insert(strings.strings[row]);
+          }
+
+          nrOfValues = stringSet.size();
+          break;
+        }
+
+        case 9:
+          DecompressColumn(myfile, column, pos, firstRow, length, chunkRows, nrOfThreads);
+          InsertDistinct(column.doubles.data(), length, doubleSet, hasNA, nrOfThreads);
+          nrOfValues = doubleSet.size();
+          break;
+
+        case 11:
+          DecompressColumn(myfile, column, pos, firstRow, length, chunkRows, nrOfThreads);
+          InsertDistinct(column.longs.data(), length, int64Set, hasNA, nrOfThreads);
+          nrOfValues = int64Set.size();
+          break;
+
+        default:  // integer and logical, run-length encoded ranges are inserted once per run
+        {
+          bool hasRuns = column.colType == 8 ?
+            fdsReadIntRuns_v8(myfile, column.runValues, column.runEnds, pos, firstRow, length) :
+            fdsReadLogicalRuns_v10(myfile, column.runValues, column.runEnds, pos, firstRow, length);
+
+          if (hasRuns)
+          {
+            InsertDistinct(column.runValues.data(), column.runValues.size(), intSet, hasNA, 1);
+          }
+          else
+          {
+            DecompressColumn(myfile, column, pos, firstRow, length, chunkRows, nrOfThreads);
+            InsertDistinct(column.ints.data(), length, intSet, hasNA, nrOfThreads);
+          }
+
+          nrOfValues = intSet.size();
+          break;
+        }
+      }
+
+      if (maxValues > 0 && nrOfValues > maxValues) return false;
+    }
+  }
+
+  // Sorted values with NA last
+  switch (column.colType)
+  {
+    case 6:
+      values.strings.assign(stringSet.begin(), stringSet.end());
+      sort(values.strings.begin(), values.strings.end());
+      values.isNA.assign(values.strings.size(), 0);
+      if (hasNA) values.strings.push_back(string());
+      break;
+
+    case 9:
+      values.values.assign(doubleSet.begin(), doubleSet.end());
+      sort(values.values.begin(), values.values.end());
+      values.isNA.assign(values.values.size(), 0);
+      if (hasNA) values.values.push_back(NAN);
+      break;
+
+    case 11:
+      values.int64Values.assign(int64Set.begin(), int64Set.end());
+      sort(values.int64Values.begin(), values.int64Values.end());
+      values.isNA.assign(values.int64Values.size(), 0);
+      if (hasNA) values.int64Values.push_back(LLONG_MIN);
+      break;
+
+    default:
+      values.values.assign(intSet.begin(), intSet.end());
+      sort(values.values.begin(), values.values.end());
+      values.isNA.assign(values.values.size(), 0);
+      if (hasNA) values.values.push_back(NAN);
+      break;
+  }
+
+  if (hasNA) values.isNA.push_back(1);
+
+  return true;
+}
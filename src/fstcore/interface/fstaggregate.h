@@ -0,0 +1,169 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_AGGREGATE_H
+#define FST_AGGREGATE_H
+
+
+#include <string>
+#include <vector>
+
+#include <fsthandle.h>
+#include <fstfilter.h>
+
+
+// Aggregate functions, combined as a bit mask
+#define AGGREGATE_SUM   1
+#define AGGREGATE_COUNT 2
+#define AGGREGATE_MIN   4
+#define AGGREGATE_MAX   8
+
+
+/**
+ Aggregates of a single column. NA values (and NaN values of double columns) are skipped. The minimum and maximum
+ are NaN if the column has no values. Character and factor columns only have a count, their sum, minimum and
+ maximum are NaN.
+ */
+struct ColumnAggregate
+{
+  unsigned long long count;  // number of non-NA values
+  double sum;
+  double minValue;
+  double maxValue;
+};
+
+
+/**
+ Values of a column, such as the values of the group column of each group of a grouped aggregate. Only the vector
+ that matches the type of the column is used, NA values are marked in isNA.
+ */
+struct GroupValues
+{
+  std::vector<char> isNA;
+  std::vector<double> values;         // integer, logical, double, date and timestamp columns
+  std::vector<long long> int64Values;  // 64-bit integer columns
+  std::vector<std::string> strings;   // character and factor columns
+};
+
+
+class AggregateColumn;
+class GroupState;
+
+
+/**
+ Computes aggregates of columns without reading the columns into memory. The column data is decompressed in
+ batches of at most AGGR_BATCH_ROWS rows into buffers that are reused for all batches, and each batch is reduced
+ in parallel. Run-length encoded integer, logical and factor columns are reduced once per run.
+
+ Without a row filter, the count, minimum and maximum of a data chunk are taken from the zone maps of the columns,
+ so only the sum requires decompressing the column data. With a row filter, only the batches of rows that can
+ contain matching rows (see FstFilter::ScanRows) are decompressed.
+ */
+class FstAggregator
+{
+  FstHandle &fstHandle;
+  unsigned long long rowsScanned;
+
+  // Decompress and reduce rows firstRow until firstRow + length of a data chunk. If mask is set, only the rows for
+  // which the mask is 1 are reduced.
+  void ReduceRange(std::vector<AggregateColumn> &columns, unsigned int chunkNr, unsigned long long firstRow,
+    unsigned long long length, const char* mask, int nrOfThreads);
+
+  // Decompress rows firstRow until firstRow + length of a data chunk and reduce them per group
+  void ReduceGroups(GroupState &state, std::vector<AggregateColumn> &columns, unsigned int chunkNr,
+    unsigned long long firstRow, unsigned long long length, const char* mask, int nrOfThreads);
+
+  friend class AggregateRowMask;  // reduces the batches of rows evaluated by a row filter
+
+public:
+  FstAggregator(FstHandle &fstHandle) : fstHandle(fstHandle), rowsScanned(0) {}
+
+  /**
+   Compute the aggregates of a set of columns.
+
+   @param colIndex Column numbers of the aggregated columns, determined with FstHandle::SelectColumns.
+   @param functions Combination of AGGREGATE_SUM, AGGREGATE_COUNT, AGGREGATE_MIN and AGGREGATE_MAX. Aggregates
+     that are not requested are undefined.
+   @param predicate Optional row filter (nullptr for all rows), only the rows that satisfy the filter are aggregated.
+   @param results Receives the aggregates of each selected column.
+   @param nrOfThreads Number of threads used for decompressing and reducing the column data.
+   */
+  void Aggregate(const std::vector<int> &colIndex, int functions, const FstPredicate* predicate,
+    std::vector<ColumnAggregate> &results, int nrOfThreads);
+
+  /**
+   Compute the aggregates of a set of columns for each group of rows with equal values in a group column. The group
+   column should be a factor column or the leading key column of the table. Rows of factor columns are assigned to
+   their groups with a lookup table of the level codes, the groups of a key column are the runs of equal values in
+   the sorted column. Only groups with at least one (selected) row are returned. The groups of a factor column are
+   ordered as the levels, with the NA group last, and the groups of a key column are in the sorted order of the key.
+
+   @param colIndex Column numbers of the aggregated columns, determined with FstHandle::SelectColumns.
+   @param groupColNr Column number of the group column.
+   @param predicate Optional row filter (nullptr for all rows), only the rows that satisfy the filter are aggregated.
+   @param groups Receives the values of the group column of each group.
+   @param results Receives the aggregates of each group for each selected column, the aggregate of group g of
+     selected column c is at position c * (number of groups) + g.
+   @param nrOfThreads Number of threads used for decompressing and reducing the column data.
+   @throws runtime_error if the group column is not a factor or leading key column.
+   */
+  void AggregateGroups(const std::vector<int> &colIndex, int groupColNr, const FstPredicate* predicate,
+    GroupValues &groups, std::vector<ColumnAggregate> &results, int nrOfThreads);
+
+  /**
+   Determine the distinct values of a column. The distinct values of a factor column are its levels, which are read
+   without decompressing the level codes of the rows (levels without rows are included). The values of other
+   columns are decompressed in batches and collected in hash sets, one for each thread.
+
+   @param colNr Column number.
+   @param maxValues Maximum number of distinct (non-NA) values, 0 for no maximum. The scan stops as soon as more
+     distinct values are found.
+   @param values Receives the distinct values. Values of factor columns are in the order of the levels, other
+     values are sorted (character values bytewise). The NA value, if present, is last.
+   @param nrOfThreads Number of threads used for decompressing and collecting the column data.
+   @return false if the column has more than maxValues distinct values, values is then empty.
+   */
+  bool Distinct(int colNr, unsigned long long maxValues, GroupValues &values, int nrOfThreads);
+
+  /**
+   Number of rows of the aggregated columns that were decompressed by the last call to Aggregate, AggregateGroups
+   or Distinct.
+   */
+  unsigned long long RowsScanned() const { return rowsScanned; }
+};
+
+
+#endif  // FST_AGGREGATE_H
@@ -0,0 +1,978 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <fstarrow.h>
+#include <vectorcolumn.h>
+#include <compression.h>
+#include <bitmapruns.h>
+
+
+using namespace std;
+
+
+// R's NA value of doubles
+inline double RealNA()
+{
+  unsigned long long naBits = REAL_NA_BITS;
+  double naValue;
+  memcpy(&naValue, &naBits, sizeof(double));
+  return naValue;
+}
+
+
+// Elements of a string block or level set with BufferToVec and LevelsToVec
+void ArrowStringColumn::SetElement(unsigned long long vecPos, const char* str, unsigned int size, bool isNA)
+{
+  if (isNA)
+  {
+    validity[vecPos / 8] &= (unsigned char) ~(1u << (vecPos % 8));
+    ++nullCount;
+  }
+
+  starts[vecPos] = chars.size();
+  chars.insert(chars.end(), str, str + size);
+  ends[vecPos] = chars.size();
+}
+
+
+void ArrowStringColumn::AllocateVec(unsigned long long vecLength)
+{
+  offsets.assign(vecLength + 1, 0);
+  validity.assign((vecLength + 7) / 8, 0xFF);
+  chars.clear();
+  starts.clear();
+  ends.clear();
+  nullCount = 0;
+  nextElem = 0;
+}
+
+
+void ArrowStringColumn::BufferToVec(unsigned int nrOfElements, unsigned int startElem, unsigned int endElem,
+  unsigned long long vecOffset, unsigned int* sizeMeta, char* buf)
+{
+  unsigned int* bitsNA = &sizeMeta[nrOfElements];
+  unsigned int pos = startElem == 0 ? 0 : sizeMeta[startElem - 1];
+
+  if (vecOffset == nextElem && starts.empty())
+  {
+    // The characters of the elements are appended as a whole
+    long long bufOffset = (long long) chars.size() - pos;
+    chars.insert(chars.end(), &buf[pos], &buf[sizeMeta[endElem]]);
+
+    for (unsigned int elem = startElem; elem <= endElem; ++elem)
+    {
+      offsets[vecOffset + elem - startElem + 1] = bufOffset + sizeMeta[elem];
+    }
+
+    // Only the NA runs are visited
+    BitmapRuns(bitsNA, startElem, endElem + 1, [&](unsigned int runStart, unsigned int runEnd, bool isNA)
+    {
+      if (!isNA) return;
+
+      for (unsigned long long vecPos = vecOffset + runStart - startElem; vecPos != vecOffset + runEnd - startElem;
+        ++vecPos)
+      {
+        validity[vecPos / 8] &= (unsigned char) ~(1u << (vecPos % 8));
+      }
+
+      nullCount += runEnd - runStart;
+    });
+
+    nextElem = vecOffset + endElem - startElem + 1;
+    return;
+  }
+
+  // Elements out of order are located by their start and end
+  if (starts.empty())
+  {
+    unsigned long long vecLength = offsets.size() - 1;
+    starts.assign(vecLength, 0);
+    ends.assign(vecLength, 0);
+
+    for (unsigned long long vecPos = 0; vecPos < nextElem; ++vecPos)
+    {
+      starts[vecPos] = offsets[vecPos];
+      ends[vecPos] = offsets[vecPos + 1];
+    }
+  }
+
+  BitmapRuns(bitsNA, startElem, endElem + 1, [&](unsigned int runStart, unsigned int runEnd, bool isNA)
+  {
+    for (unsigned int elem = runStart; elem != runEnd; ++elem)
+    {
+      unsigned int newPos = sizeMeta[elem];
+      SetElement(vecOffset + elem - startElem, &buf[pos], newPos - pos, isNA);
+      pos = newPos;
+    }
+  });
+}
+
+
+bool ArrowStringColumn::LevelsToVec(unsigned long long vecOffset, unsigned long long length, const int* codes,
+  unsigned int nrOfLevels, const unsigned int* levelSizes, const char* levelBuf)
+{
+  if (vecOffset != nextElem || !starts.empty()) return false;
+
+  for (unsigned long long elem = 0; elem < length; ++elem)
+  {
+    unsigned long long vecPos = vecOffset + elem;
+    int code = codes[elem];
+
+    if (code == INT_MIN)
+    {
+      validity[vecPos / 8] &= (unsigned char) ~(1u << (vecPos % 8));
+      ++nullCount;
+    }
+    else
+    {
+      unsigned int start = code == 1 ? 0 : levelSizes[code - 2];
+      chars.insert(chars.end(), &levelBuf[start], &levelBuf[levelSizes[code - 1]]);
+    }
+
+    offsets[vecPos + 1] = chars.size();
+  }
+
+  nextElem = vecOffset + length;
+  return true;
+}
+
+
+const char* ArrowStringColumn::GetElement(int elementNr)
+{
+  if (starts.empty())
+  {
+    element.assign(&chars[0] + offsets[elementNr], offsets[elementNr + 1] - offsets[elementNr]);
+  }
+  else
+  {
+    element.assign(&chars[0] + starts[elementNr], ends[elementNr] - starts[elementNr]);
+  }
+
+  return element.c_str();
+}
+
+
+void ArrowStringColumn::Finish()
+{
+  unsigned long long vecLength = offsets.size() - 1;
+
+  if (starts.empty())
+  {
+    // Elements that were never set are empty
+    for (unsigned long long vecPos = nextElem; vecPos < vecLength; ++vecPos) offsets[vecPos + 1] = chars.size();
+    nextElem = vecLength;
+    return;
+  }
+
+  vector<char> orderedChars;
+  orderedChars.reserve(chars.size());
+
+  for (unsigned long long vecPos = 0; vecPos < vecLength; ++vecPos)
+  {
+    orderedChars.insert(orderedChars.end(), chars.begin() + starts[vecPos], chars.begin() + ends[vecPos]);
+    offsets[vecPos + 1] = orderedChars.size();
+  }
+
+  chars.swap(orderedChars);
+  starts.clear();
+  ends.clear();
+  nextElem = vecLength;
+}
+
+
+/**
+ Buffers of an exported array, owned by the array (as its private data) and released with it. Only the vectors of
+ the layout of the array are used.
+ */
+struct ArrowArrayData
+{
+  string format;
+  unsigned long long length;
+  long long nullCount;
+
+  vector<unsigned char> validity;  // bit per element, set for valid elements
+  vector<int> ints;                // int32, date32 and dictionary index values and string offsets
+  vector<long long> longs;         // int64 and timestamp values and large string offsets
+  vector<double> doubles;
+  vector<unsigned char> bits;      // boolean values
+  vector<char> chars;              // string characters
+  vector<const void*> buffers;
+
+  vector<ArrowArray> childArrays;
+  vector<ArrowArray*> children;
+  ArrowArrayData* dictionaryData;  // dictionary values, until exported to dictionary
+  ArrowArray dictionary;
+
+  ArrowArrayData(unsigned long long length) : length(length), nullCount(0), dictionaryData(nullptr) {}
+
+  ~ArrowArrayData() { delete dictionaryData; }
+
+  // Validity buffer, absent without null elements
+  const void* Validity() { return nullCount == 0 ? nullptr : validity.data(); }
+
+  // Clear the validity bit of each value that equals naValue
+  template<typename T>
+  void SetValidity(const T* values, T naValue)
+  {
+    validity.assign((length + 7) / 8, 0xFF);
+
+    for (unsigned long long pos = 0; pos < length; ++pos)
+    {
+      if (values[pos] != naValue) continue;
+
+      validity[pos / 8] &= (unsigned char) ~(1u << (pos % 8));
+      ++nullCount;
+    }
+  }
+};
+
+
+// Schema of an exported array, owned by the schema (as its private data)
+struct ArrowSchemaData
+{
+  string format;
+  string name;
+  vector<ArrowSchema> childSchemas;
+  vector<ArrowSchema*> children;
+  ArrowSchemaData* dictionaryData;  // dictionary schema, until exported to dictionary
+  ArrowSchema dictionary;
+
+  ArrowSchemaData(const string &format, const string &name) : format(format), name(name), dictionaryData(nullptr) {}
+
+  ~ArrowSchemaData() { delete dictionaryData; }
+};
+
+
+void ReleaseArray(ArrowArray* array)
+{
+  ArrowArrayData* data = static_cast<ArrowArrayData*>(array->private_data);
+
+  for (ArrowArray* child : data->children)
+  {
+    if (child->release != nullptr) child->release(child);
+  }
+
+  if (array->dictionary != nullptr && array->dictionary->release != nullptr)
+  {
+    array->dictionary->release(array->dictionary);
+  }
+
+  delete data;
+  array->release = nullptr;
+}
+
+
+void ReleaseSchema(ArrowSchema* schema)
+{
+  ArrowSchemaData* data = static_cast<ArrowSchemaData*>(schema->private_data);
+
+  for (ArrowSchema* child : data->children)
+  {
+    if (child->release != nullptr) child->release(child);
+  }
+
+  if (schema->dictionary != nullptr && schema->dictionary->release != nullptr)
+  {
+    schema->dictionary->release(schema->dictionary);
+  }
+
+  delete data;
+  schema->release = nullptr;
+}
+
+
+// Move the array data to an Arrow array, the array (and its dictionary) own the data
+void ExportArray(ArrowArrayData* data, ArrowArray* array)
+{
+  array->length = (int64_t) data->length;
+  array->null_count = data->nullCount;
+  array->offset = 0;
+  array->n_buffers = (int64_t) data->buffers.size();
+  array->buffers = data->buffers.data();
+  array->n_children = (int64_t) data->children.size();
+  array->children = data->children.empty() ? nullptr : data->children.data();
+  array->dictionary = nullptr;
+  array->release = ReleaseArray;
+  array->private_data = data;
+
+  if (data->dictionaryData != nullptr)
+  {
+    ExportArray(data->dictionaryData, &data->dictionary);
+    data->dictionaryData = nullptr;
+    array->dictionary = &data->dictionary;
+  }
+}
+
+
+void ExportSchema(ArrowSchemaData* data, ArrowSchema* schema, int64_t flags)
+{
+  schema->format = data->format.c_str();
+  schema->name = data->name.c_str();
+  schema->metadata = nullptr;
+  schema->flags = flags;
+  schema->n_children = (int64_t) data->children.size();
+  schema->children = data->children.empty() ? nullptr : data->children.data();
+  schema->dictionary = nullptr;
+  schema->release = ReleaseSchema;
+  schema->private_data = data;
+
+  if (data->dictionaryData != nullptr)
+  {
+    ExportSchema(data->dictionaryData, &data->dictionary, ARROW_FLAG_NULLABLE);
+    data->dictionaryData = nullptr;
+    schema->dictionary = &data->dictionary;
+  }
+}
+
+
+// Move the elements of a string column to a utf8 array, or large_utf8 if the offsets exceed 32 bits or largeStrings
+// is set
+ArrowArrayData* StringArrayData(ArrowStringColumn &column, bool largeStrings)
+{
+  column.Finish();
+
+  unsigned long long length = column.offsets.size() - 1;
+  ArrowArrayData* data = new ArrowArrayData(length);
+  data->nullCount = (long long) column.nullCount;
+  data->validity.swap(column.validity);
+  data->chars.swap(column.chars);
+  if (data->chars.empty()) data->chars.resize(1);  // data buffer can't be null
+
+  if (!largeStrings && column.offsets[length] <= INT_MAX)
+  {
+    data->format = "u";
+    data->ints.assign(column.offsets.begin(), column.offsets.end());
+    data->buffers = { data->Validity(), data->ints.data(), data->chars.data() };
+  }
+  else
+  {
+    data->format = "U";
+    data->longs.swap(column.offsets);
+    data->buffers = { data->Validity(), data->longs.data(), data->chars.data() };
+  }
+
+  return data;
+}
+
+
+ArrowTableReader::ArrowTableReader(const vector<FstColumnType> &colTypes, const vector<string> &colNames,
+  bool largeStrings) : colTypes(colTypes), colNames(colNames), columns(colTypes.size(), nullptr), nrOfRows(0),
+  largeStrings(largeStrings)
+{
+}
+
+
+ArrowTableReader::~ArrowTableReader()
+{
+  for (ArrowArrayData* column : columns) delete column;
+}
+
+
+ArrowArrayData* ArrowTableReader::NewColumn(int colNr)
+{
+  delete columns[colNr];
+  columns[colNr] = new ArrowArrayData(nrOfRows);
+  return columns[colNr];
+}
+
+
+ILogicalColumn* ArrowTableReader::CreateLogicalColumn(unsigned long long nrOfRows)
+{
+  return new LogicalVectorColumn(nrOfRows);
+}
+
+
+IDoubleColumn* ArrowTableReader::CreateDoubleColumn(unsigned long long nrOfRows)
+{
+  return new DoubleVectorColumn(nrOfRows);
+}
+
+
+IIntegerColumn* ArrowTableReader::CreateIntegerColumn(unsigned long long nrOfRows)
+{
+  return new IntVectorColumn(nrOfRows);
+}
+
+
+IInt64Column* ArrowTableReader::CreateInt64Column(unsigned long long nrOfRows)
+{
+  return new Int64VectorColumn(nrOfRows);
+}
+
+
+void ArrowTableReader::AddCharColumn(IStringColumn* stringColumn, int colNr)
+{
+  delete columns[colNr];
+  columns[colNr] = StringArrayData(*static_cast<ArrowStringColumn*>(stringColumn), largeStrings);
+}
+
+
+void ArrowTableReader::AddLogicalColumn(ILogicalColumn* logicalColumn, int colNr)
+{
+  ArrowArrayData* data = NewColumn(colNr);
+  const int* values = logicalColumn->Data();
+
+  data->format = "b";
+  data->SetValidity(values, INT_MIN);
+  data->bits.assign((nrOfRows + 7) / 8 + 1, 0);
+
+  for (unsigned long long pos = 0; pos < nrOfRows; ++pos)
+  {
+    if (values[pos] == 1) data->bits[pos / 8] |= (unsigned char) (1u << (pos % 8));
+  }
+
+  data->buffers = { data->Validity(), data->bits.data() };
+}
+
+
+void ArrowTableReader::AddIntegerColumn(IIntegerColumn* integerColumn, int colNr)
+{
+  ArrowArrayData* data = NewColumn(colNr);
+
+  data->format = "i";
+  data->ints.swap(static_cast<IntVectorColumn*>(integerColumn)->data);
+  data->SetValidity(data->ints.data(), INT_MIN);
+  data->buffers = { data->Validity(), data->ints.data() };
+}
+
+
+void ArrowTableReader::AddDoubleColumn(IDoubleColumn* doubleColumn, int colNr, FstColumnType colType)
+{
+  ArrowArrayData* data = NewColumn(colNr);
+  vector<double> &values = static_cast<DoubleVectorColumn*>(doubleColumn)->data;
+
+  if (colType == FstColumnType::DOUBLE_64)
+  {
+    // Only R's NA is null, other NaN values are kept
+    double naValue = RealNA();
+
+    data->format = "g";
+    data->doubles.swap(values);
+    data->validity.assign((nrOfRows + 7) / 8, 0xFF);
+
+    for (unsigned long long pos = 0; pos < nrOfRows; ++pos)
+    {
+      if (memcmp(&data->doubles[pos], &naValue, sizeof(double)) != 0) continue;
+
+      data->validity[pos / 8] &= (unsigned char) ~(1u << (pos % 8));
+      ++data->nullCount;
+    }
+
+    data->buffers = { data->Validity(), data->doubles.data() };
+    return;
+  }
+
+  // Dates and timestamps with a NaN value are null
+  data->validity.assign((nrOfRows + 7) / 8, 0xFF);
+
+  for (unsigned long long pos = 0; pos < nrOfRows; ++pos)
+  {
+    if (values[pos] == values[pos]) continue;
+
+    data->validity[pos / 8] &= (unsigned char) ~(1u << (pos % 8));
+    ++data->nullCount;
+  }
+
+  if (colType == FstColumnType::DATE_DAYS)
+  {
+    data->format = "tdD";
+    data->ints.resize(nrOfRows);
+
+    for (unsigned long long pos = 0; pos < nrOfRows; ++pos)
+    {
+      data->ints[pos] = values[pos] == values[pos] ? (int) floor(values[pos]) : 0;
+    }
+
+    data->buffers = { data->Validity(), data->ints.data() };
+    return;
+  }
+
+  data->format = "tsu:UTC";
+  data->longs.resize(nrOfRows);
+
+  for (unsigned long long pos = 0; pos < nrOfRows; ++pos)
+  {
+    data->longs[pos] = values[pos] == values[pos] ? llround(values[pos] * 1e6) : 0;
+  }
+
+  data->buffers = { data->Validity(), data->longs.data() };
+}
+
+
+void ArrowTableReader::AddInt64Column(IInt64Column* int64Column, int colNr)
+{
+  ArrowArrayData* data = NewColumn(colNr);
+
+  data->format = "l";
+  data->longs.swap(static_cast<Int64VectorColumn*>(int64Column)->data);
+  data->SetValidity(data->longs.data(), LLONG_MIN);
+  data->buffers = { data->Validity(), data->longs.data() };
+}
+
+
+void ArrowTableReader::AddFactorColumn(IFactorColumn* factorColumn, int colNr)
+{
+  ArrowFactorColumn* column = static_cast<ArrowFactorColumn*>(factorColumn);
+  ArrowArrayData* data = NewColumn(colNr);
+
+  // Dictionary indices are the 0-based level codes
+  data->format = "i";
+  data->ints.swap(column->data);
+  data->SetValidity(data->ints.data(), INT_MIN);
+
+  for (int &code : data->ints)
+  {
+    code = code == INT_MIN ? 0 : code - 1;
+  }
+
+  data->buffers = { data->Validity(), data->ints.data() };
+  data->dictionaryData = StringArrayData(column->levels, largeStrings);
+}
+
+
+void ArrowTableReader::Export(ArrowSchema* schema, ArrowArray* array)
+{
+  unsigned int nrOfCols = (unsigned int) colTypes.size();
+
+  for (unsigned int colNr = 0; colNr < nrOfCols; ++colNr)
+  {
+    if (columns[colNr] == nullptr) throw(runtime_error("Column '" + colNames[colNr] + "' was not read."));
+  }
+
+  ArrowSchemaData* schemaData = new ArrowSchemaData("+s", "");
+  schemaData->childSchemas.resize(nrOfCols);
+
+  ArrowArrayData* arrayData = new ArrowArrayData(nrOfRows);
+  arrayData->buffers = { nullptr };
+  arrayData->childArrays.resize(nrOfCols);
+
+  for (unsigned int colNr = 0; colNr < nrOfCols; ++colNr)
+  {
+    ArrowArrayData* column = columns[colNr];
+    ArrowSchemaData* colSchema = new ArrowSchemaData(column->format, colNames[colNr]);
+
+    if (column->dictionaryData != nullptr)
+    {
+      colSchema->dictionaryData = new ArrowSchemaData(column->dictionaryData->format, "");
+    }
+
+    ExportSchema(colSchema, &schemaData->childSchemas[colNr], ARROW_FLAG_NULLABLE);
+    schemaData->children.push_back(&schemaData->childSchemas[colNr]);
+
+    ExportArray(column, &arrayData->childArrays[colNr]);
+    arrayData->children.push_back(&arrayData->childArrays[colNr]);
+    columns[colNr] = nullptr;
+  }
+
+  ExportSchema(schemaData, schema, 0);
+  ExportArray(arrayData, array);
+}
+
+
+// Whether element pos (including the offset of the array) of an Arrow array is not null
+inline bool IsValid(const ArrowArray* array, unsigned long long pos)
+{
+  const unsigned char* validity = static_cast<const unsigned char*>(array->buffers[0]);
+  if (validity == nullptr) return true;
+
+  return (validity[pos / 8] >> (pos % 8)) & 1;
+}
+
+
+inline bool HasNulls(const ArrowArray* array)
+{
+  return array->null_count != 0 && array->n_buffers > 0 && array->buffers[0] != nullptr;
+}
+
+
+// Values of an Arrow array converted to type T, with naValue for null elements
+template<typename S, typename T, typename Convert>
+void ConvertValues(const ArrowArray* array, unsigned long long firstElem, unsigned long long length,
+  vector<T> &values, T naValue, Convert convert)
+{
+  const S* source = static_cast<const S*>(array->buffers[1]);
+  values.resize(length);
+
+  for (unsigned long long pos = 0; pos < length; ++pos)
+  {
+    unsigned long long elem = firstElem + pos;
+    values[pos] = IsValid(array, elem) ? convert(source[elem]) : naValue;
+  }
+}
+
+
+template<typename T>
+void CopyValues(const ArrowArray* array, unsigned long long firstElem, unsigned long long length,
+  vector<T> &values, T naValue)
+{
+  ConvertValues<T>(array, firstElem, length, values, naValue, [](T value) { return value; });
+}
+
+
+/**
+ Block writer of the elements of an Arrow string array. Without null elements that have characters, the blocks are
+ taken from the character buffer of the array.
+ */
+class ArrowStringWriter : public IBlockWriter
+{
+  const ArrowArray* array;
+  unsigned long long firstElem;  // position of element 0 in the buffers
+  bool largeOffsets;
+  const char* chars;
+  std::vector<unsigned int> sizeBuf;
+  std::vector<unsigned int> naBuf;
+  std::vector<char> charBuf;
+
+  unsigned long long Offset(unsigned long long pos)
+  {
+    if (largeOffsets) return (unsigned long long) static_cast<const int64_t*>(array->buffers[1])[pos];
+
+    return (unsigned long long) static_cast<const int32_t*>(array->buffers[1])[pos];
+  }
+
+public:
+  ArrowStringWriter(const ArrowArray* array, unsigned long long firstElem, unsigned long long length,
+    bool largeOffsets) : array(array), firstElem(firstElem), largeOffsets(largeOffsets),
+    sizeBuf(CHAR_MAX_BLOCK_SIZE), naBuf(1 + CHAR_MAX_BLOCK_SIZE / 32), charBuf(1)
+  {
+    chars = static_cast<const char*>(array->buffers[2]);
+    strSizes = sizeBuf.data();
+    naInts = naBuf.data();
+    bufSize = 0;
+    activeBuf = charBuf.data();
+    vecLength = length;
+  }
+
+  void SetBuffersFromVec(unsigned long long startCount, unsigned long long endCount)
+  {
+    unsigned int nrOfElements = static_cast<unsigned int>(endCount - startCount);
+    unsigned int nrOfNAInts = 1 + nrOfElements / 32;  // last bit is NA flag
+    unsigned int hasNA = 0;
+    bool copyChars = false;
+
+    std::fill(naBuf.begin(), naBuf.begin() + nrOfNAInts, 0);
+
+    unsigned long long blockStart = Offset(firstElem + startCount);
+
+    for (unsigned int elem = 0; elem < nrOfElements; ++elem)
+    {
+      unsigned long long pos = firstElem + startCount + elem;
+
+      if (!IsValid(array, pos))
+      {
+        ++hasNA;
+        naInts[elem / 32] |= 1u << (elem % 32);
+
+        // null elements can have characters, which are skipped
+        if (Offset(pos + 1) != Offset(pos)) copyChars = true;
+      }
+
+      strSizes[elem] = static_cast<unsigned int>(Offset(pos + 1) - blockStart);
+    }
+
+    if (hasNA != 0) naInts[nrOfNAInts - 1] |= 1u << (nrOfElements % 32);
+
+    if (!copyChars)
+    {
+      bufSize = strSizes[nrOfElements - 1];
+
+      // keeps the buffer non-empty
+      activeBuf = bufSize == 0 ? charBuf.data() : const_cast<char*>(chars + blockStart);
+      return;
+    }
+
+    charBuf.resize(1);
+
+    for (unsigned int elem = 0; elem < nrOfElements; ++elem)
+    {
+      unsigned long long pos = firstElem + startCount + elem;
+
+      if (IsValid(array, pos)) charBuf.insert(charBuf.end(), chars + Offset(pos), chars + Offset(pos + 1));
+      strSizes[elem] = static_cast<unsigned int>(charBuf.size() - 1);
+    }
+
+    activeBuf = charBuf.data() + 1;
+    bufSize = static_cast<unsigned int>(charBuf.size() - 1);
+  }
+
+  // The characters of null elements are skipped, as in SetBuffersFromVec
+  bool GatherStrings(unsigned long long startCount, unsigned long long endCount, const char** strings,
+    unsigned int* sizes, unsigned int* naBits)
+  {
+    unsigned int nrOfElements = static_cast<unsigned int>(endCount - startCount);
+    unsigned int nrOfNAInts = 1 + nrOfElements / 32;  // last bit is NA flag
+    unsigned int hasNA = 0;
+
+    std::fill(naBits, naBits + nrOfNAInts, 0);
+
+    for (unsigned int elem = 0; elem < nrOfElements; ++elem)
+    {
+      unsigned long long pos = firstElem + startCount + elem;
+      unsigned long long offset = Offset(pos);
+
+      strings[elem] = chars + offset;
+      sizes[elem] = static_cast<unsigned int>(Offset(pos + 1) - offset);
+
+      if (!IsValid(array, pos))
+      {
+        ++hasNA;
+        naBits[elem / 32] |= 1u << (elem % 32);
+        sizes[elem] = 0;
+      }
+    }
+
+    if (hasNA != 0) naBits[nrOfNAInts - 1] |= 1u << (nrOfElements % 32);
+
+    return true;
+  }
+};
+
+
+inline bool IsStringFormat(const string &format)
+{
+  return format == "u" || format == "U";
+}
+
+
+ArrowTable::ArrowTable(const ArrowSchema* schema, const ArrowArray* array) : array(array)
+{
+  if (schema == nullptr || array == nullptr || schema->release == nullptr || array->release == nullptr)
+  {
+    throw(runtime_error("The Arrow schema or array is missing or released."));
+  }
+
+  if (string(schema->format) != "+s" || array->n_children != schema->n_children)
+  {
+    throw(runtime_error("The Arrow array should be a struct array with a child array for each column."));
+  }
+
+  if (HasNulls(array)) throw(runtime_error("The Arrow struct array can't have null rows."));
+
+  unsigned int nrOfCols = (unsigned int) schema->n_children;
+  colArrays.resize(nrOfCols);
+  colOffsets.resize(nrOfCols);
+  colTypes.resize(nrOfCols);
+  largeStrings.resize(nrOfCols);
+  colData.resize(nrOfCols);
+  ints.resize(nrOfCols);
+  doubles.resize(nrOfCols);
+  longs.resize(nrOfCols);
+  colNames.AllocateVec(nrOfCols);
+
+  for (unsigned int colNr = 0; colNr < nrOfCols; ++colNr)
+  {
+    const ArrowSchema* colSchema = schema->children[colNr];
+    colNames.strings[colNr] = colSchema->name == nullptr ? "" : colSchema->name;
+
+    colArrays[colNr] = array->children[colNr];
+    colOffsets[colNr] = (unsigned long long) (array->offset + colArrays[colNr]->offset);
+
+    if (colArrays[colNr]->length < array->offset + array->length)
+    {
+      throw(runtime_error("Column '" + colNames.strings[colNr] + "' has less elements than the Arrow array."));
+    }
+
+    AddColumn(colNr, colSchema);
+  }
+}
+
+
+void ArrowTable::AddColumn(unsigned int colNr, const ArrowSchema* colSchema)
+{
+  const ArrowArray* colArray = colArrays[colNr];
+  string format = colSchema->format;
+  unsigned long long firstElem = colOffsets[colNr];
+  unsigned long long nrOfRows = NrOfRows();
+  bool hasNulls = HasNulls(colArray);
+
+  // Dictionary arrays with string values are factors
+  if (colSchema->dictionary != nullptr)
+  {
+    if (string("cCsSiIlL").find(format) == string::npos || format.size() != 1 ||
+      !IsStringFormat(colSchema->dictionary->format) || colArray->dictionary == nullptr)
+    {
+      throw(runtime_error("Column '" + colNames.strings[colNr] +
+        "' is a dictionary array without integer indices or string values."));
+    }
+
+    vector<int> &codes = ints[colNr];
+    auto toCode = [](long long index) { return (int) index + 1; };
+
+    switch (format[0])
+    {
+      case 'c': ConvertValues<int8_t>(colArray, firstElem, nrOfRows, codes, INT_MIN, toCode); break;
+      case 'C': ConvertValues<uint8_t>(colArray, firstElem, nrOfRows, codes, INT_MIN, toCode); break;
+      case 's': ConvertValues<int16_t>(colArray, firstElem, nrOfRows, codes, INT_MIN, toCode); break;
+      case 'S': ConvertValues<uint16_t>(colArray, firstElem, nrOfRows, codes, INT_MIN, toCode); break;
+      case 'i': ConvertValues<int32_t>(colArray, firstElem, nrOfRows, codes, INT_MIN, toCode); break;
+      case 'I': ConvertValues<uint32_t>(colArray, firstElem, nrOfRows, codes, INT_MIN, toCode); break;
+      case 'l': ConvertValues<int64_t>(colArray, firstElem, nrOfRows, codes, INT_MIN, toCode); break;
+      default: ConvertValues<uint64_t>(colArray, firstElem, nrOfRows, codes, INT_MIN, toCode); break;
+    }
+
+    colTypes[colNr] = FstColumnType::FACTOR;
+    largeStrings[colNr] = string(colSchema->dictionary->format) == "U";
+    colData[colNr] = codes.data();
+    return;
+  }
+
+  if (IsStringFormat(format))
+  {
+    colTypes[colNr] = FstColumnType::CHARACTER;
+    largeStrings[colNr] = format == "U";
+    return;
+  }
+
+  if (format == "i" || format == "l" || format == "g")
+  {
+    if (format == "i")
+    {
+      colTypes[colNr] = FstColumnType::INT_32;
+      if (hasNulls) CopyValues(colArray, firstElem, nrOfRows, ints[colNr], INT_MIN);
+    }
+    else if (format == "l")
+    {
+      colTypes[colNr] = FstColumnType::INT_64;
+      if (hasNulls) CopyValues(colArray, firstElem, nrOfRows, longs[colNr], LLONG_MIN);
+    }
+    else
+    {
+      colTypes[colNr] = FstColumnType::DOUBLE_64;
+      if (hasNulls) CopyValues(colArray, firstElem, nrOfRows, doubles[colNr], RealNA());
+    }
+
+    if (!hasNulls)
+    {
+      // Values are used in place
+      size_t elementSize = format == "i" ? 4 : 8;
+      colData[colNr] = const_cast<char*>(static_cast<const char*>(colArray->buffers[1]) + firstElem * elementSize);
+      return;
+    }
+  }
+  else if (format == "c" || format == "C" || format == "s" || format == "S")
+  {
+    auto toInt = [](int value) { return value; };
+    colTypes[colNr] = FstColumnType::INT_32;
+
+    switch (format[0])
+    {
+      case 'c': ConvertValues<int8_t>(colArray, firstElem, nrOfRows, ints[colNr], INT_MIN, toInt); break;
+      case 'C': ConvertValues<uint8_t>(colArray, firstElem, nrOfRows, ints[colNr], INT_MIN, toInt); break;
+      case 's': ConvertValues<int16_t>(colArray, firstElem, nrOfRows, ints[colNr], INT_MIN, toInt); break;
+      default: ConvertValues<uint16_t>(colArray, firstElem, nrOfRows, ints[colNr], INT_MIN, toInt); break;
+    }
+  }
+  else if (format == "f")
+  {
+    colTypes[colNr] = FstColumnType::DOUBLE_64;
+    ConvertValues<float>(colArray, firstElem, nrOfRows, doubles[colNr], RealNA(),
+      [](float value) { return (double) value; });
+  }
+  else if (format == "b")
+  {
+    const unsigned char* bits = static_cast<const unsigned char*>(colArray->buffers[1]);
+    vector<int> &values = ints[colNr];
+    values.resize(nrOfRows);
+
+    for (unsigned long long pos = 0; pos < nrOfRows; ++pos)
+    {
+      unsigned long long elem = firstElem + pos;
+      values[pos] = IsValid(colArray, elem) ? (bits[elem / 8] >> (elem % 8)) & 1 : INT_MIN;
+    }
+
+    colTypes[colNr] = FstColumnType::BOOL_32;
+  }
+  else if (format == "tdD")
+  {
+    colTypes[colNr] = FstColumnType::DATE_DAYS;
+    ConvertValues<int32_t>(colArray, firstElem, nrOfRows, doubles[colNr], RealNA(),
+      [](int32_t days) { return (double) days; });
+  }
+  else if (format == "tdm")
+  {
+    colTypes[colNr] = FstColumnType::DATE_DAYS;
+    ConvertValues<int64_t>(colArray, firstElem, nrOfRows, doubles[colNr], RealNA(),
+      [](int64_t milliseconds) { return floor(milliseconds / 86400000.0); });
+  }
+  else if (format.size() >= 4 && format.compare(0, 2, "ts") == 0 && format[3] == ':' &&
+    string("smun").find(format[2]) != string::npos)
+  {
+    // Timestamps are stored in seconds, the time zone is not kept
+    double unitsPerSecond = format[2] == 's' ? 1.0 : format[2] == 'm' ? 1e3 : format[2] == 'u' ? 1e6 : 1e9;
+
+    colTypes[colNr] = FstColumnType::TIMESTAMP_SECONDS;
+    ConvertValues<int64_t>(colArray, firstElem, nrOfRows, doubles[colNr], RealNA(),
+      [unitsPerSecond](int64_t units) { return units / unitsPerSecond; });
+  }
+  else
+  {
+    throw(runtime_error("Column '" + colNames.strings[colNr] + "' has unsupported Arrow format '" + format + "'."));
+  }
+
+  switch (ValueType(colTypes[colNr]))
+  {
+    case FstColumnType::DOUBLE_64:
+      colData[colNr] = doubles[colNr].data();
+      break;
+
+    case FstColumnType::INT_64:
+      colData[colNr] = longs[colNr].data();
+      break;
+
+    default:
+      colData[colNr] = ints[colNr].data();
+      break;
+  }
+}
+
+
+IBlockWriter* ArrowTable::GetCharWriter(unsigned int colNr)
+{
+  return new ArrowStringWriter(colArrays[colNr], colOffsets[colNr], NrOfRows(), largeStrings[colNr]);
+}
+
+
+IBlockWriter* ArrowTable::GetLevelWriter(unsigned int colNr)
+{
+  const ArrowArray* levels = colArrays[colNr]->dictionary;
+  return new ArrowStringWriter(levels, (unsigned long long) levels->offset, (unsigned long long) levels->length,
+    largeStrings[colNr]);
+}
@@ -0,0 +1,210 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_ARROW_H
+#define FST_ARROW_H
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ifsttable.h>
+#include <icolumnfactory.h>
+#include <iblockrunner.h>
+#include <stringvectorcolumn.h>
+#include <fstcapi.h>
+
+
+// Buffers of an exported Arrow array (defined in fstarrow.cpp)
+struct ArrowArrayData;
+
+
+/**
+ Character column that stores its elements in the Arrow string layout: the characters of all elements in a single
+ buffer, the end position of each element in an offset vector and a validity bit per element. The decompressed
+ blocks are appended as a whole, with offsets taken from the cumulative string sizes of the block. Elements are
+ expected in order of their position, elements that are set out of order are reordered by Finish.
+ */
+class ArrowStringColumn : public IStringColumn
+{
+  std::vector<unsigned long long> starts;  // start and end of each element, only if elements were set out of order
+  std::vector<unsigned long long> ends;
+  std::string element;                     // element returned by GetElement
+
+  void SetElement(unsigned long long vecPos, const char* str, unsigned int size, bool isNA);
+
+public:
+  std::vector<long long> offsets;        // element elem is chars[offsets[elem], offsets[elem + 1])
+  std::vector<char> chars;
+  std::vector<unsigned char> validity;   // bit per element, set for non-NA elements
+  unsigned long long nullCount;
+  unsigned long long nextElem;           // elements before nextElem are set in order
+
+  ArrowStringColumn() : nullCount(0), nextElem(0) {}
+
+  void AllocateVec(unsigned long long vecLength);
+
+  void BufferToVec(unsigned int nrOfElements, unsigned int startElem, unsigned int endElem,
+    unsigned long long vecOffset, unsigned int* sizeMeta, char* buf);
+
+  bool LevelsToVec(unsigned long long vecOffset, unsigned long long length, const int* codes,
+    unsigned int nrOfLevels, const unsigned int* levelSizes, const char* levelBuf);
+
+  const char* GetElement(int elementNr);
+
+  // Complete the offsets, elements that were set out of order are placed in order of their position
+  void Finish();
+};
+
+
+class ArrowFactorColumn : public IFactorColumn
+{
+public:
+  std::vector<int> data;
+  ArrowStringColumn levels;
+  ArrowFactorColumn(unsigned long long nrOfRows) : data(nrOfRows) {}
+  int* LevelData() { return data.data(); }
+  IStringColumn* Levels() { return &levels; }
+};
+
+
+/**
+ Table reader that reads fst columns into Arrow arrays, used as the column factory and result table of a read
+ through a FstHandle. Numeric columns are decompressed into the vectors that become the Arrow buffers, only the
+ validity bits are added. Character columns are read as strings (utf8, or large_utf8 if the characters exceed
+ 2 GB), factors as dictionary arrays with int32 indices and string levels, logicals as booleans, dates as date32
+ and timestamps as timestamps in microseconds (UTC). NA values are null elements.
+ */
+class ArrowTableReader : public IFstTableReader, public IColumnFactory
+{
+  std::vector<FstColumnType> colTypes;
+  std::vector<std::string> colNames;
+  std::vector<ArrowArrayData*> columns;  // read columns, until they are exported
+  unsigned long long nrOfRows;
+  bool largeStrings;  // character columns and levels always use 64-bit offsets
+
+  ArrowArrayData* NewColumn(int colNr);
+
+public:
+  /**
+   @param colTypes Types of the selected columns.
+   @param colNames Names of the selected columns.
+   @param largeStrings If true, character columns and levels are always read as large_utf8, so batches of a stream
+   have the same schema regardless of their size.
+   */
+  ArrowTableReader(const std::vector<FstColumnType> &colTypes, const std::vector<std::string> &colNames,
+    bool largeStrings = false);
+
+  ~ArrowTableReader();
+
+  unsigned long long NrOfRows() { return nrOfRows; }
+
+  /**
+   Move the read columns to an Arrow record batch: a struct array with a child array for each column. The schema and
+   array are owned by the caller, who releases them with their release callbacks.
+   */
+  void Export(ArrowSchema* schema, ArrowArray* array);
+
+  // IColumnFactory
+  IFactorColumn* CreateFactorColumn(unsigned long long nrOfRows) { return new ArrowFactorColumn(nrOfRows); }
+  ILogicalColumn* CreateLogicalColumn(unsigned long long nrOfRows);
+  IDoubleColumn* CreateDoubleColumn(unsigned long long nrOfRows);
+  IIntegerColumn* CreateIntegerColumn(unsigned long long nrOfRows);
+  IInt64Column* CreateInt64Column(unsigned long long nrOfRows);
+  IStringColumn* CreateStringColumn(unsigned long long nrOfRows) { return new ArrowStringColumn(); }
+  IStringArray* CreateStringArray() { return nullptr; }  // not used for reading column data
+
+  // IFstTableReader
+  void InitTable(unsigned int nrOfCols, unsigned long long nrOfRows) { this->nrOfRows = nrOfRows; }
+  void AddCharColumn(IStringColumn* stringColumn, int colNr);
+  void AddLogicalColumn(ILogicalColumn* logicalColumn, int colNr);
+  void AddIntegerColumn(IIntegerColumn* integerColumn, int colNr);
+  void AddDoubleColumn(IDoubleColumn* doubleColumn, int colNr, FstColumnType colType);
+  void AddInt64Column(IInt64Column* int64Column, int colNr);
+  void AddFactorColumn(IFactorColumn* factorColumn, int colNr);
+  void SetColumnAttributes(int colNr, const char* attributeData, unsigned int size) {}
+  void SetColNames() {}
+  void SetKeyColumns(int* keyColPos, unsigned int nrOfKeys) {}
+};
+
+
+/**
+ Table to write an Arrow record batch (a struct array with a child array for each column) to a fst file. Values are
+ used in place where the layouts match: int32, int64 and double arrays without nulls and the characters of string
+ arrays. Other arrays are converted: null elements to NA values, booleans and small integers to 32-bit integers,
+ floats to doubles, dictionary arrays with string values to factors, date32 and date64 to dates and timestamps to
+ timestamps in seconds. The batch should remain valid during the lifetime of the table.
+ */
+class ArrowTable : public IFstTable
+{
+  const ArrowArray* array;
+  std::vector<const ArrowArray*> colArrays;
+  std::vector<unsigned long long> colOffsets;  // position of the first row in the buffers of each column
+  std::vector<FstColumnType> colTypes;
+  std::vector<bool> largeStrings;              // string columns (or levels) with 64-bit offsets
+  std::vector<void*> colData;                  // values of the numeric and factor columns
+
+  std::vector<std::vector<int>> ints;          // converted values
+  std::vector<std::vector<double>> doubles;
+  std::vector<std::vector<long long>> longs;
+  StringVectorColumn colNames;
+
+  void AddColumn(unsigned int colNr, const ArrowSchema* colSchema);
+
+public:
+  /**
+   @throws runtime_error if the batch is not a struct array or has columns of an unsupported type.
+   */
+  ArrowTable(const ArrowSchema* schema, const ArrowArray* array);
+
+  FstColumnType GetColumnType(unsigned int colNr) { return colTypes[colNr]; }
+  IBlockWriter* GetCharWriter(unsigned int colNr);
+  int* GetLogicalWriter(unsigned int colNr) { return static_cast<int*>(colData[colNr]); }
+  int* GetIntWriter(unsigned int colNr) { return static_cast<int*>(colData[colNr]); }
+  double* GetDoubleWriter(unsigned int colNr) { return static_cast<double*>(colData[colNr]); }
+  long long* GetInt64Writer(unsigned int colNr) { return static_cast<long long*>(colData[colNr]); }
+  IBlockWriter* GetLevelWriter(unsigned int colNr);
+  void GetColumnAttributes(unsigned int colNr, std::vector<char> &attributeData) { attributeData.clear(); }
+  IBlockWriter* GetColNameWriter() { return new StringVectorWriter(colNames); }
+  void GetKeyColumns(int* keyColPos) {}
+  unsigned int NrOfKeys() { return 0; }
+  unsigned int NrOfColumns() { return (unsigned int) colTypes.size(); }
+  unsigned long long NrOfRows() { return (unsigned long long) array->length; }
+};
+
+
+#endif  // FST_ARROW_H
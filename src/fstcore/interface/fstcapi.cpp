@@ -0,0 +1,925 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include <algorithm>
+#include <cerrno>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <ifsttable.h>
+#include <fsthandle.h>
+#include <fstsharedhandle.h>
+#include <fstfilter.h>
+#include <fststore.h>
+#include <fstwriter.h>
+#include <rowbatch.h>
+#include <fstarrow.h>
+#include <fstcapi.h>
+
+
+using namespace std;
+
+
+// Message of the last error of the calling thread
+static thread_local string lastError;
+
+
+struct fst_file
+{
+  shared_ptr<const FstSharedHandle> handle;  // shared by the references of the file (see fst_share)
+  vector<string> colNames;
+  vector<int> keyIndex;
+};
+
+
+// The columns of a read, with the column data in C++ vectors
+struct fst_table : public RowBatch
+{
+  fst_table(const vector<FstColumnType> &colTypes) : RowBatch(colTypes) {}
+};
+
+
+struct fst_writer
+{
+  RowBatch columnFactory;
+  FstWriter writer;
+
+  fst_writer(const char* path, int compress, int nrOfThreads) : columnFactory(vector<FstColumnType>()),
+    writer(path, compress, nrOfThreads, &columnFactory) {}
+};
+
+
+struct fst_filter
+{
+  FstPredicate* predicate;  // owned by the filter, until the filter is used by a scan or another filter
+
+  fst_filter(FstPredicate* predicate) : predicate(predicate) {}
+
+  ~fst_filter() { delete predicate; }
+};
+
+
+// State of a scan, the private data of its Arrow stream (see fst_scan_arrow)
+struct ScanStream
+{
+  shared_ptr<const FstSharedHandle> handle;  // reads the batches
+  vector<int> colIndex;
+  vector<FstColumnType> colTypes;
+  vector<string> colNames;
+
+  unique_ptr<FstPredicate> predicate;  // row filter, if any
+  RowBatch nameFactory;                // creates the column names of filterHandle
+  unique_ptr<FstHandle> filterHandle;  // handle with its own stream that evaluates the row filter
+
+  unsigned long long firstRow;
+  unsigned long long nextRow;  // first row of the next batch
+  unsigned long long endRow;
+  unsigned long long batchRows;
+  int nrOfThreads;
+
+  string lastError;
+
+  ScanStream() : nameFactory(vector<FstColumnType>()) {}
+};
+
+
+// Column names of a file
+class NameArray : public IStringArray
+{
+public:
+  vector<string> &strings;
+
+  NameArray(vector<string> &strings) : strings(strings) {}
+
+  void AllocateArray(int vecLength) { strings.resize(vecLength); }
+  void SetElement(int elementNr, const char* str) { strings[elementNr] = str; }
+  void SetElement(int elementNr, const char* str, int strLen) { strings[elementNr].assign(str, strLen); }
+  const char* GetElement(int elementNr) { return strings[elementNr].c_str(); }
+  int Length() { return (int) strings.size(); }
+};
+
+
+// Column numbers of a column selection, all columns if columns is NULL
+inline void SelectColumns(fst_file* file, const int* columns, int nrOfColumns, vector<int> &colIndex)
+{
+  int nrOfCols = file->handle->NrOfColumns();
+
+  if (columns == nullptr)
+  {
+    for (int colNr = 0; colNr < nrOfCols; ++colNr) colIndex.push_back(colNr);
+    return;
+  }
+
+  if (nrOfColumns < 1)
+  {
+    throw(runtime_error("Select at least one column."));
+  }
+
+  for (int colSel = 0; colSel < nrOfColumns; ++colSel)
+  {
+    if (columns[colSel] < 0 || columns[colSel] >= nrOfCols)
+    {
+      throw(runtime_error("Selected column number is out of range."));
+    }
+
+    colIndex.push_back(columns[colSel]);
+  }
+}
+
+
+// Column types of the selected columns
+inline vector<FstColumnType> ColumnTypes(fst_file* file, const vector<int> &colIndex)
+{
+  vector<FstColumnType> colTypes;
+
+  for (int colNr : colIndex)
+  {
+    colTypes.push_back(StoredColumnType(file->handle->ColumnType(colNr)));
+  }
+
+  return colTypes;
+}
+
+
+/**
+ Read the selected columns into a new table with the handle of the file. The table (created by create) is the
+ column factory of the read, so reads of the same file from multiple threads don't share any state.
+ */
+template<typename Table, typename CreateFunction, typename ReadFunction>
+inline Table* ReadTable(fst_file* file, const int* columns, int nrOfColumns, CreateFunction create, ReadFunction read)
+{
+  if (file == nullptr)
+  {
+    lastError = "No file specified.";
+    return nullptr;
+  }
+
+  Table* table = nullptr;
+
+  try
+  {
+    vector<int> colIndex;
+    SelectColumns(file, columns, nrOfColumns, colIndex);
+
+    table = create(colIndex);
+    read(*table, colIndex);
+  }
+  catch (const std::exception &e)
+  {
+    delete table;
+    lastError = e.what();
+    return nullptr;
+  }
+
+  lastError.clear();
+
+  return table;
+}
+
+
+inline fst_table* CreateTable(fst_file* file, const vector<int> &colIndex)
+{
+  return new fst_table(ColumnTypes(file, colIndex));
+}
+
+
+inline ArrowTableReader* CreateArrowTable(fst_file* file, const vector<int> &colIndex)
+{
+  vector<string> colNames;
+
+  for (int colNr : colIndex) colNames.push_back(file->colNames[colNr]);
+
+  return new ArrowTableReader(ColumnTypes(file, colIndex), colNames);
+}
+
+
+// Read a range of rows
+template<typename Table>
+inline unsigned long long ReadRange(fst_file* file, Table &table, const vector<int> &colIndex,
+  unsigned long long firstRow, unsigned long long length, int nrOfThreads)
+{
+  if (firstRow >= file->handle->NrOfRows() || length == 0)
+  {
+    throw(runtime_error("The selected rows are beyond the last row of the table."));
+  }
+
+  return file->handle->ReadRows(table, &table, colIndex, firstRow, length, nrOfThreads);
+}
+
+
+// Read a sorted set of rows
+template<typename Table>
+inline unsigned long long ReadRowSet(fst_file* file, Table &table, const vector<int> &colIndex,
+  const unsigned long long* rows, unsigned long long nrOfRows, int nrOfThreads)
+{
+  if (rows == nullptr || nrOfRows == 0)
+  {
+    throw(runtime_error("Select at least one row."));
+  }
+
+  for (unsigned long long pos = 0; pos < nrOfRows; ++pos)
+  {
+    if (rows[pos] >= file->handle->NrOfRows() || (pos > 0 && rows[pos] < rows[pos - 1]))
+    {
+      throw(runtime_error("Selected rows should be sorted in increasing order and smaller than the number of rows."));
+    }
+  }
+
+  return file->handle->ReadRowSet(table, &table, colIndex, rows, nrOfRows, nrOfThreads);
+}
+
+
+// Move a read Arrow table to the Arrow schema and array of the caller
+inline int ExportArrowTable(ArrowTableReader* table, ArrowSchema* schema, ArrowArray* array)
+{
+  if (table == nullptr) return -1;
+
+  try
+  {
+    table->Export(schema, array);
+  }
+  catch (const std::exception &e)
+  {
+    delete table;
+    lastError = e.what();
+    return -1;
+  }
+
+  delete table;
+
+  return 0;
+}
+
+
+// Read the next batch of a scan with at least one matching row into table, false at the end of the scan
+bool ScanNextBatch(ScanStream &scan, unique_ptr<ArrowTableReader> &table)
+{
+  vector<unsigned long long> rows;
+
+  while (scan.nextRow < scan.endRow)
+  {
+    unsigned long long firstRow = scan.nextRow;
+    unsigned long long length = min(scan.batchRows, scan.endRow - firstRow);
+    scan.nextRow += length;
+
+    if (scan.predicate)
+    {
+      FstFilter fstFilter(*scan.filterHandle);
+      fstFilter.SelectRows(*scan.predicate, rows, scan.nrOfThreads, firstRow, length);
+
+      if (rows.empty()) continue;
+    }
+
+    table.reset(new ArrowTableReader(scan.colTypes, scan.colNames, true));
+
+    // Batches of which all rows match are read as a range
+    if (!scan.predicate || rows.size() == length)
+    {
+      scan.handle->ReadRows(*table, table.get(), scan.colIndex, firstRow, length, scan.nrOfThreads);
+    }
+    else
+    {
+      scan.handle->ReadRowSet(*table, table.get(), scan.colIndex, rows.data(), rows.size(), scan.nrOfThreads);
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+
+int ScanGetSchema(ArrowArrayStream* stream, ArrowSchema* out)
+{
+  ScanStream* scan = static_cast<ScanStream*>(stream->private_data);
+
+  try
+  {
+    // Schema of a batch with the first row of the scan
+    ArrowTableReader table(scan->colTypes, scan->colNames, true);
+    scan->handle->ReadRows(table, &table, scan->colIndex, scan->firstRow, 1, 1);
+
+    ArrowArray array;
+    table.Export(out, &array);
+    array.release(&array);
+  }
+  catch (const std::exception &e)
+  {
+    scan->lastError = e.what();
+    return EIO;
+  }
+
+  return 0;
+}
+
+
+int ScanGetNext(ArrowArrayStream* stream, ArrowArray* out)
+{
+  ScanStream* scan = static_cast<ScanStream*>(stream->private_data);
+
+  try
+  {
+    unique_ptr<ArrowTableReader> table;
+
+    // The end of the stream is a released array
+    if (!ScanNextBatch(*scan, table))
+    {
+      out->release = nullptr;
+      return 0;
+    }
+
+    ArrowSchema schema;
+    table->Export(&schema, out);
+    schema.release(&schema);
+  }
+  catch (const std::exception &e)
+  {
+    scan->lastError = e.what();
+    return EIO;
+  }
+
+  return 0;
+}
+
+
+const char* ScanGetLastError(ArrowArrayStream* stream)
+{
+  ScanStream* scan = static_cast<ScanStream*>(stream->private_data);
+
+  return scan->lastError.empty() ? nullptr : scan->lastError.c_str();
+}
+
+
+void ScanRelease(ArrowArrayStream* stream)
+{
+  delete static_cast<ScanStream*>(stream->private_data);
+  stream->release = nullptr;
+}
+
+
+// Leaf of a row filter
+inline fst_filter* CompareFilter(const char* column, PredicateOperator op, const vector<double> &values,
+  const vector<string> &strings)
+{
+  if (column == nullptr)
+  {
+    lastError = "No column specified.";
+    return nullptr;
+  }
+
+  FstPredicate* predicate = new FstPredicate(op);
+  predicate->colName = column;
+  predicate->values = values;
+  predicate->strings = strings;
+
+  lastError.clear();
+
+  return new fst_filter(predicate);
+}
+
+
+// Conjunction or disjunction of two filters, which are consumed
+inline fst_filter* CombineFilters(PredicateOperator op, fst_filter* left, fst_filter* right)
+{
+  unique_ptr<fst_filter> leftFilter(left);
+  unique_ptr<fst_filter> rightFilter(right);
+
+  if (left == nullptr || right == nullptr || left == right)
+  {
+    if (left == right) leftFilter.release();  // a single filter is freed once
+    lastError = "Specify two different filters.";
+    return nullptr;
+  }
+
+  FstPredicate* predicate = new FstPredicate(op);
+  predicate->operands.push_back(left->predicate);
+  predicate->operands.push_back(right->predicate);
+  left->predicate = nullptr;
+  right->predicate = nullptr;
+
+  lastError.clear();
+
+  return new fst_filter(predicate);
+}
+
+
+extern "C" {
+
+
+const char* fst_last_error(void)
+{
+  return lastError.c_str();
+}
+
+
+fst_file* fst_open(const char* path, int memory_mapped)
+{
+  if (path == nullptr)
+  {
+    lastError = "No path specified.";
+    return nullptr;
+  }
+
+  fst_file* file = nullptr;
+
+  try
+  {
+    file = new fst_file();
+    file->handle = FstSharedHandle::Open(path, memory_mapped != 0);
+
+    NameArray colNames(file->colNames);
+    vector<int> colIndex;
+    SelectColumns(file, nullptr, 0, colIndex);
+    file->handle->SelectedColumns(colIndex, &colNames, file->keyIndex);
+  }
+  catch (const std::exception &e)
+  {
+    delete file;
+    lastError = e.what();
+    return nullptr;
+  }
+
+  lastError.clear();
+
+  return file;
+}
+
+
+fst_file* fst_share(fst_file* file)
+{
+  if (file == nullptr)
+  {
+    lastError = "No file specified.";
+    return nullptr;
+  }
+
+  lastError.clear();
+
+  return new fst_file(*file);
+}
+
+
+void fst_close(fst_file* file)
+{
+  delete file;
+}
+
+
+unsigned long long fst_nr_of_rows(fst_file* file)
+{
+  return file->handle->NrOfRows();
+}
+
+
+int fst_nr_of_columns(fst_file* file)
+{
+  return file->handle->NrOfColumns();
+}
+
+
+const char* fst_column_name(fst_file* file, int col)
+{
+  if (col < 0 || col >= (int) file->colNames.size()) return nullptr;
+
+  return file->colNames[col].c_str();
+}
+
+
+int fst_column_type(fst_file* file, int col)
+{
+  if (col < 0 || col >= file->handle->NrOfColumns()) return -1;
+
+  return StoredColumnType(file->handle->ColumnType(col));
+}
+
+
+int fst_nr_of_keys(fst_file* file)
+{
+  return (int) file->keyIndex.size();
+}
+
+
+int fst_key_column(fst_file* file, int key)
+{
+  if (key < 0 || key >= (int) file->keyIndex.size()) return -1;
+
+  return file->keyIndex[key];
+}
+
+
+fst_table* fst_read(fst_file* file, const int* columns, int nr_of_columns, unsigned long long first_row,
+  unsigned long long length, int nr_of_threads)
+{
+  return ReadTable<fst_table>(file, columns, nr_of_columns,
+    [&](const vector<int> &colIndex) { return CreateTable(file, colIndex); },
+    [&](fst_table &table, const vector<int> &colIndex)
+    {
+      table.nrOfRows = ReadRange(file, table, colIndex, first_row, length, nr_of_threads);
+    });
+}
+
+
+fst_table* fst_read_rows(fst_file* file, const int* columns, int nr_of_columns, const unsigned long long* rows,
+  unsigned long long nr_of_rows, int nr_of_threads)
+{
+  return ReadTable<fst_table>(file, columns, nr_of_columns,
+    [&](const vector<int> &colIndex) { return CreateTable(file, colIndex); },
+    [&](fst_table &table, const vector<int> &colIndex)
+    {
+      table.nrOfRows = ReadRowSet(file, table, colIndex, rows, nr_of_rows, nr_of_threads);
+    });
+}
+
+
+int fst_read_arrow(fst_file* file, const int* columns, int nr_of_columns, unsigned long long first_row,
+  unsigned long long length, int nr_of_threads, struct ArrowSchema* schema, struct ArrowArray* array)
+{
+  if (schema == nullptr || array == nullptr)
+  {
+    lastError = "No Arrow schema or array specified.";
+    return -1;
+  }
+
+  return ExportArrowTable(ReadTable<ArrowTableReader>(file, columns, nr_of_columns,
+    [&](const vector<int> &colIndex) { return CreateArrowTable(file, colIndex); },
+    [&](ArrowTableReader &table, const vector<int> &colIndex)
+    {
+      ReadRange(file, table, colIndex, first_row, length, nr_of_threads);
+    }), schema, array);
+}
+
+
+int fst_read_rows_arrow(fst_file* file, const int* columns, int nr_of_columns, const unsigned long long* rows,
+  unsigned long long nr_of_rows, int nr_of_threads, struct ArrowSchema* schema, struct ArrowArray* array)
+{
+  if (schema == nullptr || array == nullptr)
+  {
+    lastError = "No Arrow schema or array specified.";
+    return -1;
+  }
+
+  return ExportArrowTable(ReadTable<ArrowTableReader>(file, columns, nr_of_columns,
+    [&](const vector<int> &colIndex) { return CreateArrowTable(file, colIndex); },
+    [&](ArrowTableReader &table, const vector<int> &colIndex)
+    {
+      ReadRowSet(file, table, colIndex, rows, nr_of_rows, nr_of_threads);
+    }), schema, array);
+}
+
+
+fst_filter* fst_filter_compare(const char* column, int op, double value)
+{
+  if (op < FST_EQUAL || op > FST_GREATER_EQUAL)
+  {
+    lastError = "Unknown comparison operator.";
+    return nullptr;
+  }
+
+  return CompareFilter(column, (PredicateOperator) op, vector<double>(1, value), vector<string>());
+}
+
+
+fst_filter* fst_filter_compare_string(const char* column, int op, const char* value)
+{
+  if (op < FST_EQUAL || op > FST_GREATER_EQUAL || value == nullptr)
+  {
+    lastError = value == nullptr ? "No value specified." : "Unknown comparison operator.";
+    return nullptr;
+  }
+
+  return CompareFilter(column, (PredicateOperator) op, vector<double>(), vector<string>(1, value));
+}
+
+
+fst_filter* fst_filter_in(const char* column, const double* values, int nr_of_values)
+{
+  if (values == nullptr && nr_of_values > 0)
+  {
+    lastError = "No values specified.";
+    return nullptr;
+  }
+
+  return CompareFilter(column, PredicateOperator::IN_SET,
+    vector<double>(values, values + max(nr_of_values, 0)), vector<string>());
+}
+
+
+fst_filter* fst_filter_in_strings(const char* column, const char* const* values, int nr_of_values)
+{
+  vector<string> strings;
+
+  for (int pos = 0; pos < nr_of_values; ++pos)
+  {
+    if (values == nullptr || values[pos] == nullptr)
+    {
+      lastError = "No values specified.";
+      return nullptr;
+    }
+
+    strings.push_back(values[pos]);
+  }
+
+  return CompareFilter(column, PredicateOperator::IN_SET, vector<double>(), strings);
+}
+
+
+fst_filter* fst_filter_and(fst_filter* left, fst_filter* right)
+{
+  return CombineFilters(PredicateOperator::AND, left, right);
+}
+
+
+fst_filter* fst_filter_or(fst_filter* left, fst_filter* right)
+{
+  return CombineFilters(PredicateOperator::OR, left, right);
+}
+
+
+void fst_filter_free(fst_filter* filter)
+{
+  delete filter;
+}
+
+
+int fst_scan_arrow(fst_file* file, const int* columns, int nr_of_columns, fst_filter* filter,
+  unsigned long long first_row, unsigned long long length, unsigned long long batch_rows, int nr_of_threads,
+  struct ArrowArrayStream* stream)
+{
+  unique_ptr<fst_filter> rowFilter(filter);
+
+  if (file == nullptr || stream == nullptr)
+  {
+    lastError = file == nullptr ? "No file specified." : "No Arrow stream specified.";
+    return -1;
+  }
+
+  try
+  {
+    unique_ptr<ScanStream> scan(new ScanStream());
+    scan->handle = file->handle;
+
+    SelectColumns(file, columns, nr_of_columns, scan->colIndex);
+    scan->colTypes = ColumnTypes(file, scan->colIndex);
+    for (int colNr : scan->colIndex) scan->colNames.push_back(file->colNames[colNr]);
+
+    unsigned long long nrOfRows = file->handle->NrOfRows();
+
+    if (first_row >= nrOfRows || length == 0)
+    {
+      throw(runtime_error("The selected rows are beyond the last row of the table."));
+    }
+
+    scan->firstRow = first_row;
+    scan->nextRow = first_row;
+    scan->endRow = first_row + min(length, nrOfRows - first_row);
+    scan->batchRows = batch_rows == 0 ? SCAN_BATCH_ROWS : batch_rows;
+    scan->nrOfThreads = nr_of_threads;
+
+    if (filter != nullptr)
+    {
+      scan->predicate.reset(filter->predicate);
+      filter->predicate = nullptr;
+      scan->filterHandle.reset(file->handle->OpenHandle(&scan->nameFactory));
+
+      // The columns and operands of the filter are checked with an empty range
+      vector<unsigned long long> rows;
+      FstFilter fstFilter(*scan->filterHandle);
+      fstFilter.SelectRows(*scan->predicate, rows, nr_of_threads, first_row, 0);
+    }
+
+    stream->get_schema = ScanGetSchema;
+    stream->get_next = ScanGetNext;
+    stream->get_last_error = ScanGetLastError;
+    stream->release = ScanRelease;
+    stream->private_data = scan.release();
+  }
+  catch (const std::exception &e)
+  {
+    lastError = e.what();
+    return -1;
+  }
+
+  lastError.clear();
+
+  return 0;
+}
+
+
+int fst_write_arrow(const char* path, const struct ArrowSchema* schema, const struct ArrowArray* array,
+  int compress, int nr_of_threads)
+{
+  if (path == nullptr)
+  {
+    lastError = "No path specified.";
+    return -1;
+  }
+
+  try
+  {
+    ArrowTable table(schema, array);
+    FstStore fstStore(path);
+    fstStore.fstWrite(path, table, compress, nr_of_threads, 0);
+  }
+  catch (const std::exception &e)
+  {
+    lastError = e.what();
+    return -1;
+  }
+
+  lastError.clear();
+
+  return 0;
+}
+
+
+fst_writer* fst_writer_open(const char* path, int compress, int nr_of_threads)
+{
+  if (path == nullptr)
+  {
+    lastError = "No path specified.";
+    return nullptr;
+  }
+
+  lastError.clear();
+
+  return new fst_writer(path, compress, nr_of_threads);
+}
+
+
+int fst_writer_append_arrow(fst_writer* writer, const struct ArrowSchema* schema, const struct ArrowArray* array)
+{
+  if (writer == nullptr)
+  {
+    lastError = "No writer specified.";
+    return -1;
+  }
+
+  try
+  {
+    ArrowTable table(schema, array);
+
+    // Empty batches of a stream are skipped
+    if (table.NrOfRows() > 0) writer->writer.WriteBatch(table);
+  }
+  catch (const std::exception &e)
+  {
+    lastError = e.what();
+    return -1;
+  }
+
+  lastError.clear();
+
+  return 0;
+}
+
+
+int fst_writer_close(fst_writer* writer)
+{
+  if (writer == nullptr) return 0;
+
+  try
+  {
+    writer->writer.Close();
+  }
+  catch (const std::exception &e)
+  {
+    delete writer;
+    lastError = e.what();
+    return -1;
+  }
+
+  delete writer;
+  lastError.clear();
+
+  return 0;
+}
+
+
+void fst_table_free(fst_table* table)
+{
+  delete table;
+}
+
+
+unsigned long long fst_table_nr_of_rows(fst_table* table)
+{
+  return table->nrOfRows;
+}
+
+
+int fst_table_nr_of_columns(fst_table* table)
+{
+  return (int) table->colTypes.size();
+}
+
+
+int fst_table_column_type(fst_table* table, int col)
+{
+  if (col < 0 || col >= (int) table->colTypes.size()) return -1;
+
+  return table->colTypes[col];
+}
+
+
+const int* fst_table_int32(fst_table* table, int col)
+{
+  switch (fst_table_column_type(table, col))
+  {
+    case FstColumnType::FACTOR:
+    case FstColumnType::INT_32:
+    case FstColumnType::BOOL_32:
+      return table->ints[col].data();
+
+    default:
+      return nullptr;
+  }
+}
+
+
+const double* fst_table_double(fst_table* table, int col)
+{
+  switch (fst_table_column_type(table, col))
+  {
+    case FstColumnType::DOUBLE_64:
+    case FstColumnType::DATE_DAYS:
+    case FstColumnType::TIMESTAMP_SECONDS:
+      return table->doubles[col].data();
+
+    default:
+      return nullptr;
+  }
+}
+
+
+const long long* fst_table_int64(fst_table* table, int col)
+{
+  if (fst_table_column_type(table, col) != FstColumnType::INT_64) return nullptr;
+
+  return table->longs[col].data();
+}
+
+
+const char* fst_table_string(fst_table* table, int col, unsigned long long row)
+{
+  if (fst_table_column_type(table, col) != FstColumnType::CHARACTER || row >= table->nrOfRows) return nullptr;
+
+  StringVectorColumn &column = table->strings[col];
+
+  return column.isNA[row] ? nullptr : column.strings[row].c_str();
+}
+
+
+int fst_table_nr_of_levels(fst_table* table, int col)
+{
+  if (fst_table_column_type(table, col) != FstColumnType::FACTOR) return -1;
+
+  return (int) table->strings[col].strings.size();
+}
+
+
+const char* fst_table_level(fst_table* table, int col, int level)
+{
+  if (level < 0 || level >= fst_table_nr_of_levels(table, col)) return nullptr;
+
+  StringVectorColumn &column = table->strings[col];
+
+  return column.isNA[level] ? nullptr : column.strings[level].c_str();
+}
+
+
+}  // extern "C"
@@ -0,0 +1,320 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_C_API_H
+#define FST_C_API_H
+
+
+/*
+ C interface of fstcore for reading fst files from programs and languages that don't use R, such as C and C++
+ services or Python through ctypes or cffi. The interface only uses C types, so it can be called across compilers
+ and from any language with a C foreign function interface.
+
+ A file is opened with fst_open and read with fst_read or fst_read_rows, which return a table with the selected
+ columns in C arrays. Tables remain valid until fst_table_free, also after the file is closed. Functions that fail
+ return NULL or -1, fst_last_error has the message of the last error of the calling thread.
+
+ Columns can also be read into and written from Arrow record batches with the Arrow C data interface (the
+ ArrowSchema and ArrowArray structures), to exchange tables with Arrow implementations such as pyarrow, polars and DuckDB.
+ A file can also be scanned as a stream of record batches (the ArrowArrayStream structure) with a column selection
+ and row filter, see fst_scan_arrow.
+
+ An opened file can be read by any number of threads at the same time: the metadata of the file is parsed when it's
+ opened and each read has its own position in the file (see FstSharedHandle). Each read uses nr_of_threads threads
+ to decompress the columns in parallel. Threads that close the file independently use their own reference of the
+ file, created with fst_share. Files in the deprecated format (written with fst versions before 0.7.3) can't be
+ read.
+*/
+
+
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Column types, as in FstColumnType */
+#define FST_TYPE_CHARACTER  1  /* strings, see fst_table_string */
+#define FST_TYPE_FACTOR     2  /* 1-based level codes, see fst_table_int32 and fst_table_level */
+#define FST_TYPE_INT32      3  /* 32-bit integers, NA is INT_MIN */
+#define FST_TYPE_DOUBLE     4  /* doubles, NA is the NaN of R */
+#define FST_TYPE_BOOL32     5  /* logicals as 32-bit integers (0 or 1), NA is INT_MIN */
+#define FST_TYPE_INT64      6  /* 64-bit integers, NA is LLONG_MIN */
+#define FST_TYPE_DATE       7  /* days since 1970-01-01 as doubles */
+#define FST_TYPE_TIMESTAMP  8  /* seconds since 1970-01-01 UTC as doubles */
+
+
+typedef struct fst_file fst_file;      /* opened fst file */
+typedef struct fst_table fst_table;    /* columns read from a fst file */
+typedef struct fst_writer fst_writer;  /* fst file written in batches */
+typedef struct fst_filter fst_filter;  /* row filter of a scan */
+
+
+/*
+ Structures of the Arrow C data interface (https://arrow.apache.org/docs/format/CDataInterface.html), as defined by
+ the specification, so they can be exchanged with any other Arrow implementation
+*/
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema
+{
+  /* Array type description */
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+
+  /* Release callback */
+  void (*release)(struct ArrowSchema*);
+  /* Opaque producer-specific data */
+  void* private_data;
+};
+
+struct ArrowArray
+{
+  /* Array data description */
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+
+  /* Release callback */
+  void (*release)(struct ArrowArray*);
+  /* Opaque producer-specific data */
+  void* private_data;
+};
+
+#endif  /* ARROW_C_DATA_INTERFACE */
+
+
+/* Structure of the Arrow C stream interface (https://arrow.apache.org/docs/format/CStreamInterface.html) */
+#ifndef ARROW_C_STREAM_INTERFACE
+#define ARROW_C_STREAM_INTERFACE
+
+struct ArrowArrayStream
+{
+  /* Callbacks providing stream functionality */
+  int (*get_schema)(struct ArrowArrayStream*, struct ArrowSchema* out);
+  int (*get_next)(struct ArrowArrayStream*, struct ArrowArray* out);
+  const char* (*get_last_error)(struct ArrowArrayStream*);
+
+  /* Release callback */
+  void (*release)(struct ArrowArrayStream*);
+  /* Opaque producer-specific data */
+  void* private_data;
+};
+
+#endif  /* ARROW_C_STREAM_INTERFACE */
+
+
+/* Message of the last error of the calling thread, empty if no error occurred */
+const char* fst_last_error(void);
+
+
+/* Open a fst file, memory mapped if memory_mapped is non-zero. Returns NULL on error. */
+fst_file* fst_open(const char* path, int memory_mapped);
+
+/*
+ New reference to an opened file, for example for a thread that closes the file independently of the other threads.
+ The file itself is closed when all its references are closed with fst_close.
+*/
+fst_file* fst_share(fst_file* file);
+
+void fst_close(fst_file* file);
+
+unsigned long long fst_nr_of_rows(fst_file* file);
+
+int fst_nr_of_columns(fst_file* file);
+
+/* Name of column col (0-based), valid until the file is closed */
+const char* fst_column_name(fst_file* file, int col);
+
+/* Type (FST_TYPE_*) of column col */
+int fst_column_type(fst_file* file, int col);
+
+/* Number of key columns of a sorted file and the column number of key column key (in order of precedence) */
+int fst_nr_of_keys(fst_file* file);
+
+int fst_key_column(fst_file* file, int key);
+
+
+/*
+ Read rows first_row until first_row + length (0-based) of the selected columns. Rows beyond the last row of the file
+ are ignored. The columns are selected with their column numbers, or all columns if columns is NULL. Returns NULL on
+ error.
+*/
+fst_table* fst_read(fst_file* file, const int* columns, int nr_of_columns, unsigned long long first_row,
+  unsigned long long length, int nr_of_threads);
+
+/*
+ Read a set of rows (0-based, sorted in increasing order, duplicates allowed) of the selected columns. Only the
+ blocks that contain selected rows are decompressed. Returns NULL on error.
+*/
+fst_table* fst_read_rows(fst_file* file, const int* columns, int nr_of_columns, const unsigned long long* rows,
+  unsigned long long nr_of_rows, int nr_of_threads);
+
+void fst_table_free(fst_table* table);
+
+unsigned long long fst_table_nr_of_rows(fst_table* table);
+
+int fst_table_nr_of_columns(fst_table* table);
+
+/* Type (FST_TYPE_*) of column col of the table */
+int fst_table_column_type(fst_table* table, int col);
+
+/* Data of an integer, logical or factor column, NULL for columns of other types */
+const int* fst_table_int32(fst_table* table, int col);
+
+/* Data of a double, date or timestamp column, NULL for columns of other types */
+const double* fst_table_double(fst_table* table, int col);
+
+/* Data of a 64-bit integer column, NULL for columns of other types */
+const long long* fst_table_int64(fst_table* table, int col);
+
+/* Element row of a character column, NULL for NA values and columns of other types */
+const char* fst_table_string(fst_table* table, int col, unsigned long long row);
+
+/* Number of levels of a factor column and level level (0-based, level codes are 1-based) */
+int fst_table_nr_of_levels(fst_table* table, int col);
+
+const char* fst_table_level(fst_table* table, int col, int level);
+
+
+/*
+ Read rows first_row until first_row + length of the selected columns (as in fst_read) into an Arrow record batch: a
+ struct array with a child array for each column, with schema. NA values are null elements, factors are dictionary
+ arrays with string values, logicals are booleans, dates are date32 and timestamps are timestamps in microseconds
+ (UTC). The numeric buffers are the decompressed column data. The caller owns the schema and array and releases
+ them with their release callbacks. Returns 0 on success, -1 on error.
+*/
+int fst_read_arrow(fst_file* file, const int* columns, int nr_of_columns, unsigned long long first_row,
+  unsigned long long length, int nr_of_threads, struct ArrowSchema* schema, struct ArrowArray* array);
+
+/* Read a set of rows (as in fst_read_rows) into an Arrow record batch, see fst_read_arrow */
+int fst_read_rows_arrow(fst_file* file, const int* columns, int nr_of_columns, const unsigned long long* rows,
+  unsigned long long nr_of_rows, int nr_of_threads, struct ArrowSchema* schema, struct ArrowArray* array);
+
+/* Comparison operators of a row filter */
+#define FST_EQUAL          1
+#define FST_NOT_EQUAL      2
+#define FST_LESS           3
+#define FST_LESS_EQUAL     4
+#define FST_GREATER        5
+#define FST_GREATER_EQUAL  6
+
+/*
+ Row filters of a scan (see fst_scan_arrow): the comparison of a column with a constant (op is one of the
+ comparison operators) or with a set of constants, and the conjunction or disjunction of two filters. Numeric
+ constants are compared with integer, logical (0 or 1), 64-bit integer, double, date (days) and timestamp (seconds)
+ columns, strings with character and factor columns. NA values never satisfy a comparison, except with a NaN value
+ in the set of fst_filter_in. The column and type of a comparison are checked when the scan is started.
+ fst_filter_and and fst_filter_or take ownership of their operands, other filters are freed with fst_filter_free.
+ The functions return NULL on error.
+*/
+fst_filter* fst_filter_compare(const char* column, int op, double value);
+
+fst_filter* fst_filter_compare_string(const char* column, int op, const char* value);
+
+fst_filter* fst_filter_in(const char* column, const double* values, int nr_of_values);
+
+fst_filter* fst_filter_in_strings(const char* column, const char* const* values, int nr_of_values);
+
+fst_filter* fst_filter_and(fst_filter* left, fst_filter* right);
+
+fst_filter* fst_filter_or(fst_filter* left, fst_filter* right);
+
+void fst_filter_free(fst_filter* filter);
+
+/*
+ Scan rows first_row until first_row + length of the selected columns (as in fst_read) as a stream of Arrow record
+ batches, for query engines that consume Arrow streams such as DuckDB, which pushes its column projection and
+ filters into the scan. Each batch has the rows of at most batch_rows consecutive rows of the file (0 for 1048576
+ rows) that satisfy filter, or all rows if filter is NULL. Batches without matching rows are skipped. The filter
+ is evaluated with the zone maps and Bloom filters of the compared columns first, so blocks that can't contain a
+ matching row are not decompressed. Batches are read with nr_of_threads threads and have the layout of
+ fst_read_arrow, except that character columns and factor levels are large_utf8, so all batches have the schema of
+ the stream.
+
+ The stream takes ownership of filter (also on error) and keeps a reference to the file, which can be closed
+ before the stream is released. Streams of disjoint row ranges can be consumed from multiple threads at the same
+ time, to scan a file in parallel. Returns 0 on success, -1 on error.
+*/
+int fst_scan_arrow(fst_file* file, const int* columns, int nr_of_columns, fst_filter* filter,
+  unsigned long long first_row, unsigned long long length, unsigned long long batch_rows, int nr_of_threads,
+  struct ArrowArrayStream* stream);
+
+/*
+ Write an Arrow record batch (a struct array) to a new fst file with compression level compress (0 - 100). Null
+ elements are stored as NA values. Supported column types are (large) strings, dictionary arrays with string values
+ (stored as factors), booleans, 8 to 32-bit integers, 64-bit integers, floats, doubles, date32, date64 and
+ timestamps (stored in seconds, without time zone). The batch remains owned by the caller. Returns 0 on success, -1
+ on error.
+*/
+int fst_write_arrow(const char* path, const struct ArrowSchema* schema, const struct ArrowArray* array,
+  int compress, int nr_of_threads);
+
+/*
+ Write a stream of Arrow record batches to a new fst file, each batch as a separate data chunk. All batches should
+ have the column types of the first batch. The file is complete after each batch, fst_writer_close closes the file
+ and frees the writer. fst_writer_open returns NULL and the other functions return -1 on error.
+*/
+fst_writer* fst_writer_open(const char* path, int compress, int nr_of_threads);
+
+int fst_writer_append_arrow(fst_writer* writer, const struct ArrowSchema* schema, const struct ArrowArray* array);
+
+int fst_writer_close(fst_writer* writer);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif  /* FST_C_API_H */
@@ -0,0 +1,489 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include <ifsttable.h>
+#include <icolumnfactory.h>
+
+#include <fstdefines.h>
+#include <fststore.h>
+#include <fstcopy.h>
+#include <stringvectorcolumn.h>
+#include <vectorcolumn.h>
+
+#include <character_v6.h>
+#include <factor_v7.h>
+
+#include <xxhash.h>
+
+
+using namespace std;
+
+
+// A single column of a single data chunk that is decompressed with a read through a FstHandle, for which it acts as
+// the column factory and the result table, and compressed again with WriteColumn as a (single column) IFstTable.
+class ChunkColumn : public IFstTable, public IFstTableReader, public IColumnFactory
+{
+  FstColumnType colType;
+  unsigned long long nrOfRows;
+
+  vector<int> intData;          // integer, logical and factor columns
+  vector<double> doubleData;    // double, date and timestamp columns
+  vector<long long> int64Data;
+  StringVectorColumn strings;   // character columns and factor levels
+
+public:
+  ChunkColumn(FstColumnType colType) : colType(colType), nrOfRows(0) {}
+
+  // IColumnFactory
+  IFactorColumn* CreateFactorColumn(unsigned long long nrOfRows) { return new FactorVectorColumn(nrOfRows); }
+  ILogicalColumn* CreateLogicalColumn(unsigned long long nrOfRows) { return new LogicalVectorColumn(nrOfRows); }
+  IDoubleColumn* CreateDoubleColumn(unsigned long long nrOfRows) { return new DoubleVectorColumn(nrOfRows); }
+  IIntegerColumn* CreateIntegerColumn(unsigned long long nrOfRows) { return new IntVectorColumn(nrOfRows); }
+  IInt64Column* CreateInt64Column(unsigned long long nrOfRows) { return new Int64VectorColumn(nrOfRows); }
+  IStringColumn* CreateStringColumn(unsigned long long nrOfRows) { return new StringVectorColumn(); }
+  IStringArray* CreateStringArray() { return nullptr; }  // not used for reading column data
+
+  // IFstTableReader
+  void InitTable(unsigned int nrOfCols, unsigned long long nrOfRows) { this->nrOfRows = nrOfRows; }
+
+  void AddCharColumn(IStringColumn* stringColumn, int colNr)
+  {
+    StringVectorColumn* column = static_cast<StringVectorColumn*>(stringColumn);
+    strings.strings.swap(column->strings);
+    strings.isNA.swap(column->isNA);
+  }
+
+  void AddLogicalColumn(ILogicalColumn* logicalColumn, int colNr)
+  {
+    intData.swap(static_cast<LogicalVectorColumn*>(logicalColumn)->data);
+  }
+
+  void AddIntegerColumn(IIntegerColumn* integerColumn, int colNr)
+  {
+    intData.swap(static_cast<IntVectorColumn*>(integerColumn)->data);
+  }
+
+  void AddDoubleColumn(IDoubleColumn* doubleColumn, int colNr, FstColumnType colType)
+  {
+    doubleData.swap(static_cast<DoubleVectorColumn*>(doubleColumn)->data);
+  }
+
+  void AddInt64Column(IInt64Column* int64Column, int colNr)
+  {
+    int64Data.swap(static_cast<Int64VectorColumn*>(int64Column)->data);
+  }
+
+  void AddFactorColumn(IFactorColumn* factorColumn, int colNr)
+  {
+    FactorVectorColumn* column = static_cast<FactorVectorColumn*>(factorColumn);
+    intData.swap(column->data);
+    strings.strings.swap(column->levels.strings);
+    strings.isNA.swap(column->levels.isNA);
+  }
+
+  void SetColumnAttributes(int colNr, const char* attributeData, unsigned int size) {}
+  void SetColNames() {}
+  void SetKeyColumns(int* keyColPos, unsigned int nrOfKeys) {}
+
+  // IFstTable
+  FstColumnType GetColumnType(unsigned int colNr) { return colType; }
+  IBlockWriter* GetCharWriter(unsigned int colNr) { return new StringVectorWriter(strings); }
+  int* GetLogicalWriter(unsigned int colNr) { return intData.data(); }
+  int* GetIntWriter(unsigned int colNr) { return intData.data(); }
+  double* GetDoubleWriter(unsigned int colNr) { return doubleData.data(); }
+  long long* GetInt64Writer(unsigned int colNr) { return int64Data.data(); }
+  IBlockWriter* GetLevelWriter(unsigned int colNr) { return new StringVectorWriter(strings); }
+  void GetColumnAttributes(unsigned int colNr, vector<char> &attributeData) { attributeData.clear(); }
+  IBlockWriter* GetColNameWriter() { return nullptr; }  // not used for writing column data
+  void GetKeyColumns(int* keyColPos) {}
+  unsigned int NrOfKeys() { return 0; }
+  unsigned int NrOfColumns() { return 1; }
+  unsigned long long NrOfRows() { return nrOfRows; }
+};
+
+
+// A data chunk of the new file: the range of nrOfChunks consecutive data chunks of a table starting at chunkNr
+struct CopiedChunk
+{
+  FstHandle* table;
+  unsigned int chunkNr;
+  unsigned int nrOfChunks;
+  unsigned long long nrOfRows;
+};
+
+
+void FstCopier::AddTable(FstHandle &table)
+{
+  if (!tables.empty() && !tables[0]->SameColumns(table))
+  {
+    throw(runtime_error("The files should have identical column names and types."));
+  }
+
+  tables.push_back(&table);
+}
+
+
+void FstCopier::Recompress(int colNr, int compress)
+{
+  if (compressLevels.size() <= (unsigned int) colNr) compressLevels.resize(colNr + 1, -1);
+
+  compressLevels[colNr] = compress;
+}
+
+
+// The data is copied to the current position of myfile, colOffset is set to the offset of the column data relative to
+// that position
+bool FstCopier::CopyColumn(ostream &myfile, FstHandle &table, unsigned int chunkNr, int colNr, vector<char> &copyBuf,
+  unsigned long long &colOffset)
+{
+  ZoneMap zoneMap;
+  ColumnChecksum checksum;
+
+  if (!table.ReadZoneMap(chunkNr, colNr, zoneMap, true) || !table.ReadChecksum(chunkNr, colNr, checksum))
+  {
+    return false;
+  }
+
+  unsigned long long colPos = table.ChunkPositionData(chunkNr)[colNr];
+  unsigned long long newPos = myfile.tellp();
+
+  colOffset = CHECKSUM_META_SIZE + zoneMap.StoredSize();
+  unsigned long long copySize = colOffset + checksum.DataSize() + CHECKSUM_ENTRY_SIZE * checksum.NrOfBlocks();
+
+  copyBuf.resize(copySize);
+
+  istream &myInput = *table.inputStream;
+  myInput.clear();
+  myInput.seekg(colPos - colOffset);
+  myInput.read(copyBuf.data(), copySize);
+
+  if (!myInput)
+  {
+    throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+  }
+
+  // The header of a factor column holds the file position of the level codes, it's hashed as the first block
+  if (table.ColumnType(colNr) == 7)
+  {
+    char* colData = &copyBuf[colOffset];
+    unsigned int headerSize = fdsMoveFactorVec_v7(colData, (long long) (newPos + colOffset) - (long long) colPos);
+
+    ChecksumEntry entry;
+    memcpy(&entry, &colData[checksum.DataSize()], CHECKSUM_ENTRY_SIZE);
+
+    if (entry.size != headerSize)
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+
+    entry.hash = XXH64(colData, headerSize, 0);
+    memcpy(&colData[checksum.DataSize()], &entry, CHECKSUM_ENTRY_SIZE);
+  }
+
+  myfile.write(copyBuf.data(), copySize);
+
+  return true;
+}
+
+
+// The column is written at the current position of myfile, returns the offset of the column data relative to that
+// position
+unsigned long long FstCopier::RecompressColumn(ostream &myfile, FstHandle &table, unsigned long long firstRow,
+  unsigned long long nrOfRows, int colNr, int compress, int nrOfThreads)
+{
+  FstColumnType colType = StoredColumnType(table.ColumnType(colNr));
+  ChunkColumn chunkColumn(colType);
+
+  // The column is read with the chunk column as the factory of its vectors
+  IColumnFactory* columnFactory = table.SetColumnFactory(&chunkColumn);
+  vector<int> colIndex(1, colNr);
+
+  try
+  {
+    table.ReadRows(chunkColumn, colIndex, firstRow, nrOfRows, nrOfThreads);
+  }
+  catch (const std::runtime_error &)
+  {
+    table.SetColumnFactory(columnFactory);
+    throw;
+  }
+
+  table.SetColumnFactory(columnFactory);
+
+  unsigned short int storedType, baseType;
+  char* colData;
+  SetColumnTypes(chunkColumn, 1, &storedType, &baseType, &colData);
+
+  return WriteColumn(myfile, chunkColumn, 0, colType, colData, 0, chunkColumn.NrOfRows(), compress, nrOfThreads, 0,
+    nullptr);
+}
+
+
+unsigned long long FstCopier::Write(IFstOutput &output, int nrOfThreads)
+{
+  if (tables.empty())
+  {
+    throw(runtime_error("There are no files to copy."));
+  }
+
+  if (!output.IsSeekable())
+  {
+    throw(runtime_error("The copy of a fst file can only be written to a seekable output."));
+  }
+
+  FstHandle &first = *tables[0];
+
+  if (colIndex.empty())
+  {
+    for (int colNr = 0; colNr < first.nrOfCols; ++colNr) colIndex.push_back(colNr);
+  }
+
+  compressLevels.resize(first.nrOfCols, -1);
+
+  // Leading key columns that are retained
+  vector<int> keyIndex;
+
+  for (int keyNr = 0; tables.size() == 1 && keyNr < first.keyLength; ++keyNr)
+  {
+    vector<int>::iterator keyPos = find(colIndex.begin(), colIndex.end(), first.keyColPos[keyNr]);
+
+    if (keyPos == colIndex.end()) break;
+
+    keyIndex.push_back((int) (keyPos - colIndex.begin()));
+  }
+
+  int nrOfCols = (int) colIndex.size();
+  int keyLength = (int) keyIndex.size();
+
+  // Data chunks of the new file, each a range of consecutive data chunks of a table
+  vector<CopiedChunk> chunks;
+  unsigned long long nrOfRows = 0;
+
+  for (FstHandle* table : tables)
+  {
+    for (unsigned int chunkNr = 0; chunkNr < table->NrOfChunks(); ++chunkNr)
+    {
+      unsigned long long chunkNrOfRows = table->ChunkNrOfRows(chunkNr);
+
+      if (chunkRows > 0 && !chunks.empty() && chunks.back().table == table &&
+        chunks.back().nrOfRows + chunkNrOfRows <= chunkRows)
+      {
+        ++chunks.back().nrOfChunks;
+        chunks.back().nrOfRows += chunkNrOfRows;
+        continue;
+      }
+
+      CopiedChunk chunk = { table, chunkNr, 1, chunkNrOfRows };
+      chunks.push_back(chunk);
+    }
+
+    nrOfRows += table->NrOfRows();
+  }
+
+
+  // Table meta information, see the layout in fststore.cpp
+  unsigned long long metaDataSize = 56 + 4 * keyLength + 6 * nrOfCols;
+  vector<char> metaDataBlock(metaDataSize, 0);
+
+  unsigned long long* fstFileID          = (unsigned long long*) &metaDataBlock[0];
+  unsigned int* p_table_version          = (unsigned int*) &metaDataBlock[8];
+  unsigned int* p_tableClassType         = (unsigned int*) &metaDataBlock[12];
+  int* p_keyLength                       = (int*) &metaDataBlock[16];
+  int* p_nrOfColsFirstChunk              = (int*) &metaDataBlock[20];
+  int* keyColPos                         = (int*) &metaDataBlock[24];
+
+  unsigned int offset = 24 + 4 * keyLength;
+
+  unsigned long long* p_nextVertChunkSet = (unsigned long long*) &metaDataBlock[offset + 8];
+  unsigned long long* p_nrOfRows         = (unsigned long long*) &metaDataBlock[offset + 16];
+  unsigned int* p_version                = (unsigned int*) &metaDataBlock[offset + 24];
+  int* p_nrOfCols                        = (int*) &metaDataBlock[offset + 28];
+  unsigned short int* colAttributeTypes  = (unsigned short int*) &metaDataBlock[offset + 32];
+  unsigned short int* colTypes           = (unsigned short int*) &metaDataBlock[offset + 32 + 2 * nrOfCols];
+  unsigned short int* colBaseTypes       = (unsigned short int*) &metaDataBlock[offset + 32 + 4 * nrOfCols];
+
+  *fstFileID            = FST_FILE_ID;
+  *p_table_version      = FST_VERSION;
+  *p_tableClassType     = 1;  // default table
+  *p_keyLength          = keyLength;
+  *p_nrOfColsFirstChunk = nrOfCols;
+  *p_nrOfRows           = nrOfRows;
+  *p_version            = FST_VERSION;
+  *p_nrOfCols           = nrOfCols;
+
+  for (int keyNr = 0; keyNr < keyLength; ++keyNr) keyColPos[keyNr] = keyIndex[keyNr];
+
+  // All column data is written with checksums and a zone map, the attributes are those of the first table
+  StringVectorColumn colNames;
+  colNames.AllocateVec(nrOfCols);
+
+  vector<vector<char>> colAttributes(nrOfCols);
+  bool hasAttributes = false;
+
+  for (int colSel = 0; colSel < nrOfCols; ++colSel)
+  {
+    int colNr = colIndex[colSel];
+
+    colNames.strings[colSel] = first.colNames->GetElement(colNr);
+    colTypes[colSel] = first.colTypes[colNr];
+    colBaseTypes[colSel] = (unsigned short int) StoredColumnType(first.colTypes[colNr]);
+    colAttributeTypes[colSel] = COL_ATTR_ZONE_MAP | COL_ATTR_CHECKSUM;
+
+    first.ReadAttributeData(colNr, colAttributes[colSel]);
+
+    if (!colAttributes[colSel].empty())
+    {
+      colAttributeTypes[colSel] |= COL_ATTR_ATTRIBUTES;
+      hasAttributes = true;
+    }
+  }
+
+
+  ostream* outputStream = output.Open();
+
+  if (outputStream == nullptr)
+  {
+    throw(runtime_error("There was an error creating the file. Please check for a correct filename."));
+  }
+
+  ostream &myfile = *outputStream;
+
+  myfile.write(metaDataBlock.data(), metaDataSize);  // table meta data
+
+  StringVectorWriter colNameWriter(colNames);
+  fdsWriteCharVec_v6(myfile, &colNameWriter, 0);   // column names
+
+  // Vertical chunkset indexes, each preceded by the link to the next index
+  unsigned int nrOfChunks = (unsigned int) chunks.size();
+  unsigned int nrOfIndexes = (nrOfChunks + CHUNK_INDEX_SLOTS - 1) / CHUNK_INDEX_SLOTS;
+  vector<char> chunkIndexes(nrOfIndexes * (8 + CHUNK_INDEX_SIZE), 0);
+
+  unsigned long long indexPos = myfile.tellp();
+  myfile.write(&chunkIndexes[8], CHUNK_INDEX_SIZE);  // completed after the data chunks are written
+
+  if (hasAttributes)
+  {
+    WriteAttributes(myfile, colAttributes);
+  }
+
+  vector<unsigned long long> positionData(nrOfCols);
+  vector<char> copyBuf;
+
+  for (unsigned int chunkNr = 0; chunkNr < nrOfChunks; ++chunkNr)
+  {
+    CopiedChunk &chunk = chunks[chunkNr];
+    FstHandle &table = *chunk.table;
+    unsigned int tableChunkNr = chunk.chunkNr;
+    bool merged = chunk.nrOfChunks > 1;
+
+    unsigned long long chunkStart = myfile.tellp();
+    myfile.write((char*) positionData.data(), 8 * nrOfCols);  // completed after the columns are written
+
+    if (table.verifyOnRead)
+    {
+      for (unsigned int nr = 0; nr < chunk.nrOfChunks; ++nr) table.VerifyChunkColumns(tableChunkNr + nr, colIndex);
+    }
+
+    for (int colSel = 0; colSel < nrOfCols; ++colSel)
+    {
+      int colNr = colIndex[colSel];
+      unsigned long long colPos = myfile.tellp();
+      unsigned long long colOffset;
+
+      if (merged || compressLevels[colNr] >= 0 ||
+        !CopyColumn(myfile, table, tableChunkNr, colNr, copyBuf, colOffset))
+      {
+        int compress = compressLevels[colNr] >= 0 ? compressLevels[colNr] : merged ? mergeCompress : COPY_COMPRESS;
+        colOffset = RecompressColumn(myfile, table, table.ChunkFirstRow(tableChunkNr), chunk.nrOfRows, colNr,
+          compress, nrOfThreads);
+      }
+
+      positionData[colSel] = colPos + colOffset;
+    }
+
+    myfile.seekp(chunkStart);
+    myfile.write((char*) positionData.data(), 8 * nrOfCols);
+    myfile.seekp(0, ios_base::end);
+
+    char* chunkIndex = &chunkIndexes[(chunkNr / CHUNK_INDEX_SLOTS) * (8 + CHUNK_INDEX_SIZE) + 8];
+    unsigned long long* chunkPos                = (unsigned long long*) chunkIndex;
+    unsigned long long* chunkRows               = (unsigned long long*) &chunkIndex[64];
+    unsigned long long* p_nrOfChunksPerIndexRow = (unsigned long long*) &chunkIndex[128];
+    unsigned long long* p_nrOfChunks            = (unsigned long long*) &chunkIndex[136];
+
+    unsigned int slot = chunkNr % CHUNK_INDEX_SLOTS;
+    chunkPos[slot] = chunkStart;
+    chunkRows[slot] = chunk.nrOfRows;
+    *p_nrOfChunksPerIndexRow = 1;
+    *p_nrOfChunks = slot + 1;
+  }
+
+  // Additional chunkset indexes are linked from nextVertChunkSet and from each other
+  unsigned long long indexesPos = myfile.tellp();
+  unsigned long long* p_nextIndex = p_nextVertChunkSet;
+
+  for (unsigned int indexNr = 1; indexNr < nrOfIndexes; ++indexNr)
+  {
+    *p_nextIndex = indexesPos + (indexNr - 1) * (8 + CHUNK_INDEX_SIZE);
+    p_nextIndex = (unsigned long long*) &chunkIndexes[indexNr * (8 + CHUNK_INDEX_SIZE)];
+  }
+
+  for (unsigned int indexNr = 1; indexNr < nrOfIndexes; ++indexNr)
+  {
+    myfile.write(&chunkIndexes[indexNr * (8 + CHUNK_INDEX_SIZE)], 8 + CHUNK_INDEX_SIZE);
+  }
+
+  myfile.seekp(0);
+  myfile.write(metaDataBlock.data(), metaDataSize);  // table header
+
+  myfile.seekp(indexPos);
+  myfile.write(&chunkIndexes[8], CHUNK_INDEX_SIZE);  // vertical chunkset index
+
+  bool writeOk = !myfile.fail();
+  writeOk = output.Close() && writeOk;
+
+  if (!writeOk)
+  {
+    throw(runtime_error("There was an error writing the fst data."));
+  }
+
+  return nrOfRows;
+}
@@ -0,0 +1,131 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#ifndef FST_COPY_H
+#define FST_COPY_H
+
+
+#include <vector>
+#include <ostream>
+
+#include <ifstio.h>
+#include <fsthandle.h>
+
+
+/**
+ Write a new fst file from the stored column data of one or more tables, without decompressing it. The compressed
+ column data of each data chunk, with its zone map and checksums, is copied as is, so a copy runs at the speed of
+ the disk instead of the speed of the compression algorithms. This allows for:
+
+ - a file with a subset or a reordering of the columns of a table (SelectColumns),
+ - a file with the data chunks of multiple tables with identical columns (AddTable),
+ - a file in which only some of the columns are compressed again at a different level (Recompress),
+ - a file in which consecutive small data chunks are merged into larger chunks (MergeChunks).
+
+ The data chunks of the new file are the data chunks of the tables, in the order of the tables. Columns that are
+ compressed again, or of which the data is stored without checksums (files written before checksums were
+ introduced), are decompressed and compressed chunk by chunk. Merged chunks are decompressed and compressed column
+ by column, so only a single column of a merged chunk is kept in memory.
+ */
+class FstCopier
+{
+  std::vector<FstHandle*> tables;
+  std::vector<int> colIndex;        // column of the tables of each column of the new file
+  std::vector<int> compressLevels;  // compression level of each column of the tables, -1 to copy the column data
+  unsigned long long chunkRows;     // maximum number of rows of a merged data chunk, 0 to keep the data chunks
+  int mergeCompress;                // compression level of the columns of merged data chunks
+
+  // Copy the stored data of a column of a data chunk, with its checksum metadata, zone map and checksums. Returns
+  // false if the column data has no checksums, the size of the stored data is then unknown.
+  bool CopyColumn(std::ostream &myfile, FstHandle &table, unsigned int chunkNr, int colNr,
+    std::vector<char> &copyBuf, unsigned long long &colOffset);
+
+  // Decompress a column of a range of rows of a table and compress it again
+  unsigned long long RecompressColumn(std::ostream &myfile, FstHandle &table, unsigned long long firstRow,
+    unsigned long long nrOfRows, int colNr, int compress, int nrOfThreads);
+
+public:
+  FstCopier() : chunkRows(0), mergeCompress(0) {}
+
+  /**
+   Add an opened table. Its data chunks follow the data chunks of the tables added before.
+
+   @param table Opened table, which should remain open during the lifetime of the copier.
+   @throws runtime_error if the column names or types of the table differ from those of the first table.
+   */
+  void AddTable(FstHandle &table);
+
+  /**
+   Select the columns of the new file. By default all columns are copied.
+
+   @param colIndex Column numbers of the selected columns, see FstHandle::SelectColumns of the first table.
+   */
+  void SelectColumns(const std::vector<int> &colIndex) { this->colIndex = colIndex; }
+
+  /**
+   Compress the data of a column again instead of copying it.
+
+   @param colNr Column number in the tables.
+   @param compress Compression level (0 - 100).
+   */
+  void Recompress(int colNr, int compress);
+
+  /**
+   Merge consecutive data chunks of a table into data chunks of at most chunkRows rows. Data chunks with more rows
+   are copied as is.
+
+   @param chunkRows Maximum number of rows of a merged data chunk.
+   @param compress Compression level (0 - 100) of the merged data chunks, columns selected with Recompress use their
+   own level.
+   */
+  void MergeChunks(unsigned long long chunkRows, int compress)
+  {
+    this->chunkRows = chunkRows;
+    mergeCompress = compress;
+  }
+
+  /**
+   Write the new file. The key columns of a single table are retained when the leading key columns are selected,
+   a file with the data chunks of multiple tables has no key columns.
+
+   @param output Destination of the new file, which should be seekable.
+   @param nrOfThreads Number of threads used to compress columns that are compressed again.
+   @return Number of rows written.
+   */
+  unsigned long long Write(IFstOutput &output, int nrOfThreads);
+};
+
+
+#endif  // FST_COPY_H
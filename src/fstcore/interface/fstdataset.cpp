@@ -0,0 +1,116 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#include <stdexcept>
+
+#include <fstdataset.h>
+
+
+using namespace std;
+
+
+void FstDataset::AddTable(FstHandle &table)
+{
+  if (tables.empty())
+  {
+    tables.push_back(&table);
+    return;
+  }
+
+  if (!tables[0]->SameColumns(table))
+  {
+    throw(runtime_error("The files of a dataset should have identical column names and types."));
+  }
+
+  tables.push_back(&table);
+}
+
+
+unsigned long long FstDataset::NrOfRows() const
+{
+  unsigned long long nrOfRows = 0;
+
+  for (FstHandle* table : tables) nrOfRows += table->nrOfRows;
+
+  return nrOfRows;
+}
+
+
+unsigned long long FstDataset::Read(IFstTableReader &tableReader, const vector<int> &colIndex, int nrOfThreads)
+{
+  if (tables.empty())
+  {
+    throw(runtime_error("The dataset has no files."));
+  }
+
+  vector<ChunkSlice> slices;
+  vector<IFstInput*> inputs;
+  vector<istream*> streams;
+  unsigned long long length = 0;
+
+  // All rows of each table, placed after the rows of the previous tables
+  for (unsigned int tableNr = 0; tableNr < tables.size(); ++tableNr)
+  {
+    FstHandle &table = *tables[tableNr];
+
+    if (table.inputStream == nullptr)
+    {
+      throw(runtime_error("The files of a dataset should be opened before they are read."));
+    }
+
+    table.inputStream->clear();  // reset state from a previous read at the end of the file
+    inputs.push_back(&table.input);
+    streams.push_back(table.inputStream);
+
+    unsigned int firstSlice = (unsigned int) slices.size();
+    table.ChunkSlices(0, table.nrOfRows, length, tableNr, slices);
+
+    if (table.verifyOnRead)
+    {
+      for (unsigned int sliceNr = firstSlice; sliceNr < slices.size(); ++sliceNr)
+      {
+        table.VerifyChunkColumns(slices[sliceNr].chunkNr, colIndex);
+      }
+    }
+
+    length += table.nrOfRows;
+  }
+
+  // Blocks of different files can't share the block cache of a single file
+  tables[0]->ReadSlices(tableReader, tables[0]->columnFactory, colIndex, inputs, streams, slices, length,
+    nrOfThreads, 0);
+
+  return length;
+}
@@ -0,0 +1,90 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_DATASET_H
+#define FST_DATASET_H
+
+
+#include <vector>
+
+#include <fsthandle.h>
+
+
+/**
+ Set of fst tables with identical columns, such as the files of a dataset that is partitioned by day or symbol,
+ that are read into a single table. The data chunks of all tables are read as if they were the chunks of a single
+ table: the result columns are allocated once for the total number of rows and each chunk is decompressed
+ directly into its part of the result. Integer, double, 64-bit integer and logical columns are decompressed
+ concurrently over the chunks of all tables, the levels of factor columns are merged.
+ */
+class FstDataset
+{
+  std::vector<FstHandle*> tables;
+
+public:
+  /**
+   Add an opened table. Its rows follow the rows of the tables added before.
+
+   @param table Opened table, which should remain open during the lifetime of the dataset.
+   @throws runtime_error if the column names or types of the table differ from those of the first table.
+   */
+  void AddTable(FstHandle &table);
+
+  /**
+   Number of tables in the dataset.
+   */
+  unsigned int NrOfTables() const { return (unsigned int) tables.size(); }
+
+  /**
+   Total number of rows of the tables.
+   */
+  unsigned long long NrOfRows() const;
+
+  /**
+   Read all rows of the selected columns of the tables. The column names, types and attributes of the result are
+   those of the first table. The result has no key columns, as the tables aren't necessarily sorted relative to
+   each other.
+
+   @param tableReader Receives the result table.
+   @param colIndex Selected columns, see FstHandle::SelectColumns of the first table.
+   @param nrOfThreads Number of threads used for decompression.
+   @return Number of rows read.
+   */
+  unsigned long long Read(IFstTableReader &tableReader, const std::vector<int> &colIndex, int nrOfThreads);
+};
+
+
+#endif  // FST_DATASET_H
@@ -38,15 +38,72 @@
 
 
 #define FST_VERSION         1                  // version of fst codebase
+#define FST_VERSION_STREAM  2                  // file version of the append-only layout with a chunkset index trailer
+#define FOOTER_SIZE         16                 // size of the footer of the append-only layout
 #define TABLE_META_SIZE     24                 // size of table meta-data block
 #define BLOCKSIZE           16384              // number of bytes in default compression block
+#define MIN_BLOCK_SIZE      1024               // minimum (and granularity of a) user defined compression block size
+#define MAX_BLOCK_SIZE      268435456          // maximum user defined compression block size (256 MB)
 #define FST_FILE_ID         0xa91c12f8b245a71d // identifies a fst file
 #define CHUNK_INDEX_SIZE    144                // size of fixed component of vertical chunk index
+#define CHUNK_INDEX_SLOTS   8                  // number of data chunks in a single vertical chunk index
 #define MAX_CHAR_STACK_SIZE 32768              // number of characters in default compression block
-#define BLOCKSIZE_CHAR      2047               // number of characters in default compression block
+#define BLOCKSIZE_CHAR      2047               // default number of strings in a block of a character column
+#define CHAR_BLOCK_BYTES    65536              // target size of the character data in a block of a character column
+#define CHAR_MIN_BLOCK_SIZE 8                  // minimum number of strings in a block of a character column
+#define CHAR_MAX_BLOCK_SIZE 16376              // maximum number of strings in a block of a character column
+#define CHAR_SIZE_SAMPLES   16                 // number of samples used to estimate the average string size
+#define CHAR_SAMPLE_ROWS    32                 // number of strings in a single sample
 #define CHAR_HEADER_SIZE    8                  // meta data header size
 #define CHAR_INDEX_SIZE     16                 // size of 1 index entry
-#define BASIC_HEAP_SIZE     1048576            // starting size of heap buffer
+#define CHAR_NO_NA_BITS     0x8000             // flag in the string size algorithm of a block without (stored) NA bits
+#define CHAR_FRONT_CODED    0x8000             // flag in the character data algorithm of a front coded block
+#define CHAR_FRONT_RESTART  16                 // number of strings between restart points of a front coded block
+#define CHAR_DICT_SIZE      8192               // maximum size of the compression dictionary of a character column
+#define CHAR_DICT_SAMPLES   32                 // maximum number of blocks sampled for a character column dictionary
+#define CHAR_DICT_MIN_BLOCKS 8                 // minimum number of blocks of a character column that uses a dictionary
+#define CHAR_DICT_PROBES    4                  // number of blocks used to verify the gain of a character column dictionary
+#define CHAR_LEVEL_MIN_ROWS 8192               // minimum length of a character column stored as level codes
+#define CHAR_LEVEL_MAX      32767              // maximum number of levels of a character column stored as level codes
+#define CHAR_LEVEL_REPEATS  8                  // minimum average number of rows per level for level codes
+#define CHAR_PIPELINE_MIN_BLOCKS 4             // minimum number of blocks of a character read or write using worker threads
+#define CHAR_PIPELINE_SLOTS 2                  // number of decoded blocks buffered per decoding thread of the pipeline
+#define CHAR_WRITE_BATCH    4                  // number of blocks per thread in a batch of a parallel character write
+#define BASIC_HEAP_SIZE     1048576            // minimum size of the character staging buffer
+#define PARALLEL_READ_BATCH 256                // maximum number of columns allocated for a single parallel read
+#define PARALLEL_READ_TASK  1048576            // number of bytes of column data decompressed by a single read task
+#define GATHER_MAX_ROWS     1048576            // maximum length of a row range decompressed for a set of selected rows
+#define LEVEL_REMAP_SEGMENT 262144             // minimum number of factor codes translated with multiple threads
+#define FILTER_BATCH_ROWS   1048576            // maximum number of rows of the compared columns decompressed at once
+#define AGGR_BATCH_ROWS     1048576            // maximum number of rows of an aggregated column decompressed at once
+#define KEY_BATCH_MIN_KEYS  1024               // minimum number of keys looked up by a thread of a batched key lookup
+#define SCAN_BATCH_ROWS     1048576            // default maximum number of rows of a batch of a scan
+#define PREFETCH_MAX_GAP    262144             // maximum gap between byte ranges that are merged into a single prefetch
+#define RANGE_PAGE_SIZE     262144             // size of the cached pages of a remote (range request) input
+#define RANGE_MAX_REQUEST   8388608            // maximum size of a single coalesced request of a remote input
+#define WRITE_BUFFER_SIZE   4194304            // size of the output buffers written to a file by the I/O thread
+#define WRITE_BUFFERS       2                  // number of output buffers of a file (double buffering)
+#define DIRECT_IO_ALIGNMENT 4096               // alignment of the file positions, sizes and buffers of direct I/O
+#define DIRECT_IO_BUFFER    4194304            // size of the aligned buffer of direct reads
+#define DIRECT_IO_MIN_READ  262144             // minimum size of a read that bypasses the page cache
+#define READ_PREFIX_SIZE    65536              // default number of bytes read from the start of a file in a single read
+#define READ_PREFIX_MAX     16777216           // maximum size of the prefix of a file that is read in a single read
+#define POSITIONAL_READ_BUFFER 65536           // size of the buffer of a stream of a shared file input
+#define SHARED_CACHE_FILES  4096               // number of files that can use the shared block cache
+#define SHARED_CACHE_SLOT   4096               // bytes of block data per slot of the shared block cache index
+#define SHARED_CACHE_PROBES 64                 // maximum number of probed slots of the shared block cache index
+#define HUGE_PAGE_SIZE      2097152            // size of a transparent huge page
+#define HUGE_PAGE_SIZE_MIN  8388608            // minimum size of a result vector that is backed by huge pages
+#define COPY_COMPRESS       50                 // compression level of copied columns stored without checksums
+#define COL_ATTR_ZONE_MAP   0x8000             // column attribute flag: column data is preceded by a zone map
+#define COL_ATTR_CHECKSUM   0x4000             // column attribute flag: zone map is preceded by data checksums
+#define COL_ATTR_ATTRIBUTES 0x2000             // column attribute flag: column has data in the attribute section
+#define COL_ATTR_BLOOM      0x1000             // column attribute flag: checksum metadata is preceded by Bloom filters
+#define COL_ATTR_PRECISION  0x0800             // column attribute flag: doubles are stored with a reduced precision
+#define COL_ATTR_DELETED    0x0400             // column attribute flag: column is deleted and hidden from readers
+#define COL_ATTR_BITS_MASK  0x003F             // column attribute bits: mantissa bits kept by a reduced precision column
+#define ATTRIBUTE_ID        0x5342495254544101 // attribute section identifier (version 1)
+#define KEY_COL_DROPPED     -1                 // keyColPos of a key column invalidated by appended rows
 
 
 // fst specific errors
@@ -55,6 +112,7 @@
 #define FSTERROR_NO_APPEND           "This version of the fst file format does not allow appending data"
 #define FSTERROR_DAMAGED_HEADER      "Error reading file header, your fst file is incomplete or damaged"
 #define FSTERROR_INCORRECT_COL_COUNT "Data frame has an incorrect amount of columns"
+#define FSTERROR_INCORRECT_COL_TYPE  "Data frame has a column type that differs from the stored column type"
 
 
 #endif // FSTDEFINES_H
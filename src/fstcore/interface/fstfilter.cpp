@@ -0,0 +1,893 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include <stdexcept>
+#include <cstring>
+#include <climits>
+#include <cmath>
+#include <algorithm>
+#include <map>
+
+#include <fstdefines.h>
+#include <fstfilter.h>
+#include <stringvectorcolumn.h>
+
+#include <character_v6.h>
+#include <factor_v7.h>
+#include <integer_v8.h>
+#include <integer64_v11.h>
+#include <double_v9.h>
+#include <logical_v10.h>
+
+
+using namespace std;
+
+
+// Rows firstRow until endRow of a data chunk (relative to the first row of the chunk)
+struct RowRange
+{
+  unsigned long long firstRow;
+  unsigned long long endRow;
+};
+
+
+// Predicate with its columns resolved and its operands sorted
+class FilterNode
+{
+public:
+  PredicateOperator op;
+  int colNr;
+  unsigned short int colType;  // stored column type
+  vector<double> values;
+  vector<string> strings;
+  bool matchNA;
+  vector<FilterNode> operands;
+
+  // Factor columns only: matching level codes of the current data chunk, element 0 is unused
+  vector<char> levelMatch;
+  vector<unsigned int> levelMatchCount;  // cumulative number of matching levels
+
+  // Equality tests of integer, 64-bit integer and character columns: Bloom filter hashes of the operands that can
+  // be equal to a value of the column
+  bool useBloom;
+  vector<unsigned long long> hashes;
+
+  FilterNode() : useBloom(false) {}
+
+  bool IsLeaf() const { return op != PredicateOperator::AND && op != PredicateOperator::OR; }
+};
+
+
+// Values of a compared column in the scanned row range
+struct ColumnData
+{
+  vector<int> ints;  // integer, logical and factor columns
+  vector<double> doubles;
+  vector<long long> longs;  // 64-bit integer columns
+  StringVectorColumn strings;
+
+  // Run-length encoded integer, logical and factor columns are read as runs instead of ints
+  bool hasRuns;
+  vector<int> runValues;
+  vector<unsigned long long> runEnds;
+
+  ColumnData() : hasRuns(false) {}
+};
+
+
+template<typename T>
+inline bool Compare(PredicateOperator op, const T &value, const T &operand)
+{
+  switch (op)
+  {
+    case PredicateOperator::EQUAL:
+      return value == operand;
+
+    case PredicateOperator::NOT_EQUAL:
+      return value != operand;
+
+    case PredicateOperator::LESS:
+      return value < operand;
+
+    case PredicateOperator::LESS_EQUAL:
+      return value <= operand;
+
+    case PredicateOperator::GREATER:
+      return value > operand;
+
+    default:  // GREATER_EQUAL
+      return value >= operand;
+  }
+}
+
+
+// Hash the operands of an equality test for the Bloom filters of the compared column
+void PrepareHashes(FilterNode &node)
+{
+  node.useBloom = false;
+  node.hashes.clear();
+
+  if (node.op != PredicateOperator::EQUAL && node.op != PredicateOperator::IN_SET) return;
+
+  if (node.colType == 6)
+  {
+    for (vector<string>::const_iterator it = node.strings.begin(); it != node.strings.end(); ++it)
+    {
+      node.hashes.push_back(BloomFilter::StringHash(it->data(), (unsigned int) it->size()));
+    }
+
+    node.useBloom = true;
+    return;
+  }
+
+  if (node.colType != 8 && node.colType != 11) return;
+
+  for (vector<double>::const_iterator it = node.values.begin(); it != node.values.end(); ++it)
+  {
+    double operand = *it;
+
+    // Values are compared as doubles, so 64-bit integers beyond 2^53 can equal an operand with a different hash
+    if (node.colType == 11 && fabs(operand) >= 9007199254740992.0) return;
+
+    // Operands without an equal integer value never match
+    if (operand != floor(operand) || (node.colType == 8 && (operand <= INT_MIN || operand > INT_MAX))) continue;
+
+    node.hashes.push_back(BloomFilter::IntHash((long long) operand));
+  }
+
+  node.useBloom = true;
+}
+
+
+// Resolve the columns of a predicate and validate the operands against the column types
+void PrepareNode(const FstPredicate &predicate, FilterNode &node, ColumnNameIndex &colNameIndex,
+  vector<unsigned short int> &colTypes)
+{
+  node.op      = predicate.op;
+  node.matchNA = predicate.matchNA;
+
+  if (!node.IsLeaf())
+  {
+    if (predicate.operands.empty())
+    {
+      throw(runtime_error("Logical operators in the row filter should have at least one operand."));
+    }
+
+    node.colNr = -1;
+    node.operands.resize(predicate.operands.size());
+
+    for (unsigned int pos = 0; pos < predicate.operands.size(); ++pos)
+    {
+      PrepareNode(*predicate.operands[pos], node.operands[pos], colNameIndex, colTypes);
+    }
+
+    return;
+  }
+
+  node.colNr = colNameIndex.Find(predicate.colName.c_str());
+
+  if (node.colNr == -1)
+  {
+    throw(runtime_error("Column '" + predicate.colName + "' in the row filter was not found."));
+  }
+
+  node.colType = colTypes[node.colNr];
+  node.values  = predicate.values;
+
+  if (node.colType == 12 || node.colType == 13) node.colType = 9;  // dates and timestamps are stored as doubles
+
+  node.strings = predicate.strings;
+
+  bool isText = node.colType == 6 || node.colType == 7;
+
+  if (isText ? !node.values.empty() : !node.strings.empty())
+  {
+    throw(runtime_error("Column '" + predicate.colName + "' in the row filter should be compared with " +
+      (isText ? "character" : "numeric") + " values."));
+  }
+
+  if (node.colType == 7 && node.op != PredicateOperator::EQUAL && node.op != PredicateOperator::NOT_EQUAL &&
+    node.op != PredicateOperator::IN_SET)
+  {
+    throw(runtime_error("Factor column '" + predicate.colName +
+      "' in the row filter can only be tested for (in)equality."));
+  }
+
+  if (node.op == PredicateOperator::IN_SET)
+  {
+    // Sorted for binary searches, NaN operands are equivalent to matchNA
+    vector<double>::iterator lastValue = remove_if(node.values.begin(), node.values.end(),
+      [](double value) { return value != value; });
+    if (lastValue != node.values.end()) node.matchNA = true;
+    node.values.erase(lastValue, node.values.end());
+
+    sort(node.values.begin(), node.values.end());
+    sort(node.strings.begin(), node.strings.end());
+
+    PrepareHashes(node);
+    return;
+  }
+
+  if (node.values.size() + node.strings.size() != 1)
+  {
+    throw(runtime_error("Comparisons in the row filter should have a single operand."));
+  }
+
+  node.matchNA = false;
+
+  // A comparison with NaN is never true, the equivalent empty set is evaluated instead
+  if (!isText && node.values[0] != node.values[0])
+  {
+    node.op = PredicateOperator::IN_SET;
+    node.values.clear();
+  }
+
+  PrepareHashes(node);
+}
+
+
+// Determine the matching level codes of a factor column in a data chunk
+void PrepareLevels(FilterNode &node, StringVectorColumn &levels)
+{
+  unsigned int nrOfLevels = (unsigned int) levels.strings.size();
+
+  node.levelMatch.assign(nrOfLevels + 1, 0);
+  node.levelMatchCount.assign(nrOfLevels + 1, 0);
+
+  for (unsigned int level = 0; level < nrOfLevels; ++level)
+  {
+    const string &levelStr = levels.strings[level];
+    bool match;
+
+    if (node.op == PredicateOperator::IN_SET)
+    {
+      match = binary_search(node.strings.begin(), node.strings.end(), levelStr);
+    }
+    else
+    {
+      match = Compare(node.op, levelStr, node.strings[0]);
+    }
+
+    node.levelMatch[level + 1] = match ? 1 : 0;
+    node.levelMatchCount[level + 1] = node.levelMatchCount[level] + (match ? 1 : 0);
+  }
+}
+
+
+// Leading bytes of a string, padded with zeros as in the zone map
+inline void StringPrefix(const string &str, char* prefix)
+{
+  memset(prefix, 0, ZONE_MAP_PREFIX_SIZE);
+  memcpy(prefix, str.data(), min(str.size(), (size_t) ZONE_MAP_PREFIX_SIZE));
+}
+
+
+// Test if a character block with the given statistics can contain a string that satisfies the comparison
+bool CharBlockMayMatch(PredicateOperator op, const string &operand, const ZoneMapEntry &entry)
+{
+  char prefix[ZONE_MAP_PREFIX_SIZE];
+  StringPrefix(operand, prefix);
+
+  int minComp = memcmp(entry.minPrefix, prefix, ZONE_MAP_PREFIX_SIZE);
+  int maxComp = memcmp(entry.maxPrefix, prefix, ZONE_MAP_PREFIX_SIZE);
+
+  switch (op)
+  {
+    case PredicateOperator::EQUAL:
+      return minComp <= 0 && maxComp >= 0;
+
+    case PredicateOperator::NOT_EQUAL:
+      // Strings shorter than the prefix are stored completely, so the block could only consist of the operand
+      return operand.size() >= ZONE_MAP_PREFIX_SIZE || minComp != 0 || maxComp != 0;
+
+    case PredicateOperator::LESS:
+    case PredicateOperator::LESS_EQUAL:
+      return minComp <= 0;
+
+    default:  // GREATER and GREATER_EQUAL
+      return maxComp >= 0;
+  }
+}
+
+
+// Test if a block with the given statistics can contain a row that satisfies a leaf predicate
+bool BlockMayMatch(const FilterNode &node, const ZoneMapEntry &entry)
+{
+  if (entry.naCount > 0 && node.matchNA) return true;
+
+  if (entry.naCount == entry.nrOfValues) return false;  // minimum and maximum are undefined
+
+  // Character columns
+  if (node.colType == 6)
+  {
+    if (node.op != PredicateOperator::IN_SET)
+    {
+      return CharBlockMayMatch(node.op, node.strings[0], entry);
+    }
+
+    for (vector<string>::const_iterator it = node.strings.begin(); it != node.strings.end(); ++it)
+    {
+      if (CharBlockMayMatch(PredicateOperator::EQUAL, *it, entry)) return true;
+    }
+
+    return false;
+  }
+
+  // Factor columns, test for a matching level code in the range of the block
+  if (node.colType == 7)
+  {
+    unsigned int maxLevel = (unsigned int) node.levelMatch.size() - 1;
+    unsigned int minCode = (unsigned int) max(entry.minValue, 1.0);
+    unsigned int maxCode = (unsigned int) min(entry.maxValue, (double) maxLevel);
+
+    return minCode <= maxCode && node.levelMatchCount[maxCode] > node.levelMatchCount[minCode - 1];
+  }
+
+  // Integer, double and logical columns. Values of 64-bit integer columns are compared as doubles, which keeps
+  // the order of the values
+  double minValue = node.colType == 11 ? (double) entry.minInt64 : entry.minValue;
+  double maxValue = node.colType == 11 ? (double) entry.maxInt64 : entry.maxValue;
+
+  if (node.op == PredicateOperator::IN_SET)
+  {
+    vector<double>::const_iterator it = lower_bound(node.values.begin(), node.values.end(), minValue);
+
+    return it != node.values.end() && *it <= maxValue;
+  }
+
+  double operand = node.values[0];
+
+  switch (node.op)
+  {
+    case PredicateOperator::EQUAL:
+      return minValue <= operand && maxValue >= operand;
+
+    case PredicateOperator::NOT_EQUAL:
+      return minValue != operand || maxValue != operand;
+
+    case PredicateOperator::LESS:
+      return minValue < operand;
+
+    case PredicateOperator::LESS_EQUAL:
+      return minValue <= operand;
+
+    case PredicateOperator::GREATER:
+      return maxValue > operand;
+
+    default:  // GREATER_EQUAL
+      return maxValue >= operand;
+  }
+}
+
+
+// Append a row range to a sorted list of ranges, joining adjacent ranges
+inline void AddRange(vector<RowRange> &ranges, unsigned long long firstRow, unsigned long long endRow)
+{
+  if (!ranges.empty() && ranges.back().endRow >= firstRow)
+  {
+    ranges.back().endRow = max(ranges.back().endRow, endRow);
+    return;
+  }
+
+  RowRange range;
+  range.firstRow = firstRow;
+  range.endRow   = endRow;
+  ranges.push_back(range);
+}
+
+
+// Rows that are present in both lists of ranges
+void IntersectRanges(const vector<RowRange> &left, const vector<RowRange> &right, vector<RowRange> &result)
+{
+  result.clear();
+
+  unsigned int leftPos = 0;
+  unsigned int rightPos = 0;
+
+  while (leftPos < left.size() && rightPos < right.size())
+  {
+    unsigned long long firstRow = max(left[leftPos].firstRow, right[rightPos].firstRow);
+    unsigned long long endRow = min(left[leftPos].endRow, right[rightPos].endRow);
+
+    if (firstRow < endRow) AddRange(result, firstRow, endRow);
+
+    if (left[leftPos].endRow < right[rightPos].endRow) ++leftPos; else ++rightPos;
+  }
+}
+
+
+// Rows that are present in either list of ranges
+void UniteRanges(const vector<RowRange> &left, const vector<RowRange> &right, vector<RowRange> &result)
+{
+  result.clear();
+
+  unsigned int leftPos = 0;
+  unsigned int rightPos = 0;
+
+  while (leftPos < left.size() || rightPos < right.size())
+  {
+    if (rightPos == right.size() || (leftPos < left.size() && left[leftPos].firstRow < right[rightPos].firstRow))
+    {
+      AddRange(result, left[leftPos].firstRow, left[leftPos].endRow);
+      ++leftPos;
+    }
+    else
+    {
+      AddRange(result, right[rightPos].firstRow, right[rightPos].endRow);
+      ++rightPos;
+    }
+  }
+}
+
+
+// Evaluate a leaf predicate on a value of an integer, logical or factor column
+inline bool IntMatch(const FilterNode &node, int value)
+{
+  if (value == INT_MIN) return node.matchNA;
+
+  if (node.colType == 7)  // factor level code
+  {
+    return value >= 1 && value < (int) node.levelMatch.size() && node.levelMatch[value];
+  }
+
+  if (node.op == PredicateOperator::IN_SET)
+  {
+    return binary_search(node.values.begin(), node.values.end(), (double) value);
+  }
+
+  return Compare(node.op, (double) value, node.values[0]);
+}
+
+
+// Evaluate a leaf predicate on the values of its column
+void EvaluateLeaf(const FilterNode &node, ColumnData &data, vector<char> &mask, unsigned long long length)
+{
+  PredicateOperator op = node.op;
+
+  // The predicate is evaluated once for each run
+  if (data.hasRuns)
+  {
+    unsigned long long runStart = 0;
+
+    for (size_t run = 0; run < data.runValues.size(); ++run)
+    {
+      unsigned long long runEnd = data.runEnds[run];
+      memset(&mask[runStart], IntMatch(node, data.runValues[run]) ? 1 : 0, runEnd - runStart);
+      runStart = runEnd;
+    }
+
+    return;
+  }
+
+  switch (node.colType)
+  {
+    case 6:  // character
+    {
+      const vector<string> &strings = data.strings.strings;
+      const vector<char> &isNA = data.strings.isNA;
+
+      for (unsigned long long row = 0; row < length; ++row)
+      {
+        if (isNA[row])
+        {
+          mask[row] = node.matchNA;
+        }
+        else if (op == PredicateOperator::IN_SET)
+        {
+          mask[row] = binary_search(node.strings.begin(), node.strings.end(), strings[row]);
+        }
+        else
+        {
+          mask[row] = Compare(op, strings[row], node.strings[0]);
+        }
+      }
+
+      return;
+    }
+
+    case 7:  // factor
+    {
+      const int* codes = data.ints.data();
+
+      for (unsigned long long row = 0; row < length; ++row)
+      {
+        mask[row] = IntMatch(node, codes[row]);
+      }
+
+      return;
+    }
+
+    case 9:  // double
+    {
+      const double* values = data.doubles.data();
+
+      for (unsigned long long row = 0; row < length; ++row)
+      {
+        double value = values[row];
+
+        if (value != value)
+        {
+          mask[row] = node.matchNA;
+        }
+        else if (op == PredicateOperator::IN_SET)
+        {
+          mask[row] = binary_search(node.values.begin(), node.values.end(), value);
+        }
+        else
+        {
+          mask[row] = Compare(op, value, node.values[0]);
+        }
+      }
+
+      return;
+    }
+
+    case 11:  // 64-bit integer
+    {
+      const long long* values = data.longs.data();
+
+      for (unsigned long long row = 0; row < length; ++row)
+      {
+        long long value = values[row];
+
+        if (value == LLONG_MIN)
+        {
+          mask[row] = node.matchNA;
+        }
+        else if (op == PredicateOperator::IN_SET)
+        {
+          mask[row] = binary_search(node.values.begin(), node.values.end(), (double) value);
+        }
+        else
+        {
+          mask[row] = Compare(op, (double) value, node.values[0]);
+        }
+      }
+
+      return;
+    }
+
+    default:  // integer and logical
+    {
+      const int* values = data.ints.data();
+
+      for (unsigned long long row = 0; row < length; ++row)
+      {
+        mask[row] = IntMatch(node, values[row]);
+      }
+    }
+  }
+}
+
+
+void Evaluate(const FilterNode &node, map<int, ColumnData> &columns, vector<char> &mask, unsigned long long length)
+{
+  if (node.IsLeaf())
+  {
+    EvaluateLeaf(node, columns[node.colNr], mask, length);
+    return;
+  }
+
+  Evaluate(node.operands[0], columns, mask, length);
+
+  vector<char> operandMask(length);
+  bool isAnd = node.op == PredicateOperator::AND;
+
+  for (unsigned int pos = 1; pos < node.operands.size(); ++pos)
+  {
+    Evaluate(node.operands[pos], columns, operandMask, length);
+
+    for (unsigned long long row = 0; row < length; ++row)
+    {
+      mask[row] = isAnd ? (mask[row] & operandMask[row]) : (mask[row] | operandMask[row]);
+    }
+  }
+}
+
+
+// Collect the leaf predicates of a tree
+void CollectLeaves(FilterNode &node, vector<FilterNode*> &leaves)
+{
+  if (node.IsLeaf())
+  {
+    leaves.push_back(&node);
+    return;
+  }
+
+  for (vector<FilterNode>::iterator it = node.operands.begin(); it != node.operands.end(); ++it)
+  {
+    CollectLeaves(*it, leaves);
+  }
+}
+
+
+// Test if the Bloom filter of a block can contain one of the compared values of an equality test
+bool BloomMayMatch(const FilterNode &node, const BloomFilter &bloomFilter, unsigned long long blockNr,
+  const ZoneMapEntry &entry)
+{
+  if (entry.naCount > 0 && node.matchNA) return true;
+
+  for (vector<unsigned long long>::const_iterator it = node.hashes.begin(); it != node.hashes.end(); ++it)
+  {
+    if (bloomFilter.MayContain(blockNr, *it)) return true;
+  }
+
+  return false;
+}
+
+
+// Determine the row ranges of a data chunk that can contain matching rows
+void CandidateRanges(FstHandle &fstHandle, const FilterNode &node, unsigned int chunkNr, vector<RowRange> &ranges)
+{
+  ranges.clear();
+  unsigned long long chunkRows = fstHandle.ChunkNrOfRows(chunkNr);
+
+  if (!node.IsLeaf())
+  {
+    CandidateRanges(fstHandle, node.operands[0], chunkNr, ranges);
+
+    vector<RowRange> operandRanges, result;
+    bool isAnd = node.op == PredicateOperator::AND;
+
+    for (unsigned int pos = 1; pos < node.operands.size(); ++pos)
+    {
+      if (isAnd && ranges.empty()) return;
+
+      CandidateRanges(fstHandle, node.operands[pos], chunkNr, operandRanges);
+
+      if (isAnd)
+      {
+        IntersectRanges(ranges, operandRanges, result);
+      }
+      else
+      {
+        UniteRanges(ranges, operandRanges, result);
+      }
+
+      ranges.swap(result);
+    }
+
+    return;
+  }
+
+  ZoneMap zoneMap;
+
+  // Without statistics, all rows of the chunk are scanned
+  if (!fstHandle.ReadZoneMap(chunkNr, node.colNr, zoneMap))
+  {
+    AddRange(ranges, 0, chunkRows);
+    return;
+  }
+
+  unsigned long long blockSize = zoneMap.BlockSize();
+
+  // Equality tests also skip the blocks of which the Bloom filter excludes the compared values
+  BloomFilter bloomFilter;
+  bool hasBloomFilter = node.useBloom && fstHandle.ReadBloomFilter(chunkNr, node.colNr, zoneMap, bloomFilter);
+
+  for (unsigned long long blockNr = 0; blockNr < zoneMap.NrOfBlocks(); ++blockNr)
+  {
+    const ZoneMapEntry &entry = zoneMap.Block(blockNr);
+
+    if (BlockMayMatch(node, entry) && (!hasBloomFilter || BloomMayMatch(node, bloomFilter, blockNr, entry)))
+    {
+      AddRange(ranges, blockNr * blockSize, min((blockNr + 1) * blockSize, chunkRows));
+    }
+  }
+}
+
+
+// Collects the matching rows of the scanned batches
+class RowCollector : public IRowMask
+{
+  FstHandle &fstHandle;
+  vector<unsigned long long> &rows;
+
+public:
+  RowCollector(FstHandle &fstHandle, vector<unsigned long long> &rows) : fstHandle(fstHandle), rows(rows) {}
+
+  void AddBatch(unsigned int chunkNr, unsigned long long firstRow, unsigned long long length, const vector<char> &mask)
+  {
+    unsigned long long chunkFirstRow = fstHandle.ChunkFirstRow(chunkNr) + firstRow;
+
+    for (unsigned long long row = 0; row < length; ++row)
+    {
+      if (mask[row]) rows.push_back(chunkFirstRow + row);
+    }
+  }
+};
+
+
+void FstFilter::SelectRows(const FstPredicate &predicate, vector<unsigned long long> &rows, int nrOfThreads)
+{
+  SelectRows(predicate, rows, nrOfThreads, 0, fstHandle.NrOfRows());
+}
+
+
+void FstFilter::SelectRows(const FstPredicate &predicate, vector<unsigned long long> &rows, int nrOfThreads,
+  unsigned long long firstRow, unsigned long long length)
+{
+  rows.clear();
+
+  RowCollector rowCollector(fstHandle, rows);
+  ScanRows(predicate, rowCollector, nrOfThreads, firstRow, length);
+}
+
+
+void FstFilter::ScanRows(const FstPredicate &predicate, IRowMask &rowMask, int nrOfThreads)
+{
+  ScanRows(predicate, rowMask, nrOfThreads, 0, fstHandle.NrOfRows());
+}
+
+
+void FstFilter::ScanRows(const FstPredicate &predicate, IRowMask &rowMask, int nrOfThreads,
+  unsigned long long firstRow, unsigned long long length)
+{
+  if (fstHandle.inputStream == nullptr)
+  {
+    throw(runtime_error("The fst file is not opened."));
+  }
+
+  rowsScanned = 0;
+
+  FilterNode root;
+  PrepareNode(predicate, root, fstHandle.colNameIndex, fstHandle.colTypes);
+
+  vector<FilterNode*> leaves;
+  CollectLeaves(root, leaves);
+
+  istream &myfile = *fstHandle.inputStream;
+  vector<RowRange> ranges;
+  unsigned long long endRow = min(firstRow + length, fstHandle.NrOfRows());
+
+  for (unsigned int chunkNr = 0; chunkNr < fstHandle.NrOfChunks(); ++chunkNr)
+  {
+    // Scanned rows of the chunk, relative to the first row of the chunk
+    unsigned long long chunkFirstRow = fstHandle.ChunkFirstRow(chunkNr);
+    unsigned long long chunkEndRow = chunkFirstRow + fstHandle.ChunkNrOfRows(chunkNr);
+
+    if (chunkEndRow <= firstRow) continue;
+    if (chunkFirstRow >= endRow) break;
+
+    unsigned long long scanFirstRow = firstRow > chunkFirstRow ? firstRow - chunkFirstRow : 0;
+    unsigned long long scanEndRow = min(endRow, chunkEndRow) - chunkFirstRow;
+
+    unsigned long long* blockPos = fstHandle.ChunkPositionData(chunkNr);
+
+    // Factor comparisons are translated to the level codes of the chunk
+    for (vector<FilterNode*>::iterator it = leaves.begin(); it != leaves.end(); ++it)
+    {
+      if ((*it)->colType != 7) continue;
+
+      StringVectorColumn levels;
+      myfile.clear();  // reset state from a previous read at the end of the file
+      fdsReadFactorLevels_v7(myfile, &levels, blockPos[(*it)->colNr]);
+      PrepareLevels(**it, levels);
+    }
+
+    CandidateRanges(fstHandle, root, chunkNr, ranges);
+
+    for (vector<RowRange>::iterator it = ranges.begin(); it != ranges.end(); ++it)
+    {
+      unsigned long long rangeEndRow = min(it->endRow, scanEndRow);
+
+      for (unsigned long long batchRow = max(it->firstRow, scanFirstRow); batchRow < rangeEndRow;
+        batchRow += FILTER_BATCH_ROWS)
+      {
+        unsigned long long batchLength = min((unsigned long long) FILTER_BATCH_ROWS, rangeEndRow - batchRow);
+        ScanRange(root, chunkNr, batchRow, batchLength, rowMask, nrOfThreads);
+      }
+    }
+  }
+}
+
+
+void FstFilter::ScanRange(FilterNode &root, unsigned int chunkNr, unsigned long long firstRow,
+  unsigned long long length, IRowMask &rowMask, int nrOfThreads)
+{
+  istream &myfile = *fstHandle.inputStream;
+  unsigned long long* blockPos = fstHandle.ChunkPositionData(chunkNr);
+  unsigned long long chunkRows = fstHandle.ChunkNrOfRows(chunkNr);
+
+  vector<FilterNode*> leaves;
+  CollectLeaves(root, leaves);
+
+  // Each compared column is decompressed once
+  map<int, ColumnData> columns;
+
+  for (vector<FilterNode*>::iterator it = leaves.begin(); it != leaves.end(); ++it)
+  {
+    int colNr = (*it)->colNr;
+
+    if (columns.find(colNr) != columns.end()) continue;
+
+    ColumnData &data = columns[colNr];
+    unsigned long long pos = blockPos[colNr];
+    myfile.clear();  // reset state from a previous read at the end of the file
+
+    switch ((*it)->colType)
+    {
+      case 6:
+        data.strings.AllocateVec(length);
+        fdsReadCharVecAt_v6(myfile, &data.strings, pos, firstRow, length, chunkRows, 0);
+        break;
+
+      case 7:
+        data.hasRuns = fdsReadFactorCodeRuns_v7(myfile, data.runValues, data.runEnds, pos, firstRow, length);
+        if (data.hasRuns) break;
+
+        data.ints.resize(length);
+        fdsReadFactorCodes_v7(myfile, data.ints.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+        break;
+
+      case 8:
+        data.hasRuns = fdsReadIntRuns_v8(myfile, data.runValues, data.runEnds, pos, firstRow, length);
+        if (data.hasRuns) break;
+
+        data.ints.resize(length);
+        fdsReadIntVec_v8(myfile, data.ints.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+        break;
+
+      case 9:
+        data.doubles.resize(length);
+        fdsReadRealVec_v9(myfile, data.doubles.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+        break;
+
+      case 11:
+        data.longs.resize(length);
+        fdsReadInt64Vec_v11(myfile, data.longs.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+        break;
+
+      case 10:
+        data.hasRuns = fdsReadLogicalRuns_v10(myfile, data.runValues, data.runEnds, pos, firstRow, length);
+        if (data.hasRuns) break;
+
+        data.ints.resize(length);
+        fdsReadLogicalVec_v10(myfile, data.ints.data(), pos, firstRow, length, chunkRows, nrOfThreads);
+        break;
+
+      default:
+        throw(runtime_error("Unknown type found in column."));
+    }
+  }
+
+  rowsScanned += length;
+
+  vector<char> mask(length);
+  Evaluate(root, columns, mask, length);
+
+  rowMask.AddBatch(chunkNr, firstRow, length, mask);
+}
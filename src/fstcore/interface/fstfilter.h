@@ -0,0 +1,168 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_FILTER_H
+#define FST_FILTER_H
+
+
+#include <string>
+#include <vector>
+
+#include <fsthandle.h>
+
+
+enum PredicateOperator
+{
+  EQUAL = 1,
+  NOT_EQUAL,
+  LESS,
+  LESS_EQUAL,
+  GREATER,
+  GREATER_EQUAL,
+  IN_SET,
+  AND,
+  OR
+};
+
+
+/**
+ Row filter on the columns of a fst table. A leaf compares a single column with one operand (or a set of
+ operands for IN_SET), AND and OR combine the results of their operands. NA values never satisfy a
+ comparison, unless matchNA is set on an IN_SET leaf. Character values are compared bytewise.
+ */
+class FstPredicate
+{
+public:
+  PredicateOperator op;
+  std::string colName;                  // compared column
+  std::vector<double> values;           // numeric operands (integer, double and logical columns)
+  std::vector<std::string> strings;     // character operands (character and factor columns)
+  bool matchNA;                         // IN_SET only: NA values are part of the set
+  std::vector<FstPredicate*> operands;  // AND and OR only, owned by the predicate
+
+  FstPredicate(PredicateOperator op) : op(op), matchNA(false) {}
+
+  ~FstPredicate()
+  {
+    for (std::vector<FstPredicate*>::iterator it = operands.begin(); it != operands.end(); ++it)
+    {
+      delete *it;
+    }
+  }
+};
+
+
+class FilterNode;
+
+
+/**
+ Receives the evaluated row filter of a batch of scanned rows (see FstFilter::ScanRows).
+ */
+class IRowMask
+{
+public:
+  virtual ~IRowMask() {}
+
+  /**
+   Rows firstRow until firstRow + length of a data chunk (relative to the first row of the chunk) were scanned.
+
+   @param chunkNr Data chunk of the scanned rows.
+   @param firstRow First scanned row of the data chunk.
+   @param length Number of scanned rows, at most FILTER_BATCH_ROWS.
+   @param mask Element i is 1 if row firstRow + i satisfies the predicate and 0 otherwise.
+   */
+  virtual void AddBatch(unsigned int chunkNr, unsigned long long firstRow, unsigned long long length,
+    const std::vector<char> &mask) = 0;
+};
+
+
+/**
+ Determines the rows of a table that satisfy a predicate. For each data chunk, the zone maps of the compared
+ columns are used to skip all blocks that can't contain a matching row. Only the remaining row ranges of the
+ compared columns are decompressed and evaluated, in batches of at most FILTER_BATCH_ROWS rows. Ranges of
+ run-length encoded columns are not expanded, the comparison is evaluated once per run.
+ */
+class FstFilter
+{
+  FstHandle &fstHandle;
+  unsigned long long rowsScanned;
+
+public:
+  FstFilter(FstHandle &fstHandle) : fstHandle(fstHandle), rowsScanned(0) {}
+
+  /**
+   Select the rows that satisfy the predicate.
+
+   @param predicate Row filter, columns are referenced by name.
+   @param rows Receives the matching rows (0-based) in increasing order.
+   @param nrOfThreads Number of threads available for decompressing the compared columns.
+   */
+  void SelectRows(const FstPredicate &predicate, std::vector<unsigned long long> &rows, int nrOfThreads);
+
+  /**
+   Select the rows in rows firstRow until firstRow + length (0-based) that satisfy the predicate.
+   */
+  void SelectRows(const FstPredicate &predicate, std::vector<unsigned long long> &rows, int nrOfThreads,
+    unsigned long long firstRow, unsigned long long length);
+
+  /**
+   Evaluate the predicate on all rows that can contain a match. Rows that are skipped with the zone maps don't
+   satisfy the predicate and are not passed to rowMask.
+
+   @param predicate Row filter, columns are referenced by name.
+   @param rowMask Receives the evaluated batches in increasing row order.
+   @param nrOfThreads Number of threads available for decompressing the compared columns.
+   */
+  void ScanRows(const FstPredicate &predicate, IRowMask &rowMask, int nrOfThreads);
+
+  /**
+   Evaluate the predicate on the rows in rows firstRow until firstRow + length (0-based) that can contain a match.
+   */
+  void ScanRows(const FstPredicate &predicate, IRowMask &rowMask, int nrOfThreads, unsigned long long firstRow,
+    unsigned long long length);
+
+  /**
+   Number of rows of the compared columns that were decompressed by the last call to SelectRows or ScanRows.
+   */
+  unsigned long long RowsScanned() const { return rowsScanned; }
+
+private:
+  void ScanRange(FilterNode &root, unsigned int chunkNr, unsigned long long firstRow, unsigned long long length,
+    IRowMask &rowMask, int nrOfThreads);
+};
+
+
+#endif  // FST_FILTER_H
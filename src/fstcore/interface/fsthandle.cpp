@@ -0,0 +1,2072 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+
+#include <iostream>
+#include <omp.h>
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <ifsttable.h>
+#include <icolumnfactory.h>
+
+#include <fstdefines.h>
+#include <fststore.h>
+#include <fsthandle.h>
+#include <fsttasks.h>
+#include <fstmmap.h>
+
+#include <character_v6.h>
+#include <factor_v7.h>
+#include <integer_v8.h>
+#include <integer64_v11.h>
+#include <double_v9.h>
+#include <logical_v10.h>
+#include <blockstreamer_v2.h>
+#include <profile.h>
+
+
+using namespace std;
+
+
+// Collect the position data location and number of rows of all data chunks. The first chunkset index is read
+// from the current stream position, appended indexes are found by following their links.
+inline void ReadChunkIndex(istream &myfile, unsigned long long nextIndexPos, vector<unsigned long long> &chunkPositions,
+  vector<unsigned long long> &chunkRowCounts)
+{
+  char chunkIndex[CHUNK_INDEX_SIZE];
+
+  unsigned long long* chunkPos     = (unsigned long long*) chunkIndex;
+  unsigned long long* chunkRows    = (unsigned long long*) &chunkIndex[64];
+  unsigned long long* p_nrOfChunks = (unsigned long long*) &chunkIndex[136];
+
+  unsigned long long indexPos = myfile.tellg();
+
+  while (true)
+  {
+    myfile.read(chunkIndex, CHUNK_INDEX_SIZE);
+
+    if (!myfile || *p_nrOfChunks == 0 || *p_nrOfChunks > CHUNK_INDEX_SLOTS)
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+
+    for (unsigned int chunkNr = 0; chunkNr < *p_nrOfChunks; ++chunkNr)
+    {
+      chunkPositions.push_back(chunkPos[chunkNr]);
+      chunkRowCounts.push_back(chunkRows[chunkNr]);
+    }
+
+    if (nextIndexPos == 0) return;
+
+    // indexes are always appended, so a link pointing backwards indicates a damaged file
+    if (nextIndexPos <= indexPos)
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+
+    indexPos = nextIndexPos + 8;
+    myfile.seekg(nextIndexPos);
+    myfile.read((char*) &nextIndexPos, 8);
+  }
+}
+
+
+// Set the elements of an allocated string column, using the buffer layout of a character block without NA's
+inline void SetStringElements(IStringColumn* stringColumn, const vector<string> &elements)
+{
+  unsigned int nrOfElements = (unsigned int) elements.size();
+
+  for (unsigned int startElem = 0; startElem < nrOfElements; startElem += BLOCKSIZE_CHAR)
+  {
+    unsigned int blockSize = min((unsigned int) BLOCKSIZE_CHAR, nrOfElements - startElem);
+    unsigned int nrOfNAInts = 1 + blockSize / 32;
+
+    vector<unsigned int> sizeMeta(blockSize + nrOfNAInts, 0);  // cumulative string lengths followed by NA bits
+    string buf;
+
+    for (unsigned int elem = 0; elem < blockSize; ++elem)
+    {
+      buf += elements[startElem + elem];
+      sizeMeta[elem] = (unsigned int) buf.size();
+    }
+
+    stringColumn->BufferToVec(blockSize, 0, blockSize - 1, startElem, sizeMeta.data(), &buf[0]);
+  }
+}
+
+
+// Translate the level codes of a part of a factor column with the result code of each code, NA's are unchanged. The
+// loop is branch free so the compiler can vectorize the lookups, long parts are divided over the threads.
+inline void RemapLevelCodes(int* levelData, unsigned long long length, const int* levelMap, unsigned int nrOfLevels,
+  int nrOfThreads)
+{
+  int nrOfSegments = length < LEVEL_REMAP_SEGMENT ? 1 : nrOfThreads;
+
+#pragma omp parallel for schedule(static) num_threads(nrOfSegments)
+  for (long long row = 0; row < (long long) length; ++row)
+  {
+    int value = levelData[row];
+    unsigned int code = (unsigned int) value - 1;  // NA's and out of range values are larger than the last code
+
+    levelData[row] = code < nrOfLevels ? levelMap[code] : value;
+  }
+}
+
+
+// Merges the levels of the parts of a factor column that are read from separate data chunks. The result uses
+// the union of the chunk levels in order of appearance. Only the levels are hashed, the level codes are translated
+// with a lookup table. Chunks with the leading result levels in the same order (typically chunks or files that were
+// appended with the same level set) and chunks with the levels of the previous chunk skip the hashing.
+class FactorLevelMerger
+{
+  vector<string> levels;
+  unordered_map<string, int> levelIndex;
+
+  vector<string> mapLevels;  // levels of the chunk that was last translated
+  vector<int> levelMap;      // result code of each level code of that chunk
+
+  // True if the chunk levels equal the strings in compareLevels
+  static bool EqualLevels(IStringColumn* chunkLevels, unsigned int nrOfLevels, const vector<string> &compareLevels,
+    bool prefix)
+  {
+    if (prefix ? nrOfLevels > compareLevels.size() : nrOfLevels != compareLevels.size()) return false;
+
+    for (unsigned int level = 0; level < nrOfLevels; ++level)
+    {
+      if (compareLevels[level] != chunkLevels->GetElement(level)) return false;
+    }
+
+    return true;
+  }
+
+public:
+  // Add the levels of a chunk and map the level codes of the rows read from that chunk on the result levels
+  void AddChunk(IStringColumn* chunkLevels, unsigned int nrOfLevels, int* levelData, unsigned long long length,
+    int nrOfThreads)
+  {
+    if (!levels.empty() && EqualLevels(chunkLevels, nrOfLevels, levels, true)) return;  // codes are unchanged
+
+    if (levelMap.empty() || !EqualLevels(chunkLevels, nrOfLevels, mapLevels, false))
+    {
+      mapLevels.resize(nrOfLevels);
+      levelMap.resize(nrOfLevels);
+      bool identityMap = true;
+
+      for (unsigned int level = 0; level < nrOfLevels; ++level)
+      {
+        mapLevels[level] = chunkLevels->GetElement(level);
+        unordered_map<string, int>::iterator it = levelIndex.find(mapLevels[level]);
+
+        if (it == levelIndex.end())
+        {
+          it = levelIndex.insert(make_pair(mapLevels[level], (int) levels.size())).first;
+          levels.push_back(mapLevels[level]);
+        }
+
+        levelMap[level] = it->second + 1;
+        identityMap = identityMap && (it->second == (int) level);
+      }
+
+      if (identityMap) return;
+    }
+
+    RemapLevelCodes(levelData, length, levelMap.data(), nrOfLevels, nrOfThreads);
+  }
+
+  void SetLevels(IFactorColumn* factorColumn)
+  {
+    IStringColumn* factorLevels = factorColumn->Levels();
+    factorLevels->AllocateVec((unsigned int) levels.size());
+    SetStringElements(factorLevels, levels);
+  }
+};
+
+
+// Read a factor column that is stored in multiple data chunks
+inline void ReadFactorChunks(const vector<istream*> &streams, IFactorColumn* factorColumn,
+  IColumnFactory* columnFactory, vector<ChunkSlice> &slices, int colNr, int nrOfThreads)
+{
+  FactorLevelMerger levelMerger;
+
+  for (ChunkSlice &slice : slices)
+  {
+    istream &myfile = *streams[slice.tableNr];
+    unsigned long long pos = slice.blockPos[colNr];
+
+    // Version and number of levels of the factor column
+    unsigned int factorMeta[2];
+    myfile.seekg(pos);
+    myfile.read((char*) factorMeta, 8);
+
+    unsigned int nrOfLevels = factorMeta[1];
+
+    int* levelData = &factorColumn->LevelData()[slice.vecOffset];
+    IStringColumn* chunkLevels = columnFactory->CreateStringColumn(nrOfLevels);
+    fdsReadFactorVec_v7(myfile, chunkLevels, levelData, pos, slice.firstRow, slice.length, slice.nrOfRows,
+      nrOfThreads);
+
+    levelMerger.AddChunk(chunkLevels, nrOfLevels, levelData, slice.length, nrOfThreads);
+    delete chunkLevels;
+  }
+
+  levelMerger.SetLevels(factorColumn);
+}
+
+
+/**
+ Hint the input about the byte ranges of the selected columns that will be read. The ranges of all chunk slices are
+ sorted by file offset and ranges separated by less than PREFETCH_MAX_GAP bytes are merged, so the input can fetch
+ the data with a few large sequential reads in the background while the first columns are decompressed. Factor
+ columns and character columns stored as level codes are read from their own small level section and are skipped.
+*/
+inline void PrefetchColumns(IFstInput &input, istream &myfile, const vector<ChunkSlice> &slices,
+  const vector<int> &colIndex, const unsigned short int* colTypes)
+{
+  if (!input.CanPrefetch()) return;
+
+  vector<pair<unsigned long long, unsigned long long>> ranges;
+
+  for (const ChunkSlice &slice : slices)
+  {
+    for (int colNr : colIndex)
+    {
+      unsigned long long rangeStart, rangeEnd;
+      bool hasRange;
+
+      switch (colTypes[colNr])
+      {
+        case 6:
+          hasRange = fdsCharColumnRange_v6(myfile, slice.blockPos[colNr], slice.firstRow, slice.length,
+            rangeStart, rangeEnd);
+          break;
+
+        case 8:
+        case 10:
+          hasRange = fdsColumnRange_v2(myfile, slice.blockPos[colNr], slice.firstRow, slice.length, 4,
+            rangeStart, rangeEnd);
+          break;
+
+        case 9:
+        case 11:
+        case 12:
+        case 13:
+          hasRange = fdsColumnRange_v2(myfile, slice.blockPos[colNr], slice.firstRow, slice.length, 8,
+            rangeStart, rangeEnd);
+          break;
+
+        default:
+          hasRange = false;
+      }
+
+      if (hasRange && rangeEnd > rangeStart) ranges.push_back(make_pair(rangeStart, rangeEnd));
+    }
+  }
+
+  myfile.clear();
+
+  if (ranges.empty()) return;
+
+  sort(ranges.begin(), ranges.end());
+
+  // (offset, size) of the merged ranges
+  vector<pair<unsigned long long, unsigned long long>> merged;
+  unsigned long long mergedStart = ranges[0].first;
+  unsigned long long mergedEnd = ranges[0].second;
+
+  for (size_t rangeNr = 1; rangeNr < ranges.size(); ++rangeNr)
+  {
+    if (ranges[rangeNr].first <= mergedEnd + PREFETCH_MAX_GAP)
+    {
+      mergedEnd = max(mergedEnd, ranges[rangeNr].second);
+      continue;
+    }
+
+    merged.push_back(make_pair(mergedStart, mergedEnd - mergedStart));
+    mergedStart = ranges[rangeNr].first;
+    mergedEnd = ranges[rangeNr].second;
+  }
+
+  merged.push_back(make_pair(mergedStart, mergedEnd - mergedStart));
+  input.PrefetchRanges(merged);
+}
+
+
+/**
+ Selections of colIndex in the order of their data in the file, with blockPos the column positions of a chunk.
+ Columns are decoded in this order instead of the order of the selection, so a read of columns listed out of file
+ order still walks the file forward and the column reads follow the merged prefetch ranges. Columns are stored in
+ the same order in every chunk and results are added to the table by selection number, keeping the order of the
+ selection in the result.
+*/
+inline vector<int> FileOrder(const int* colIndex, int nrOfSelect, const unsigned long long* blockPos)
+{
+  vector<int> order(nrOfSelect);
+  for (int colSel = 0; colSel < nrOfSelect; ++colSel) order[colSel] = colSel;
+
+  if (blockPos == nullptr) return order;
+
+  stable_sort(order.begin(), order.end(), [colIndex, blockPos](int colSel1, int colSel2)
+  {
+    return blockPos[colIndex[colSel1]] < blockPos[colIndex[colSel2]];
+  });
+
+  return order;
+}
+
+
+// Part of the column data of a slice that is read by a single task of a parallel read
+struct ReadTask
+{
+  int batchNr;                   // column in the batch of columns
+  int sliceNr;
+  unsigned long long firstRow;   // first row in the data chunk
+  unsigned long long length;
+  unsigned long long vecOffset;  // position of the first row in the result vector
+};
+
+
+/**
+ Decompress the selected integer, double, 64-bit integer and logical columns concurrently. The column data of each
+ slice is divided in tasks of about PARALLEL_READ_TASK bytes of decompressed data, aligned with the compression
+ blocks, which are distributed over the threads with a TaskQueue. Tasks of uniform size keep all threads busy when
+ the columns differ in length, and as each thread reads the compressed blocks of its task from its own stream on
+ the input of the slice, reading and decompressing of different tasks overlap. Column vectors are created and
+ added to the result table on the calling thread only, because the column factory may not be thread-safe. Columns
+ are processed in batches to limit the number of column vectors that are alive simultaneously.
+*/
+inline void ReadFixedColumnsParallel(const vector<IFstInput*> &inputs, const vector<istream*> &streams,
+  IFstTableReader &tableReader, IColumnFactory* columnFactory, const int* colIndex, int nrOfSelect,
+  vector<ChunkSlice> &slices, const unsigned short int* colTypes, unsigned long long length, int nrOfThreads,
+  unsigned long long cacheFileId)
+{
+  vector<int> fixedSel;
+
+  for (int colSel : FileOrder(colIndex, nrOfSelect, slices.empty() ? nullptr : slices[0].blockPos))
+  {
+    int colType = colTypes[colIndex[colSel]];
+    if (colType >= 8 && colType <= 13)
+    {
+      fixedSel.push_back(colSel);
+    }
+  }
+
+  int nrOfFixed = (int) fixedSel.size();
+
+  IIntegerColumn* intCols[PARALLEL_READ_BATCH];
+  IDoubleColumn* doubleCols[PARALLEL_READ_BATCH];
+  IInt64Column* int64Cols[PARALLEL_READ_BATCH];
+  ILogicalColumn* logicalCols[PARALLEL_READ_BATCH];
+
+  for (int batchStart = 0; batchStart < nrOfFixed; batchStart += PARALLEL_READ_BATCH)
+  {
+    int batchSize = min(PARALLEL_READ_BATCH, nrOfFixed - batchStart);
+
+    // Allocate result vectors on the calling thread. The vectors are not touched before the tasks decompress into them,
+    // so their pages are allocated on the NUMA node of the thread that decompresses the first task on the page.
+    for (int batchNr = 0; batchNr < batchSize; ++batchNr)
+    {
+      int colNr = colIndex[fixedSel[batchStart + batchNr]];
+      ProfileColumn profileColumn(fixedSel[batchStart + batchNr], ProfilePhase::TABLE);
+      intCols[batchNr] = nullptr;
+      doubleCols[batchNr] = nullptr;
+      int64Cols[batchNr] = nullptr;
+      logicalCols[batchNr] = nullptr;
+
+      switch (colTypes[colNr])
+      {
+        case 8:
+          intCols[batchNr] = columnFactory->CreateIntegerColumn(length, fixedSel[batchStart + batchNr]);
+          AdviseHugePages(intCols[batchNr]->Data(), 4 * length);
+          break;
+
+        case 9:
+        case 12:
+        case 13:
+          doubleCols[batchNr] = columnFactory->CreateDoubleColumn(length, fixedSel[batchStart + batchNr]);
+          AdviseHugePages(doubleCols[batchNr]->Data(), 8 * length);
+          break;
+
+        case 11:
+          int64Cols[batchNr] = columnFactory->CreateInt64Column(length, fixedSel[batchStart + batchNr]);
+          AdviseHugePages(int64Cols[batchNr]->Data(), 8 * length);
+          break;
+
+        default:
+          logicalCols[batchNr] = columnFactory->CreateLogicalColumn(length, fixedSel[batchStart + batchNr]);
+          AdviseHugePages(logicalCols[batchNr]->Data(), 4 * length);
+          break;
+      }
+    }
+
+    // Tasks of whole numbers of blocks, in order of slice, column (in file order) and row, so the tasks follow the
+    // column data through the file and each thread reads a contiguous part of a column
+    vector<ReadTask> tasks;
+
+    for (int sliceNr = 0; sliceNr < (int) slices.size(); ++sliceNr)
+    {
+      ChunkSlice &slice = slices[sliceNr];
+
+      for (int batchNr = 0; batchNr < batchSize; ++batchNr)
+      {
+        int colNr = colIndex[fixedSel[batchStart + batchNr]];
+        unsigned long long elementSize = colTypes[colNr] == 8 || colTypes[colNr] == 10 ? 4 : 8;
+        unsigned long long blockRows = fdsColumnBlockRows_v2(*streams[slice.tableNr], slice.blockPos[colNr]);
+        unsigned long long taskRows = max(1ULL, PARALLEL_READ_TASK / elementSize / blockRows) * blockRows;
+        unsigned long long endRow = slice.firstRow + slice.length;
+
+        for (unsigned long long row = slice.firstRow; row < endRow;)
+        {
+          unsigned long long taskEnd = min(endRow, (row / taskRows + 1) * taskRows);
+          tasks.push_back({ batchNr, sliceNr, row, taskEnd - row, slice.vecOffset + row - slice.firstRow });
+          row = taskEnd;
+        }
+      }
+    }
+
+    for (istream* stream : streams) stream->clear();
+
+    bool readError = false;
+    string errorMessage;
+    FstProfile* profile = ProfileScope::Active();
+    int nrOfTaskThreads = (int) min((size_t) nrOfThreads, tasks.size());
+    TaskQueue taskQueue((int) tasks.size(), nrOfTaskThreads);
+
+#pragma omp parallel num_threads(nrOfTaskThreads)
+    {
+      // Stream of this thread on the input of the current slice. Slices are ordered by input, so streams are
+      // rarely reopened and each thread keeps a single file open.
+      istream* colStream = nullptr;
+      unsigned int streamTableNr = 0;
+      BlockCacheScope cacheScope(cacheFileId);
+      ProfileScope profileScope(profile);
+      int threadNr = omp_get_thread_num();
+
+      for (int taskNr = taskQueue.Next(threadNr); taskNr != -1; taskNr = taskQueue.Next(threadNr))
+      {
+        ReadTask &task = tasks[taskNr];
+        int batchNr = task.batchNr;
+        ChunkSlice &slice = slices[task.sliceNr];
+
+        if (colStream == nullptr || streamTableNr != slice.tableNr)
+        {
+          delete colStream;
+          colStream = inputs[slice.tableNr]->OpenStream();
+          streamTableNr = slice.tableNr;
+        }
+
+        if (colStream == nullptr)
+        {
+#pragma omp critical
+          {
+            readError = true;
+            errorMessage = "There was an error opening the fst file, please check for a correct path.";
+          }
+          continue;
+        }
+
+        int colNr = colIndex[fixedSel[batchStart + batchNr]];
+        unsigned long long pos = slice.blockPos[colNr];
+        istream &colFile = *colStream;
+        ProfileColumn profileColumn(fixedSel[batchStart + batchNr], ProfilePhase::CODEC);
+
+        try
+        {
+          if (intCols[batchNr] != nullptr)
+          {
+            fdsReadIntVec_v8(colFile, &intCols[batchNr]->Data()[task.vecOffset], pos, task.firstRow, task.length,
+              slice.nrOfRows, 1);
+          }
+          else if (doubleCols[batchNr] != nullptr)
+          {
+            fdsReadRealVec_v9(colFile, &doubleCols[batchNr]->Data()[task.vecOffset], pos, task.firstRow,
+              task.length, slice.nrOfRows, 1);
+          }
+          else if (int64Cols[batchNr] != nullptr)
+          {
+            fdsReadInt64Vec_v11(colFile, &int64Cols[batchNr]->Data()[task.vecOffset], pos, task.firstRow,
+              task.length, slice.nrOfRows, 1);
+          }
+          else
+          {
+            fdsReadLogicalVec_v10(colFile, &logicalCols[batchNr]->Data()[task.vecOffset], pos, task.firstRow,
+              task.length, slice.nrOfRows, 1);
+          }
+        }
+        catch (const std::exception &e)
+        {
+#pragma omp critical
+          {
+            readError = true;
+            errorMessage = e.what();
+          }
+        }
+      }
+
+      delete colStream;
+    }
+
+    // Add all columns of the batch to the result table before releasing any of them
+    for (int batchNr = 0; batchNr < batchSize; ++batchNr)
+    {
+      int colSel = fixedSel[batchStart + batchNr];
+      ProfileColumn profileColumn(colSel, ProfilePhase::TABLE);
+
+      if (intCols[batchNr] != nullptr) tableReader.AddIntegerColumn(intCols[batchNr], colSel);
+      else if (doubleCols[batchNr] != nullptr)
+      {
+        tableReader.AddDoubleColumn(doubleCols[batchNr], colSel, StoredColumnType(colTypes[colIndex[colSel]]));
+      }
+      else if (int64Cols[batchNr] != nullptr) tableReader.AddInt64Column(int64Cols[batchNr], colSel);
+      else tableReader.AddLogicalColumn(logicalCols[batchNr], colSel);
+    }
+
+    for (int batchNr = batchSize - 1; batchNr >= 0; --batchNr)
+    {
+      delete intCols[batchNr];
+      delete doubleCols[batchNr];
+      delete int64Cols[batchNr];
+      delete logicalCols[batchNr];
+    }
+
+    if (readError)
+    {
+      throw(runtime_error(errorMessage));
+    }
+  }
+}
+
+
+
+// Selected rows that are read as a single range of rows of a data chunk
+struct RowGroup
+{
+  unsigned int chunkNr;
+  unsigned long long firstRow;  // first row of the range, relative to the chunk
+  unsigned long long length;    // number of rows in the range
+  unsigned long long firstSel;  // position of the first selected row of the group in the result vectors
+  unsigned long long nrOfSel;   // number of selected rows in the group
+};
+
+
+// Copies the selected elements of the character blocks of a row range to the result vector. Consecutive
+// selected rows are copied with a single call to the result column.
+class GatherStringColumn : public IStringColumn
+{
+  IStringColumn* stringColumn;
+  const unsigned int* selRows;      // selected rows relative to the first row of the range
+  unsigned long long nrOfSel;
+  unsigned long long resultOffset;  // position of the first selected row in the result vector
+  unsigned long long selNr;         // next selected row to copy
+
+public:
+  GatherStringColumn(IStringColumn* stringColumn, const unsigned int* selRows, unsigned long long nrOfSel,
+    unsigned long long resultOffset)
+  {
+    this->stringColumn = stringColumn;
+    this->selRows      = selRows;
+    this->nrOfSel      = nrOfSel;
+    this->resultOffset = resultOffset;
+    selNr              = 0;
+  }
+
+  // The result vector is allocated by the caller
+  void AllocateVec(unsigned long long vecLength) {}
+
+  void BufferToVec(unsigned int nrOfElements, unsigned int startElem, unsigned int endElem,
+    unsigned long long vecOffset, unsigned int* sizeMeta, char* buf)
+  {
+    unsigned long long lastRow = vecOffset + endElem - startElem;  // last row of the range in this block
+
+    while (selNr < nrOfSel && selRows[selNr] <= lastRow)
+    {
+      unsigned long long runStart = selNr;
+
+      while (selNr + 1 < nrOfSel && selRows[selNr + 1] == selRows[selNr] + 1 && selRows[selNr + 1] <= lastRow)
+      {
+        ++selNr;
+      }
+
+      unsigned int firstElem = startElem + (unsigned int) (selRows[runStart] - vecOffset);
+      unsigned int lastElem  = startElem + (unsigned int) (selRows[selNr] - vecOffset);
+      stringColumn->BufferToVec(nrOfElements, firstElem, lastElem, resultOffset + runStart, sizeMeta, buf);
+
+      ++selNr;
+    }
+  }
+
+  const char* GetElement(int elementNr) { return stringColumn->GetElement((int) resultOffset + elementNr); }
+};
+
+
+// Copy the selected rows of a decompressed row range to the result vector
+template<typename T>
+inline void GatherRows(T* result, const T* rangeData, const unsigned int* selRows, unsigned long long nrOfSel)
+{
+  for (unsigned long long sel = 0; sel < nrOfSel; ++sel)
+  {
+    result[sel] = rangeData[selRows[sel]];
+  }
+}
+
+
+FstHandle::FstHandle(IFstInput &input, IColumnFactory* columnFactory) : input(input)
+{
+  this->columnFactory = columnFactory;
+
+  inputStream = nullptr;
+  colNames    = nullptr;
+  nrOfCols    = 0;
+  keyLength   = 0;
+  nrOfRows    = 0;
+
+  nrOfStoredCols = 0;
+  verifyOnRead = false;
+  cacheFileId  = 0;
+
+  fileIdentityRead = false;
+  hasFileIdentity = false;
+}
+
+
+FstHandle::~FstHandle()
+{
+  SetBlockCache(false);
+
+  delete colNames;
+  delete inputStream;
+}
+
+
+bool FstHandle::Open()
+{
+  inputStream = input.OpenStream();
+
+  if (inputStream == nullptr)
+  {
+    throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+  }
+
+  istream &myfile = *inputStream;
+
+  unsigned int tableClassType;
+  int nrOfColsFirstChunk;
+  unsigned int version = ReadHeader(myfile, tableClassType, keyLength, nrOfColsFirstChunk);
+
+  // We may be looking at a fst v0.7.2 file format
+  if (version == 0)
+  {
+    return false;
+  }
+
+
+  // Continue reading table metadata
+  int metaSize = 32 + 4 * keyLength + 6 * nrOfColsFirstChunk;
+  vector<char> metaDataBlock(metaSize);
+  myfile.read(metaDataBlock.data(), metaSize);
+
+  if (!myfile)
+  {
+    throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+  }
+
+  unsigned int tmpOffset = 4 * keyLength;
+
+  int* p_keyColPos                       = (int*) metaDataBlock.data();
+  unsigned long long* p_nextHorzChunkSet = (unsigned long long*) &metaDataBlock[tmpOffset];
+  unsigned long long* p_nextVertChunkSet = (unsigned long long*) &metaDataBlock[tmpOffset + 8];
+  int* p_nrOfCols                        = (int*) &metaDataBlock[tmpOffset + 28];
+  unsigned short int* p_colAttrTypes     = (unsigned short int*) &metaDataBlock[tmpOffset + 32];
+  unsigned short int* p_colTypes         = (unsigned short int*) &metaDataBlock[tmpOffset + 32 + 2 * nrOfColsFirstChunk];
+
+  nrOfStoredCols = *p_nrOfCols;
+  keyLength = ValidKeyLength(p_keyColPos, keyLength);  // appended rows can invalidate the trailing key columns
+  keyColPos.assign(p_keyColPos, p_keyColPos + keyLength);
+  storedColTypes.assign(p_colTypes, p_colTypes + nrOfStoredCols);
+  storedAttributeTypes.assign(p_colAttrTypes, p_colAttrTypes + nrOfStoredCols);
+
+  // The columns of appended horizontal chunksets follow the columns of the first chunkset
+  vector<HorzChunkSet> chunkSets;
+  ReadHorzChunkSets(myfile, *p_nextHorzChunkSet, chunkSets);
+
+  chunkSetFirstCols.push_back(0);
+  chunkSetHeaderPos.push_back(TABLE_META_SIZE + tmpOffset);
+
+  for (const HorzChunkSet &chunkSet : chunkSets)
+  {
+    chunkSetFirstCols.push_back(nrOfStoredCols);
+    chunkSetHeaderPos.push_back(chunkSet.pos);
+    storedColTypes.insert(storedColTypes.end(), chunkSet.colTypes.begin(), chunkSet.colTypes.end());
+    storedAttributeTypes.insert(storedAttributeTypes.end(), chunkSet.colAttributeTypes.begin(),
+      chunkSet.colAttributeTypes.end());
+    nrOfStoredCols += chunkSet.nrOfCols;
+  }
+
+  chunkSetFirstCols.push_back(nrOfStoredCols);
+  int nrOfColsFirstChunkSet = chunkSetFirstCols[1];
+
+
+  // Read column names
+  colNames = columnFactory->CreateStringColumn(nrOfStoredCols);
+  colNames->AllocateVec(nrOfStoredCols);
+  fdsReadCharVecAt_v6(myfile, colNames, TABLE_META_SIZE + metaSize, 0, (unsigned int) nrOfColsFirstChunkSet,
+    (unsigned int) nrOfColsFirstChunkSet, 0);
+
+  // The attribute section follows the column names in the append-only layout and the first chunkset index
+  // otherwise
+  chunkSetAttributePos.push_back((unsigned long long) myfile.tellg() +
+    (version == FST_VERSION_STREAM ? 0 : CHUNK_INDEX_SIZE));
+
+
+  // The append-only layout stores the chunkset index in a trailer, located by the footer
+  if (version == FST_VERSION_STREAM)
+  {
+    unsigned long long footer[2];
+    myfile.seekg(-FOOTER_SIZE, ios_base::end);
+    myfile.read((char*) footer, FOOTER_SIZE);
+
+    if (!myfile || footer[1] != FST_FILE_ID)
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+
+    myfile.seekg(footer[0]);
+  }
+
+  // Position data location and size of all data chunks
+  chunkSetPositions.resize(chunkSets.size() + 1);
+  ReadChunkIndex(myfile, *p_nextVertChunkSet, chunkSetPositions[0], chunkRowCounts);
+
+  // Appended chunksets store the column names and chunkset index of their columns in the same way
+  for (unsigned int setNr = 1; setNr <= chunkSets.size(); ++setNr)
+  {
+    const HorzChunkSet &chunkSet = chunkSets[setNr - 1];
+
+    fdsReadCharVecAt_v6(myfile, colNames, chunkSet.pos + 32 + 6 * chunkSet.nrOfCols, 0,
+      (unsigned int) chunkSet.nrOfCols, (unsigned int) chunkSet.nrOfCols, chunkSetFirstCols[setNr]);
+
+    chunkSetAttributePos.push_back((unsigned long long) myfile.tellg() + CHUNK_INDEX_SIZE);
+
+    vector<unsigned long long> setRowCounts;
+    ReadChunkIndex(myfile, chunkSet.nextVertChunkSet, chunkSetPositions[setNr], setRowCounts);
+
+    if (setRowCounts != chunkRowCounts)
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+  }
+
+  // Replaced and deleted columns are hidden
+  VisibleColumns(colNames, storedAttributeTypes.data(), chunkSetFirstCols, storedCols);
+
+  nrOfCols = (int) storedCols.size();
+  bool allVisible = nrOfCols == nrOfStoredCols;
+
+  for (int colNr = 0; allVisible && colNr < nrOfCols; ++colNr)
+  {
+    allVisible = storedCols[colNr] == colNr;
+  }
+
+  if (allVisible)
+  {
+    storedCols.clear();
+    colTypes = storedColTypes;
+    colAttributeTypes = storedAttributeTypes;
+  }
+  else
+  {
+    if (nrOfCols == 0)
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+
+    IStringColumn* storedNames = colNames;
+    colNames = SelectStrings(columnFactory, storedNames, storedCols);
+    delete storedNames;
+
+    for (int storedCol : storedCols)
+    {
+      colTypes.push_back(storedColTypes[storedCol]);
+      colAttributeTypes.push_back(storedAttributeTypes[storedCol]);
+    }
+
+    // Key columns can't be replaced or deleted, but columns in front of them can be deleted
+    for (int keyNr = 0; keyNr < keyLength; ++keyNr)
+    {
+      vector<int>::iterator keyCol = find(storedCols.begin(), storedCols.end(), keyColPos[keyNr]);
+
+      if (keyCol == storedCols.end())
+      {
+        keyLength = keyNr;
+        keyColPos.resize(keyLength);
+        break;
+      }
+
+      keyColPos[keyNr] = (int) (keyCol - storedCols.begin());
+    }
+  }
+
+  for (unsigned long long chunkNrOfRows : chunkRowCounts)
+  {
+    chunkFirstRows.push_back(nrOfRows);
+    nrOfRows += chunkNrOfRows;
+  }
+
+  positionData.resize(chunkRowCounts.size() * nrOfCols);
+  positionDataRead.assign(chunkRowCounts.size(), false);
+  columnVerified.assign(chunkRowCounts.size() * nrOfCols, false);
+
+
+  // Hash index for column selections
+  colNameIndex.Reserve(nrOfCols);
+
+  for (int colNr = 0; colNr < nrOfCols; ++colNr)
+  {
+    colNameIndex.Add(colNames->GetElement(colNr), colNr);
+  }
+
+  return true;
+}
+
+
+void FstHandle::SelectColumns(IStringArray* columnSelection, vector<int> &colIndex)
+{
+  colIndex.clear();
+
+  if (columnSelection == nullptr)
+  {
+    for (int colNr = 0; colNr < nrOfCols; ++colNr)
+    {
+      colIndex.push_back(colNr);
+    }
+  }
+  else  // determine column numbers of column names
+  {
+    int nrOfSelect = columnSelection->Length();
+
+    for (int colSel = 0; colSel < nrOfSelect; ++colSel)
+    {
+      int colNr = colNameIndex.Find(columnSelection->GetElement(colSel));
+
+      if (colNr == -1)
+      {
+        throw(runtime_error("Selected column not found."));
+      }
+
+      colIndex.push_back(colNr);
+    }
+  }
+
+  // Validate the column types before any result vector is allocated
+  for (int colNr : colIndex)
+  {
+    int colType = colTypes[colNr];
+
+    if (colType < 6 || colType > 13)
+    {
+      throw(runtime_error("Unknown type found in column."));
+    }
+  }
+}
+
+
+unsigned long long* FstHandle::ChunkPositionData(unsigned int chunkNr)
+{
+  unsigned long long* chunkPositionData = &positionData[(unsigned long long) chunkNr * nrOfCols];
+
+  if (!positionDataRead[chunkNr])
+  {
+    // The positions of the stored columns are collected when columns are hidden
+    vector<unsigned long long> storedPositionData(storedCols.empty() ? 0 : nrOfStoredCols);
+    unsigned long long* storedPositions = storedCols.empty() ? chunkPositionData : storedPositionData.data();
+
+    // Each horizontal chunkset stores the file positions of its own columns
+    for (unsigned int setNr = 0; setNr < chunkSetPositions.size(); ++setNr)
+    {
+      int firstCol = chunkSetFirstCols[setNr];
+
+      inputStream->seekg(chunkSetPositions[setNr][chunkNr]);
+      inputStream->read((char*) &storedPositions[firstCol], (chunkSetFirstCols[setNr + 1] - firstCol) * 8);
+    }
+
+    if (!*inputStream)
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+
+    for (unsigned int colNr = 0; colNr < storedCols.size(); ++colNr)
+    {
+      chunkPositionData[colNr] = storedPositions[storedCols[colNr]];
+    }
+
+    positionDataRead[chunkNr] = true;
+  }
+
+  return chunkPositionData;
+}
+
+
+bool FstHandle::ReadZoneMap(unsigned int chunkNr, int colNr, ZoneMap &zoneMap, bool metaOnly)
+{
+  if ((colAttributeTypes[colNr] & COL_ATTR_ZONE_MAP) == 0)
+  {
+    return false;
+  }
+
+  unsigned long long colPos = ChunkPositionData(chunkNr)[colNr];
+
+  inputStream->clear();  // reset state from a previous read at the end of the file
+
+  FstColumnType colType = StoredColumnType(colTypes[colNr]);
+
+  if (metaOnly)
+  {
+    return zoneMap.ReadMeta(*inputStream, colPos, colType, chunkRowCounts[chunkNr]);
+  }
+
+  return zoneMap.Read(*inputStream, colPos, colType, chunkRowCounts[chunkNr]);
+}
+
+
+bool FstHandle::ReadBloomFilter(unsigned int chunkNr, int colNr, const ZoneMap &zoneMap, BloomFilter &bloomFilter)
+{
+  if ((colAttributeTypes[colNr] & COL_ATTR_BLOOM) == 0 || !HasChecksums(colNr))
+  {
+    return false;
+  }
+
+  // The filters are stored in front of the checksum metadata, which precedes the zone map
+  unsigned long long colPos = ChunkPositionData(chunkNr)[colNr];
+  unsigned long long metaSize = zoneMap.StoredSize() + CHECKSUM_META_SIZE;
+
+  if (colPos < metaSize)
+  {
+    return false;
+  }
+
+  inputStream->clear();  // reset state from a previous read at the end of the file
+
+  return bloomFilter.Read(*inputStream, colPos - metaSize, StoredColumnType(colTypes[colNr]), zoneMap.NrOfBlocks());
+}
+
+
+bool FstHandle::SameColumns(FstHandle &table)
+{
+  bool identical = table.nrOfCols == nrOfCols;
+
+  for (int colNr = 0; identical && colNr < nrOfCols; ++colNr)
+  {
+    identical = table.colTypes[colNr] == colTypes[colNr] &&
+      strcmp(table.colNames->GetElement(colNr), colNames->GetElement(colNr)) == 0;
+  }
+
+  return identical;
+}
+
+
+bool FstHandle::HasChecksums(int colNr)
+{
+  return (colAttributeTypes[colNr] & COL_ATTR_CHECKSUM) != 0;
+}
+
+
+bool FstHandle::ReadChecksum(unsigned int chunkNr, int colNr, ColumnChecksum &checksum)
+{
+  if (!HasChecksums(colNr))
+  {
+    return false;
+  }
+
+  // The checksum metadata is stored in front of the zone map
+  ZoneMap zoneMap;
+  if (!ReadZoneMap(chunkNr, colNr, zoneMap, true))
+  {
+    return false;
+  }
+
+  unsigned long long colPos = ChunkPositionData(chunkNr)[colNr];
+
+  return checksum.Read(*inputStream, colPos - zoneMap.StoredSize(), colPos);
+}
+
+
+bool FstHandle::VerifyColumn(unsigned int chunkNr, int colNr)
+{
+  ColumnChecksum checksum;
+
+  if (!ReadChecksum(chunkNr, colNr, checksum))
+  {
+    return false;
+  }
+
+  return checksum.Verify(*inputStream, ChunkPositionData(chunkNr)[colNr]) == 0;
+}
+
+
+void FstHandle::SetBlockCache(bool enable)
+{
+  if (enable == (cacheFileId != 0)) return;
+
+  if (enable)
+  {
+    cacheFileId = BlockCache::Global().NewFile();
+    return;
+  }
+
+  BlockCache::Global().ReleaseFile(cacheFileId);
+  cacheFileId = 0;
+}
+
+
+unsigned long long FstHandle::CacheFile()
+{
+  SharedBlockCache &sharedCache = SharedBlockCache::Global();
+
+  if (!sharedCache.Enabled()) return cacheFileId;
+
+  if (!fileIdentityRead)
+  {
+    hasFileIdentity = input.FileIdentity(fileIdentity);
+    fileIdentityRead = true;
+  }
+
+  unsigned long long fileNr = hasFileIdentity ? sharedCache.FileNr(fileIdentity) : 0;
+
+  return fileNr == 0 ? cacheFileId : (fileNr | SHARED_CACHE_FILE);
+}
+
+
+void FstHandle::ReadAllMetadata()
+{
+  for (unsigned int chunkNr = 0; chunkNr < chunkRowCounts.size(); ++chunkNr)
+  {
+    ChunkPositionData(chunkNr);
+  }
+
+  inputStream->clear();  // reset state from a previous read at the end of the file
+  ReadAttributeOffsets(*inputStream);
+
+  if (!fileIdentityRead)
+  {
+    hasFileIdentity = input.FileIdentity(fileIdentity);
+    fileIdentityRead = true;
+  }
+}
+
+
+void FstHandle::VerifyChunkColumns(unsigned int chunkNr, const vector<int> &colIndex)
+{
+  for (int colNr : colIndex)
+  {
+    unsigned long long verifiedIndex = (unsigned long long) chunkNr * nrOfCols + colNr;
+
+    if (columnVerified[verifiedIndex] || !HasChecksums(colNr)) continue;
+
+    if (!VerifyColumn(chunkNr, colNr))
+    {
+      throw(runtime_error("Checksum mismatch in column '" + string(colNames->GetElement(colNr)) +
+        "', the fst file is damaged."));
+    }
+
+    columnVerified[verifiedIndex] = true;
+  }
+
+  inputStream->clear();
+}
+
+
+bool FstHandle::ColumnStatistics(int colNr, ZoneMapEntry &summary)
+{
+  memset(&summary, 0, ZONE_MAP_ENTRY_SIZE);
+
+  ZoneMap zoneMap;
+
+  for (unsigned int chunkNr = 0; chunkNr < chunkRowCounts.size(); ++chunkNr)
+  {
+    if (!ReadZoneMap(chunkNr, colNr, zoneMap))
+    {
+      return false;
+    }
+
+    zoneMap.Merge(summary);
+  }
+
+  return true;
+}
+
+
+void FstHandle::ReadColumnStorage(int colNr, ColumnStorage &storage)
+{
+  storage = ColumnStorage();
+
+  istream &myfile = *inputStream;
+
+  for (unsigned int chunkNr = 0; chunkNr < chunkRowCounts.size(); ++chunkNr)
+  {
+    unsigned long long nrOfRows = chunkRowCounts[chunkNr];
+    unsigned long long colPos = ChunkPositionData(chunkNr)[colNr];
+
+    if (nrOfRows == 0) continue;
+
+    myfile.clear();  // reset state from a previous read at the end of the file
+
+    switch (colTypes[colNr])
+    {
+      case 6:
+        fdsCharColumnStorage_v6(myfile, colPos, nrOfRows, storage);
+        break;
+
+      case 7:
+        fdsFactorColumnStorage_v7(myfile, colPos, nrOfRows, storage);
+        break;
+
+      case 8:
+      case 10:
+        fdsColumnStorage_v2(myfile, colPos, nrOfRows, 4, storage);
+        break;
+
+      case 9:
+      case 11:
+      case 12:
+      case 13:
+        fdsColumnStorage_v2(myfile, colPos, nrOfRows, 8, storage);
+        break;
+
+      default:
+        throw(runtime_error("Unknown type found in column."));
+    }
+  }
+
+  myfile.clear();
+}
+
+
+unsigned long long FstHandle::DeadBytes()
+{
+  if (storedCols.empty() && nrOfCols == nrOfStoredCols) return 0;
+
+  vector<bool> visible(nrOfStoredCols, storedCols.empty());
+  for (int storedCol : storedCols) visible[storedCol] = true;
+
+  istream &myfile = *inputStream;
+  unsigned long long deadBytes = 0;
+
+  for (unsigned int setNr = 0; setNr < chunkSetPositions.size(); ++setNr)
+  {
+    for (int storedCol = chunkSetFirstCols[setNr]; storedCol < chunkSetFirstCols[setNr + 1]; ++storedCol)
+    {
+      unsigned short int attributeType = storedAttributeTypes[storedCol];
+
+      if (visible[storedCol] || (attributeType & COL_ATTR_CHECKSUM) == 0 || (attributeType & COL_ATTR_ZONE_MAP) == 0)
+      {
+        continue;
+      }
+
+      FstColumnType colType = StoredColumnType(storedColTypes[storedCol]);
+
+      for (unsigned int chunkNr = 0; chunkNr < chunkRowCounts.size(); ++chunkNr)
+      {
+        unsigned long long colPos;
+
+        myfile.clear();  // reset state from a previous read at the end of the file
+        myfile.seekg(chunkSetPositions[setNr][chunkNr] + 8 * (storedCol - chunkSetFirstCols[setNr]));
+        myfile.read((char*) &colPos, 8);
+
+        ZoneMap zoneMap;
+        ColumnChecksum checksum;
+
+        if (!myfile || !zoneMap.ReadMeta(myfile, colPos, colType, chunkRowCounts[chunkNr]) ||
+          !checksum.Read(myfile, colPos - zoneMap.StoredSize(), colPos))
+        {
+          throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+        }
+
+        // Bloom filters, checksum metadata, zone map, column data and block checksums (see WriteColumn)
+        deadBytes += CHECKSUM_META_SIZE + zoneMap.StoredSize() + checksum.DataSize() +
+          CHECKSUM_ENTRY_SIZE * checksum.NrOfBlocks();
+
+        if ((attributeType & COL_ATTR_BLOOM) != 0)
+        {
+          BloomFilter bloomFilter;
+
+          if (bloomFilter.Read(myfile, colPos - zoneMap.StoredSize() - CHECKSUM_META_SIZE, colType,
+            zoneMap.NrOfBlocks()))
+          {
+            deadBytes += bloomFilter.StoredSize();
+          }
+        }
+      }
+    }
+  }
+
+  myfile.clear();
+
+  return deadBytes;
+}
+
+
+unsigned long long FstHandle::AttributeTypePos(int colNr)
+{
+  int storedCol = storedCols.empty() ? colNr : storedCols[colNr];
+  unsigned int setNr = (unsigned int) (upper_bound(chunkSetFirstCols.begin(), chunkSetFirstCols.end(), storedCol) -
+    chunkSetFirstCols.begin()) - 1;
+
+  return chunkSetHeaderPos[setNr] + 32 + 2 * (storedCol - chunkSetFirstCols[setNr]);
+}
+
+
+void FstHandle::ReadAttributeOffsets(istream &myfile)
+{
+  if (!attributeOffsets.empty()) return;
+
+  attributeOffsets.assign(nrOfStoredCols, 0);
+  attributeSizes.assign(nrOfStoredCols, 0);
+
+  // The chunksets with column attributes have an attribute section for their columns
+  for (unsigned int setNr = 0; setNr + 1 < chunkSetFirstCols.size(); ++setNr)
+  {
+    int firstCol = chunkSetFirstCols[setNr];
+    int endCol = chunkSetFirstCols[setNr + 1];
+    bool hasAttributes = false;
+
+    for (int col = firstCol; col < endCol; ++col)
+    {
+      if ((storedAttributeTypes[col] & COL_ATTR_ATTRIBUTES) != 0) hasAttributes = true;
+    }
+
+    if (!hasAttributes) continue;
+
+    unsigned long long attributeId = 0;
+
+    myfile.seekg(chunkSetAttributePos[setNr]);
+    myfile.read((char*) &attributeId, 8);
+    myfile.read((char*) &attributeSizes[firstCol], 4 * (endCol - firstCol));
+
+    if (!myfile || attributeId != ATTRIBUTE_ID)
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+
+    unsigned long long offset = chunkSetAttributePos[setNr] + 8 + 4 * (endCol - firstCol);
+
+    for (int col = firstCol; col < endCol; ++col)
+    {
+      attributeOffsets[col] = offset;
+      offset += attributeSizes[col];
+    }
+  }
+}
+
+
+void FstHandle::ReadAttributeData(int colNr, vector<char> &attributeData)
+{
+  inputStream->clear();  // reset state from a previous read at the end of the file
+
+  ReadAttributeData(*inputStream, colNr, attributeData);
+}
+
+
+void FstHandle::ReadAttributeData(istream &myfile, int colNr, vector<char> &attributeData)
+{
+  attributeData.clear();
+
+  if ((colAttributeTypes[colNr] & COL_ATTR_ATTRIBUTES) == 0) return;
+
+  ReadAttributeOffsets(myfile);
+
+  int storedCol = storedCols.empty() ? colNr : storedCols[colNr];
+  attributeData.resize(attributeSizes[storedCol]);
+
+  if (attributeData.empty()) return;
+
+  myfile.seekg(attributeOffsets[storedCol]);
+  myfile.read(attributeData.data(), attributeData.size());
+
+  if (!myfile)
+  {
+    throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+  }
+}
+
+
+void FstHandle::ReadColumnAttributes(IFstTableReader &tableReader, const vector<int> &colIndex, istream &stream)
+{
+  vector<char> attributeData;
+
+  for (int colSel = 0; colSel < (int) colIndex.size(); ++colSel)
+  {
+    ReadAttributeData(stream, colIndex[colSel], attributeData);
+
+    if (attributeData.empty()) continue;
+
+    tableReader.SetColumnAttributes(colSel, attributeData.data(), (unsigned int) attributeData.size());
+  }
+}
+
+
+void FstHandle::ChunkSlices(unsigned long long firstRow, unsigned long long length, unsigned long long vecOffset,
+  unsigned int tableNr, vector<ChunkSlice> &slices)
+{
+  // Only the data chunks that overlap with the selected rows are read, starting with the chunk that holds firstRow
+  unsigned int chunkNr = (unsigned int) (upper_bound(chunkFirstRows.begin(), chunkFirstRows.end(), firstRow) -
+    chunkFirstRows.begin()) - 1;
+
+  for (; chunkNr < chunkRowCounts.size() && chunkFirstRows[chunkNr] < firstRow + length; ++chunkNr)
+  {
+    unsigned long long chunkStart = chunkFirstRows[chunkNr];
+    unsigned long long chunkEnd = chunkStart + chunkRowCounts[chunkNr];
+
+    ChunkSlice slice;
+    slice.tableNr   = tableNr;
+    slice.chunkNr   = chunkNr;
+    slice.firstRow  = max(chunkStart, firstRow) - chunkStart;
+    slice.length    = min(chunkEnd, firstRow + length) - chunkStart - slice.firstRow;
+    slice.nrOfRows  = chunkRowCounts[chunkNr];
+    slice.vecOffset = vecOffset + chunkStart + slice.firstRow - firstRow;
+    slice.blockPos  = ChunkPositionData(chunkNr);
+    slices.push_back(slice);
+  }
+}
+
+
+unsigned long long FstHandle::ReadRows(IFstTableReader &tableReader, const vector<int> &colIndex,
+  unsigned long long firstRow, unsigned long long length, int nrOfThreads)
+{
+  if (inputStream == nullptr)
+  {
+    throw(runtime_error("Row selection is out of range."));
+  }
+
+  inputStream->clear();  // reset state from a previous read at the end of the file
+
+  return ReadRows(tableReader, columnFactory, *inputStream, colIndex, firstRow, length, nrOfThreads);
+}
+
+
+unsigned long long FstHandle::ReadRows(IFstTableReader &tableReader, IColumnFactory* columnFactory, istream &stream,
+  const vector<int> &colIndex, unsigned long long firstRow, unsigned long long length, int nrOfThreads)
+{
+  if (firstRow >= nrOfRows)
+  {
+    throw(runtime_error("Row selection is out of range."));
+  }
+
+  length = min(length, nrOfRows - firstRow);
+
+  vector<ChunkSlice> slices;
+  ChunkSlices(firstRow, length, 0, 0, slices);
+
+  if (verifyOnRead)
+  {
+    for (ChunkSlice &slice : slices) VerifyChunkColumns(slice.chunkNr, colIndex);
+  }
+
+  vector<IFstInput*> inputs(1, &input);
+  vector<istream*> streams(1, &stream);
+
+  ReadSlices(tableReader, columnFactory, colIndex, inputs, streams, slices, length, nrOfThreads, CacheFile());
+
+  return length;
+}
+
+
+void FstHandle::ReadSlices(IFstTableReader &tableReader, IColumnFactory* columnFactory, const vector<int> &colIndex,
+  const vector<IFstInput*> &inputs, const vector<istream*> &streams, vector<ChunkSlice> &slices,
+  unsigned long long length, int nrOfThreads, unsigned long long blockCacheId)
+{
+  BlockCacheScope cacheScope(blockCacheId);
+
+  int nrOfSelect = (int) colIndex.size();
+
+  int nrOfFixedCols = 0;
+  for (int colNr : colIndex)
+  {
+    if (colTypes[colNr] >= 8) ++nrOfFixedCols;
+  }
+
+  tableReader.InitTable(nrOfSelect, length);
+
+  // Prefetch hints for the slices of each input
+  bool concurrentStreams = true;
+  for (unsigned int tableNr = 0; tableNr < inputs.size(); ++tableNr)
+  {
+    concurrentStreams = concurrentStreams && inputs[tableNr]->ConcurrentStreams();
+
+    vector<ChunkSlice> tableSlices;
+    for (ChunkSlice &slice : slices)
+    {
+      if (slice.tableNr == tableNr) tableSlices.push_back(slice);
+    }
+
+    PrefetchColumns(*inputs[tableNr], *streams[tableNr], tableSlices, colIndex, colTypes.data());
+  }
+
+  // Integer, double, 64-bit integer and logical columns are decompressed in parallel tasks, each thread using its own
+  // file stream. Small reads (less column data than a single task per thread) and inputs without concurrent streams
+  // decompress the blocks of each column in parallel instead.
+  bool fixedColsRead = false;
+  if (nrOfThreads > 1 && concurrentStreams && (nrOfFixedCols * (int) slices.size() >= nrOfThreads ||
+    8 * length * nrOfFixedCols >= (unsigned long long) nrOfThreads * PARALLEL_READ_TASK))
+  {
+    ReadFixedColumnsParallel(inputs, streams, tableReader, columnFactory, colIndex.data(), nrOfSelect, slices,
+      colTypes.data(), length, nrOfThreads, blockCacheId);
+
+    fixedColsRead = true;
+  }
+
+  // Columns are decoded in file order and added to the table at their selected position
+  for (int colSel : FileOrder(colIndex.data(), nrOfSelect, slices.empty() ? nullptr : slices[0].blockPos))
+  {
+    int colNr = colIndex[colSel];
+    ProfileColumn profileColumn(colSel, ProfilePhase::TABLE);
+
+    switch (colTypes[colNr])
+    {
+    // Character vector
+      case 6:
+      {
+        IStringColumn* stringColumn = columnFactory->CreateStringColumn(length, colSel);
+        stringColumn->AllocateVec(length);
+
+        for (ChunkSlice &slice : slices)
+        {
+          istream &myfile = *streams[slice.tableNr];
+          fdsReadCharVecAt_v6(myfile, stringColumn, slice.blockPos[colNr], slice.firstRow, slice.length, slice.nrOfRows,
+            slice.vecOffset, nrOfThreads);
+        }
+
+        tableReader.AddCharColumn(stringColumn, colSel);
+        delete stringColumn;
+        break;
+      }
+
+      // Integer vector
+      case 8:
+      {
+        if (fixedColsRead) break;
+
+        IIntegerColumn* integerColumn = columnFactory->CreateIntegerColumn(length, colSel);
+        AdviseHugePages(integerColumn->Data(), 4 * length);
+
+        for (ChunkSlice &slice : slices)
+        {
+          istream &myfile = *streams[slice.tableNr];
+          fdsReadIntVec_v8(myfile, &integerColumn->Data()[slice.vecOffset], slice.blockPos[colNr], slice.firstRow,
+            slice.length, slice.nrOfRows, nrOfThreads);
+        }
+
+        tableReader.AddIntegerColumn(integerColumn, colSel);
+        delete integerColumn;
+        break;
+      }
+
+      // Real vector (or date or timestamp)
+      case 9:
+      case 12:
+      case 13:
+      {
+        if (fixedColsRead) break;
+
+        IDoubleColumn* doubleColumn = columnFactory->CreateDoubleColumn(length, colSel);
+        AdviseHugePages(doubleColumn->Data(), 8 * length);
+
+        for (ChunkSlice &slice : slices)
+        {
+          istream &myfile = *streams[slice.tableNr];
+          fdsReadRealVec_v9(myfile, &doubleColumn->Data()[slice.vecOffset], slice.blockPos[colNr], slice.firstRow,
+            slice.length, slice.nrOfRows, nrOfThreads);
+        }
+
+        tableReader.AddDoubleColumn(doubleColumn, colSel, StoredColumnType(colTypes[colNr]));
+        delete doubleColumn;
+        break;
+      }
+
+      // 64-bit integer vector
+      case 11:
+      {
+        if (fixedColsRead) break;
+
+        IInt64Column* int64Column = columnFactory->CreateInt64Column(length, colSel);
+        AdviseHugePages(int64Column->Data(), 8 * length);
+
+        for (ChunkSlice &slice : slices)
+        {
+          istream &myfile = *streams[slice.tableNr];
+          fdsReadInt64Vec_v11(myfile, &int64Column->Data()[slice.vecOffset], slice.blockPos[colNr], slice.firstRow,
+            slice.length, slice.nrOfRows, nrOfThreads);
+        }
+
+        tableReader.AddInt64Column(int64Column, colSel);
+        delete int64Column;
+        break;
+      }
+
+      // Logical vector
+      case 10:
+      {
+        if (fixedColsRead) break;
+
+        ILogicalColumn* logicalColumn = columnFactory->CreateLogicalColumn(length, colSel);
+        AdviseHugePages(logicalColumn->Data(), 4 * length);
+
+        for (ChunkSlice &slice : slices)
+        {
+          istream &myfile = *streams[slice.tableNr];
+          fdsReadLogicalVec_v10(myfile, &logicalColumn->Data()[slice.vecOffset], slice.blockPos[colNr], slice.firstRow,
+            slice.length, slice.nrOfRows, nrOfThreads);
+        }
+
+        tableReader.AddLogicalColumn(logicalColumn, colSel);
+        delete logicalColumn;
+        break;
+      }
+
+      // Factor vector
+      default:
+      {
+        IFactorColumn* factorColumn = columnFactory->CreateFactorColumn(length, colSel);
+
+        if (slices.size() == 1)
+        {
+          ChunkSlice &slice = slices[0];
+          istream &myfile = *streams[slice.tableNr];
+          fdsReadFactorVec_v7(myfile, factorColumn->Levels(), factorColumn->LevelData(), slice.blockPos[colNr],
+            slice.firstRow, slice.length, slice.nrOfRows, nrOfThreads);
+        }
+        else
+        {
+          ReadFactorChunks(streams, factorColumn, columnFactory, slices, colNr, nrOfThreads);
+        }
+
+        tableReader.AddFactorColumn(factorColumn, colSel);
+        delete factorColumn;
+        break;
+      }
+    }
+  }
+
+  ReadColumnAttributes(tableReader, colIndex, *streams[0]);
+}
+
+
+unsigned long long FstHandle::ReadRange(IFstTableReader &tableReader, const vector<int> &colIndex, long long startRow,
+  long long endRow, int nrOfThreads)
+{
+  // Check range of selected rows
+  long long firstRow = startRow - 1;
+  long long totalNrOfRows = (long long) nrOfRows;
+
+  if (firstRow < 0)
+  {
+    throw(runtime_error("Parameter fromRow should have a positive value."));
+  }
+
+  if (firstRow >= totalNrOfRows)
+  {
+    throw(runtime_error("Row selection is out of range."));
+  }
+
+  long long length = totalNrOfRows - firstRow;
+
+  // Determine vector length
+  if (endRow != -1)
+  {
+    if (endRow <= firstRow)
+    {
+      throw(runtime_error("Incorrect row range specified."));
+    }
+
+    length = min(endRow - firstRow, totalNrOfRows - firstRow);
+  }
+
+  return ReadRows(tableReader, colIndex, firstRow, length, nrOfThreads);
+}
+
+
+unsigned long long FstHandle::ReadRowSet(IFstTableReader &tableReader, const vector<int> &colIndex,
+  const unsigned long long* rows, unsigned long long nrOfSel, int nrOfThreads)
+{
+  if (nrOfSel == 0)
+  {
+    throw(runtime_error("Row selection is empty."));
+  }
+
+  if (inputStream == nullptr)
+  {
+    throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+  }
+
+  inputStream->clear();  // reset state from a previous read at the end of the file
+
+  return ReadRowSet(tableReader, columnFactory, *inputStream, colIndex, rows, nrOfSel, nrOfThreads);
+}
+
+
+unsigned long long FstHandle::ReadRowSet(IFstTableReader &tableReader, IColumnFactory* columnFactory, istream &stream,
+  const vector<int> &colIndex, const unsigned long long* rows, unsigned long long nrOfSel, int nrOfThreads)
+{
+  for (unsigned long long sel = 0; sel < nrOfSel; ++sel)
+  {
+    if (rows[sel] >= nrOfRows)
+    {
+      throw(runtime_error("Row selection is out of range."));
+    }
+
+    if (sel > 0 && rows[sel] < rows[sel - 1])
+    {
+      throw(runtime_error("Selected rows should be sorted in increasing order."));
+    }
+  }
+
+  BlockCacheScope cacheScope(CacheFile());
+
+  istream &myfile = stream;
+
+
+  // Group the selected rows of each chunk in row ranges. A new range is started when the gap with the previous
+  // selected row can hold a complete block of most columns (BLOCKSIZE_CHAR is the smallest default block size in
+  // rows), so mostly blocks that contain selected rows are decompressed, and most of those blocks only once.
+  vector<RowGroup> groups;
+  vector<unsigned int> selRows(nrOfSel);  // selected rows relative to the first row of their range
+  unsigned long long maxLength = 0;
+  unsigned int chunkNr = 0;
+
+  for (unsigned long long sel = 0; sel < nrOfSel; ++sel)
+  {
+    while (rows[sel] >= chunkFirstRows[chunkNr] + chunkRowCounts[chunkNr]) ++chunkNr;
+
+    unsigned long long chunkRow = rows[sel] - chunkFirstRows[chunkNr];
+
+    bool newGroup = groups.empty() || groups.back().chunkNr != chunkNr;
+
+    if (!newGroup)
+    {
+      RowGroup &group = groups.back();
+      unsigned long long lastRow = group.firstRow + group.length - 1;
+      newGroup = chunkRow > lastRow + BLOCKSIZE_CHAR || chunkRow - group.firstRow >= GATHER_MAX_ROWS;
+    }
+
+    if (newGroup)
+    {
+      RowGroup group;
+      group.chunkNr  = chunkNr;
+      group.firstRow = chunkRow;
+      group.firstSel = sel;
+      group.nrOfSel  = 0;
+      groups.push_back(group);
+    }
+
+    RowGroup &group = groups.back();
+    group.length = chunkRow - group.firstRow + 1;
+    ++group.nrOfSel;
+
+    selRows[sel] = (unsigned int) (chunkRow - group.firstRow);
+    maxLength = max(maxLength, group.length);
+  }
+
+  for (RowGroup &group : groups)
+  {
+    ChunkPositionData(group.chunkNr);  // make sure position data is available
+
+    if (verifyOnRead) VerifyChunkColumns(group.chunkNr, colIndex);
+  }
+
+  int nrOfSelect = (int) colIndex.size();
+  bool singleChunk = groups.front().chunkNr == groups.back().chunkNr;
+
+  tableReader.InitTable(nrOfSelect, nrOfSel);
+
+  // Decompressed row ranges of fixed width columns
+  vector<int> rangeInts;
+  vector<double> rangeDoubles;
+  vector<long long> rangeLongs;
+
+  // Columns are decoded in file order and added to the table at their selected position
+  for (int colSel : FileOrder(colIndex.data(), nrOfSelect, ChunkPositionData(groups.front().chunkNr)))
+  {
+    int colNr = colIndex[colSel];
+    ProfileColumn profileColumn(colSel, ProfilePhase::TABLE);
+
+    switch (colTypes[colNr])
+    {
+    // Character vector
+      case 6:
+      {
+        IStringColumn* stringColumn = columnFactory->CreateStringColumn(nrOfSel);
+        stringColumn->AllocateVec(nrOfSel);
+
+        for (RowGroup &group : groups)
+        {
+          GatherStringColumn gatherColumn(stringColumn, &selRows[group.firstSel], group.nrOfSel, group.firstSel);
+          fdsReadCharVecAt_v6(myfile, &gatherColumn, ChunkPositionData(group.chunkNr)[colNr], group.firstRow,
+            group.length, chunkRowCounts[group.chunkNr], 0);
+        }
+
+        tableReader.AddCharColumn(stringColumn, colSel);
+        delete stringColumn;
+        break;
+      }
+
+      // Integer vector
+      case 8:
+      {
+        IIntegerColumn* integerColumn = columnFactory->CreateIntegerColumn(nrOfSel);
+        rangeInts.resize(maxLength);
+
+        for (RowGroup &group : groups)
+        {
+          fdsReadIntVec_v8(myfile, rangeInts.data(), ChunkPositionData(group.chunkNr)[colNr], group.firstRow,
+            group.length, chunkRowCounts[group.chunkNr], nrOfThreads);
+          GatherRows(&integerColumn->Data()[group.firstSel], rangeInts.data(), &selRows[group.firstSel],
+            group.nrOfSel);
+        }
+
+        tableReader.AddIntegerColumn(integerColumn, colSel);
+        delete integerColumn;
+        break;
+      }
+
+      // Real vector (or date or timestamp)
+      case 9:
+      case 12:
+      case 13:
+      {
+        IDoubleColumn* doubleColumn = columnFactory->CreateDoubleColumn(nrOfSel);
+        rangeDoubles.resize(maxLength);
+
+        for (RowGroup &group : groups)
+        {
+          fdsReadRealVec_v9(myfile, rangeDoubles.data(), ChunkPositionData(group.chunkNr)[colNr], group.firstRow,
+            group.length, chunkRowCounts[group.chunkNr], nrOfThreads);
+          GatherRows(&doubleColumn->Data()[group.firstSel], rangeDoubles.data(), &selRows[group.firstSel],
+            group.nrOfSel);
+        }
+
+        tableReader.AddDoubleColumn(doubleColumn, colSel, StoredColumnType(colTypes[colNr]));
+        delete doubleColumn;
+        break;
+      }
+
+      // 64-bit integer vector
+      case 11:
+      {
+        IInt64Column* int64Column = columnFactory->CreateInt64Column(nrOfSel);
+        rangeLongs.resize(maxLength);
+
+        for (RowGroup &group : groups)
+        {
+          fdsReadInt64Vec_v11(myfile, rangeLongs.data(), ChunkPositionData(group.chunkNr)[colNr], group.firstRow,
+            group.length, chunkRowCounts[group.chunkNr], nrOfThreads);
+          GatherRows(&int64Column->Data()[group.firstSel], rangeLongs.data(), &selRows[group.firstSel],
+            group.nrOfSel);
+        }
+
+        tableReader.AddInt64Column(int64Column, colSel);
+        delete int64Column;
+        break;
+      }
+
+      // Logical vector
+      case 10:
+      {
+        ILogicalColumn* logicalColumn = columnFactory->CreateLogicalColumn(nrOfSel);
+        rangeInts.resize(maxLength);
+
+        for (RowGroup &group : groups)
+        {
+          fdsReadLogicalVec_v10(myfile, rangeInts.data(), ChunkPositionData(group.chunkNr)[colNr], group.firstRow,
+            group.length, chunkRowCounts[group.chunkNr], nrOfThreads);
+          GatherRows(&logicalColumn->Data()[group.firstSel], rangeInts.data(), &selRows[group.firstSel],
+            group.nrOfSel);
+        }
+
+        tableReader.AddLogicalColumn(logicalColumn, colSel);
+        delete logicalColumn;
+        break;
+      }
+
+      // Factor vector, the levels of each chunk are read once
+      default:
+      {
+        IFactorColumn* factorColumn = columnFactory->CreateFactorColumn(nrOfSel);
+        int* levelData = factorColumn->LevelData();
+        rangeInts.resize(maxLength);
+
+        FactorLevelMerger levelMerger;
+        unsigned int groupNr = 0;
+
+        while (groupNr < groups.size())
+        {
+          unsigned int chunkNr = groups[groupNr].chunkNr;
+          unsigned long long pos = ChunkPositionData(chunkNr)[colNr];
+          unsigned long long chunkFirstSel = groups[groupNr].firstSel;
+          unsigned long long chunkNrOfSel = 0;
+
+          for (; groupNr < groups.size() && groups[groupNr].chunkNr == chunkNr; ++groupNr)
+          {
+            RowGroup &group = groups[groupNr];
+
+            fdsReadFactorCodes_v7(myfile, rangeInts.data(), pos, group.firstRow, group.length,
+              chunkRowCounts[chunkNr], nrOfThreads);
+            GatherRows(&levelData[group.firstSel], rangeInts.data(), &selRows[group.firstSel], group.nrOfSel);
+
+            chunkNrOfSel += group.nrOfSel;
+          }
+
+          if (singleChunk)
+          {
+            fdsReadFactorLevels_v7(myfile, factorColumn->Levels(), pos);
+            break;
+          }
+
+          // Version and number of levels of the factor column
+          unsigned int factorMeta[2];
+          myfile.seekg(pos);
+          myfile.read((char*) factorMeta, 8);
+
+          IStringColumn* chunkLevels = columnFactory->CreateStringColumn(factorMeta[1]);
+          fdsReadFactorLevels_v7(myfile, chunkLevels, pos);
+
+          levelMerger.AddChunk(chunkLevels, factorMeta[1], &levelData[chunkFirstSel], chunkNrOfSel, nrOfThreads);
+          delete chunkLevels;
+        }
+
+        if (!singleChunk)
+        {
+          levelMerger.SetLevels(factorColumn);
+        }
+
+        tableReader.AddFactorColumn(factorColumn, colSel);
+        delete factorColumn;
+        break;
+      }
+    }
+  }
+
+  ReadColumnAttributes(tableReader, colIndex, myfile);
+
+  return nrOfSel;
+}
+
+
+// Draw nrOfSamples distinct values from 0 until populationSize with Robert Floyd's algorithm, in increasing
+// order. Large samples are drawn as the complement of a smaller sample. Values are taken from the raw output of
+// the generator (which is fully specified by the standard), unlike std::uniform_int_distribution, so samples are
+// identical on all platforms. The modulo bias is at most populationSize / 2^64.
+inline void DrawSample(mt19937_64 &generator, unsigned long long populationSize, unsigned long long nrOfSamples,
+  vector<unsigned long long> &sample)
+{
+  bool complement = nrOfSamples > populationSize / 2;
+  unsigned long long nrOfDraws = complement ? populationSize - nrOfSamples : nrOfSamples;
+
+  sample.clear();
+  sample.reserve(nrOfSamples);
+
+  // Dense draws are marked in a flag per value
+  if (nrOfDraws > populationSize / 64)
+  {
+    vector<char> drawn(populationSize, 0);
+
+    for (unsigned long long value = populationSize - nrOfDraws; value < populationSize; ++value)
+    {
+      unsigned long long draw = generator() % (value + 1);
+      drawn[drawn[draw] ? value : draw] = 1;
+    }
+
+    for (unsigned long long value = 0; value < populationSize; ++value)
+    {
+      if ((drawn[value] != 0) != complement) sample.push_back(value);
+    }
+
+    return;
+  }
+
+  unordered_set<unsigned long long> drawn;
+  drawn.reserve(nrOfDraws);
+
+  for (unsigned long long value = populationSize - nrOfDraws; value < populationSize; ++value)
+  {
+    unsigned long long draw = generator() % (value + 1);
+    if (!drawn.insert(draw).second) drawn.insert(value);
+  }
+
+  vector<unsigned long long> draws(drawn.begin(), drawn.end());
+  sort(draws.begin(), draws.end());
+
+  if (!complement)
+  {
+    sample.swap(draws);
+    return;
+  }
+
+  unsigned long long drawNr = 0;
+
+  for (unsigned long long value = 0; value < populationSize; ++value)
+  {
+    if (drawNr < draws.size() && draws[drawNr] == value)
+    {
+      ++drawNr;
+      continue;
+    }
+
+    sample.push_back(value);
+  }
+}
+
+
+// Default number of elements in a compression block of a column, for column data without a zone map
+inline unsigned long long DefaultBlockRows(unsigned short int colType)
+{
+  switch (colType)
+  {
+    case 6:
+      return BLOCKSIZE_CHAR;
+
+    case 9:
+    case 12:
+    case 13:
+      return BLOCKSIZE_REAL;
+
+    case 11:
+      return BLOCKSIZE_INT64;
+
+    case 10:
+      return BLOCKSIZE_LOGICAL;
+
+    default:
+      return BLOCKSIZE_INT;
+  }
+}
+
+
+void FstHandle::SampleRows(const vector<int> &colIndex, double fraction, bool blocks, unsigned long long seed,
+  vector<unsigned long long> &rows)
+{
+  if (!(fraction >= 0.0 && fraction <= 1.0))
+  {
+    throw(runtime_error("The sample fraction should be a value between 0 and 1."));
+  }
+
+  mt19937_64 generator(seed);
+
+  if (!blocks)
+  {
+    DrawSample(generator, nrOfRows, (unsigned long long) llround(fraction * nrOfRows), rows);
+    return;
+  }
+
+  // Divide each data chunk in sampling blocks, blocks of the other selected columns end within a sampling block
+  // or span a few sampling blocks at most
+  unsigned int nrOfChunks = NrOfChunks();
+  vector<unsigned long long> blockRows(nrOfChunks, 1);
+  vector<unsigned long long> firstBlocks(nrOfChunks + 1, 0);
+
+  for (unsigned int chunkNr = 0; chunkNr < nrOfChunks; ++chunkNr)
+  {
+    for (int colNr : colIndex)
+    {
+      ZoneMap zoneMap;
+      unsigned long long colBlockRows = ReadZoneMap(chunkNr, colNr, zoneMap, true) ? zoneMap.BlockSize() :
+        DefaultBlockRows(colTypes[colNr]);
+
+      blockRows[chunkNr] = max(blockRows[chunkNr], colBlockRows);
+    }
+
+    firstBlocks[chunkNr + 1] = firstBlocks[chunkNr] +
+      (chunkRowCounts[chunkNr] + blockRows[chunkNr] - 1) / blockRows[chunkNr];
+  }
+
+  unsigned long long nrOfBlocks = firstBlocks[nrOfChunks];
+  unsigned long long nrOfSamples = (unsigned long long) llround(fraction * nrOfBlocks);
+
+  if (nrOfSamples == 0 && fraction > 0.0) nrOfSamples = min(nrOfBlocks, 1ULL);
+
+  vector<unsigned long long> sampledBlocks;
+  DrawSample(generator, nrOfBlocks, nrOfSamples, sampledBlocks);
+
+  // Expand the sampled blocks to their rows
+  rows.clear();
+  unsigned int chunkNr = 0;
+
+  for (unsigned long long blockNr : sampledBlocks)
+  {
+    while (blockNr >= firstBlocks[chunkNr + 1]) ++chunkNr;
+
+    unsigned long long firstRow = chunkFirstRows[chunkNr] + (blockNr - firstBlocks[chunkNr]) * blockRows[chunkNr];
+    unsigned long long endRow = min(firstRow + blockRows[chunkNr], chunkFirstRows[chunkNr] + chunkRowCounts[chunkNr]);
+
+    for (unsigned long long row = firstRow; row < endRow; ++row)
+    {
+      rows.push_back(row);
+    }
+  }
+}
+
+
+void FstHandle::SelectedColumns(const vector<int> &colIndex, IStringArray* selectedCols, vector<int> &keyIndex)
+{
+  int nrOfSelect = (int) colIndex.size();
+
+  // Leading key columns present in the result
+  for (int i = 0; i < keyLength; ++i)
+  {
+    int colSel = 0;
+
+    for (; colSel < nrOfSelect; ++colSel)
+    {
+      if (keyColPos[i] == colIndex[colSel])  // key present in result
+      {
+        keyIndex.push_back(colSel);
+        break;
+      }
+    }
+
+    // key column not selected
+    if (colSel == nrOfSelect) break;
+  }
+
+  selectedCols->AllocateArray(nrOfSelect);
+
+  for (int i = 0; i < nrOfSelect; ++i)
+  {
+    selectedCols->SetElement(i, colNames->GetElement(colIndex[i]));
+  }
+}
@@ -0,0 +1,447 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_HANDLE_H
+#define FST_HANDLE_H
+
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include <icolumnfactory.h>
+#include <ifsttable.h>
+#include <ifstio.h>
+#include <columnnameindex.h>
+#include <zonemap.h>
+#include <checksum.h>
+#include <blockcache.h>
+#include <blockstreamer_v2.h>
+
+
+// Column type of the writers of a stored column type
+inline FstColumnType StoredColumnType(unsigned short int colType)
+{
+  switch (colType)
+  {
+    case 6:
+      return FstColumnType::CHARACTER;
+
+    case 7:
+      return FstColumnType::FACTOR;
+
+    case 8:
+      return FstColumnType::INT_32;
+
+    case 9:
+      return FstColumnType::DOUBLE_64;
+
+    case 10:
+      return FstColumnType::BOOL_32;
+
+    case 11:
+      return FstColumnType::INT_64;
+
+    case 12:
+      return FstColumnType::DATE_DAYS;
+
+    case 13:
+      return FstColumnType::TIMESTAMP_SECONDS;
+
+    default:
+      return FstColumnType::UNKNOWN;
+  }
+}
+
+
+// Part of the selected row range that is stored in a single data chunk
+struct ChunkSlice
+{
+  unsigned int tableNr;          // table (input) of the chunk in a read of multiple tables
+  unsigned int chunkNr;          // data chunk in its table
+  unsigned long long* blockPos;  // file positions of the columns of the chunk
+  unsigned long long firstRow;   // first selected row of the chunk
+  unsigned long long length;     // number of selected rows in the chunk
+  unsigned long long nrOfRows;   // total number of rows in the chunk
+  unsigned long long vecOffset;  // position of the first selected row in the result vectors
+};
+
+
+/**
+ Open fst input with its table metadata parsed. The header, column names (indexed by a hash map) and
+ chunkset index are read once when the handle is opened and the input stream is kept open. The position data
+ of each data chunk is read on first use and cached, so repeated reads through a single handle only pay for
+ reading the column data.
+ */
+class FstHandle
+{
+  IFstInput &input;
+  IColumnFactory* columnFactory;
+  std::istream* inputStream;
+
+  // Layout of the opened file
+  int nrOfCols;
+  int keyLength;
+  std::vector<int> keyColPos;
+  std::vector<unsigned short int> colTypes;
+  std::vector<unsigned short int> colAttributeTypes;
+  IStringColumn* colNames;
+  ColumnNameIndex colNameIndex;
+
+  // Horizontal chunksets: the first chunkset and the chunksets of appended columns (see FstStore::fstCbind), which
+  // share the rows of their data chunks. The stored columns of all chunksets are numbered consecutively.
+  int nrOfStoredCols;
+  std::vector<int> chunkSetFirstCols;                              // first stored column of each chunkset, then
+                                                                   // nrOfStoredCols
+  std::vector<unsigned long long> chunkSetHeaderPos;               // position of the header of each chunkset
+  std::vector<unsigned long long> chunkSetAttributePos;            // position of the attribute section of each chunkset
+  std::vector<std::vector<unsigned long long>> chunkSetPositions;  // file positions of the position data of each chunk
+
+  // Stored columns, of which replaced and deleted columns are hidden (see VisibleColumns)
+  std::vector<int> storedCols;                            // stored column of each column, empty if all are visible
+  std::vector<unsigned short int> storedColTypes;
+  std::vector<unsigned short int> storedAttributeTypes;
+
+  // Column attributes, the offsets are read on first use
+  std::vector<unsigned long long> attributeOffsets;  // position of the attribute data of each stored column
+  std::vector<unsigned int> attributeSizes;          // size of the attribute data of each stored column
+
+  // Data chunks
+  std::vector<unsigned long long> chunkRowCounts;   // number of rows of each chunk
+  std::vector<unsigned long long> chunkFirstRows;   // first row of each chunk
+  std::vector<unsigned long long> positionData;     // cached column positions, nrOfCols elements per chunk
+  std::vector<bool> positionDataRead;
+
+  unsigned long long nrOfRows;
+
+  // Checksum verification of the column data before it's decompressed
+  bool verifyOnRead;
+  std::vector<bool> columnVerified;  // nrOfCols elements per chunk
+
+  unsigned long long cacheFileId;  // identity of the file in the block cache, zero if blocks aren't cached
+
+  // Identity of the file in the shared block cache, determined on first use
+  bool fileIdentityRead;
+  bool hasFileIdentity;
+  FstFileIdentity fileIdentity;
+
+  // Identity of the file in the block cache used by the reads: the shared block cache if it's enabled, the
+  // process-wide block cache otherwise
+  unsigned long long CacheFile();
+
+  unsigned long long* ChunkPositionData(unsigned int chunkNr);
+
+  // Read the metadata that is otherwise read on first use: the position data of all data chunks, the offsets of the
+  // column attributes and the identity of the file. Reads with a stream of the caller (see ReadRows) and without
+  // checksum verification don't modify the handle after this.
+  void ReadAllMetadata();
+
+  void VerifyChunkColumns(unsigned int chunkNr, const std::vector<int> &colIndex);
+
+  // Add the slices of the data chunks that overlap with rows [firstRow, firstRow + length). The selected rows are
+  // placed at position vecOffset of the result vectors.
+  void ChunkSlices(unsigned long long firstRow, unsigned long long length, unsigned long long vecOffset,
+    unsigned int tableNr, std::vector<ChunkSlice> &slices);
+
+  // Decompress the selected columns of the chunk slices into a result table of length rows. Slice tableNr reads from
+  // inputs[tableNr] with stream streams[tableNr], the column layout and attributes are those of this table.
+  // The column vectors are created with columnFactory.
+  void ReadSlices(IFstTableReader &tableReader, IColumnFactory* columnFactory, const std::vector<int> &colIndex,
+    const std::vector<IFstInput*> &inputs, const std::vector<std::istream*> &streams, std::vector<ChunkSlice> &slices,
+    unsigned long long length, int nrOfThreads, unsigned long long blockCacheId);
+
+  // Read rows with a stream of the input and a column factory of the caller (see the public ReadRows and ReadRowSet)
+  unsigned long long ReadRows(IFstTableReader &tableReader, IColumnFactory* columnFactory, std::istream &stream,
+    const std::vector<int> &colIndex, unsigned long long firstRow, unsigned long long length, int nrOfThreads);
+
+  unsigned long long ReadRowSet(IFstTableReader &tableReader, IColumnFactory* columnFactory, std::istream &stream,
+    const std::vector<int> &colIndex, const unsigned long long* rows, unsigned long long nrOfSel, int nrOfThreads);
+
+  void ReadAttributeOffsets(std::istream &stream);
+
+  void ReadAttributeData(std::istream &stream, int colNr, std::vector<char> &attributeData);
+
+  void ReadColumnAttributes(IFstTableReader &tableReader, const std::vector<int> &colIndex, std::istream &stream);
+
+  friend class FstFilter;        // decompresses the compared columns of a row filter
+  friend class FstKeyLookup;     // decompresses single blocks of the key columns
+  friend class FstDataset;       // reads the data chunks of multiple tables into a single result
+  friend class FstCopier;        // copies the stored column data of data chunks to a new file
+  friend class FstAggregator;    // decompresses the aggregated columns in batches
+  friend class FstJoiner;        // reads the join columns of keyed tables
+  friend class FstSharedHandle;  // reads with a stream and column factory per read
+
+public:
+  /**
+   Create a handle on a fst input. The input should remain valid during the lifetime of the handle.
+
+   @param input Source of the fst data.
+   @param columnFactory Factory used to create column vectors (only used from the calling thread).
+   */
+  FstHandle(IFstInput &input, IColumnFactory* columnFactory);
+
+  ~FstHandle();
+
+  /**
+   Parse the table metadata and the chunkset index of the input.
+
+   @return false if the input uses the deprecated (pre v0.7.3) file format, which can't be read with a handle.
+   */
+  bool Open();
+
+  /**
+   Total number of rows in the table.
+   */
+  unsigned long long NrOfRows() { return nrOfRows; }
+
+  /**
+   Number of columns in the table.
+   */
+  int NrOfColumns() { return nrOfCols; }
+
+  /**
+   Column number of a column name, -1 if the table has no such column.
+   */
+  int ColumnIndex(const char* colName) { return colNameIndex.Find(colName); }
+
+  /**
+   Whether a column is one of the key columns of a sorted table.
+   */
+  bool IsKeyColumn(int colNr) { return std::find(keyColPos.begin(), keyColPos.end(), colNr) != keyColPos.end(); }
+
+  /**
+   Number of data chunks in the table.
+   */
+  unsigned int NrOfChunks() { return (unsigned int) chunkRowCounts.size(); }
+
+  /**
+   Number of rows in a data chunk.
+   */
+  unsigned long long ChunkNrOfRows(unsigned int chunkNr) { return chunkRowCounts[chunkNr]; }
+
+  /**
+   First row (0-based) of a data chunk.
+   */
+  unsigned long long ChunkFirstRow(unsigned int chunkNr) { return chunkFirstRows[chunkNr]; }
+
+  /**
+   Column type, as stored in the file (6: character, 7: factor, 8: integer, 9: double, 10: logical,
+   11: 64-bit integer, 12: date, 13: timestamp).
+   */
+  unsigned short int ColumnType(int colNr) { return colTypes[colNr]; }
+
+  /**
+   Read the zone map with the per-block statistics of a column in a data chunk.
+
+   @param chunkNr Data chunk of the column data.
+   @param colNr Column number.
+   @param zoneMap Receives the zone map.
+   @param metaOnly If true, only the metadata of the zone map is read (see ZoneMap::ReadMeta).
+   @return false if the column data has no zone map (files written before zone maps were introduced).
+   */
+  bool ReadZoneMap(unsigned int chunkNr, int colNr, ZoneMap &zoneMap, bool metaOnly = false);
+
+  /**
+   Read the Bloom filters of the blocks of a column in a data chunk (see BloomFilter).
+
+   @param zoneMap Zone map of the column in the data chunk (at least its metadata), which locates the filters.
+   @param bloomFilter Receives the filters.
+   @return false if the column data has no Bloom filters.
+   */
+  bool ReadBloomFilter(unsigned int chunkNr, int colNr, const ZoneMap &zoneMap, BloomFilter &bloomFilter);
+
+  /**
+   Whether table has the same column names and types as this table.
+   */
+  bool SameColumns(FstHandle &table);
+
+  /**
+   Read the encoded attributes of a column (see IFstTable::GetColumnAttributes).
+
+   @param colNr Column number.
+   @param attributeData Receives the attributes, empty if the column has none.
+   */
+  void ReadAttributeData(int colNr, std::vector<char> &attributeData);
+
+  /**
+   Whether the column data is stored with checksums (files written before checksums were introduced have none).
+   */
+  bool HasChecksums(int colNr);
+
+  /**
+   Read the checksums of a column in a data chunk.
+
+   @return false if the column data has no (valid) checksums.
+   */
+  bool ReadChecksum(unsigned int chunkNr, int colNr, ColumnChecksum &checksum);
+
+  /**
+   Verify the stored (compressed) column data of a data chunk with its checksums. The data is hashed without
+   decompressing it.
+
+   @return false if the column data is damaged. Column data without checksums (see HasChecksums) can't be
+   verified and is reported as damaged.
+   */
+  bool VerifyColumn(unsigned int chunkNr, int colNr);
+
+  /**
+   Verify the checksums of the column data read by ReadRows and ReadRowSet before it's decompressed. Damaged
+   column data is reported with an exception. Columns without checksums are read without verification. Each
+   column of a data chunk is verified only once during the lifetime of the handle.
+   */
+  void SetVerifyOnRead(bool verify) { verifyOnRead = verify; }
+
+  /**
+   Cache the decompressed blocks of the reads through this handle in the process-wide block cache (see BlockCache),
+   which is effective when the cache has a memory budget. The cached blocks are released when the handle is
+   destroyed or the cache is disabled for the handle. Reads of a file use the shared block cache instead when it
+   is enabled (see SharedBlockCache), independent of this setting.
+   */
+  void SetBlockCache(bool enable);
+
+  /**
+   Replace the factory used to create the column vectors of subsequent reads, for example with a factory that
+   returns preallocated columns. Returns the previous factory.
+   */
+  IColumnFactory* SetColumnFactory(IColumnFactory* factory)
+  {
+    IColumnFactory* previous = columnFactory;
+    columnFactory = factory;
+    return previous;
+  }
+
+  /**
+   Combine the zone maps of a column over all data chunks.
+
+   @param colNr Column number.
+   @param summary Receives the statistics of the complete column. For factor columns, the minimum and maximum
+   are level codes, which refer to the levels of the individual data chunks.
+   @return false if not all data chunks have a zone map for the column.
+   */
+  bool ColumnStatistics(int colNr, ZoneMapEntry &summary);
+
+  /**
+   Determine the storage of a column over all data chunks, from the block indexes of the column. No data blocks
+   are read.
+
+   @param colNr Column number.
+   @param storage Receives the size of the column in the file and the number of blocks per compression algorithm.
+   The zone maps, checksums and bloom filters of the column are not included.
+   */
+  void ReadColumnStorage(int colNr, ColumnStorage &storage);
+
+  /**
+   Determine the number of bytes of the column data of the replaced and deleted columns, which are left in the file
+   until it is copied. Only the zone maps, checksum metadata and block indexes of these columns are read. Columns
+   stored without checksums are not included.
+   */
+  unsigned long long DeadBytes();
+
+  /**
+   File position of the attribute flags of a column in the header of its chunkset, see FstStore::fstDeleteColumn.
+   */
+  unsigned long long AttributeTypePos(int colNr);
+
+  /**
+   Determine the column numbers of a column selection.
+
+   @param columnSelection Names of the selected columns or nullptr for all columns.
+   @param colIndex Receives the column number of each selected column.
+   */
+  void SelectColumns(IStringArray* columnSelection, std::vector<int> &colIndex);
+
+  /**
+   Read rows firstRow until firstRow + length (0-based) of the selected columns. Rows beyond the last row of
+   the table are ignored. Stored column attributes are restored on the result columns.
+
+   @param tableReader Table that receives the column vectors.
+   @param colIndex Column numbers of the selected columns, determined with SelectColumns.
+   @param firstRow First row to read, should be smaller than the number of rows in the table.
+   @param length Number of rows to read.
+   @param nrOfThreads Number of threads available for decompressing columns in parallel.
+   @return Number of rows read.
+   */
+  unsigned long long ReadRows(IFstTableReader &tableReader, const std::vector<int> &colIndex,
+    unsigned long long firstRow, unsigned long long length, int nrOfThreads);
+
+  /**
+   Read a range of rows specified with 1-based row numbers, as used by FstStore::fstRead.
+
+   @param startRow First row to read (1-based).
+   @param endRow Last row to read or -1 for all remaining rows.
+   @return Number of rows read.
+   */
+  unsigned long long ReadRange(IFstTableReader &tableReader, const std::vector<int> &colIndex, long long startRow,
+    long long endRow, int nrOfThreads);
+
+  /**
+   Read a set of rows of the selected columns. The selected rows are grouped in row ranges per data chunk, such
+   that only the blocks that contain selected rows are decompressed, after which the selected rows are gathered
+   in the result vectors.
+
+   @param tableReader Table that receives the column vectors.
+   @param colIndex Column numbers of the selected columns, determined with SelectColumns.
+   @param rows Selected rows (0-based), sorted in increasing order. Duplicate rows are allowed.
+   @param nrOfSel Number of selected rows, at least one.
+   @param nrOfThreads Number of threads available for decompressing columns in parallel.
+   @return Number of rows read.
+   */
+  unsigned long long ReadRowSet(IFstTableReader &tableReader, const std::vector<int> &colIndex,
+    const unsigned long long* rows, unsigned long long nrOfSel, int nrOfThreads);
+
+  /**
+   Draw a uniform random sample of the rows of the table, to be read with ReadRowSet.
+
+   @param colIndex Column numbers of the columns that will be read, which determine the sampled blocks.
+   @param fraction Fraction of the rows (or blocks) to sample, between 0 and 1.
+   @param blocks If false, round(fraction * NrOfRows()) distinct rows are drawn. If true, whole blocks of rows are
+   drawn, which is much cheaper to read: the rows of each data chunk are divided in blocks with the (largest)
+   compression block size of the selected columns and round(fraction * number of blocks) blocks, at least one, are
+   selected. Only those blocks are read and decompressed.
+   @param seed Seed of the random generator, the same seed gives the same sample on every platform.
+   @param rows Receives the sampled rows (0-based), sorted in increasing order.
+   */
+  void SampleRows(const std::vector<int> &colIndex, double fraction, bool blocks, unsigned long long seed,
+    std::vector<unsigned long long> &rows);
+
+  /**
+   Names of the selected columns and the positions of the key columns among them. Only the leading key
+   columns that are present in the selection are reported in keyIndex.
+   */
+  void SelectedColumns(const std::vector<int> &colIndex, IStringArray* selectedCols, std::vector<int> &keyIndex);
+};
+
+
+#endif  // FST_HANDLE_H
@@ -0,0 +1,638 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <ifsttable.h>
+#include <icolumnfactory.h>
+
+#include <fstdefines.h>
+#include <fsthandle.h>
+#include <fstindex.h>
+#include <fstio.h>
+#include <fstwriter.h>
+#include <stringvectorcolumn.h>
+#include <vectorcolumn.h>
+
+
+using namespace std;
+
+
+// A batch of index entries: values of the indexed column with their (1-based) row numbers. The batch is the column
+// factory and the result table of reads of the indexed column and of index files, and the table of the batches
+// that are written to the run file and the index file. Only the value vector of the value type is used.
+class IndexBatch : public IFstTable, public IFstTableReader, public IColumnFactory
+{
+public:
+  FstColumnType valueType;
+  unsigned long long nrOfRows;
+
+  vector<int> ints;           // integer columns
+  vector<double> doubles;     // double, date and timestamp columns
+  vector<long long> longs;    // 64-bit integer columns
+  StringVectorColumn strings;  // character and factor columns
+  vector<double> rows;
+
+  StringVectorColumn colNames;
+
+  IndexBatch(FstColumnType valueType) : valueType(valueType), nrOfRows(0)
+  {
+    colNames.AllocateVec(2);
+    colNames.strings[0] = "Value";
+    colNames.strings[1] = "Row";
+  }
+
+  void Clear()
+  {
+    nrOfRows = 0;
+    ints.clear();
+    doubles.clear();
+    longs.clear();
+    strings.strings.clear();
+    strings.isNA.clear();
+    rows.clear();
+  }
+
+  // IColumnFactory
+  IFactorColumn* CreateFactorColumn(unsigned long long nrOfRows) { return new FactorVectorColumn(nrOfRows); }
+  ILogicalColumn* CreateLogicalColumn(unsigned long long nrOfRows) { return new LogicalVectorColumn(nrOfRows); }
+  IDoubleColumn* CreateDoubleColumn(unsigned long long nrOfRows) { return new DoubleVectorColumn(nrOfRows); }
+  IIntegerColumn* CreateIntegerColumn(unsigned long long nrOfRows) { return new IntVectorColumn(nrOfRows); }
+  IInt64Column* CreateInt64Column(unsigned long long nrOfRows) { return new Int64VectorColumn(nrOfRows); }
+  IStringColumn* CreateStringColumn(unsigned long long nrOfRows) { return new StringVectorColumn(); }
+  IStringArray* CreateStringArray() { return nullptr; }  // not used for reading column data
+
+  // IFstTableReader, the value column is added as column 0 and the row numbers of an index file as column 1
+  void InitTable(unsigned int nrOfCols, unsigned long long nrOfRows) { this->nrOfRows = nrOfRows; }
+
+  void AddCharColumn(IStringColumn* stringColumn, int colNr)
+  {
+    StringVectorColumn* column = static_cast<StringVectorColumn*>(stringColumn);
+    strings.strings.swap(column->strings);
+    strings.isNA.swap(column->isNA);
+  }
+
+  void AddLogicalColumn(ILogicalColumn* logicalColumn, int colNr) {}  // logical columns are not indexed
+
+  void AddIntegerColumn(IIntegerColumn* integerColumn, int colNr)
+  {
+    ints.swap(static_cast<IntVectorColumn*>(integerColumn)->data);
+  }
+
+  void AddDoubleColumn(IDoubleColumn* doubleColumn, int colNr, FstColumnType colType)
+  {
+    (colNr == 0 ? doubles : rows).swap(static_cast<DoubleVectorColumn*>(doubleColumn)->data);
+  }
+
+  void AddInt64Column(IInt64Column* int64Column, int colNr)
+  {
+    longs.swap(static_cast<Int64VectorColumn*>(int64Column)->data);
+  }
+
+  // The level codes of a factor column are replaced by their levels
+  void AddFactorColumn(IFactorColumn* factorColumn, int colNr)
+  {
+    FactorVectorColumn* column = static_cast<FactorVectorColumn*>(factorColumn);
+    vector<string> &levels = column->levels.strings;
+
+    strings.AllocateVec(column->data.size());
+
+    for (unsigned long long row = 0; row < column->data.size(); ++row)
+    {
+      int code = column->data[row];
+
+      if (code == INT_MIN)
+      {
+        strings.isNA[row] = 1;
+        continue;
+      }
+
+      strings.strings[row] = levels[code - 1];
+    }
+  }
+
+  void SetColumnAttributes(int colNr, const char* attributeData, unsigned int size) {}
+  void SetColNames() {}
+  void SetKeyColumns(int* keyColPos, unsigned int nrOfKeys) {}
+
+  // IFstTable, the batch is keyed on the value column
+  FstColumnType GetColumnType(unsigned int colNr) { return colNr == 0 ? valueType : FstColumnType::DOUBLE_64; }
+  IBlockWriter* GetCharWriter(unsigned int colNr) { return new StringVectorWriter(strings); }
+  int* GetLogicalWriter(unsigned int colNr) { return nullptr; }
+  int* GetIntWriter(unsigned int colNr) { return ints.data(); }
+  double* GetDoubleWriter(unsigned int colNr) { return colNr == 0 ? doubles.data() : rows.data(); }
+  long long* GetInt64Writer(unsigned int colNr) { return longs.data(); }
+  IBlockWriter* GetLevelWriter(unsigned int colNr) { return nullptr; }
+  void GetColumnAttributes(unsigned int colNr, vector<char> &attributeData) { attributeData.clear(); }
+  IBlockWriter* GetColNameWriter() { return new StringVectorWriter(colNames); }
+  void GetKeyColumns(int* keyColPos) { keyColPos[0] = 0; }
+  unsigned int NrOfKeys() { return 1; }
+  unsigned int NrOfColumns() { return 2; }
+  unsigned long long NrOfRows() { return nrOfRows; }
+};
+
+
+// Access to the values of a batch of a specific value type. Entries are ordered on value, with NA values first,
+// and entries with equal values on row number.
+template<typename T>
+struct IndexValues
+{
+  static vector<T> &Values(IndexBatch &batch);
+
+  static bool IsNA(const IndexBatch &batch, unsigned long long pos);
+
+  static bool Less(IndexBatch &batchA, unsigned long long posA, IndexBatch &batchB, unsigned long long posB)
+  {
+    bool naA = IsNA(batchA, posA);
+    bool naB = IsNA(batchB, posB);
+
+    if (naA || naB)
+    {
+      if (naA != naB) return naA;
+    }
+    else
+    {
+      const T &valueA = Values(batchA)[posA];
+      const T &valueB = Values(batchB)[posB];
+
+      if (valueA < valueB) return true;
+      if (valueB < valueA) return false;
+    }
+
+    return batchA.rows[posA] < batchB.rows[posB];
+  }
+
+  static void Append(IndexBatch &batch, IndexBatch &source, unsigned long long pos)
+  {
+    Values(batch).push_back(Values(source)[pos]);
+    batch.rows.push_back(source.rows[pos]);
+    ++batch.nrOfRows;
+  }
+
+  static void Permute(IndexBatch &batch, const vector<unsigned long long> &order)
+  {
+    vector<T> &values = Values(batch);
+    vector<T> sortedValues(order.size());
+    vector<double> sortedRows(order.size());
+
+    for (unsigned long long pos = 0; pos < order.size(); ++pos)
+    {
+      swap(sortedValues[pos], values[order[pos]]);
+      sortedRows[pos] = batch.rows[order[pos]];
+    }
+
+    values.swap(sortedValues);
+    batch.rows.swap(sortedRows);
+  }
+};
+
+
+template<> vector<int> &IndexValues<int>::Values(IndexBatch &batch) { return batch.ints; }
+template<> vector<double> &IndexValues<double>::Values(IndexBatch &batch) { return batch.doubles; }
+template<> vector<long long> &IndexValues<long long>::Values(IndexBatch &batch) { return batch.longs; }
+template<> vector<string> &IndexValues<string>::Values(IndexBatch &batch) { return batch.strings.strings; }
+
+template<> bool IndexValues<int>::IsNA(const IndexBatch &batch, unsigned long long pos)
+{
+  return batch.ints[pos] == INT_MIN;
+}
+
+template<> bool IndexValues<double>::IsNA(const IndexBatch &batch, unsigned long long pos)
+{
+  return batch.doubles[pos] != batch.doubles[pos];  // NA and NaN
+}
+
+template<> bool IndexValues<long long>::IsNA(const IndexBatch &batch, unsigned long long pos)
+{
+  return batch.longs[pos] == LLONG_MIN;
+}
+
+template<> bool IndexValues<string>::IsNA(const IndexBatch &batch, unsigned long long pos)
+{
+  return batch.strings.isNA[pos] != 0;
+}
+
+
+// The NA flags of character values are kept with the values
+template<> void IndexValues<string>::Append(IndexBatch &batch, IndexBatch &source, unsigned long long pos)
+{
+  batch.strings.strings.push_back(source.strings.strings[pos]);
+  batch.strings.isNA.push_back(source.strings.isNA[pos]);
+  batch.rows.push_back(source.rows[pos]);
+  ++batch.nrOfRows;
+}
+
+
+template<> void IndexValues<string>::Permute(IndexBatch &batch, const vector<unsigned long long> &order)
+{
+  StringVectorColumn sorted;
+  sorted.AllocateVec(order.size());
+  vector<double> sortedRows(order.size());
+
+  for (unsigned long long pos = 0; pos < order.size(); ++pos)
+  {
+    sorted.strings[pos].swap(batch.strings.strings[order[pos]]);
+    sorted.isNA[pos] = batch.strings.isNA[order[pos]];
+    sortedRows[pos] = batch.rows[order[pos]];
+  }
+
+  batch.strings.strings.swap(sorted.strings);
+  batch.strings.isNA.swap(sorted.isNA);
+  batch.rows.swap(sortedRows);
+}
+
+
+template<typename T>
+class EntryLess
+{
+  IndexBatch &batch;
+
+public:
+  EntryLess(IndexBatch &batch) : batch(batch) {}
+
+  bool operator()(unsigned long long posA, unsigned long long posB) const
+  {
+    return IndexValues<T>::Less(batch, posA, batch, posB);
+  }
+};
+
+
+// Sort the entries of a batch. Segments of the batch are sorted in parallel and merged pairwise, with the merges of
+// each round in parallel.
+template<typename T>
+void SortBatch(IndexBatch &batch, int nrOfThreads)
+{
+  unsigned long long nrOfEntries = batch.nrOfRows;
+  vector<unsigned long long> order(nrOfEntries);
+  iota(order.begin(), order.end(), 0ULL);
+
+  EntryLess<T> entryLess(batch);
+  int nrOfSegments = (int) min((unsigned long long) max(nrOfThreads, 1), 1 + nrOfEntries / 65536);
+
+  vector<unsigned long long> bounds(nrOfSegments + 1);
+  for (int segment = 0; segment <= nrOfSegments; ++segment)
+  {
+    bounds[segment] = nrOfEntries * segment / nrOfSegments;
+  }
+
+#pragma omp parallel for schedule(static) num_threads(nrOfSegments)
+  for (int segment = 0; segment < nrOfSegments; ++segment)
+  {
+    sort(order.begin() + bounds[segment], order.begin() + bounds[segment + 1], entryLess);
+  }
+
+  for (int width = 1; width < nrOfSegments; width *= 2)
+  {
+    int nrOfMerges = (nrOfSegments + 2 * width - 1) / (2 * width);
+
+#pragma omp parallel for schedule(static) num_threads(nrOfMerges)
+    for (int merge = 0; merge < nrOfMerges; ++merge)
+    {
+      int first = 2 * merge * width;
+      int middle = min(first + width, nrOfSegments);
+      int last = min(first + 2 * width, nrOfSegments);
+
+      if (middle < last)
+      {
+        inplace_merge(order.begin() + bounds[first], order.begin() + bounds[middle], order.begin() + bounds[last],
+          entryLess);
+      }
+    }
+  }
+
+  IndexValues<T>::Permute(batch, order);
+}
+
+
+// A sorted range of the rows of a file with index entries (a run or the current index), which is read in parts
+class MergeSource
+{
+public:
+  FstHandle* handle;
+  unsigned long long nextRow;  // first row of the file that is not read yet
+  unsigned long long endRow;
+  IndexBatch entries;          // entries that were read
+  unsigned long long pos;      // current entry
+
+  MergeSource(FstHandle* handle, unsigned long long firstRow, unsigned long long endRow, FstColumnType valueType) :
+    handle(handle), nextRow(firstRow), endRow(endRow), entries(valueType), pos(0) {}
+
+  // Read the next part of at most maxRows entries, returns false if all entries were read
+  bool Read(unsigned long long maxRows, int nrOfThreads)
+  {
+    entries.Clear();
+    pos = 0;
+
+    if (nextRow == endRow) return false;
+
+    vector<int> colIndex = { 0, 1 };
+    unsigned long long length = min(maxRows, endRow - nextRow);
+    IColumnFactory* columnFactory = handle->SetColumnFactory(&entries);
+
+    try
+    {
+      handle->ReadRows(entries, colIndex, nextRow, length, nrOfThreads);
+    }
+    catch (const std::runtime_error &)
+    {
+      handle->SetColumnFactory(columnFactory);
+      throw;
+    }
+
+    handle->SetColumnFactory(columnFactory);
+    nextRow += length;
+
+    return true;
+  }
+};
+
+
+// Orders the sources on their current entry, the source with the smallest entry is on top of the queue
+template<typename T>
+class SourceGreater
+{
+  vector<MergeSource*> *sources;
+
+public:
+  SourceGreater(vector<MergeSource*> &sources) : sources(&sources) {}
+
+  bool operator()(int sourceA, int sourceB) const
+  {
+    MergeSource &a = *(*sources)[sourceA];
+    MergeSource &b = *(*sources)[sourceB];
+
+    return IndexValues<T>::Less(b.entries, b.pos, a.entries, a.pos);
+  }
+};
+
+
+// Read the rows of the table that are not in the current index in batches and store each sorted batch as a data
+// chunk of the run file
+template<typename T>
+void WriteRuns(FstHandle &table, int colNr, FstColumnType valueType, unsigned long long firstRow,
+  unsigned long long batchRows, const char* runFileName, int compress, int nrOfThreads)
+{
+  IndexBatch batch(valueType);
+  FstWriter runWriter(runFileName, compress, nrOfThreads, &batch);
+  vector<int> colIndex(1, colNr);
+
+  for (unsigned long long row = firstRow; row < table.NrOfRows(); row += batchRows)
+  {
+    unsigned long long length = min(batchRows, table.NrOfRows() - row);
+
+    batch.Clear();
+    IColumnFactory* columnFactory = table.SetColumnFactory(&batch);
+
+    try
+    {
+      table.ReadRows(batch, colIndex, row, length, nrOfThreads);
+    }
+    catch (const std::runtime_error &)
+    {
+      table.SetColumnFactory(columnFactory);
+      throw;
+    }
+
+    table.SetColumnFactory(columnFactory);
+
+    batch.rows.resize(length);
+    for (unsigned long long pos = 0; pos < length; ++pos)
+    {
+      batch.rows[pos] = (double) (row + pos + 1);
+    }
+
+    SortBatch<T>(batch, nrOfThreads);
+    runWriter.WriteBatch(batch);
+  }
+
+  runWriter.Close();
+}
+
+
+// Merge the runs and the current index into the new index file
+template<typename T>
+void MergeRuns(FstHandle* runs, FstHandle* currentIndex, FstColumnType valueType, unsigned long long batchRows,
+  const char* indexFileName, int compress, int nrOfThreads)
+{
+  vector<MergeSource*> sources;
+
+  if (currentIndex != nullptr)
+  {
+    sources.push_back(new MergeSource(currentIndex, 0, currentIndex->NrOfRows(), valueType));
+  }
+
+  if (runs != nullptr)
+  {
+    for (unsigned int chunkNr = 0; chunkNr < runs->NrOfChunks(); ++chunkNr)
+    {
+      unsigned long long firstRow = runs->ChunkFirstRow(chunkNr);
+      sources.push_back(new MergeSource(runs, firstRow, firstRow + runs->ChunkNrOfRows(chunkNr), valueType));
+    }
+  }
+
+  // The sources share the memory of a single batch
+  unsigned long long sourceRows = max(1 + batchRows / sources.size(), (unsigned long long) 1024);
+
+  IndexBatch output(valueType);
+  FstWriter indexWriter(indexFileName, compress, nrOfThreads, &output);
+  indexWriter.SetSortedBatches(true);
+
+  try
+  {
+    SourceGreater<T> sourceGreater(sources);
+    priority_queue<int, vector<int>, SourceGreater<T> > queue(sourceGreater);
+
+    for (unsigned int sourceNr = 0; sourceNr < sources.size(); ++sourceNr)
+    {
+      if (sources[sourceNr]->Read(sourceRows, nrOfThreads)) queue.push(sourceNr);
+    }
+
+    while (!queue.empty())
+    {
+      int sourceNr = queue.top();
+      queue.pop();
+
+      MergeSource &source = *sources[sourceNr];
+      IndexValues<T>::Append(output, source.entries, source.pos);
+
+      if (output.nrOfRows == batchRows)
+      {
+        indexWriter.WriteBatch(output);
+        output.Clear();
+      }
+
+      if (++source.pos == source.entries.nrOfRows && !source.Read(sourceRows, nrOfThreads)) continue;
+
+      queue.push(sourceNr);
+    }
+
+    if (output.nrOfRows > 0) indexWriter.WriteBatch(output);
+
+    indexWriter.Close();
+  }
+  catch (const std::runtime_error &)
+  {
+    for (vector<MergeSource*>::iterator it = sources.begin(); it != sources.end(); ++it) delete *it;
+    throw;
+  }
+
+  for (vector<MergeSource*>::iterator it = sources.begin(); it != sources.end(); ++it) delete *it;
+}
+
+
+// Type of the value column of the index of a column
+FstColumnType IndexValueType(unsigned short int colType)
+{
+  switch (colType)
+  {
+    case 6:
+    case 7:
+      return FstColumnType::CHARACTER;
+
+    case 8:
+      return FstColumnType::INT_32;
+
+    case 9:
+      return FstColumnType::DOUBLE_64;
+
+    case 11:
+      return FstColumnType::INT_64;
+
+    case 12:
+      return FstColumnType::DATE_DAYS;
+
+    case 13:
+      return FstColumnType::TIMESTAMP_SECONDS;
+
+    default:
+      throw(runtime_error("Only character, factor, integer, double, integer64, date and timestamp columns can be "
+        "indexed."));
+  }
+}
+
+
+template<typename T>
+void BuildIndex(FstHandle &table, int colNr, FstColumnType valueType, FstHandle* currentIndex,
+  unsigned long long batchRows, const char* runFileName, const char* indexFileName, int compress, int nrOfThreads)
+{
+  unsigned long long firstRow = currentIndex == nullptr ? 0 : currentIndex->NrOfRows();
+
+  if (firstRow == table.NrOfRows())
+  {
+    MergeRuns<T>(nullptr, currentIndex, valueType, batchRows, indexFileName, compress, nrOfThreads);
+    return;
+  }
+
+  try
+  {
+    WriteRuns<T>(table, colNr, valueType, firstRow, batchRows, runFileName, compress, nrOfThreads);
+
+    IndexBatch columnFactory(valueType);  // creates the column names of the run file
+    FstFileInput runInput(runFileName);
+    FstHandle runs(runInput, &columnFactory);
+
+    if (!runs.Open())
+    {
+      throw(runtime_error("The temporary file of the index could not be read."));
+    }
+
+    MergeRuns<T>(&runs, currentIndex, valueType, batchRows, indexFileName, compress, nrOfThreads);
+  }
+  catch (const std::runtime_error &)
+  {
+    remove(runFileName);
+    throw;
+  }
+
+  remove(runFileName);
+}
+
+
+unsigned long long FstIndexer::Build(int colNr, FstHandle* currentIndex, const char* runFileName,
+  const char* indexFileName)
+{
+  if (fstHandle.NrOfRows() == 0)
+  {
+    throw(runtime_error("A table without rows can't be indexed."));
+  }
+
+  FstColumnType valueType = IndexValueType(fstHandle.ColumnType(colNr));
+
+  if (currentIndex != nullptr)
+  {
+    unsigned short int storedValueType = fstHandle.ColumnType(colNr) == 7 ? 6 : fstHandle.ColumnType(colNr);
+
+    if (currentIndex->NrOfColumns() != 2 || currentIndex->ColumnType(0) != storedValueType ||
+      currentIndex->ColumnType(1) != 9 || currentIndex->NrOfRows() > fstHandle.NrOfRows())
+    {
+      throw(runtime_error("The index doesn't match the column of the fst file, please rebuild the index."));
+    }
+  }
+
+  unsigned long long nrOfBatchRows = max(batchRows, (unsigned long long) 1);
+
+  switch (valueType)
+  {
+    case FstColumnType::CHARACTER:
+      BuildIndex<string>(fstHandle, colNr, valueType, currentIndex, nrOfBatchRows, runFileName, indexFileName,
+        compress, nrOfThreads);
+      break;
+
+    case FstColumnType::INT_32:
+      BuildIndex<int>(fstHandle, colNr, valueType, currentIndex, nrOfBatchRows, runFileName, indexFileName,
+        compress, nrOfThreads);
+      break;
+
+    case FstColumnType::INT_64:
+      BuildIndex<long long>(fstHandle, colNr, valueType, currentIndex, nrOfBatchRows, runFileName, indexFileName,
+        compress, nrOfThreads);
+      break;
+
+    default:  // double, date and timestamp
+      BuildIndex<double>(fstHandle, colNr, valueType, currentIndex, nrOfBatchRows, runFileName, indexFileName,
+        compress, nrOfThreads);
+      break;
+  }
+
+  return fstHandle.NrOfRows();
+}
@@ -0,0 +1,90 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_INDEX_H
+#define FST_INDEX_H
+
+
+#include <fsthandle.h>
+
+
+/**
+ Builds the secondary index of a column of a fst table. The index is a separate fst file with columns 'Value' and
+ 'Row' that holds the values of the indexed column sorted in increasing order (NA values first), each with the
+ 1-based row number of the value in the table. Equal values are sorted on row number. The index file is keyed on
+ 'Value', so a lookup of a value or a range of values is a row filter on a sorted column, for which the zone maps
+ of the index file skip all but the matching blocks. The matching row numbers are then read from the table as a
+ sparse row selection.
+
+ The index is built with an external merge sort: the rows are read in batches of batchRows rows, each batch is
+ sorted with multiple threads and stored as a data chunk (a sorted run) of a temporary fst file, and the runs are
+ merged in a single pass. Memory use is limited to about two batches, independent of the size of the table.
+ */
+class FstIndexer
+{
+  FstHandle &fstHandle;
+  int compress;
+  unsigned long long batchRows;
+  int nrOfThreads;
+
+public:
+  /**
+   @param fstHandle Opened table of which a column is indexed.
+   @param compress Compression level (0 - 100) of the index file.
+   @param batchRows Number of rows that are sorted in memory at a time.
+   @param nrOfThreads Number of threads used for decompressing, sorting and compressing.
+   */
+  FstIndexer(FstHandle &fstHandle, int compress, unsigned long long batchRows, int nrOfThreads) :
+    fstHandle(fstHandle), compress(compress), batchRows(batchRows), nrOfThreads(nrOfThreads) {}
+
+  /**
+   Build the index of a column, or update an existing index after rows were appended to the table. The rows that
+   are not in the current index are sorted and merged with the current index into a new index file.
+
+   @param colNr Column number of the indexed column. Character, factor, integer, double, 64-bit integer, date and
+     timestamp columns can be indexed, the values of a factor column are indexed as character values.
+   @param currentIndex Opened current index of the column, which holds the first rows of the table, or nullptr to
+     index all rows.
+   @param runFileName Path of the temporary file with the sorted runs, which is removed afterwards.
+   @param indexFileName Path of the new index file, which should differ from the file of the current index.
+   @return Number of rows of the new index, which is the number of rows of the table.
+   @throws runtime_error if the column can't be indexed or if the current index doesn't match the table.
+   */
+  unsigned long long Build(int colNr, FstHandle* currentIndex, const char* runFileName, const char* indexFileName);
+};
+
+
+#endif  // FST_INDEX_H
@@ -0,0 +1,1250 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <fstdefines.h>
+#include <fstio.h>
+
+
+using namespace std;
+
+
+streambuf::pos_type MemoryOutputStreamBuf::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+  if (!(which & ios_base::out)) return pos_type(off_type(-1));
+
+  off_type newPos;
+
+  if (dir == ios_base::beg) newPos = off - (off_type) basePos;
+  else if (dir == ios_base::cur) newPos = (off_type) pos + off;
+  else newPos = (off_type) size + off;
+
+  if (newPos < 0 || newPos > (off_type) size) return pos_type(off_type(-1));
+
+  pos = (unsigned long long) newPos;
+
+  return pos_type(newPos + (off_type) basePos);
+}
+
+
+streambuf::pos_type MemoryOutputStreamBuf::seekpos(pos_type newPos, ios_base::openmode which)
+{
+  return seekoff(off_type(newPos), ios_base::beg, which);
+}
+
+
+streamsize MemoryOutputStreamBuf::xsputn(const char* s, streamsize n)
+{
+  if (n <= 0) return 0;
+
+  unsigned long long endPos = pos + n;
+
+  if (endPos > buffer.size())
+  {
+    // Grow geometrically to keep the number of reallocations small
+    unsigned long long newCapacity = buffer.size() < 4096 ? 4096 : buffer.size();
+    while (newCapacity < endPos) newCapacity *= 2;
+    buffer.resize(newCapacity);
+  }
+
+  memcpy(&buffer[pos], s, n);
+  pos = endPos;
+  if (pos > size) size = pos;
+
+  return n;
+}
+
+
+streambuf::int_type MemoryOutputStreamBuf::overflow(int_type c)
+{
+  if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+
+  char ch = traits_type::to_char_type(c);
+  xsputn(&ch, 1);
+
+  return c;
+}
+
+
+// Write size bytes at a position of the file
+inline bool WriteAt(int fileDescriptor, const char* data, unsigned long long size, unsigned long long offset)
+{
+#ifdef _WIN32
+  // Only a single thread uses the file descriptor
+  if (_lseeki64(fileDescriptor, (__int64) offset, SEEK_SET) == -1) return false;
+#endif
+
+  while (size > 0)
+  {
+    unsigned long long nrOfBytes = min(size, 1ULL << 30);
+
+#ifdef _WIN32
+    int written = _write(fileDescriptor, data, (unsigned int) nrOfBytes);
+#else
+    ssize_t written = pwrite(fileDescriptor, data, (size_t) nrOfBytes, (off_t) offset);
+    if (written == -1 && errno == EINTR) continue;
+#endif
+
+    if (written <= 0) return false;
+
+    data += written;
+    size -= written;
+    offset += written;
+  }
+
+  return true;
+}
+
+
+// Read size bytes at a position of the file, returns the number of bytes read
+inline unsigned long long ReadAt(int fileDescriptor, char* data, unsigned long long size, unsigned long long offset)
+{
+  unsigned long long total = 0;
+
+  while (total < size)
+  {
+    unsigned long long nrOfBytes = min(size - total, 1ULL << 30);
+
+#ifdef _WIN32
+    // Only a single thread uses the file descriptor
+    if (_lseeki64(fileDescriptor, (__int64) (offset + total), SEEK_SET) == -1) break;
+    int bytesRead = _read(fileDescriptor, data + total, (unsigned int) nrOfBytes);
+#else
+    ssize_t bytesRead = pread(fileDescriptor, data + total, (size_t) nrOfBytes, (off_t) (offset + total));
+    if (bytesRead == -1 && errno == EINTR) continue;
+#endif
+
+    if (bytesRead <= 0) break;
+
+    total += bytesRead;
+  }
+
+  return total;
+}
+
+
+// Open a file descriptor that bypasses the page cache, returns -1 if direct I/O is not supported
+inline int OpenDirect(const char* fileName, int flags)
+{
+#if defined(O_DIRECT)
+  return open(fileName, flags | O_DIRECT);
+#elif defined(F_NOCACHE)
+  int fileDescriptor = open(fileName, flags);
+
+  if (fileDescriptor != -1 && fcntl(fileDescriptor, F_NOCACHE, 1) == -1)
+  {
+    close(fileDescriptor);
+    return -1;
+  }
+
+  return fileDescriptor;
+#else
+  return -1;
+#endif
+}
+
+
+inline void CloseFile(int fileDescriptor)
+{
+#ifdef _WIN32
+  _close(fileDescriptor);
+#else
+  close(fileDescriptor);
+#endif
+}
+
+
+// Start of a buffer of size bytes in memory, aligned for direct I/O
+inline char* AlignedBuffer(vector<char> &memory, unsigned long long size)
+{
+  memory.resize(size + DIRECT_IO_ALIGNMENT);
+  unsigned long long misalignment = reinterpret_cast<uintptr_t>(memory.data()) % DIRECT_IO_ALIGNMENT;
+
+  return memory.data() + (DIRECT_IO_ALIGNMENT - misalignment) % DIRECT_IO_ALIGNMENT;
+}
+
+
+PipelinedFileStreamBuf::PipelinedFileStreamBuf() : fileDescriptor(-1), directFile(-1), activeBuffer(0),
+  activeStart(0), activeSize(0), pos(0), endPos(0), busy(false), stopping(false), failed(false)
+{
+}
+
+
+bool PipelinedFileStreamBuf::Open(const char* fileName, bool directIO)
+{
+  Close();
+
+#ifdef _WIN32
+  fileDescriptor = _open(fileName, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+  fileDescriptor = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+#endif
+
+  if (fileDescriptor == -1) return false;
+
+  directFile = directIO ? OpenDirect(fileName, O_WRONLY) : -1;
+
+  char* bufferStart = AlignedBuffer(bufferMemory, (unsigned long long) WRITE_BUFFERS * WRITE_BUFFER_SIZE);
+  buffers.clear();
+  freeBuffers.clear();
+
+  for (int bufferNr = 0; bufferNr < WRITE_BUFFERS; ++bufferNr)
+  {
+    buffers.push_back(bufferStart + (unsigned long long) bufferNr * WRITE_BUFFER_SIZE);
+    if (bufferNr > 0) freeBuffers.push_back(bufferNr);
+  }
+
+  activeBuffer = 0;
+  activeStart = 0;
+  activeSize = 0;
+  pos = 0;
+  endPos = 0;
+  busy = false;
+  stopping = false;
+  failed = false;
+
+  ioThread = thread(&PipelinedFileStreamBuf::WriteRequests, this);
+
+  return true;
+}
+
+
+bool PipelinedFileStreamBuf::Close()
+{
+  if (fileDescriptor == -1) return false;
+
+  Submit();
+
+  {
+    unique_lock<mutex> lock(requestMutex);
+    stopping = true;
+    requestReady.notify_one();
+  }
+
+  ioThread.join();  // all queued requests are written
+
+#ifndef _WIN32
+  if (directFile != -1)
+  {
+    CloseFile(directFile);
+
+    // Remove the padding of the last direct write
+    if (ftruncate(fileDescriptor, (off_t) endPos) != 0) failed = true;
+  }
+#endif
+
+#ifdef _WIN32
+  if (_close(fileDescriptor) != 0) failed = true;
+#else
+  if (close(fileDescriptor) != 0) failed = true;
+#endif
+
+  fileDescriptor = -1;
+  directFile = -1;
+  buffers.clear();
+  vector<char>().swap(bufferMemory);
+
+  return !failed;
+}
+
+
+void PipelinedFileStreamBuf::Submit()
+{
+  if (activeSize == 0) return;
+
+  WriteRequest request;
+  request.offset = activeStart;
+  request.size = activeSize;
+  request.bufferNr = activeBuffer;
+
+  // A direct write is padded to whole aligned blocks, the unaligned tail is written again with the next buffer
+  unsigned long long tailSize = 0;
+
+  if (directFile != -1)
+  {
+    tailSize = activeSize % DIRECT_IO_ALIGNMENT;
+
+    if (tailSize > 0)
+    {
+      request.size = activeSize + DIRECT_IO_ALIGNMENT - tailSize;
+      memset(&buffers[activeBuffer][activeSize], 0, request.size - activeSize);
+    }
+  }
+
+  int previousBuffer = activeBuffer;
+
+  {
+    unique_lock<mutex> lock(requestMutex);
+    requests.push_back(std::move(request));
+    requestReady.notify_one();
+
+    // Wait for the write of an earlier buffer to complete
+    requestDone.wait(lock, [this] { return !freeBuffers.empty(); });
+
+    activeBuffer = freeBuffers.back();
+    freeBuffers.pop_back();
+  }
+
+  // The queued buffer is only read by the I/O thread
+  activeStart += activeSize - tailSize;
+  memcpy(buffers[activeBuffer], &buffers[previousBuffer][activeSize - tailSize], tailSize);
+  activeSize = tailSize;
+}
+
+
+void PipelinedFileStreamBuf::WriteRequests()
+{
+  unique_lock<mutex> lock(requestMutex);
+
+  while (true)
+  {
+    requestReady.wait(lock, [this] { return stopping || !requests.empty(); });
+
+    if (requests.empty()) return;  // closed
+
+    WriteRequest request = std::move(requests.front());
+    requests.pop_front();
+    busy = true;
+
+    lock.unlock();
+
+    // After a failed write, the remaining requests are skipped
+    if (!failed)
+    {
+      if (request.bufferNr == -1)
+      {
+        if (!WriteAt(fileDescriptor, request.data.data(), request.size, request.offset)) failed = true;
+      }
+      else
+      {
+        const char* data = buffers[request.bufferNr];
+
+        // A file system that refuses the direct write is written through the page cache
+        if ((directFile == -1 || !WriteAt(directFile, data, request.size, request.offset)) &&
+          !WriteAt(fileDescriptor, data, request.size, request.offset))
+        {
+          failed = true;
+        }
+      }
+    }
+
+    lock.lock();
+
+    if (request.bufferNr != -1) freeBuffers.push_back(request.bufferNr);
+    busy = false;
+    requestDone.notify_all();
+  }
+}
+
+
+streambuf::pos_type PipelinedFileStreamBuf::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+  if (!(which & ios_base::out) || fileDescriptor == -1) return pos_type(off_type(-1));
+
+  off_type newPos;
+
+  if (dir == ios_base::beg) newPos = off;
+  else if (dir == ios_base::cur) newPos = (off_type) pos + off;
+  else newPos = (off_type) endPos + off;
+
+  if (newPos < 0) return pos_type(off_type(-1));
+
+  pos = (unsigned long long) newPos;
+
+  return pos_type(newPos);
+}
+
+
+streambuf::pos_type PipelinedFileStreamBuf::seekpos(pos_type newPos, ios_base::openmode which)
+{
+  return seekoff(off_type(newPos), ios_base::beg, which);
+}
+
+
+streamsize PipelinedFileStreamBuf::xsputn(const char* s, streamsize n)
+{
+  if (n <= 0) return 0;
+  if (fileDescriptor == -1 || failed) return 0;
+
+  // A write beyond the end of the data fills the gap with zeros, so the active buffer always ends at endPos
+  if (pos > endPos)
+  {
+    unsigned long long writePos = pos;
+    vector<char> zeros((size_t) min(writePos - endPos, (unsigned long long) WRITE_BUFFER_SIZE));
+
+    pos = endPos;
+    while (pos < writePos)
+    {
+      if (xsputn(zeros.data(), (streamsize) min(writePos - pos, (unsigned long long) zeros.size())) == 0) return 0;
+    }
+  }
+
+  streamsize remain = n;
+
+  while (remain > 0)
+  {
+    unsigned long long nrOfBytes;
+
+    if (pos < activeStart)
+    {
+      // Rewrite of data in an earlier buffer
+      nrOfBytes = min((unsigned long long) remain, activeStart - pos);
+
+      WriteRequest request;
+      request.offset = pos;
+      request.size = nrOfBytes;
+      request.bufferNr = -1;
+      request.data.assign(s, s + nrOfBytes);
+
+      unique_lock<mutex> lock(requestMutex);
+      requests.push_back(std::move(request));
+      requestReady.notify_one();
+    }
+    else
+    {
+      unsigned long long bufferPos = pos - activeStart;
+
+      if (bufferPos == WRITE_BUFFER_SIZE)
+      {
+        Submit();
+        continue;
+      }
+
+      nrOfBytes = min((unsigned long long) remain, WRITE_BUFFER_SIZE - bufferPos);
+      memcpy(&buffers[activeBuffer][bufferPos], s, nrOfBytes);
+      activeSize = max(activeSize, bufferPos + nrOfBytes);
+    }
+
+    s += nrOfBytes;
+    remain -= nrOfBytes;
+    pos += nrOfBytes;
+  }
+
+  endPos = max(endPos, pos);
+
+  return n;
+}
+
+
+streambuf::int_type PipelinedFileStreamBuf::overflow(int_type c)
+{
+  if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+
+  char ch = traits_type::to_char_type(c);
+  if (xsputn(&ch, 1) != 1) return traits_type::eof();
+
+  return c;
+}
+
+
+int PipelinedFileStreamBuf::sync()
+{
+  if (fileDescriptor == -1) return -1;
+
+  Submit();
+
+  unique_lock<mutex> lock(requestMutex);
+  requestDone.wait(lock, [this] { return requests.empty() && !busy; });
+
+  return failed ? -1 : 0;
+}
+
+
+DirectFileStreamBuf::~DirectFileStreamBuf()
+{
+  if (fileDescriptor != -1) CloseFile(fileDescriptor);
+  if (directFile != -1) CloseFile(directFile);
+}
+
+
+bool DirectFileStreamBuf::Open(const char* fileName)
+{
+#ifdef _WIN32
+  fileDescriptor = _open(fileName, _O_RDONLY | _O_BINARY);
+  if (fileDescriptor == -1) return false;
+
+  fileSize = (unsigned long long) _lseeki64(fileDescriptor, 0, SEEK_END);
+#else
+  fileDescriptor = open(fileName, O_RDONLY);
+  if (fileDescriptor == -1) return false;
+
+  fileSize = (unsigned long long) lseek(fileDescriptor, 0, SEEK_END);
+#endif
+
+  directFile = OpenDirect(fileName, O_RDONLY);
+  pos = 0;
+
+  return true;
+}
+
+
+unsigned long long DirectFileStreamBuf::Read(char* data, unsigned long long size, unsigned long long offset)
+{
+  if (directFile == -1 || size < DIRECT_IO_MIN_READ) return ReadAt(fileDescriptor, data, size, offset);
+
+  if (buffer == nullptr) buffer = AlignedBuffer(bufferMemory, DIRECT_IO_BUFFER);
+
+  unsigned long long endPos = offset + size;
+  unsigned long long alignedEnd = endPos + (DIRECT_IO_ALIGNMENT - endPos % DIRECT_IO_ALIGNMENT) % DIRECT_IO_ALIGNMENT;
+  unsigned long long total = 0;
+
+  while (total < size)
+  {
+    // Aligned part of the range that fits in the buffer
+    unsigned long long position = offset + total;
+    unsigned long long alignedPos = position - position % DIRECT_IO_ALIGNMENT;
+    unsigned long long length = min((unsigned long long) DIRECT_IO_BUFFER, alignedEnd - alignedPos);
+
+    unsigned long long nrOfBytes = ReadAt(directFile, buffer, length, alignedPos);
+    unsigned long long skip = position - alignedPos;
+
+    if (nrOfBytes <= skip) break;
+
+    unsigned long long count = min(nrOfBytes - skip, size - total);
+    memcpy(data + total, buffer + skip, count);
+    total += count;
+
+    if (nrOfBytes < length) break;  // end of file
+  }
+
+  // A direct read that is refused by the file system is completed through the page cache
+  if (total < size) total += ReadAt(fileDescriptor, data + total, size - total, offset + total);
+
+  return total;
+}
+
+
+streambuf::pos_type DirectFileStreamBuf::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+  if (!(which & ios_base::in) || fileDescriptor == -1) return pos_type(off_type(-1));
+
+  off_type newPos;
+
+  if (dir == ios_base::beg) newPos = off;
+  else if (dir == ios_base::cur) newPos = (off_type) pos + off;
+  else newPos = (off_type) fileSize + off;
+
+  if (newPos < 0) return pos_type(off_type(-1));
+
+  pos = (unsigned long long) newPos;
+
+  return pos_type(newPos);
+}
+
+
+streambuf::pos_type DirectFileStreamBuf::seekpos(pos_type newPos, ios_base::openmode which)
+{
+  return seekoff(off_type(newPos), ios_base::beg, which);
+}
+
+
+streambuf::int_type DirectFileStreamBuf::underflow()
+{
+  char ch;
+  if (ReadAt(fileDescriptor, &ch, 1, pos) != 1) return traits_type::eof();
+
+  return traits_type::to_int_type(ch);
+}
+
+
+streambuf::int_type DirectFileStreamBuf::uflow()
+{
+  int_type c = underflow();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) ++pos;
+
+  return c;
+}
+
+
+streamsize DirectFileStreamBuf::xsgetn(char* s, streamsize n)
+{
+  if (n <= 0 || fileDescriptor == -1) return 0;
+
+  unsigned long long nrOfBytes = Read(s, (unsigned long long) n, pos);
+  pos += nrOfBytes;
+
+  return (streamsize) nrOfBytes;
+}
+
+
+static unsigned long long readPrefixSize = READ_PREFIX_SIZE;
+
+
+void SetReadPrefixSize(unsigned long long size)
+{
+  readPrefixSize = min(size, (unsigned long long) READ_PREFIX_MAX);
+}
+
+
+unsigned long long ReadPrefixSize()
+{
+  return readPrefixSize;
+}
+
+
+PrefixStreamBuf::PrefixStreamBuf(FstFileInput &input, const vector<char> &prefix, unsigned long long fileSize) :
+  input(input), prefix(prefix), fileSize(fileSize), fileStream(nullptr), position(0), filePos(0)
+{
+  char* start = const_cast<char*>(prefix.data());
+  setg(start, start, start + prefix.size());
+}
+
+
+unsigned long long PrefixStreamBuf::Position() const
+{
+  return gptr() == nullptr ? position : (unsigned long long) (gptr() - eback());
+}
+
+
+bool PrefixStreamBuf::LeavePrefix()
+{
+  if (gptr() != nullptr)
+  {
+    position = Position();
+    setg(nullptr, nullptr, nullptr);
+  }
+
+  if (fileStream != nullptr) return true;
+
+  fileStream = input.OpenFileStream();
+  filePos = 0;
+
+  return fileStream != nullptr;
+}
+
+
+bool PrefixStreamBuf::SyncFileStream()
+{
+  fileStream->clear();  // a read up to the end of the file sets the failbit
+
+  if (filePos == position) return true;
+
+  fileStream->seekg(position);
+  filePos = position;
+
+  return !fileStream->fail();
+}
+
+
+streambuf::pos_type PrefixStreamBuf::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+  if (!(which & ios_base::in)) return pos_type(off_type(-1));
+
+  off_type newPos;
+
+  if (dir == ios_base::beg) newPos = off;
+  else if (dir == ios_base::cur) newPos = (off_type) Position() + off;
+  else newPos = (off_type) fileSize + off;
+
+  if (newPos < 0) return pos_type(off_type(-1));
+
+  if ((unsigned long long) newPos < prefix.size())
+  {
+    char* start = const_cast<char*>(prefix.data());
+    setg(start, start + newPos, start + prefix.size());
+  }
+  else
+  {
+    setg(nullptr, nullptr, nullptr);
+    position = newPos;
+  }
+
+  return pos_type(newPos);
+}
+
+
+streambuf::pos_type PrefixStreamBuf::seekpos(pos_type pos, ios_base::openmode which)
+{
+  return seekoff(off_type(pos), ios_base::beg, which);
+}
+
+
+streambuf::int_type PrefixStreamBuf::underflow()
+{
+  if (gptr() != nullptr && gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+  if (!LeavePrefix() || !SyncFileStream()) return traits_type::eof();
+
+  return fileStream->peek();
+}
+
+
+streambuf::int_type PrefixStreamBuf::uflow()
+{
+  int_type c = underflow();
+
+  if (gptr() != nullptr || traits_type::eq_int_type(c, traits_type::eof())) return streambuf::uflow();
+
+  fileStream->get();
+  filePos = ++position;
+
+  return c;
+}
+
+
+streamsize PrefixStreamBuf::xsgetn(char* s, streamsize n)
+{
+  streamsize nrOfBytes = 0;
+
+  if (gptr() != nullptr)
+  {
+    nrOfBytes = min((streamsize) (egptr() - gptr()), n);
+    memcpy(s, gptr(), nrOfBytes);
+    gbump((int) nrOfBytes);
+  }
+
+  if (nrOfBytes == n || !LeavePrefix() || !SyncFileStream()) return nrOfBytes;
+
+  fileStream->read(s + nrOfBytes, n - nrOfBytes);
+  streamsize count = fileStream->gcount();
+
+  position += count;
+  filePos = position;
+
+  return nrOfBytes + count;
+}
+
+
+bool FstFileInput::ReadPrefix()
+{
+#ifdef _WIN32
+  int fileDescriptor = _open(fileName.c_str(), _O_RDONLY | _O_BINARY);
+  if (fileDescriptor == -1) return false;
+
+  fileSize = (unsigned long long) _lseeki64(fileDescriptor, 0, SEEK_END);
+#else
+  int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+  if (fileDescriptor == -1) return false;
+
+  fileSize = (unsigned long long) lseek(fileDescriptor, 0, SEEK_END);
+#endif
+
+  prefix.resize(min(prefixSize, fileSize));
+  prefix.resize(ReadAt(fileDescriptor, prefix.data(), prefix.size(), 0));
+  CloseFile(fileDescriptor);
+
+  return true;
+}
+
+
+istream* FstFileInput::OpenStream()
+{
+  if (prefixSize == 0) return OpenFileStream();
+
+  {
+    lock_guard<mutex> lock(prefixMutex);
+
+    if (!prefixRead)
+    {
+      if (!ReadPrefix()) return nullptr;
+      prefixRead = true;
+    }
+  }
+
+  // The complete file is in memory
+  if (prefix.size() == fileSize) return new MemoryInputStream(prefix.data(), prefix.size());
+
+  return new PrefixInputStream(*this, prefix, fileSize);
+}
+
+
+istream* FstFileInput::OpenFileStream()
+{
+  if (directIO)
+  {
+    DirectFileInputStream* directStream = new DirectFileInputStream();
+
+    if (!directStream->Open(fileName.c_str()))
+    {
+      delete directStream;
+      return nullptr;
+    }
+
+    return directStream;
+  }
+
+  FileInputStream* fileStream = new FileInputStream(fileName.c_str());
+
+  if (fileStream->fail())
+  {
+    delete fileStream;
+    return nullptr;
+  }
+
+  return fileStream;
+}
+
+
+FstFileInput::~FstFileInput()
+{
+#ifndef _WIN32
+  if (prefetchFile != -1) close(prefetchFile);
+#endif
+}
+
+
+void FstFileInput::Prefetch(unsigned long long offset, unsigned long long size)
+{
+  // The kernel reads the range asynchronously (POSIX_FADV_WILLNEED initiates read-ahead), other systems
+  // read the data on demand
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+  if (prefetchFile == -1) prefetchFile = open(fileName.c_str(), O_RDONLY);
+  if (prefetchFile == -1) return;
+
+  posix_fadvise(prefetchFile, (off_t) offset, (off_t) size, POSIX_FADV_WILLNEED);
+#endif
+}
+
+
+bool FstFileInput::FileIdentity(FstFileIdentity &identity)
+{
+#ifdef _WIN32
+  return false;  // processes are not forked
+#else
+  struct stat fileStat;
+  if (stat(fileName.c_str(), &fileStat) != 0) return false;
+
+  identity.device = (unsigned long long) fileStat.st_dev;
+  identity.inode = (unsigned long long) fileStat.st_ino;
+  identity.size = (unsigned long long) fileStat.st_size;
+
+#ifdef __APPLE__
+  identity.modified = (unsigned long long) fileStat.st_mtimespec.tv_sec * 1000000000ULL + fileStat.st_mtimespec.tv_nsec;
+#else
+  identity.modified = (unsigned long long) fileStat.st_mtim.tv_sec * 1000000000ULL + fileStat.st_mtim.tv_nsec;
+#endif
+
+  return true;
+#endif
+}
+
+
+istream* FstMappedFileInput::OpenStream()
+{
+  if (mappedFile.Data() == nullptr) return nullptr;
+
+  return new MemoryInputStream(mappedFile.Data(), mappedFile.Size());
+}
+
+
+unsigned long long PositionalStreamBuf::Position() const
+{
+  return bufferPos + (unsigned long long) (gptr() - eback());
+}
+
+
+streambuf::pos_type PositionalStreamBuf::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+  if (!(which & ios_base::in)) return pos_type(off_type(-1));
+
+  off_type newPos;
+
+  if (dir == ios_base::beg) newPos = off;
+  else if (dir == ios_base::cur) newPos = (off_type) Position() + off;
+  else newPos = (off_type) input.Size() + off;
+
+  if (newPos < 0) return pos_type(off_type(-1));
+
+  // The buffered data is kept when the new position is inside the get area
+  unsigned long long position = (unsigned long long) newPos;
+
+  if (position >= bufferPos && position <= bufferPos + (unsigned long long) (egptr() - eback()))
+  {
+    setg(eback(), eback() + (position - bufferPos), egptr());
+  }
+  else
+  {
+    bufferPos = position;
+    setg(buffer.data(), buffer.data(), buffer.data());
+  }
+
+  return pos_type(newPos);
+}
+
+
+streambuf::pos_type PositionalStreamBuf::seekpos(pos_type pos, ios_base::openmode which)
+{
+  return seekoff(off_type(pos), ios_base::beg, which);
+}
+
+
+streambuf::int_type PositionalStreamBuf::underflow()
+{
+  if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+  unsigned long long position = Position();
+
+  buffer.resize(POSITIONAL_READ_BUFFER);
+  unsigned long long nrOfBytes = input.Read(buffer.data(), buffer.size(), position);
+
+  bufferPos = position;
+  setg(buffer.data(), buffer.data(), buffer.data() + nrOfBytes);
+
+  if (nrOfBytes == 0) return traits_type::eof();
+
+  return traits_type::to_int_type(*gptr());
+}
+
+
+streamsize PositionalStreamBuf::xsgetn(char* s, streamsize n)
+{
+  streamsize nrOfBytes = 0;
+
+  while (nrOfBytes < n)
+  {
+    streamsize available = (streamsize) (egptr() - gptr());
+
+    if (available > 0)
+    {
+      streamsize count = min(available, n - nrOfBytes);
+      memcpy(s + nrOfBytes, gptr(), count);
+      gbump((int) count);
+      nrOfBytes += count;
+      continue;
+    }
+
+    // Large reads bypass the buffer
+    if (n - nrOfBytes >= POSITIONAL_READ_BUFFER)
+    {
+      unsigned long long position = Position();
+      unsigned long long count = input.Read(s + nrOfBytes, (unsigned long long) (n - nrOfBytes), position);
+
+      bufferPos = position + count;
+      setg(buffer.data(), buffer.data(), buffer.data());
+
+      return nrOfBytes + (streamsize) count;
+    }
+
+    if (traits_type::eq_int_type(underflow(), traits_type::eof())) break;
+  }
+
+  return nrOfBytes;
+}
+
+
+FstSharedFileInput::~FstSharedFileInput()
+{
+  if (fileDescriptor != -1) CloseFile(fileDescriptor);
+}
+
+
+bool FstSharedFileInput::Open(const char* fileName)
+{
+  if (fileDescriptor != -1) CloseFile(fileDescriptor);
+
+#ifdef _WIN32
+  fileDescriptor = _open(fileName, _O_RDONLY | _O_BINARY);
+  if (fileDescriptor == -1) return false;
+
+  fileSize = (unsigned long long) _lseeki64(fileDescriptor, 0, SEEK_END);
+#else
+  fileDescriptor = open(fileName, O_RDONLY);
+  if (fileDescriptor == -1) return false;
+
+  fileSize = (unsigned long long) lseek(fileDescriptor, 0, SEEK_END);
+#endif
+
+  return true;
+}
+
+
+istream* FstSharedFileInput::OpenStream()
+{
+  if (fileDescriptor == -1) return nullptr;
+
+  return new PositionalInputStream(*this);
+}
+
+
+unsigned long long FstSharedFileInput::Read(char* data, unsigned long long size, unsigned long long offset)
+{
+#ifdef _WIN32
+  lock_guard<mutex> lock(readMutex);  // the file descriptor has a single seek pointer
+#endif
+
+  return ReadAt(fileDescriptor, data, size, offset);
+}
+
+
+void FstSharedFileInput::Prefetch(unsigned long long offset, unsigned long long size)
+{
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+  if (fileDescriptor != -1) posix_fadvise(fileDescriptor, (off_t) offset, (off_t) size, POSIX_FADV_WILLNEED);
+#endif
+}
+
+
+bool FstSharedFileInput::FileIdentity(FstFileIdentity &identity)
+{
+#ifdef _WIN32
+  return false;  // processes are not forked
+#else
+  struct stat fileStat;
+  if (fileDescriptor == -1 || fstat(fileDescriptor, &fileStat) != 0) return false;
+
+  identity.device = (unsigned long long) fileStat.st_dev;
+  identity.inode = (unsigned long long) fileStat.st_ino;
+  identity.size = (unsigned long long) fileStat.st_size;
+
+#ifdef __APPLE__
+  identity.modified = (unsigned long long) fileStat.st_mtimespec.tv_sec * 1000000000ULL + fileStat.st_mtimespec.tv_nsec;
+#else
+  identity.modified = (unsigned long long) fileStat.st_mtim.tv_sec * 1000000000ULL + fileStat.st_mtim.tv_nsec;
+#endif
+
+  return true;
+#endif
+}
+
+
+istream* FstMemoryInput::OpenStream()
+{
+  if (data == nullptr) return nullptr;
+
+  return new MemoryInputStream(data, size);
+}
+
+
+ostream* FstFileOutput::Open()
+{
+  delete fileStream;
+  delete fileBuf;
+  fileStream = nullptr;
+  fileBuf = nullptr;
+
+  if (!seekable)
+  {
+    FileOutputStream* outputStream = new FileOutputStream(fileName.c_str());
+
+    if (outputStream->fail())
+    {
+      delete outputStream;
+      return nullptr;
+    }
+
+    fileStream = outputStream;
+
+    return fileStream;
+  }
+
+  fileBuf = new PipelinedFileStreamBuf();
+
+  if (!fileBuf->Open(fileName.c_str(), directIO))
+  {
+    delete fileBuf;
+    fileBuf = nullptr;
+    return nullptr;
+  }
+
+  fileStream = new ostream(fileBuf);
+
+  return fileStream;
+}
+
+
+bool FstFileOutput::Close()
+{
+  if (fileStream == nullptr) return false;
+
+  bool success;
+
+  if (fileBuf == nullptr)
+  {
+    static_cast<FileOutputStream*>(fileStream)->close();
+    success = !fileStream->fail();
+  }
+  else
+  {
+    success = !fileStream->fail();
+    success = fileBuf->Close() && success;
+  }
+
+  delete fileStream;
+  delete fileBuf;
+  fileStream = nullptr;
+  fileBuf = nullptr;
+
+  return success;
+}
+
+
+ostream* FstMemoryOutput::Open()
+{
+  memoryBuf.Clear();
+  memoryStream.clear();
+
+  return &memoryStream;
+}
+
+
+// Reads, writes and seeks are timed as I/O of the column (or metadata) selected on the current thread, so the total
+// I/O time of an operation is the sum of the I/O times of its columns and metadata
+streambuf::pos_type ProfiledStreamBuf::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+  if (dir == ios_base::cur && off == 0) return target->pubseekoff(off, dir, which);  // tellg or tellp
+
+  ProfileTimer timer(ProfilePhase::IO);
+  profile->seeks.fetch_add(1, memory_order_relaxed);
+
+  return target->pubseekoff(off, dir, which);
+}
+
+
+streambuf::pos_type ProfiledStreamBuf::seekpos(pos_type newPos, ios_base::openmode which)
+{
+  ProfileTimer timer(ProfilePhase::IO);
+  profile->seeks.fetch_add(1, memory_order_relaxed);
+
+  return target->pubseekpos(newPos, which);
+}
+
+
+streambuf::int_type ProfiledStreamBuf::underflow()
+{
+  ProfileTimer timer(ProfilePhase::IO);
+
+  return target->sgetc();
+}
+
+
+streambuf::int_type ProfiledStreamBuf::uflow()
+{
+  ProfileTimer timer(ProfilePhase::IO);
+  int_type c = target->sbumpc();
+
+  if (!traits_type::eq_int_type(c, traits_type::eof()))
+  {
+    profile->bytesRead.fetch_add(1, memory_order_relaxed);
+    ProfileBytes(1);
+  }
+
+  return c;
+}
+
+
+streamsize ProfiledStreamBuf::xsgetn(char* s, streamsize n)
+{
+  ProfileTimer timer(ProfilePhase::IO);
+  streamsize nrOfBytes = target->sgetn(s, n);
+
+  profile->bytesRead.fetch_add(nrOfBytes, memory_order_relaxed);
+  ProfileBytes(nrOfBytes);
+
+  return nrOfBytes;
+}
+
+
+streamsize ProfiledStreamBuf::xsputn(const char* s, streamsize n)
+{
+  ProfileTimer timer(ProfilePhase::IO);
+  streamsize nrOfBytes = target->sputn(s, n);
+
+  profile->bytesWritten.fetch_add(nrOfBytes, memory_order_relaxed);
+  ProfileBytes(nrOfBytes);
+
+  return nrOfBytes;
+}
+
+
+streambuf::int_type ProfiledStreamBuf::overflow(int_type c)
+{
+  if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+
+  char ch = traits_type::to_char_type(c);
+  if (xsputn(&ch, 1) != 1) return traits_type::eof();
+
+  return c;
+}
+
+
+int ProfiledStreamBuf::sync()
+{
+  ProfileTimer timer(ProfilePhase::IO);
+
+  return target->pubsync();
+}
+
+
+istream* FstProfiledInput::OpenStream()
+{
+  istream* stream = input.OpenStream();
+
+  if (stream == nullptr) return nullptr;
+
+  return new ProfiledInputStream(stream, profile);
+}
+
+
+ostream* FstProfiledOutput::Open()
+{
+  delete profiledStream;
+  delete profiledBuf;
+  profiledStream = nullptr;
+  profiledBuf = nullptr;
+
+  ostream* stream = output.Open();
+
+  if (stream == nullptr) return nullptr;
+
+  profiledBuf = new ProfiledStreamBuf(stream->rdbuf(), profile);
+  profiledStream = new ostream(profiledBuf);
+
+  return profiledStream;
+}
+
+
+bool FstProfiledOutput::Close()
+{
+  bool success = profiledStream != nullptr && !profiledStream->fail();
+
+  if (profiledStream != nullptr) profiledStream->flush();
+
+  return output.Close() && success;
+}
@@ -0,0 +1,627 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_IO_H
+#define FST_IO_H
+
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ifstio.h>
+#include <fstmmap.h>
+#include <profile.h>
+
+
+// Input stream on top of a block of memory
+class MemoryInputStream : public std::istream
+{
+  MemoryStreamBuf memoryBuf;
+
+public:
+  MemoryInputStream(const char* data, unsigned long long size) : std::istream(nullptr), memoryBuf(data, size)
+  {
+    rdbuf(&memoryBuf);
+  }
+};
+
+
+// Growable, seekable output stream buffer in memory. Data written beyond the current end extends the buffer.
+class MemoryOutputStreamBuf : public std::streambuf
+{
+  std::vector<char> buffer;
+  unsigned long long pos;      // current write position
+  unsigned long long size;     // number of bytes written
+  unsigned long long basePos;  // stream position of the first byte in the buffer
+
+public:
+  MemoryOutputStreamBuf() : pos(0), size(0), basePos(0) {}
+
+  const char* Data() const { return buffer.data(); }
+
+  unsigned long long Size() const { return size; }
+
+  void Clear() { pos = 0; size = 0; basePos = 0; }
+
+  // Stream positions (tellp, seekp) are reported relative to basePos. This allows data to be buffered
+  // before it is appended to another stream at position basePos.
+  void SetBasePosition(unsigned long long basePosition) { basePos = basePosition; }
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::out);
+
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::out);
+
+  std::streamsize xsputn(const char* s, std::streamsize n);
+
+  int_type overflow(int_type c);
+};
+
+
+// File input stream using a small local buffer
+class FileInputStream : public std::ifstream
+{
+  char ioBuf[4096];
+
+public:
+  FileInputStream(const char* fileName)
+  {
+    rdbuf()->pubsetbuf(ioBuf, 4096);
+    open(fileName, std::ios::binary);
+  }
+};
+
+
+// File output stream using a small local buffer
+class FileOutputStream : public std::ofstream
+{
+  char ioBuf[4096];
+
+public:
+  FileOutputStream(const char* fileName)
+  {
+    rdbuf()->pubsetbuf(ioBuf, 4096);  // workaround for memory leak in ofstream
+    open(fileName, std::ios::binary);
+  }
+};
+
+
+// Output stream buffer of a file that is written by a dedicated I/O thread. Written data is collected in large
+// output buffers and a full buffer is written (with pwrite) by the I/O thread while the next buffer is filled, so
+// compression of the next blocks overlaps the write of the previous blocks. Seeks don't flush the buffers: data that
+// is rewritten (block indexes and chunk indexes) in the active buffer is updated in place and earlier data is
+// rewritten by a positional write that is queued after the write of the original data.
+//
+// With direct I/O, the output buffers are written with a second file descriptor that bypasses the page cache
+// (O_DIRECT). These writes start at an aligned file position and are padded to a multiple of the alignment: the
+// unaligned tail of a partially filled buffer is copied to the next buffer and written again with the data that
+// follows. The file is truncated to the size of the data when it's closed. Rewrites of earlier data are small and
+// use the buffered file descriptor.
+class PipelinedFileStreamBuf : public std::streambuf
+{
+  // A single positional write of the I/O thread
+  struct WriteRequest
+  {
+    unsigned long long offset;  // position in the file
+    unsigned long long size;    // number of bytes
+    int bufferNr;               // output buffer with the data or -1 if the data is owned by the request
+    std::vector<char> data;
+  };
+
+  int fileDescriptor;
+  int directFile;                  // file descriptor of the output buffers with direct I/O, -1 otherwise
+  std::vector<char> bufferMemory;
+  std::vector<char*> buffers;      // aligned output buffers
+  std::vector<int> freeBuffers;    // output buffers that are not used or queued
+  int activeBuffer;                // output buffer that is filled
+  unsigned long long activeStart;  // file position of the first byte of the active buffer
+  unsigned long long activeSize;   // number of bytes in the active buffer
+  unsigned long long pos;          // current write position
+  unsigned long long endPos;       // end of the written data
+
+  std::deque<WriteRequest> requests;  // queued writes, in order
+  bool busy;                          // the I/O thread is writing
+  bool stopping;
+  std::atomic<bool> failed;
+  std::mutex requestMutex;
+  std::condition_variable requestReady;
+  std::condition_variable requestDone;
+  std::thread ioThread;
+
+  // Queue the active buffer and continue with a free buffer
+  void Submit();
+
+  // Write queued requests until the buffer is closed
+  void WriteRequests();
+
+public:
+  PipelinedFileStreamBuf();
+
+  ~PipelinedFileStreamBuf() { Close(); }
+
+  // Create or truncate the file and start the I/O thread. Returns false if the file could not be opened. If direct
+  // I/O is requested but not supported by the file system, the file is written through the page cache.
+  bool Open(const char* fileName, bool directIO = false);
+
+  // Write all data and close the file. Returns false if the data could not be written completely.
+  bool Close();
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::out);
+
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::out);
+
+  std::streamsize xsputn(const char* s, std::streamsize n);
+
+  int_type overflow(int_type c);
+
+  // Waits until all data is written
+  int sync();
+};
+
+
+// Unbuffered input stream buffer of a file that reads large ranges with direct I/O (O_DIRECT), bypassing the page
+// cache. Large reads are done in aligned parts through an aligned buffer, smaller reads (the header, block indexes
+// and other metadata) use a second file descriptor that reads through the page cache.
+class DirectFileStreamBuf : public std::streambuf
+{
+  int fileDescriptor;
+  int directFile;  // -1 if direct I/O is not supported
+  unsigned long long pos;
+  unsigned long long fileSize;
+  std::vector<char> bufferMemory;
+  char* buffer;    // aligned buffer of the direct reads
+
+  // Read size bytes at position offset, returns the number of bytes read
+  unsigned long long Read(char* data, unsigned long long size, unsigned long long offset);
+
+public:
+  DirectFileStreamBuf() : fileDescriptor(-1), directFile(-1), pos(0), fileSize(0), buffer(nullptr) {}
+
+  ~DirectFileStreamBuf();
+
+  // Returns false if the file could not be opened
+  bool Open(const char* fileName);
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in);
+
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in);
+
+  int_type underflow();
+
+  int_type uflow();
+
+  std::streamsize xsgetn(char* s, std::streamsize n);
+};
+
+
+// File input stream that reads large ranges with direct I/O
+class DirectFileInputStream : public std::istream
+{
+  DirectFileStreamBuf directBuf;
+
+public:
+  DirectFileInputStream() : std::istream(nullptr)
+  {
+    rdbuf(&directBuf);
+  }
+
+  bool Open(const char* fileName) { return directBuf.Open(fileName); }
+};
+
+
+// Set the number of bytes at the start of a file that are read with a single read when a file input is first
+// opened (see FstFileInput). Use 0 to read all data of a file on demand.
+void SetReadPrefixSize(unsigned long long size);
+
+unsigned long long ReadPrefixSize();
+
+
+class FstFileInput;
+
+
+// Input stream buffer of a file of which the first bytes (the prefix) are kept in memory. Reads in the prefix are
+// copied from memory, reads beyond the prefix are passed to a stream of the file that is opened on first use. The
+// header, column names and indexes of a small file are parsed from the prefix without further file access.
+class PrefixStreamBuf : public std::streambuf
+{
+  FstFileInput &input;
+  const std::vector<char> &prefix;
+  unsigned long long fileSize;
+  std::istream* fileStream;     // stream of the data beyond the prefix, nullptr until it's first used
+  unsigned long long position;  // read position when it's beyond the prefix
+  unsigned long long filePos;   // position of fileStream
+
+  unsigned long long Position() const;
+
+  // Continue beyond the prefix, returns false if the file could not be opened
+  bool LeavePrefix();
+
+  // Position the file stream at the read position
+  bool SyncFileStream();
+
+public:
+  PrefixStreamBuf(FstFileInput &input, const std::vector<char> &prefix, unsigned long long fileSize);
+
+  ~PrefixStreamBuf() { delete fileStream; }
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in);
+
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in);
+
+  int_type underflow();
+
+  int_type uflow();
+
+  std::streamsize xsgetn(char* s, std::streamsize n);
+};
+
+
+// File input stream of which the prefix is read from memory
+class PrefixInputStream : public std::istream
+{
+  PrefixStreamBuf prefixBuf;
+
+public:
+  PrefixInputStream(FstFileInput &input, const std::vector<char> &prefix, unsigned long long fileSize) :
+    std::istream(nullptr), prefixBuf(input, prefix, fileSize)
+  {
+    rdbuf(&prefixBuf);
+  }
+};
+
+
+// Read a fst file through buffered file streams, or with direct I/O for large ranges. When the first stream is
+// opened, the first ReadPrefixSize() bytes of the file are read with a single read and shared by all streams of
+// the input (see PrefixStreamBuf). Files that fit in the prefix are read from memory completely.
+class FstFileInput : public IFstInput
+{
+  std::string fileName;
+  int prefetchFile;  // file descriptor used for prefetch hints, opened on first use
+  bool directIO;
+  unsigned long long prefixSize;  // requested size of the prefix, 0 for no prefix
+  bool prefixRead;                // the prefix has been read
+  std::vector<char> prefix;       // first bytes of the file
+  unsigned long long fileSize;
+  std::mutex prefixMutex;
+
+  // Read the prefix and the size of the file, returns false if the file could not be opened
+  bool ReadPrefix();
+
+public:
+  FstFileInput(const char* fileName) : fileName(fileName), prefetchFile(-1), directIO(false),
+    prefixSize(ReadPrefixSize()), prefixRead(false), fileSize(0) {}
+
+  // Use directIO = true to read large ranges of the file without filling the page cache
+  FstFileInput(const char* fileName, bool directIO) : fileName(fileName), prefetchFile(-1), directIO(directIO),
+    prefixSize(ReadPrefixSize()), prefixRead(false), fileSize(0) {}
+
+  ~FstFileInput();
+
+  std::istream* OpenStream();
+
+  // Returns a new stream on the file that doesn't use the prefix or nullptr on failure
+  std::istream* OpenFileStream();
+
+  // Prefetched data would be read into the page cache
+  bool CanPrefetch() { return !directIO; }
+
+  void Prefetch(unsigned long long offset, unsigned long long size);
+
+  bool FileIdentity(FstFileIdentity &identity);
+};
+
+
+// Read a fst file through a memory mapping of the complete file, shared by all streams
+class FstMappedFileInput : public IFstInput
+{
+  MemoryMappedFile mappedFile;
+
+public:
+  // Returns false if the file could not be mapped
+  bool Open(const char* fileName) { return mappedFile.Open(fileName); }
+
+  std::istream* OpenStream();
+
+  bool CanPrefetch() { return true; }
+
+  void Prefetch(unsigned long long offset, unsigned long long size) { mappedFile.Prefetch(offset, size); }
+};
+
+
+class FstSharedFileInput;
+
+
+// Buffered input stream buffer of a file that is shared with other streams. Data is read with positional reads at
+// the read position of the stream, there is no seek pointer that is shared with the other streams of the file.
+// Reads of at least POSITIONAL_READ_BUFFER bytes bypass the buffer.
+class PositionalStreamBuf : public std::streambuf
+{
+  FstSharedFileInput &input;
+  std::vector<char> buffer;
+  unsigned long long bufferPos;  // file position of the first byte in the get area
+
+  unsigned long long Position() const;
+
+public:
+  PositionalStreamBuf(FstSharedFileInput &input) : input(input), bufferPos(0) {}
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in);
+
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in);
+
+  int_type underflow();
+
+  std::streamsize xsgetn(char* s, std::streamsize n);
+};
+
+
+// Input stream of a file that is shared with other streams
+class PositionalInputStream : public std::istream
+{
+  PositionalStreamBuf positionalBuf;
+
+public:
+  PositionalInputStream(FstSharedFileInput &input) : std::istream(nullptr), positionalBuf(input)
+  {
+    rdbuf(&positionalBuf);
+  }
+};
+
+
+// Read a fst file through a single file descriptor that is opened with the input and shared by all streams (see
+// PositionalStreamBuf). Opening a stream doesn't access the file and the streams of the input can be read from any
+// number of threads concurrently, so the input can be shared by the concurrent reads of a FstSharedHandle. On
+// systems without positional reads (Windows), the reads of the streams are serialized.
+class FstSharedFileInput : public IFstInput
+{
+  int fileDescriptor;
+  unsigned long long fileSize;
+
+#ifdef _WIN32
+  std::mutex readMutex;
+#endif
+
+public:
+  FstSharedFileInput() : fileDescriptor(-1), fileSize(0) {}
+
+  ~FstSharedFileInput();
+
+  // Returns false if the file could not be opened
+  bool Open(const char* fileName);
+
+  std::istream* OpenStream();
+
+  bool CanPrefetch() { return true; }
+
+  void Prefetch(unsigned long long offset, unsigned long long size);
+
+  bool FileIdentity(FstFileIdentity &identity);
+
+  // Read size bytes at position offset of the file, returns the number of bytes read. Can be called from multiple
+  // threads simultaneously.
+  unsigned long long Read(char* data, unsigned long long size, unsigned long long offset);
+
+  unsigned long long Size() const { return fileSize; }
+};
+
+
+// Read a fst file from a block of memory that contains the complete file image. The memory is not owned.
+class FstMemoryInput : public IFstInput
+{
+  const char* data;
+  unsigned long long size;
+
+public:
+  FstMemoryInput(const char* data, unsigned long long size) : data(data), size(size) {}
+
+  std::istream* OpenStream();
+};
+
+
+// Write a fst file. The file is created when the output is opened. A seekable file is written with pipelined
+// writes (see PipelinedFileStreamBuf), other files through a buffered file stream.
+class FstFileOutput : public IFstOutput
+{
+  std::string fileName;
+  std::ostream* fileStream;
+  PipelinedFileStreamBuf* fileBuf;  // stream buffer of a seekable file
+  bool seekable;
+  bool directIO;
+
+public:
+  FstFileOutput(const char* fileName) : fileName(fileName), fileStream(nullptr), fileBuf(nullptr), seekable(true),
+    directIO(false) {}
+
+  // Use seekable = false for files that can only be written sequentially, such as named pipes. With directIO = true,
+  // a seekable file is written without filling the page cache.
+  FstFileOutput(const char* fileName, bool seekable, bool directIO = false) : fileName(fileName), fileStream(nullptr),
+    fileBuf(nullptr), seekable(seekable), directIO(directIO) {}
+
+  ~FstFileOutput() { delete fileStream; delete fileBuf; }
+
+  std::ostream* Open();
+
+  bool Close();
+
+  bool IsSeekable() { return seekable; }
+};
+
+
+// Write a fst file to an existing stream that can only be written sequentially (a pipe or socket stream).
+// The stream is not owned and is flushed (not closed) on Close.
+class FstStreamOutput : public IFstOutput
+{
+  std::ostream &outputStream;
+
+public:
+  FstStreamOutput(std::ostream &outputStream) : outputStream(outputStream) {}
+
+  std::ostream* Open() { return &outputStream; }
+
+  bool Close() { outputStream.flush(); return !outputStream.fail(); }
+
+  bool IsSeekable() { return false; }
+};
+
+
+// Write a fst file to a growable memory buffer
+class FstMemoryOutput : public IFstOutput
+{
+  MemoryOutputStreamBuf memoryBuf;
+  std::ostream memoryStream;
+
+public:
+  FstMemoryOutput() : memoryStream(&memoryBuf) {}
+
+  std::ostream* Open();
+
+  bool Close() { return !memoryStream.fail(); }
+
+  bool IsSeekable() { return true; }
+
+  // Start of the serialized fst data
+  const char* Data() const { return memoryBuf.Data(); }
+
+  // Size of the serialized fst data in bytes
+  unsigned long long Size() const { return memoryBuf.Size(); }
+};
+
+
+// Unbuffered stream buffer that passes all reads, writes and seeks to a target stream buffer, counting the bytes,
+// seeks and time of the file access for a profile (see FstProfile). Position requests (tellg and tellp) are not
+// counted as seeks.
+class ProfiledStreamBuf : public std::streambuf
+{
+  std::streambuf* target;
+  FstProfile* profile;
+
+public:
+  ProfiledStreamBuf(std::streambuf* target, FstProfile* profile) : target(target), profile(profile) {}
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+  int_type underflow();
+
+  int_type uflow();
+
+  std::streamsize xsgetn(char* s, std::streamsize n);
+
+  std::streamsize xsputn(const char* s, std::streamsize n);
+
+  int_type overflow(int_type c);
+
+  int sync();
+};
+
+
+// Input stream on top of a stream of another input, counting its file access
+class ProfiledInputStream : public std::istream
+{
+  std::istream* stream;
+  ProfiledStreamBuf profiledBuf;
+
+public:
+  ProfiledInputStream(std::istream* stream, FstProfile* profile) : std::istream(nullptr), stream(stream),
+    profiledBuf(stream->rdbuf(), profile)
+  {
+    rdbuf(&profiledBuf);
+  }
+
+  ~ProfiledInputStream() { delete stream; }
+};
+
+
+// Counts the file access of the streams of another input for a profile
+class FstProfiledInput : public IFstInput
+{
+  IFstInput &input;
+  FstProfile* profile;
+
+public:
+  FstProfiledInput(IFstInput &input, FstProfile* profile) : input(input), profile(profile) {}
+
+  std::istream* OpenStream();
+
+  bool ConcurrentStreams() { return input.ConcurrentStreams(); }
+
+  bool CanPrefetch() { return input.CanPrefetch(); }
+
+  void Prefetch(unsigned long long offset, unsigned long long size) { input.Prefetch(offset, size); }
+
+  void PrefetchRanges(const std::vector<std::pair<unsigned long long, unsigned long long>> &ranges)
+  {
+    input.PrefetchRanges(ranges);
+  }
+
+  bool FileIdentity(FstFileIdentity &identity) { return input.FileIdentity(identity); }
+};
+
+
+// Counts the file access of the stream of another output for a profile
+class FstProfiledOutput : public IFstOutput
+{
+  IFstOutput &output;
+  FstProfile* profile;
+  ProfiledStreamBuf* profiledBuf;
+  std::ostream* profiledStream;
+
+public:
+  FstProfiledOutput(IFstOutput &output, FstProfile* profile) : output(output), profile(profile),
+    profiledBuf(nullptr), profiledStream(nullptr) {}
+
+  ~FstProfiledOutput() { delete profiledStream; delete profiledBuf; }
+
+  std::ostream* Open();
+
+  bool Close();
+
+  bool IsSeekable() { return output.IsSeekable(); }
+};
+
+
+#endif  // FST_IO_H
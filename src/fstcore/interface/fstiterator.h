@@ -0,0 +1,107 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_ITERATOR_H
+#define FST_ITERATOR_H
+
+
+#include <vector>
+
+#include <icolumnfactory.h>
+#include <ifsttable.h>
+#include <ifstio.h>
+#include <fsthandle.h>
+
+
+/**
+ Reads a fst file in consecutive ranges of rows. The table metadata is parsed only once by the underlying
+ FstHandle when the iterator is opened, so reading the rows of a file in a sequence of batches requires no
+ additional metadata reads.
+ */
+class FstIterator
+{
+  FstHandle fstHandle;
+
+  std::vector<int> colIndex;  // selected columns
+  unsigned long long currentRow;
+
+public:
+  /**
+   Create an iterator on a fst input. The input should remain valid during the lifetime of the iterator.
+
+   @param input Source of the fst data.
+   @param columnFactory Factory used to create column vectors (only used from the calling thread).
+   */
+  FstIterator(IFstInput &input, IColumnFactory* columnFactory) : fstHandle(input, columnFactory), currentRow(0) {}
+
+  /**
+   Parse the table metadata and the chunkset index of the input.
+
+   @param columnSelection Names of the selected columns or nullptr for all columns.
+   @return false if the input uses the deprecated (pre v0.7.3) file format, which can't be iterated.
+   */
+  bool Open(IStringArray* columnSelection);
+
+  /**
+   Total number of rows in the table.
+   */
+  unsigned long long NrOfRows() { return fstHandle.NrOfRows(); }
+
+  /**
+   First row (0-based) that is returned by the next call to NextBatch.
+   */
+  unsigned long long CurrentRow() { return currentRow; }
+
+  /**
+   Read the next batch of rows and advance the iterator.
+
+   @param tableReader Table that receives the column vectors, left untouched when all rows have been read.
+   @param batchRows Maximum number of rows in the batch.
+   @param nrOfThreads Number of threads available for decompressing columns in parallel.
+   @return Number of rows read, 0 when all rows have been read.
+   */
+  unsigned long long NextBatch(IFstTableReader &tableReader, unsigned long long batchRows, int nrOfThreads);
+
+  /**
+   Names of the selected columns and the positions of the key columns among them.
+   */
+  void SelectedColumns(IStringArray* selectedCols, std::vector<int> &keyIndex)
+  {
+    fstHandle.SelectedColumns(colIndex, selectedCols, keyIndex);
+  }
+};
+
+
+#endif  // FST_ITERATOR_H
@@ -0,0 +1,379 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <ifsttable.h>
+#include <icolumnfactory.h>
+
+#include <fstdefines.h>
+#include <fsthandle.h>
+#include <fstjoin.h>
+#include <fstwriter.h>
+#include <rowbatch.h>
+
+
+using namespace std;
+
+
+// Join columns of the consecutive parts of a table, walked in key order
+class JoinSource
+{
+public:
+  FstHandle &table;
+  const vector<int> &keyCols;  // column numbers of the join columns
+  unsigned long long partRow;  // first row of the part that was read
+  unsigned long long nextRow;  // first row of the table that is not read yet
+  RowBatch keys;               // join columns of the part
+  unsigned long long pos;      // current row of the part
+
+  JoinSource(FstHandle &table, const vector<int> &keyCols, const vector<FstColumnType> &keyTypes) :
+    table(table), keyCols(keyCols), partRow(0), nextRow(0), keys(keyTypes), pos(0) {}
+
+  // Read the join columns of the next part of at most maxRows rows, returns false if all rows were read
+  bool Read(unsigned long long maxRows, int nrOfThreads)
+  {
+    pos = 0;
+
+    if (nextRow == table.NrOfRows()) return false;
+
+    unsigned long long length = min(maxRows, table.NrOfRows() - nextRow);
+    IColumnFactory* columnFactory = table.SetColumnFactory(&keys);
+
+    try
+    {
+      table.ReadRows(keys, keyCols, nextRow, length, nrOfThreads);
+    }
+    catch (const std::runtime_error &)
+    {
+      table.SetColumnFactory(columnFactory);
+      throw;
+    }
+
+    table.SetColumnFactory(columnFactory);
+    partRow = nextRow;
+    nextRow += length;
+
+    return true;
+  }
+
+  // Move to the next row, returns false at the end of the table
+  bool Next(unsigned long long maxRows, int nrOfThreads)
+  {
+    if (++pos < keys.nrOfRows) return true;
+
+    return Read(maxRows, nrOfThreads);
+  }
+
+  // Move to the first row with a key that doesn't sort before the key of row targetPos of target, returns false at
+  // the end of the table. Parts that sort before the key are skipped as a whole, within a part the row is found
+  // with a binary search.
+  bool SkipTo(RowBatch &target, unsigned long long targetPos, const vector<int> &keyIndex, unsigned long long maxRows,
+    int nrOfThreads)
+  {
+    while (CompareRows(keys, keys.nrOfRows - 1, target, targetPos, keyIndex) < 0)
+    {
+      if (!Read(maxRows, nrOfThreads)) return false;
+    }
+
+    unsigned long long low = pos;
+    unsigned long long high = keys.nrOfRows - 1;  // doesn't sort before the key
+
+    while (low < high)
+    {
+      unsigned long long mid = low + (high - low) / 2;
+
+      if (CompareRows(keys, mid, target, targetPos, keyIndex) < 0)
+      {
+        low = mid + 1;
+      }
+      else
+      {
+        high = mid;
+      }
+    }
+
+    pos = low;
+
+    return true;
+  }
+
+  // Row of the table of the current row
+  unsigned long long Row() { return partRow + pos; }
+};
+
+
+// Read the selected rows (sorted, duplicates allowed) of a table into a batch
+void ReadBatchRows(FstHandle &table, RowBatch &batch, const vector<int> &colIndex, const vector<unsigned long long> &rows,
+  int nrOfThreads)
+{
+  IColumnFactory* columnFactory = table.SetColumnFactory(&batch);
+
+  try
+  {
+    table.ReadRowSet(batch, colIndex, rows.data(), rows.size(), nrOfThreads);
+  }
+  catch (const std::runtime_error &)
+  {
+    table.SetColumnFactory(columnFactory);
+    throw;
+  }
+
+  table.SetColumnFactory(columnFactory);
+}
+
+
+// Read the columns of the paired rows and write them as a data chunk of the joined file. The output batch holds the
+// layout of the result, the columns read from the left table followed by the columns of the right table.
+void WriteJoined(FstHandle &left, FstHandle &right, const vector<int> &leftIndex, const vector<int> &rightIndex,
+  const vector<unsigned long long> &leftRows, const vector<long long> &rightRows, RowBatch &output, FstWriter &writer,
+  int nrOfThreads)
+{
+  unsigned long long nrOfRows = leftRows.size();
+  int nrOfLeftCols = (int) leftIndex.size();
+
+  // The left rows are paired in file order
+  RowBatch leftBatch(vector<FstColumnType>(output.colTypes.begin(), output.colTypes.begin() + nrOfLeftCols));
+  ReadBatchRows(left, leftBatch, leftIndex, leftRows, nrOfThreads);
+
+  for (int colNr = 0; colNr < nrOfLeftCols; ++colNr) output.MoveColumn(colNr, leftBatch, colNr);
+
+  if (!rightIndex.empty())
+  {
+    RowBatch rightBatch(vector<FstColumnType>(output.colTypes.begin() + nrOfLeftCols, output.colTypes.end()));
+
+    // The right rows of a group are paired with each left row of the group, so they're sorted before reading
+    vector<unsigned long long> pairs;
+
+    for (unsigned long long pairNr = 0; pairNr < nrOfRows; ++pairNr)
+    {
+      if (rightRows[pairNr] >= 0) pairs.push_back(pairNr);
+    }
+
+    stable_sort(pairs.begin(), pairs.end(), [&rightRows](unsigned long long pairA, unsigned long long pairB)
+    {
+      return rightRows[pairA] < rightRows[pairB];
+    });
+
+    vector<unsigned long long> rows(pairs.size());
+    vector<long long> batchRows(nrOfRows, -1);  // row of rightBatch of each pair, -1 without a paired row
+
+    for (unsigned long long pos = 0; pos < pairs.size(); ++pos)
+    {
+      rows[pos] = rightRows[pairs[pos]];
+      batchRows[pairs[pos]] = pos;
+    }
+
+    if (!rows.empty()) ReadBatchRows(right, rightBatch, rightIndex, rows, nrOfThreads);
+
+    rightBatch.Gather(batchRows, nrOfThreads);
+
+    for (int colNr = 0; colNr < (int) rightIndex.size(); ++colNr)
+    {
+      output.MoveColumn(nrOfLeftCols + colNr, rightBatch, colNr);
+    }
+  }
+
+  output.nrOfRows = nrOfRows;
+  writer.WriteBatch(output);
+}
+
+
+unsigned long long FstJoiner::Join(int nrOfKeys, const vector<int> &leftCols, const vector<int> &rightCols,
+  const vector<string> &colNames, bool allLeft, const char* fileName)
+{
+  if (nrOfKeys < 1 || nrOfKeys > left.keyLength || nrOfKeys > right.keyLength)
+  {
+    throw(runtime_error("Both tables should be keyed on the join columns."));
+  }
+
+  vector<int> leftKeys(left.keyColPos.begin(), left.keyColPos.begin() + nrOfKeys);
+  vector<int> rightKeys(right.keyColPos.begin(), right.keyColPos.begin() + nrOfKeys);
+
+  vector<FstColumnType> keyTypes;
+  vector<int> keyIndex;
+
+  for (int keyNr = 0; keyNr < nrOfKeys; ++keyNr)
+  {
+    unsigned short int colType = left.colTypes[leftKeys[keyNr]];
+
+    if (colType != right.colTypes[rightKeys[keyNr]])
+    {
+      throw(runtime_error("The join columns should have the same types in both tables."));
+    }
+
+    if (StoredColumnType(colType) == FstColumnType::FACTOR)
+    {
+      throw(runtime_error("Factor columns can't be used as join columns."));
+    }
+
+    keyTypes.push_back(StoredColumnType(colType));
+    keyIndex.push_back(keyNr);
+  }
+
+  // Columns read from the left table: the join columns and the selected columns
+  vector<int> leftIndex(leftKeys);
+  leftIndex.insert(leftIndex.end(), leftCols.begin(), leftCols.end());
+
+  // Layout of the result
+  vector<FstColumnType> colTypes;
+  for (vector<int>::iterator it = leftIndex.begin(); it != leftIndex.end(); ++it)
+  {
+    colTypes.push_back(StoredColumnType(left.colTypes[*it]));
+  }
+
+  for (vector<int>::const_iterator it = rightCols.begin(); it != rightCols.end(); ++it)
+  {
+    colTypes.push_back(StoredColumnType(right.colTypes[*it]));
+  }
+
+  if (colNames.size() != colTypes.size())
+  {
+    throw(runtime_error("Incorrect number of column names for the joined table."));
+  }
+
+  RowBatch output(colTypes);
+  output.colNames.AllocateVec(colNames.size());
+  output.colNames.strings = colNames;
+  output.keyColPos = keyIndex;
+
+  for (unsigned int colNr = 0; colNr < leftIndex.size(); ++colNr)
+  {
+    left.ReadAttributeData(leftIndex[colNr], output.colAttributes[colNr]);
+  }
+
+  for (unsigned int colNr = 0; colNr < rightCols.size(); ++colNr)
+  {
+    right.ReadAttributeData(rightCols[colNr], output.colAttributes[leftIndex.size() + colNr]);
+  }
+
+  JoinSource leftSource(left, leftKeys, keyTypes);
+  JoinSource rightSource(right, rightKeys, keyTypes);
+  RowBatch groupKey(keyTypes);  // key of the current group of equal keys
+
+  FstWriter writer(fileName, compress, nrOfThreads, &output);
+  writer.SetSortedBatches(true);
+
+  vector<unsigned long long> leftRows;
+  vector<long long> rightRows;  // -1 for left rows without a paired row
+  leftRows.reserve(batchRows);
+  rightRows.reserve(batchRows);
+
+  unsigned long long nrOfRows = 0;
+
+  // Add a pair of rows to the result, the pairs are written in batches
+  auto addPair = [&](unsigned long long leftRow, long long rightRow)
+  {
+    leftRows.push_back(leftRow);
+    rightRows.push_back(rightRow);
+
+    if (leftRows.size() < batchRows) return;
+
+    WriteJoined(left, right, leftIndex, rightCols, leftRows, rightRows, output, writer, nrOfThreads);
+    nrOfRows += leftRows.size();
+    leftRows.clear();
+    rightRows.clear();
+  };
+
+  bool leftValid = leftSource.Read(batchRows, nrOfThreads);
+  bool rightValid = rightSource.Read(batchRows, nrOfThreads);
+
+  while (leftValid)
+  {
+    int order = rightValid ? CompareRows(leftSource.keys, leftSource.pos, rightSource.keys, rightSource.pos,
+      keyIndex) : -1;
+
+    // Left rows without a matching right row
+    if (order < 0)
+    {
+      if (!allLeft)
+      {
+        leftValid = rightValid && leftSource.SkipTo(rightSource.keys, rightSource.pos, keyIndex, batchRows,
+          nrOfThreads);
+        continue;
+      }
+
+      addPair(leftSource.Row(), -1);
+      leftValid = leftSource.Next(batchRows, nrOfThreads);
+      continue;
+    }
+
+    if (order > 0)
+    {
+      rightValid = rightSource.SkipTo(leftSource.keys, leftSource.pos, keyIndex, batchRows, nrOfThreads);
+      continue;
+    }
+
+    // The right rows with the key of the left row are the row range [rightFirst, rightEnd)
+    groupKey.AssignRow(leftSource.keys, leftSource.pos);
+    unsigned long long rightFirst = rightSource.Row();
+
+    do
+    {
+      rightValid = rightSource.Next(batchRows, nrOfThreads);
+    }
+    while (rightValid && CompareRows(rightSource.keys, rightSource.pos, groupKey, 0, keyIndex) == 0);
+
+    unsigned long long rightEnd = rightValid ? rightSource.Row() : right.NrOfRows();
+
+    // Pair each left row of the group with the right rows
+    do
+    {
+      for (unsigned long long rightRow = rightFirst; rightRow < rightEnd; ++rightRow)
+      {
+        addPair(leftSource.Row(), (long long) rightRow);
+      }
+
+      leftValid = leftSource.Next(batchRows, nrOfThreads);
+    }
+    while (leftValid && CompareRows(leftSource.keys, leftSource.pos, groupKey, 0, keyIndex) == 0);
+  }
+
+  if (!leftRows.empty())
+  {
+    WriteJoined(left, right, leftIndex, rightCols, leftRows, rightRows, output, writer, nrOfThreads);
+    nrOfRows += leftRows.size();
+  }
+
+  writer.Close();
+
+  return nrOfRows;
+}
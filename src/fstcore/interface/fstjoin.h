@@ -0,0 +1,98 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+
+#ifndef FST_JOIN_H
+#define FST_JOIN_H
+
+
+#include <string>
+#include <vector>
+
+#include <fsthandle.h>
+
+
+/**
+ Joins two fst tables that are keyed on the join columns with a streaming merge join, for tables that don't fit in
+ memory. Both tables are walked in key order: the join columns are read in parts of batchRows rows and the rows of
+ the right table with a key equal to the key of a left row are paired with that row. Groups of equal keys are
+ paired in full (a many-to-many join), NA keys are equal to each other like the NA values of a data.table join.
+
+ The pairs are written as data chunks of at most batchRows rows to a new fst file that is keyed on the join columns.
+ Only the blocks of the selected columns that contain paired rows are decompressed, so memory use is limited to a
+ few batches independent of the size of the tables.
+ */
+class FstJoiner
+{
+  FstHandle &left;
+  FstHandle &right;
+  int compress;
+  unsigned long long batchRows;
+  int nrOfThreads;
+
+public:
+  /**
+   @param left Opened left table of the join.
+   @param right Opened right table of the join.
+   @param compress Compression level (0 - 100) of the joined file.
+   @param batchRows Number of rows that are read and written at a time.
+   @param nrOfThreads Number of threads used for decompressing and compressing.
+   */
+  FstJoiner(FstHandle &left, FstHandle &right, int compress, unsigned long long batchRows, int nrOfThreads) :
+    left(left), right(right), compress(compress), batchRows(batchRows), nrOfThreads(nrOfThreads) {}
+
+  /**
+   Join the tables on the first nrOfKeys key columns of both tables and write the result to a new fst file. The
+   result has the join columns, the selected columns of the left table and the selected columns of the right table,
+   in that order.
+
+   @param nrOfKeys Number of join columns, the leading key columns of both tables. The join columns should have
+     the same types in both tables and can't be factor columns.
+   @param leftCols Column numbers of the selected columns of the left table, other than the join columns.
+   @param rightCols Column numbers of the selected columns of the right table, other than the join columns.
+   @param colNames Names of the columns of the result.
+   @param allLeft If true, rows of the left table without a matching row are kept with NA values for the columns of
+     the right table (a left join), otherwise only paired rows are kept (an inner join).
+   @param fileName Path of the joined fst file. If no rows are paired, no file is written.
+   @return Number of rows of the result.
+   @throws runtime_error if the tables are not keyed on compatible join columns.
+   */
+  unsigned long long Join(int nrOfKeys, const std::vector<int> &leftCols, const std::vector<int> &rightCols,
+    const std::vector<std::string> &colNames, bool allLeft, const char* fileName);
+};
+
+
+#endif  // FST_JOIN_H
@@ -0,0 +1,733 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include <stdexcept>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+#include <unordered_map>
+
+#include <fstdefines.h>
+#include <fstkeylookup.h>
+#include <stringvectorcolumn.h>
+
+#include <character_v6.h>
+#include <factor_v7.h>
+#include <integer_v8.h>
+#include <integer64_v11.h>
+#include <double_v9.h>
+#include <logical_v10.h>
+
+
+using namespace std;
+
+
+// Sorted key column of a table. Values are compared with the key value one row at a time, the block that
+// contains the last compared row is kept in decompressed form.
+class KeyColumn
+{
+  istream &myfile;
+  unsigned short int colType;
+  const vector<unsigned long long> &chunkFirstRows;
+  const vector<unsigned long long> &chunkRowCounts;
+  unsigned long long &blocksRead;
+
+  // Key value
+  double keyValue;  // integer, double, 64-bit integer and logical columns, level code for factor columns
+  string keyStr;    // character columns
+  char keyPrefix[ZONE_MAP_PREFIX_SIZE];
+
+  // Cached block
+  unsigned int cacheChunk;
+  unsigned long long cacheFirstRow;  // relative to the first row of the chunk
+  unsigned long long cacheEndRow;
+  vector<int> ints;
+  vector<double> doubles;
+  vector<long long> longs;
+  StringVectorColumn strings;
+
+public:
+  vector<unsigned long long> colPos;  // position of the column data in each chunk
+  vector<ZoneMap> zoneMaps;           // zone map metadata of each chunk, without blocks if not available
+
+  KeyColumn(istream &myfile, unsigned short int colType, const vector<unsigned long long> &chunkFirstRows,
+    const vector<unsigned long long> &chunkRowCounts, unsigned long long &blocksRead) :
+    myfile(myfile), colType(colType), chunkFirstRows(chunkFirstRows), chunkRowCounts(chunkRowCounts),
+    blocksRead(blocksRead)
+  {
+    keyValue    = 0;
+    cacheChunk  = 0;
+    cacheFirstRow = 0;
+    cacheEndRow = 0;  // empty cache
+  }
+
+  void SetKey(double value) { keyValue = value; }
+
+  void SetKey(const string &str)
+  {
+    keyStr = str;
+    memset(keyPrefix, 0, ZONE_MAP_PREFIX_SIZE);
+    memcpy(keyPrefix, str.data(), min(str.size(), (size_t) ZONE_MAP_PREFIX_SIZE));
+  }
+
+  /**
+   First row in the range lo until hi for which the value is larger than the key value (strict) or larger
+   than or equal to the key value, hi if there is no such row. NA values are sorted before all other values.
+   */
+  unsigned long long LowerBound(unsigned long long lo, unsigned long long hi, bool strict);
+
+private:
+  // Sign of the difference between the value at a row and the key value, NA values are smaller than any key
+  int Compare(unsigned long long row);
+
+  // Narrow the range lo until hi to the cached block if that block contains the bound
+  bool InCachedBlock(unsigned long long &lo, unsigned long long &hi, bool strict);
+
+  // Binary search on the rows of the range lo until hi
+  unsigned long long RowLowerBound(unsigned long long lo, unsigned long long hi, bool strict);
+
+  // Test if a block can contain a row that passes the bound, using its maximum
+  bool MaxMayPass(const ZoneMapEntry &entry, bool strict);
+
+  // Test if all rows of a block pass the bound, using its minimum
+  bool MinPasses(const ZoneMapEntry &entry, bool strict);
+
+  // First block in firstBlock until endBlock of a chunk for which the (monotonic) test passes
+  template<typename Test>
+  unsigned long long FirstBlock(unsigned int chunkNr, unsigned long long firstBlock, unsigned long long endBlock,
+    Test test);
+
+  void ReadBlock(unsigned int chunkNr, unsigned long long chunkRow);
+};
+
+
+int KeyColumn::Compare(unsigned long long row)
+{
+  unsigned int chunkNr = (unsigned int) (upper_bound(chunkFirstRows.begin(), chunkFirstRows.end(), row) -
+    chunkFirstRows.begin()) - 1;
+  unsigned long long chunkRow = row - chunkFirstRows[chunkNr];
+
+  if (chunkNr != cacheChunk || chunkRow < cacheFirstRow || chunkRow >= cacheEndRow)
+  {
+    ReadBlock(chunkNr, chunkRow);
+  }
+
+  unsigned long long pos = chunkRow - cacheFirstRow;
+
+  if (colType == 6)
+  {
+    if (strings.isNA[pos]) return -1;
+
+    int comp = strings.strings[pos].compare(keyStr);
+
+    return comp < 0 ? -1 : (comp > 0 ? 1 : 0);
+  }
+
+  double value;
+
+  if (colType == 9)
+  {
+    value = doubles[pos];
+
+    if (value != value) return -1;
+  }
+  else if (colType == 11)
+  {
+    if (longs[pos] == LLONG_MIN) return -1;
+
+    value = (double) longs[pos];  // compared as doubles, like the key value
+  }
+  else
+  {
+    if (ints[pos] == INT_MIN) return -1;
+
+    value = ints[pos];
+  }
+
+  return value < keyValue ? -1 : (value > keyValue ? 1 : 0);
+}
+
+
+void KeyColumn::ReadBlock(unsigned int chunkNr, unsigned long long chunkRow)
+{
+  unsigned long long blockSize = zoneMaps[chunkNr].BlockSize();
+
+  if (blockSize == 0)
+  {
+    switch (colType)
+    {
+      case 6:
+        blockSize = BLOCKSIZE_CHAR;
+        break;
+
+      case 9:
+        blockSize = BLOCKSIZE_REAL;
+        break;
+
+      case 11:
+        blockSize = BLOCKSIZE_INT64;
+        break;
+
+      case 10:
+        blockSize = BLOCKSIZE_LOGICAL;
+        break;
+
+      default:
+        blockSize = BLOCKSIZE_INT;
+    }
+  }
+
+  unsigned long long nrOfRows = chunkRowCounts[chunkNr];
+
+  cacheChunk    = chunkNr;
+  cacheFirstRow = (chunkRow / blockSize) * blockSize;
+  cacheEndRow   = min(cacheFirstRow + blockSize, nrOfRows);
+
+  unsigned long long length = cacheEndRow - cacheFirstRow;
+  unsigned long long pos = colPos[chunkNr];
+
+  myfile.clear();  // reset state from a previous read at the end of the file
+
+  switch (colType)
+  {
+    case 6:
+      strings.AllocateVec(length);
+      fdsReadCharVecAt_v6(myfile, &strings, pos, cacheFirstRow, length, nrOfRows, 0);
+      break;
+
+    case 7:
+      ints.resize(length);
+      fdsReadFactorCodes_v7(myfile, ints.data(), pos, cacheFirstRow, length, nrOfRows, 1);
+      break;
+
+    case 8:
+      ints.resize(length);
+      fdsReadIntVec_v8(myfile, ints.data(), pos, cacheFirstRow, length, nrOfRows, 1);
+      break;
+
+    case 9:
+      doubles.resize(length);
+      fdsReadRealVec_v9(myfile, doubles.data(), pos, cacheFirstRow, length, nrOfRows, 1);
+      break;
+
+    case 11:
+      longs.resize(length);
+      fdsReadInt64Vec_v11(myfile, longs.data(), pos, cacheFirstRow, length, nrOfRows, 1);
+      break;
+
+    default:
+      ints.resize(length);
+      fdsReadLogicalVec_v10(myfile, ints.data(), pos, cacheFirstRow, length, nrOfRows, 1);
+  }
+
+  ++blocksRead;
+}
+
+
+bool KeyColumn::MaxMayPass(const ZoneMapEntry &entry, bool strict)
+{
+  if (entry.naCount == entry.nrOfValues) return false;
+
+  if (colType == 6)
+  {
+    int comp = memcmp(entry.maxPrefix, keyPrefix, ZONE_MAP_PREFIX_SIZE);
+
+    // Strings shorter than the prefix are stored completely in the zone map
+    if (strict && comp == 0 && keyStr.size() < ZONE_MAP_PREFIX_SIZE) return false;
+
+    return comp >= 0;
+  }
+
+  double maxValue = colType == 11 ? (double) entry.maxInt64 : entry.maxValue;
+
+  return strict ? maxValue > keyValue : maxValue >= keyValue;
+}
+
+
+bool KeyColumn::MinPasses(const ZoneMapEntry &entry, bool strict)
+{
+  if (entry.naCount != 0) return false;
+
+  if (colType == 6)
+  {
+    int comp = memcmp(entry.minPrefix, keyPrefix, ZONE_MAP_PREFIX_SIZE);
+
+    if (!strict && comp == 0 && keyStr.size() < ZONE_MAP_PREFIX_SIZE) return true;
+
+    return comp > 0;
+  }
+
+  double minValue = colType == 11 ? (double) entry.minInt64 : entry.minValue;
+
+  return strict ? minValue > keyValue : minValue >= keyValue;
+}
+
+
+template<typename Test>
+unsigned long long KeyColumn::FirstBlock(unsigned int chunkNr, unsigned long long firstBlock,
+  unsigned long long endBlock, Test test)
+{
+  const ZoneMap &zoneMap = zoneMaps[chunkNr];
+  ZoneMapEntry entry;
+
+  while (firstBlock < endBlock)
+  {
+    unsigned long long block = firstBlock + (endBlock - firstBlock) / 2;
+
+    if (!zoneMap.ReadBlock(myfile, colPos[chunkNr], block, entry))
+    {
+      throw(runtime_error("Error reading the zone map of a key column, your fst file is incomplete or damaged."));
+    }
+
+    if (test(entry)) endBlock = block; else firstBlock = block + 1;
+  }
+
+  return firstBlock;
+}
+
+
+bool KeyColumn::InCachedBlock(unsigned long long &lo, unsigned long long &hi, bool strict)
+{
+  if (cacheEndRow == 0) return false;  // empty cache
+
+  unsigned long long cacheStart = chunkFirstRows[cacheChunk] + cacheFirstRow;
+  unsigned long long cacheEnd = chunkFirstRows[cacheChunk] + cacheEndRow;
+
+  if (lo < cacheStart || lo >= cacheEnd) return false;
+
+  if (hi <= cacheEnd) return true;
+
+  // The last row of the block passes the bound
+  int comp = Compare(cacheEnd - 1);
+
+  if (strict ? comp > 0 : comp >= 0)
+  {
+    hi = cacheEnd - 1;
+    return true;
+  }
+
+  lo = cacheEnd;
+
+  return false;
+}
+
+
+unsigned long long KeyColumn::LowerBound(unsigned long long lo, unsigned long long hi, bool strict)
+{
+  if (lo >= hi) return hi;
+
+  // Keys that are looked up in key order mostly find their bound in the block of the previous search
+  if (InCachedBlock(lo, hi, strict)) return RowLowerBound(lo, hi, strict);
+
+  if (lo >= hi) return hi;
+
+  unsigned int chunkNr = (unsigned int) (upper_bound(chunkFirstRows.begin(), chunkFirstRows.end(), lo) -
+    chunkFirstRows.begin()) - 1;
+
+  bool lowerFound = false;
+
+
+  // The zone maps narrow the range down to the blocks that contain the bound
+  for (; chunkNr < chunkFirstRows.size() && chunkFirstRows[chunkNr] < hi; ++chunkNr)
+  {
+    const ZoneMap &zoneMap = zoneMaps[chunkNr];
+
+    if (zoneMap.NrOfBlocks() == 0) break;  // no statistics, search the remaining range row by row
+
+    unsigned long long chunkStart = chunkFirstRows[chunkNr];
+    unsigned long long chunkEnd = min(hi, chunkStart + chunkRowCounts[chunkNr]);
+    unsigned long long blockSize = zoneMap.BlockSize();
+
+    unsigned long long firstBlock = (max(lo, chunkStart) - chunkStart) / blockSize;
+    unsigned long long endBlock = (chunkEnd - chunkStart - 1) / blockSize + 1;
+
+    if (!lowerFound)
+    {
+      unsigned long long block = FirstBlock(chunkNr, firstBlock, endBlock,
+        [this, strict](const ZoneMapEntry &entry) { return MaxMayPass(entry, strict); });
+
+      // All rows of the chunk are before the bound
+      if (block == endBlock)
+      {
+        lo = chunkEnd;
+        continue;
+      }
+
+      lo = max(lo, chunkStart + block * blockSize);
+      firstBlock = block;
+      lowerFound = true;
+    }
+
+    unsigned long long block = FirstBlock(chunkNr, firstBlock, endBlock,
+      [this, strict](const ZoneMapEntry &entry) { return MinPasses(entry, strict); });
+
+    // The first row of the block passes the bound
+    if (block < endBlock)
+    {
+      hi = max(lo, chunkStart + block * blockSize);
+      break;
+    }
+  }
+
+
+  return RowLowerBound(lo, hi, strict);
+}
+
+
+unsigned long long KeyColumn::RowLowerBound(unsigned long long lo, unsigned long long hi, bool strict)
+{
+  while (lo < hi)
+  {
+    unsigned long long row = lo + (hi - lo) / 2;
+    int comp = Compare(row);
+
+    if (strict ? comp > 0 : comp >= 0) hi = row; else lo = row + 1;
+  }
+
+  return lo;
+}
+
+
+unsigned short int FstKeyLookup::KeyColumnType(unsigned int keyNr, bool isString)
+{
+  int colNr = fstHandle.keyColPos[keyNr];
+  unsigned short int colType = fstHandle.colTypes[colNr];
+  if (colType == 12 || colType == 13) colType = 9;  // dates and timestamps are stored as doubles
+  bool isText = colType == 6 || colType == 7;
+
+  if (isString != isText)
+  {
+    throw(runtime_error(string("Key column '") + fstHandle.colNames->GetElement(colNr) +
+      "' should be compared with a " + (isText ? "character" : "numeric") + " value."));
+  }
+
+  return colType;
+}
+
+
+void FstKeyLookup::ReadKeyColumn(unsigned int keyNr, KeyColumn &keyColumn)
+{
+  int colNr = fstHandle.keyColPos[keyNr];
+
+  for (unsigned int chunkNr = 0; chunkNr < fstHandle.NrOfChunks(); ++chunkNr)
+  {
+    keyColumn.colPos.push_back(fstHandle.ChunkPositionData(chunkNr)[colNr]);
+    keyColumn.zoneMaps.push_back(ZoneMap());
+    fstHandle.ReadZoneMap(chunkNr, colNr, keyColumn.zoneMaps.back(), true);
+  }
+}
+
+
+void FstKeyLookup::ReadKeyLevels(const KeyColumn &keyColumn, StringVectorColumn &levels)
+{
+  istream &myfile = *fstHandle.inputStream;
+
+  myfile.clear();  // reset state from a previous read at the end of the file
+  fdsReadFactorLevels_v7(myfile, &levels, keyColumn.colPos[0]);
+}
+
+
+// Check the opened file and the number of key columns of a lookup
+inline void CheckKeyLookup(istream* inputStream, int keyLength, size_t nrOfKeyValues)
+{
+  if (inputStream == nullptr)
+  {
+    throw(runtime_error("The fst file is not opened."));
+  }
+
+  if (keyLength == 0)
+  {
+    throw(runtime_error("The fst file has no key columns."));
+  }
+
+  if (nrOfKeyValues == 0 || nrOfKeyValues > (size_t) keyLength)
+  {
+    throw(runtime_error("The number of key values should be in the range of one to the number of key columns."));
+  }
+}
+
+
+unsigned long long FstKeyLookup::Lookup(const vector<FstKeyValue> &keyValues, unsigned long long &firstRow)
+{
+  blocksRead = 0;
+  firstRow = 0;
+
+  CheckKeyLookup(fstHandle.inputStream, fstHandle.keyLength, keyValues.size());
+
+  unsigned long long lo = 0;
+  unsigned long long hi = fstHandle.nrOfRows;
+  istream &myfile = *fstHandle.inputStream;
+
+  for (unsigned int keyNr = 0; keyNr < keyValues.size(); ++keyNr)
+  {
+    const FstKeyValue &key = keyValues[keyNr];
+    unsigned short int colType = KeyColumnType(keyNr, key.isString);
+
+    if (!key.isString && key.value != key.value) return 0;  // NA key values match no rows
+
+    KeyColumn keyColumn(myfile, colType, fstHandle.chunkFirstRows, fstHandle.chunkRowCounts, blocksRead);
+    ReadKeyColumn(keyNr, keyColumn);
+
+    // Factor columns are sorted on their level codes
+    if (colType == 7)
+    {
+      StringVectorColumn levels;
+      ReadKeyLevels(keyColumn, levels);
+
+      unsigned int nrOfLevels = (unsigned int) levels.strings.size();
+      unsigned int level = 0;
+      while (level < nrOfLevels && (levels.isNA[level] || levels.strings[level] != key.str)) ++level;
+
+      if (level == nrOfLevels) return 0;
+
+      keyColumn.SetKey((double) (level + 1));
+    }
+    else if (colType == 6)
+    {
+      keyColumn.SetKey(key.str);
+    }
+    else
+    {
+      keyColumn.SetKey(key.value);
+    }
+
+    lo = keyColumn.LowerBound(lo, hi, false);
+    hi = keyColumn.LowerBound(lo, hi, true);
+
+    if (lo == hi) return 0;
+  }
+
+  firstRow = lo;
+
+  return hi - lo;
+}
+
+
+void FstKeyLookup::LookupBatch(const vector<FstKeyValues> &keyValues, vector<unsigned long long> &firstRows,
+  vector<unsigned long long> &rowCounts, int nrOfThreads)
+{
+  blocksRead = 0;
+
+  CheckKeyLookup(fstHandle.inputStream, fstHandle.keyLength, keyValues.size());
+
+  unsigned int nrOfKeyCols = (unsigned int) keyValues.size();
+  size_t nrOfKeys = keyValues[0].isString ? keyValues[0].strs.size() : keyValues[0].values.size();
+
+  firstRows.assign(nrOfKeys, 0);
+  rowCounts.assign(nrOfKeys, 0);
+
+  // Numeric keys of the key columns (level codes for factor columns), or a pointer to the character keys
+  vector<unsigned short int> colTypes(nrOfKeyCols);
+  vector<vector<double>> numKeys(nrOfKeyCols);
+  vector<const vector<string>*> strKeys(nrOfKeyCols, nullptr);
+  vector<char> matchable(nrOfKeys, 1);  // keys without NA values or unknown levels
+  vector<KeyColumn> prototypes;
+  prototypes.reserve(nrOfKeyCols);
+
+  for (unsigned int keyNr = 0; keyNr < nrOfKeyCols; ++keyNr)
+  {
+    const FstKeyValues &keys = keyValues[keyNr];
+
+    if ((keys.isString ? keys.strs.size() : keys.values.size()) != nrOfKeys ||
+      (keys.isString && keys.isNA.size() != nrOfKeys))
+    {
+      throw(runtime_error("All key columns should have the same number of key values."));
+    }
+
+    colTypes[keyNr] = KeyColumnType(keyNr, keys.isString);
+    prototypes.emplace_back(*fstHandle.inputStream, colTypes[keyNr], fstHandle.chunkFirstRows,
+      fstHandle.chunkRowCounts, blocksRead);
+    ReadKeyColumn(keyNr, prototypes.back());
+
+    if (colTypes[keyNr] == 6)
+    {
+      strKeys[keyNr] = &keys.strs;
+
+      for (size_t key = 0; key < nrOfKeys; ++key)
+      {
+        if (keys.isNA[key]) matchable[key] = 0;
+      }
+
+      continue;
+    }
+
+    if (colTypes[keyNr] != 7)
+    {
+      numKeys[keyNr] = keys.values;
+
+      for (size_t key = 0; key < nrOfKeys; ++key)
+      {
+        if (keys.values[key] != keys.values[key]) matchable[key] = 0;
+      }
+
+      continue;
+    }
+
+    // Factor keys are translated to the level codes on which the column is sorted
+    StringVectorColumn levels;
+    ReadKeyLevels(prototypes.back(), levels);
+
+    unordered_map<string, unsigned int> levelCodes;
+    for (unsigned int level = 0; level < levels.strings.size(); ++level)
+    {
+      if (!levels.isNA[level]) levelCodes.emplace(levels.strings[level], level + 1);
+    }
+
+    numKeys[keyNr].assign(nrOfKeys, 0);
+
+    for (size_t key = 0; key < nrOfKeys; ++key)
+    {
+      auto level = keys.isNA[key] ? levelCodes.end() : levelCodes.find(keys.strs[key]);
+
+      if (level == levelCodes.end()) matchable[key] = 0;
+      else numKeys[keyNr][key] = level->second;
+    }
+  }
+
+  // Keys are looked up in key order
+  auto compareKeys = [&](size_t key1, size_t key2)
+  {
+    for (unsigned int keyNr = 0; keyNr < nrOfKeyCols; ++keyNr)
+    {
+      if (strKeys[keyNr] != nullptr)
+      {
+        int comp = (*strKeys[keyNr])[key1].compare((*strKeys[keyNr])[key2]);
+        if (comp != 0) return comp;
+        continue;
+      }
+
+      double value1 = numKeys[keyNr][key1];
+      double value2 = numKeys[keyNr][key2];
+      if (value1 != value2) return value1 < value2 ? -1 : 1;
+    }
+
+    return 0;
+  };
+
+  vector<size_t> order;
+  order.reserve(nrOfKeys);
+
+  for (size_t key = 0; key < nrOfKeys; ++key)
+  {
+    if (matchable[key]) order.push_back(key);
+  }
+
+  sort(order.begin(), order.end(), [&](size_t key1, size_t key2) { return compareKeys(key1, key2) < 0; });
+
+  // Contiguous ranges of the sorted keys are looked up in parallel, each with its own stream
+  int nrOfBatches = (int) min((size_t) max(nrOfThreads, 1), order.size() / KEY_BATCH_MIN_KEYS + 1);
+  unsigned long long nrOfRows = fstHandle.nrOfRows;
+  bool lookupError = false;
+  string errorMessage;
+
+#pragma omp parallel for schedule(static, 1) num_threads(nrOfBatches)
+  for (int batchNr = 0; batchNr < nrOfBatches; ++batchNr)
+  {
+    size_t batchStart = (order.size() * batchNr) / nrOfBatches;
+    size_t batchEnd = (order.size() * (batchNr + 1)) / nrOfBatches;
+    istream* batchStream = nrOfBatches == 1 ? fstHandle.inputStream : fstHandle.input.OpenStream();
+    unsigned long long batchBlocks = 0;
+
+    try
+    {
+      if (batchStream == nullptr)
+      {
+        throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+      }
+
+      vector<KeyColumn> keyColumns;
+      keyColumns.reserve(nrOfKeyCols);
+
+      for (unsigned int keyNr = 0; keyNr < nrOfKeyCols; ++keyNr)
+      {
+        keyColumns.emplace_back(*batchStream, colTypes[keyNr], fstHandle.chunkFirstRows, fstHandle.chunkRowCounts,
+          batchBlocks);
+        keyColumns.back().colPos = prototypes[keyNr].colPos;
+        keyColumns.back().zoneMaps = prototypes[keyNr].zoneMaps;
+      }
+
+      // The rows before the first matching row of a key don't match any later key
+      unsigned long long lo = 0;
+
+      for (size_t pos = batchStart; pos < batchEnd; ++pos)
+      {
+        size_t key = order[pos];
+
+        // Equal keys have equal results
+        if (pos != batchStart && compareKeys(order[pos - 1], key) == 0)
+        {
+          firstRows[key] = firstRows[order[pos - 1]];
+          rowCounts[key] = rowCounts[order[pos - 1]];
+          continue;
+        }
+
+        unsigned long long hi = nrOfRows;
+
+        for (unsigned int keyNr = 0; keyNr < nrOfKeyCols && lo < hi; ++keyNr)
+        {
+          KeyColumn &keyColumn = keyColumns[keyNr];
+
+          if (strKeys[keyNr] != nullptr) keyColumn.SetKey((*strKeys[keyNr])[key]);
+          else keyColumn.SetKey(numKeys[keyNr][key]);
+
+          lo = keyColumn.LowerBound(lo, hi, false);
+          hi = keyColumn.LowerBound(lo, hi, true);
+        }
+
+        firstRows[key] = lo;
+        rowCounts[key] = hi - lo;
+      }
+    }
+    catch (const std::exception &e)
+    {
+#pragma omp critical
+      {
+        lookupError = true;
+        errorMessage = e.what();
+      }
+    }
+
+    if (batchStream != fstHandle.inputStream) delete batchStream;
+
+#pragma omp atomic
+    blocksRead += batchBlocks;
+  }
+
+  if (lookupError)
+  {
+    throw(runtime_error(errorMessage));
+  }
+}
@@ -0,0 +1,132 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_KEY_LOOKUP_H
+#define FST_KEY_LOOKUP_H
+
+
+#include <string>
+#include <vector>
+
+#include <fsthandle.h>
+
+
+class KeyColumn;
+class StringVectorColumn;
+
+
+/**
+ Value of a single key column in a key lookup. Character and factor key columns use str, all other key
+ columns use value.
+ */
+struct FstKeyValue
+{
+  bool isString;
+  double value;
+  std::string str;
+};
+
+
+/**
+ Values of a key column in a batch of key lookups, one value for each key. Character and factor key columns use
+ strs and isNA, all other key columns use values (NaN for NA).
+ */
+struct FstKeyValues
+{
+  bool isString;
+  std::vector<double> values;
+  std::vector<std::string> strs;
+  std::vector<char> isNA;
+};
+
+
+/**
+ Binary search on the (sorted) key columns of a fst table, without reading the key columns. The zone maps of
+ the key columns narrow the search down to one or two blocks per key column, which are the only blocks that
+ are decompressed. Files without zone maps are searched by decompressing a single block for each step of the
+ binary search.
+ */
+class FstKeyLookup
+{
+  FstHandle &fstHandle;
+  unsigned long long blocksRead;
+
+  // Type of a key column in its comparisons, after checking that it can be compared with the key values
+  unsigned short int KeyColumnType(unsigned int keyNr, bool isString);
+
+  // Read the positions and zone maps of a key column in all data chunks
+  void ReadKeyColumn(unsigned int keyNr, KeyColumn &keyColumn);
+
+  // Levels of a factor key column, identical in all chunks as a keyed table is written from a single table
+  void ReadKeyLevels(const KeyColumn &keyColumn, StringVectorColumn &levels);
+
+public:
+  FstKeyLookup(FstHandle &fstHandle) : fstHandle(fstHandle), blocksRead(0) {}
+
+  /**
+   Find the rows of which the leading key columns are equal to the key values. As the table is sorted on
+   the key columns, these rows form a single row range. NA key values don't match any row.
+
+   @param keyValues Values of the leading key columns, at least one and at most the number of key columns.
+   @param firstRow Receives the first matching row (0-based).
+   @return Number of matching rows.
+   */
+  unsigned long long Lookup(const std::vector<FstKeyValue> &keyValues, unsigned long long &firstRow);
+
+  /**
+   Find the matching rows of a batch of keys (see Lookup). The keys are sorted and looked up in key order, so the
+   search for a key starts at the first matching row of the previous key and mostly compares rows of the block that
+   was decompressed for the previous key. Each key column is prepared once for the batch. The sorted keys are split
+   into ranges of at least KEY_BATCH_MIN_KEYS keys that are looked up in parallel, each with its own input stream.
+
+   @param keyValues Values of the leading key columns, at least one and at most the number of key columns, all
+     with the same number of keys.
+   @param firstRows Receives the first matching row (0-based) of each key. If no row matches, the row before which
+     the key would be inserted (zero for keys with NA values or unknown factor levels).
+   @param rowCounts Receives the number of matching rows of each key.
+   @param nrOfThreads Maximum number of threads used for the lookups.
+   */
+  void LookupBatch(const std::vector<FstKeyValues> &keyValues, std::vector<unsigned long long> &firstRows,
+    std::vector<unsigned long long> &rowCounts, int nrOfThreads);
+
+  /**
+   Number of key column blocks that were decompressed by the last call to Lookup or LookupBatch.
+   */
+  unsigned long long BlocksRead() const { return blocksRead; }
+};
+
+
+#endif  // FST_KEY_LOOKUP_H
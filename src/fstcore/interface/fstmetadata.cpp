@@ -84,7 +84,7 @@ unsigned int FstMetaData::ReadHeader(istream &fstfile, unsigned int &tableClassT
   }
 
   // Compare file version with current
-  if (*p_table_version > FST_VERSION)
+  if (*p_table_version > FST_VERSION_STREAM)
   {
     throw "Incompatible fst file: file was created by a newer version of the fst package.";
   }
@@ -117,7 +117,7 @@ int FstMetaData::CollectRecursive(std::istream &fstfile, uint64_t filePointer)
   fstfile.read(horzChunkInfo, headerSize);
 
   unsigned long long* p_nextHorzChunkSet = (unsigned long long*) horzChunkInfo;
-  unsigned long long* p_nextVertChunkSet = (unsigned long long*) &horzChunkInfo[8];
+  // unsigned long long* p_nextVertChunkSet = (unsigned long long*) &horzChunkInfo[8];
   unsigned long long* p_nrOfRows         = (unsigned long long*) &horzChunkInfo[16];
   unsigned int* p_version                = (unsigned int*) &horzChunkInfo[24];
   int* p_nrOfCols                        = (int*) &horzChunkInfo[28];
@@ -160,15 +160,10 @@ int FstMetaData::CollectRecursive(std::istream &fstfile, uint64_t filePointer)
     if (errorRes != 0) return errorRes;
   }
 
-  // No horizontal chunks left, get information from last chunk set
+  // No horizontal chunks left, get information from last chunk set. The number of rows includes the rows of all
+  // appended data chunks (linked from nextVertChunkSet).
   nrOfRows = *p_nrOfRows;
 
-  if (*p_nextVertChunkSet != 0)
-  {
-    // count total number of rows for all data chunks
-    throw std::runtime_error(FSTERROR_NOT_IMPLEMENTED);
-  }
-
   lastHorzChunkPointer = filePointer;
 
   return 0;
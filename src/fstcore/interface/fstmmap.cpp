@@ -0,0 +1,237 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <fstdefines.h>
+#include <fstmmap.h>
+
+
+using namespace std;
+
+
+static bool hugePages = false;
+
+
+void SetHugePages(bool enable)
+{
+  hugePages = enable;
+}
+
+
+bool HugePages()
+{
+  return hugePages;
+}
+
+
+void AdviseHugePages(void* data, unsigned long long size)
+{
+#if !defined(_WIN32) && defined(MADV_HUGEPAGE)
+  if (!hugePages || size < HUGE_PAGE_SIZE_MIN) return;
+
+  // Huge pages are aligned to their size
+  uintptr_t start = reinterpret_cast<uintptr_t>(data);
+  uintptr_t end = start + size;
+  start = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  end = end / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+  if (end > start) madvise(reinterpret_cast<void*>(start), end - start, MADV_HUGEPAGE);
+#endif
+}
+
+
+streambuf::pos_type MemoryStreamBuf::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+  if (!(which & ios_base::in)) return pos_type(off_type(-1));
+
+  off_type newPos;
+
+  if (dir == ios_base::beg) newPos = off;
+  else if (dir == ios_base::cur) newPos = (gptr() - eback()) + off;
+  else newPos = (egptr() - eback()) + off;
+
+  if (newPos < 0 || newPos > egptr() - eback()) return pos_type(off_type(-1));
+
+  setg(eback(), eback() + newPos, egptr());
+
+  return pos_type(newPos);
+}
+
+
+streambuf::pos_type MemoryStreamBuf::seekpos(pos_type pos, ios_base::openmode which)
+{
+  return seekoff(off_type(pos), ios_base::beg, which);
+}
+
+
+streamsize MemoryStreamBuf::xsgetn(char* s, streamsize n)
+{
+  streamsize available = egptr() - gptr();
+  if (n > available) n = available;
+
+  memcpy(s, gptr(), n);
+  setg(eback(), gptr() + n, egptr());
+
+  return n;
+}
+
+
+MemoryMappedFile::MemoryMappedFile()
+{
+  data = nullptr;
+  size = 0;
+
+#ifdef _WIN32
+  fileHandle = INVALID_HANDLE_VALUE;
+  mapHandle = nullptr;
+#endif
+}
+
+
+#ifdef _WIN32
+
+bool MemoryMappedFile::Open(const char* fileName)
+{
+  Close();
+
+  fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+  {
+    Close();
+    return false;
+  }
+
+  mapHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapHandle == nullptr)
+  {
+    Close();
+    return false;
+  }
+
+  data = (const char*) MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr)
+  {
+    Close();
+    return false;
+  }
+
+  size = (unsigned long long) fileSize.QuadPart;
+
+  return true;
+}
+
+
+void MemoryMappedFile::Prefetch(unsigned long long offset, unsigned long long size)
+{
+  // Windows 8 and later provide PrefetchVirtualMemory, which isn't available for all supported toolchains
+}
+
+
+void MemoryMappedFile::Close()
+{
+  if (data != nullptr) UnmapViewOfFile(data);
+  if (mapHandle != nullptr) CloseHandle(mapHandle);
+  if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+
+  data = nullptr;
+  size = 0;
+  mapHandle = nullptr;
+  fileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MemoryMappedFile::Open(const char* fileName)
+{
+  Close();
+
+  int fd = open(fileName, O_RDONLY);
+  if (fd == -1) return false;
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) == -1 || fileStat.st_size == 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  void* mapped = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);  // the mapping stays valid after closing the descriptor
+
+  if (mapped == MAP_FAILED) return false;
+
+  data = (const char*) mapped;
+  size = (unsigned long long) fileStat.st_size;
+
+  return true;
+}
+
+
+void MemoryMappedFile::Prefetch(unsigned long long offset, unsigned long long size)
+{
+  if (data == nullptr || offset >= this->size) return;
+
+  // madvise requires a page aligned address
+  unsigned long long pageSize = (unsigned long long) sysconf(_SC_PAGESIZE);
+  unsigned long long start = offset - offset % pageSize;
+  unsigned long long end = min(offset + size, this->size);
+
+  madvise((void*) (data + start), end - start, MADV_WILLNEED);
+}
+
+
+void MemoryMappedFile::Close()
+{
+  if (data != nullptr) munmap((void*) data, size);
+
+  data = nullptr;
+  size = 0;
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_MMAP_H
+#define FST_MMAP_H
+
+
+#include <istream>
+#include <streambuf>
+
+
+/**
+  Read-only stream buffer on top of a contiguous block of memory. Reads are copied directly from
+  the memory block, so no intermediate buffering is used.
+*/
+class MemoryStreamBuf : public std::streambuf
+{
+public:
+  MemoryStreamBuf() {}
+
+  MemoryStreamBuf(const char* data, unsigned long long size) { SetBuffer(data, size); }
+
+  /**
+   Set the memory block used by the stream buffer.
+
+   @param data Start of the memory block.
+   @param size Size of the memory block in bytes.
+   */
+  void SetBuffer(const char* data, unsigned long long size)
+  {
+    char* start = const_cast<char*>(data);
+    setg(start, start, start + size);
+  }
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in);
+
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in);
+
+  std::streamsize xsgetn(char* s, std::streamsize n);
+};
+
+
+/**
+  Read-only memory mapping of a complete file. The mapped pages are shared with the page cache, so
+  multiple processes reading the same file do not each keep a private copy of the data.
+*/
+class MemoryMappedFile
+{
+  const char* data;
+  unsigned long long size;
+
+#ifdef _WIN32
+  void* fileHandle;
+  void* mapHandle;
+#endif
+
+public:
+  MemoryMappedFile();
+
+  ~MemoryMappedFile() { Close(); }
+
+  /**
+   Map a file into memory.
+
+   @param fileName Path of the file to map.
+   @return false if the file could not be opened or mapped.
+   */
+  bool Open(const char* fileName);
+
+  void Close();
+
+  /**
+   Hint that the pages of the bytes [offset, offset + size) will be accessed soon.
+   */
+  void Prefetch(unsigned long long offset, unsigned long long size);
+
+  const char* Data() const { return data; }
+
+  unsigned long long Size() const { return size; }
+};
+
+
+/**
+  Enable or disable transparent huge pages for large result vectors (disabled by default).
+ */
+void SetHugePages(bool enable);
+
+bool HugePages();
+
+/**
+  Hint that a large buffer that is about to be filled is backed by transparent huge pages, reducing the TLB misses
+  of the writes to the buffer. Only the whole huge pages inside the buffer are advised. Has no effect if huge pages
+  are disabled, for buffers smaller than HUGE_PAGE_SIZE_MIN and on systems without transparent huge pages.
+
+  @param data Start of the buffer.
+  @param size Size of the buffer in bytes.
+ */
+void AdviseHugePages(void* data, unsigned long long size);
+
+
+#endif  // FST_MMAP_H
@@ -0,0 +1,313 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fstdefines.h>
+#include <fstrangeinput.h>
+
+
+using namespace std;
+
+
+// Input stream on the pages of a remote input. A source that fails to deliver a page results in a runtime_error
+// thrown from the read.
+class RangeInputStream : public istream
+{
+  RangeStreamBuf rangeBuf;
+
+public:
+  RangeInputStream(FstRangeInput &input) : istream(nullptr), rangeBuf(input)
+  {
+    rdbuf(&rangeBuf);
+    exceptions(ios_base::badbit);  // rethrow exceptions of the stream buffer
+  }
+};
+
+
+unsigned long long RangeStreamBuf::Position() const
+{
+  return gptr() == nullptr ? position : pageStart + (gptr() - eback());
+}
+
+
+streambuf::int_type RangeStreamBuf::underflow()
+{
+  if (gptr() != nullptr && gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+  unsigned long long pos = Position();
+  if (pos >= input.Size()) return traits_type::eof();
+
+  unsigned long long pageNr = pos / RANGE_PAGE_SIZE;
+  page = input.Page(pageNr);
+
+  if (!page)
+  {
+    throw(runtime_error("Error reading data from the remote fst file."));
+  }
+
+  pageStart = pageNr * RANGE_PAGE_SIZE;
+  char* data = page->data();
+  setg(data, data + (pos - pageStart), data + page->size());
+
+  return traits_type::to_int_type(*gptr());
+}
+
+
+streambuf::pos_type RangeStreamBuf::seekoff(off_type off, ios_base::seekdir dir, ios_base::openmode which)
+{
+  if (!(which & ios_base::in)) return pos_type(off_type(-1));
+
+  off_type newPos;
+
+  if (dir == ios_base::beg) newPos = off;
+  else if (dir == ios_base::cur) newPos = (off_type) Position() + off;
+  else newPos = (off_type) input.Size() + off;
+
+  if (newPos < 0 || newPos > (off_type) input.Size()) return pos_type(off_type(-1));
+
+  // Positions in the current page don't require a new page
+  if (gptr() != nullptr && (unsigned long long) newPos >= pageStart &&
+    (unsigned long long) newPos < pageStart + (egptr() - eback()))
+  {
+    setg(eback(), eback() + (newPos - pageStart), egptr());
+    return pos_type(newPos);
+  }
+
+  setg(nullptr, nullptr, nullptr);
+  page.reset();
+  position = newPos;
+
+  return pos_type(newPos);
+}
+
+
+streambuf::pos_type RangeStreamBuf::seekpos(pos_type pos, ios_base::openmode which)
+{
+  return seekoff(off_type(pos), ios_base::beg, which);
+}
+
+
+streamsize RangeStreamBuf::xsgetn(char* s, streamsize n)
+{
+  streamsize nrOfBytes = 0;
+
+  while (nrOfBytes < n)
+  {
+    if (gptr() == egptr() && traits_type::eq_int_type(underflow(), traits_type::eof())) break;
+
+    streamsize count = min((streamsize) (egptr() - gptr()), n - nrOfBytes);
+    memcpy(s + nrOfBytes, gptr(), count);
+    gbump((int) count);
+    nrOfBytes += count;
+  }
+
+  return nrOfBytes;
+}
+
+
+FstRangeInput::FstRangeInput(IRangeSource* source, unsigned long long cacheSize) : source(source)
+{
+  fileSize = source->Size();
+  maxPages = max(cacheSize / RANGE_PAGE_SIZE, (unsigned long long) 2);
+  nrOfRequests = 0;
+  bytesRead = 0;
+}
+
+
+istream* FstRangeInput::OpenStream()
+{
+  if (fileSize == 0) return nullptr;
+
+  return new RangeInputStream(*this);
+}
+
+
+shared_ptr<vector<char>> FstRangeInput::FindPage(unsigned long long pageNr)
+{
+  shared_ptr<vector<char>> page;
+
+#pragma omp critical (range_input)
+  {
+    auto pos = pageMap.find(pageNr);
+
+    if (pos != pageMap.end())
+    {
+      pages.splice(pages.begin(), pages, pos->second);  // most recently used
+      page = pos->second->second;
+    }
+  }
+
+  return page;
+}
+
+
+void FstRangeInput::InsertPage(unsigned long long pageNr, shared_ptr<vector<char>> page)
+{
+#pragma omp critical (range_input)
+  {
+    if (pageMap.find(pageNr) == pageMap.end())
+    {
+      pages.push_front(make_pair(pageNr, page));
+      pageMap[pageNr] = pages.begin();
+
+      // Release the least recently used pages
+      while (pages.size() > maxPages)
+      {
+        pageMap.erase(pages.back().first);
+        pages.pop_back();
+      }
+    }
+  }
+}
+
+
+bool FstRangeInput::FetchPages(const vector<pair<unsigned long long, unsigned long long>> &runs)
+{
+  unsigned int nrOfRuns = (unsigned int) runs.size();
+
+  vector<unsigned long long> offsets(nrOfRuns);
+  vector<unsigned long long> sizes(nrOfRuns);
+  vector<vector<char>> runData(nrOfRuns);
+  vector<char*> buffers(nrOfRuns);
+
+  for (unsigned int runNr = 0; runNr < nrOfRuns; ++runNr)
+  {
+    offsets[runNr] = runs[runNr].first * RANGE_PAGE_SIZE;
+    sizes[runNr] = min(runs[runNr].second * RANGE_PAGE_SIZE, fileSize - offsets[runNr]);
+    runData[runNr].resize(sizes[runNr]);
+    buffers[runNr] = runData[runNr].data();
+  }
+
+  if (!source->ReadRanges(nrOfRuns, offsets.data(), sizes.data(), buffers.data())) return false;
+
+#pragma omp critical (range_input)
+  {
+    ++nrOfRequests;
+    for (unsigned long long size : sizes) bytesRead += size;
+  }
+
+  // Split the runs into pages
+  for (unsigned int runNr = 0; runNr < nrOfRuns; ++runNr)
+  {
+    for (unsigned long long pageOffset = 0; pageOffset < sizes[runNr]; pageOffset += RANGE_PAGE_SIZE)
+    {
+      const char* pageData = buffers[runNr] + pageOffset;
+      unsigned long long pageSize = min((unsigned long long) RANGE_PAGE_SIZE, sizes[runNr] - pageOffset);
+
+      InsertPage((offsets[runNr] + pageOffset) / RANGE_PAGE_SIZE,
+        make_shared<vector<char>>(pageData, pageData + pageSize));
+    }
+  }
+
+  return true;
+}
+
+
+shared_ptr<vector<char>> FstRangeInput::Page(unsigned long long pageNr)
+{
+  shared_ptr<vector<char>> page = FindPage(pageNr);
+  if (page) return page;
+
+  unsigned long long offset = pageNr * RANGE_PAGE_SIZE;
+  if (offset >= fileSize) return nullptr;
+
+  unsigned long long size = min((unsigned long long) RANGE_PAGE_SIZE, fileSize - offset);
+  page = make_shared<vector<char>>(size);
+  char* buffer = page->data();
+
+  if (!source->ReadRanges(1, &offset, &size, &buffer)) return nullptr;
+
+#pragma omp critical (range_input)
+  {
+    ++nrOfRequests;
+    bytesRead += size;
+  }
+
+  InsertPage(pageNr, page);
+
+  return page;
+}
+
+
+void FstRangeInput::Prefetch(unsigned long long offset, unsigned long long size)
+{
+  PrefetchRanges(vector<pair<unsigned long long, unsigned long long>>(1, make_pair(offset, size)));
+}
+
+
+void FstRangeInput::PrefetchRanges(const vector<pair<unsigned long long, unsigned long long>> &ranges)
+{
+  // Only half of the cache is filled, so prefetched pages don't evict each other before they are read.
+  // Pages beyond that are read on demand.
+  unsigned long long maxPrefetch = maxPages / 2;
+
+  // Runs of missing pages as (first page, number of pages)
+  vector<pair<unsigned long long, unsigned long long>> runs;
+  unsigned long long nextPage = 0;  // pages before nextPage are handled
+  unsigned long long nrOfPages = 0;
+  unsigned long long pagesPerRequest = max((unsigned long long) RANGE_MAX_REQUEST / RANGE_PAGE_SIZE, 1ULL);
+
+  for (const pair<unsigned long long, unsigned long long> &range : ranges)
+  {
+    if (range.second == 0 || range.first >= fileSize) continue;
+
+    unsigned long long firstPage = max(range.first / RANGE_PAGE_SIZE, nextPage);
+    unsigned long long endPage = (min(range.first + range.second, fileSize) - 1) / RANGE_PAGE_SIZE;
+
+    for (unsigned long long pageNr = firstPage; pageNr <= endPage && nrOfPages < maxPrefetch; ++pageNr)
+    {
+      if (FindPage(pageNr)) continue;
+
+      ++nrOfPages;
+
+      // Extend the last run with the next page
+      if (!runs.empty() && runs.back().first + runs.back().second == pageNr && runs.back().second < pagesPerRequest)
+      {
+        ++runs.back().second;
+        continue;
+      }
+
+      runs.push_back(make_pair(pageNr, 1ULL));
+    }
+
+    nextPage = max(nextPage, endPage + 1);
+  }
+
+  // Failures are ignored here, the pages are requested again when they are read
+  if (!runs.empty()) FetchPages(runs);
+}
@@ -0,0 +1,156 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_RANGE_INPUT_H
+#define FST_RANGE_INPUT_H
+
+
+#include <list>
+#include <memory>
+#include <streambuf>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <ifstio.h>
+
+
+class FstRangeInput;
+
+
+/**
+  Read-only stream buffer on top of the pages of a remote input. The page that holds the read position is
+  requested from the input when it is first read, so only the parts of the file that are actually read are
+  transferred.
+*/
+class RangeStreamBuf : public std::streambuf
+{
+  FstRangeInput &input;
+  std::shared_ptr<std::vector<char>> page;  // page at the read position (keeps it alive when it's evicted)
+  unsigned long long pageStart;             // file position of the first byte of the current page
+  unsigned long long position;              // read position when no page is set
+
+  unsigned long long Position() const;
+
+public:
+  RangeStreamBuf(FstRangeInput &input) : input(input), pageStart(0), position(0) {}
+
+protected:
+  int_type underflow();
+
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in);
+
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in);
+
+  std::streamsize xsgetn(char* s, std::streamsize n);
+};
+
+
+/**
+  Read a fst file from a remote source that supports random access to byte ranges, such as an object store
+  accessed with HTTP range requests. The file is read in pages of RANGE_PAGE_SIZE bytes, which are kept in a cache
+  of the least recently used pages. Before the selected columns are read, their byte ranges are prefetched: missing
+  pages are coalesced into requests of at most RANGE_MAX_REQUEST bytes that are handed to the source in a single
+  call, so the source can fetch them concurrently. Streams of the input throw a runtime_error when the source fails
+  to deliver a page.
+*/
+class FstRangeInput : public IFstInput
+{
+  IRangeSource* source;
+  unsigned long long fileSize;
+  unsigned long long maxPages;  // maximum number of cached pages
+  unsigned long long nrOfRequests;
+  unsigned long long bytesRead;
+
+  // Cached pages, most recently used first
+  std::list<std::pair<unsigned long long, std::shared_ptr<std::vector<char>>>> pages;
+  std::unordered_map<unsigned long long, std::list<std::pair<unsigned long long,
+    std::shared_ptr<std::vector<char>>>>::iterator> pageMap;
+
+  std::shared_ptr<std::vector<char>> FindPage(unsigned long long pageNr);
+
+  void InsertPage(unsigned long long pageNr, std::shared_ptr<std::vector<char>> page);
+
+  // Fetch runs of consecutive pages from the source and add them to the cache
+  bool FetchPages(const std::vector<std::pair<unsigned long long, unsigned long long>> &runs);
+
+public:
+  /**
+   Create an input on a remote source.
+
+   @param source Source of the file data, owned by the input.
+   @param cacheSize Maximum size of the cached pages in bytes.
+   */
+  FstRangeInput(IRangeSource* source, unsigned long long cacheSize);
+
+  ~FstRangeInput() { delete source; }
+
+  std::istream* OpenStream();
+
+  bool ConcurrentStreams() { return source->IsThreadSafe(); }
+
+  bool CanPrefetch() { return true; }
+
+  void Prefetch(unsigned long long offset, unsigned long long size);
+
+  void PrefetchRanges(const std::vector<std::pair<unsigned long long, unsigned long long>> &ranges);
+
+  /**
+   Page of the file, read from the source when it isn't cached.
+
+   @param pageNr Page number, the page starts at file position pageNr * RANGE_PAGE_SIZE.
+   @return The page data (smaller than RANGE_PAGE_SIZE for the last page) or nullptr if the source failed.
+   */
+  std::shared_ptr<std::vector<char>> Page(unsigned long long pageNr);
+
+  /**
+   Size of the file in bytes.
+   */
+  unsigned long long Size() const { return fileSize; }
+
+  /**
+   Number of requests issued to the source (each can contain multiple ranges).
+   */
+  unsigned long long NrOfRequests() const { return nrOfRequests; }
+
+  /**
+   Number of bytes read from the source.
+   */
+  unsigned long long BytesRead() const { return bytesRead; }
+};
+
+
+#endif  // FST_RANGE_INPUT_H
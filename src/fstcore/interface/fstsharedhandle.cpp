@@ -0,0 +1,137 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#include <stdexcept>
+
+#include <fstio.h>
+#include <fstsharedhandle.h>
+
+
+using namespace std;
+
+
+FstSharedHandle::FstSharedHandle(IFstInput* input) : input(input), nameFactory(vector<FstColumnType>())
+{
+  handle = new FstHandle(*input, &nameFactory);
+}
+
+
+FstSharedHandle::~FstSharedHandle()
+{
+  delete handle;
+  delete input;
+}
+
+
+shared_ptr<const FstSharedHandle> FstSharedHandle::Open(const char* fileName, bool memoryMapped)
+{
+  bool opened;
+  IFstInput* input;
+
+  if (memoryMapped)
+  {
+    FstMappedFileInput* mappedInput = new FstMappedFileInput();
+    opened = mappedInput->Open(fileName);
+    input = mappedInput;
+  }
+  else
+  {
+    FstSharedFileInput* fileInput = new FstSharedFileInput();
+    opened = fileInput->Open(fileName);
+    input = fileInput;
+  }
+
+  shared_ptr<FstSharedHandle> sharedHandle(new FstSharedHandle(input));
+
+  if (!opened)
+  {
+    throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+  }
+
+  if (!sharedHandle->handle->Open())
+  {
+    throw(runtime_error("The fst file uses a deprecated format, please resave the file with a recent fst version."));
+  }
+
+  sharedHandle->handle->ReadAllMetadata();
+
+  return sharedHandle;
+}
+
+
+unsigned long long FstSharedHandle::ReadRows(IFstTableReader &tableReader, IColumnFactory* columnFactory,
+  const vector<int> &colIndex, unsigned long long firstRow, unsigned long long length, int nrOfThreads) const
+{
+  unique_ptr<istream> stream(input->OpenStream());
+
+  if (!stream)
+  {
+    throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+  }
+
+  return handle->ReadRows(tableReader, columnFactory, *stream, colIndex, firstRow, length, nrOfThreads);
+}
+
+
+unsigned long long FstSharedHandle::ReadRowSet(IFstTableReader &tableReader, IColumnFactory* columnFactory,
+  const vector<int> &colIndex, const unsigned long long* rows, unsigned long long nrOfSel, int nrOfThreads) const
+{
+  if (nrOfSel == 0)
+  {
+    throw(runtime_error("Row selection is empty."));
+  }
+
+  unique_ptr<istream> stream(input->OpenStream());
+
+  if (!stream)
+  {
+    throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+  }
+
+  return handle->ReadRowSet(tableReader, columnFactory, *stream, colIndex, rows, nrOfSel, nrOfThreads);
+}
+
+
+FstHandle* FstSharedHandle::OpenHandle(IColumnFactory* columnFactory) const
+{
+  unique_ptr<FstHandle> privateHandle(new FstHandle(*input, columnFactory));
+
+  if (!privateHandle->Open())
+  {
+    throw(runtime_error("The fst file uses a deprecated format, please resave the file with a recent fst version."));
+  }
+
+  return privateHandle.release();
+}
@@ -0,0 +1,155 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_SHARED_HANDLE_H
+#define FST_SHARED_HANDLE_H
+
+
+#include <memory>
+#include <vector>
+
+#include <fsthandle.h>
+#include <rowbatch.h>
+
+
+/**
+ Opened fst file that can be read by any number of threads concurrently. All metadata of the file is parsed when
+ the handle is opened: the header, column names, chunkset index, the position data of all data chunks and the
+ offsets of the column attributes. After that the handle is immutable, reads don't modify it and don't need locks.
+ Each read uses its own stream of the input. Files are read with positional reads on a single file descriptor (see
+ FstSharedFileInput), so the streams don't share a seek pointer, or through a memory mapping of the file.
+
+ Handles are reference counted (std::shared_ptr), the file is closed when the last reference is released. Reads
+ use the shared block cache when it's enabled (see SharedBlockCache), checksums are not verified on read.
+ */
+class FstSharedHandle
+{
+  IFstInput* input;
+  RowBatch nameFactory;  // creates the column names when the handle is opened
+  FstHandle* handle;
+
+  FstSharedHandle(IFstInput* input);
+
+public:
+  ~FstSharedHandle();
+
+  /**
+   Open a fst file for concurrent reads.
+
+   @param fileName Path of the fst file.
+   @param memoryMapped If true, the file is read through a memory mapping, otherwise with positional reads.
+   @return The opened handle.
+   @throws runtime_error if the file can't be opened or uses the deprecated (pre v0.7.3) file format.
+   */
+  static std::shared_ptr<const FstSharedHandle> Open(const char* fileName, bool memoryMapped = false);
+
+  /**
+   Total number of rows in the table.
+   */
+  unsigned long long NrOfRows() const { return handle->NrOfRows(); }
+
+  /**
+   Number of columns in the table.
+   */
+  int NrOfColumns() const { return handle->NrOfColumns(); }
+
+  /**
+   Name of a column, valid during the lifetime of the handle.
+   */
+  const char* ColumnName(int colNr) const { return handle->colNames->GetElement(colNr); }
+
+  /**
+   Column number of a column name, -1 if the table has no such column.
+   */
+  int ColumnIndex(const char* colName) const { return handle->ColumnIndex(colName); }
+
+  /**
+   Column type, as stored in the file (see FstHandle::ColumnType).
+   */
+  unsigned short int ColumnType(int colNr) const { return handle->ColumnType(colNr); }
+
+  /**
+   Determine the column numbers of a column selection (see FstHandle::SelectColumns).
+   */
+  void SelectColumns(IStringArray* columnSelection, std::vector<int> &colIndex) const
+  {
+    handle->SelectColumns(columnSelection, colIndex);
+  }
+
+  /**
+   Names of the selected columns and the positions of the key columns among them (see FstHandle::SelectedColumns).
+   */
+  void SelectedColumns(const std::vector<int> &colIndex, IStringArray* selectedCols, std::vector<int> &keyIndex) const
+  {
+    handle->SelectedColumns(colIndex, selectedCols, keyIndex);
+  }
+
+  /**
+   Read rows firstRow until firstRow + length (0-based) of the selected columns, as FstHandle::ReadRows. Can be
+   called from multiple threads simultaneously.
+
+   @param tableReader Table that receives the column vectors.
+   @param columnFactory Factory used to create the column vectors of this read.
+   @param colIndex Column numbers of the selected columns, determined with SelectColumns.
+   @param firstRow First row to read, should be smaller than the number of rows in the table.
+   @param length Number of rows to read.
+   @param nrOfThreads Number of threads used by this read for decompressing columns in parallel.
+   @return Number of rows read.
+   */
+  unsigned long long ReadRows(IFstTableReader &tableReader, IColumnFactory* columnFactory,
+    const std::vector<int> &colIndex, unsigned long long firstRow, unsigned long long length, int nrOfThreads) const;
+
+  /**
+   Read a set of rows (0-based, sorted in increasing order) of the selected columns, as FstHandle::ReadRowSet. Can
+   be called from multiple threads simultaneously.
+   */
+  unsigned long long ReadRowSet(IFstTableReader &tableReader, IColumnFactory* columnFactory,
+    const std::vector<int> &colIndex, const unsigned long long* rows, unsigned long long nrOfSel,
+    int nrOfThreads) const;
+
+  /**
+   Open a separate handle with its own stream of the input, for operations that need a FstHandle such as row filters
+   (see FstFilter). The handle is used by a single thread and parses the metadata of the file again, it should be
+   deleted before the last reference to this handle is released.
+
+   @param columnFactory Factory used to create the column names of the handle.
+   @return The opened handle, owned by the caller.
+   */
+  FstHandle* OpenHandle(IColumnFactory* columnFactory) const;
+};
+
+
+#endif  // FST_SHARED_HANDLE_H
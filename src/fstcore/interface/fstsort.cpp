@@ -0,0 +1,559 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <ifsttable.h>
+#include <icolumnfactory.h>
+
+#include <fstdefines.h>
+#include <fsthandle.h>
+#include <fstio.h>
+#include <fstsort.h>
+#include <fstwriter.h>
+#include <rowbatch.h>
+
+
+using namespace std;
+
+
+// Segments of the rows of a batch that are processed in parallel
+void SegmentBounds(unsigned long long nrOfRows, int nrOfThreads, vector<unsigned long long> &bounds)
+{
+  int nrOfSegments = (int) min((unsigned long long) max(nrOfThreads, 1), 1 + nrOfRows / 65536);
+
+  bounds.resize(nrOfSegments + 1);
+  for (int segment = 0; segment <= nrOfSegments; ++segment)
+  {
+    bounds[segment] = nrOfRows * segment / nrOfSegments;
+  }
+}
+
+
+// Stable LSD radix sort of order on keys, where keys[pos] is the key of order[pos]. Keys are sorted on 8-bit digits
+// and digits that are equal for all keys are skipped, for integer keys that's usually all but the lowest digits.
+// The digits of each segment of the keys are counted and scattered in parallel.
+void RadixSort(vector<unsigned long long> &keys, vector<unsigned long long> &order, int nrOfThreads)
+{
+  unsigned long long nrOfRows = keys.size();
+
+  vector<unsigned long long> bounds;
+  SegmentBounds(nrOfRows, nrOfThreads, bounds);
+  int nrOfSegments = (int) bounds.size() - 1;
+
+  unsigned long long orBits = 0;
+  unsigned long long andBits = ~0ULL;
+
+  for (unsigned long long pos = 0; pos < nrOfRows; ++pos)
+  {
+    orBits |= keys[pos];
+    andBits &= keys[pos];
+  }
+
+  vector<unsigned long long> counts(256 * nrOfSegments);
+  vector<unsigned long long> sortedKeys(nrOfRows);
+  vector<unsigned long long> sortedOrder(nrOfRows);
+
+  for (int shift = 0; shift < 64; shift += 8)
+  {
+    if ((((orBits ^ andBits) >> shift) & 0xFF) == 0) continue;
+
+    fill(counts.begin(), counts.end(), 0);
+
+#pragma omp parallel for schedule(static) num_threads(nrOfSegments)
+    for (int segment = 0; segment < nrOfSegments; ++segment)
+    {
+      unsigned long long* segmentCounts = &counts[256 * segment];
+
+      for (unsigned long long pos = bounds[segment]; pos < bounds[segment + 1]; ++pos)
+      {
+        ++segmentCounts[(keys[pos] >> shift) & 0xFF];
+      }
+    }
+
+    // Position of the first key of each digit of each segment, the segments of a digit are kept in order
+    unsigned long long offset = 0;
+
+    for (int digit = 0; digit < 256; ++digit)
+    {
+      for (int segment = 0; segment < nrOfSegments; ++segment)
+      {
+        unsigned long long count = counts[256 * segment + digit];
+        counts[256 * segment + digit] = offset;
+        offset += count;
+      }
+    }
+
+#pragma omp parallel for schedule(static) num_threads(nrOfSegments)
+    for (int segment = 0; segment < nrOfSegments; ++segment)
+    {
+      unsigned long long* segmentOffsets = &counts[256 * segment];
+
+      for (unsigned long long pos = bounds[segment]; pos < bounds[segment + 1]; ++pos)
+      {
+        unsigned long long newPos = segmentOffsets[(keys[pos] >> shift) & 0xFF]++;
+        sortedKeys[newPos] = keys[pos];
+        sortedOrder[newPos] = order[pos];
+      }
+    }
+
+    keys.swap(sortedKeys);
+    order.swap(sortedOrder);
+  }
+}
+
+
+class StringLess
+{
+  StringVectorColumn &column;
+
+public:
+  StringLess(StringVectorColumn &column) : column(column) {}
+
+  bool operator()(unsigned long long posA, unsigned long long posB) const
+  {
+    if (column.isNA[posA] || column.isNA[posB]) return column.isNA[posA] > column.isNA[posB];  // NA first
+
+    return column.strings[posA] < column.strings[posB];
+  }
+};
+
+
+// Stable sort of order on the elements of a character column. Segments are sorted in parallel and merged pairwise,
+// with the merges of each round in parallel.
+void SortStrings(StringVectorColumn &column, vector<unsigned long long> &order, int nrOfThreads)
+{
+  vector<unsigned long long> bounds;
+  SegmentBounds(order.size(), nrOfThreads, bounds);
+  int nrOfSegments = (int) bounds.size() - 1;
+
+  StringLess stringLess(column);
+
+#pragma omp parallel for schedule(static) num_threads(nrOfSegments)
+  for (int segment = 0; segment < nrOfSegments; ++segment)
+  {
+    stable_sort(order.begin() + bounds[segment], order.begin() + bounds[segment + 1], stringLess);
+  }
+
+  for (int width = 1; width < nrOfSegments; width *= 2)
+  {
+    int nrOfMerges = (nrOfSegments + 2 * width - 1) / (2 * width);
+
+#pragma omp parallel for schedule(static) num_threads(nrOfMerges)
+    for (int merge = 0; merge < nrOfMerges; ++merge)
+    {
+      int first = 2 * merge * width;
+      int middle = min(first + width, nrOfSegments);
+      int last = min(first + 2 * width, nrOfSegments);
+
+      if (middle < last)
+      {
+        inplace_merge(order.begin() + bounds[first], order.begin() + bounds[middle], order.begin() + bounds[last],
+          stringLess);
+      }
+    }
+  }
+}
+
+
+// Order of the rows of a batch on its key columns. The rows are sorted on each key column with a stable sort, from
+// the last key column to the first.
+void SortOrder(RowBatch &batch, const vector<int> &keyColPos, int nrOfThreads, vector<unsigned long long> &order)
+{
+  long long nrOfRows = (long long) batch.nrOfRows;
+
+  order.resize(nrOfRows);
+  iota(order.begin(), order.end(), 0ULL);
+
+  vector<unsigned long long> keys;
+
+  for (int keyNr = (int) keyColPos.size() - 1; keyNr >= 0; --keyNr)
+  {
+    int colNr = keyColPos[keyNr];
+
+    if (batch.colTypes[colNr] == FstColumnType::CHARACTER)
+    {
+      SortStrings(batch.strings[colNr], order, nrOfThreads);
+      continue;
+    }
+
+    keys.resize(nrOfRows);
+
+#pragma omp parallel for schedule(static) num_threads(nrOfThreads)
+    for (long long pos = 0; pos < nrOfRows; ++pos)
+    {
+      keys[pos] = NumericKey(batch, colNr, order[pos]);
+    }
+
+    RadixSort(keys, order, nrOfThreads);
+  }
+}
+
+
+// A sorted run of the run file, of which the key columns are read in parts
+class MergeSource
+{
+public:
+  FstHandle &runs;
+  unsigned long long partRow;  // first row of the part that was read
+  unsigned long long nextRow;  // first row of the run that is not read yet
+  unsigned long long endRow;
+  RowBatch keys;               // key columns of the part
+  unsigned long long pos;      // current row of the part
+
+  MergeSource(FstHandle &runs, unsigned long long firstRow, unsigned long long endRow,
+    const vector<FstColumnType> &keyTypes) :
+    runs(runs), partRow(firstRow), nextRow(firstRow), endRow(endRow), keys(keyTypes), pos(0) {}
+
+  // Read the key columns of the next part of at most maxRows rows, returns false if all rows were read
+  bool Read(const vector<int> &keyColPos, unsigned long long maxRows, int nrOfThreads)
+  {
+    pos = 0;
+
+    if (nextRow == endRow) return false;
+
+    unsigned long long length = min(maxRows, endRow - nextRow);
+    IColumnFactory* columnFactory = runs.SetColumnFactory(&keys);
+
+    try
+    {
+      runs.ReadRows(keys, keyColPos, nextRow, length, nrOfThreads);
+    }
+    catch (const std::runtime_error &)
+    {
+      runs.SetColumnFactory(columnFactory);
+      throw;
+    }
+
+    runs.SetColumnFactory(columnFactory);
+    partRow = nextRow;
+    nextRow += length;
+
+    return true;
+  }
+
+  // Row of the run file of the current row
+  unsigned long long Row() { return partRow + pos; }
+};
+
+
+// Orders the sources on their current row, the source with the smallest row is on top of the queue. Rows with equal
+// keys are taken from the runs in the order in which the runs were written.
+class SourceGreater
+{
+  vector<MergeSource*> *sources;
+  const vector<int> *keyIndex;
+
+public:
+  SourceGreater(vector<MergeSource*> &sources, const vector<int> &keyIndex) : sources(&sources),
+    keyIndex(&keyIndex) {}
+
+  bool operator()(int sourceA, int sourceB) const
+  {
+    MergeSource &a = *(*sources)[sourceA];
+    MergeSource &b = *(*sources)[sourceB];
+
+    int order = CompareRows(a.keys, a.pos, b.keys, b.pos, *keyIndex);
+
+    if (order != 0) return order > 0;
+
+    return sourceA > sourceB;
+  }
+};
+
+
+// Read the merged rows (in merge order) from the run file and write them as a data chunk of the sorted file
+void WriteMerged(FstHandle &runs, RowBatch &output, const vector<int> &colIndex,
+  const vector<unsigned long long> &mergedRows, FstWriter &writer, int nrOfThreads)
+{
+  unsigned long long nrOfRows = mergedRows.size();
+
+  // The rows are read in file order
+  vector<unsigned long long> readOrder(nrOfRows);
+  iota(readOrder.begin(), readOrder.end(), 0ULL);
+
+  sort(readOrder.begin(), readOrder.end(), [&mergedRows](unsigned long long posA, unsigned long long posB)
+  {
+    return mergedRows[posA] < mergedRows[posB];
+  });
+
+  vector<unsigned long long> rows(nrOfRows);
+  vector<unsigned long long> order(nrOfRows);
+
+  for (unsigned long long pos = 0; pos < nrOfRows; ++pos)
+  {
+    rows[pos] = mergedRows[readOrder[pos]];
+    order[readOrder[pos]] = pos;
+  }
+
+  IColumnFactory* columnFactory = runs.SetColumnFactory(&output);
+
+  try
+  {
+    runs.ReadRowSet(output, colIndex, rows.data(), nrOfRows, nrOfThreads);
+  }
+  catch (const std::runtime_error &)
+  {
+    runs.SetColumnFactory(columnFactory);
+    throw;
+  }
+
+  runs.SetColumnFactory(columnFactory);
+
+  output.Permute(order, nrOfThreads);
+  writer.WriteBatch(output);
+}
+
+
+// Merge the runs into the sorted file. The output batch holds the layout of the table.
+void MergeRuns(FstHandle &runs, RowBatch &output, unsigned long long batchRows, const char* fileName, int compress,
+  int nrOfThreads)
+{
+  vector<int> colIndex(output.NrOfColumns());
+  iota(colIndex.begin(), colIndex.end(), 0);
+
+  // Key columns of the parts of the runs that are read
+  vector<FstColumnType> keyTypes;
+  vector<int> keyIndex;
+
+  for (unsigned int keyNr = 0; keyNr < output.keyColPos.size(); ++keyNr)
+  {
+    keyTypes.push_back(output.colTypes[output.keyColPos[keyNr]]);
+    keyIndex.push_back(keyNr);
+  }
+
+  vector<MergeSource*> sources;
+
+  for (unsigned int chunkNr = 0; chunkNr < runs.NrOfChunks(); ++chunkNr)
+  {
+    unsigned long long firstRow = runs.ChunkFirstRow(chunkNr);
+    sources.push_back(new MergeSource(runs, firstRow, firstRow + runs.ChunkNrOfRows(chunkNr), keyTypes));
+  }
+
+  // The sources share the memory of a single batch
+  unsigned long long sourceRows = max(1 + batchRows / sources.size(), (unsigned long long) 1024);
+
+  FstWriter writer(fileName, compress, nrOfThreads, &output);
+  writer.SetSortedBatches(true);
+
+  vector<unsigned long long> mergedRows;
+  mergedRows.reserve(batchRows);
+
+  try
+  {
+    SourceGreater sourceGreater(sources, keyIndex);
+    priority_queue<int, vector<int>, SourceGreater> queue(sourceGreater);
+
+    for (unsigned int sourceNr = 0; sourceNr < sources.size(); ++sourceNr)
+    {
+      if (sources[sourceNr]->Read(output.keyColPos, sourceRows, nrOfThreads)) queue.push(sourceNr);
+    }
+
+    while (!queue.empty())
+    {
+      int sourceNr = queue.top();
+      queue.pop();
+
+      MergeSource &source = *sources[sourceNr];
+      mergedRows.push_back(source.Row());
+
+      if (mergedRows.size() == batchRows)
+      {
+        WriteMerged(runs, output, colIndex, mergedRows, writer, nrOfThreads);
+        mergedRows.clear();
+      }
+
+      if (++source.pos == source.keys.nrOfRows && !source.Read(output.keyColPos, sourceRows, nrOfThreads)) continue;
+
+      queue.push(sourceNr);
+    }
+
+    if (!mergedRows.empty()) WriteMerged(runs, output, colIndex, mergedRows, writer, nrOfThreads);
+
+    writer.Close();
+  }
+  catch (const std::runtime_error &)
+  {
+    for (vector<MergeSource*>::iterator it = sources.begin(); it != sources.end(); ++it) delete *it;
+    throw;
+  }
+
+  for (vector<MergeSource*>::iterator it = sources.begin(); it != sources.end(); ++it) delete *it;
+}
+
+
+FstSorter::FstSorter(const char* fileName, const char* runFileName, const vector<string> &keyNames, int compress,
+  int nrOfThreads, IColumnFactory* columnFactory) : fileName(fileName), runFileName(runFileName), keyNames(keyNames),
+  compress(compress), nrOfThreads(max(nrOfThreads, 1)), runWriter(runFileName, compress, max(nrOfThreads, 1),
+  columnFactory)
+{
+  isClosed  = false;
+  nrOfRows  = 0;
+  batchRows = 0;
+}
+
+
+// The runs of a sorter that wasn't closed are discarded
+FstSorter::~FstSorter()
+{
+  if (isClosed || nrOfRows == 0) return;
+
+  try
+  {
+    runWriter.Close();
+  }
+  catch (const std::runtime_error &)
+  {
+  }
+
+  remove(runFileName.c_str());
+}
+
+
+void FstSorter::WriteBatch(IFstTable &batch)
+{
+  if (isClosed)
+  {
+    throw(runtime_error("The fst writer is closed."));
+  }
+
+  if (batch.NrOfColumns() == 0)
+  {
+    throw(runtime_error("Your dataset needs at least one column."));
+  }
+
+  if (batch.NrOfRows() == 0)
+  {
+    throw(runtime_error("The dataset contains no data."));
+  }
+
+  RowBatch rows(colTypes);
+  rows.Assign(batch);
+
+  // The first batch defines the layout of the table and the positions of the sort columns
+  if (colTypes.empty())
+  {
+    vector<int> sortColumns;
+
+    for (vector<string>::iterator key = keyNames.begin(); key != keyNames.end(); ++key)
+    {
+      vector<string> &names = rows.colNames.strings;
+      vector<string>::iterator colName = find(names.begin(), names.end(), *key);
+
+      if (colName == names.end())
+      {
+        throw(runtime_error("Sort column '" + *key + "' is not a column of the table."));
+      }
+
+      int colNr = (int) (colName - names.begin());
+      FstColumnType colType = rows.colTypes[colNr];
+
+      if (colType == FstColumnType::FACTOR)
+      {
+        throw(runtime_error("Only character, integer, double, logical, integer64, date and timestamp columns can "
+          "be sorted on."));
+      }
+
+      sortColumns.push_back(colNr);
+    }
+
+    colTypes = rows.colTypes;
+    colNames = rows.colNames.strings;
+    colAttributes = rows.colAttributes;
+    keyColPos = sortColumns;
+  }
+  else if (rows.colTypes.size() != colTypes.size())
+  {
+    throw(runtime_error(FSTERROR_INCORRECT_COL_COUNT));
+  }
+  else if (rows.colTypes != colTypes)
+  {
+    throw(runtime_error(FSTERROR_INCORRECT_COL_TYPE));
+  }
+
+  vector<unsigned long long> order;
+  SortOrder(rows, keyColPos, nrOfThreads, order);
+  rows.Permute(order, nrOfThreads);
+
+  runWriter.WriteBatch(rows);
+
+  nrOfRows += rows.nrOfRows;
+  batchRows = max(batchRows, rows.nrOfRows);
+}
+
+
+void FstSorter::Close()
+{
+  if (isClosed) return;
+
+  isClosed = true;
+  runWriter.Close();
+
+  if (nrOfRows == 0) return;
+
+  try
+  {
+    RowBatch output(colTypes);
+    output.colNames.AllocateVec(colNames.size());
+    output.colNames.strings = colNames;
+    output.colAttributes = colAttributes;
+    output.keyColPos = keyColPos;
+
+    FstFileInput runInput(runFileName.c_str());
+    FstHandle runs(runInput, &output);
+
+    if (!runs.Open())
+    {
+      throw(runtime_error("The temporary file with the sorted runs could not be read."));
+    }
+
+    MergeRuns(runs, output, batchRows, fileName.c_str(), compress, nrOfThreads);
+  }
+  catch (const std::runtime_error &)
+  {
+    remove(runFileName.c_str());
+    throw;
+  }
+
+  remove(runFileName.c_str());
+}
@@ -0,0 +1,115 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_SORT_H
+#define FST_SORT_H
+
+
+#include <string>
+#include <vector>
+
+#include <icolumnfactory.h>
+#include <ifsttable.h>
+#include <fstwriter.h>
+
+
+/**
+ Writes a fst file that is sorted on one or more key columns from a sequence of unsorted row batches, for tables
+ that don't fit in memory. The file is keyed on the sort columns, like a table sorted with setkey, with NA values
+ first and character values in byte (C locale) order. Rows with equal keys keep the order in which they were
+ written.
+
+ The file is written with an external merge sort: each batch is sorted with multiple threads (a radix sort for
+ numerical keys) and stored as a data chunk (a sorted run) of a temporary fst file. When the sorter is closed, the
+ runs are merged in a single pass into data chunks of the size of the largest batch. Memory use is limited to
+ about two batches, independent of the size of the table.
+ */
+class FstSorter
+{
+  std::string fileName;
+  std::string runFileName;
+  std::vector<std::string> keyNames;
+  int compress;
+  int nrOfThreads;
+
+  FstWriter runWriter;
+  bool isClosed;
+
+  // Layout of the table, taken from the first batch
+  std::vector<FstColumnType> colTypes;
+  std::vector<std::string> colNames;
+  std::vector<std::vector<char>> colAttributes;
+  std::vector<int> keyColPos;
+
+  unsigned long long nrOfRows;
+  unsigned long long batchRows;  // rows of the largest batch
+
+public:
+  /**
+   @param fileName Path of the sorted fst file, an existing file is overwritten when the sorter is closed.
+   @param runFileName Path of the temporary file with the sorted runs, which is removed afterwards.
+   @param keyNames Names of the sort columns, in order of precedence. Character, integer, double, logical, 64-bit
+     integer, date and timestamp columns can be used.
+   @param compress Compression level (0 - 100) of the sorted file.
+   @param nrOfThreads Number of threads used for sorting, decompressing and compressing.
+   @param columnFactory Factory used to read the stored column names of the run file.
+   */
+  FstSorter(const char* fileName, const char* runFileName, const std::vector<std::string> &keyNames, int compress,
+    int nrOfThreads, IColumnFactory* columnFactory);
+
+  ~FstSorter();
+
+  /**
+   Sort a batch of rows and store it as a sorted run. The batch should have the same column names and types as the
+   first batch. Key columns of the batch are ignored.
+
+   @throws runtime_error if a sort column is missing or has a type that can't be sorted.
+   */
+  void WriteBatch(IFstTable &batch);
+
+  /**
+   Merge the sorted runs into the sorted file. Further batches are refused. Without batches, no file is written.
+   */
+  void Close();
+
+  /**
+   Total number of rows written.
+   */
+  unsigned long long NrOfRows() { return nrOfRows; }
+};
+
+
+#endif  // FST_SORT_H
@@ -35,9 +35,12 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <stdexcept>
 #include <cstring>
 #include <algorithm>
+#include <vector>
+#include <unordered_map>
 
 #include <iblockrunner.h>
 #include <ifsttable.h>
@@ -45,12 +48,23 @@
 
 #include <fstdefines.h>
 #include <fststore.h>
+#include <fstwriter.h>
+#include <fsthandle.h>
+#include <fstio.h>
 
 #include <character_v6.h>
 #include <factor_v7.h>
 #include <integer_v8.h>
+#include <integer64_v11.h>
 #include <double_v9.h>
 #include <logical_v10.h>
+#include <zonemap.h>
+#include <checksum.h>
+#include <profile.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 using namespace std;
@@ -66,7 +80,8 @@ using namespace std;
 //  4                      | int                | tableClassType
 //  4                      | int                | keyLength
 //  4                      | int                | nrOfCols  (duplicate for fast access)
-//  4 * keyLength          | int                | keyColPos
+//  4 * keyLength          | int                | keyColPos (KEY_COL_DROPPED for key columns that were dropped
+//                         |                    | by appended rows, see FstWriter)
 //
 // Column chunkset info
 //
@@ -75,8 +90,11 @@ using namespace std;
 //  8                      | unsigned long long | nrOfRows
 //  4                      | unsigned int       | FST_VERSION
 //  4                      | int                | nrOfCols
-//  2 * nrOfCols           | unsigned short int | colAttributesType (not implemented yet)
-//  2 * nrOfCols           | unsigned short int | colTypes
+//  2 * nrOfCols           | unsigned short int | colAttributesType (flags COL_ATTR_ZONE_MAP, COL_ATTR_CHECKSUM,
+//                         |                    | COL_ATTR_ATTRIBUTES, COL_ATTR_BLOOM, COL_ATTR_PRECISION with
+//                         |                    | the kept mantissa bits in COL_ATTR_BITS_MASK, COL_ATTR_DELETED)
+//  2 * nrOfCols           | unsigned short int | colTypes (6 character, 7 factor, 8 integer, 9 double, 10 logical,
+//                         |                    | 11 64-bit integer, 12 date, 13 timestamp)
 //  2 * nrOfCols           | unsigned short int | colBaseTypes
 //  ?                      | char               | colNames
 //
@@ -91,18 +109,71 @@ using namespace std;
 //
 //  8 * nrOfCols           | unsigned long long | positionData
 //
+// Each chunkPos element points to the positionData of a data chunk. Chunks appended to an existing file are
+// written at the end of the file (positionData followed by the column data). When all slots of a chunkset
+// index are used, a new index is appended. The first appended index is linked from nextVertChunkSet, later
+// indexes from the link field of the previous index:
+//
+//  8                      | unsigned long long | nextVertChunkSet (0 for the last index)
+//  CHUNK_INDEX_SIZE       |                    | data chunkset index
+//
+// Columns appended to a stored table (see FstStore::fstCbind) are written at the end of the file as a new
+// horizontal chunkset, linked from nextHorzChunkSet of the previous chunkset. It starts with the column chunkset
+// info of the appended columns, followed by their column names, chunkset indexes, attribute section and data chunks
+// as above. Its data chunks hold the rows of the data chunks of the first chunkset.
+//
+// A column of an appended chunkset with the name of a column of a preceding chunkset replaces that column (see
+// FstStore::fstReplaceColumn) and columns with the COL_ATTR_DELETED flag are hidden (see FstStore::fstDeleteColumn).
+// The data of replaced and deleted columns remains in the file until it is copied with FstCopier.
+//
+// Columns with the COL_ATTR_ATTRIBUTES flag have their (encoded) attributes stored in the attribute section. The
+// section is located directly after the first chunkset index, or directly after the column names in the
+// append-only layout, where readers unaware of attributes never look:
+//
+//  8                      | unsigned long long | ATTRIBUTE_ID
+//  4 * nrOfCols           | unsigned int       | attributeSizes (0 for columns without attributes)
+//  ?                      | char               | attribute data of each column with attributes
+//
+// Columns with the COL_ATTR_ZONE_MAP flag store a zone map directly in front of the column data of each data
+// chunk (positionData points to the column data):
+//
+//  24 * nrOfBlocks        | ZoneMapEntry       | min, max, NA count and number of values per block
+//  8                      | unsigned long long | ZONE_MAP_ID
+//  4                      | unsigned int       | blockSizeElems
+//  4                      | unsigned int       | nrOfBlocks
+//
+// Columns with the COL_ATTR_BLOOM flag (integer, 64-bit integer and character columns) store Bloom filters of the
+// blocks of each data chunk directly in front of the checksum metadata:
+//
+//  8 * filterWords * nrOfBlocks | unsigned long long | Bloom filter bits of each block
+//  8                      | unsigned long long | BLOOM_FILTER_ID
+//  4                      | unsigned int       | bitsPerKey
+//  4                      | unsigned int       | nrOfHashes
+//  4                      | unsigned int       | filterWords (64-bit words in the filter of a single block)
+//  4                      | unsigned int       | nrOfBlocks
+//
+// Columns with the COL_ATTR_CHECKSUM flag store the checksum metadata directly in front of the zone map and a
+// checksum for each block written by the column writers directly after the column data:
+//
+//  8                      | unsigned long long | CHECKSUM_ID
+//  8                      | unsigned long long | dataSize (bytes of column data)
+//  8                      | unsigned long long | nrOfBlocks
+//  ...                    |                    | zone map and column data
+//  16 * nrOfBlocks        | ChecksumEntry      | size and XXH64 hash of each block
+//
 //
 
 FstStore::FstStore(std::string fstFile)
 {
   this->fstFile = fstFile;
   metaDataBlock = nullptr;
+  colAttributeTypes = nullptr;
   blockReader = nullptr;
 }
 
 
 // Read header information
-inline unsigned int ReadHeader(ifstream &myfile, unsigned int &tableClassType, int &keyLength, int &nrOfColsFirstChunk)
+unsigned int ReadHeader(istream &myfile, unsigned int &tableClassType, int &keyLength, int &nrOfColsFirstChunk)
 {
   // Get meta-information for table
   char tableMeta[TABLE_META_SIZE];
@@ -110,7 +181,6 @@ inline unsigned int ReadHeader(ifstream &myfile, unsigned int &tableClassType, i
 
   if (!myfile)
   {
-    myfile.close();
     throw(runtime_error("Error reading file header, your fst file is incomplete or damaged."));
   }
 
@@ -131,9 +201,8 @@ inline unsigned int ReadHeader(ifstream &myfile, unsigned int &tableClassType, i
   }
 
   // Compare file version with current
-  if (*p_table_version > FST_VERSION)
+  if (*p_table_version > FST_VERSION_STREAM)
   {
-    myfile.close();
     throw(runtime_error("Incompatible fst file: file was created by a newer version of the fst package."));
   }
 
@@ -141,616 +210,1290 @@ inline unsigned int ReadHeader(ifstream &myfile, unsigned int &tableClassType, i
 }
 
 
-inline void SetKeyIndex(vector<int> &keyIndex, int keyLength, int nrOfSelect, int* keyColPos, int* colIndex)
+int ValidKeyLength(const int* keyColPos, int keyLength)
+{
+  for (int keyNr = 0; keyNr < keyLength; ++keyNr)
+  {
+    if (keyColPos[keyNr] == KEY_COL_DROPPED) return keyNr;
+  }
+
+  return keyLength;
+}
+
+
+void ReadHorzChunkSets(istream &myfile, unsigned long long nextHorzChunkSet, vector<HorzChunkSet> &chunkSets)
+{
+  unsigned long long prevPos = 0;
+
+  while (nextHorzChunkSet != 0)
+  {
+    // Chunksets are appended, so each link points further into the file
+    if (nextHorzChunkSet <= prevPos)
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+
+    char header[32];
+    myfile.seekg(nextHorzChunkSet);
+    myfile.read(header, 32);
+
+    unsigned int* p_version = (unsigned int*) &header[24];
+    int* p_nrOfCols         = (int*) &header[28];
+
+    if (!myfile || *p_nrOfCols <= 0 || *p_version != FST_VERSION)
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+
+    HorzChunkSet chunkSet;
+    chunkSet.pos              = nextHorzChunkSet;
+    chunkSet.nextVertChunkSet = *(unsigned long long*) &header[8];
+    chunkSet.nrOfCols         = *p_nrOfCols;
+    chunkSet.colAttributeTypes.resize(chunkSet.nrOfCols);
+    chunkSet.colTypes.resize(chunkSet.nrOfCols);
+
+    myfile.read((char*) chunkSet.colAttributeTypes.data(), 2 * chunkSet.nrOfCols);
+    myfile.read((char*) chunkSet.colTypes.data(), 2 * chunkSet.nrOfCols);
+
+    if (!myfile)
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+
+    prevPos = nextHorzChunkSet;
+    nextHorzChunkSet = *(unsigned long long*) header;
+    chunkSets.push_back(chunkSet);
+  }
+}
+
+
+void VisibleColumns(IStringColumn* colNames, const unsigned short int* colAttributeTypes,
+  const vector<int> &chunkSetFirstCols, vector<int> &storedCols)
 {
-  for (int i = 0; i < keyLength; ++i)
+  vector<int> slots;  // stored column of each column of the table, -1 for deleted columns
+  unordered_map<string, unsigned int> nameSlots;  // slots of the column names of the preceding chunksets
+
+  for (unsigned int setNr = 0; setNr + 1 < chunkSetFirstCols.size(); ++setNr)
   {
-    int colSel = 0;
+    vector<pair<string, unsigned int>> setSlots;
 
-    for (; colSel < nrOfSelect; ++colSel)
+    for (int colNr = chunkSetFirstCols[setNr]; colNr < chunkSetFirstCols[setNr + 1]; ++colNr)
     {
-      if (keyColPos[i] == colIndex[colSel])  // key present in result
+      int storedCol = (colAttributeTypes[colNr] & COL_ATTR_DELETED) == 0 ? colNr : -1;
+      string colName = colNames->GetElement(colNr);
+
+      unordered_map<string, unsigned int>::iterator slot = nameSlots.find(colName);
+
+      if (slot != nameSlots.end())
       {
-        keyIndex.push_back(colSel);
-        break;
+        slots[slot->second] = storedCol;  // replaces the column of a preceding chunkset
+        continue;
       }
+
+      setSlots.push_back(make_pair(colName, (unsigned int) slots.size()));
+      slots.push_back(storedCol);
+    }
+
+    for (pair<string, unsigned int> &setSlot : setSlots)
+    {
+      nameSlots[setSlot.first] = setSlot.second;
     }
+  }
+
+  storedCols.clear();
 
-    // key column not selected
-    if (colSel == nrOfSelect) return;
+  for (int storedCol : slots)
+  {
+    if (storedCol >= 0) storedCols.push_back(storedCol);
   }
 }
 
 
-void FstStore::fstWrite(const char* fileName, IFstTable &fstTable, int compress)
+IStringColumn* SelectStrings(IColumnFactory* columnFactory, IStringColumn* strings, const vector<int> &elements)
 {
-  // SEXP keyNames = Rf_getAttrib(table, Rf_mkString("sorted"));
-
-  // Meta on dataset
-  int nrOfCols =  fstTable.NrOfColumns();
-  int keyLength = fstTable.NrOfKeys();
+  IStringColumn* selection = columnFactory->CreateStringColumn(elements.size());
+  selection->AllocateVec(elements.size());
 
-  if (nrOfCols == 0)
+  for (unsigned int elem = 0; elem < elements.size(); ++elem)
   {
-    throw(runtime_error("Your dataset needs at least one column."));
+    const char* str = strings->GetElement(elements[elem]);
+    unsigned int sizeMeta[2] = { (unsigned int) strlen(str), 0 };  // size and (no) NA bits of a single string
+
+    selection->BufferToVec(1, 0, 0, elem, sizeMeta, const_cast<char*>(str));
   }
 
+  return selection;
+}
 
-  // Table meta information
-  unsigned long long metaDataSize        = 56 + 4 * keyLength + 6 * nrOfCols;  // see index above
-  char* metaDataBlock                    = new char[metaDataSize];
 
-  unsigned long long* fstFileID          = (unsigned long long*) metaDataBlock;
-  unsigned int* p_table_version          = (unsigned int*) &metaDataBlock[8];
-  unsigned int* p_tableClassType         = (unsigned int*) &metaDataBlock[12];
-  int* p_keyLength                       = (int*) &metaDataBlock[16];
-  int* p_nrOfColsFirstChunk              = (int*) &metaDataBlock[20];
-  int* keyColPos                         = (int*) &metaDataBlock[24];
+// Exposes a range of elements of a character vector writer as a separate vector
+class BlockWriterRange : public IBlockWriter
+{
+  IBlockWriter* blockWriter;
+  unsigned long long firstElem;
 
-  unsigned int offset = 24 + 4 * keyLength;
+public:
+  BlockWriterRange(IBlockWriter* blockWriter, unsigned long long firstElem, unsigned long long nrOfElements)
+  {
+    this->blockWriter = blockWriter;
+    this->firstElem   = firstElem;
+    vecLength         = nrOfElements;
+
+    strSizes  = blockWriter->strSizes;
+    naInts    = blockWriter->naInts;
+    bufSize   = blockWriter->bufSize;
+    activeBuf = blockWriter->activeBuf;
+  }
 
-  unsigned long long* p_nextHorzChunkSet = (unsigned long long*) &metaDataBlock[offset];
-  unsigned long long* p_nextVertChunkSet = (unsigned long long*) &metaDataBlock[offset + 8];
-  unsigned long long* p_nrOfRows         = (unsigned long long*) &metaDataBlock[offset + 16];
-  unsigned int* p_version                = (unsigned int*) &metaDataBlock[offset + 24];
-  int* p_nrOfCols                        = (int*) &metaDataBlock[offset + 28];
-  // unsigned short int* colAttributeTypes  = (unsigned short int*) &metaDataBlock[offset + 32];
-  unsigned short int* colTypes           = (unsigned short int*) &metaDataBlock[offset + 32 + 2 * nrOfCols];
-  unsigned short int* colBaseTypes       = (unsigned short int*) &metaDataBlock[offset + 32 + 4 * nrOfCols];
+  // Profiled writes count the string conversions of the table
+  void SetBuffersFromVec(unsigned long long startCount, unsigned long long endCount)
+  {
+    ProfileTimer timer(ProfilePhase::TABLE);
+    blockWriter->SetBuffersFromVec(firstElem + startCount, firstElem + endCount);
 
-  // Get key column positions
-  fstTable.GetKeyColumns(keyColPos);
+    strSizes  = blockWriter->strSizes;
+    naInts    = blockWriter->naInts;
+    bufSize   = blockWriter->bufSize;
+    activeBuf = blockWriter->activeBuf;
 
-  *fstFileID            = FST_FILE_ID;
-  *p_table_version      = FST_VERSION;
-  *p_tableClassType     = 1;  // default table
-  *p_keyLength          = keyLength;
-  *p_nrOfColsFirstChunk = nrOfCols;
+    ProfileData(4 * (endCount - startCount) + strSizes[endCount - startCount - 1]);
+  }
 
-  *p_nextHorzChunkSet   = 0;
-  *p_nextVertChunkSet   = 0;
-  *p_version            = FST_VERSION;
-  *p_nrOfCols           = nrOfCols;
+  bool GatherStrings(unsigned long long startCount, unsigned long long endCount, const char** strings,
+    unsigned int* sizes, unsigned int* naBits)
+  {
+    ProfileTimer timer(ProfilePhase::TABLE);
+    if (!blockWriter->GatherStrings(firstElem + startCount, firstElem + endCount, strings, sizes, naBits)) return false;
 
+    unsigned long long nrOfBytes = 4 * (endCount - startCount);
+    for (unsigned long long elem = 0; elem < endCount - startCount; ++elem) nrOfBytes += sizes[elem];
 
-  // data.frame code here for stability!
+    ProfileData(nrOfBytes);
+    return true;
+  }
+};
 
-  int nrOfRows = fstTable.NrOfRows();
-  *p_nrOfRows = nrOfRows;
 
+// Number of elements in a compression block of a column. Character columns use BLOCKSIZE_CHAR here, their block
+// size depends on the string sizes (see fdsCharBlockSize_v6). For the fixed width types, a requested block size (in bytes, 0 for the default) is rounded down to a multiple of
+// MIN_BLOCK_SIZE, which keeps blocks aligned with the repetition sizes of the fixed ratio compressors. Without a
+// requested size, long double columns at maximum compression use multithreaded segments (unless the algorithms
+// are selected adaptively).
+inline unsigned int ColumnBlockSize(FstColumnType colType, unsigned int blockSize, unsigned long long nrOfRows,
+  int compress, int nrOfThreads, bool adaptive)
+{
+  if (colType == FstColumnType::CHARACTER) return BLOCKSIZE_CHAR;
+
+  colType = ValueType(colType);  // dates and timestamps are stored as doubles
+  unsigned int elementSize = colType == FstColumnType::DOUBLE_64 || colType == FstColumnType::INT_64 ? 8 : 4;
 
-  if (nrOfRows == 0)
+  if (blockSize != 0)
   {
-    delete[] metaDataBlock;
-    throw(runtime_error("The dataset contains no data."));
+    blockSize = max(blockSize - blockSize % MIN_BLOCK_SIZE, (unsigned int) MIN_BLOCK_SIZE);
+    return min(blockSize, (unsigned int) MAX_BLOCK_SIZE) / elementSize;
   }
 
+  switch (colType)
+  {
+    case FstColumnType::DOUBLE_64:
+      if (!adaptive && compress == 100 && nrOfThreads > 1 && nrOfRows > SEGMENTSIZE_REAL) return SEGMENTSIZE_REAL;
+      return BLOCKSIZE_REAL;
 
-  // Create file, set fast local buffer and open
-  ofstream myfile;
-  char ioBuf[4096];
-  myfile.rdbuf()->pubsetbuf(ioBuf, 4096);  // workaround for memory leak in ofstream
-  myfile.open(fileName, ios::binary);
+    case FstColumnType::INT_64:
+      return BLOCKSIZE_INT64;
 
-  if (myfile.fail())
+    case FstColumnType::BOOL_32:
+      return BLOCKSIZE_LOGICAL;
+
+    default:
+      return BLOCKSIZE_INT;  // integers and factor level codes
+  }
+}
+
+
+// Serialize rows firstRow until firstRow + nrOfRows of a single column. Character and factor columns use the
+// string buffers of fstTable, so only one of those columns can be written at any given time. Other column
+// types only use colData. Blocks of fixed width columns are compressed with nrOfThreads threads, in blocks of
+// blockSize bytes (0 for the default block size of the column type). If goal is specified, the compression
+// algorithms of integer and double columns are selected per block to meet the goal. The column data is preceded by the checksum metadata and the zone map of the column, collected while the
+// blocks are written, and followed by the checksums of the blocks. Integer, 64-bit integer and character columns
+// with bloomBits bits per key store Bloom filters of their blocks in front of the checksum metadata. Double
+// columns with a non-zero mantissaBits are stored with their values rounded to that precision. With fastDecode,
+// integer and double columns use LZ4HC instead of ZSTD at high compression. Returns the offset of the column data
+// relative to the starting position.
+unsigned long long WriteColumn(ostream &myfile, IFstTable &fstTable, unsigned int colNr, FstColumnType colType,
+  char* colData, unsigned long long firstRow, unsigned long long nrOfRows, int compress, int nrOfThreads,
+  unsigned int blockSize, const CompressionGoal* goal, unsigned int bloomBits, unsigned int mantissaBits,
+  bool fastDecode)
+{
+  ProfileColumn profileColumn(colNr, ProfilePhase::CODEC);
+
+  // The zone map holds the statistics of the blocks as written
+  unsigned int blockSizeElems = ColumnBlockSize(colType, blockSize, nrOfRows, compress, nrOfThreads, goal != nullptr);
+
+  IBlockWriter* blockRunner = nullptr;
+  IBlockWriter* charWriter = nullptr;  // string buffers of the selected rows
+
+  if (colType == FstColumnType::CHARACTER)
   {
-    delete[] metaDataBlock;
-    myfile.close();
-    throw(runtime_error("There was an error creating the file. Please check for a correct filename."));
+    blockRunner = fstTable.GetCharWriter(colNr);
+    charWriter = blockRunner;
+
+    if (firstRow != 0 || nrOfRows != blockRunner->vecLength || ProfileScope::Active() != nullptr)
+    {
+      charWriter = new BlockWriterRange(blockRunner, firstRow, nrOfRows);
+    }
+
+    blockSizeElems = fdsCharBlockSize_v6(charWriter);
   }
 
+  ZoneMap zoneMap(colType, nrOfRows, blockSizeElems);
+  ColumnChecksum checksum;
 
-  // Write table meta information
-  myfile.write((char*)(metaDataBlock), metaDataSize);  // table meta data
+  // The Bloom filters receive the values of the blocks added to the zone map
+  BloomFilter bloomFilter(colType, nrOfRows, blockSizeElems, BloomFilter::SupportsType(colType) ? bloomBits : 0);
+  if (bloomFilter.Enabled()) zoneMap.SetBloomFilter(&bloomFilter);
 
-  // Serialize column names
-  IBlockWriter* blockRunner = fstTable.GetColNameWriter();
-  fdsWriteCharVec_v6(myfile, blockRunner, 0);   // column names
+  // Space for the Bloom filters, checksum metadata and zone map, which are completed after the column data is written
+  unsigned long long metaPos = myfile.tellp();
+  unsigned long long colOffset = bloomFilter.StoredSize() + CHECKSUM_META_SIZE + zoneMap.StoredSize();
+  vector<char> metaSpace(colOffset, 0);
+  myfile.write(metaSpace.data(), metaSpace.size());
+
+  // The column data is hashed on its way to myfile
+  ChecksumStreamBuf checksumBuf(myfile.rdbuf(), checksum);
+  ostream colStream(&checksumBuf);
+
+  switch (colType)
+  {
+    case FstColumnType::CHARACTER:
+    {
+      fdsWriteCharVec_v6(colStream, charWriter, compress, &zoneMap, nrOfThreads);
 
-  // TODO: Write column attributes here
+      if (charWriter != blockRunner) delete charWriter;
+      delete blockRunner;
+      break;
+    }
+
+    case FstColumnType::FACTOR:
+    {
+      IBlockWriter* blockRunner = fstTable.GetLevelWriter(colNr);
+      fdsWriteFactorVec_v7(colStream, &((int*) colData)[firstRow], blockRunner, nrOfRows, compress, nrOfThreads,
+        blockSizeElems, &zoneMap);
+      delete blockRunner;
+      break;
+    }
+
+    case FstColumnType::INT_32:
+      fdsWriteIntVec_v8(colStream, &((int*) colData)[firstRow], nrOfRows, compress, nrOfThreads, blockSizeElems,
+        &zoneMap, goal, fastDecode);
+      break;
+
+    case FstColumnType::INT_64:
+      fdsWriteInt64Vec_v11(colStream, &((long long*) colData)[firstRow], nrOfRows, compress, nrOfThreads,
+        blockSizeElems, &zoneMap, goal, fastDecode);
+      break;
+
+    case FstColumnType::DOUBLE_64:
+    {
+      double* doubleVector = &((double*) colData)[firstRow];
 
-  // Vertical chunkset index or index of index
-  char* chunkIndex = new char[CHUNK_INDEX_SIZE + 8 * nrOfCols];
+      // The rounded values are compressed and collected in the zone map, the table itself is left untouched
+      vector<double> reducedVector;
+      if (mantissaBits != 0)
+      {
+        reducedVector.resize(nrOfRows);
+        ReduceRealPrecision(doubleVector, reducedVector.data(), nrOfRows, mantissaBits);
+        doubleVector = reducedVector.data();
+      }
+
+      fdsWriteRealVec_v9(colStream, doubleVector, nrOfRows, compress, nrOfThreads, blockSizeElems, &zoneMap, goal,
+        fastDecode);
+      break;
+    }
+
+    case FstColumnType::DATE_DAYS:
+    case FstColumnType::TIMESTAMP_SECONDS:
+      fdsWriteRealVec_v9(colStream, &((double*) colData)[firstRow], nrOfRows, compress, nrOfThreads, blockSizeElems,
+        &zoneMap, goal, fastDecode);
+      break;
+
+    case FstColumnType::BOOL_32:
+      fdsWriteLogicalVec_v10(colStream, &((int*) colData)[firstRow], nrOfRows, compress, nrOfThreads, blockSizeElems,
+        &zoneMap);
+      break;
+
+    default:
+      break;
+  }
 
-  unsigned long long* chunkPos                = (unsigned long long*) chunkIndex;
-  unsigned long long* chunkRows               = (unsigned long long*) &chunkIndex[64];
-  unsigned long long* p_nrOfChunksPerIndexRow = (unsigned long long*) &chunkIndex[128];
-  unsigned long long* p_nrOfChunks            = (unsigned long long*) &chunkIndex[136];
-  unsigned long long *positionData            = (unsigned long long*) &chunkIndex[144];  // column position index
+  if (!colStream) myfile.setstate(ios::badbit);
 
+  myfile.seekp(metaPos + colOffset + checksum.DataSize());
+  checksum.WriteEntries(myfile);
+  unsigned long long colEndPos = myfile.tellp();
 
-  *p_nrOfChunksPerIndexRow = 1;
-  *p_nrOfChunks            = 1;  // set to 0 if all reserved slots are used
-  *chunkRows               = (unsigned long long) nrOfRows;
+  myfile.seekp(metaPos);
+  bloomFilter.Write(myfile);
+  checksum.WriteMeta(myfile);
+  zoneMap.Write(myfile);
+  myfile.seekp(colEndPos);
 
+  return colOffset;
+}
 
-  // Row and column meta data
-  myfile.write((char*)(chunkIndex), CHUNK_INDEX_SIZE + 8 * nrOfCols);   // file positions of column data
 
-  // column data
+// Collect the stored column type, base type and data pointer of each column of fstTable. Returns false if the
+// table contains a column of an unknown type.
+bool SetColumnTypes(IFstTable &fstTable, int nrOfCols, unsigned short int* colTypes,
+  unsigned short int* colBaseTypes, char** colData)
+{
   for (int colNr = 0; colNr < nrOfCols; ++colNr)
   {
-    positionData[colNr] = myfile.tellp();  // current location
     FstColumnType colType = fstTable.GetColumnType(colNr);
     colBaseTypes[colNr] = (unsigned short int) colType;
 
-    // Store attributes here if any
-    // unsigned int attrBlockSize = SerializeObjectAttributes(ofstream &myfile, RObject rObject, serializer);
-
     switch (colType)
     {
       case FstColumnType::CHARACTER:
-      {
         colTypes[colNr] = 6;
-        delete blockRunner;
-        blockRunner = fstTable.GetCharWriter(colNr);
-        fdsWriteCharVec_v6(myfile, blockRunner, compress);   // column names
+        colData[colNr] = nullptr;
         break;
-      }
 
       case FstColumnType::FACTOR:
-      {
         colTypes[colNr] = 7;
-        delete blockRunner;
-        int* intP = fstTable.GetIntWriter(colNr);  // level values pointer
-        blockRunner = fstTable.GetLevelWriter(colNr);
-        fdsWriteFactorVec_v7(myfile, intP, blockRunner, nrOfRows, compress);
+        colData[colNr] = (char*) fstTable.GetIntWriter(colNr);  // level values pointer
         break;
-      }
 
       case FstColumnType::INT_32:
-      {
         colTypes[colNr] = 8;
-        int* intP = fstTable.GetIntWriter(colNr);
-        fdsWriteIntVec_v8(myfile, intP, nrOfRows, compress);
+        colData[colNr] = (char*) fstTable.GetIntWriter(colNr);
         break;
-      }
 
       case FstColumnType::DOUBLE_64:
-      {
         colTypes[colNr] = 9;
-        double* doubleP = fstTable.GetDoubleWriter(colNr);
-        fdsWriteRealVec_v9(myfile, doubleP, nrOfRows, compress);
+        colData[colNr] = (char*) fstTable.GetDoubleWriter(colNr);
         break;
-      }
 
       case FstColumnType::BOOL_32:
-      {
         colTypes[colNr] = 10;
-        int* intP = fstTable.GetLogicalWriter(colNr);
-        fdsWriteLogicalVec_v10(myfile, intP, nrOfRows, compress);
+        colData[colNr] = (char*) fstTable.GetLogicalWriter(colNr);
         break;
-      }
-
-      default:
-        delete[] metaDataBlock;
-        delete[] chunkIndex;
-        delete blockRunner;
-        myfile.close();
-        throw(runtime_error("Unknown type found in column."));
-    }
-  }
-
-  delete blockRunner;
 
-  // update chunk position data
-  *chunkPos = positionData[0] - 8 * nrOfCols;
+      case FstColumnType::INT_64:
+        colTypes[colNr] = 11;
+        colData[colNr] = (char*) fstTable.GetInt64Writer(colNr);
+        break;
 
-  myfile.seekp(0);
-  myfile.write((char*)(metaDataBlock), metaDataSize);  // table header
+      case FstColumnType::DATE_DAYS:
+        colTypes[colNr] = 12;
+        colData[colNr] = (char*) fstTable.GetDoubleWriter(colNr);
+        break;
 
-  myfile.seekp(*chunkPos - CHUNK_INDEX_SIZE);
-  myfile.write((char*)(chunkIndex), CHUNK_INDEX_SIZE + 8 * nrOfCols);  // vertical chunkset index and positiondata
+      case FstColumnType::TIMESTAMP_SECONDS:
+        colTypes[colNr] = 13;
+        colData[colNr] = (char*) fstTable.GetDoubleWriter(colNr);
+        break;
 
-  myfile.close();
+      default:
+        return false;
+    }
+  }
 
-  // cleanup
-  delete[] metaDataBlock;
-  delete[] chunkIndex;
+  return true;
 }
 
 
-int FstStore::fstMeta(const char*  fileName, IColumnFactory* columnFactory)
+// Write the attribute section with the attributes of all columns at the current position of myfile. Returns the
+// number of bytes written.
+unsigned long long WriteAttributes(ostream &myfile, const vector<vector<char>> &colAttributes)
 {
-  // fst file stream using a stack buffer
-  ifstream myfile;
-  char ioBuf[4096];
-  myfile.rdbuf()->pubsetbuf(ioBuf, 4096);
-  myfile.open(fileName, ios::binary);
+  unsigned long long attributeId = ATTRIBUTE_ID;
+  myfile.write((char*) &attributeId, 8);
 
-  if (myfile.fail())
+  vector<unsigned int> attributeSizes;
+  unsigned long long sectionSize = 8 + 4 * colAttributes.size();
+
+  for (const vector<char> &attributeData : colAttributes)
   {
-    myfile.close();
-    throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+    attributeSizes.push_back((unsigned int) attributeData.size());
+    sectionSize += attributeData.size();
   }
 
-  // Read variables from fst file header
-  version = ReadHeader(myfile, tableClassType, keyLength, nrOfColsFirstChunk);
+  myfile.write((char*) attributeSizes.data(), 4 * attributeSizes.size());
 
-  // We may be looking at a fst v0.7.2 file format
-  if (version == 0)
+  for (const vector<char> &attributeData : colAttributes)
   {
-    // Close and reopen (slow: fst file should be resaved to avoid)
-    myfile.close();
-    return 0;  // scans further for safety
+    myfile.write(attributeData.data(), attributeData.size());
   }
 
+  return sectionSize;
+}
 
-  // Continue reading table metadata
-  int metaSize = 32 + 4 * keyLength + 6 * nrOfColsFirstChunk;
-  metaDataBlock = new char[metaSize];
-  myfile.read(metaDataBlock, metaSize);
 
-  unsigned int tmpOffset = 4 * keyLength;
+// Serialize rows firstRow until firstRow + nrOfRows of all columns of fstTable at the current position of myfile
+// and store the file position of each column in positionData. If blockSizes is specified, it holds the block
+// size in bytes of each column (0 for the default block size). If goal is specified, the compression algorithms
+// are selected adaptively. If bloomBits is specified, it holds the number of Bloom filter bits per key of each
+// column (0 for no filters). If mantissaBits is specified, it holds the mantissa bits kept of each double column
+// (0 for full precision). With fastDecode, integer and double columns use LZ4HC instead of ZSTD. If compressLevels is
+// specified, it holds the compression level of each column.
+void WriteColumns(ostream &myfile, IFstTable &fstTable, unsigned short int* colBaseTypes, char** colData,
+  unsigned long long* positionData, int nrOfCols, unsigned long long firstRow, unsigned long long nrOfRows, int compress,
+  int nrOfThreads, const unsigned int* blockSizes, const CompressionGoal* goal, const unsigned int* bloomBits,
+  const unsigned int* mantissaBits, bool fastDecode, const int* compressLevels)
+{
+  // Narrow tables are written column by column, using all threads to compress the blocks of a single column
+  if (nrOfThreads < 2 || nrOfCols < nrOfThreads)
+  {
+    for (int colNr = 0; colNr < nrOfCols; ++colNr)
+    {
+      unsigned long long colPos = myfile.tellp();  // current location
+      positionData[colNr] = colPos + WriteColumn(myfile, fstTable, colNr, (FstColumnType) colBaseTypes[colNr],
+        colData[colNr], firstRow, nrOfRows, compressLevels == nullptr ? compress : compressLevels[colNr], nrOfThreads,
+        blockSizes == nullptr ? 0 : blockSizes[colNr], goal, bloomBits == nullptr ? 0 : bloomBits[colNr],
+        mantissaBits == nullptr ? 0 : mantissaBits[colNr], fastDecode);
+    }
+  }
+  else
+  {
+    // Worker threads compress fixed width columns into a private buffer. The ordered section appends these
+    // buffers to the file in column order. Character and factor columns share the string buffers of fstTable
+    // and are written directly from the ordered section. The bytes written are identical to a serial write,
+    // as all column positions in the column data are relative to the column start (or, for factors, taken
+    // from myfile itself).
+    // Profiled columns are selected by the threads, waiting for the threads is not attributed to the metadata
+    FstProfile* profile = ProfileScope::Active();
+    ProfileScope waitScope(nullptr);
+
+#pragma omp parallel for schedule(dynamic) ordered num_threads(nrOfThreads)
+    for (int colNr = 0; colNr < nrOfCols; ++colNr)
+    {
+      ProfileScope profileScope(profile);
+      FstColumnType colType = (FstColumnType) colBaseTypes[colNr];
+      bool isFixedWidth = colType != FstColumnType::CHARACTER && colType != FstColumnType::FACTOR;
+      stringstream colBuf(ios::in | ios::out | ios::binary);
+      unsigned long long colOffset = 0;  // offset of the column data after the checksum metadata and zone map
+      unsigned int blockSize = blockSizes == nullptr ? 0 : blockSizes[colNr];
+      unsigned int colBloomBits = bloomBits == nullptr ? 0 : bloomBits[colNr];
+      unsigned int colMantissaBits = mantissaBits == nullptr ? 0 : mantissaBits[colNr];
+      int colCompress = compressLevels == nullptr ? compress : compressLevels[colNr];
+
+      if (isFixedWidth)
+      {
+        colOffset = WriteColumn(colBuf, fstTable, colNr, colType, colData[colNr], firstRow, nrOfRows, colCompress, 1,
+          blockSize, goal, colBloomBits, colMantissaBits, fastDecode);
+      }
 
-  keyColPos                                 = (int*) metaDataBlock;
-  // unsigned long long* p_nextHorzChunkSet = (unsigned long long*) &metaDataBlock[tmpOffset];
-  // unsigned long long* p_nextVertChunkSet = (unsigned long long*) &metaDataBlock[tmpOffset + 8];
-  p_nrOfRows                                = (unsigned long long*) &metaDataBlock[tmpOffset + 16];
-  // unsigned int* p_version                = (unsigned int*) &metaDataBlock[tmpOffset + 24];
-  int* p_nrOfCols                           = (int*) &metaDataBlock[tmpOffset + 28];
-  // unsigned short int* colAttributeTypes  = (unsigned short int*) &metaDataBlock[tmpOffset + 32];
-  colTypes                                  = (unsigned short int*) &metaDataBlock[tmpOffset + 32 + 2 * nrOfColsFirstChunk];
-  // unsigned short int* colBaseTypes       = (unsigned short int*) &metaDataBlock[tmpOffset + 32 + 4 * nrOfColsFirstChunk];
+#pragma omp ordered
+      {
+        unsigned long long colPos = myfile.tellp();  // current location
+
+        if (isFixedWidth)
+        {
+          ProfileColumn profileColumn(colNr, ProfilePhase::IO);
+          myfile << colBuf.rdbuf();
+        }
+        else
+        {
+          colOffset = WriteColumn(myfile, fstTable, colNr, colType, colData[colNr], firstRow, nrOfRows, colCompress, 1,
+          blockSize, goal, colBloomBits, colMantissaBits, fastDecode);
+        }
 
+        positionData[colNr] = colPos + colOffset;
+      }
+    }
+  }
+}
 
-  nrOfCols = *p_nrOfCols;
 
+// Set the number of rows of each data chunk in the vertical chunkset indexes of a chunkset, CHUNK_INDEX_SLOTS chunks
+// per index. Each index is preceded by the link to the next index, unused slots and links are set to zero.
+inline void SetChunkRows(char* chunkIndexes, const vector<unsigned long long> &chunkRows)
+{
+  unsigned int nrOfChunks = static_cast<unsigned int>(chunkRows.size());
+  unsigned int nrOfIndexes = (nrOfChunks + CHUNK_INDEX_SLOTS - 1) / CHUNK_INDEX_SLOTS;
 
-  // Read column names
-  unsigned long long offset = metaSize + TABLE_META_SIZE;
+  memset(chunkIndexes, 0, nrOfIndexes * (8 + CHUNK_INDEX_SIZE));  // unused index slots are written as zeros
 
-  blockReader = columnFactory->CreateStringColumn(nrOfCols);
-  fdsReadCharVec_v6(myfile, blockReader, offset, 0, (unsigned int) nrOfCols, (unsigned int) nrOfCols);
+  for (unsigned int chunkNr = 0; chunkNr < nrOfChunks; ++chunkNr)
+  {
+    char* chunkIndex = &chunkIndexes[(chunkNr / CHUNK_INDEX_SLOTS) * (8 + CHUNK_INDEX_SIZE) + 8];
 
-  // cleanup
-  myfile.close();
+    unsigned long long* p_chunkRows             = (unsigned long long*) &chunkIndex[64];
+    unsigned long long* p_nrOfChunksPerIndexRow = (unsigned long long*) &chunkIndex[128];
+    unsigned long long* p_nrOfChunks            = (unsigned long long*) &chunkIndex[136];
 
-  return 1;
+    unsigned int slot = chunkNr % CHUNK_INDEX_SLOTS;
+    p_chunkRows[slot] = chunkRows[chunkNr];
+    *p_nrOfChunksPerIndexRow = 1;
+    *p_nrOfChunks = slot + 1;
+  }
 }
 
 
-int FstStore::fstRead(const char* fileName, IFstTableReader &tableReader, IStringArray* columnSelection, int startRow, int endRow, IColumnFactory* columnFactory, vector<int> &keyIndex, IStringArray* selectedCols)
+// Write the first chunkset index of a chunkset at the current position of myfile, followed by the attribute section
+// (if any column has attributes), the data chunks with the rows set in chunkIndexes (see SetChunkRows) and the
+// additional chunkset indexes. The positions of the data chunks are set in chunkIndexes and the link to the first
+// additional index in nextVertChunkSet. Returns the position of the first chunkset index, which should be rewritten
+// by the caller, as should the chunkset header.
+unsigned long long WriteDataChunks(ostream &myfile, IFstTable &fstTable, unsigned short int* colBaseTypes,
+  char** colData, int nrOfCols, const vector<vector<char>> &colAttributes, bool hasAttributes, char* chunkIndexes,
+  unsigned int nrOfChunks, unsigned long long* p_nextVertChunkSet, int compress, int nrOfThreads,
+  const unsigned int* blockSizes, const CompressionGoal* goal, const unsigned int* bloomBits,
+  const unsigned int* mantissaBits, bool fastDecode, const int* compressLevels)
 {
-  // fst file stream using a stack buffer
-  ifstream myfile;
-  char ioBuf[4096];
-  myfile.rdbuf()->pubsetbuf(ioBuf, 4096);
-  myfile.open(fileName, ios::binary);
+  unsigned int nrOfIndexes = (nrOfChunks + CHUNK_INDEX_SLOTS - 1) / CHUNK_INDEX_SLOTS;
+  char* chunkIndex = &chunkIndexes[8];  // first index
+  vector<unsigned long long> positionData(nrOfCols);  // column position index of a single chunk
 
-  if (myfile.fail())
+  // The first chunkset index is followed by the data chunks, each starting with its position data
+  unsigned long long indexPos = myfile.tellp();
+  myfile.write(chunkIndex, CHUNK_INDEX_SIZE);
+
+  if (hasAttributes)
   {
-    myfile.close();
-    throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+    WriteAttributes(myfile, colAttributes);
   }
 
-  unsigned int tableClassType;
-  int keyLength, nrOfColsFirstChunk;
-  unsigned int version = ReadHeader(myfile, tableClassType, keyLength, nrOfColsFirstChunk);
+  unsigned long long firstRow = 0;
 
-  // We may be looking at a fst v0.7.2 file format, TODO: return error_code
-  if (version == 0)
+  for (unsigned int chunkNr = 0; chunkNr < nrOfChunks; ++chunkNr)
   {
-    // Close and reopen (slow: fst file should be resaved to avoid this overhead)
-    myfile.close();
-    return -1;  // error code for deprecated fst format
-  }
+    char* chunkSetIndex = &chunkIndexes[(chunkNr / CHUNK_INDEX_SLOTS) * (8 + CHUNK_INDEX_SIZE) + 8];
+    unsigned long long* chunkPos = (unsigned long long*) chunkSetIndex;
+    unsigned long long* chunkRows = (unsigned long long*) &chunkSetIndex[64];
+    unsigned long long chunkNrOfRows = chunkRows[chunkNr % CHUNK_INDEX_SLOTS];
 
+    unsigned long long chunkStart = myfile.tellp();
+    myfile.write((char*) positionData.data(), 8 * nrOfCols);  // completed after the columns are written
 
-  // Continue reading table metadata
-  int metaSize = 32 + 4 * keyLength + 6 * nrOfColsFirstChunk;
-  char* metaDataBlock = new char[metaSize];
-  myfile.read(metaDataBlock, metaSize);
+    WriteColumns(myfile, fstTable, colBaseTypes, colData, positionData.data(), nrOfCols, firstRow, chunkNrOfRows,
+      compress, nrOfThreads, blockSizes, goal, bloomBits, mantissaBits, fastDecode, compressLevels);
 
+    myfile.seekp(chunkStart);
+    myfile.write((char*) positionData.data(), 8 * nrOfCols);
+    myfile.seekp(0, ios_base::end);
 
-  int* keyColPos = (int*) metaDataBlock;
+    chunkPos[chunkNr % CHUNK_INDEX_SLOTS] = chunkStart;
+    firstRow += chunkNrOfRows;
+  }
 
-  unsigned int tmpOffset = 4 * keyLength;
+  // Additional chunkset indexes are linked from nextVertChunkSet and from each other
+  unsigned long long indexesPos = myfile.tellp();
+  unsigned long long* p_nextIndex = p_nextVertChunkSet;
 
-  // unsigned long long* p_nextHorzChunkSet = (unsigned long long*) &metaDataBlock[tmpOffset];
-  // unsigned long long* p_nextVertChunkSet = (unsigned long long*) &metaDataBlock[tmpOffset + 8];
-  // unsigned long long* p_nrOfRows         = (unsigned long long*) &metaDataBlock[tmpOffset + 16];
-  // unsigned int* p_version                = (unsigned int*) &metaDataBlock[tmpOffset + 24];
-  int* p_nrOfCols                        = (int*) &metaDataBlock[tmpOffset + 28];
-  // unsigned short int* colAttributeTypes  = (unsigned short int*) &metaDataBlock[tmpOffset + 32];
-  unsigned short int* colTypes           = (unsigned short int*) &metaDataBlock[tmpOffset + 32 + 2 * nrOfColsFirstChunk];
-  // unsigned short int* colBaseTypes       = (unsigned short int*) &metaDataBlock[tmpOffset + 32 + 4 * nrOfColsFirstChunk];
+  for (unsigned int indexNr = 1; indexNr < nrOfIndexes; ++indexNr)
+  {
+    *p_nextIndex = indexesPos + (indexNr - 1) * (8 + CHUNK_INDEX_SIZE);
+    p_nextIndex = (unsigned long long*) &chunkIndexes[indexNr * (8 + CHUNK_INDEX_SIZE)];
+  }
 
-  int nrOfCols = *p_nrOfCols;
+  for (unsigned int indexNr = 1; indexNr < nrOfIndexes; ++indexNr)
+  {
+    myfile.write(&chunkIndexes[indexNr * (8 + CHUNK_INDEX_SIZE)], 8 + CHUNK_INDEX_SIZE);
+  }
 
+  return indexPos;
+}
 
-  // TODO: read table attributes here
 
-  // Read column names
-  unsigned long long offset = metaSize + TABLE_META_SIZE;
+void FstStore::fstWrite(IFstOutput &output, IFstTable &fstTable, int compress, int nrOfThreads,
+  unsigned long long rowsPerChunk, const unsigned int* blockSizes, const CompressionGoal* goal,
+  const unsigned int* bloomBits, const unsigned int* mantissaBits, bool fastDecode, const int* compressLevels)
+{
+  // SEXP keyNames = Rf_getAttrib(table, Rf_mkString("sorted"));
 
-  // Use a pure C++ charVector implementation here for performance
-  IStringColumn* blockReader = columnFactory->CreateStringColumn(nrOfCols);
-  fdsReadCharVec_v6(myfile, blockReader, offset, 0, (unsigned int) nrOfCols, (unsigned int) nrOfCols);
+  // Meta on dataset
+  int nrOfCols =  fstTable.NrOfColumns();
+  int keyLength = fstTable.NrOfKeys();
 
-  // SEXP colNames = ((BlockReaderChar*) blockReader)->StrVector();
+  if (nrOfCols == 0)
+  {
+    throw(runtime_error("Your dataset needs at least one column."));
+  }
 
-  // TODO: read column attributes here
+  // Time outside WriteColumn is spent on the metadata
+  if (ProfileScope::Active() != nullptr) ProfileScope::Active()->SetColumns(nrOfCols);
+  ProfileColumn profileMetadata(PROFILE_METADATA, ProfilePhase::CODEC);
 
+  // Table meta information
+  unsigned long long metaDataSize        = 56 + 4 * keyLength + 6 * nrOfCols;  // see index above
+  char* metaDataBlock                    = new char[metaDataSize];
+  memset(metaDataBlock, 0, metaDataSize);  // unused fields are written as zeros
+
+  unsigned long long* fstFileID          = (unsigned long long*) metaDataBlock;
+  unsigned int* p_table_version          = (unsigned int*) &metaDataBlock[8];
+  unsigned int* p_tableClassType         = (unsigned int*) &metaDataBlock[12];
+  int* p_keyLength                       = (int*) &metaDataBlock[16];
+  int* p_nrOfColsFirstChunk              = (int*) &metaDataBlock[20];
+  int* keyColPos                         = (int*) &metaDataBlock[24];
+
+  unsigned int offset = 24 + 4 * keyLength;
 
-  // Vertical chunkset index or index of index
-  char chunkIndex[CHUNK_INDEX_SIZE];
-  myfile.read(chunkIndex, CHUNK_INDEX_SIZE);
+  unsigned long long* p_nextHorzChunkSet = (unsigned long long*) &metaDataBlock[offset];
+  unsigned long long* p_nextVertChunkSet = (unsigned long long*) &metaDataBlock[offset + 8];
+  unsigned long long* p_nrOfRows         = (unsigned long long*) &metaDataBlock[offset + 16];
+  unsigned int* p_version                = (unsigned int*) &metaDataBlock[offset + 24];
+  int* p_nrOfCols                        = (int*) &metaDataBlock[offset + 28];
+  unsigned short int* colAttributeTypes  = (unsigned short int*) &metaDataBlock[offset + 32];
+  unsigned short int* colTypes           = (unsigned short int*) &metaDataBlock[offset + 32 + 2 * nrOfCols];
+  unsigned short int* colBaseTypes       = (unsigned short int*) &metaDataBlock[offset + 32 + 4 * nrOfCols];
 
-  // unsigned long long* chunkPos                = (unsigned long long*) chunkIndex;
-  unsigned long long* chunkRows               = (unsigned long long*) &chunkIndex[64];
-  // unsigned long long* p_nrOfChunksPerIndexRow = (unsigned long long*) &chunkIndex[128];
-  unsigned long long* p_nrOfChunks            = (unsigned long long*) &chunkIndex[136];
+  // Get key column positions
+  fstTable.GetKeyColumns(keyColPos);
 
-  // Check nrOfChunks
-  if (*p_nrOfChunks > 1)
+  *fstFileID            = FST_FILE_ID;
+  *p_table_version      = FST_VERSION;
+  *p_tableClassType     = 1;  // default table
+  *p_keyLength          = keyLength;
+  *p_nrOfColsFirstChunk = nrOfCols;
+
+  *p_nextHorzChunkSet   = 0;
+  *p_nextVertChunkSet   = 0;
+  *p_version            = FST_VERSION;
+  *p_nrOfCols           = nrOfCols;
+
+
+  // data.frame code here for stability!
+
+  unsigned long long nrOfRows = fstTable.NrOfRows();
+  *p_nrOfRows = nrOfRows;
+
+
+  if (nrOfRows == 0)
   {
-    myfile.close();
     delete[] metaDataBlock;
-    delete blockReader;
-    throw(runtime_error("Multiple chunk read not implemented yet."));
+    throw(runtime_error("The dataset contains no data."));
   }
 
 
-  // Start reading chunk here. TODO: loop over chunks
+  // Column types and data pointers are collected on the calling thread, before any data is written
+  char** colData = new char*[nrOfCols];
+
+  if (!SetColumnTypes(fstTable, nrOfCols, colTypes, colBaseTypes, colData))
+  {
+    delete[] metaDataBlock;
+    delete[] colData;
+    throw(runtime_error("Unknown type found in column."));
+  }
 
+  // The data of all columns is written with checksums and a zone map. Column attributes are encoded on the
+  // calling thread as well.
+  vector<vector<char>> colAttributes(nrOfCols);
+  bool hasAttributes = false;
 
-  // Read block positions
-  unsigned long long* blockPos = new unsigned long long[nrOfCols];
-  myfile.read((char*) blockPos, nrOfCols * 8);  // nrOfCols file positions
+  for (int colNr = 0; colNr < nrOfCols; ++colNr)
+  {
+    colAttributeTypes[colNr] = COL_ATTR_ZONE_MAP | COL_ATTR_CHECKSUM;
 
+    if (bloomBits != nullptr && bloomBits[colNr] != 0 && BloomFilter::SupportsType((FstColumnType) colBaseTypes[colNr]))
+    {
+      colAttributeTypes[colNr] |= COL_ATTR_BLOOM;
+    }
 
-  // Determine column selection
-  int *colIndex;
-  int nrOfSelect = 0;
+    // The precision of a double column is recorded so appended data can be stored with the same precision
+    if (mantissaBits != nullptr && mantissaBits[colNr] != 0 &&
+      (FstColumnType) colBaseTypes[colNr] == FstColumnType::DOUBLE_64)
+    {
+      colAttributeTypes[colNr] |= COL_ATTR_PRECISION | mantissaBits[colNr];
+    }
 
-  if (columnSelection == nullptr)
-  {
-    colIndex = new int[nrOfCols];
+    fstTable.GetColumnAttributes(colNr, colAttributes[colNr]);
 
-    for (int colNr = 0; colNr < nrOfCols; ++colNr)
+    if (!colAttributes[colNr].empty())
     {
-      colIndex[colNr] = colNr;
+      colAttributeTypes[colNr] |= COL_ATTR_ATTRIBUTES;
+      hasAttributes = true;
     }
-    nrOfSelect = nrOfCols;
   }
-  else  // determine column numbers of column names
+
+
+  // Create the output stream
+  ostream* outputStream = output.Open();
+
+  if (outputStream == nullptr)
+  {
+    delete[] metaDataBlock;
+    delete[] colData;
+    throw(runtime_error("There was an error creating the file. Please check for a correct filename."));
+  }
+
+  ostream &myfile = *outputStream;
+
+  // Outputs that can't seek are written in a single forward pass using the append-only layout
+  bool streamLayout = !output.IsSeekable();
+  if (streamLayout) *p_table_version = FST_VERSION_STREAM;
+
+  // Parts of the stream layout are serialized in a memory buffer positioned at their final stream location
+  MemoryOutputStreamBuf partBuf;
+  ostream partStream(&partBuf);
+  unsigned long long streamPos = metaDataSize;
+
+
+  // Write table meta information
+  myfile.write((char*)(metaDataBlock), metaDataSize);  // table meta data
+
+  // Serialize column names
+  IBlockWriter* blockRunner = fstTable.GetColNameWriter();
+
+  if (streamLayout)
+  {
+    partBuf.SetBasePosition(streamPos);
+    fdsWriteCharVec_v6(partStream, blockRunner, 0);   // column names
+    myfile.write(partBuf.Data(), partBuf.Size());
+    streamPos += partBuf.Size();
+  }
+  else
+  {
+    fdsWriteCharVec_v6(myfile, blockRunner, 0);   // column names
+  }
+
+  delete blockRunner;
+
+  // The append-only layout has no chunkset index in front of the column data
+  if (streamLayout && hasAttributes)
+  {
+    streamPos += WriteAttributes(myfile, colAttributes);
+  }
+
+  // Row ranges of the data chunks
+  if (rowsPerChunk == 0 || rowsPerChunk > nrOfRows) rowsPerChunk = nrOfRows;
+
+  // The trailer of the append-only layout holds a single chunkset index
+  if (streamLayout)
+  {
+    rowsPerChunk = max(rowsPerChunk, (nrOfRows + CHUNK_INDEX_SLOTS - 1) / CHUNK_INDEX_SLOTS);
+  }
+
+  unsigned int nrOfChunks = static_cast<unsigned int>((nrOfRows + rowsPerChunk - 1) / rowsPerChunk);
+  unsigned int nrOfIndexes = (nrOfChunks + CHUNK_INDEX_SLOTS - 1) / CHUNK_INDEX_SLOTS;
+
+  vector<unsigned long long> chunkRows(nrOfChunks);
+
+  for (unsigned int chunkNr = 0; chunkNr < nrOfChunks; ++chunkNr)
+  {
+    chunkRows[chunkNr] = min(rowsPerChunk, nrOfRows - chunkNr * rowsPerChunk);
+  }
+
+  // Vertical chunkset indexes, each preceded by the link to the next index
+  char* chunkIndexes = new char[nrOfIndexes * (8 + CHUNK_INDEX_SIZE)];
+  SetChunkRows(chunkIndexes, chunkRows);
+
+  char* chunkIndex = &chunkIndexes[8];  // first index
+  unsigned long long* positionData = new unsigned long long[nrOfChunks * nrOfCols];  // column position index
+
+
+  // Uncompressed data is limited by disk speed only, so there is nothing to gain from multiple threads
+  bool compressed = compress > 0 || goal != nullptr;
+
+  for (int colNr = 0; compressLevels != nullptr && colNr < nrOfCols; ++colNr)
+  {
+    if (compressLevels[colNr] > 0) compressed = true;
+  }
+
+  if (!compressed) nrOfThreads = 1;
+
+  if (streamLayout)
   {
-    nrOfSelect = columnSelection->Length();
-    colIndex = new int[nrOfSelect];
-    int equal;
-    for (int colSel = 0; colSel < nrOfSelect; ++colSel)
+    // Columns are appended one by one, with the column block indexes completed in memory
+    for (unsigned int chunkNr = 0; chunkNr < nrOfChunks; ++chunkNr)
     {
-      equal = -1;
-      const char* str1 = columnSelection->GetElement(colSel);
+      unsigned long long firstRow = chunkNr * rowsPerChunk;
+      unsigned long long chunkNrOfRows = min(rowsPerChunk, nrOfRows - firstRow);
 
       for (int colNr = 0; colNr < nrOfCols; ++colNr)
       {
-        const char* str2 = blockReader->GetElement(colNr);
-        if (strcmp(str1, str2) == 0)
-        {
-          equal = colNr;
-          break;
-        }
-      }
+        partBuf.Clear();
+        partBuf.SetBasePosition(streamPos);
+        unsigned long long colOffset = WriteColumn(partStream, fstTable, colNr, (FstColumnType) colBaseTypes[colNr],
+          colData[colNr], firstRow, chunkNrOfRows, compressLevels == nullptr ? compress : compressLevels[colNr],
+          nrOfThreads, blockSizes == nullptr ? 0 : blockSizes[colNr], goal, bloomBits == nullptr ? 0 : bloomBits[colNr],
+          mantissaBits == nullptr ? 0 : mantissaBits[colNr], fastDecode);
 
-      if (equal == -1)
-      {
-        delete[] metaDataBlock;
-        delete[] blockPos;
-        delete[] colIndex;
-        delete blockReader;
-        myfile.close();
-        throw(runtime_error("Selected column not found."));
+        positionData[chunkNr * nrOfCols + colNr] = streamPos + colOffset;  // location of the column data
+
+        myfile.write(partBuf.Data(), partBuf.Size());
+        streamPos += partBuf.Size();
       }
+    }
 
-      colIndex[colSel] = equal;
+    // Trailer with the vertical chunkset index and positiondata of all chunks, followed by a fixed size footer
+    unsigned long long* chunkPos = (unsigned long long*) chunkIndex;
+    for (unsigned int chunkNr = 0; chunkNr < nrOfChunks; ++chunkNr)
+    {
+      chunkPos[chunkNr] = streamPos + CHUNK_INDEX_SIZE + 8 * chunkNr * nrOfCols;
     }
+
+    myfile.write(chunkIndex, CHUNK_INDEX_SIZE);
+    myfile.write((char*) positionData, 8 * nrOfChunks * nrOfCols);
+
+    unsigned long long footer[2] = { streamPos, FST_FILE_ID };  // trailer position and file identifier
+    myfile.write((char*) footer, FOOTER_SIZE);
   }
+  else
+  {
+    unsigned long long indexPos = WriteDataChunks(myfile, fstTable, colBaseTypes, colData, nrOfCols, colAttributes,
+      hasAttributes, chunkIndexes, nrOfChunks, p_nextVertChunkSet, compress, nrOfThreads, blockSizes, goal, bloomBits,
+      mantissaBits, fastDecode, compressLevels);
 
+    myfile.seekp(0);
+    myfile.write((char*)(metaDataBlock), metaDataSize);  // table header
 
-  // Check range of selected rows
-  int firstRow = startRow - 1;
-  int nrOfRows = *chunkRows;  // TODO: check for row numbers > INT_MAX !!!
+    myfile.seekp(indexPos);
+    myfile.write(chunkIndex, CHUNK_INDEX_SIZE);  // vertical chunkset index
+  }
 
-  if (firstRow >= nrOfRows || firstRow < 0)
+  bool writeOk = !myfile.fail();
+  writeOk = output.Close() && writeOk;
+
+  // cleanup
+  delete[] metaDataBlock;
+  delete[] chunkIndexes;
+  delete[] positionData;
+  delete[] colData;
+
+  if (!writeOk)
   {
-    delete[] metaDataBlock;
-    delete[] blockPos;
-    delete[] colIndex;
-    delete blockReader;
-    myfile.close();
+    throw(runtime_error("There was an error writing the fst data."));
+  }
+}
 
-    if (firstRow < 0)
-    {
-      throw(runtime_error("Parameter fromRow should have a positive value."));
-    }
 
-    throw(runtime_error("Row selection is out of range."));
+void FstStore::fstWrite(const char* fileName, IFstTable &fstTable, int compress, int nrOfThreads,
+  unsigned long long rowsPerChunk, const unsigned int* blockSizes, const CompressionGoal* goal,
+  const unsigned int* bloomBits, const unsigned int* mantissaBits, bool fastDecode, const int* compressLevels)
+{
+  FstFileOutput fileOutput(fileName);
+
+  fstWrite(fileOutput, fstTable, compress, nrOfThreads, rowsPerChunk, blockSizes, goal, bloomBits, mantissaBits,
+    fastDecode, compressLevels);
+}
+
+
+
+void FstStore::fstAppend(const char* fileName, IFstTable &fstTable, int compress, int nrOfThreads,
+  IColumnFactory* columnFactory)
+{
+  FstWriter fstWriter(fileName, compress, nrOfThreads, columnFactory);
+
+  fstWriter.Open();
+  fstWriter.WriteBatch(fstTable);
+  fstWriter.Close();
+}
+
+
+void FstStore::fstCbind(const char* fileName, IFstTable &fstTable, int compress, int nrOfThreads,
+  IColumnFactory* columnFactory)
+{
+  int nrOfCols = fstTable.NrOfColumns();
+
+  if (nrOfCols == 0)
+  {
+    throw(runtime_error("Your dataset needs at least one column."));
+  }
+
+  // The existing file is updated in place
+  fstream myfile;
+  myfile.open(fileName, ios::binary | ios::in | ios::out);
+
+  if (myfile.fail())
+  {
+    throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+  }
+
+  int keyLength;
+  unsigned int version = ReadHeader(myfile, tableClassType, keyLength, nrOfColsFirstChunk);
+
+  // Older files lack the chunkset index and the append-only layout keeps its index in a trailer
+  if (version != FST_VERSION)
+  {
+    throw(runtime_error(FSTERROR_NO_APPEND));
   }
 
-  int length = nrOfRows - firstRow;
+  // The new chunkset is linked from the last horizontal chunkset
+  unsigned long long linkPos = TABLE_META_SIZE + 4 * keyLength;
+  unsigned long long nextHorzChunkSet = 0;
+
+  myfile.seekg(linkPos);
+  myfile.read((char*) &nextHorzChunkSet, 8);
+
+  if (!myfile)
+  {
+    throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+  }
+
+  vector<HorzChunkSet> chunkSets;
+  ReadHorzChunkSets(myfile, nextHorzChunkSet, chunkSets);
+
+  if (!chunkSets.empty()) linkPos = chunkSets.back().pos;
 
+  // The new columns are stored in data chunks with the rows of the stored data chunks
+  vector<unsigned long long> chunkRows;
+  unsigned long long nrOfRows = 0;
 
-  // Determine vector length
-  if (endRow != -1)
   {
-    if (endRow <= firstRow)
+    FstFileInput fileInput(fileName);
+    FstHandle fstHandle(fileInput, columnFactory);
+    fstHandle.Open();
+
+    nrOfRows = fstHandle.NrOfRows();
+
+    for (unsigned int chunkNr = 0; chunkNr < fstHandle.NrOfChunks(); ++chunkNr)
     {
-      delete[] metaDataBlock;
-      delete[] blockPos;
-      delete[] colIndex;
-      delete blockReader;
-      myfile.close();
-      throw(runtime_error("Incorrect row range specified."));
+      chunkRows.push_back(fstHandle.ChunkNrOfRows(chunkNr));
     }
+  }
 
-    length = min(endRow - firstRow, nrOfRows - firstRow);
+  if (fstTable.NrOfRows() != nrOfRows)
+  {
+    throw(runtime_error("The appended columns should have the same number of rows as the stored table."));
   }
 
-  tableReader.InitTable(nrOfSelect, length);
+  // Chunkset header, see the layout above
+  vector<char> headerBlock(32 + 6 * nrOfCols);
+  char* header = headerBlock.data();
+
+  unsigned long long* p_nextVertChunkSet = (unsigned long long*) &header[8];
+  unsigned long long* p_nrOfRows         = (unsigned long long*) &header[16];
+  unsigned int* p_version                = (unsigned int*) &header[24];
+  int* p_nrOfCols                        = (int*) &header[28];
+  unsigned short int* colAttrTypes       = (unsigned short int*) &header[32];
+  unsigned short int* colTypes           = (unsigned short int*) &header[32 + 2 * nrOfCols];
+  unsigned short int* colBaseTypes       = (unsigned short int*) &header[32 + 4 * nrOfCols];
 
-  for (int colSel = 0; colSel < nrOfSelect; ++colSel)
+  *p_nrOfRows = nrOfRows;
+  *p_version  = FST_VERSION;
+  *p_nrOfCols = nrOfCols;
+
+  vector<char*> colData(nrOfCols);
+
+  if (!SetColumnTypes(fstTable, nrOfCols, colTypes, colBaseTypes, colData.data()))
   {
-    int colNr = colIndex[colSel];
+    throw(runtime_error("Unknown type found in column."));
+  }
 
-    if (colNr < 0 || colNr >= nrOfCols)
+  vector<vector<char>> colAttributes(nrOfCols);
+  bool hasAttributes = false;
+
+  for (int colNr = 0; colNr < nrOfCols; ++colNr)
+  {
+    colAttrTypes[colNr] = COL_ATTR_ZONE_MAP | COL_ATTR_CHECKSUM;
+
+    fstTable.GetColumnAttributes(colNr, colAttributes[colNr]);
+
+    if (!colAttributes[colNr].empty())
     {
-      delete[] metaDataBlock;
-      delete[] blockPos;
-      delete[] colIndex;
-      delete blockReader;
-      myfile.close();
-      throw(runtime_error("Column selection is out of range."));
+      colAttrTypes[colNr] |= COL_ATTR_ATTRIBUTES;
+      hasAttributes = true;
     }
+  }
 
-    unsigned long long pos = blockPos[colNr];
+  // Time outside WriteColumn is spent on the metadata
+  if (ProfileScope::Active() != nullptr) ProfileScope::Active()->SetColumns(nrOfCols);
+  ProfileColumn profileMetadata(PROFILE_METADATA, ProfilePhase::CODEC);
 
-    switch (colTypes[colNr])
-    {
-    // Character vector
-      case 6:
-      {
-        IStringColumn* stringColumn = columnFactory->CreateStringColumn(length);
-        fdsReadCharVec_v6(myfile, stringColumn, pos, firstRow, length, nrOfRows);
-        tableReader.AddCharColumn(stringColumn, colSel);
-        delete stringColumn;
-        break;
-      }
+  // Uncompressed data is limited by disk speed only, so there is nothing to gain from multiple threads
+  if (compress == 0) nrOfThreads = 1;
 
-      // Integer vector
-      case 8:
-      {
-        IIntegerColumn* integerColumn = columnFactory->CreateIntegerColumn(length);
-        fdsReadIntVec_v8(myfile, integerColumn->Data(), pos, firstRow, length, nrOfRows);
-        tableReader.AddIntegerColumn(integerColumn, colSel);
-        delete integerColumn;
-        break;
-      }
+  // The chunkset is written at the end of the file, followed by the column names
+  myfile.seekp(0, ios_base::end);
+  unsigned long long chunkSetPos = myfile.tellp();
+  myfile.write(header, headerBlock.size());
 
-      // Real vector
-      case 9:
-      {
-        IDoubleColumn* doubleColumn = columnFactory->CreateDoubleColumn(length);
-        fdsReadRealVec_v9(myfile, doubleColumn->Data(), pos, firstRow, length, nrOfRows);
-        tableReader.AddDoubleColumn(doubleColumn, colSel);
-        delete doubleColumn;
-        break;
-      }
+  IBlockWriter* blockRunner = fstTable.GetColNameWriter();
+  fdsWriteCharVec_v6(myfile, blockRunner, 0);   // column names
+  delete blockRunner;
 
-      // Logical vector
-      case 10:
-      {
-        ILogicalColumn* logicalColumn = columnFactory->CreateLogicalColumn(length);
-        fdsReadLogicalVec_v10(myfile, logicalColumn->Data(), pos, firstRow, length, nrOfRows);
-        tableReader.AddLogicalColumn(logicalColumn, colSel);
-        delete logicalColumn;
-        break;
-      }
+  unsigned int nrOfChunks = static_cast<unsigned int>(chunkRows.size());
+  vector<char> chunkIndexes(((nrOfChunks + CHUNK_INDEX_SLOTS - 1) / CHUNK_INDEX_SLOTS) * (8 + CHUNK_INDEX_SIZE));
+  SetChunkRows(chunkIndexes.data(), chunkRows);
+
+  unsigned long long indexPos = WriteDataChunks(myfile, fstTable, colBaseTypes, colData.data(), nrOfCols,
+    colAttributes, hasAttributes, chunkIndexes.data(), nrOfChunks, p_nextVertChunkSet, compress, nrOfThreads,
+    nullptr, nullptr, nullptr, nullptr, false, nullptr);
+
+  myfile.seekp(chunkSetPos);
+  myfile.write(header, headerBlock.size());  // chunkset header
+
+  myfile.seekp(indexPos);
+  myfile.write(&chunkIndexes[8], CHUNK_INDEX_SIZE);  // vertical chunkset index
+
+  // The chunkset is linked last, so an interrupted write leaves the stored table intact
+  myfile.flush();
+  myfile.seekp(linkPos);
+  myfile.write((char*) &chunkSetPos, 8);
+
+  bool writeOk = !myfile.fail();
+  myfile.close();
+
+  if (!writeOk || myfile.fail())
+  {
+    throw(runtime_error("There was an error writing the fst data."));
+  }
+}
+
+
+// Locate a column of the table stored in fileName, returns the file position of its attribute flags
+inline unsigned long long ModifiedColumnPos(const char* fileName, const char* colName, IColumnFactory* columnFactory,
+  bool deleted)
+{
+  FstFileInput fileInput(fileName);
+  FstHandle fstHandle(fileInput, columnFactory);
+
+  if (!fstHandle.Open())
+  {
+    throw(runtime_error(FSTERROR_NO_APPEND));
+  }
+
+  int colNr = fstHandle.ColumnIndex(colName);
+
+  if (colNr == -1)
+  {
+    throw(runtime_error("Selected column not found."));
+  }
+
+  // Replacing or removing a key column would invalidate the sort order of the table
+  if (fstHandle.IsKeyColumn(colNr))
+  {
+    throw(runtime_error("Key columns can't be replaced or deleted."));
+  }
+
+  if (deleted && fstHandle.NrOfColumns() == 1)
+  {
+    throw(runtime_error("The last column of a table can't be deleted."));
+  }
+
+  return fstHandle.AttributeTypePos(colNr);
+}
+
+
+void FstStore::fstReplaceColumn(const char* fileName, const char* colName, IFstTable &fstTable, int compress,
+  int nrOfThreads, IColumnFactory* columnFactory)
+{
+  if (fstTable.NrOfColumns() != 1)
+  {
+    throw(runtime_error("A single column should be specified."));
+  }
+
+  ModifiedColumnPos(fileName, colName, columnFactory, false);
+
+  // The appended column replaces the stored column with the same name
+  fstCbind(fileName, fstTable, compress, nrOfThreads, columnFactory);
+}
+
+
+void FstStore::fstDeleteColumn(const char* fileName, const char* colName, IColumnFactory* columnFactory)
+{
+  unsigned long long attributeTypePos = ModifiedColumnPos(fileName, colName, columnFactory, true);
+
+  // The existing file is updated in place
+  fstream myfile;
+  myfile.open(fileName, ios::binary | ios::in | ios::out);
+
+  if (myfile.fail())
+  {
+    throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+  }
+
+  unsigned short int attributeType = 0;
+
+  myfile.seekg(attributeTypePos);
+  myfile.read((char*) &attributeType, 2);
+
+  attributeType |= COL_ATTR_DELETED;
+
+  myfile.seekp(attributeTypePos);
+  myfile.write((char*) &attributeType, 2);
+
+  bool writeOk = !myfile.fail();
+  myfile.close();
+
+  if (!writeOk || myfile.fail())
+  {
+    throw(runtime_error("There was an error writing the fst data."));
+  }
+}
+
+
+int FstStore::fstMeta(IFstInput &input, IColumnFactory* columnFactory)
+{
+  istream* inputStream = input.OpenStream();
+
+  if (inputStream == nullptr)
+  {
+    throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+  }
+
+  istream &myfile = *inputStream;
+
+  // Read variables from fst file header
+  version = ReadHeader(myfile, tableClassType, keyLength, nrOfColsFirstChunk);
+
+  // We may be looking at a fst v0.7.2 file format
+  if (version == 0)
+  {
+    // Close and reopen (slow: fst file should be resaved to avoid)
+    delete inputStream;
+    return 0;  // scans further for safety
+  }
+
+
+  // Continue reading table metadata
+  int metaSize = 32 + 4 * keyLength + 6 * nrOfColsFirstChunk;
+  metaDataBlock = new char[metaSize];
+  myfile.read(metaDataBlock, metaSize);
+
+  unsigned int tmpOffset = 4 * keyLength;
+
+  keyColPos                                 = (int*) metaDataBlock;
+  unsigned long long* p_nextHorzChunkSet    = (unsigned long long*) &metaDataBlock[tmpOffset];
+  // unsigned long long* p_nextVertChunkSet = (unsigned long long*) &metaDataBlock[tmpOffset + 8];
+  p_nrOfRows                                = (unsigned long long*) &metaDataBlock[tmpOffset + 16];
+  // unsigned int* p_version                = (unsigned int*) &metaDataBlock[tmpOffset + 24];
+  int* p_nrOfCols                           = (int*) &metaDataBlock[tmpOffset + 28];
+  colAttributeTypes                         = (unsigned short int*) &metaDataBlock[tmpOffset + 32];
+  colTypes                                  = (unsigned short int*) &metaDataBlock[tmpOffset + 32 + 2 * nrOfColsFirstChunk];
+  // unsigned short int* colBaseTypes       = (unsigned short int*) &metaDataBlock[tmpOffset + 32 + 4 * nrOfColsFirstChunk];
+
+  // Appended rows can invalidate the trailing key columns
+  keyLength = ValidKeyLength(keyColPos, keyLength);
+
+
+  nrOfCols = *p_nrOfCols;
+
+  // The columns of appended horizontal chunksets follow the columns of the first chunkset
+  vector<HorzChunkSet> chunkSets;
+  ReadHorzChunkSets(myfile, *p_nextHorzChunkSet, chunkSets);
+
+  vector<unsigned short int> storedColTypes(colTypes, colTypes + nrOfCols);
+  vector<unsigned short int> storedAttributeTypes(colAttributeTypes, colAttributeTypes + nrOfCols);
+  vector<int> chunkSetFirstCols(1, 0);
+
+  for (const HorzChunkSet &chunkSet : chunkSets)
+  {
+    chunkSetFirstCols.push_back((int) storedColTypes.size());
+    storedColTypes.insert(storedColTypes.end(), chunkSet.colTypes.begin(), chunkSet.colTypes.end());
+    storedAttributeTypes.insert(storedAttributeTypes.end(), chunkSet.colAttributeTypes.begin(),
+      chunkSet.colAttributeTypes.end());
+  }
 
-      // Factor vector
-      case 7:
+  int nrOfStoredCols = (int) storedColTypes.size();
+  chunkSetFirstCols.push_back(nrOfStoredCols);
+
+
+  // Read column names
+  unsigned long long offset = metaSize + TABLE_META_SIZE;
+
+  blockReader = columnFactory->CreateStringColumn(nrOfStoredCols);
+  blockReader->AllocateVec(nrOfStoredCols);
+  fdsReadCharVecAt_v6(myfile, blockReader, offset, 0, (unsigned int) nrOfCols, (unsigned int) nrOfCols, 0);
+
+  for (unsigned int setNr = 1; setNr <= chunkSets.size(); ++setNr)
+  {
+    const HorzChunkSet &chunkSet = chunkSets[setNr - 1];
+
+    fdsReadCharVecAt_v6(myfile, blockReader, chunkSet.pos + 32 + 6 * chunkSet.nrOfCols, 0,
+      (unsigned int) chunkSet.nrOfCols, (unsigned int) chunkSet.nrOfCols, chunkSetFirstCols[setNr]);
+  }
+
+  // Replaced and deleted columns are hidden
+  vector<int> storedCols;
+  VisibleColumns(blockReader, storedAttributeTypes.data(), chunkSetFirstCols, storedCols);
+
+  nrOfCols = (int) storedCols.size();
+  colTypeVec.clear();
+  colAttributeTypeVec.clear();
+
+  for (int storedCol : storedCols)
+  {
+    colTypeVec.push_back(storedColTypes[storedCol]);
+    colAttributeTypeVec.push_back(storedAttributeTypes[storedCol]);
+  }
+
+  colTypes = colTypeVec.data();
+  colAttributeTypes = colAttributeTypeVec.data();
+
+  if (nrOfCols != nrOfStoredCols)
+  {
+    IStringColumn* storedNames = blockReader;
+    blockReader = SelectStrings(columnFactory, storedNames, storedCols);
+    delete storedNames;
+
+    // Key columns can't be replaced or deleted, but columns in front of them can be deleted
+    for (int keyNr = 0; keyNr < keyLength; ++keyNr)
+    {
+      vector<int>::iterator keyCol = find(storedCols.begin(), storedCols.end(), keyColPos[keyNr]);
+
+      if (keyCol == storedCols.end())
       {
-        IFactorColumn* factorColumn = columnFactory->CreateFactorColumn(length);
-        fdsReadFactorVec_v7(myfile, factorColumn->Levels(), factorColumn->LevelData(), pos, firstRow, length, nrOfRows);
-        tableReader.AddFactorColumn(factorColumn, colSel);
-        delete factorColumn;
+        keyLength = keyNr;
         break;
       }
 
-      default:
-        delete[] metaDataBlock;
-        delete[] blockPos;
-        delete[] colIndex;
-        delete blockReader;
-        myfile.close();
-        throw(runtime_error("Unknown type found in column."));
+      keyColPos[keyNr] = (int) (keyCol - storedCols.begin());
     }
   }
 
-  // delete blockReaderStrVec;
+  // cleanup
+  delete inputStream;
+
+  return 1;
+}
 
-  myfile.close();
 
-  // Key index
-  SetKeyIndex(keyIndex, keyLength, nrOfSelect, keyColPos, colIndex);
+int FstStore::fstMeta(const char* fileName, IColumnFactory* columnFactory)
+{
+  FstFileInput fileInput(fileName);
+
+  return fstMeta(fileInput, columnFactory);
+}
+
+
+int FstStore::fstRead(IFstInput &input, IFstTableReader &tableReader, IStringArray* columnSelection, long long startRow,
+  long long endRow, IColumnFactory* columnFactory, vector<int> &keyIndex, IStringArray* selectedCols, int nrOfThreads)
+{
+  FstHandle fstHandle(input, columnFactory);
 
-  selectedCols->AllocateArray(nrOfSelect);
+  // Time outside the columns is spent on the metadata
+  ProfileColumn profileMetadata(PROFILE_METADATA, ProfilePhase::CODEC);
 
-  // Only when keys are present in result set, TODO: compute using C++ only !!!
-  for (int i = 0; i < nrOfSelect; ++i)
+  // We may be looking at a fst v0.7.2 file format, TODO: return error_code
+  if (!fstHandle.Open())
   {
-    selectedCols->SetElement(i, blockReader->GetElement(colIndex[i]));
+    return -1;  // error code for deprecated fst format
   }
 
-  delete[] metaDataBlock;
-  delete[] blockPos;
-  delete[] colIndex;
-  delete blockReader;
+  vector<int> colIndex;
+  fstHandle.SelectColumns(columnSelection, colIndex);
 
+  if (ProfileScope::Active() != nullptr) ProfileScope::Active()->SetColumns((unsigned int) colIndex.size());
+
+  fstHandle.ReadRange(tableReader, colIndex, startRow, endRow, nrOfThreads);
+
+  fstHandle.SelectedColumns(colIndex, selectedCols, keyIndex);
 
   return 0;
 }
 
-//
-// void FstStore::ColBind(FstTable table)
-// {
-//   // fst file stream using a stack buffer
-//   ifstream myfile;
-//   char ioBuf[4096];
-//   myfile.rdbuf()->pubsetbuf(ioBuf, 4096);
-//   myfile.open(fstFile.c_str(), ios::binary);
-//
-//   const std::vector<FstColumn*> columns = table.Columns();
-//
-//   if (myfile.fail())
-//   {
-//     myfile.close();
-//     throw std::runtime_error(FSTERROR_ERROR_OPENING_FILE);
-//   }
-//
-//   // Read fst file header
-//   FstMetaData metaData;
-//
-//   unsigned int tableClassType;
-//   int keyLength, nrOfColsFirstChunk;
-//   unsigned int version = metaData.ReadHeader(myfile, tableClassType, keyLength, nrOfColsFirstChunk);
-//
-//   // We can't append to a fst file with version lower than 1
-//   if (version == 0)
-//   {
-//     myfile.close();
-//     throw std::runtime_error(FSTERROR_NO_APPEND);
-//   }
-//
-//
-//   // Collect meta data from horizontal chunk headers and last vertical chunk set
-//   uint64_t firstHorzChunkPos = 24 + 4 * keyLength;  // hard-coded offset: beware of format changes
-//   istream* fstfile  = static_cast<istream*>(&myfile);
-//   metaData.Collect(*fstfile, firstHorzChunkPos);
-//
-//   vector<uint16_t> colTypeVec = metaData.colTypeVec;
-//   uint64_t nrOfRowsPrev = metaData.nrOfRows;
-//
-//   // We can only append an equal amount of columns
-//   if (colTypeVec.size() != columns.size())
-//   {
-//     myfile.close();
-//     throw std::runtime_error(FSTERROR_INCORRECT_COL_COUNT);
-//   }
-//
-//    // check for equal column types
-//
-//   // set compression or copy from existing meta data
-//
-//   // Seek to last horizontal chunk index
-//
-//   // Seek to last vertical chunk
-//
-//   // Add chunk
-//
-//   // Update vertical chunk index of lat horizontal chunk
-//
-// }
-//
+int FstStore::fstRead(const char* fileName, IFstTableReader &tableReader, IStringArray* columnSelection, long long startRow, long long endRow, IColumnFactory* columnFactory, vector<int> &keyIndex, IStringArray* selectedCols, int nrOfThreads,
+  bool memoryMapped)
+{
+  if (memoryMapped)
+  {
+    FstMappedFileInput mappedInput;
+
+    if (!mappedInput.Open(fileName))
+    {
+      throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+    }
+
+    return fstRead(mappedInput, tableReader, columnSelection, startRow, endRow, columnFactory, keyIndex, selectedCols,
+      nrOfThreads);
+  }
 
+  FstFileInput fileInput(fileName);
+
+  return fstRead(fileInput, tableReader, columnSelection, startRow, endRow, columnFactory, keyIndex, selectedCols,
+    nrOfThreads);
+}
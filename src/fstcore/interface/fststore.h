@@ -42,6 +42,8 @@
 
 #include <icolumnfactory.h>
 #include <ifsttable.h>
+#include <ifstio.h>
+#include <compressor.h>
 
 
 class FstStore
@@ -52,11 +54,13 @@ class FstStore
   std::string fstFile;
 
   char* metaDataBlock;
+  std::vector<unsigned short int> colTypeVec, colAttributeTypeVec;  // types of all horizontal chunksets
 
   public:
     unsigned long long* p_nrOfRows;
     int* keyColPos;
     unsigned short int* colTypes;
+    unsigned short int* colAttributeTypes;
     unsigned int version;
     int nrOfCols, keyLength;
     IStringColumn* blockReader;
@@ -65,12 +69,199 @@ class FstStore
 
     ~FstStore() { delete[] metaDataBlock; delete blockReader; }
 
-    void fstWrite(const char* fileName, IFstTable &fstTable, int compress);
+    /**
+     Write a table to a fst file.
+
+     @param fileName Path of the fst file.
+     @param fstTable Table to serialize.
+     @param compress Compression level (0 - 100).
+     @param nrOfThreads Number of threads available for compressing columns in parallel.
+     @param rowsPerChunk Maximum number of rows in a single data chunk, 0 to store all rows in a single chunk.
+     @param blockSizes Compression block size in bytes of each column (0 for the default block size), or nullptr to
+     use the default block size for all columns. Sizes are rounded down to a multiple of MIN_BLOCK_SIZE and are
+     ignored for character columns.
+     @param goal If specified, the compression algorithm of each block of the integer and double columns is selected
+     adaptively to meet this goal, ignoring compress for these columns.
+     @param bloomBits Number of Bloom filter bits per key of each column (0 for no filters), or nullptr to store no
+     Bloom filters. Filters are only stored for integer, 64-bit integer and character columns (see BloomFilter).
+     @param mantissaBits Number of mantissa bits (1 - 52) kept of the values of each double column (0 for full
+     precision), or nullptr to store all columns with full precision. The precision is recorded in the header.
+     @param fastDecode If true, integer, 64-bit integer and double columns are compressed with LZ4HC instead of
+     ZSTD at compression levels above 50. These blocks decompress at LZ4 speed, at the cost of a slower write.
+     @param compressLevels Compression level (0 - 100) of each column, or nullptr to use compress for all columns.
+     */
+    void fstWrite(const char* fileName, IFstTable &fstTable, int compress, int nrOfThreads, unsigned long long rowsPerChunk,
+      const unsigned int* blockSizes = nullptr, const CompressionGoal* goal = nullptr,
+      const unsigned int* bloomBits = nullptr, const unsigned int* mantissaBits = nullptr, bool fastDecode = false,
+      const int* compressLevels = nullptr);
+
+    /**
+     Write a table to a fst output. Outputs that are not seekable are written in a single forward pass using
+     the append-only layout, with the chunkset index in a trailer located by a fixed size footer.
+
+     @param output Destination of the fst data.
+     @param fstTable Table to serialize.
+     @param compress Compression level (0 - 100).
+     @param nrOfThreads Number of threads available for compressing columns in parallel.
+     @param rowsPerChunk Maximum number of rows in a single data chunk, 0 to store all rows in a single chunk. The
+     append-only layout stores at most CHUNK_INDEX_SLOTS chunks, so larger chunks are used when required.
+     @param blockSizes Compression block size in bytes of each column, see the file based version.
+     @param goal Goal of the adaptive compression algorithm selection, see the file based version.
+     @param bloomBits Number of Bloom filter bits per key of each column, see the file based version.
+     @param mantissaBits Number of mantissa bits kept of each double column, see the file based version.
+     @param fastDecode Use LZ4HC instead of ZSTD for high compression, see the file based version.
+     @param compressLevels Compression level of each column, see the file based version.
+     */
+    void fstWrite(IFstOutput &output, IFstTable &fstTable, int compress, int nrOfThreads, unsigned long long rowsPerChunk,
+      const unsigned int* blockSizes = nullptr, const CompressionGoal* goal = nullptr,
+      const unsigned int* bloomBits = nullptr, const unsigned int* mantissaBits = nullptr, bool fastDecode = false,
+      const int* compressLevels = nullptr);
+
+    /**
+     Append the rows of a table to an existing fst file as a new data chunk. Only the new chunk and the chunkset
+     index are written, the existing data is left untouched.
+
+     @param fileName Path of the fst file.
+     @param fstTable Table with the same number and types of columns as the stored table.
+     @param compress Compression level (0 - 100).
+     @param nrOfThreads Number of threads available for compressing columns in parallel.
+     @param columnFactory Factory used to read the stored column names.
+     */
+    void fstAppend(const char* fileName, IFstTable &fstTable, int compress, int nrOfThreads,
+      IColumnFactory* columnFactory);
+
+    /**
+     Append the columns of a table to an existing fst file as a new horizontal chunkset, linked from the last
+     chunkset of the file. The new columns are stored in data chunks with the same rows as the data chunks of
+     the stored table, the existing data is left untouched.
+
+     @param fileName Path of the fst file.
+     @param fstTable Table with the same number of rows as the stored table.
+     @param compress Compression level (0 - 100).
+     @param nrOfThreads Number of threads available for compressing columns in parallel.
+     @param columnFactory Factory used to read the stored column names.
+     */
+    void fstCbind(const char* fileName, IFstTable &fstTable, int compress, int nrOfThreads,
+      IColumnFactory* columnFactory);
+
+    /**
+     Replace a column of an existing fst file. The new column is appended to the file as a horizontal chunkset
+     (see fstCbind) with the name of the replaced column, which takes the position of the replaced column. The data of
+     the replaced column is left in the file as dead space, until the file is copied (see FstCopier).
+
+     @param fileName Path of the fst file.
+     @param colName Name of the replaced column, which can't be a key column.
+     @param fstTable Table with a single column named colName and the same number of rows as the stored table.
+     @param compress Compression level (0 - 100).
+     @param nrOfThreads Number of threads available for compressing the column.
+     @param columnFactory Factory used to read the stored column names.
+     */
+    void fstReplaceColumn(const char* fileName, const char* colName, IFstTable &fstTable, int compress,
+      int nrOfThreads, IColumnFactory* columnFactory);
+
+    /**
+     Delete a column of an existing fst file by setting the COL_ATTR_DELETED flag of the column. Only the column
+     header is updated, the data of the column is left in the file as dead space.
+
+     @param fileName Path of the fst file.
+     @param colName Name of the deleted column, which can't be a key column or the last column of the table.
+     @param columnFactory Factory used to read the stored column names.
+     */
+    void fstDeleteColumn(const char* fileName, const char* colName, IColumnFactory* columnFactory);
 
     int fstMeta(const char* fileName, IColumnFactory* columnFactory);
 
-    int fstRead(const char* fileName, IFstTableReader &tableReader, IStringArray* columnSelection, int startRow, int endRow, IColumnFactory* columnFactory, std::vector<int> &keyIndex, IStringArray* selectedCols);
+    int fstMeta(IFstInput &input, IColumnFactory* columnFactory);
+
+    /**
+     Read a (subset of a) table from a fst file.
+
+     @param fileName Path of the fst file.
+     @param tableReader Table that receives the column vectors.
+     @param columnSelection Names of the selected columns or nullptr for all columns.
+     @param startRow First row to read (1-based).
+     @param endRow Last row to read or -1 for all remaining rows.
+     @param columnFactory Factory used to create column vectors (only used from the calling thread).
+     @param keyIndex Positions of the key columns in the result table.
+     @param selectedCols Names of the selected columns.
+     @param nrOfThreads Number of threads available for decompressing columns in parallel.
+     @param memoryMapped If true, the file is memory mapped instead of read through a buffered file stream.
+     */
+    int fstRead(const char* fileName, IFstTableReader &tableReader, IStringArray* columnSelection, long long startRow,
+      long long endRow, IColumnFactory* columnFactory, std::vector<int> &keyIndex, IStringArray* selectedCols,
+      int nrOfThreads, bool memoryMapped);
+
+    /**
+     Read a (subset of a) table from a fst input. Parameters are identical to the file based version.
+     */
+    int fstRead(IFstInput &input, IFstTableReader &tableReader, IStringArray* columnSelection, long long startRow,
+      long long endRow, IColumnFactory* columnFactory, std::vector<int> &keyIndex, IStringArray* selectedCols,
+      int nrOfThreads);
 };
 
 
+// Serialization helpers shared by FstStore and FstWriter
+
+// Read the table header, returns the file format version or 0 for the deprecated (pre v0.7.3) format.
+unsigned int ReadHeader(std::istream &myfile, unsigned int &tableClassType, int &keyLength, int &nrOfColsFirstChunk);
+
+// Number of leading key columns in keyColPos that were not dropped by appended rows (see FstWriter).
+int ValidKeyLength(const int* keyColPos, int keyLength);
+
+// Chunkset of columns appended to a table (see FstStore::fstCbind)
+struct HorzChunkSet
+{
+  unsigned long long pos;               // file position of the chunkset header
+  unsigned long long nextVertChunkSet;  // link to the additional chunkset indexes
+  int nrOfCols;
+  std::vector<unsigned short int> colAttributeTypes;
+  std::vector<unsigned short int> colTypes;
+};
+
+// Read the headers of the horizontal chunksets linked from nextHorzChunkSet (0 for none) and of the chunksets
+// linked from them, in order.
+void ReadHorzChunkSets(std::istream &myfile, unsigned long long nextHorzChunkSet,
+  std::vector<HorzChunkSet> &chunkSets);
+
+// Determine the stored columns that are visible in a table with the horizontal chunksets that start at the columns in
+// chunkSetFirstCols (followed by the total number of columns). Columns of appended chunksets replace the columns
+// with the same name of the preceding chunksets, columns with the COL_ATTR_DELETED flag are hidden. storedCols
+// receives the stored column of each visible column.
+void VisibleColumns(IStringColumn* colNames, const unsigned short int* colAttributeTypes,
+  const std::vector<int> &chunkSetFirstCols, std::vector<int> &storedCols);
+
+// Create a string column with the selected elements of strings, which should have no NA elements.
+IStringColumn* SelectStrings(IColumnFactory* columnFactory, IStringColumn* strings, const std::vector<int> &elements);
+
+// Collect the stored column type and data pointer of each column of fstTable. Returns false if the
+// table contains a column of an unknown type.
+bool SetColumnTypes(IFstTable &fstTable, int nrOfCols, unsigned short int* colTypes,
+  unsigned short int* colBaseTypes, char** colData);
+
+// Serialize rows firstRow until firstRow + nrOfRows of column colNr of fstTable, preceded by its (optional) Bloom
+// filters, checksum metadata and zone map and followed by the checksums of its blocks. Double columns with a
+// non-zero mantissaBits are rounded to that precision. With fastDecode, integer and double columns use LZ4HC
+// instead of ZSTD. Returns the offset of the column data relative to the starting position.
+unsigned long long WriteColumn(std::ostream &myfile, IFstTable &fstTable, unsigned int colNr, FstColumnType colType,
+  char* colData, unsigned long long firstRow, unsigned long long nrOfRows, int compress, int nrOfThreads,
+  unsigned int blockSize, const CompressionGoal* goal, unsigned int bloomBits = 0, unsigned int mantissaBits = 0,
+  bool fastDecode = false);
+
+// Write the attribute section with the encoded attributes of all columns. Returns the number of bytes written.
+unsigned long long WriteAttributes(std::ostream &myfile, const std::vector<std::vector<char>> &colAttributes);
+
+// Serialize rows firstRow until firstRow + nrOfRows of all columns of fstTable at the current position of myfile
+// and store the file position of each column in positionData. If blockSizes is specified, it holds the block
+// size in bytes of each column (0 for the default block size). If goal is specified, the compression algorithms
+// are selected adaptively. If bloomBits is specified, it holds the Bloom filter bits per key of each column. If
+// mantissaBits is specified, it holds the mantissa bits kept of each double column (0 for full precision).
+// With fastDecode, integer and double columns use LZ4HC instead of ZSTD. If compressLevels is specified, it holds
+// the compression level of each column, which is used instead of compress.
+void WriteColumns(std::ostream &myfile, IFstTable &fstTable, unsigned short int* colBaseTypes, char** colData,
+  unsigned long long* positionData, int nrOfCols, unsigned long long firstRow, unsigned long long nrOfRows, int compress,
+  int nrOfThreads, const unsigned int* blockSizes = nullptr, const CompressionGoal* goal = nullptr,
+  const unsigned int* bloomBits = nullptr, const unsigned int* mantissaBits = nullptr, bool fastDecode = false,
+  const int* compressLevels = nullptr);
+
+
 #endif  // FST_STORE_H
@@ -0,0 +1,107 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include <fsttasks.h>
+
+
+using namespace std;
+
+
+inline unsigned long long TaskRangeBits(unsigned int next, unsigned int end)
+{
+  return (static_cast<unsigned long long>(end) << 32) | next;
+}
+
+
+TaskQueue::TaskQueue(int nrOfTasks, int nrOfThreads) : ranges(nrOfThreads)
+{
+  for (int threadNr = 0; threadNr < nrOfThreads; ++threadNr)
+  {
+    unsigned int next = (unsigned int) ((long long) nrOfTasks * threadNr / nrOfThreads);
+    unsigned int end = (unsigned int) ((long long) nrOfTasks * (threadNr + 1) / nrOfThreads);
+    ranges[threadNr].range.store(TaskRangeBits(next, end));
+  }
+}
+
+
+int TaskQueue::Next(int threadNr)
+{
+  atomic<unsigned long long> &ownRange = ranges[threadNr].range;
+  unsigned long long range = ownRange.load();
+
+  // Tasks of the own range are taken from the front
+  while ((unsigned int) range < (unsigned int) (range >> 32))
+  {
+    if (ownRange.compare_exchange_weak(range, range + 1)) return (int) (unsigned int) range;
+  }
+
+  // Steal the second half of the largest remaining range. Ranges that are empty never receive tasks from other
+  // threads, so a non-empty range can't recur (taken tasks are never returned).
+  while (true)
+  {
+    int victimNr = -1;
+    unsigned long long victimRange = 0;
+    unsigned int mostTasks = 0;
+
+    for (int rangeNr = 0; rangeNr < (int) ranges.size(); ++rangeNr)
+    {
+      unsigned long long candidate = ranges[rangeNr].range.load();
+      unsigned int next = (unsigned int) candidate;
+      unsigned int end = (unsigned int) (candidate >> 32);
+
+      if (next < end && end - next > mostTasks)
+      {
+        victimNr = rangeNr;
+        victimRange = candidate;
+        mostTasks = end - next;
+      }
+    }
+
+    if (victimNr == -1) return -1;
+
+    unsigned int next = (unsigned int) victimRange;
+    unsigned int end = (unsigned int) (victimRange >> 32);
+    unsigned int stolen = (mostTasks + 1) / 2;
+
+    if (!ranges[victimNr].range.compare_exchange_strong(victimRange, TaskRangeBits(next, end - stolen))) continue;
+
+    // The first stolen task is taken, the others become the own range
+    unsigned int first = end - stolen;
+    ownRange.store(TaskRangeBits(first + 1, end));
+
+    return (int) first;
+  }
+}
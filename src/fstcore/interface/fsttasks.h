@@ -0,0 +1,80 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_TASKS_H
+#define FST_TASKS_H
+
+
+#include <atomic>
+#include <vector>
+
+
+/**
+ Work stealing distribution of the tasks of an OpenMP parallel region, for work of uneven size such as the blocks of
+ columns with very different lengths. The tasks (numbered 0 until nrOfTasks) are divided in contiguous ranges, one
+ range per thread, so each thread processes neighbouring tasks (consecutive blocks of a column) in order. A thread
+ that has completed its range steals the second half of the largest remaining range of another thread, so all threads
+ stay busy until the last tasks are taken.
+
+ The queue runs on the threads of the OpenMP runtime, which keeps its thread team between parallel regions and is
+ sized by the caller (getDTthreads() in the R package, which is set to a single thread in forked processes).
+ */
+class TaskQueue
+{
+  // Range of remaining tasks of a thread, padded to a cache line to prevent false sharing
+  struct TaskRange
+  {
+    std::atomic<unsigned long long> range;  // next task in the low and end of the range in the high 32 bits
+    char padding[64 - sizeof(std::atomic<unsigned long long>)];
+  };
+
+  std::vector<TaskRange> ranges;
+
+public:
+  /**
+   @param nrOfTasks Number of tasks, smaller than 2^31.
+   @param nrOfThreads Number of threads of the parallel region that takes the tasks.
+   */
+  TaskQueue(int nrOfTasks, int nrOfThreads);
+
+  /**
+   Take the next task of thread threadNr (its OpenMP thread number). Returns -1 when all tasks are taken.
+   */
+  int Next(int threadNr);
+};
+
+
+#endif  // FST_TASKS_H
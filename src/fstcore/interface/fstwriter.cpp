@@ -0,0 +1,665 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
+#include <vector>
+
+#include <ifsttable.h>
+#include <icolumnfactory.h>
+
+#include <fstdefines.h>
+#include <fsthandle.h>
+#include <fstio.h>
+#include <fststore.h>
+#include <fstwriter.h>
+#include <rowbatch.h>
+
+#include <character_v6.h>
+#include <double_v9.h>
+#include <zonemap.h>
+
+
+using namespace std;
+
+
+// Hides the key columns of a table. Batches are written as unsorted data.
+class UnkeyedTable : public IFstTable
+{
+  IFstTable &table;
+
+public:
+  UnkeyedTable(IFstTable &table) : table(table) {}
+
+  FstColumnType GetColumnType(unsigned int colNr) { return table.GetColumnType(colNr); }
+
+  IBlockWriter* GetCharWriter(unsigned int colNr) { return table.GetCharWriter(colNr); }
+
+  int* GetLogicalWriter(unsigned int colNr) { return table.GetLogicalWriter(colNr); }
+
+  int* GetIntWriter(unsigned int colNr) { return table.GetIntWriter(colNr); }
+
+  double* GetDoubleWriter(unsigned int colNr) { return table.GetDoubleWriter(colNr); }
+
+  long long* GetInt64Writer(unsigned int colNr) { return table.GetInt64Writer(colNr); }
+
+  IBlockWriter* GetLevelWriter(unsigned int colNr) { return table.GetLevelWriter(colNr); }
+
+  void GetColumnAttributes(unsigned int colNr, vector<char> &attributeData)
+  {
+    table.GetColumnAttributes(colNr, attributeData);
+  }
+
+  IBlockWriter* GetColNameWriter() { return table.GetColNameWriter(); }
+
+  void GetKeyColumns(int* keyColPos) {}
+
+  unsigned int NrOfKeys() { return 0; }
+
+  unsigned int NrOfColumns() { return table.NrOfColumns(); }
+
+  unsigned long long NrOfRows() { return table.NrOfRows(); }
+};
+
+
+// Number of leading key columns on which the rows of the batch are sorted. Each key column is compared in a
+// single pass over the rows that are tied on the previous key columns.
+int SortedKeyLength(RowBatch &keys)
+{
+  unsigned long long nrOfRows = keys.nrOfRows;
+  int nrOfKeys = (int) keys.colTypes.size();
+
+  if (nrOfRows < 2) return nrOfKeys;
+
+  vector<unsigned char> tied(nrOfRows - 1, 1);  // rows pos and pos + 1 have equal keys so far
+  vector<unsigned long long> values;
+
+  for (int keyNr = 0; keyNr < nrOfKeys; ++keyNr)
+  {
+    unsigned char unsorted = 0;
+
+    if (keys.colTypes[keyNr] == FstColumnType::CHARACTER)
+    {
+      vector<int> keyIndex(1, keyNr);
+
+      for (unsigned long long pos = 0; pos < nrOfRows - 1; ++pos)
+      {
+        if (!tied[pos]) continue;
+
+        int order = CompareRows(keys, pos, keys, pos + 1, keyIndex);
+
+        if (order > 0) return keyNr;
+        tied[pos] = order == 0;
+      }
+
+      continue;
+    }
+
+    values.resize(nrOfRows);
+
+    for (unsigned long long pos = 0; pos < nrOfRows; ++pos)
+    {
+      values[pos] = NumericKey(keys, keyNr, pos);
+    }
+
+    // Branch free, so the compiler can vectorize the comparisons
+    for (unsigned long long pos = 0; pos < nrOfRows - 1; ++pos)
+    {
+      unsorted |= tied[pos] & (values[pos] > values[pos + 1]);
+      tied[pos] &= values[pos] == values[pos + 1];
+    }
+
+    if (unsorted) return keyNr;
+  }
+
+  return nrOfKeys;
+}
+
+
+FstWriter::FstWriter(const char* fileName, int compress, int nrOfThreads, IColumnFactory* columnFactory) :
+  lastKeys(vector<FstColumnType>())
+{
+  this->fileName      = fileName;
+  this->compress      = compress;
+  this->nrOfThreads   = nrOfThreads;
+  this->columnFactory = columnFactory;
+
+  isOpen   = false;
+  isClosed = false;
+  sortedBatches = false;
+  nrOfCols = 0;
+  nrOfRows = 0;
+  nrOfRowsPos = 0;
+  indexPos = 0;
+  linkPos  = 0;
+  keyZoneMap  = false;
+  hasLastKeys = false;
+}
+
+
+FstWriter::~FstWriter()
+{
+  if (isOpen) myfile.close();
+}
+
+
+void FstWriter::Open()
+{
+  if (isClosed)
+  {
+    throw(runtime_error("The fst writer is closed."));
+  }
+
+  if (isOpen) return;
+
+  // The existing file is updated in place
+  myfile.open(fileName.c_str(), ios::binary | ios::in | ios::out);
+
+  if (myfile.fail())
+  {
+    throw(runtime_error("There was an error opening the fst file, please check for a correct path."));
+  }
+
+  isOpen = true;
+
+  unsigned int tableClassType;
+  int keyLength, nrOfColsFirstChunk;
+  unsigned int version = ReadHeader(myfile, tableClassType, keyLength, nrOfColsFirstChunk);
+
+  // Older files lack the chunkset index and the append-only layout keeps its index in a trailer
+  if (version != FST_VERSION)
+  {
+    throw(runtime_error(FSTERROR_NO_APPEND));
+  }
+
+  // Continue reading table metadata
+  int metaSize = 32 + 4 * keyLength + 6 * nrOfColsFirstChunk;
+  vector<char> metaDataBlock(metaSize);
+  myfile.read(metaDataBlock.data(), metaSize);
+
+  if (!myfile)
+  {
+    throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+  }
+
+  unsigned int tmpOffset = 4 * keyLength;
+
+  unsigned long long* p_nextHorzChunkSet = (unsigned long long*) &metaDataBlock[tmpOffset];
+  unsigned long long* p_nextVertChunkSet = (unsigned long long*) &metaDataBlock[tmpOffset + 8];
+  unsigned long long* p_nrOfRows         = (unsigned long long*) &metaDataBlock[tmpOffset + 16];
+  int* p_nrOfCols                        = (int*) &metaDataBlock[tmpOffset + 28];
+  unsigned short int* p_colAttrTypes     = (unsigned short int*) &metaDataBlock[tmpOffset + 32];
+  unsigned short int* p_colTypes         = (unsigned short int*) &metaDataBlock[tmpOffset + 32 + 2 * nrOfColsFirstChunk];
+
+  // Appended rows would lack the data of the columns in appended horizontal chunksets
+  if (*p_nextHorzChunkSet != 0)
+  {
+    throw(runtime_error("Rows can't be appended to a fst file with appended columns."));
+  }
+
+  nrOfCols    = *p_nrOfCols;
+  nrOfRows    = *p_nrOfRows;
+  nrOfRowsPos = TABLE_META_SIZE + tmpOffset + 16;
+  colTypes.assign(p_colTypes, p_colTypes + nrOfCols);
+
+  // With sorted batches, the key is the responsibility of the caller
+  if (!sortedBatches)
+  {
+    int* p_keyColPos = (int*) metaDataBlock.data();
+    keyColPos.assign(p_keyColPos, p_keyColPos + ValidKeyLength(p_keyColPos, keyLength));
+
+    keyZoneMap = !keyColPos.empty() && (p_colAttrTypes[keyColPos[0]] & COL_ATTR_ZONE_MAP) != 0;
+  }
+
+  // Appended data is stored with the precision recorded for each column
+  mantissaBits.assign(nrOfCols, 0);
+  for (int colNr = 0; colNr < nrOfCols; ++colNr)
+  {
+    if ((p_colAttrTypes[colNr] & COL_ATTR_DELETED) != 0)
+    {
+      throw(runtime_error("Rows can't be appended to a fst file with deleted columns."));
+    }
+
+    if ((p_colAttrTypes[colNr] & COL_ATTR_PRECISION) != 0)
+    {
+      mantissaBits[colNr] = p_colAttrTypes[colNr] & COL_ATTR_BITS_MASK;
+    }
+  }
+
+
+  // The first chunkset index is located directly after the column names
+  IStringColumn* colNames = columnFactory->CreateStringColumn(nrOfCols);
+  fdsReadCharVec_v6(myfile, colNames, TABLE_META_SIZE + metaSize, 0, nrOfCols, nrOfCols);
+  delete colNames;
+
+  indexPos = myfile.tellg();
+  linkPos  = TABLE_META_SIZE + tmpOffset + 8;  // location of nextVertChunkSet
+
+  // Follow the links to the last chunkset index
+  unsigned long long nextIndexPos = *p_nextVertChunkSet;
+  while (nextIndexPos != 0)
+  {
+    if (nextIndexPos <= indexPos)
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+
+    linkPos  = nextIndexPos;
+    indexPos = nextIndexPos + 8;
+
+    myfile.seekg(nextIndexPos);
+    myfile.read((char*) &nextIndexPos, 8);
+
+    if (!myfile)
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+  }
+
+  myfile.seekg(indexPos);
+  myfile.read(chunkIndex, CHUNK_INDEX_SIZE);
+
+  unsigned long long* p_nrOfChunks = (unsigned long long*) &chunkIndex[136];
+
+  if (!myfile || *p_nrOfChunks == 0 || *p_nrOfChunks > CHUNK_INDEX_SLOTS)
+  {
+    throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+  }
+}
+
+
+void FstWriter::WriteBatch(IFstTable &batch)
+{
+  if (isClosed)
+  {
+    throw(runtime_error("The fst writer is closed."));
+  }
+
+  int batchNrOfCols = batch.NrOfColumns();
+  unsigned long long batchNrOfRows = batch.NrOfRows();
+
+  if (batchNrOfCols == 0)
+  {
+    throw(runtime_error("Your dataset needs at least one column."));
+  }
+
+  if (batchNrOfRows == 0)
+  {
+    throw(runtime_error("The dataset contains no data."));
+  }
+
+  // The first batch creates the file and defines the column names and types
+  if (!isOpen)
+  {
+    UnkeyedTable unkeyedBatch(batch);
+
+    FstStore fstStore(fileName);
+    fstStore.fstWrite(fileName.c_str(), sortedBatches ? batch : unkeyedBatch, compress, nrOfThreads, 0);
+
+    Open();
+
+    return;
+  }
+
+  if (batchNrOfCols != nrOfCols)
+  {
+    throw(runtime_error(FSTERROR_INCORRECT_COL_COUNT));
+  }
+
+
+  // Column types of the batch should match the stored column types
+  vector<unsigned short int> batchColTypes(nrOfCols);
+  vector<unsigned short int> colBaseTypes(nrOfCols);
+  vector<char*> colData(nrOfCols);
+
+  if (!SetColumnTypes(batch, nrOfCols, batchColTypes.data(), colBaseTypes.data(), colData.data()))
+  {
+    throw(runtime_error("Unknown type found in column."));
+  }
+
+  if (batchColTypes != colTypes)
+  {
+    throw(runtime_error(FSTERROR_INCORRECT_COL_TYPE));
+  }
+
+
+  // Rows that don't follow the sort order shorten the key before any data is written, so the stored key is valid
+  // at all times
+  RowBatch keys(vector<FstColumnType>{});
+
+  if (!keyColPos.empty())
+  {
+    CopyKeys(batch, keys);
+
+    int keyLength = min(FollowingKeyLength(keys), SortedKeyLength(keys));
+
+    if (keyLength < (int) keyColPos.size())
+    {
+      DropKeyColumns(keyLength);
+    }
+  }
+
+
+  // Uncompressed data is limited by disk speed only, so there is nothing to gain from multiple threads
+  int nrOfWriteThreads = compress == 0 ? 1 : nrOfThreads;
+
+  // The new data chunk is written at the end of the file, its position data is completed afterwards
+  myfile.seekp(0, ios_base::end);
+  unsigned long long newChunkPos = myfile.tellp();
+
+  vector<unsigned long long> positionData(nrOfCols);
+  myfile.write((char*) positionData.data(), 8 * nrOfCols);
+
+  WriteColumns(myfile, batch, colBaseTypes.data(), colData.data(), positionData.data(), nrOfCols, 0,
+    batchNrOfRows, compress, nrOfWriteThreads, nullptr, nullptr, nullptr, mantissaBits.data());
+
+  myfile.seekp(newChunkPos);
+  myfile.write((char*) positionData.data(), 8 * nrOfCols);
+
+
+  // Only after all chunk data is written, the chunk is added to the index
+  unsigned long long* chunkPos     = (unsigned long long*) chunkIndex;
+  unsigned long long* chunkRows    = (unsigned long long*) &chunkIndex[64];
+  unsigned long long* p_nrOfChunks = (unsigned long long*) &chunkIndex[136];
+
+  if (*p_nrOfChunks < CHUNK_INDEX_SLOTS)
+  {
+    chunkPos[*p_nrOfChunks]  = newChunkPos;
+    chunkRows[*p_nrOfChunks] = batchNrOfRows;
+    ++(*p_nrOfChunks);
+
+    myfile.seekp(indexPos);
+    myfile.write(chunkIndex, CHUNK_INDEX_SIZE);
+  }
+  else
+  {
+    // All slots are used, link a new chunkset index
+    char newIndex[8 + CHUNK_INDEX_SIZE];
+    memset(newIndex, 0, 8 + CHUNK_INDEX_SIZE);
+
+    unsigned long long* newChunkIndex = (unsigned long long*) &newIndex[8];
+    newChunkIndex[0]  = newChunkPos;    // chunkPos
+    newChunkIndex[8]  = batchNrOfRows;  // chunkRows
+    newChunkIndex[16] = 1;              // nrOfChunksPerIndexRow
+    newChunkIndex[17] = 1;              // nrOfChunks
+
+    myfile.seekp(0, ios_base::end);
+    unsigned long long newIndexPos = myfile.tellp();
+    myfile.write(newIndex, 8 + CHUNK_INDEX_SIZE);
+
+    myfile.seekp(linkPos);
+    myfile.write((char*) &newIndexPos, 8);
+
+    // The new index becomes the last index
+    memcpy(chunkIndex, &newIndex[8], CHUNK_INDEX_SIZE);
+    linkPos  = newIndexPos;
+    indexPos = newIndexPos + 8;
+  }
+
+  // Total number of rows
+  nrOfRows += batchNrOfRows;
+  myfile.seekp(nrOfRowsPos);
+  myfile.write((char*) &nrOfRows, 8);
+
+  myfile.flush();
+
+  if (myfile.fail())
+  {
+    throw(runtime_error("There was an error writing the fst data."));
+  }
+
+  // The next batch follows the last row of this batch
+  if (!keyColPos.empty())
+  {
+    lastKeys.SetColumnTypes(keys.colTypes);
+    lastKeys.AssignRow(keys, batchNrOfRows - 1);
+    hasLastKeys = true;
+  }
+}
+
+
+void FstWriter::CopyKeys(IFstTable &batch, RowBatch &keys)
+{
+  vector<FstColumnType> keyTypes;
+
+  for (int colNr : keyColPos)
+  {
+    FstColumnType colType = batch.GetColumnType(colNr);
+
+    // Factor columns are sorted on their level codes, which differ between the batch and the table
+    if (colType == FstColumnType::FACTOR) break;
+
+    keyTypes.push_back(colType);
+  }
+
+  keys.SetColumnTypes(keyTypes);
+  keys.nrOfRows = batch.NrOfRows();
+
+  for (unsigned int keyNr = 0; keyNr < keyTypes.size(); ++keyNr)
+  {
+    int colNr = keyColPos[keyNr];
+
+    switch (keyTypes[keyNr])
+    {
+      case FstColumnType::CHARACTER:
+        CopyStrings(batch.GetCharWriter(colNr), keys.strings[keyNr]);
+        break;
+
+      case FstColumnType::INT_32:
+      {
+        int* intData = batch.GetIntWriter(colNr);
+        keys.ints[keyNr].assign(intData, intData + keys.nrOfRows);
+        break;
+      }
+
+      case FstColumnType::BOOL_32:
+      {
+        int* logicalData = batch.GetLogicalWriter(colNr);
+        keys.ints[keyNr].assign(logicalData, logicalData + keys.nrOfRows);
+        break;
+      }
+
+      case FstColumnType::INT_64:
+      {
+        long long* int64Data = batch.GetInt64Writer(colNr);
+        keys.longs[keyNr].assign(int64Data, int64Data + keys.nrOfRows);
+        break;
+      }
+
+      default:  // double, date and timestamp
+      {
+        double* doubleData = batch.GetDoubleWriter(colNr);
+        keys.doubles[keyNr].resize(keys.nrOfRows);
+
+        // Rounding can make values equal, which changes the order of the rows on the next key columns
+        if (mantissaBits[colNr] != 0)
+        {
+          ReduceRealPrecision(doubleData, keys.doubles[keyNr].data(), keys.nrOfRows, mantissaBits[colNr]);
+        }
+        else
+        {
+          keys.doubles[keyNr].assign(doubleData, doubleData + keys.nrOfRows);
+        }
+
+        break;
+      }
+    }
+  }
+}
+
+
+int FstWriter::FollowingKeyLength(RowBatch &keys)
+{
+  int nrOfKeys = (int) keys.colTypes.size();
+
+  if (nrOfKeys == 0) return 0;
+
+  // The zone map decides without reading any column data, unless the first key values are equal
+  if (!hasLastKeys)
+  {
+    int order = ZoneMapOrder(keys);
+
+    if (order != 0) return order > 0 ? nrOfKeys : 0;
+
+    lastKeys.SetColumnTypes(keys.colTypes);
+    lastKeys.nrOfRows = 0;
+
+    FstFileInput tableInput(fileName.c_str());
+    FstHandle table(tableInput, &lastKeys);
+
+    if (!table.Open())
+    {
+      throw(runtime_error(FSTERROR_DAMAGED_HEADER));
+    }
+
+    vector<int> colIndex(keyColPos.begin(), keyColPos.begin() + nrOfKeys);
+    table.ReadRows(lastKeys, colIndex, nrOfRows - 1, 1, 1);
+    hasLastKeys = true;
+  }
+
+  for (int keyNr = 0; keyNr < nrOfKeys; ++keyNr)
+  {
+    int order = CompareRows(lastKeys, 0, keys, 0, vector<int>(1, keyNr));
+
+    if (order != 0) return order < 0 ? nrOfKeys : keyNr;
+  }
+
+  return nrOfKeys;  // equal keys
+}
+
+
+int FstWriter::ZoneMapOrder(RowBatch &keys)
+{
+  if (!keyZoneMap) return 0;
+
+  unsigned long long* chunkPos     = (unsigned long long*) chunkIndex;
+  unsigned long long* chunkRows    = (unsigned long long*) &chunkIndex[64];
+  unsigned long long* p_nrOfChunks = (unsigned long long*) &chunkIndex[136];
+  unsigned long long lastChunk     = *p_nrOfChunks - 1;
+
+  // Position of the first key column in the last data chunk
+  unsigned long long colPos;
+  myfile.seekg(chunkPos[lastChunk] + 8 * (unsigned long long) keyColPos[0]);
+  myfile.read((char*) &colPos, 8);
+
+  ZoneMap zoneMap;
+  ZoneMapEntry entry;
+
+  if (!myfile || !zoneMap.ReadMeta(myfile, colPos, keys.colTypes[0], chunkRows[lastChunk]) ||
+    !zoneMap.ReadBlock(myfile, colPos, zoneMap.NrOfBlocks() - 1, entry))
+  {
+    myfile.clear();
+    return 0;
+  }
+
+  // NA values are sorted first, so the last row holds the maximum if the block has any other values
+  if (entry.naCount == entry.nrOfValues) return 0;
+
+  if (keys.colTypes[0] == FstColumnType::CHARACTER)
+  {
+    StringVectorColumn &column = keys.strings[0];
+
+    if (column.isNA[0]) return -1;
+
+    // Strings are compared on the stored prefix only
+    char prefix[ZONE_MAP_PREFIX_SIZE];
+    memset(prefix, 0, ZONE_MAP_PREFIX_SIZE);
+    memcpy(prefix, column.strings[0].data(), min(column.strings[0].size(), (size_t) ZONE_MAP_PREFIX_SIZE));
+
+    int order = memcmp(prefix, entry.maxPrefix, ZONE_MAP_PREFIX_SIZE);
+
+    return order < 0 ? -1 : (order > 0 ? 1 : 0);
+  }
+
+  unsigned long long maxKey;
+
+  switch (keys.colTypes[0])
+  {
+    case FstColumnType::INT_32:
+    case FstColumnType::BOOL_32:
+      maxKey = IntKey((int) entry.maxValue);
+      break;
+
+    case FstColumnType::INT_64:
+      maxKey = Int64Key(entry.maxInt64);
+      break;
+
+    default:  // double, date and timestamp
+      maxKey = DoubleKey(entry.maxValue);
+      break;
+  }
+
+  unsigned long long firstKey = NumericKey(keys, 0, 0);
+
+  if (firstKey == maxKey) return 0;
+
+  return firstKey < maxKey ? -1 : 1;
+}
+
+
+void FstWriter::DropKeyColumns(int keyLength)
+{
+  // The stored key length determines the layout of the metadata, so the dropped key columns are marked instead
+  vector<int> droppedKeys(keyColPos.size() - keyLength, KEY_COL_DROPPED);
+
+  myfile.seekp(TABLE_META_SIZE + 4 * keyLength);
+  myfile.write((char*) droppedKeys.data(), 4 * droppedKeys.size());
+  myfile.flush();
+
+  if (myfile.fail())
+  {
+    throw(runtime_error("There was an error writing the fst data."));
+  }
+
+  keyColPos.resize(keyLength);
+}
+
+
+void FstWriter::Close()
+{
+  isClosed = true;
+
+  if (!isOpen) return;
+
+  isOpen = false;
+  myfile.close();
+
+  if (myfile.fail())
+  {
+    throw(runtime_error("There was an error writing the fst data."));
+  }
+}
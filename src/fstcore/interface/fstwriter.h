@@ -0,0 +1,148 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef FST_WRITER_H
+#define FST_WRITER_H
+
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <icolumnfactory.h>
+#include <ifsttable.h>
+#include <fstdefines.h>
+#include <rowbatch.h>
+
+
+/**
+ Writes a fst file from a sequence of row batches. Each batch is serialized as a separate data chunk as soon as
+ it is written, so memory use is bounded by the size of a single batch. The file is kept open between batches
+ and the chunkset index is updated after each batch, leaving a complete fst file on disk at all times.
+
+ Batches appended to a table with key columns are verified to follow the sort order of the key. Only the key
+ columns of the batch and a single stored row are compared: the first row of the batch with the maximum of the
+ first key column in the zone map of the last block of the table, and only if these are equal, with the last row
+ of the table. Trailing key columns on which the appended rows are out of order are dropped from the key.
+ */
+class FstWriter
+{
+  std::string fileName;
+  int compress;
+  int nrOfThreads;
+  IColumnFactory* columnFactory;
+
+  std::fstream myfile;
+  bool isOpen;
+  bool isClosed;
+  bool sortedBatches;  // the key columns of the first batch are retained
+
+  // Layout of the opened file
+  int nrOfCols;
+  std::vector<int> keyColPos;         // key columns of the table that are still valid
+  std::vector<unsigned short int> colTypes;
+  std::vector<unsigned int> mantissaBits;  // recorded precision of each double column (0 for full precision)
+  unsigned long long nrOfRowsPos;     // file position of the total number of rows
+  unsigned long long nrOfRows;        // total number of rows in the file
+  unsigned long long indexPos;        // file position of the last chunkset index
+  unsigned long long linkPos;         // file position of the link to the last chunkset index
+  char chunkIndex[CHUNK_INDEX_SIZE];  // copy of the last chunkset index
+  bool keyZoneMap;                    // the first key column has zone maps
+  bool hasLastKeys;                   // the key columns of the last row of the table are known
+  RowBatch lastKeys;                  // key columns of the last row of the table (only the comparable key columns)
+
+  // Copy the leading key columns of the batch that can be compared (all but factors) to keys, with the stored
+  // precision
+  void CopyKeys(IFstTable &batch, RowBatch &keys);
+
+  // Number of leading key columns on which the first row of the batch follows the last row of the table
+  int FollowingKeyLength(RowBatch &keys);
+
+  // Order of the first row of the batch relative to the last row of the table on the first key column, taken from
+  // the zone map of the last block of the table. Returns 0 if the zone map can't decide.
+  int ZoneMapOrder(RowBatch &keys);
+
+  // Drop the key columns from position keyLength onwards from the key of the table
+  void DropKeyColumns(int keyLength);
+
+public:
+  /**
+   Create a writer for a fst file. No data is written until the first batch arrives.
+
+   @param fileName Path of the fst file.
+   @param compress Compression level (0 - 100) used for all batches.
+   @param nrOfThreads Number of threads available for compressing columns in parallel.
+   @param columnFactory Factory used to read the stored column names of an existing file.
+   */
+  FstWriter(const char* fileName, int compress, int nrOfThreads, IColumnFactory* columnFactory);
+
+  ~FstWriter();
+
+  /**
+   Open an existing fst file, subsequent batches are appended to the stored table. Without a call to Open, the
+   first batch creates a new file (overwriting any existing file) and defines the column types of the table.
+   The key of a stored table is kept for as far as the appended rows follow its sort order (see SetSortedBatches
+   for batches that are known to be sorted).
+   */
+  void Open();
+
+  /**
+   Retain the key columns of the first batch. The batches should then be sorted on these key columns and each batch
+   should follow the rows of the previous batch in the sort order, which is not verified. By default, key columns
+   of the batches are ignored.
+   */
+  void SetSortedBatches(bool sorted) { sortedBatches = sorted; }
+
+  /**
+   Write a batch of rows as a new data chunk. The batch should have the same number and types of columns as the
+   first batch (or the stored table). Key columns of the batch are ignored, see SetSortedBatches. If the rows of the
+   batch don't follow the sort order of the stored table, the key of the table is shortened or dropped before the
+   batch is written.
+   */
+  void WriteBatch(IFstTable &batch);
+
+  /**
+   Close the file. Further batches are refused.
+   */
+  void Close();
+
+  /**
+   Total number of rows in the file.
+   */
+  unsigned long long NrOfRows() { return nrOfRows; }
+};
+
+
+#endif  // FST_WRITER_H
@@ -46,11 +46,20 @@ public:
   unsigned int bufSize;
   char* activeBuf;
 
-  unsigned int vecLength;
+  unsigned long long vecLength;
 
   virtual ~IBlockWriter() {};
 
-  virtual void SetBuffersFromVec(unsigned int startCount, unsigned int endCount) = 0;
+  virtual void SetBuffersFromVec(unsigned long long startCount, unsigned long long endCount) = 0;
+
+  // Pointers to and sizes of the strings startCount until endCount and their NA bits (as set by SetBuffersFromVec),
+  // without copying the strings, so they can be copied to the block buffer on another thread. The pointers should
+  // remain valid during the write. Writers that can't provide them return false.
+  virtual bool GatherStrings(unsigned long long startCount, unsigned long long endCount, const char** strings,
+    unsigned int* sizes, unsigned int* naBits)
+  {
+    return false;
+  }
 };
 
 
@@ -44,12 +44,23 @@ class IColumnFactory
 {
 public:
   virtual ~IColumnFactory() {};
-  virtual IFactorColumn* CreateFactorColumn(int nrOfRows) = 0;
-  virtual ILogicalColumn* CreateLogicalColumn(int nrOfRows) = 0;
-  virtual IDoubleColumn* CreateDoubleColumn(int nrOfRows) = 0;
-  virtual IIntegerColumn* CreateIntegerColumn(int nrOfRows) = 0;
-  virtual IStringColumn* CreateStringColumn(int nrOfRows) = 0;
+  virtual IFactorColumn* CreateFactorColumn(unsigned long long nrOfRows) = 0;
+  virtual ILogicalColumn* CreateLogicalColumn(unsigned long long nrOfRows) = 0;
+  virtual IDoubleColumn* CreateDoubleColumn(unsigned long long nrOfRows) = 0;
+  virtual IIntegerColumn* CreateIntegerColumn(unsigned long long nrOfRows) = 0;
+  virtual IInt64Column* CreateInt64Column(unsigned long long nrOfRows) = 0;
+  virtual IStringColumn* CreateStringColumn(unsigned long long nrOfRows) = 0;
   virtual IStringArray* CreateStringArray() = 0;
+
+  // The result columns of a range read are created with the position of the column in the selection (colSel), so
+  // a factory can return columns that wrap caller supplied (reused) memory of at least nrOfRows elements. By
+  // default a new column is created.
+  virtual IFactorColumn* CreateFactorColumn(unsigned long long nrOfRows, int colSel) { return CreateFactorColumn(nrOfRows); }
+  virtual ILogicalColumn* CreateLogicalColumn(unsigned long long nrOfRows, int colSel) { return CreateLogicalColumn(nrOfRows); }
+  virtual IDoubleColumn* CreateDoubleColumn(unsigned long long nrOfRows, int colSel) { return CreateDoubleColumn(nrOfRows); }
+  virtual IIntegerColumn* CreateIntegerColumn(unsigned long long nrOfRows, int colSel) { return CreateIntegerColumn(nrOfRows); }
+  virtual IInt64Column* CreateInt64Column(unsigned long long nrOfRows, int colSel) { return CreateInt64Column(nrOfRows); }
+  virtual IStringColumn* CreateStringColumn(unsigned long long nrOfRows, int colSel) { return CreateStringColumn(nrOfRows); }
 };
 
 #endif // IFST_COLUMN_FACTORY_H
@@ -55,10 +55,18 @@ class IStringColumn
 public:
 
   virtual ~IStringColumn() {};
-  virtual void AllocateVec(unsigned int vecLength) = 0;
+  virtual void AllocateVec(unsigned long long vecLength) = 0;
   virtual void BufferToVec(unsigned int nrOfElements, unsigned int startElem, unsigned int endElem,
-    unsigned int vecOffset, unsigned int* sizeMeta, char* buf) = 0;
+    unsigned long long vecOffset, unsigned int* sizeMeta, char* buf) = 0;
   virtual const char* GetElement(int elementNr) = 0;
+
+  /**
+   Set elements vecOffset until vecOffset + length from 1-based level codes (INT_MIN for NA), so each distinct
+   string can be converted once. The levels are given by their cumulative sizes and concatenated characters.
+   Returns false if not implemented, the elements are then set with BufferToVec.
+  */
+  virtual bool LevelsToVec(unsigned long long vecOffset, unsigned long long length, const int* codes,
+    unsigned int nrOfLevels, const unsigned int* levelSizes, const char* levelBuf) { return false; }
 };
 
 
@@ -88,6 +96,14 @@ public:
 };
 
 
+class IInt64Column
+{
+public:
+  virtual ~IInt64Column() {};
+  virtual long long* Data() = 0;
+};
+
+
 class ILogicalColumn
 {
 public:
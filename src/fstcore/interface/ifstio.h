@@ -0,0 +1,137 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef IFST_IO_H
+#define IFST_IO_H
+
+
+#include <istream>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+
+// Identity of a file that is the same in all processes. A file that is rewritten receives a new identity, because
+// its modification time changes.
+struct FstFileIdentity
+{
+  unsigned long long device;
+  unsigned long long inode;
+  unsigned long long size;
+  unsigned long long modified;  // modification time in nanoseconds
+
+  bool operator==(const FstFileIdentity &other) const
+  {
+    return device == other.device && inode == other.inode && size == other.size && modified == other.modified;
+  }
+};
+
+
+// Source of the data of a fst file. Every call to OpenStream returns a new and independent seekable
+// stream, so multiple threads can read from the same source concurrently (each with its own stream).
+class IFstInput
+{
+public:
+  virtual ~IFstInput() {};
+
+  // Returns a new stream positioned at the start of the fst data or nullptr on failure. The caller
+  // takes ownership of the stream. Must be callable from multiple threads simultaneously.
+  virtual std::istream* OpenStream() = 0;
+
+  // True if streams of the input can be read from threads other than the thread that opened the input. Otherwise
+  // all reads are done from the calling thread.
+  virtual bool ConcurrentStreams() { return true; }
+
+  // True if the input benefits from Prefetch (data that isn't in memory yet)
+  virtual bool CanPrefetch() { return false; }
+
+  // Hint that the bytes [offset, offset + size) will be read soon, so they can be fetched in the background while
+  // earlier data is processed. Only used from a single thread.
+  virtual void Prefetch(unsigned long long offset, unsigned long long size) {}
+
+  // Hint for a set of (offset, size) byte ranges, sorted by offset. Inputs that can fetch multiple ranges
+  // concurrently override this method.
+  virtual void PrefetchRanges(const std::vector<std::pair<unsigned long long, unsigned long long>> &ranges)
+  {
+    for (const std::pair<unsigned long long, unsigned long long> &range : ranges) Prefetch(range.first, range.second);
+  }
+
+  // Identity of the file of the input, used to share decompressed blocks between processes (see SharedBlockCache).
+  // Returns false if the input isn't a file.
+  virtual bool FileIdentity(FstFileIdentity &identity) { return false; }
+};
+
+
+// Random access to the bytes of a remote fst file, for example an object in an object store that is read with
+// HTTP range requests.
+class IRangeSource
+{
+public:
+  virtual ~IRangeSource() {};
+
+  // Size of the file in bytes
+  virtual unsigned long long Size() = 0;
+
+  // Read nrOfRanges byte ranges, range i [offsets[i], offsets[i] + sizes[i]) is copied to buffers[i]. The ranges
+  // can be fetched concurrently. Returns false if not all ranges could be read.
+  virtual bool ReadRanges(unsigned int nrOfRanges, const unsigned long long* offsets, const unsigned long long* sizes,
+    char** buffers) = 0;
+
+  // True if ReadRanges can be called from multiple threads simultaneously
+  virtual bool IsThreadSafe() { return false; }
+};
+
+
+// Destination of a fst file. For a seekable output, block indexes and the chunkset index are updated in
+// place after the column data has been written. Otherwise the file is written in a single forward pass,
+// using the append-only layout with the chunkset index in a trailer.
+class IFstOutput
+{
+public:
+  virtual ~IFstOutput() {};
+
+  // True if the stream supports seekp and tellp
+  virtual bool IsSeekable() = 0;
+
+  // Returns a stream positioned at the start of the destination or nullptr on failure. The stream is
+  // owned by the output and remains valid until Close is called.
+  virtual std::ostream* Open() = 0;
+
+  // Complete the output. Returns false if the data could not be written completely.
+  virtual bool Close() = 0;
+};
+
+
+#endif // IFST_IO_H
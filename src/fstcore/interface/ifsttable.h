@@ -36,6 +36,8 @@
 #ifndef IFST_TABLE_H
 #define IFST_TABLE_H
 
+#include <vector>
+
 #include "ifstcolumn.h"
 #include "iblockrunner.h"
 
@@ -46,10 +48,28 @@ enum FstColumnType
   INT_32,
   DOUBLE_64,
   BOOL_32,
+  INT_64,
+  DATE_DAYS,
+  TIMESTAMP_SECONDS,
   UNKNOWN
 };
 
 
+/**
+  Dates (days since epoch) and timestamps (seconds since epoch) are stored as doubles. Only their column type
+  differs, so that readers can restore the original class.
+*/
+inline FstColumnType ValueType(FstColumnType colType)
+{
+  if (colType == FstColumnType::DATE_DAYS || colType == FstColumnType::TIMESTAMP_SECONDS)
+  {
+    return FstColumnType::DOUBLE_64;
+  }
+
+  return colType;
+}
+
+
 /**
   Interface to a fst table. A fst table is a temporary wrapper around an array of columnar data buffers.
   The table only exists to facilitate serialization and deserialization of data.
@@ -69,8 +89,16 @@ class IFstTable
 
     virtual double* GetDoubleWriter(unsigned int colNr) = 0;
 
+    virtual long long* GetInt64Writer(unsigned int colNr) = 0;
+
     virtual IBlockWriter* GetLevelWriter(unsigned int colNr) = 0;
 
+    /**
+      Encoded attributes of a column (other than the attributes restored from the column type), empty if the
+      column has none. The encoding is opaque to the fst format, only the table reader needs to decode it.
+    */
+    virtual void GetColumnAttributes(unsigned int colNr, std::vector<char> &attributeData) = 0;
+
     virtual IBlockWriter* GetColNameWriter() = 0;
 
     virtual void GetKeyColumns(int* keyColPos) = 0;
@@ -79,7 +107,7 @@ class IFstTable
 
     virtual unsigned int NrOfColumns() = 0;
 
-    virtual unsigned int NrOfRows() = 0;
+    virtual unsigned long long NrOfRows() = 0;
 };
 
 
@@ -92,7 +120,7 @@ class IFstTableReader
 public:
   virtual ~IFstTableReader() {};
 
-  virtual void InitTable(unsigned int nrOfCols, int nrOfRows) = 0;
+  virtual void InitTable(unsigned int nrOfCols, unsigned long long nrOfRows) = 0;
 
   virtual void AddCharColumn(IStringColumn* stringColumn, int colNr) = 0;
 
@@ -100,10 +128,17 @@ public:
 
   virtual void AddIntegerColumn(IIntegerColumn* integerColumn, int colNr) = 0;
 
-  virtual void AddDoubleColumn(IDoubleColumn* doubleColumn, int colNr) = 0;
+  virtual void AddDoubleColumn(IDoubleColumn* doubleColumn, int colNr, FstColumnType colType) = 0;
+
+  virtual void AddInt64Column(IInt64Column* int64Column, int colNr) = 0;
 
   virtual void AddFactorColumn(IFactorColumn* factorColumn, int colNr) = 0;
 
+  /**
+    Restore the attributes of a column added to the table, encoded as in IFstTable::GetColumnAttributes.
+  */
+  virtual void SetColumnAttributes(int colNr, const char* attributeData, unsigned int size) = 0;
+
   virtual void SetColNames() = 0;
 
   virtual void SetKeyColumns(int* keyColPos, unsigned int nrOfKeys) = 0;
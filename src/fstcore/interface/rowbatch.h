@@ -0,0 +1,530 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef ROW_BATCH_H
+#define ROW_BATCH_H
+
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <ifsttable.h>
+#include <icolumnfactory.h>
+#include <iblockrunner.h>
+
+#include <fstdefines.h>
+#include <compression.h>
+#include <stringvectorcolumn.h>
+#include <vectorcolumn.h>
+
+
+// Copy the elements of the block writer of a character column or of factor levels
+inline void CopyStrings(IBlockWriter* blockWriter, StringVectorColumn &column)
+{
+  unsigned long long length = blockWriter->vecLength;
+  column.AllocateVec(length);
+
+  for (unsigned long long blockStart = 0; blockStart < length; blockStart += CHAR_MAX_BLOCK_SIZE)
+  {
+    unsigned long long blockEnd = std::min(blockStart + CHAR_MAX_BLOCK_SIZE, length);
+    blockWriter->SetBuffersFromVec(blockStart, blockEnd);
+
+    unsigned int pos = 0;
+
+    for (unsigned long long count = blockStart; count != blockEnd; ++count)
+    {
+      unsigned int elem = static_cast<unsigned int>(count - blockStart);
+      unsigned int newPos = blockWriter->strSizes[elem];
+
+      if ((blockWriter->naInts[elem / 32] >> (elem % 32)) & 1)
+      {
+        column.isNA[count] = 1;
+      }
+      else
+      {
+        column.strings[count].assign(&blockWriter->activeBuf[pos], newPos - pos);
+      }
+
+      pos = newPos;
+    }
+  }
+
+  delete blockWriter;
+}
+
+
+template<typename T>
+inline void PermuteVector(std::vector<T> &values, const std::vector<unsigned long long> &order)
+{
+  std::vector<T> sortedValues(order.size());
+
+  for (unsigned long long pos = 0; pos < order.size(); ++pos)
+  {
+    sortedValues[pos] = values[order[pos]];
+  }
+
+  values.swap(sortedValues);
+}
+
+
+// Values of the selected rows, with naValue for negative rows
+template<typename T>
+inline void GatherVector(std::vector<T> &values, const std::vector<long long> &rows, T naValue)
+{
+  std::vector<T> gatheredValues(rows.size());
+
+  for (unsigned long long pos = 0; pos < rows.size(); ++pos)
+  {
+    gatheredValues[pos] = rows[pos] < 0 ? naValue : values[rows[pos]];
+  }
+
+  values.swap(gatheredValues);
+}
+
+
+/**
+ Rows of a table with the column data in C++ vectors, for tables that fstcore reads and writes itself. The batch is
+ the column factory and the result table of reads through a FstHandle, and the table of the batches that are written
+ with a FstWriter. Only the vector of the value type of each column is used, factor columns have their levels in the
+ string column.
+ */
+class RowBatch : public IFstTable, public IFstTableReader, public IColumnFactory
+{
+public:
+  std::vector<FstColumnType> colTypes;
+  unsigned long long nrOfRows;
+
+  std::vector<std::vector<int>> ints;            // integer, logical and factor columns
+  std::vector<std::vector<double>> doubles;      // double, date and timestamp columns
+  std::vector<std::vector<long long>> longs;     // 64-bit integer columns
+  std::vector<StringVectorColumn> strings;  // character columns and factor levels
+
+  StringVectorColumn colNames;
+  std::vector<std::vector<char>> colAttributes;
+  std::vector<int> keyColPos;
+
+  RowBatch(const std::vector<FstColumnType> &colTypes) : nrOfRows(0)
+  {
+    SetColumnTypes(colTypes);
+  }
+
+  void SetColumnTypes(const std::vector<FstColumnType> &colTypes)
+  {
+    this->colTypes = colTypes;
+
+    ints.resize(colTypes.size());
+    doubles.resize(colTypes.size());
+    longs.resize(colTypes.size());
+    strings.resize(colTypes.size());
+    colAttributes.resize(colTypes.size());
+  }
+
+  // Copy the rows, column names and column attributes of a table
+  void Assign(IFstTable &table)
+  {
+    unsigned int nrOfCols = table.NrOfColumns();
+    nrOfRows = table.NrOfRows();
+
+    std::vector<FstColumnType> tableColTypes(nrOfCols);
+    for (unsigned int colNr = 0; colNr < nrOfCols; ++colNr) tableColTypes[colNr] = table.GetColumnType(colNr);
+
+    SetColumnTypes(tableColTypes);
+
+    for (unsigned int colNr = 0; colNr < nrOfCols; ++colNr)
+    {
+      switch (colTypes[colNr])
+      {
+        case FstColumnType::CHARACTER:
+          CopyStrings(table.GetCharWriter(colNr), strings[colNr]);
+          break;
+
+        case FstColumnType::FACTOR:
+        {
+          int* levelData = table.GetIntWriter(colNr);
+          ints[colNr].assign(levelData, levelData + nrOfRows);
+          CopyStrings(table.GetLevelWriter(colNr), strings[colNr]);
+          break;
+        }
+
+        case FstColumnType::INT_32:
+        {
+          int* intData = table.GetIntWriter(colNr);
+          ints[colNr].assign(intData, intData + nrOfRows);
+          break;
+        }
+
+        case FstColumnType::BOOL_32:
+        {
+          int* logicalData = table.GetLogicalWriter(colNr);
+          ints[colNr].assign(logicalData, logicalData + nrOfRows);
+          break;
+        }
+
+        case FstColumnType::INT_64:
+        {
+          long long* int64Data = table.GetInt64Writer(colNr);
+          longs[colNr].assign(int64Data, int64Data + nrOfRows);
+          break;
+        }
+
+        case FstColumnType::DOUBLE_64:
+        case FstColumnType::DATE_DAYS:
+        case FstColumnType::TIMESTAMP_SECONDS:
+        {
+          double* doubleData = table.GetDoubleWriter(colNr);
+          doubles[colNr].assign(doubleData, doubleData + nrOfRows);
+          break;
+        }
+
+        default:
+          throw(std::runtime_error("Unknown type found in column."));
+      }
+
+      table.GetColumnAttributes(colNr, colAttributes[colNr]);
+    }
+
+    CopyStrings(table.GetColNameWriter(), colNames);
+  }
+
+  // Reorder the rows, row pos of the result is row order[pos] of the batch. Each row is selected once.
+  void Permute(const std::vector<unsigned long long> &order, int nrOfThreads)
+  {
+    int nrOfCols = (int) colTypes.size();
+
+#pragma omp parallel for schedule(dynamic) num_threads(nrOfThreads)
+    for (int colNr = 0; colNr < nrOfCols; ++colNr)
+    {
+      switch (colTypes[colNr])
+      {
+        case FstColumnType::CHARACTER:
+        {
+          StringVectorColumn &column = strings[colNr];
+          StringVectorColumn sorted;
+          sorted.AllocateVec(order.size());
+
+          for (unsigned long long pos = 0; pos < order.size(); ++pos)
+          {
+            sorted.strings[pos].swap(column.strings[order[pos]]);
+            sorted.isNA[pos] = column.isNA[order[pos]];
+          }
+
+          column.strings.swap(sorted.strings);
+          column.isNA.swap(sorted.isNA);
+          break;
+        }
+
+        case FstColumnType::FACTOR:
+        case FstColumnType::INT_32:
+        case FstColumnType::BOOL_32:
+          PermuteVector(ints[colNr], order);
+          break;
+
+        case FstColumnType::INT_64:
+          PermuteVector(longs[colNr], order);
+          break;
+
+        default:  // double, date and timestamp
+          PermuteVector(doubles[colNr], order);
+          break;
+      }
+    }
+  }
+
+  // Reorder the rows with repeated and missing rows, row pos of the result is row rows[pos] of the batch or a row of
+  // NA values if rows[pos] is negative
+  void Gather(const std::vector<long long> &rows, int nrOfThreads)
+  {
+    int nrOfCols = (int) colTypes.size();
+
+#pragma omp parallel for schedule(dynamic) num_threads(nrOfThreads)
+    for (int colNr = 0; colNr < nrOfCols; ++colNr)
+    {
+      switch (colTypes[colNr])
+      {
+        case FstColumnType::CHARACTER:
+        {
+          StringVectorColumn &column = strings[colNr];
+          StringVectorColumn gathered;
+          gathered.AllocateVec(rows.size());
+
+          for (unsigned long long pos = 0; pos < rows.size(); ++pos)
+          {
+            if (rows[pos] < 0 || column.isNA[rows[pos]])
+            {
+              gathered.isNA[pos] = 1;
+              continue;
+            }
+
+            gathered.strings[pos] = column.strings[rows[pos]];
+          }
+
+          column.strings.swap(gathered.strings);
+          column.isNA.swap(gathered.isNA);
+          break;
+        }
+
+        case FstColumnType::FACTOR:
+        case FstColumnType::INT_32:
+        case FstColumnType::BOOL_32:
+          GatherVector(ints[colNr], rows, INT_MIN);
+          break;
+
+        case FstColumnType::INT_64:
+          GatherVector(longs[colNr], rows, LLONG_MIN);
+          break;
+
+        default:  // double, date and timestamp
+        {
+          unsigned long long naBits = REAL_NA_BITS;
+          double naValue;
+          std::memcpy(&naValue, &naBits, 8);
+
+          GatherVector(doubles[colNr], rows, naValue);
+          break;
+        }
+      }
+    }
+
+    nrOfRows = rows.size();
+  }
+
+  // Copy a single row of a batch with the same column types
+  void AssignRow(RowBatch &batch, unsigned long long pos)
+  {
+    nrOfRows = 1;
+
+    for (unsigned int colNr = 0; colNr < colTypes.size(); ++colNr)
+    {
+      switch (colTypes[colNr])
+      {
+        case FstColumnType::CHARACTER:
+          strings[colNr].AllocateVec(1);
+          strings[colNr].strings[0] = batch.strings[colNr].strings[pos];
+          strings[colNr].isNA[0] = batch.strings[colNr].isNA[pos];
+          break;
+
+        case FstColumnType::FACTOR:
+          ints[colNr].assign(1, batch.ints[colNr][pos]);
+          strings[colNr].strings = batch.strings[colNr].strings;
+          strings[colNr].isNA = batch.strings[colNr].isNA;
+          break;
+
+        case FstColumnType::INT_32:
+        case FstColumnType::BOOL_32:
+          ints[colNr].assign(1, batch.ints[colNr][pos]);
+          break;
+
+        case FstColumnType::INT_64:
+          longs[colNr].assign(1, batch.longs[colNr][pos]);
+          break;
+
+        default:  // double, date and timestamp
+          doubles[colNr].assign(1, batch.doubles[colNr][pos]);
+          break;
+      }
+    }
+  }
+
+  // Move a column of a batch with the same number of rows to column colNr
+  void MoveColumn(int colNr, RowBatch &batch, int batchColNr)
+  {
+    ints[colNr].swap(batch.ints[batchColNr]);
+    doubles[colNr].swap(batch.doubles[batchColNr]);
+    longs[colNr].swap(batch.longs[batchColNr]);
+    strings[colNr].strings.swap(batch.strings[batchColNr].strings);
+    strings[colNr].isNA.swap(batch.strings[batchColNr].isNA);
+  }
+
+  // IColumnFactory
+  IFactorColumn* CreateFactorColumn(unsigned long long nrOfRows) { return new FactorVectorColumn(nrOfRows); }
+  ILogicalColumn* CreateLogicalColumn(unsigned long long nrOfRows) { return new LogicalVectorColumn(nrOfRows); }
+  IDoubleColumn* CreateDoubleColumn(unsigned long long nrOfRows) { return new DoubleVectorColumn(nrOfRows); }
+  IIntegerColumn* CreateIntegerColumn(unsigned long long nrOfRows) { return new IntVectorColumn(nrOfRows); }
+  IInt64Column* CreateInt64Column(unsigned long long nrOfRows) { return new Int64VectorColumn(nrOfRows); }
+  IStringColumn* CreateStringColumn(unsigned long long nrOfRows) { return new StringVectorColumn(); }
+  IStringArray* CreateStringArray() { return nullptr; }  // not used for reading column data
+
+  // IFstTableReader, the column vectors are moved to the batch
+  void InitTable(unsigned int nrOfCols, unsigned long long nrOfRows) { this->nrOfRows = nrOfRows; }
+
+  void AddCharColumn(IStringColumn* stringColumn, int colNr)
+  {
+    StringVectorColumn* column = static_cast<StringVectorColumn*>(stringColumn);
+    strings[colNr].strings.swap(column->strings);
+    strings[colNr].isNA.swap(column->isNA);
+  }
+
+  void AddLogicalColumn(ILogicalColumn* logicalColumn, int colNr)
+  {
+    ints[colNr].swap(static_cast<LogicalVectorColumn*>(logicalColumn)->data);
+  }
+
+  void AddIntegerColumn(IIntegerColumn* integerColumn, int colNr)
+  {
+    ints[colNr].swap(static_cast<IntVectorColumn*>(integerColumn)->data);
+  }
+
+  void AddDoubleColumn(IDoubleColumn* doubleColumn, int colNr, FstColumnType colType)
+  {
+    doubles[colNr].swap(static_cast<DoubleVectorColumn*>(doubleColumn)->data);
+  }
+
+  void AddInt64Column(IInt64Column* int64Column, int colNr)
+  {
+    longs[colNr].swap(static_cast<Int64VectorColumn*>(int64Column)->data);
+  }
+
+  void AddFactorColumn(IFactorColumn* factorColumn, int colNr)
+  {
+    FactorVectorColumn* column = static_cast<FactorVectorColumn*>(factorColumn);
+    ints[colNr].swap(column->data);
+    strings[colNr].strings.swap(column->levels.strings);
+    strings[colNr].isNA.swap(column->levels.isNA);
+  }
+
+  void SetColumnAttributes(int colNr, const char* attributeData, unsigned int size) {}  // taken from the first batch
+  void SetColNames() {}
+  void SetKeyColumns(int* keyColPos, unsigned int nrOfKeys) {}
+
+  // IFstTable
+  FstColumnType GetColumnType(unsigned int colNr) { return colTypes[colNr]; }
+  IBlockWriter* GetCharWriter(unsigned int colNr) { return new StringVectorWriter(strings[colNr]); }
+  int* GetLogicalWriter(unsigned int colNr) { return ints[colNr].data(); }
+  int* GetIntWriter(unsigned int colNr) { return ints[colNr].data(); }
+  double* GetDoubleWriter(unsigned int colNr) { return doubles[colNr].data(); }
+  long long* GetInt64Writer(unsigned int colNr) { return longs[colNr].data(); }
+  IBlockWriter* GetLevelWriter(unsigned int colNr) { return new StringVectorWriter(strings[colNr]); }
+  void GetColumnAttributes(unsigned int colNr, std::vector<char> &attributeData) { attributeData = colAttributes[colNr]; }
+  IBlockWriter* GetColNameWriter() { return new StringVectorWriter(colNames); }
+
+  void GetKeyColumns(int* keyColPos)
+  {
+    std::copy(this->keyColPos.begin(), this->keyColPos.end(), keyColPos);
+  }
+
+  unsigned int NrOfKeys() { return (unsigned int) keyColPos.size(); }
+  unsigned int NrOfColumns() { return (unsigned int) colTypes.size(); }
+  unsigned long long NrOfRows() { return nrOfRows; }
+};
+
+
+// Unsigned keys with the sort order (as used for key columns) of the values of numerical columns, NA values first
+
+inline unsigned long long IntKey(int value)
+{
+  return (unsigned int) value ^ 0x80000000u;  // NA (INT_MIN) is 0
+}
+
+
+inline unsigned long long Int64Key(long long value)
+{
+  return (unsigned long long) value ^ 0x8000000000000000ULL;  // NA (LLONG_MIN) is 0
+}
+
+
+inline unsigned long long DoubleKey(double value)
+{
+  unsigned long long bits;
+  std::memcpy(&bits, &value, 8);
+
+  // NA (a NaN with a low word of 1954) is sorted before NaN
+  if (value != value) return (bits & 0xFFFFFFFFULL) == 1954 ? 0 : 1;
+
+  if (value == 0) return 0x8000000000000000ULL;  // -0.0 equals 0.0
+
+  // Negative values are sorted in reverse order of their bit pattern
+  return (bits >> 63) != 0 ? ~bits : bits | 0x8000000000000000ULL;
+}
+
+
+inline unsigned long long NumericKey(RowBatch &batch, int colNr, unsigned long long pos)
+{
+  switch (batch.colTypes[colNr])
+  {
+    case FstColumnType::INT_32:
+    case FstColumnType::BOOL_32:
+      return IntKey(batch.ints[colNr][pos]);
+
+    case FstColumnType::INT_64:
+      return Int64Key(batch.longs[colNr][pos]);
+
+    default:  // double, date and timestamp
+      return DoubleKey(batch.doubles[colNr][pos]);
+  }
+}
+
+
+// Compare rows on the selected key columns of their batches, returns a negative number if the row of batchA sorts
+// before the row of batchB, a positive number if it sorts after it and zero for equal keys
+inline int CompareRows(RowBatch &batchA, unsigned long long posA, RowBatch &batchB, unsigned long long posB,
+  const std::vector<int> &keyColPos)
+{
+  for (std::vector<int>::const_iterator it = keyColPos.begin(); it != keyColPos.end(); ++it)
+  {
+    int colNr = *it;
+
+    if (batchA.colTypes[colNr] == FstColumnType::CHARACTER)
+    {
+      StringVectorColumn &columnA = batchA.strings[colNr];
+      StringVectorColumn &columnB = batchB.strings[colNr];
+
+      if (columnA.isNA[posA] || columnB.isNA[posB])
+      {
+        if (columnA.isNA[posA] != columnB.isNA[posB]) return columnA.isNA[posA] ? -1 : 1;
+        continue;
+      }
+
+      int order = columnA.strings[posA].compare(columnB.strings[posB]);  // byte order
+
+      if (order != 0) return order;
+      continue;
+    }
+
+    unsigned long long keyA = NumericKey(batchA, colNr, posA);
+    unsigned long long keyB = NumericKey(batchB, colNr, posB);
+
+    if (keyA != keyB) return keyA < keyB ? -1 : 1;
+  }
+
+  return 0;
+}
+
+
+#endif  // ROW_BATCH_H
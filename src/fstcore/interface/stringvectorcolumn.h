@@ -0,0 +1,151 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef STRING_VECTOR_COLUMN_H
+#define STRING_VECTOR_COLUMN_H
+
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <ifstcolumn.h>
+#include <iblockrunner.h>
+#include <fstdefines.h>
+#include <bitmapruns.h>
+
+
+/**
+ Character column that stores its elements in C++ strings. Used by fstcore itself for the (small) parts of
+ character columns and factor levels that are inspected while reading, such as compared and key columns.
+ */
+class StringVectorColumn : public IStringColumn
+{
+public:
+  std::vector<std::string> strings;
+  std::vector<char> isNA;
+
+  void AllocateVec(unsigned long long vecLength)
+  {
+    strings.assign(vecLength, std::string());
+    isNA.assign(vecLength, 0);
+  }
+
+  void BufferToVec(unsigned int nrOfElements, unsigned int startElem, unsigned int endElem,
+    unsigned long long vecOffset, unsigned int* sizeMeta, char* buf)
+  {
+    unsigned int* bitsNA = &sizeMeta[nrOfElements];
+    unsigned int pos = startElem == 0 ? 0 : sizeMeta[startElem - 1];
+
+    BitmapRuns(bitsNA, startElem, endElem + 1, [&](unsigned int runStart, unsigned int runEnd, bool runNA)
+    {
+      if (runNA)
+      {
+        std::fill(&isNA[vecOffset + runStart - startElem], &isNA[vecOffset + runEnd - startElem], 1);
+        pos = sizeMeta[runEnd - 1];
+        return;
+      }
+
+      for (unsigned int elem = runStart; elem != runEnd; ++elem)
+      {
+        unsigned int newPos = sizeMeta[elem];
+        strings[vecOffset + elem - startElem].assign(&buf[pos], newPos - pos);
+        pos = newPos;
+      }
+    });
+  }
+
+  const char* GetElement(int elementNr) { return strings[elementNr].c_str(); }
+};
+
+
+/**
+ Block writer of the elements of a StringVectorColumn, used to serialize character columns and factor levels that
+ were decompressed by fstcore itself.
+ */
+class StringVectorWriter : public IBlockWriter
+{
+  StringVectorColumn &column;
+  std::vector<unsigned int> sizeBuf;
+  std::vector<unsigned int> naBuf;
+  std::vector<char> charBuf;
+
+public:
+  StringVectorWriter(StringVectorColumn &column) : column(column), sizeBuf(CHAR_MAX_BLOCK_SIZE),
+    naBuf(1 + CHAR_MAX_BLOCK_SIZE / 32), charBuf(1)
+  {
+    strSizes = sizeBuf.data();
+    naInts = naBuf.data();
+    bufSize = 0;
+    activeBuf = charBuf.data();
+    vecLength = column.strings.size();
+  }
+
+  void SetBuffersFromVec(unsigned long long startCount, unsigned long long endCount)
+  {
+    unsigned int nrOfElements = static_cast<unsigned int>(endCount - startCount);
+    unsigned int nrOfNAInts = 1 + nrOfElements / 32;  // last bit is NA flag
+    unsigned int hasNA = 0;
+
+    charBuf.resize(1);  // keeps the buffer non-empty
+    std::fill(naBuf.begin(), naBuf.begin() + nrOfNAInts, 0);
+
+    for (unsigned long long count = startCount; count != endCount; ++count)
+    {
+      unsigned int elem = static_cast<unsigned int>(count - startCount);
+
+      if (column.isNA[count])
+      {
+        ++hasNA;
+        naInts[elem / 32] |= 1u << (elem % 32);
+      }
+      else
+      {
+        charBuf.insert(charBuf.end(), column.strings[count].begin(), column.strings[count].end());
+      }
+
+      strSizes[elem] = static_cast<unsigned int>(charBuf.size() - 1);
+    }
+
+    if (hasNA != 0) naInts[nrOfNAInts - 1] |= 1u << (nrOfElements % 32);
+
+    activeBuf = charBuf.data() + 1;
+    bufSize = static_cast<unsigned int>(charBuf.size() - 1);
+  }
+};
+
+
+#endif  // STRING_VECTOR_COLUMN_H
@@ -0,0 +1,99 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#ifndef VECTOR_COLUMN_H
+#define VECTOR_COLUMN_H
+
+
+#include <vector>
+
+#include <ifstcolumn.h>
+#include <stringvectorcolumn.h>
+
+
+/**
+ Column vectors that store their elements in C++ vectors. fstcore creates these for reads of which it processes the
+ result itself, such as copied column data and index entries. The data is moved to the result table when the
+ column is added.
+ */
+class IntVectorColumn : public IIntegerColumn
+{
+public:
+  std::vector<int> data;
+  IntVectorColumn(unsigned long long nrOfRows) : data(nrOfRows) {}
+  int* Data() { return data.data(); }
+};
+
+
+class LogicalVectorColumn : public ILogicalColumn
+{
+public:
+  std::vector<int> data;
+  LogicalVectorColumn(unsigned long long nrOfRows) : data(nrOfRows) {}
+  int* Data() { return data.data(); }
+};
+
+
+class DoubleVectorColumn : public IDoubleColumn
+{
+public:
+  std::vector<double> data;
+  DoubleVectorColumn(unsigned long long nrOfRows) : data(nrOfRows) {}
+  double* Data() { return data.data(); }
+};
+
+
+class Int64VectorColumn : public IInt64Column
+{
+public:
+  std::vector<long long> data;
+  Int64VectorColumn(unsigned long long nrOfRows) : data(nrOfRows) {}
+  long long* Data() { return data.data(); }
+};
+
+
+class FactorVectorColumn : public IFactorColumn
+{
+public:
+  std::vector<int> data;
+  StringVectorColumn levels;
+  FactorVectorColumn(unsigned long long nrOfRows) : data(nrOfRows) {}
+  int* LevelData() { return data.data(); }
+  IStringColumn* Levels() { return &levels; }
+};
+
+
+#endif  // VECTOR_COLUMN_H
@@ -40,39 +40,42 @@
 #include <compression.h>
 #include <compressor.h>
 
-#define BLOCKSIZE_LOGICAL 4096  // number of logicals in default compression block
-
-
 using namespace std;
 
 
 // Logical vectors are always compressed to fill all available bits (factor 16 compression).
-// On top of that, we can compress the resulting bytes with a custom compressor.
-void fdsWriteLogicalVec_v10(ofstream &myfile, int* boolVector, unsigned nrOfLogicals, int compression)
+// On top of that, we can compress the resulting bytes with a custom compressor. Blocks of (mostly) constant
+// values are run-length encoded instead.
+void fdsWriteLogicalVec_v10(ostream &myfile, int* boolVector, unsigned long long nrOfLogicals, int compression,
+  int nrOfThreads, unsigned int blockSizeElems, ZoneMap* zoneMap)
 {
   if (compression == 0)
   {
     FixedRatioCompressor* compressor = new FixedRatioCompressor(CompAlgo::LOGIC64);  // compression level not relevant here
-    fdsStreamUncompressed_v2(myfile, (char*) boolVector, nrOfLogicals, 4, BLOCKSIZE_LOGICAL, compressor);
+    fdsStreamUncompressed_v2(myfile, (char*) boolVector, nrOfLogicals, 4, blockSizeElems, compressor, zoneMap);
 
     delete compressor;
 
     return;
   }
 
-  int blockSize = 4 * BLOCKSIZE_LOGICAL;  // block size in bytes
+  int blockSize = 4 * blockSizeElems;  // block size in bytes
 
   if (compression <= 50)  // compress 1 - 50
   {
     Compressor* defaultCompress = new SingleCompressor(CompAlgo::LOGIC64, 0);  // compression not relevant here
     Compressor* compress2 = new SingleCompressor(CompAlgo::LZ4_LOGIC64, 100);  // use maximum compression for LZ4 algorithm
-    StreamCompressor* streamCompressor = new StreamCompositeCompressor(defaultCompress, compress2, 2 * compression);
+    Compressor* rleCompress1 = new RleCompressor(defaultCompress);
+    Compressor* rleCompress2 = new RleCompressor(compress2);
+    StreamCompressor* streamCompressor = new StreamCompositeCompressor(rleCompress1, rleCompress2, 2 * compression);
     streamCompressor->CompressBufferSize(blockSize);
 
-    fdsStreamcompressed_v2(myfile, (char*) boolVector, nrOfLogicals, 4, streamCompressor, BLOCKSIZE_LOGICAL);
+    fdsStreamcompressed_v2(myfile, (char*) boolVector, nrOfLogicals, 4, streamCompressor, blockSizeElems, nrOfThreads, zoneMap);
 
     delete defaultCompress;
     delete compress2;
+    delete rleCompress1;
+    delete rleCompress2;
     delete streamCompressor;
 
     return;
@@ -81,12 +84,16 @@ void fdsWriteLogicalVec_v10(ofstream &myfile, int* boolVector, unsigned nrOfLogi
   {
     Compressor* compress1 = new SingleCompressor(CompAlgo::LZ4_LOGIC64, 100);
     Compressor* compress2 = new SingleCompressor(CompAlgo::ZSTD_LOGIC64, 30 + 7 * (compression - 50) / 5);
-    StreamCompressor* streamCompressor = new StreamCompositeCompressor(compress1, compress2, 2 * (compression - 50));
+    Compressor* rleCompress1 = new RleCompressor(compress1);
+    Compressor* rleCompress2 = new RleCompressor(compress2);
+    StreamCompressor* streamCompressor = new StreamCompositeCompressor(rleCompress1, rleCompress2, 2 * (compression - 50));
     streamCompressor->CompressBufferSize(blockSize);
-    fdsStreamcompressed_v2(myfile, (char*) boolVector, nrOfLogicals, 4, streamCompressor, BLOCKSIZE_LOGICAL);
+    fdsStreamcompressed_v2(myfile, (char*) boolVector, nrOfLogicals, 4, streamCompressor, blockSizeElems, nrOfThreads, zoneMap);
 
     delete compress1;
     delete compress2;
+    delete rleCompress1;
+    delete rleCompress2;
     delete streamCompressor;
   }
 
@@ -94,8 +101,15 @@ void fdsWriteLogicalVec_v10(ofstream &myfile, int* boolVector, unsigned nrOfLogi
 }
 
 
-void fdsReadLogicalVec_v10(istream &myfile, int* boolVector, unsigned long long blockPos, unsigned int startRow,
-  unsigned int length, unsigned int size)
+void fdsReadLogicalVec_v10(istream &myfile, int* boolVector, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, unsigned long long size, int nrOfThreads)
+{
+  return fdsReadColumn_v2(myfile, (char*) boolVector, blockPos, startRow, length, size, 4, nrOfThreads);
+}
+
+
+bool fdsReadLogicalRuns_v10(istream &myfile, vector<int> &runValues, vector<unsigned long long> &runEnds,
+  unsigned long long blockPos, unsigned long long startRow, unsigned long long length)
 {
-  return fdsReadColumn_v2(myfile, (char*) boolVector, blockPos, startRow, length, size, 4);
+  return fdsReadColumnRuns_v2(myfile, runValues, runEnds, blockPos, startRow, length);
 }
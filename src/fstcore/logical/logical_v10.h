@@ -39,14 +39,27 @@
 
 #include <istream>
 #include <ostream>
+#include <vector>
+
+#include <zonemap.h>
+
+
+#define BLOCKSIZE_LOGICAL 4096  // number of logicals in default compression block
 
 
 // Logical vectors are always compressed to fill all available bits (factor 16 compression).
-// On top of that, we can compress the resulting bytes with a custom compressor.
-void fdsWriteLogicalVec_v10(std::ofstream &myfile, int* boolVector, unsigned nrOfLogicals, int compression);
+// On top of that, we can compress the resulting bytes with a custom compressor. Blocks of blockSizeElems
+// logicals are compressed. If zoneMap is specified, it receives the statistics of each block.
+void fdsWriteLogicalVec_v10(std::ostream &myfile, int* boolVector, unsigned long long nrOfLogicals, int compression,
+  int nrOfThreads, unsigned int blockSizeElems, ZoneMap* zoneMap = nullptr);
+
 
+void fdsReadLogicalVec_v10(std::istream &myfile, int* boolVector, unsigned long long blockPos, unsigned long long startRow,
+  unsigned long long length, unsigned long long size, int nrOfThreads);
 
-void fdsReadLogicalVec_v10(std::istream &myfile, int* boolVector, unsigned long long blockPos, unsigned int startRow,
-  unsigned int length, unsigned int size);
+// Read rows startRow until startRow + length as runs of equal values (see fdsReadColumnRuns_v2). Returns false if
+// the range is not run-length encoded.
+bool fdsReadLogicalRuns_v10(std::istream &myfile, std::vector<int> &runValues, std::vector<unsigned long long> &runEnds,
+  unsigned long long blockPos, unsigned long long startRow, unsigned long long length);
 
 #endif // LOGICAL_v10_H
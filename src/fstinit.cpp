@@ -37,6 +37,8 @@
 
 #include "openmp.h"
 #include "FastStore.h"
+#include "lazystrings.h"
+#include "lazycolumns.h"
 
 /* FIXME:
  Check these declarations against the C/Fortran source code.
@@ -47,22 +49,106 @@
 // extern SEXP fst_BytesConvert(SEXP);
 // extern SEXP fst_compChar(SEXP, SEXP);
 // extern SEXP fst_FirstIntEqualHigher(SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstUpgrade(SEXP, SEXP, SEXP, SEXP);
 // extern SEXP fst_fstMeta(SEXP);
-// extern SEXP fst_fstRetrieve(SEXP, SEXP, SEXP, SEXP);
-// extern SEXP fst_fstStore(SEXP, SEXP, SEXP);
+// extern SEXP fst_fstColumnStatistics(SEXP);
+// extern SEXP fst_fstColumnStorage(SEXP);
+// extern SEXP fst_fstRetrieve(SEXP, SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstRetrieveRaw(SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstIterOpen(SEXP, SEXP);
+// extern SEXP fst_fstIterNext(SEXP, SEXP);
+// extern SEXP fst_fstIterClose(SEXP);
+// extern SEXP fst_fstHandleOpen(SEXP, SEXP, SEXP);
+// extern SEXP fst_fstHandleOpenRemote(SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstDatasetRead(SEXP, SEXP);
+// extern SEXP fst_fstCopy(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstIndex(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstJoin(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstHandleRead(SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstHandleReadInto(SEXP, SEXP, SEXP);
+// extern SEXP fst_fstHandleReadLazy(SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstRetrieveRows(SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstHandleReadRows(SEXP, SEXP, SEXP);
+// extern SEXP fst_fstHandleSample(SEXP, SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstHandleFilter(SEXP, SEXP);
+// extern SEXP fst_fstHandleKeyLookup(SEXP, SEXP);
+// extern SEXP fst_fstHandleKeyLookupBatch(SEXP, SEXP);
+// extern SEXP fst_fstHandleAggregate(SEXP, SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstHandleDistinct(SEXP, SEXP, SEXP);
+// extern SEXP fst_fstHandleVerify(SEXP, SEXP);
+// extern SEXP fst_fstHandleClose(SEXP);
+// extern SEXP fst_fstBlockCache(SEXP, SEXP);
+// extern SEXP fst_fstSharedBlockCache(SEXP);
+// extern SEXP fst_fstProfile(SEXP);
+// extern SEXP fst_fstDirectIO(SEXP);
+// extern SEXP fst_fstHugePages(SEXP);
+// extern SEXP fst_fstReadPrefix(SEXP);
+// extern SEXP fst_fstStore(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstStoreRaw(SEXP, SEXP);
+// extern SEXP fst_fstAppend(SEXP, SEXP, SEXP);
+// extern SEXP fst_fstCbind(SEXP, SEXP, SEXP);
+// extern SEXP fst_fstReplaceColumn(SEXP, SEXP, SEXP, SEXP);
+// extern SEXP fst_fstDeleteColumn(SEXP, SEXP);
+// extern SEXP fst_fstWriterOpen(SEXP, SEXP, SEXP);
+// extern SEXP fst_fstWriterAppend(SEXP, SEXP);
+// extern SEXP fst_fstWriterClose(SEXP);
 // extern SEXP fst_getDTthreads();
+// extern SEXP fst_setDTthreads(SEXP);
 // extern SEXP fst_hasOpenMP();
+// extern SEXP fst_setLazyStrings(SEXP);
 // extern SEXP fst_IsSortedTable(SEXP, SEXP);
 // extern SEXP fst_LastIntEqualLower(SEXP, SEXP, SEXP, SEXP);
 // extern SEXP fst_LowerBoundIndex(SEXP, SEXP, SEXP, SEXP);
 // extern SEXP fst_SType(SEXP);
 
 static const R_CallMethodDef CallEntries[] = {
+  {"fst_fstUpgrade",          (DL_FUNC) &fstUpgrade,          4},
   {"fst_fstMeta",             (DL_FUNC) &fstMeta,             1},
-  {"fst_fstRetrieve",         (DL_FUNC) &fstRetrieve,         4},
-  {"fst_fstStore",            (DL_FUNC) &fstStore,            3},
-  {"fst_getDTthreads",        (DL_FUNC) &getDTthreads,        0},
+  {"fst_fstColumnStatistics", (DL_FUNC) &fstColumnStatistics, 1},
+  {"fst_fstColumnStorage",    (DL_FUNC) &fstColumnStorage,    1},
+  {"fst_fstRetrieve",         (DL_FUNC) &fstRetrieve,         5},
+  {"fst_fstRetrieveRaw",      (DL_FUNC) &fstRetrieveRaw,      4},
+  {"fst_fstIterOpen",         (DL_FUNC) &fstIterOpen,         2},
+  {"fst_fstIterNext",         (DL_FUNC) &fstIterNext,         2},
+  {"fst_fstIterClose",        (DL_FUNC) &fstIterClose,        1},
+  {"fst_fstHandleOpen",       (DL_FUNC) &fstHandleOpen,       3},
+  {"fst_fstHandleOpenRemote", (DL_FUNC) &fstHandleOpenRemote, 4},
+  {"fst_fstDatasetRead",      (DL_FUNC) &fstDatasetRead,      2},
+  {"fst_fstCopy",             (DL_FUNC) &fstCopy,             6},
+  {"fst_fstIndex",            (DL_FUNC) &fstIndex,            6},
+  {"fst_fstJoin",             (DL_FUNC) &fstJoin,            10},
+  {"fst_fstHandleRead",       (DL_FUNC) &fstHandleRead,       4},
+  {"fst_fstHandleReadInto",   (DL_FUNC) &fstHandleReadInto,   3},
+  {"fst_fstHandleReadLazy",   (DL_FUNC) &fstHandleReadLazy,   4},
+  {"fst_fstRetrieveRows",     (DL_FUNC) &fstRetrieveRows,     4},
+  {"fst_fstHandleReadRows",   (DL_FUNC) &fstHandleReadRows,   3},
+  {"fst_fstHandleSample",     (DL_FUNC) &fstHandleSample,     5},
+  {"fst_fstHandleFilter",     (DL_FUNC) &fstHandleFilter,     2},
+  {"fst_fstHandleKeyLookup",  (DL_FUNC) &fstHandleKeyLookup,  2},
+  {"fst_fstHandleKeyLookupBatch", (DL_FUNC) &fstHandleKeyLookupBatch, 2},
+  {"fst_fstHandleAggregate",  (DL_FUNC) &fstHandleAggregate,  5},
+  {"fst_fstHandleDistinct",   (DL_FUNC) &fstHandleDistinct,   3},
+  {"fst_fstHandleVerify",     (DL_FUNC) &fstHandleVerify,     2},
+  {"fst_fstHandleClose",      (DL_FUNC) &fstHandleClose,      1},
+  {"fst_fstBlockCache",       (DL_FUNC) &fstBlockCache,       2},
+  {"fst_fstSharedBlockCache", (DL_FUNC) &fstSharedBlockCache, 1},
+  {"fst_fstProfile",          (DL_FUNC) &fstProfile,          1},
+  {"fst_fstDirectIO",         (DL_FUNC) &fstDirectIO,         1},
+  {"fst_fstHugePages",        (DL_FUNC) &fstHugePages,        1},
+  {"fst_fstReadPrefix",       (DL_FUNC) &fstReadPrefix,       1},
+  {"fst_fstStore",            (DL_FUNC) &fstStore,            11},
+  {"fst_fstStoreRaw",         (DL_FUNC) &fstStoreRaw,         2},
+  {"fst_fstAppend",           (DL_FUNC) &fstAppend,           3},
+  {"fst_fstCbind",            (DL_FUNC) &fstCbind,            3},
+  {"fst_fstReplaceColumn",    (DL_FUNC) &fstReplaceColumn,    4},
+  {"fst_fstDeleteColumn",     (DL_FUNC) &fstDeleteColumn,     2},
+  {"fst_fstWriterOpen",       (DL_FUNC) &fstWriterOpen,       3},
+  {"fst_fstWriterAppend",     (DL_FUNC) &fstWriterAppend,     2},
+  {"fst_fstWriterClose",      (DL_FUNC) &fstWriterClose,      1},
+  {"fst_getDTthreads",        (DL_FUNC) &getDTthreads_R,      0},
+  {"fst_setDTthreads",        (DL_FUNC) &setDTthreads,        1},
   {"fst_hasOpenMP",           (DL_FUNC) &hasOpenMP,           0},
+  {"fst_setLazyStrings",      (DL_FUNC) &setLazyStrings,      1},
   {NULL, NULL, 0}
 };
 
@@ -71,6 +157,9 @@ void R_init_fst(DllInfo *dll)
   R_registerRoutines(dll, NULL, CallEntries, NULL, NULL);
   R_useDynamicSymbols(dll, FALSE);
 
+  RegisterLazyStrings(dll);
+  RegisterLazyColumns(dll);
+
   // TODO (from data.table repository):
   // create strings in advance for speed, same techique as R_*Symbol
   // char_integer64 = PRINTNAME(install("integer64"));
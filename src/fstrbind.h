@@ -39,7 +39,4 @@
 #include <Rcpp.h>
 
 
-// SEXP fstrbind(Rcpp::String fileName, SEXP table, SEXP compression, Rcpp::Function serializer);
-
-
 #endif  // FSTRBIND_H
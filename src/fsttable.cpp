@@ -38,10 +38,12 @@
 #include "ifsttable.h"
 #include "iblockrunner.h"
 #include "fstdefines.h"
+#include "columnnameindex.h"
 
 #include "blockrunner_char.h"
 #include "fsttable.h"
 #include "fstcolumn.h"
+#include "attributes.h"
 
 #include <Rcpp.h>
 
@@ -66,7 +68,7 @@ unsigned int FstTable::NrOfColumns()
 }
 
 
-unsigned int FstTable::NrOfRows()
+unsigned long long FstTable::NrOfRows()
 {
   if (nrOfCols == 0)  // table has zero columns
   {
@@ -76,7 +78,7 @@ unsigned int FstTable::NrOfRows()
   }
 
   SEXP colVec = VECTOR_ELT(*rTable, 0);  // retrieve column vector
-  return Rf_length(colVec);
+  return Rf_xlength(colVec);
 }
 
 
@@ -98,6 +100,21 @@ FstColumnType FstTable::GetColumnType(unsigned int colNr)
       return FstColumnType::INT_32;
 
     case REALSXP:
+      if (Rf_inherits(colVec, "integer64"))
+      {
+        return FstColumnType::INT_64;
+      }
+
+      if (Rf_inherits(colVec, "Date"))
+      {
+        return FstColumnType::DATE_DAYS;
+      }
+
+      if (Rf_inherits(colVec, "POSIXct"))
+      {
+        return FstColumnType::TIMESTAMP_SECONDS;
+      }
+
       return FstColumnType::DOUBLE_64;
 
     case LGLSXP:
@@ -130,12 +147,19 @@ double* FstTable::GetDoubleWriter(unsigned int colNr)
 }
 
 
+long long* FstTable::GetInt64Writer(unsigned int colNr)
+{
+  cols = VECTOR_ELT(*rTable, colNr);  // retrieve column vector
+  return (long long*) REAL(cols);  // integer64 vectors are double vectors with a class attribute
+}
+
+
 IBlockWriter* FstTable::GetCharWriter(unsigned int colNr)
 {
   cols = VECTOR_ELT(*rTable, colNr);  // retrieve column vector
 
   // Assuming that nrOfRows is already set
-  unsigned int nrOfVectorRows = LENGTH(cols);
+  unsigned long long nrOfVectorRows = XLENGTH(cols);
 
   return new BlockWriterChar(cols, nrOfVectorRows, strSizes, naInts, buf, MAX_CHAR_STACK_SIZE);
 }
@@ -144,36 +168,25 @@ IBlockWriter* FstTable::GetCharWriter(unsigned int colNr)
 IBlockWriter* FstTable::GetLevelWriter(unsigned int colNr)
 {
   cols = VECTOR_ELT(*rTable, colNr);  // retrieve column vector
-  cols = Rf_getAttrib(cols, Rf_mkString("levels"));
+  cols = Rf_getAttrib(cols, R_LevelsSymbol);  // no allocations, can be called from a worker thread
   unsigned int nrOfFactorLevels = LENGTH(cols);
   return new BlockWriterChar(cols, nrOfFactorLevels, strSizes, naInts, buf, MAX_CHAR_STACK_SIZE);
 }
 
 
-IBlockWriter* FstTable::GetColNameWriter()
+void FstTable::GetColumnAttributes(unsigned int colNr, std::vector<char> &attributeData)
 {
-  cols = Rf_getAttrib(*rTable, R_NamesSymbol);
-
-  // Assuming that nrOfCols is already set
-  return new BlockWriterChar(cols, nrOfCols, strSizes, naInts, buf, MAX_CHAR_STACK_SIZE);
+  SEXP colVec = VECTOR_ELT(*rTable, colNr);  // retrieve column vector
+  EncodeColumnAttributes(colVec, GetColumnType(colNr), attributeData);
 }
 
 
-inline unsigned int FindKey(StringVector colNameList, String item)
+IBlockWriter* FstTable::GetColNameWriter()
 {
-  int index = -1;
-  int found = 0;
-  for (Rcpp::StringVector::iterator it = colNameList.begin(); it != colNameList.end(); ++it)
-  {
-    if (*it == item)
-    {
-      index = found;
-      break;
-    }
-    ++found;
-  }
+  cols = Rf_getAttrib(*rTable, R_NamesSymbol);
 
-  return index;
+  // Assuming that nrOfCols is already set
+  return new BlockWriterChar(cols, nrOfCols, strSizes, naInts, buf, MAX_CHAR_STACK_SIZE);
 }
 
 
@@ -194,19 +207,27 @@ void FstTable::GetKeyColumns(int* keyColPos)
   int keyLength = LENGTH(keyNames);
 
   // Find key column index numbers, if any
-  StringVector keyList(keyNames);
   SEXP colNames = Rf_getAttrib(*rTable, R_NamesSymbol);
+  int nrOfNames = LENGTH(colNames);
+
+  ColumnNameIndex colNameIndex;
+  colNameIndex.Reserve(nrOfNames);
+
+  for (int colNr = 0; colNr < nrOfNames; ++colNr)
+  {
+    colNameIndex.Add(CHAR(STRING_ELT(colNames, colNr)), colNr);
+  }
 
   for (int colSel = 0; colSel < keyLength; ++colSel)
   {
-    keyColPos[colSel] = FindKey(colNames, keyList[colSel]);
+    keyColPos[colSel] = colNameIndex.Find(CHAR(STRING_ELT(keyNames, colSel)));
   }
 }
 
 
 //  FstTableReader implementation
 
-void FstTableReader::InitTable(unsigned int nrOfCols, int nrOfRows)
+void FstTableReader::InitTable(unsigned int nrOfCols, unsigned long long nrOfRows)
 {
   this->nrOfCols = nrOfCols;
   this->nrOfRows = nrOfRows;
@@ -231,13 +252,35 @@ void FstTableReader::AddLogicalColumn(ILogicalColumn* logicalColumn, int colNr)
 }
 
 
-void FstTableReader::AddDoubleColumn(IDoubleColumn* doubleColumn, int colNr)
+void FstTableReader::AddDoubleColumn(IDoubleColumn* doubleColumn, int colNr, FstColumnType colType)
 {
   DoubleColumn* dColumn = (DoubleColumn*) doubleColumn;
+
+  if (colType == FstColumnType::DATE_DAYS)
+  {
+    Rf_setAttrib(dColumn->colVec, R_ClassSymbol, Rf_mkString("Date"));
+  }
+  else if (colType == FstColumnType::TIMESTAMP_SECONDS)
+  {
+    SEXP classVec = PROTECT(Rf_allocVector(STRSXP, 2));
+    SET_STRING_ELT(classVec, 0, Rf_mkChar("POSIXct"));
+    SET_STRING_ELT(classVec, 1, Rf_mkChar("POSIXt"));
+    Rf_setAttrib(dColumn->colVec, R_ClassSymbol, classVec);
+    UNPROTECT(1);
+  }
+
   SET_VECTOR_ELT(resTable, colNr, dColumn->colVec);
 }
 
 
+void FstTableReader::AddInt64Column(IInt64Column* int64Column, int colNr)
+{
+  Int64Column* lColumn = (Int64Column*) int64Column;
+  Rf_setAttrib(lColumn->colVec, R_ClassSymbol, Rf_mkString("integer64"));
+  SET_VECTOR_ELT(resTable, colNr, lColumn->colVec);
+}
+
+
 void FstTableReader::AddIntegerColumn(IIntegerColumn* integerColumn, int colNr)
 {
   IntegerColumn* iColumn = (IntegerColumn*) integerColumn;
@@ -254,6 +297,12 @@ void FstTableReader::AddFactorColumn(IFactorColumn* factorColumn, int colNr)
 }
 
 
+void FstTableReader::SetColumnAttributes(int colNr, const char* attributeData, unsigned int size)
+{
+  DecodeColumnAttributes(VECTOR_ELT(resTable, colNr), attributeData, size);
+}
+
+
 void FstTableReader::SetColNames()
 {
   // BlockReaderChar* blockReader = new BlockReaderChar();
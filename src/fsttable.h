@@ -57,8 +57,8 @@ class FstTable : public IFstTable
   SEXP  cols;
 
   // Buffers for blockRunner
-  unsigned int naInts[1 + BLOCKSIZE_CHAR / 32];  // we have 32 NA bits per integer
-  unsigned int strSizes[BLOCKSIZE_CHAR];  // we have 32 NA bits per integer
+  unsigned int naInts[1 + CHAR_MAX_BLOCK_SIZE / 32];  // we have 32 NA bits per integer
+  unsigned int strSizes[CHAR_MAX_BLOCK_SIZE];  // cumulative string sizes of a block
   char buf[MAX_CHAR_STACK_SIZE];
 
   // Table metadata
@@ -80,8 +80,12 @@ class FstTable : public IFstTable
 
     double* GetDoubleWriter(unsigned int colNr);
 
+    long long* GetInt64Writer(unsigned int colNr);
+
     IBlockWriter* GetLevelWriter(unsigned int colNr);
 
+    void GetColumnAttributes(unsigned int colNr, std::vector<char> &attributeData);
+
     IBlockWriter* GetColNameWriter();
 
     void GetKeyColumns(int* keyColPos);
@@ -90,7 +94,7 @@ class FstTable : public IFstTable
 
     unsigned int NrOfColumns();
 
-    unsigned int NrOfRows();
+    unsigned long long NrOfRows();
 };
 
 
@@ -98,7 +102,7 @@ class FstTableReader : public IFstTableReader
 {
   // Table metadata
   unsigned int nrOfCols;
-  int nrOfRows;
+  unsigned long long nrOfRows;
   bool isProtected;
 
 public:
@@ -109,7 +113,7 @@ public:
 
   ~FstTableReader() { if (isProtected) UNPROTECT(1); };
 
-  void InitTable(unsigned int nrOfCols, int nrOfRows);
+  void InitTable(unsigned int nrOfCols, unsigned long long nrOfRows);
 
   void AddCharColumn(IStringColumn* stringColumn, int colNr);
 
@@ -117,10 +121,14 @@ public:
 
   void AddIntegerColumn(IIntegerColumn* integerColumn, int colNr);
 
-  void AddDoubleColumn(IDoubleColumn* doubleColumn, int colNr);
+  void AddDoubleColumn(IDoubleColumn* doubleColumn, int colNr, FstColumnType colType);
+
+  void AddInt64Column(IInt64Column* int64Column, int colNr);
 
   void AddFactorColumn(IFactorColumn* factorColumn, int colNr);
 
+  void SetColumnAttributes(int colNr, const char* attributeData, unsigned int size);
+
   void SetColNames();
 
   void SetKeyColumns(int* keyColPos, unsigned int nrOfKeys);
@@ -0,0 +1,315 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include <cstring>
+#include <algorithm>
+
+#include "lazycolumns.h"
+#include "altrep.h"
+#include "FastStore.h"
+
+
+#ifdef HAS_ALTREP
+
+// A lazy column holds a list with the fst handle, the column number, the first row and the number of rows (data1)
+// and the column vector once it's read (data2)
+
+static R_altrep_class_t lazyIntegerClass;
+static R_altrep_class_t lazyRealClass;
+static R_altrep_class_t lazyLogicalClass;
+static R_altrep_class_t lazyStringClass;
+
+
+static R_xlen_t LazyColumnLength(SEXP x)
+{
+  return (R_xlen_t) REAL(VECTOR_ELT(R_altrep_data1(x), 3))[0];
+}
+
+
+// Read rows offset until offset + length of the column
+static SEXP ReadColumnRegion(SEXP x, R_xlen_t offset, R_xlen_t length)
+{
+  SEXP info = R_altrep_data1(x);
+  unsigned long long firstRow = (unsigned long long) REAL(VECTOR_ELT(info, 2))[0] + offset;
+
+  return ReadHandleColumn(VECTOR_ELT(info, 0), INTEGER(VECTOR_ELT(info, 1))[0], firstRow, (unsigned long long) length);
+}
+
+
+// Read the complete column (using all available threads) on first use
+static SEXP Materialize(SEXP x)
+{
+  SEXP data = R_altrep_data2(x);
+  if (data != R_NilValue) return data;
+
+  data = ReadColumnRegion(x, 0, LazyColumnLength(x));
+  R_set_altrep_data2(x, data);
+
+  return data;
+}
+
+
+static void* LazyColumnDataptr(SEXP x, Rboolean writeable)
+{
+  return DATAPTR(Materialize(x));
+}
+
+
+static const void* LazyColumnDataptrOrNull(SEXP x)
+{
+  SEXP data = R_altrep_data2(x);
+  return data == R_NilValue ? nullptr : DATAPTR(data);
+}
+
+
+static Rboolean LazyColumnInspect(SEXP x, int pre, int deep, int pvec, void (*inspect_subtree)(SEXP, int, int, int))
+{
+  Rprintf("fst lazy column (length %lld, read: %s)\n", (long long) LazyColumnLength(x),
+    R_altrep_data2(x) == R_NilValue ? "no" : "yes");
+
+  return TRUE;
+}
+
+
+// Subsets of a column that is not read yet are taken from the rows between the smallest and largest selected row.
+// Selections that span more than half of the column (or contain NA or out of range indices) read the full column.
+static SEXP LazyColumnExtractSubset(SEXP x, SEXP indx, SEXP call)
+{
+  if (R_altrep_data2(x) != R_NilValue) return nullptr;
+  if (TYPEOF(indx) != INTSXP && TYPEOF(indx) != REALSXP) return nullptr;
+
+  R_xlen_t length = LazyColumnLength(x);
+  R_xlen_t nrOfSel = XLENGTH(indx);
+  if (nrOfSel == 0) return nullptr;
+
+  // Range of the selected rows (1-based)
+  double minRow = (double) length + 1;
+  double maxRow = 0;
+
+  for (R_xlen_t sel = 0; sel < nrOfSel; ++sel)
+  {
+    double row;
+
+    if (TYPEOF(indx) == INTSXP)
+    {
+      int intRow = INTEGER(indx)[sel];
+      row = intRow == NA_INTEGER ? NA_REAL : (double) intRow;
+    }
+    else
+    {
+      row = REAL(indx)[sel];
+    }
+
+    if (ISNAN(row) || row < 1 || row >= (double) length + 1) return nullptr;
+
+    minRow = std::min(minRow, row);
+    maxRow = std::max(maxRow, row);
+  }
+
+  R_xlen_t firstRow = (R_xlen_t) minRow - 1;
+  R_xlen_t rangeLength = (R_xlen_t) maxRow - firstRow;
+
+  if (rangeLength > length / 2) return nullptr;
+
+  SEXP data = PROTECT(ReadColumnRegion(x, firstRow, rangeLength));
+  SEXP res = PROTECT(Rf_allocVector(TYPEOF(x), nrOfSel));
+
+  for (R_xlen_t sel = 0; sel < nrOfSel; ++sel)
+  {
+    R_xlen_t pos = (TYPEOF(indx) == INTSXP ? (R_xlen_t) INTEGER(indx)[sel] : (R_xlen_t) REAL(indx)[sel]) - 1 - firstRow;
+
+    switch (TYPEOF(x))
+    {
+      case INTSXP:
+        INTEGER(res)[sel] = INTEGER(data)[pos];
+        break;
+
+      case LGLSXP:
+        LOGICAL(res)[sel] = LOGICAL(data)[pos];
+        break;
+
+      case REALSXP:
+        REAL(res)[sel] = REAL(data)[pos];
+        break;
+
+      default:
+        SET_STRING_ELT(res, sel, STRING_ELT(data, pos));
+    }
+  }
+
+  UNPROTECT(2);
+  return res;
+}
+
+
+// Regions of a column that is not read yet are read separately (for example when a column is serialized)
+template<typename T>
+static R_xlen_t LazyColumnGetRegion(SEXP x, R_xlen_t i, R_xlen_t n, T* buf)
+{
+  R_xlen_t length = LazyColumnLength(x);
+  if (i >= length) return 0;
+
+  n = std::min(n, length - i);
+
+  SEXP data = R_altrep_data2(x);
+
+  if (data == R_NilValue)
+  {
+    data = PROTECT(ReadColumnRegion(x, i, n));
+    memcpy(buf, DATAPTR(data), n * sizeof(T));
+    UNPROTECT(1);
+
+    return n;
+  }
+
+  memcpy(buf, (T*) DATAPTR(data) + i, n * sizeof(T));
+
+  return n;
+}
+
+
+static int LazyIntegerElt(SEXP x, R_xlen_t i)
+{
+  return INTEGER(Materialize(x))[i];
+}
+
+
+static int LazyLogicalElt(SEXP x, R_xlen_t i)
+{
+  return LOGICAL(Materialize(x))[i];
+}
+
+
+static double LazyRealElt(SEXP x, R_xlen_t i)
+{
+  return REAL(Materialize(x))[i];
+}
+
+
+static SEXP LazyStringElt(SEXP x, R_xlen_t i)
+{
+  return STRING_ELT(Materialize(x), i);
+}
+
+
+static void LazyStringSetElt(SEXP x, R_xlen_t i, SEXP v)
+{
+  SET_STRING_ELT(Materialize(x), i, v);
+}
+
+
+static void SetLazyColumnMethods(R_altrep_class_t &lazyClass)
+{
+  R_set_altrep_Length_method(lazyClass, LazyColumnLength);
+  R_set_altrep_Inspect_method(lazyClass, LazyColumnInspect);
+  R_set_altvec_Dataptr_method(lazyClass, LazyColumnDataptr);
+  R_set_altvec_Dataptr_or_null_method(lazyClass, LazyColumnDataptrOrNull);
+  R_set_altvec_Extract_subset_method(lazyClass, LazyColumnExtractSubset);
+}
+
+
+void RegisterLazyColumns(DllInfo* dll)
+{
+  lazyIntegerClass = R_make_altinteger_class("fst_lazy_integer", "fst", dll);
+  SetLazyColumnMethods(lazyIntegerClass);
+  R_set_altinteger_Elt_method(lazyIntegerClass, LazyIntegerElt);
+  R_set_altinteger_Get_region_method(lazyIntegerClass, LazyColumnGetRegion<int>);
+
+  lazyLogicalClass = R_make_altlogical_class("fst_lazy_logical", "fst", dll);
+  SetLazyColumnMethods(lazyLogicalClass);
+  R_set_altlogical_Elt_method(lazyLogicalClass, LazyLogicalElt);
+  R_set_altlogical_Get_region_method(lazyLogicalClass, LazyColumnGetRegion<int>);
+
+  lazyRealClass = R_make_altreal_class("fst_lazy_real", "fst", dll);
+  SetLazyColumnMethods(lazyRealClass);
+  R_set_altreal_Elt_method(lazyRealClass, LazyRealElt);
+  R_set_altreal_Get_region_method(lazyRealClass, LazyColumnGetRegion<double>);
+
+  lazyStringClass = R_make_altstring_class("fst_lazy_character", "fst", dll);
+  SetLazyColumnMethods(lazyStringClass);
+  R_set_altstring_Elt_method(lazyStringClass, LazyStringElt);
+  R_set_altstring_Set_elt_method(lazyStringClass, LazyStringSetElt);
+}
+
+
+SEXP LazyColumn(SEXP handle, int colNr, unsigned long long firstRow, unsigned long long length, SEXP sample)
+{
+  SEXP info = PROTECT(Rf_allocVector(VECSXP, 4));
+  SET_VECTOR_ELT(info, 0, handle);  // keeps the handle open
+  SET_VECTOR_ELT(info, 1, Rf_ScalarInteger(colNr));
+  SET_VECTOR_ELT(info, 2, Rf_ScalarReal((double) firstRow));
+  SET_VECTOR_ELT(info, 3, Rf_ScalarReal((double) length));
+
+  R_altrep_class_t lazyClass;
+
+  switch (TYPEOF(sample))
+  {
+    case INTSXP:
+      lazyClass = lazyIntegerClass;
+      break;
+
+    case LGLSXP:
+      lazyClass = lazyLogicalClass;
+      break;
+
+    case REALSXP:
+      lazyClass = lazyRealClass;
+      break;
+
+    default:
+      lazyClass = lazyStringClass;
+  }
+
+  SEXP res = PROTECT(R_new_altrep(lazyClass, info, R_NilValue));
+  DUPLICATE_ATTRIB(res, sample);  // class, levels and stored attributes
+
+  UNPROTECT(2);
+  return res;
+}
+
+#else
+
+SEXP LazyColumn(SEXP handle, int colNr, unsigned long long firstRow, unsigned long long length, SEXP sample)
+{
+  ::Rf_error("Lazy columns require R 3.5.0 or later.");
+  return R_NilValue;
+}
+
+
+void RegisterLazyColumns(DllInfo* dll)
+{
+}
+
+#endif
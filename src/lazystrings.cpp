@@ -0,0 +1,219 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+
+#include "lazystrings.h"
+#include "altrep.h"
+
+
+static bool lazyStrings = false;
+
+
+bool LazyStringsEnabled()
+{
+  return lazyStrings;
+}
+
+
+// Returns the setting before the call, enable is NULL to leave the setting unchanged
+SEXP setLazyStrings(SEXP enable)
+{
+  if (Rf_isNull(enable)) return Rf_ScalarLogical(lazyStrings);
+
+  if (!Rf_isLogical(enable) || Rf_length(enable) != 1 || LOGICAL(enable)[0] == NA_LOGICAL)
+  {
+    Rf_error("Argument to setLazyStrings must be a single logical value.");
+  }
+
+#ifndef HAS_ALTREP
+  if (LOGICAL(enable)[0]) Rf_error("Lazy string vectors require R 3.5.0 or later.");
+#endif
+
+  bool old = lazyStrings;
+  lazyStrings = LOGICAL(enable)[0] != 0;
+
+  return Rf_ScalarLogical(old);
+}
+
+
+#ifdef HAS_ALTREP
+
+// The lazy string vector holds an external pointer to the string store (data1) and a character vector with the
+// CHARSXP's created so far (data2). After full materialization, only the character vector remains.
+
+static R_altrep_class_t lazyStringClass;
+
+
+static LazyStringStore* Store(SEXP x)
+{
+  SEXP ptr = R_altrep_data1(x);
+  return ptr == R_NilValue ? nullptr : (LazyStringStore*) R_ExternalPtrAddr(ptr);
+}
+
+
+static void LazyStoreFinalizer(SEXP ptr)
+{
+  delete (LazyStringStore*) R_ExternalPtrAddr(ptr);
+  R_ClearExternalPtr(ptr);
+}
+
+
+static R_xlen_t LazyStringLength(SEXP x)
+{
+  LazyStringStore* store = Store(x);
+  return store == nullptr ? XLENGTH(R_altrep_data2(x)) : (R_xlen_t) store->sizes.size();
+}
+
+
+static SEXP LazyStringElt(SEXP x, R_xlen_t i)
+{
+  SEXP cache = R_altrep_data2(x);
+  LazyStringStore* store = Store(x);
+
+  if (store == nullptr) return STRING_ELT(cache, i);  // fully materialized
+
+  if (cache == R_NilValue)
+  {
+    cache = Rf_allocVector(STRSXP, (R_xlen_t) store->sizes.size());  // all elements are R_BlankString
+    R_set_altrep_data2(x, cache);
+  }
+
+  // empty strings and CHARSXP's created earlier
+  SEXP elem = STRING_ELT(cache, i);
+  int size = store->sizes[i];
+  if (elem != R_BlankString || size == 0) return elem;
+
+  elem = size == NA_INTEGER ? NA_STRING : Rf_mkCharLen(&store->data[store->offsets[i]], size);
+  SET_STRING_ELT(cache, i, elem);
+
+  return elem;
+}
+
+
+// Create all remaining CHARSXP's and release the string store
+static SEXP Materialize(SEXP x)
+{
+  LazyStringStore* store = Store(x);
+  if (store == nullptr) return R_altrep_data2(x);
+
+  R_xlen_t length = (R_xlen_t) store->sizes.size();
+  for (R_xlen_t i = 0; i < length; ++i) LazyStringElt(x, i);
+
+  if (length == 0) R_set_altrep_data2(x, Rf_allocVector(STRSXP, 0));
+
+  SEXP ptr = R_altrep_data1(x);
+  LazyStoreFinalizer(ptr);
+  R_set_altrep_data1(x, R_NilValue);
+
+  return R_altrep_data2(x);
+}
+
+
+static void* LazyStringDataptr(SEXP x, Rboolean writeable)
+{
+  return DATAPTR(Materialize(x));
+}
+
+
+static const void* LazyStringDataptrOrNull(SEXP x)
+{
+  return Store(x) == nullptr ? DATAPTR(R_altrep_data2(x)) : nullptr;
+}
+
+
+static void LazyStringSetElt(SEXP x, R_xlen_t i, SEXP v)
+{
+  SET_STRING_ELT(Materialize(x), i, v);
+}
+
+
+static Rboolean LazyStringInspect(SEXP x, int pre, int deep, int pvec, void (*inspect_subtree)(SEXP, int, int, int))
+{
+  Rprintf("fst lazy string vector (length %lld, materialized: %s)\n", (long long) LazyStringLength(x),
+    Store(x) == nullptr ? "yes" : "no");
+
+  return TRUE;
+}
+
+
+SEXP LazyStringVector(LazyStringStore* store)
+{
+  SEXP ptr = PROTECT(R_MakeExternalPtr(store, R_NilValue, R_NilValue));
+  R_RegisterCFinalizerEx(ptr, LazyStoreFinalizer, TRUE);
+
+  SEXP res = R_new_altrep(lazyStringClass, ptr, R_NilValue);
+
+  UNPROTECT(1);
+  return res;
+}
+
+
+void RegisterLazyStrings(DllInfo* dll)
+{
+  lazyStringClass = R_make_altstring_class("fst_lazy_string", "fst", dll);
+
+  R_set_altrep_Length_method(lazyStringClass, LazyStringLength);
+  R_set_altrep_Inspect_method(lazyStringClass, LazyStringInspect);
+  R_set_altvec_Dataptr_method(lazyStringClass, LazyStringDataptr);
+  R_set_altvec_Dataptr_or_null_method(lazyStringClass, LazyStringDataptrOrNull);
+  R_set_altstring_Elt_method(lazyStringClass, LazyStringElt);
+  R_set_altstring_Set_elt_method(lazyStringClass, LazyStringSetElt);
+}
+
+#else
+
+// Without ALTREP support the strings are materialized directly (lazy strings can't be enabled)
+SEXP LazyStringVector(LazyStringStore* store)
+{
+  R_xlen_t length = (R_xlen_t) store->sizes.size();
+  SEXP res = PROTECT(Rf_allocVector(STRSXP, length));
+
+  for (R_xlen_t i = 0; i < length; ++i)
+  {
+    int size = store->sizes[i];
+    SET_STRING_ELT(res, i, size == NA_INTEGER ? NA_STRING : Rf_mkCharLen(&store->data[store->offsets[i]], size));
+  }
+
+  delete store;
+
+  UNPROTECT(1);
+  return res;
+}
+
+
+void RegisterLazyStrings(DllInfo* dll)
+{
+}
+
+#endif
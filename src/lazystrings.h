@@ -0,0 +1,86 @@
+/*
+  fst - An R-package for ultra fast storage and retrieval of datasets.
+  Header File
+  Copyright (C) 2017, Mark AJ Klik
+
+  BSD 2-Clause License (http://www.opensource.org/licenses/bsd-license.php)
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are
+  met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  You can contact the author at :
+  - fst source repository : https://github.com/fstPackage/fst
+*/
+
+#ifndef LAZY_STRINGS_H
+#define LAZY_STRINGS_H
+
+
+#include <vector>
+
+#include <Rcpp.h>
+
+
+// Strings of a character column as read from the column blocks. With lazy strings enabled, character columns are
+// returned as ALTREP vectors that create the CHARSXP of an element only when it's accessed.
+class LazyStringStore
+{
+public:
+  std::vector<char> data;                   // strings, each followed by a zero
+  std::vector<unsigned long long> offsets;  // offset of each element in data
+  std::vector<int> sizes;                   // size of each element, NA_INTEGER for a NA string
+
+  LazyStringStore(unsigned long long length) : offsets(length, 0), sizes(length, 0) {}
+
+  void SetElement(unsigned long long elemNr, const char* str, unsigned int size)
+  {
+    offsets[elemNr] = data.size();
+    sizes[elemNr] = size;
+    data.insert(data.end(), str, str + size);
+    data.push_back(0);
+  }
+
+  void SetNA(unsigned long long elemNr) { sizes[elemNr] = NA_INTEGER; }
+
+  const char* Element(unsigned long long elemNr) const
+  {
+    return sizes[elemNr] == NA_INTEGER ? "NA" : &data[offsets[elemNr]];
+  }
+};
+
+
+// Create a character vector backed by store, which is owned by the vector from then on
+SEXP LazyStringVector(LazyStringStore* store);
+
+// True if character columns are read as lazy string vectors
+bool LazyStringsEnabled();
+
+// [[Rcpp::export]]
+SEXP setLazyStrings(SEXP enable);
+
+// Register the lazy string vector class (ALTREP, R >= 3.5.0)
+void RegisterLazyStrings(DllInfo* dll);
+
+
+#endif  // LAZY_STRINGS_H
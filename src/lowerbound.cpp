@@ -36,6 +36,8 @@
 #include <R.h>
 #include <Rinternals.h>
 
+#include <columnnameindex.h>
+
 using namespace Rcpp;
 using namespace std;
 
@@ -240,22 +242,19 @@ SEXP LowerBoundIndex(SEXP table, SEXP key, SEXP lower, SEXP upper)
   int nrOfSelect = LENGTH(keyNames);
   int nrOfCols = LENGTH(colNames);
 
+  ColumnNameIndex colNameIndex;
+  colNameIndex.Reserve(nrOfCols);
+
+  for (int colNr = 0; colNr < nrOfCols; ++colNr)
+  {
+    colNameIndex.Add(CHAR(STRING_ELT(colNames, colNr)), colNr);
+  }
+
   int *colIndex = new int[nrOfSelect];
 
   for (int colSel = 0; colSel < nrOfSelect; ++colSel)
   {
-    int equal = -1;
-    const char* str1 = CHAR(STRING_ELT(keyNames, colSel));
-
-    for (int colNr = 0; colNr < nrOfCols; ++colNr)
-    {
-      const char* str2 = CHAR(STRING_ELT(colNames, colNr));
-      if (strcmp(str1, str2) == 0)
-      {
-        equal = colNr;
-        break;
-      }
-    }
+    int equal = colNameIndex.Find(CHAR(STRING_ELT(keyNames, colSel)));
 
     if (equal == -1)
     {
@@ -43,6 +43,11 @@
 // [[Rcpp::export]]
 int getDTthreads();
 
+SEXP getDTthreads_R();
+
+// [[Rcpp::export]]
+SEXP setDTthreads(SEXP threads);
+
 void avoid_openmp_hang_within_fork();
 
 // [[Rcpp::export]]